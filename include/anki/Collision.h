@@ -19,3 +19,5 @@
 #include <anki/collision/GjkEpa.h>
 #include <anki/collision/Functions.h>
 #include <anki/collision/Tests.h>
+#include <anki/collision/BatchTests.h>
+#include <anki/collision/DynamicAabbTree.h>
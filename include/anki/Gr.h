@@ -14,6 +14,9 @@
 /// @defgroup opengl OpenGL backend
 /// @ingroup graphics
 
+/// @defgroup null NULL backend that doesn't touch the GPU
+/// @ingroup graphics
+
 #include <anki/gr/Buffer.h>
 #include <anki/gr/Texture.h>
 #include <anki/gr/Sampler.h>
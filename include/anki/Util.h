@@ -60,6 +60,7 @@
 #include <anki/util/NonCopyable.h>
 #include <anki/util/Hierarchy.h>
 #include <anki/util/Ptr.h>
+#include <anki/util/RadixSort.h>
 #include <anki/util/Singleton.h>
 #include <anki/util/StdTypes.h>
 #include <anki/util/String.h>
@@ -0,0 +1,74 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/collision/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup collision
+/// @{
+
+/// A number of bounding volumes in structure of arrays layout. It's the input
+/// of the batch tests.
+///
+/// A volume is a box defined by a center and extents that is grown by a
+/// radius. For spheres leave the extents nullptr and for boxes leave the
+/// radius nullptr.
+class BatchVolumes
+{
+public:
+	const F32* m_centerX = nullptr;
+	const F32* m_centerY = nullptr;
+	const F32* m_centerZ = nullptr;
+
+	const F32* m_extentX = nullptr;
+	const F32* m_extentY = nullptr;
+	const F32* m_extentZ = nullptr;
+
+	const F32* m_radius = nullptr;
+};
+
+/// The maximum number of planes the batch tests accept.
+const U MAX_BATCH_TEST_PLANES = 6;
+
+/// Test volumes against a number of planes, usually the planes of a frustum.
+/// A volume passes if no plane has it completely behind it.
+/// @param volumes The volumes.
+/// @param count The number of volumes.
+/// @param[in] planes The planes.
+/// @param planeCount The number of planes. Up to MAX_BATCH_TEST_PLANES.
+/// @param[out] visibleIndices The indices of the volumes that passed. It
+///             should have room for count indices.
+/// @return The number of visibleIndices.
+U32 batchTestPlanes(const BatchVolumes& volumes,
+	U32 count,
+	const Plane* planes,
+	U planeCount,
+	U32* visibleIndices);
+
+/// Same as batchTestPlanes but it outputs a bitmask.
+/// @param[out] visibleMask Bit i is set if volume i passed. It should have
+///             room for (count + 31) / 32 words.
+void batchTestPlanesMask(const BatchVolumes& volumes,
+	U32 count,
+	const Plane* planes,
+	U planeCount,
+	U32* visibleMask);
+
+/// Same as batchTestPlanes but it tests a subset of the volumes.
+/// @param[in] indices The indices of the volumes to test.
+/// @param[out] visibleIndices The indices that passed. It can alias indices.
+U32 batchTestPlanesIndexed(const BatchVolumes& volumes,
+	const U32* indices,
+	U32 count,
+	const Plane* planes,
+	U planeCount,
+	U32* visibleIndices);
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,183 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/collision/Common.h>
+#include <anki/collision/Plane.h>
+#include <anki/Math.h>
+#include <anki/util/DynamicArray.h>
+
+namespace anki
+{
+
+/// @addtogroup collision
+/// @{
+
+/// A bounding volume hierarchy of Aabbs that is updated incrementally.
+///
+/// The leaves hold a user value and an Aabb that is fattened by a margin so
+/// that small moves don't touch the tree. The leaves are inserted next to the
+/// sibling that increases the surface area the least and the tree is kept
+/// balanced with rotations.
+///
+/// The queries are const and they can run concurrently. The modifications
+/// are not thread-safe.
+class DynamicAabbTree
+{
+public:
+	static const U32 NULL_NODE = MAX_U32;
+
+	DynamicAabbTree()
+	{
+	}
+
+	~DynamicAabbTree()
+	{
+		ANKI_ASSERT(m_nodes.getSize() == 0 && "Forgot to call destroy");
+	}
+
+	/// @param margin The distance the Aabbs of the leaves are fattened by.
+	void init(F32 margin)
+	{
+		ANKI_ASSERT(margin >= 0.0);
+		m_margin = margin;
+	}
+
+	void destroy(CollisionAllocator<U8> alloc);
+
+	/// Create a leaf.
+	/// @return The leaf.
+	U32 newLeaf(CollisionAllocator<U8> alloc, const Aabb& aabb, U32 userData);
+
+	/// Delete a leaf that newLeaf returned.
+	void deleteLeaf(U32 leaf);
+
+	/// Update the Aabb of a leaf. It's cheap if the new Aabb is inside the fat
+	/// one.
+	/// @return True if the leaf got re-inserted.
+	Bool moveLeaf(U32 leaf, const Aabb& aabb);
+
+	U32 getUserData(U32 leaf) const
+	{
+		ANKI_ASSERT(leaf < m_nodes.getSize() && m_nodes[leaf].isLeaf());
+		return m_nodes[leaf].m_userData;
+	}
+
+	/// Get the fat Aabb of a leaf.
+	void getFatAabb(U32 leaf, Vec4& aabbMin, Vec4& aabbMax) const
+	{
+		ANKI_ASSERT(leaf < m_nodes.getSize() && m_nodes[leaf].isLeaf());
+		aabbMin = m_nodes[leaf].m_min;
+		aabbMax = m_nodes[leaf].m_max;
+	}
+
+	U32 getLeafCount() const
+	{
+		return m_leafCount;
+	}
+
+	/// Get the height of the tree. A tree with a single leaf has zero height.
+	U32 getHeight() const
+	{
+		return (m_root != NULL_NODE) ? m_nodes[m_root].m_height : 0;
+	}
+
+	/// Visit the leaves that are not completely behind any of the planes.
+	/// When a node is in front of a plane its subtree skips that plane and
+	/// when it's in front of all planes its subtree is visited without any
+	/// tests.
+	/// @param[in] planes The planes. Usually the planes of a frustum.
+	/// @param planeCount The number of planes. Up to MAX_PLANES.
+	/// @param func A functor with signature void(U32 userData).
+	template<typename TFunc>
+	void visitPlanes(const Plane* planes, U planeCount, TFunc func) const;
+
+	/// Same as the other visitPlanes but it can cull whole subtrees.
+	/// @param nodeFunc A functor with signature
+	///        Bool(const Vec4& min, const Vec4& max). If it returns false the
+	///        node and its children are skipped.
+	/// @param func A functor with signature void(U32 userData).
+	template<typename TNodeFunc, typename TFunc>
+	void visitPlanes(const Plane* planes,
+		U planeCount,
+		TNodeFunc nodeFunc,
+		TFunc func) const;
+
+	/// Visit the leaves that touch a sphere.
+	/// @param func A functor with signature void(U32 userData).
+	template<typename TFunc>
+	void visitSphere(const Vec4& center, F32 radius, TFunc func) const;
+
+	/// Visit the leaves that a ray segment hits.
+	/// @param origin The origin of the ray.
+	/// @param dir The normalized direction of the ray.
+	/// @param maxDistance The length of the segment.
+	/// @param func A functor with signature void(U32 userData).
+	template<typename TFunc>
+	void visitRay(
+		const Vec4& origin, const Vec4& dir, F32 maxDistance, TFunc func) const;
+
+	static const U MAX_PLANES = 8;
+
+private:
+	class Node
+	{
+	public:
+		Vec4 m_min;
+		Vec4 m_max;
+
+		/// The parent or the next free node.
+		U32 m_parent;
+		Array<U32, 2> m_children;
+		U32 m_userData;
+
+		/// Zero for leaves and -1 for free nodes.
+		I32 m_height;
+
+		Bool isLeaf() const
+		{
+			return m_children[0] == NULL_NODE;
+		}
+	};
+
+	/// The max depth of the traversal stack. The tree is balanced so it's
+	/// enough for any sane number of leaves.
+	static const U STACK_SIZE = 64;
+
+	DynamicArray<Node> m_nodes;
+	U32 m_root = NULL_NODE;
+	U32 m_freeList = NULL_NODE;
+	U32 m_usedNodeCount = 0;
+	U32 m_leafCount = 0;
+	F32 m_margin = 0.1;
+
+	/// Make sure that there are some free nodes.
+	void reserveNodes(CollisionAllocator<U8> alloc, U32 count);
+
+	/// Take a node from the free list.
+	U32 newNode();
+	void deleteNode(U32 node);
+
+	void insertLeaf(U32 leaf);
+	void removeLeaf(U32 leaf);
+
+	/// Rotate the subtree if it's imbalanced.
+	/// @return The new root of the subtree.
+	U32 balance(U32 node);
+
+	/// Recompute the Aabb and the height of a node from its children.
+	void refit(U32 node);
+
+	/// Refit all the ancestors of a node.
+	void refitAncestors(U32 node);
+
+	static F32 computeSurfaceArea(const Vec4& aabbMin, const Vec4& aabbMax);
+};
+/// @}
+
+} // end namespace anki
+
+#include <anki/collision/DynamicAabbTree.inl.h>
@@ -0,0 +1,222 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+namespace anki
+{
+
+//==============================================================================
+template<typename TFunc>
+inline void DynamicAabbTree::visitPlanes(
+	const Plane* planes, U planeCount, TFunc func) const
+{
+	visitPlanes(planes,
+		planeCount,
+		[](const Vec4&, const Vec4&) -> Bool { return true; },
+		func);
+}
+
+//==============================================================================
+template<typename TNodeFunc, typename TFunc>
+inline void DynamicAabbTree::visitPlanes(
+	const Plane* planes, U planeCount, TNodeFunc nodeFunc, TFunc func) const
+{
+	ANKI_ASSERT(planes && planeCount > 0 && planeCount <= MAX_PLANES);
+
+	if(m_root == NULL_NODE)
+	{
+		return;
+	}
+
+	// Every node in the stack has a mask of the planes it should be tested
+	Array<U32, STACK_SIZE> stack;
+	Array<U8, STACK_SIZE> stackPlaneMasks;
+	U stackSize = 1;
+	stack[0] = m_root;
+	stackPlaneMasks[0] = (1 << planeCount) - 1;
+
+	while(stackSize > 0)
+	{
+		--stackSize;
+		const Node& node = m_nodes[stack[stackSize]];
+		U8 planeMask = stackPlaneMasks[stackSize];
+
+		// Test the planes that the parent was not in front of
+		Bool outside = false;
+		for(U i = 0; i < planeCount && !outside; ++i)
+		{
+			if(!(planeMask & (1 << i)))
+			{
+				continue;
+			}
+
+			const Vec4& n = planes[i].getNormal();
+			F32 nearDist = -planes[i].getOffset();
+			F32 farDist = -planes[i].getOffset();
+			for(U j = 0; j < 3; ++j)
+			{
+				if(n[j] >= 0.0)
+				{
+					nearDist += n[j] * node.m_min[j];
+					farDist += n[j] * node.m_max[j];
+				}
+				else
+				{
+					nearDist += n[j] * node.m_max[j];
+					farDist += n[j] * node.m_min[j];
+				}
+			}
+
+			if(farDist < 0.0)
+			{
+				outside = true;
+			}
+			else if(nearDist >= 0.0)
+			{
+				// The subtree is in front of that plane
+				planeMask &= ~(1 << i);
+			}
+		}
+
+		if(outside || !nodeFunc(node.m_min, node.m_max))
+		{
+			continue;
+		}
+
+		if(node.isLeaf())
+		{
+			func(node.m_userData);
+		}
+		else
+		{
+			ANKI_ASSERT(stackSize + 2 <= STACK_SIZE);
+			stack[stackSize] = node.m_children[0];
+			stackPlaneMasks[stackSize++] = planeMask;
+			stack[stackSize] = node.m_children[1];
+			stackPlaneMasks[stackSize++] = planeMask;
+		}
+	}
+}
+
+//==============================================================================
+template<typename TFunc>
+inline void DynamicAabbTree::visitSphere(
+	const Vec4& center, F32 radius, TFunc func) const
+{
+	if(m_root == NULL_NODE)
+	{
+		return;
+	}
+
+	const F32 radiusSq = radius * radius;
+	Array<U32, STACK_SIZE> stack;
+	U stackSize = 1;
+	stack[0] = m_root;
+
+	while(stackSize > 0)
+	{
+		const Node& node = m_nodes[stack[--stackSize]];
+
+		// Distance of the center from the box
+		F32 distSq = 0.0;
+		for(U j = 0; j < 3; ++j)
+		{
+			const F32 c = center[j];
+			const F32 d = (c < node.m_min[j])
+				? node.m_min[j] - c
+				: ((c > node.m_max[j]) ? c - node.m_max[j] : 0.0f);
+			distSq += d * d;
+		}
+
+		if(distSq > radiusSq)
+		{
+			continue;
+		}
+
+		if(node.isLeaf())
+		{
+			func(node.m_userData);
+		}
+		else
+		{
+			ANKI_ASSERT(stackSize + 2 <= STACK_SIZE);
+			stack[stackSize++] = node.m_children[0];
+			stack[stackSize++] = node.m_children[1];
+		}
+	}
+}
+
+//==============================================================================
+template<typename TFunc>
+inline void DynamicAabbTree::visitRay(
+	const Vec4& origin, const Vec4& dir, F32 maxDistance, TFunc func) const
+{
+	ANKI_ASSERT(maxDistance >= 0.0);
+
+	if(m_root == NULL_NODE)
+	{
+		return;
+	}
+
+	Array<F32, 3> invDir;
+	for(U j = 0; j < 3; ++j)
+	{
+		invDir[j] = (absolute(dir[j]) > getEpsilon<F32>()) ? 1.0f / dir[j]
+														   : MAX_F32;
+	}
+
+	Array<U32, STACK_SIZE> stack;
+	U stackSize = 1;
+	stack[0] = m_root;
+
+	while(stackSize > 0)
+	{
+		const Node& node = m_nodes[stack[--stackSize]];
+
+		// Slab test
+		F32 tmin = 0.0;
+		F32 tmax = maxDistance;
+		for(U j = 0; j < 3 && tmin <= tmax; ++j)
+		{
+			if(invDir[j] == MAX_F32)
+			{
+				// Parallel to the slab
+				if(origin[j] < node.m_min[j] || origin[j] > node.m_max[j])
+				{
+					tmin = MAX_F32;
+				}
+			}
+			else
+			{
+				F32 t0 = (node.m_min[j] - origin[j]) * invDir[j];
+				F32 t1 = (node.m_max[j] - origin[j]) * invDir[j];
+				if(t0 > t1)
+				{
+					std::swap(t0, t1);
+				}
+
+				tmin = max(tmin, t0);
+				tmax = min(tmax, t1);
+			}
+		}
+
+		if(tmin > tmax)
+		{
+			continue;
+		}
+
+		if(node.isLeaf())
+		{
+			func(node.m_userData);
+		}
+		else
+		{
+			ANKI_ASSERT(stackSize + 2 <= STACK_SIZE);
+			stack[stackSize++] = node.m_children[0];
+			stack[stackSize++] = node.m_children[1];
+		}
+	}
+}
+
+} // end namespace anki
@@ -19,4 +19,6 @@ class Aabb;
 class CompoundShape;
 class ConvexHullShape;
 
+class BatchVolumes;
+
 } // end namespace anki
@@ -102,6 +102,18 @@ public:
 	/// Check if a collision shape @a b is inside the frustum
 	Bool insideFrustum(const CollisionShape& b) const;
 
+	/// Batch version of insideFrustum. See batchTestPlanes.
+	/// @return The number of visibleIndices.
+	U32 insideFrustum(
+		const BatchVolumes& volumes, U32 count, U32* visibleIndices) const;
+
+	/// Get the planes in world space. Useful for batch tests.
+	const Array<Plane, (U)PlaneType::COUNT>& getPlanesWorldSpace() const
+	{
+		update();
+		return m_planesW;
+	}
+
 	/// Calculate the projection matrix
 	virtual Mat4 calculateProjectionMatrix() const = 0;
 
@@ -22,7 +22,6 @@ extern android_app* gAndroidApp;
 
 // Forward
 class ConfigSet;
-class ThreadPool;
 class ThreadHive;
 class NativeWindow;
 class Input;
@@ -75,11 +74,6 @@ public:
 		return m_allocCbData;
 	}
 
-	ThreadPool& getThreadPool()
-	{
-		return *m_threadpool;
-	}
-
 	ThreadHive& getThreadHive()
 	{
 		return *m_threadHive;
@@ -159,7 +153,6 @@ private:
 
 	// Misc
 	Timestamp m_globalTimestamp = 0;
-	ThreadPool* m_threadpool = nullptr;
 	ThreadHive* m_threadHive = nullptr;
 	String m_settingsDir; ///< The path that holds the configuration
 	String m_cacheDir; ///< This is used as a cache
@@ -30,8 +30,10 @@ enum class TraceEventType
 	SCENE_VISIBILITY_TESTS,
 	SCENE_VISIBILITY_TEST,
 	SCENE_VISIBILITY_COMBINE_RESULTS,
+	SCENE_VISIBILITY_MERGE_RESULTS,
 	SCENE_VISIBILITY_ITERATE_SECTORS,
 	SCENE_VISIBILITY_GATHER_TRIANGLES,
+	SCENE_VISIBILITY_BIN_TRIANGLES,
 	SCENE_VISIBILITY_RASTERIZE,
 	SCENE_RASTERIZER_TEST,
 	RENDER,
@@ -59,6 +61,10 @@ enum class TraceCounterType
 	GR_DRAWCALLS,
 	GR_DYNAMIC_UNIFORMS_SIZE,
 	GR_DYNAMIC_STORAGE_SIZE,
+	GR_TRANSIENT_UNIFORM_HIGH_WATER,
+	GR_TRANSIENT_STORAGE_HIGH_WATER,
+	GR_TRANSIENT_VERTEX_HIGH_WATER,
+	GR_TRANSIENT_TRANSFER_HIGH_WATER,
 	GR_VERTICES,
 	GR_PIPELINES_CREATED,
 	GR_PIPELINE_BINDS_SKIPPED,
@@ -66,9 +72,13 @@ enum class TraceCounterType
 	RENDERER_LIGHTS,
 	RENDERER_SHADOW_PASSES,
 	RENDERER_MERGED_DRAWCALLS,
+	RENDERER_BATCHED_DRAWCALLS,
 	RENDERER_REFLECTIONS,
 	RESOURCE_ASYNC_TASKS,
 	SCENE_NODES_UPDATED,
+	SCENE_MEMORY,
+	SCENE_FRAME_MEMORY,
+	SCENE_ALLOCATOR_LOCK_CONTENTION,
 
 	COUNT
 };
@@ -179,6 +179,12 @@ public:
 	void drawArrays(
 		U32 count, U32 instanceCount = 1, U32 first = 0, U32 baseInstance = 0);
 
+	/// Issue many drawcalls at once.
+	/// @param drawCount The number of drawcalls.
+	/// @param token Transient memory with BufferUsageBit::INDIRECT usage. It
+	///        holds drawCount DrawElementsIndirectInfo.
+	void drawElementsIndirect(U32 drawCount, const TransientMemoryToken& token);
+
 	void drawElementsConditional(OcclusionQueryPtr query,
 		U32 count,
 		U32 instanceCount = 1,
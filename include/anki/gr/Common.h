@@ -143,6 +143,7 @@ anki_internal:
 	TransientMemoryTokenLifetime m_lifetime =
 		TransientMemoryTokenLifetime::PER_FRAME;
 	BufferUsageBit m_usage = BufferUsageBit::NONE;
+	U8 m_page = 0; ///< The page of the transient memory.
 
 	void markUnused()
 	{
@@ -75,6 +75,10 @@ public:
 		TransientMemoryToken& token,
 		Error* err = nullptr);
 
+	/// Check if ANKI_INSTANCE_ID in the vertex shaders includes the
+	/// baseInstance of the drawcall. If not the drawcalls should leave it zero.
+	Bool getBaseInstanceSupported() const;
+
 anki_internal:
 	GrAllocator<U8>& getAllocator()
 	{
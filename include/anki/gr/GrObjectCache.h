@@ -7,7 +7,7 @@
 
 #include <anki/gr/Common.h>
 #include <anki/gr/GrObject.h>
-#include <anki/util/HashMap.h>
+#include <anki/util/FlatHashMap.h>
 #include <anki/util/NonCopyable.h>
 
 namespace anki
@@ -20,6 +20,11 @@ namespace anki
 class GrObjectCache : public NonCopyable
 {
 public:
+	~GrObjectCache()
+	{
+		m_map.destroy(m_alloc);
+	}
+
 	void init(const GrAllocator<U8>& alloc)
 	{
 		m_alloc = alloc;
@@ -79,7 +84,7 @@ private:
 	};
 
 	GrAllocator<U8> m_alloc;
-	HashMap<U64, GrObject*, Hasher, Compare> m_map;
+	FlatHashMap<U64, GrObject*, Hasher, Compare> m_map;
 	Mutex m_mtx;
 };
 /// @}
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/gr/Common.h>
+#include <anki/util/Thread.h>
 
 namespace anki
 {
@@ -13,18 +14,57 @@ namespace anki
 /// @addtogroup graphics
 /// @{
 
+/// The backends implement it to give memory to the overflow pages of a
+/// GpuFrameRingAllocator.
+class GpuFrameRingAllocatorPageInterface
+{
+public:
+	virtual ~GpuFrameRingAllocatorPageInterface()
+	{
+	}
+
+	/// Create the memory of an overflow page. It's called from the thread that
+	/// allocates while the allocator holds a lock.
+	virtual ANKI_USE_RESULT Error createPage(U32 page, PtrSize size) = 0;
+
+	/// Release the memory of an overflow page. It's called from endFrame and
+	/// destroy.
+	virtual void destroyPage(U32 page) = 0;
+};
+
 /// Manages pre-allocated GPU memory for per frame usage.
+///
+/// The memory is a ring that is split in MAX_FRAMES_IN_FLIGHT slices. When a
+/// frame doesn't fit in its slice the allocator chains overflow pages that the
+/// backend creates through GpuFrameRingAllocatorPageInterface. Every page that
+/// a frame chains is double the size of the previous one. The pages are
+/// recycled when the GPU is done with them and they are released after they
+/// stay unused for a few frames.
+///
+/// Small allocations are served from sub-blocks that every thread keeps
+/// locally so the recording threads don't fight for the same atomic.
 class GpuFrameRingAllocator : public NonCopyable
 {
 	friend class DynamicMemorySerializeCommand;
 
 public:
+	/// The page of the ring. The overflow pages come after it.
+	static const U32 MAIN_PAGE = 0;
+
+	/// Max number of pages including the MAIN_PAGE.
+	static const U32 MAX_PAGES = 16;
+
+	/// The number of frames an overflow page can stay unused before it's
+	/// released.
+	static const U32 PAGE_RELEASE_FRAME_COUNT = 60;
+
 	GpuFrameRingAllocator()
 	{
 	}
 
 	~GpuFrameRingAllocator()
 	{
+		ANKI_ASSERT(m_overflowPageCount == 0 && "Forgot to call destroy");
 	}
 
 	/// Initialize with pre-allocated always mapped memory.
@@ -32,37 +72,102 @@ public:
 	/// @param alignment The working alignment.
 	/// @param maxAllocationSize The size in @a allocate cannot exceed
 	///        maxAllocationSize.
-	void init(
-		PtrSize size, U32 alignment, PtrSize maxAllocationSize = MAX_PTR_SIZE);
+	/// @param pageInterface Creates the overflow pages. If it's nullptr the
+	///        allocator fails when a frame doesn't fit in its slice.
+	void init(PtrSize size,
+		U32 alignment,
+		PtrSize maxAllocationSize = MAX_PTR_SIZE,
+		GpuFrameRingAllocatorPageInterface* pageInterface = nullptr);
+
+	/// Release the overflow pages.
+	void destroy();
 
 	/// Allocate memory for a dynamic buffer.
-	ANKI_USE_RESULT Error allocate(PtrSize size, PtrSize& outOffset);
+	/// @param size The size of the allocation.
+	/// @param[out] outOffset The offset inside the page.
+	/// @param[out] outPage The page. MAIN_PAGE or an overflow page.
+	ANKI_USE_RESULT Error allocate(
+		PtrSize size, PtrSize& outOffset, U32& outPage);
+
+	/// Allocate memory for a dynamic buffer from the ring only.
+	ANKI_USE_RESULT Error allocate(PtrSize size, PtrSize& outOffset)
+	{
+		ANKI_ASSERT(m_pageInterface == nullptr);
+		U32 page;
+		Error err = allocate(size, outOffset, page);
+		ANKI_ASSERT(err || page == MAIN_PAGE);
+		return err;
+	}
 
 	/// Call this at the end of the frame.
-	/// @return The bytes that were not used. Used for statistics.
+	/// @note It's not thread-safe against allocate.
+	/// @return The bytes of the ring that were not used. Used for statistics.
 	PtrSize endFrame();
 
-#if ANKI_ENABLE_TRACE
 	/// Call this before endFrame.
 	PtrSize getUnallocatedMemorySize() const;
-#endif
+
+	/// Get the max bytes that a frame has used so far. It includes the
+	/// overflow pages.
+	PtrSize getHighWaterMark() const
+	{
+		return m_highWaterMark;
+	}
+
+	/// Get the number of overflow pages that are alive.
+	U32 getOverflowPageCount() const
+	{
+		return m_overflowPageCount;
+	}
 
 private:
+	class OverflowPage
+	{
+	public:
+		PtrSize m_size = 0; ///< Zero if the page doesn't exist.
+		PtrSize m_offset = 0;
+		U64 m_lastUsedFrame = 0;
+	};
+
 	PtrSize m_size = 0; ///< The full size of the buffer.
 	U32 m_alignment = 0; ///< Always work in that alignment.
 	PtrSize m_maxAllocationSize = 0; ///< For debugging.
 
+	/// The size of the blocks the threads take. Zero if they are disabled.
+	PtrSize m_subBlockSize = 0;
+
+	/// Identifies the allocator in the per thread caches.
+	U64 m_uuid = 0;
+
 	Atomic<PtrSize> m_offset = {0};
-#if ANKI_ENABLE_TRACE
-	Atomic<PtrSize> m_lastAllocatedSize = {0}; ///< For tracing.
-#endif
+	Atomic<PtrSize> m_frameUsedSize = {0};
+	PtrSize m_highWaterMark = 0;
 	U64 m_frame = 0;
 
+	GpuFrameRingAllocatorPageInterface* m_pageInterface = nullptr;
+	Array<OverflowPage, MAX_PAGES> m_pages;
+	U32 m_activePage = MAIN_PAGE; ///< The page that the frame is filling.
+	U32 m_framePageCount = 0; ///< The overflow pages the frame has used.
+	U32 m_overflowPageCount = 0;
+	Mutex m_pageMtx;
+
 	Bool isCreated() const
 	{
 		return m_size > 0;
 	}
+
+	PtrSize getPerFrameSize() const
+	{
+		return m_size / MAX_FRAMES_IN_FLIGHT;
+	}
+
+	/// Allocate from the ring or the overflow pages.
+	ANKI_USE_RESULT Error allocateShared(
+		PtrSize size, PtrSize& outOffset, U32& outPage);
+
+	ANKI_USE_RESULT Error allocateFromOverflowPage(
+		PtrSize size, PtrSize& outOffset, U32& outPage);
 };
 /// @}
 
-} // end namespace anki
\ No newline at end of file
+} // end namespace anki
@@ -27,8 +27,10 @@ inline TransientBufferType bufferUsageToTransient(BufferUsageBit bit)
 	{
 		return TransientBufferType::UNIFORM;
 	}
-	else if((bit & BufferUsageBit::STORAGE_ANY) != BufferUsageBit::NONE)
+	else if((bit & (BufferUsageBit::STORAGE_ANY | BufferUsageBit::INDIRECT))
+		!= BufferUsageBit::NONE)
 	{
+		// The indirect drawcalls share the storage buffer
 		return TransientBufferType::STORAGE;
 	}
 	else if((bit & BufferUsageBit::VERTEX) != BufferUsageBit::NONE)
@@ -0,0 +1,100 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Common.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/String.h>
+#include <anki/util/Atomic.h>
+
+namespace anki
+{
+
+/// @addtogroup graphics
+/// @{
+
+/// A cache of compiled shader and pipeline blobs that lives on the disk and
+/// survives between runs.
+///
+/// The blobs are addressed by a key that the backends compute from the
+/// content they compiled (the shader source for example). The backend hash
+/// describes everything else that affects the blobs, like the backend and the
+/// driver version. When it changes the whole cache is dropped.
+///
+/// Every blob is written to a temporary file that is renamed in place so a
+/// crash never leaves a half written blob behind. Blobs that fail validation
+/// are ignored and get overwritten by the next store.
+///
+/// A failing cache is never fatal. The backends log the error and continue
+/// with the cache disabled.
+class ShaderCache : public NonCopyable
+{
+public:
+	ShaderCache()
+	{
+	}
+
+	~ShaderCache()
+	{
+		destroy();
+	}
+
+	/// @param alloc The allocator.
+	/// @param cacheDir The root cache directory. The blobs go in a
+	///        subdirectory of it.
+	/// @param backendHash The hash of the backend and the driver.
+	ANKI_USE_RESULT Error init(GenericMemoryPoolAllocator<U8> alloc,
+		const CString& cacheDir,
+		U64 backendHash);
+
+	void destroy();
+
+	Bool isEnabled() const
+	{
+		return !m_dir.isEmpty();
+	}
+
+	/// Compute the key of some content.
+	U64 computeKey(const void* data, PtrSize size) const;
+
+	/// Load a blob.
+	/// @param key The key of the blob.
+	/// @param[out] blob The content of the blob.
+	/// @param[out] found True if there is a valid blob.
+	/// @note It's thread-safe.
+	ANKI_USE_RESULT Error load(
+		U64 key, DynamicArrayAuto<U8>& blob, Bool& found) const;
+
+	/// Store a blob. It replaces a blob with the same key.
+	/// @note It's thread-safe.
+	ANKI_USE_RESULT Error store(U64 key, const void* data, PtrSize size);
+
+	/// @name Statistics
+	/// @{
+	U32 getHitCount() const
+	{
+		return m_hits.load();
+	}
+
+	U32 getMissCount() const
+	{
+		return m_misses.load();
+	}
+	/// @}
+
+private:
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	String m_dir;
+	U64 m_backendHash = 0;
+	mutable Atomic<U32> m_hits = {0};
+	mutable Atomic<U32> m_misses = {0};
+	Atomic<U32> m_tmpFileCount = {0};
+
+	void getBlobFilename(U64 key, StringAuto& out) const;
+};
+/// @}
+
+} // end namespace anki
@@ -8,6 +8,7 @@
 #include <anki/gr/CommandBuffer.h>
 #include <anki/util/Assert.h>
 #include <anki/util/Allocator.h>
+#include <anki/gr/gl/Common.h>
 
 namespace anki
 {
@@ -21,12 +22,11 @@ class GlState;
 template<typename T>
 using CommandBufferAllocator = StackAllocator<T>;
 
-/// The base of all GL commands.
+/// The base of the GL commands that don't have their own type in the command
+/// stream. They are rare so they can afford a virtual call.
 class GlCommand
 {
 public:
-	GlCommand* m_nextCommand = nullptr;
-
 	virtual ~GlCommand()
 	{
 	}
@@ -35,7 +35,31 @@ public:
 	virtual ANKI_USE_RESULT Error operator()(GlState& state) = 0;
 };
 
-/// A number of GL commands organized in a chain
+/// The type of a command in the command stream.
+enum class GlCommandType : U8
+{
+	VIEWPORT,
+	POLYGON_OFFSET,
+	BIND_PIPELINE,
+	BIND_FRAMEBUFFER,
+	BIND_RESOURCE_GROUP,
+	DRAW_ELEMENTS,
+	DRAW_ARRAYS,
+	DRAW_ELEMENTS_INDIRECT,
+	DRAW_ELEMENTS_CONDITIONAL,
+	DRAW_ARRAYS_CONDITIONAL,
+	DISPATCH,
+	BEGIN_OCCLUSION_QUERY,
+	END_OCCLUSION_QUERY,
+	PUSH_SECOND_LEVEL,
+	MEMORY_BARRIER,
+	GENERIC ///< A GlCommand.
+};
+
+/// The commands of a command buffer packed in a linear stream of bytes. Every
+/// command is a small header followed by its payload. The stream is replayed
+/// with a switch and it stays intact so a command buffer can be executed many
+/// times. Redundant state changes are dropped while recording.
 class CommandBufferImpl
 {
 public:
@@ -78,11 +102,11 @@ public:
 	/// Compute initialization hints.
 	InitHints computeInitHints() const;
 
-	/// Create a new command and add it to the chain.
+	/// Create a new GlCommand and add it to the stream.
 	template<typename TCommand, typename... TArgs>
 	void pushBackNewCommand(TArgs&&... args);
 
-	/// Execute all commands
+	/// Execute all commands. It can be called many times.
 	ANKI_USE_RESULT Error executeAllCommands();
 
 	/// Fake that it's been executed
@@ -106,9 +130,23 @@ public:
 
 	Bool isEmpty() const
 	{
-		return m_firstCommand == nullptr;
+		return m_commandCount == 0;
 	}
 
+	/// Get the number of commands in the stream.
+	U32 getCommandCount() const
+	{
+		return m_commandCount;
+	}
+
+	void setViewport(U16 minx, U16 miny, U16 maxx, U16 maxy);
+
+	void setPolygonOffset(F32 factor, F32 units);
+
+	void bindPipeline(PipelinePtr ppline);
+
+	void beginRenderPass(FramebufferPtr fb);
+
 	void bindResourceGroup(
 		ResourceGroupPtr rc, U slot, const TransientMemoryInfo* info);
 
@@ -121,6 +159,8 @@ public:
 	void drawArrays(
 		U32 count, U32 instanceCount = 1, U32 first = 0, U32 baseInstance = 0);
 
+	void drawElementsIndirect(U32 drawCount, const TransientMemoryToken& token);
+
 	void drawElementsConditional(OcclusionQueryPtr query,
 		U32 count,
 		U32 instanceCount = 1,
@@ -136,11 +176,58 @@ public:
 
 	void dispatchCompute(U32 groupCountX, U32 groupCountY, U32 groupCountZ);
 
+	void beginOcclusionQuery(OcclusionQueryPtr query);
+
+	void endOcclusionQuery(OcclusionQueryPtr query);
+
+	void pushSecondLevelCommandBuffer(CommandBufferPtr cmdb);
+
+	void setMemoryBarrier(GLenum barrier);
+
 private:
+	/// A piece of the stream.
+	class Chunk
+	{
+	public:
+		Chunk* m_next;
+		U32 m_size;
+		U32 m_capacity;
+	};
+
+	/// The header of every command.
+	class CommandHeader
+	{
+	public:
+		U32 m_size; ///< The size of the command including the header.
+		GlCommandType m_type;
+	};
+
+	/// The alignment of the commands in the stream.
+	static const U COMMAND_ALIGNMENT = 8;
+
+	static const U32 MIN_CHUNK_SIZE = 1024;
+	static const U32 MAX_CHUNK_SIZE = 64 * 1024;
+
+	/// The state that the stream has set so far. Used to skip redundant
+	/// commands while recording.
+	class RecordState
+	{
+	public:
+		Array<U16, 4> m_viewport;
+		F32 m_polygonOffsetFactor;
+		F32 m_polygonOffsetUnits;
+		U64 m_pplineUuid;
+		Array<U64, MAX_BOUND_RESOURCE_GROUPS> m_rcUuids;
+		Bool8 m_viewportSet;
+		Bool8 m_polygonOffsetSet;
+	};
+
 	GrManager* m_manager = nullptr;
-	GlCommand* m_firstCommand = nullptr;
-	GlCommand* m_lastCommand = nullptr;
+	Chunk* m_firstChunk = nullptr;
+	Chunk* m_lastChunk = nullptr;
+	U32 m_commandCount = 0;
 	CommandBufferAllocator<U8> m_alloc;
+	RecordState m_recState;
 	Bool8 m_immutable = false;
 
 #if ANKI_DEBUG
@@ -149,6 +236,21 @@ private:
 
 	void destroy();
 
+	/// Allocate a command at the end of the stream.
+	/// @return The memory of the payload.
+	void* newCommand(GlCommandType type, PtrSize payloadSize);
+
+	template<typename T>
+	T* newCommand(GlCommandType type)
+	{
+		static_assert(alignof(T) <= COMMAND_ALIGNMENT, "Wrong alignment");
+		return static_cast<T*>(newCommand(type, sizeof(T)));
+	}
+
+	/// Forget the state of the stream. The next state commands will not be
+	/// skipped.
+	void resetRecordState();
+
 	void checkDrawcall() const
 	{
 		ANKI_ASSERT(m_dbg.m_viewport == true);
@@ -160,23 +262,12 @@ private:
 template<typename TCommand, typename... TArgs>
 inline void CommandBufferImpl::pushBackNewCommand(TArgs&&... args)
 {
-	ANKI_ASSERT(!m_immutable);
-	TCommand* newCommand =
-		m_alloc.template newInstance<TCommand>(std::forward<TArgs>(args)...);
+	static_assert(alignof(TCommand) <= COMMAND_ALIGNMENT, "Wrong alignment");
+	void* mem = newCommand(GlCommandType::GENERIC, sizeof(TCommand));
+	::new(mem) TCommand(std::forward<TArgs>(args)...);
 
-	if(m_firstCommand != nullptr)
-	{
-		ANKI_ASSERT(m_lastCommand != nullptr);
-		ANKI_ASSERT(m_lastCommand->m_nextCommand == nullptr);
-		m_lastCommand->m_nextCommand = newCommand;
-		m_lastCommand = newCommand;
-	}
-	else
-	{
-		ANKI_ASSERT(m_lastCommand == nullptr);
-		m_firstCommand = newCommand;
-		m_lastCommand = newCommand;
-	}
+	// Don't know what it touches
+	resetRecordState();
 }
 /// @}
 
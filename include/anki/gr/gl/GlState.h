@@ -33,6 +33,8 @@ public:
 	GrManager* m_manager;
 	I32 m_version = -1; ///< Minor major GL version. Something like 430
 	GpuVendor m_gpu = GpuVendor::UNKNOWN;
+	/// The vertex shaders can read the base instance of the drawcall.
+	Bool8 m_shaderDrawParameters = false;
 	Bool8 m_registerMessages = false;
 
 	GLuint m_defaultVao;
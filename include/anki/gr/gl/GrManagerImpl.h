@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/gr/Common.h>
+#include <anki/gr/common/ShaderCache.h>
 
 namespace anki
 {
@@ -69,10 +70,20 @@ public:
 		return *m_transManager;
 	}
 
+	/// The cache of the program binaries. Use it from the rendering thread.
+	ShaderCache& getShaderCache()
+	{
+		return m_shaderCache;
+	}
+
 	GrAllocator<U8> getAllocator() const;
 
 	void swapBuffers();
 
+	/// Initialize the shader cache. It needs the context so it's called from
+	/// the rendering thread.
+	void initShaderCacheRenderThread();
+
 	void pinContextToCurrentThread(Bool pin);
 
 private:
@@ -81,6 +92,8 @@ private:
 	RenderingThread* m_thread = nullptr;
 	WindowingBackend* m_backend = nullptr; ///< The backend of the backend.
 	TransientMemoryManager* m_transManager = nullptr;
+	ShaderCache m_shaderCache;
+	Bool8 m_diskShaderCache = false;
 
 	ANKI_USE_RESULT Error createBackend(GrManagerInitInfo& init);
 	void destroyBackend();
@@ -11,6 +11,9 @@
 namespace anki
 {
 
+// Forward
+class ShaderCache;
+
 /// @addtogroup opengl
 /// @{
 
@@ -84,6 +87,12 @@ private:
 	/// Attach all the programs
 	ANKI_USE_RESULT Error createGlPipeline();
 
+	/// Create the program from a cached binary.
+	/// @return False if there is no binary or the driver rejected it.
+	Bool loadProgramBinary(ShaderCache& cache, U64 key);
+
+	void storeProgramBinary(ShaderCache& cache, U64 key);
+
 	void initVertexState();
 	void initInputAssemblerState();
 	void initTessellationState();
@@ -7,14 +7,11 @@
 
 #include <anki/gr/Shader.h>
 #include <anki/gr/gl/GlObject.h>
+#include <anki/util/String.h>
 
 namespace anki
 {
 
-// Forward
-class CString;
-class String;
-
 /// @addtogroup opengl
 /// @{
 
@@ -33,10 +30,25 @@ public:
 
 	~ShaderImpl();
 
-	/// Create the shader.
+	/// Create the shader. If the shader cache is enabled the compilation is
+	/// deferred until a pipeline can't find its binary in the cache.
 	/// @param shaderType The type of the shader in the program
 	/// @param source The shader's source
 	ANKI_USE_RESULT Error init(ShaderType shaderType, const CString& source);
+
+	/// Compile the shader if it's not compiled already.
+	ANKI_USE_RESULT Error compile();
+
+	/// The hash of the final source. Pipelines use it to find their binaries.
+	U64 getSourceHash() const
+	{
+		return m_sourceHash;
+	}
+
+private:
+	String m_source; ///< The final source. Kept until compile.
+	U64 m_sourceHash = 0;
+	Bool8 m_compileFailed = false;
 };
 /// @}
 
@@ -6,6 +6,8 @@
 #pragma once
 
 #include <anki/gr/gl/Common.h>
+#include <anki/gr/gl/BufferImpl.h>
+#include <anki/gr/Buffer.h>
 #include <anki/gr/common/GpuFrameRingAllocator.h>
 #include <anki/gr/common/GpuBlockAllocator.h>
 #include <anki/gr/common/Misc.h>
@@ -29,13 +31,15 @@ public:
 
 	~TransientMemoryManager();
 
-	void initMainThread(
-		GenericMemoryPoolAllocator<U8> alloc, const ConfigSet& cfg);
+	void initMainThread(GrManager* manager,
+		GenericMemoryPoolAllocator<U8> alloc,
+		const ConfigSet& cfg);
 
 	void initRenderThread();
 
 	void destroyRenderThread();
 
+	/// @note It's called from the client thread.
 	void endFrame();
 
 	void allocate(PtrSize size,
@@ -56,8 +60,11 @@ public:
 		void* addr;
 		if(token.m_lifetime == TransientMemoryTokenLifetime::PER_FRAME)
 		{
-			addr = m_perFrameBuffers[bufferUsageToTransient(token.m_usage)]
-					   .m_mappedMem;
+			const PerFrameBuffer& buff =
+				m_perFrameBuffers[bufferUsageToTransient(token.m_usage)];
+			addr = (token.m_page == GpuFrameRingAllocator::MAIN_PAGE)
+				? buff.m_mappedMem
+				: buff.m_pages[token.m_page].m_mappedMem;
 		}
 		else
 		{
@@ -72,8 +79,13 @@ public:
 		GLuint name;
 		if(token.m_lifetime == TransientMemoryTokenLifetime::PER_FRAME)
 		{
-			name =
-				m_perFrameBuffers[bufferUsageToTransient(token.m_usage)].m_name;
+			const PerFrameBuffer& buff =
+				m_perFrameBuffers[bufferUsageToTransient(token.m_usage)];
+			name = (token.m_page == GpuFrameRingAllocator::MAIN_PAGE)
+				? buff.m_name
+				: buff.m_pages[token.m_page]
+					  .m_buff->getImplementation()
+					  .getGlName();
 		}
 		else
 		{
@@ -89,17 +101,34 @@ private:
 		U8 _m_val[16];
 	};
 
+	/// An overflow page. It's a Buffer so it can be created from any thread.
+	class OverflowPage
+	{
+	public:
+		BufferPtr m_buff;
+		DynamicArray<Aligned16Type> m_cpuBuff;
+		U8* m_mappedMem = nullptr;
+	};
+
 	// CPU or GPU buffer.
-	class PerFrameBuffer
+	class PerFrameBuffer : public GpuFrameRingAllocatorPageInterface
 	{
 	public:
+		TransientMemoryManager* m_manager = nullptr;
+		BufferUsageBit m_usage = BufferUsageBit::NONE;
 		PtrSize m_size = 0;
 		GLuint m_name = 0;
 		DynamicArray<Aligned16Type> m_cpuBuff;
 		U8* m_mappedMem = nullptr;
 		GpuFrameRingAllocator m_alloc;
+		Array<OverflowPage, GpuFrameRingAllocator::MAX_PAGES> m_pages;
+
+		ANKI_USE_RESULT Error createPage(U32 page, PtrSize size) override;
+
+		void destroyPage(U32 page) override;
 	};
 
+	GrManager* m_manager = nullptr;
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Array<PerFrameBuffer, U(TransientBufferType::COUNT)> m_perFrameBuffers;
 };
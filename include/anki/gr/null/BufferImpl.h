@@ -0,0 +1,73 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+#include <anki/util/DynamicArray.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Buffer implementation. The storage is CPU memory that is always mapped.
+class BufferImpl : public NullObject
+{
+public:
+	BufferImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~BufferImpl();
+
+	ANKI_USE_RESULT Error init(
+		PtrSize size, BufferUsageBit usage, BufferMapAccessBit access);
+
+	ANKI_USE_RESULT void* map(
+		PtrSize offset, PtrSize range, BufferMapAccessBit access);
+
+	void unmap()
+	{
+		ANKI_ASSERT(isCreated());
+		ANKI_ASSERT(m_mapped);
+
+#if ANKI_ASSERTIONS
+		m_mapped = false;
+#endif
+	}
+
+	/// Copy data to the buffer. The uploads end up here.
+	void write(PtrSize offset, const void* data, PtrSize size);
+
+	PtrSize getSize() const
+	{
+		return m_storage.getSize();
+	}
+
+	BufferUsageBit getUsage() const
+	{
+		return m_usage;
+	}
+
+private:
+	DynamicArray<U8> m_storage;
+	BufferUsageBit m_usage = BufferUsageBit::NONE;
+	BufferMapAccessBit m_access = BufferMapAccessBit::NONE;
+
+#if ANKI_ASSERTIONS
+	Bool8 m_mapped = false;
+#endif
+
+	Bool isCreated() const
+	{
+		return m_storage.getSize() > 0;
+	}
+};
+/// @}
+
+} // end namespace anki
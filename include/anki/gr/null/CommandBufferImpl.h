@@ -0,0 +1,120 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+#include <anki/gr/CommandBuffer.h>
+#include <anki/util/Allocator.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+template<typename T>
+using CommandBufferAllocator = StackAllocator<T>;
+
+/// The state while executing commands.
+class NullState
+{
+public:
+	GrManagerImpl* m_gr = nullptr;
+	GrStatistics m_stats;
+	PipelineImpl* m_ppline = nullptr;
+	FramebufferImpl* m_fb = nullptr;
+	Array<U16, 4> m_viewport = {{0, 0, 0, 0}};
+	F32 m_polygonOffsetFactor = 0.0;
+	F32 m_polygonOffsetUnits = 0.0;
+};
+
+/// A recorded command.
+class NullCommand
+{
+public:
+	NullCommand* m_nextCommand = nullptr;
+
+	virtual ~NullCommand()
+	{
+	}
+
+	/// Execute command
+	virtual void operator()(NullState& state) = 0;
+};
+
+/// Command buffer implementation. The commands are recorded to a linked list
+/// like the GL backend does and they run when the command buffer is flushed.
+class CommandBufferImpl : public NullObject
+{
+public:
+	CommandBufferImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~CommandBufferImpl();
+
+	void init(const CommandBufferInitInfo& init);
+
+	CommandBufferInitHints computeInitHints() const;
+
+	/// Create a new command and add it to the chain.
+	template<typename TCommand, typename... TArgs>
+	void pushBackNewCommand(TArgs&&... args);
+
+	/// Execute all commands. The second level command buffers are executed
+	/// by the command buffer they are pushed to.
+	void executeAllCommands(NullState& state);
+
+	/// Make immutable. No commands can be added after that.
+	void makeImmutable()
+	{
+		m_immutable = true;
+	}
+
+	Bool isEmpty() const
+	{
+		return m_firstCommand == nullptr;
+	}
+
+	Bool isSecondLevel() const
+	{
+		return (m_flags & CommandBufferFlag::SECOND_LEVEL)
+			== CommandBufferFlag::SECOND_LEVEL;
+	}
+
+private:
+	NullCommand* m_firstCommand = nullptr;
+	NullCommand* m_lastCommand = nullptr;
+	CommandBufferAllocator<U8> m_alloc;
+	CommandBufferFlag m_flags = CommandBufferFlag::NONE;
+	Bool8 m_immutable = false;
+};
+
+template<typename TCommand, typename... TArgs>
+inline void CommandBufferImpl::pushBackNewCommand(TArgs&&... args)
+{
+	ANKI_ASSERT(!m_immutable);
+	TCommand* newCommand =
+		m_alloc.template newInstance<TCommand>(std::forward<TArgs>(args)...);
+
+	if(m_firstCommand != nullptr)
+	{
+		ANKI_ASSERT(m_lastCommand != nullptr);
+		ANKI_ASSERT(m_lastCommand->m_nextCommand == nullptr);
+		m_lastCommand->m_nextCommand = newCommand;
+		m_lastCommand = newCommand;
+	}
+	else
+	{
+		ANKI_ASSERT(m_lastCommand == nullptr);
+		m_firstCommand = newCommand;
+		m_lastCommand = newCommand;
+	}
+}
+/// @}
+
+} // end namespace anki
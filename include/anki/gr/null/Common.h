@@ -0,0 +1,54 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Common.h>
+
+namespace anki
+{
+
+// Forward
+class GrManagerImpl;
+
+/// @addtogroup null
+/// @{
+
+/// Counters of the work that went through the NULL backend. The command
+/// buffers add to them when they are flushed.
+class GrStatistics
+{
+public:
+	U64 m_commandBufferCount = 0; ///< Flushed command buffers.
+	U64 m_commandCount = 0; ///< Executed commands.
+	U64 m_drawcallCount = 0;
+	U64 m_instanceCount = 0; ///< The instances of all the drawcalls.
+	U64 m_vertexCount = 0; ///< The vertices or indices of all drawcalls.
+	U64 m_dispatchCount = 0;
+	U64 m_renderPassCount = 0;
+	U64 m_pipelineBindCount = 0;
+	U64 m_resourceGroupBindCount = 0;
+	U64 m_uploadedBytes = 0; ///< Buffer and texture uploads.
+	U64 m_transientBytes = 0; ///< Allocated transient memory.
+
+	GrStatistics& operator+=(const GrStatistics& b)
+	{
+		m_commandBufferCount += b.m_commandBufferCount;
+		m_commandCount += b.m_commandCount;
+		m_drawcallCount += b.m_drawcallCount;
+		m_instanceCount += b.m_instanceCount;
+		m_vertexCount += b.m_vertexCount;
+		m_dispatchCount += b.m_dispatchCount;
+		m_renderPassCount += b.m_renderPassCount;
+		m_pipelineBindCount += b.m_pipelineBindCount;
+		m_resourceGroupBindCount += b.m_resourceGroupBindCount;
+		m_uploadedBytes += b.m_uploadedBytes;
+		m_transientBytes += b.m_transientBytes;
+		return *this;
+	}
+};
+/// @}
+
+} // end namespace anki
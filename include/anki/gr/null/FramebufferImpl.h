@@ -0,0 +1,40 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+#include <anki/gr/Framebuffer.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Framebuffer implementation. It holds the attachments.
+class FramebufferImpl : public NullObject
+{
+public:
+	FramebufferInitInfo m_init;
+
+	FramebufferImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~FramebufferImpl()
+	{
+	}
+
+	void init(const FramebufferInitInfo& init)
+	{
+		ANKI_ASSERT(init.isValid());
+		m_init = init;
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,78 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/Common.h>
+#include <anki/gr/null/TransientMemoryManager.h>
+#include <anki/util/Thread.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// The NULL backend. It records and executes the commands on the CPU without
+/// touching any GPU so the CPU side of the engine can run on machines without
+/// one.
+class GrManagerImpl
+{
+public:
+	GrManagerImpl(GrManager* manager)
+		: m_manager(manager)
+		, m_transientMem(manager)
+	{
+		ANKI_ASSERT(manager);
+	}
+
+	~GrManagerImpl();
+
+	ANKI_USE_RESULT Error init(const GrManagerInitInfo& init);
+
+	GrAllocator<U8> getAllocator() const;
+
+	void beginFrame();
+
+	void endFrame();
+
+	/// Execute the commands of a primary command buffer. It's thread-safe.
+	void flushCommandBuffer(CommandBufferPtr cmdb);
+
+	TransientMemoryManager& getTransientMemoryManager()
+	{
+		return m_transientMem;
+	}
+
+	U64 getFrameCount() const
+	{
+		return m_frame;
+	}
+
+	/// Get the counters since the last resetStatistics. It's thread-safe.
+	GrStatistics getStatistics() const;
+
+	/// Zero the counters. It's thread-safe.
+	void resetStatistics();
+
+	/// Add to the counters. It's thread-safe.
+	void addStatistics(const GrStatistics& stats)
+	{
+		LockGuard<SpinLock> lock(m_statsLock);
+		m_stats += stats;
+	}
+
+private:
+	GrManager* m_manager;
+	TransientMemoryManager m_transientMem;
+
+	GrStatistics m_stats;
+	mutable SpinLock m_statsLock;
+
+	U64 m_frame = 0;
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,45 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// The base class for all NULL object implementations.
+class NullObject
+{
+public:
+	NullObject(GrManager* manager)
+		: m_manager(manager)
+	{
+		ANKI_ASSERT(manager);
+	}
+
+	virtual ~NullObject()
+	{
+	}
+
+	GrAllocator<U8> getAllocator() const;
+
+	GrManagerImpl& getGrManagerImpl();
+
+	GrManager& getGrManager()
+	{
+		ANKI_ASSERT(m_manager);
+		return *m_manager;
+	}
+
+protected:
+	GrManager* m_manager = nullptr;
+};
+/// @}
+
+} // end namespace anki
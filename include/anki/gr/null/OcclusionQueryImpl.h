@@ -0,0 +1,47 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Occlusion query implementation. Nothing is rasterized so the conditional
+/// drawcalls consider this query always visible.
+class OcclusionQueryImpl : public NullObject
+{
+public:
+	OcclusionQueryResultBit m_condRenderingBit =
+		OcclusionQueryResultBit::VISIBLE;
+
+	OcclusionQueryImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~OcclusionQueryImpl()
+	{
+	}
+
+	void init(OcclusionQueryResultBit condRenderingBit)
+	{
+		m_condRenderingBit = condRenderingBit;
+	}
+
+	/// Check if a conditional drawcall should be skipped.
+	Bool skipDrawcall() const
+	{
+		return (m_condRenderingBit & OcclusionQueryResultBit::VISIBLE)
+			!= OcclusionQueryResultBit::VISIBLE;
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,44 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+#include <anki/gr/Pipeline.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Pipeline implementation. It holds the shaders and the state.
+class PipelineImpl : public NullObject
+{
+public:
+	PipelineInitInfo m_init;
+
+	PipelineImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~PipelineImpl()
+	{
+	}
+
+	void init(const PipelineInitInfo& init)
+	{
+		m_init = init;
+	}
+
+	Bool isCompute() const
+	{
+		return m_init.m_shaders[ShaderType::COMPUTE].isCreated();
+	}
+};
+/// @}
+
+} // end namespace anki
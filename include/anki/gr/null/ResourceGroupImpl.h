@@ -0,0 +1,49 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+#include <anki/gr/ResourceGroup.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Resource group implementation. It holds the bindings.
+class ResourceGroupImpl : public NullObject
+{
+public:
+	ResourceGroupInitInfo m_init;
+
+	ResourceGroupImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~ResourceGroupImpl()
+	{
+	}
+
+	void init(const ResourceGroupInitInfo& init);
+
+	/// The number of resources the group binds.
+	U32 getBindingCount() const
+	{
+		return m_bindingCount;
+	}
+
+	/// Check if the transient memory covers all the bindings that use it.
+	Bool checkTransientMemoryInfo(const TransientMemoryInfo* info) const;
+
+private:
+	U32 m_bindingCount = 0;
+	Bool8 m_hasUploadedMemory = false;
+};
+/// @}
+
+} // end namespace anki
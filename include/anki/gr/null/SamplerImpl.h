@@ -0,0 +1,39 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+#include <anki/gr/Sampler.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Sampler implementation.
+class SamplerImpl : public NullObject
+{
+public:
+	SamplerInitInfo m_init;
+
+	SamplerImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~SamplerImpl()
+	{
+	}
+
+	void init(const SamplerInitInfo& init)
+	{
+		m_init = init;
+	}
+};
+/// @}
+
+} // end namespace anki
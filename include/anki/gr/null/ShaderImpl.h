@@ -0,0 +1,39 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Shader implementation. The source is not compiled.
+class ShaderImpl : public NullObject
+{
+public:
+	ShaderType m_shaderType = ShaderType::COUNT;
+
+	ShaderImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~ShaderImpl()
+	{
+	}
+
+	void init(ShaderType shaderType, const CString& source)
+	{
+		ANKI_ASSERT(!source.isEmpty());
+		m_shaderType = shaderType;
+	}
+};
+/// @}
+
+} // end namespace anki
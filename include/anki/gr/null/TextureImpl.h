@@ -0,0 +1,44 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/NullObject.h>
+#include <anki/gr/Texture.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Texture implementation. It keeps only the description of the texture. The
+/// texels are never stored since nothing can sample them.
+class TextureImpl : public NullObject
+{
+public:
+	TextureInitInfo m_init;
+
+	TextureImpl(GrManager* manager)
+		: NullObject(manager)
+	{
+	}
+
+	~TextureImpl()
+	{
+	}
+
+	void init(const TextureInitInfo& init)
+	{
+		ANKI_ASSERT(init.isValid());
+		m_init = init;
+	}
+
+	/// Check if a surface is inside the texture.
+	Bool isValidSurface(const TextureSurfaceInfo& surf) const;
+};
+/// @}
+
+} // end namespace anki
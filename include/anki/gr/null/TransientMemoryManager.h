@@ -0,0 +1,103 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/null/Common.h>
+#include <anki/gr/common/GpuFrameRingAllocator.h>
+#include <anki/gr/common/Misc.h>
+#include <anki/util/DynamicArray.h>
+
+namespace anki
+{
+
+class ConfigSet;
+
+/// @addtogroup null
+/// @{
+
+/// Transient memory that lives in plain CPU memory. It's sized and aligned
+/// like the memory of the other backends so the CPU side behaves the same.
+class TransientMemoryManager
+{
+public:
+	TransientMemoryManager(GrManager* gr)
+		: m_manager(gr)
+	{
+		ANKI_ASSERT(gr);
+	}
+
+	~TransientMemoryManager()
+	{
+	}
+
+	ANKI_USE_RESULT Error init(const ConfigSet& cfg);
+
+	void destroy();
+
+	/// @note Not thread-safe.
+	void endFrame();
+
+	void allocate(PtrSize size,
+		BufferUsageBit usage,
+		TransientMemoryToken& token,
+		void*& ptr,
+		Error* outErr);
+
+	U8* getBaseAddress(const TransientMemoryToken& token)
+	{
+		ANKI_ASSERT(
+			token.m_lifetime == TransientMemoryTokenLifetime::PER_FRAME);
+		PerFrameBuffer& frame =
+			m_perFrameBuffers[bufferUsageToTransient(token.m_usage)];
+		DynamicArray<U8>& mem = frame.m_pages[token.m_page];
+		ANKI_ASSERT(token.m_offset + token.m_range <= mem.getSize());
+		return &mem[0];
+	}
+
+	/// Get the max bytes a frame has used.
+	PtrSize getHighWaterMark(TransientBufferType type) const
+	{
+		return m_perFrameBuffers[type].m_alloc.getHighWaterMark();
+	}
+
+	U32 getOverflowPageCount(TransientBufferType type) const
+	{
+		return m_perFrameBuffers[type].m_alloc.getOverflowPageCount();
+	}
+
+	/// Get the bytes that were allocated since the last reset.
+	PtrSize getAllocatedBytes() const
+	{
+		return m_allocatedBytes.load();
+	}
+
+	void resetAllocatedBytes()
+	{
+		m_allocatedBytes.store(0);
+	}
+
+private:
+	/// The ring and its overflow pages.
+	class PerFrameBuffer : public GpuFrameRingAllocatorPageInterface
+	{
+	public:
+		GrManager* m_manager = nullptr;
+		Array<DynamicArray<U8>, GpuFrameRingAllocator::MAX_PAGES> m_pages;
+		GpuFrameRingAllocator m_alloc;
+
+		ANKI_USE_RESULT Error createPage(U32 page, PtrSize size) override;
+
+		void destroyPage(U32 page) override;
+	};
+
+	GrManager* m_manager = nullptr;
+
+	Array<PerFrameBuffer, U(TransientBufferType::COUNT)> m_perFrameBuffers;
+	Atomic<PtrSize> m_allocatedBytes = {0};
+};
+/// @}
+
+} // end namespace anki
@@ -77,6 +77,8 @@ public:
 		U32 baseVertex,
 		U32 baseInstance);
 
+	void drawElementsIndirect(U32 drawCount, const TransientMemoryToken& token);
+
 	void beginOcclusionQuery(OcclusionQueryPtr query);
 
 	void endOcclusionQuery(OcclusionQueryPtr query);
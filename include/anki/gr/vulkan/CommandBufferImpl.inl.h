@@ -195,6 +195,22 @@ inline void CommandBufferImpl::drawElements(U32 count,
 		m_handle, count, instanceCount, firstIndex, baseVertex, baseInstance);
 }
 
+//==============================================================================
+inline void CommandBufferImpl::drawElementsIndirect(
+	U32 drawCount, const TransientMemoryToken& token)
+{
+	ANKI_ASSERT(drawCount > 0);
+	ANKI_ASSERT(
+		drawCount * sizeof(DrawElementsIndirectInfo) <= token.m_range);
+	drawcallCommon();
+	vkCmdDrawIndexedIndirect(m_handle,
+		getGrManagerImpl().getTransientMemoryManager().getBufferHandle(
+			token.m_usage),
+		token.m_offset,
+		drawCount,
+		sizeof(DrawElementsIndirectInfo));
+}
+
 //==============================================================================
 inline void CommandBufferImpl::beginOcclusionQuery(OcclusionQueryPtr query)
 {
@@ -11,6 +11,7 @@
 #include <anki/gr/vulkan/Semaphore.h>
 #include <anki/gr/vulkan/Fence.h>
 #include <anki/gr/vulkan/TransientMemoryManager.h>
+#include <anki/gr/common/ShaderCache.h>
 #include <anki/util/HashMap.h>
 
 namespace anki
@@ -71,6 +72,17 @@ public:
 		return m_globalPipelineLayout;
 	}
 
+	/// The pipeline cache that is loaded from and saved to the ShaderCache.
+	VkPipelineCache getPipelineCache() const
+	{
+		return m_pipelineCache;
+	}
+
+	ShaderCache& getShaderCache()
+	{
+		return m_shaderCache;
+	}
+
 	/// @name object_creation
 	/// @{
 
@@ -234,6 +246,12 @@ private:
 	U32 m_descriptorSetAllocationCount = 0;
 	VkPipelineLayout m_globalPipelineLayout = VK_NULL_HANDLE;
 
+	/// @name Shader_cache
+	/// @{
+	ShaderCache m_shaderCache;
+	VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+	/// @}
+
 	/// Map for compatible render passes.
 	class CompatibleRenderPassHashMap;
 	CompatibleRenderPassHashMap* m_renderPasses = nullptr;
@@ -299,6 +317,9 @@ private:
 	ANKI_USE_RESULT Error initGlobalDsetPool();
 	ANKI_USE_RESULT Error initGlobalPplineLayout();
 	ANKI_USE_RESULT Error initMemory(const ConfigSet& cfg);
+	void initShaderCache(const GrManagerInitInfo& init);
+	ANKI_USE_RESULT Error initPipelineCache();
+	void savePipelineCache();
 
 	static void* allocateCallback(void* userData,
 		size_t size,
@@ -42,6 +42,8 @@ public:
 		ANKI_ASSERT(m_nativeWindow == nullptr);
 	}
 
+	/// @param nativeWindow The window to get the events from. If it's nullptr
+	///        there will be no events.
 	ANKI_USE_RESULT Error create(NativeWindow* nativeWindow)
 	{
 		reset();
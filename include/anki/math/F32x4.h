@@ -0,0 +1,353 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/math/Simd.h>
+#include <anki/util/Functions.h>
+#include <anki/util/Array.h>
+
+namespace anki
+{
+
+/// @addtogroup math
+/// @{
+
+/// Set to 1 if F32x4 maps to SIMD registers. If not it's emulated with 4
+/// floats.
+#if ANKI_SIMD == ANKI_SIMD_SSE || ANKI_SIMD == ANKI_SIMD_NEON
+#define ANKI_F32X4_SIMD 1
+#else
+#define ANKI_F32X4_SIMD 0
+#endif
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+
+/// 4 floats that are processed together.
+using F32x4 = __m128;
+
+inline F32x4 splat(F32 x)
+{
+	return _mm_set1_ps(x);
+}
+
+inline F32x4 setLanes(F32 a, F32 b, F32 c, F32 d)
+{
+	return _mm_setr_ps(a, b, c, d);
+}
+
+inline F32x4 load(const F32* arr)
+{
+	return _mm_loadu_ps(arr);
+}
+
+inline void store(F32* arr, F32x4 a)
+{
+	_mm_storeu_ps(arr, a);
+}
+
+/// Load arr[idx[0]], arr[idx[1]], arr[idx[2]] and arr[idx[3]].
+inline F32x4 gather(const F32* arr, const U32* idx)
+{
+	return _mm_set_ps(arr[idx[3]], arr[idx[2]], arr[idx[1]], arr[idx[0]]);
+}
+
+inline F32x4 add(F32x4 a, F32x4 b)
+{
+	return _mm_add_ps(a, b);
+}
+
+inline F32x4 sub(F32x4 a, F32x4 b)
+{
+	return _mm_sub_ps(a, b);
+}
+
+inline F32x4 mul(F32x4 a, F32x4 b)
+{
+	return _mm_mul_ps(a, b);
+}
+
+/// a * b + c
+inline F32x4 mulAdd(F32x4 a, F32x4 b, F32x4 c)
+{
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+inline F32x4 minPerLane(F32x4 a, F32x4 b)
+{
+	return _mm_min_ps(a, b);
+}
+
+inline F32x4 maxPerLane(F32x4 a, F32x4 b)
+{
+	return _mm_max_ps(a, b);
+}
+
+/// Return a 4 bit mask with the lanes that are greater or equal to zero.
+inline U32 nonNegativeMask(F32x4 a)
+{
+	return _mm_movemask_ps(_mm_cmpge_ps(a, _mm_setzero_ps()));
+}
+
+/// Return min(depth, z) in the lanes that all edges are non negative and depth
+/// in the rest.
+inline F32x4 minInside(F32x4 depth, F32x4 z, F32x4 e0, F32x4 e1, F32x4 e2)
+{
+	const F32x4 zero = _mm_setzero_ps();
+	const F32x4 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero),
+		_mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+
+	return _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(depth, z)),
+		_mm_andnot_ps(inside, depth));
+}
+
+inline F32 horizontalMin(F32x4 a)
+{
+	a = _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+	a = _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(a);
+}
+
+inline F32 horizontalMax(F32x4 a)
+{
+	a = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+	a = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(a);
+}
+
+#elif ANKI_SIMD == ANKI_SIMD_NEON
+
+/// 4 floats that are processed together.
+using F32x4 = float32x4_t;
+
+inline F32x4 splat(F32 x)
+{
+	return vdupq_n_f32(x);
+}
+
+inline F32x4 setLanes(F32 a, F32 b, F32 c, F32 d)
+{
+	const F32 tmp[4] = {a, b, c, d};
+	return vld1q_f32(tmp);
+}
+
+inline F32x4 load(const F32* arr)
+{
+	return vld1q_f32(arr);
+}
+
+inline void store(F32* arr, F32x4 a)
+{
+	vst1q_f32(arr, a);
+}
+
+/// Load arr[idx[0]], arr[idx[1]], arr[idx[2]] and arr[idx[3]].
+inline F32x4 gather(const F32* arr, const U32* idx)
+{
+	const F32 tmp[4] = {arr[idx[0]], arr[idx[1]], arr[idx[2]], arr[idx[3]]};
+	return vld1q_f32(tmp);
+}
+
+inline F32x4 add(F32x4 a, F32x4 b)
+{
+	return vaddq_f32(a, b);
+}
+
+inline F32x4 sub(F32x4 a, F32x4 b)
+{
+	return vsubq_f32(a, b);
+}
+
+inline F32x4 mul(F32x4 a, F32x4 b)
+{
+	return vmulq_f32(a, b);
+}
+
+/// a * b + c
+inline F32x4 mulAdd(F32x4 a, F32x4 b, F32x4 c)
+{
+	return vmlaq_f32(c, a, b);
+}
+
+inline F32x4 minPerLane(F32x4 a, F32x4 b)
+{
+	return vminq_f32(a, b);
+}
+
+inline F32x4 maxPerLane(F32x4 a, F32x4 b)
+{
+	return vmaxq_f32(a, b);
+}
+
+/// Return a 4 bit mask with the lanes that are greater or equal to zero.
+inline U32 nonNegativeMask(F32x4 a)
+{
+	static const U32 LANE_BITS[4] = {1, 2, 4, 8};
+	const uint32x4_t ge = vcgeq_f32(a, vdupq_n_f32(0.0));
+	const uint32x4_t bits = vandq_u32(ge, vld1q_u32(LANE_BITS));
+	const uint32x2_t pair = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+	return vget_lane_u32(pair, 0) | vget_lane_u32(pair, 1);
+}
+
+/// Return min(depth, z) in the lanes that all edges are non negative and depth
+/// in the rest.
+inline F32x4 minInside(F32x4 depth, F32x4 z, F32x4 e0, F32x4 e1, F32x4 e2)
+{
+	const F32x4 zero = vdupq_n_f32(0.0);
+	const uint32x4_t inside = vandq_u32(vcgeq_f32(e0, zero),
+		vandq_u32(vcgeq_f32(e1, zero), vcgeq_f32(e2, zero)));
+
+	return vbslq_f32(inside, vminq_f32(depth, z), depth);
+}
+
+inline F32 horizontalMin(F32x4 a)
+{
+	float32x2_t pair = vpmin_f32(vget_low_f32(a), vget_high_f32(a));
+	pair = vpmin_f32(pair, pair);
+	return vget_lane_f32(pair, 0);
+}
+
+inline F32 horizontalMax(F32x4 a)
+{
+	float32x2_t pair = vpmax_f32(vget_low_f32(a), vget_high_f32(a));
+	pair = vpmax_f32(pair, pair);
+	return vget_lane_f32(pair, 0);
+}
+
+#else
+
+/// Emulate 4 lanes when there is no SIMD.
+class F32x4
+{
+public:
+	Array<F32, 4> m_lanes;
+};
+
+inline F32x4 splat(F32 x)
+{
+	return F32x4{{{x, x, x, x}}};
+}
+
+inline F32x4 setLanes(F32 a, F32 b, F32 c, F32 d)
+{
+	return F32x4{{{a, b, c, d}}};
+}
+
+inline F32x4 load(const F32* arr)
+{
+	return F32x4{{{arr[0], arr[1], arr[2], arr[3]}}};
+}
+
+inline void store(F32* arr, F32x4 a)
+{
+	for(U i = 0; i < 4; ++i)
+	{
+		arr[i] = a.m_lanes[i];
+	}
+}
+
+/// Load arr[idx[0]], arr[idx[1]], arr[idx[2]] and arr[idx[3]].
+inline F32x4 gather(const F32* arr, const U32* idx)
+{
+	return F32x4{{{arr[idx[0]], arr[idx[1]], arr[idx[2]], arr[idx[3]]}}};
+}
+
+inline F32x4 add(F32x4 a, F32x4 b)
+{
+	for(U i = 0; i < 4; ++i)
+	{
+		a.m_lanes[i] += b.m_lanes[i];
+	}
+	return a;
+}
+
+inline F32x4 sub(F32x4 a, F32x4 b)
+{
+	for(U i = 0; i < 4; ++i)
+	{
+		a.m_lanes[i] -= b.m_lanes[i];
+	}
+	return a;
+}
+
+inline F32x4 mul(F32x4 a, F32x4 b)
+{
+	for(U i = 0; i < 4; ++i)
+	{
+		a.m_lanes[i] *= b.m_lanes[i];
+	}
+	return a;
+}
+
+/// a * b + c
+inline F32x4 mulAdd(F32x4 a, F32x4 b, F32x4 c)
+{
+	for(U i = 0; i < 4; ++i)
+	{
+		a.m_lanes[i] = a.m_lanes[i] * b.m_lanes[i] + c.m_lanes[i];
+	}
+	return a;
+}
+
+inline F32x4 minPerLane(F32x4 a, F32x4 b)
+{
+	for(U i = 0; i < 4; ++i)
+	{
+		a.m_lanes[i] = min(a.m_lanes[i], b.m_lanes[i]);
+	}
+	return a;
+}
+
+inline F32x4 maxPerLane(F32x4 a, F32x4 b)
+{
+	for(U i = 0; i < 4; ++i)
+	{
+		a.m_lanes[i] = max(a.m_lanes[i], b.m_lanes[i]);
+	}
+	return a;
+}
+
+/// Return a 4 bit mask with the lanes that are greater or equal to zero.
+inline U32 nonNegativeMask(F32x4 a)
+{
+	U32 mask = 0;
+	for(U i = 0; i < 4; ++i)
+	{
+		mask |= (a.m_lanes[i] >= 0.0) ? (1u << i) : 0u;
+	}
+	return mask;
+}
+
+/// Return min(depth, z) in the lanes that all edges are non negative and depth
+/// in the rest.
+inline F32x4 minInside(F32x4 depth, F32x4 z, F32x4 e0, F32x4 e1, F32x4 e2)
+{
+	for(U i = 0; i < 4; ++i)
+	{
+		if(e0.m_lanes[i] >= 0.0 && e1.m_lanes[i] >= 0.0
+			&& e2.m_lanes[i] >= 0.0)
+		{
+			depth.m_lanes[i] = min(depth.m_lanes[i], z.m_lanes[i]);
+		}
+	}
+	return depth;
+}
+
+inline F32 horizontalMin(F32x4 a)
+{
+	return min(
+		min(a.m_lanes[0], a.m_lanes[1]), min(a.m_lanes[2], a.m_lanes[3]));
+}
+
+inline F32 horizontalMax(F32x4 a)
+{
+	return max(
+		max(a.m_lanes[0], a.m_lanes[1]), max(a.m_lanes[2], a.m_lanes[3]));
+}
+
+#endif
+/// @}
+
+} // end namespace anki
@@ -16,10 +16,26 @@
 namespace anki
 {
 
+// Forward
+class XmlBakedElement;
+
 /// @addtogroup misc
 /// @{
 
-/// XML element.
+/// The tables of a baked XML document. They point to the memory of the
+/// XmlDocument.
+class XmlBakedTables
+{
+public:
+	const XmlBakedElement* m_elements = nullptr;
+	const F64* m_numbers = nullptr;
+	const char* m_strings = nullptr;
+	U32 m_elementCount = 0;
+	U32 m_numberCount = 0;
+	U32 m_stringsSize = 0;
+};
+
+/// XML element. It reads a tinyxml2 element or an element of a baked document.
 class XmlElement
 {
 	friend class XmlDocument;
@@ -32,6 +48,8 @@ public:
 
 	XmlElement(const XmlElement& b)
 		: m_el(b.m_el)
+		, m_baked(b.m_baked)
+		, m_bakedIdx(b.m_bakedIdx)
 		, m_alloc(b.m_alloc)
 	{
 	}
@@ -46,13 +64,15 @@ public:
 	/// If element has something return true
 	operator Bool() const
 	{
-		return m_el != nullptr;
+		return m_el != nullptr || m_baked != nullptr;
 	}
 
 	/// Copy
 	XmlElement& operator=(const XmlElement& b)
 	{
 		m_el = b.m_el;
+		m_baked = b.m_baked;
+		m_bakedIdx = b.m_bakedIdx;
 		m_alloc = b.m_alloc;
 		return *this;
 	}
@@ -97,29 +117,91 @@ public:
 
 private:
 	const tinyxml2::XMLElement* m_el;
+	const XmlBakedTables* m_baked = nullptr; ///< Set if the element is baked.
+	U32 m_bakedIdx = 0;
 	GenericMemoryPoolAllocator<U8> m_alloc;
 
+	XmlElement(const XmlBakedTables* baked,
+		U32 idx,
+		GenericMemoryPoolAllocator<U8> alloc)
+		: m_el(nullptr)
+		, m_baked(baked)
+		, m_bakedIdx(idx)
+		, m_alloc(alloc)
+	{
+	}
+
 	ANKI_USE_RESULT Error check() const;
+
+	const XmlBakedElement& getBakedElement() const;
+
+	const char* getName() const;
+
+	/// Get the text or nullptr if there is no text.
+	const char* getTextPtr() const;
+
+	/// Get the pre-parsed numbers of a baked element.
+	/// @return False if the element doesn't have them.
+	Bool getBakedNumbers(const F64*& numbers, U32& count) const;
+
+	/// Search for an element with the same name starting from idx.
+	XmlElement findBakedElement(U32 idx, const CString& name) const;
 };
 
-/// XML document
+/// XML document. It can be parsed from XML text or from a baked document. A
+/// baked document is a binary blob that is read in place. It has the element
+/// tree and the numbers of the elements already parsed.
 class XmlDocument
 {
 public:
 	static CString XML_HEADER;
 
+	/// The suffix that the baked documents append to the filename of the XML
+	/// file. Eg "file.ankimtl" is baked to "file.ankimtl.baked".
+	static CString BAKED_FILENAME_SUFFIX;
+
+	XmlDocument() = default;
+
+	~XmlDocument();
+
 	ANKI_USE_RESULT Error loadFile(
 		const CString& filename, GenericMemoryPoolAllocator<U8> alloc);
 
 	ANKI_USE_RESULT Error parse(
 		const CString& xmlText, GenericMemoryPoolAllocator<U8> alloc);
 
+	/// Load a baked document. The blob is copied to properly aligned memory
+	/// and the elements are read from there.
+	ANKI_USE_RESULT Error parseBaked(const void* data,
+		PtrSize size,
+		GenericMemoryPoolAllocator<U8> alloc);
+
+	/// Bake a document that was parsed from XML text. The baked document
+	/// keeps the size and the hash of that text.
+	ANKI_USE_RESULT Error bake(DynamicArrayAuto<U8>& out) const;
+
+	/// Check if a baked document was baked from some XML text. If it wasn't
+	/// the XML changed after the baking and the baked document is stale.
+	static Bool isBakedFromText(
+		const void* data, PtrSize size, const CString& xmlText);
+
 	ANKI_USE_RESULT Error getChildElement(
 		const CString& name, XmlElement& out) const;
 
+	Bool isBaked() const
+	{
+		return m_baked.m_elements != nullptr;
+	}
+
 private:
 	tinyxml2::XMLDocument m_doc;
 	GenericMemoryPoolAllocator<U8> m_alloc;
+
+	XmlBakedTables m_baked;
+	DynamicArray<F64> m_bakedStorage; ///< F64 to align the numbers.
+
+	U64 m_sourceHash = 0; ///< The hash of the parsed XML text.
+	U32 m_sourceSize = 0; ///< The size of the parsed XML text.
 };
 /// @}
 
@@ -16,7 +16,7 @@ namespace anki
 // Forward
 class FrustumComponent;
 class SceneNode;
-class ThreadPool;
+class ThreadHive;
 
 /// @addtogroup renderer
 /// @{
@@ -69,8 +69,6 @@ private:
 /// Collection of clusters for visibility tests.
 class Clusterer
 {
-	friend class UpdatePlanesPerspectiveCameraTask;
-
 public:
 	Clusterer()
 	{
@@ -84,7 +82,7 @@ public:
 		U clusterCountZ);
 
 	/// Prepare for visibility tests.
-	void prepare(ThreadPool& threadpool, const FrustumComponent& frc);
+	void prepare(ThreadHive& threadHive, const FrustumComponent& frc);
 
 	void initTestResults(const GenericMemoryPoolAllocator<U8>& alloc,
 		ClustererTestResult& rez) const;
@@ -167,7 +165,9 @@ private:
 
 	void computeSplitRange(const CollisionShape& cs, U& zBegin, U& zEnd) const;
 
-	void update(U32 threadId, PtrSize threadsCount, Bool frustumChanged);
+	/// Update the planes in [start, end). The range indexes the Y planes
+	/// first and then the X planes.
+	void update(PtrSize start, PtrSize end, Bool frustumChanged);
 
 	/// Calculate and set a top looking plane.
 	void calcPlaneY(U i, const Vec4& projParams);
@@ -47,6 +47,8 @@ private:
 		const RenderingKey& key);
 
 	ANKI_USE_RESULT Error drawSingle(DrawContext& ctx);
+
+	void stashDrawcall(DrawContext& ctx, const RenderComponent& renderable);
 };
 /// @}
 
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/renderer/Clusterer.h>
+#include <anki/util/FlatHashMap.h>
 
 namespace anki
 {
@@ -13,23 +14,29 @@ namespace anki
 // Forward
 class MoveComponent;
 class LightBinContext;
-class SpatialComponent;
 class LightComponent;
+class SceneNode;
 
 /// @addtogroup renderer
 /// @{
 
 /// Bins lights and probes to clusters.
+///
+/// The clusters of every light and probe are kept between frames and they are
+/// binned again only if the light or the camera changed. The lights of a
+/// cluster are counted first, a prefix sum gives the place of every cluster
+/// in the light index buffer and then the lights are scattered there. There
+/// is no limit of lights per cluster.
 class LightBin
 {
-	friend class WriteLightsTask;
+	friend class LightBinContext;
 
 public:
 	LightBin(const GenericMemoryPoolAllocator<U8>& alloc,
 		U clusterCountX,
 		U clusterCountY,
 		U clusterCountZ,
-		ThreadPool* threadPool,
+		ThreadHive* threadHive,
 		GrManager* gr);
 
 	~LightBin();
@@ -50,35 +57,83 @@ public:
 	}
 
 private:
+	/// The clusters of a light or a probe from a previous frame.
+	class CachedBin
+	{
+	public:
+		DynamicArray<U32> m_clusters;
+		U32 m_clusterCount = 0;
+		const FrustumComponent* m_frc = nullptr;
+		Timestamp m_timestamp = 0; ///< When the clusters were computed.
+		U32 m_frame = 0; ///< The last bin that used it.
+	};
+
+	/// Hash the node pointer.
+	class CacheHasher
+	{
+	public:
+		U64 operator()(const U64& b) const
+		{
+			return b * 0x9E3779B97F4A7C15;
+		}
+	};
+
+	class CacheCompare
+	{
+	public:
+		Bool operator()(const U64& a, const U64& b) const
+		{
+			return a == b;
+		}
+	};
+
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Clusterer m_clusterer;
 	U32 m_clusterCount = 0;
-	ThreadPool* m_threadPool = nullptr;
+	ThreadHive* m_threadHive = nullptr;
 	GrManager* m_gr = nullptr;
-	Barrier m_barrier;
 
-	void binLights(U32 threadId, PtrSize threadsCount, LightBinContext& ctx);
+	/// The cached bins of the visible lights and probes. The key is the node.
+	FlatHashMap<U64, CachedBin*, CacheHasher, CacheCompare> m_cache;
+	U32 m_frame = 0;
+
+	/// Find or create the cached bins of the visible nodes and throw away
+	/// the rest.
+	void updateCache(LightBinContext& ctx);
+
+	void binLights(PtrSize start,
+		PtrSize end,
+		LightBinContext& ctx,
+		ClustererTestResult& testResult);
 
-	I writePointLight(const LightComponent& light,
+	void scatterLights(PtrSize start, PtrSize end, LightBinContext& ctx);
+
+	void writeClusters(PtrSize start, PtrSize end, LightBinContext& ctx);
+
+	void writePointLight(const LightComponent& light,
 		const MoveComponent& move,
 		const FrustumComponent& camfrc,
+		U idx,
 		LightBinContext& ctx);
 
-	I writeSpotLight(const LightComponent& lightc,
+	void writeSpotLight(const LightComponent& lightc,
 		const MoveComponent& lightMove,
 		const FrustumComponent* lightFrc,
 		const MoveComponent& camMove,
 		const FrustumComponent& camFrc,
+		U idx,
 		LightBinContext& ctx);
 
-	void binLight(SpatialComponent& sp,
-		U pos,
-		U lightType,
-		LightBinContext& ctx,
-		ClustererTestResult& testResult);
-
-	void writeAndBinProbe(const FrustumComponent& camFrc,
+	void writeProbe(const FrustumComponent& camFrc,
 		const SceneNode& node,
+		U idx,
+		LightBinContext& ctx);
+
+	/// Get the clusters of an element from the cache or bin it again and
+	/// count it in the clusters.
+	void binElement(const SceneNode& node,
+		U elementIdx,
+		U type,
 		LightBinContext& ctx,
 		ClustererTestResult& testResult);
 };
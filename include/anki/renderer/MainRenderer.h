@@ -17,7 +17,7 @@ class ResourceManager;
 class ConfigSet;
 class SceneGraph;
 class SceneNode;
-class ThreadPool;
+class ThreadHive;
 
 /// @addtogroup renderer
 /// @{
@@ -30,7 +30,7 @@ public:
 
 	~MainRenderer();
 
-	ANKI_USE_RESULT Error create(ThreadPool* threadpool,
+	ANKI_USE_RESULT Error create(ThreadHive* threadHive,
 		ResourceManager* resources,
 		GrManager* gl,
 		AllocAlignedCallback allocCb,
@@ -0,0 +1,299 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/renderer/Common.h>
+#include <anki/Gr.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/ThreadHive.h>
+
+namespace anki
+{
+
+// Forward
+class RenderingContext;
+
+/// @addtogroup renderer
+/// @{
+
+/// The callback that records the commands of a pass in the primary command
+/// buffer.
+using RenderGraphRunCallback = Error (*)(void* userData, RenderingContext& ctx);
+
+/// The callback that builds the second level command buffers of a pass. The
+/// work of the pass is split in sliceCount slices.
+using RenderGraphBuildCallback = Error (*)(
+	void* userData, RenderingContext& ctx, U slice, U sliceCount);
+
+/// A graph of the render passes of a frame.
+///
+/// The passes declare the textures and the buffers they read and write. The
+/// compile step:
+/// - Culls the passes that don't contribute to the outputs.
+/// - Works out the barriers between the passes.
+/// - Creates the textures of the graph. Textures with the same description
+///   that don't live at the same time share the same physical texture.
+/// - Splits the passes in dependency levels. Passes of the same level don't
+///   depend on each other.
+///
+/// The second level command buffers of all the passes are recorded in
+/// parallel since the barriers are known after compile.
+///
+/// The passes run in the order they were declared so a pass should be
+/// declared after the passes it depends on.
+class RenderGraph : public NonCopyable
+{
+public:
+	static const U32 NULL_HANDLE = MAX_U32;
+
+	RenderGraph()
+	{
+	}
+
+	~RenderGraph();
+
+	void init(GrManager* gr, HeapAllocator<U8> alloc)
+	{
+		ANKI_ASSERT(gr);
+		m_gr = gr;
+		m_alloc = alloc;
+	}
+
+	/// @name Declaration
+	/// @{
+
+	/// Declare a texture that the graph creates.
+	/// @param name The name of the texture. It should outlive the graph.
+	/// @return The handle of the texture.
+	U32 newTexture(CString name, const TextureInitInfo& init);
+
+	/// Declare a texture that lives outside the graph. Set it with
+	/// setImportedTexture before run.
+	/// @param mipmapCount The barriers are set to that many mipmaps.
+	U32 importTexture(CString name, U mipmapCount = 1);
+
+	/// Declare a buffer that lives outside the graph. Set it with
+	/// setImportedBuffer before run.
+	U32 importBuffer(CString name);
+
+	/// Declare a pass.
+	/// @param name The name of the pass.
+	/// @param run Records the commands of the pass.
+	/// @param userData Passed to the callbacks.
+	/// @param build Builds the second level command buffers. It can be nullptr.
+	U32 newPass(CString name,
+		RenderGraphRunCallback run,
+		void* userData,
+		RenderGraphBuildCallback build = nullptr);
+
+	void readTexture(U32 pass, U32 tex, TextureUsageBit usage)
+	{
+		newDependency(pass, tex, true, U(usage), false);
+	}
+
+	void writeTexture(U32 pass, U32 tex, TextureUsageBit usage)
+	{
+		newDependency(pass, tex, true, U(usage), true);
+	}
+
+	void readBuffer(U32 pass, U32 buff, BufferUsageBit usage)
+	{
+		newDependency(pass, buff, false, U(usage), false);
+	}
+
+	void writeBuffer(U32 pass, U32 buff, BufferUsageBit usage)
+	{
+		newDependency(pass, buff, false, U(usage), true);
+	}
+
+	/// The pass has effects outside the graph so it's never culled.
+	void setSideEffects(U32 pass)
+	{
+		m_passes[pass].m_sideEffects = true;
+	}
+
+	/// The texture is used outside the graph. The passes that write it are
+	/// not culled and no texture takes its memory after it.
+	void markOutput(U32 tex)
+	{
+		m_textures[tex].m_output = true;
+	}
+	/// @}
+
+	/// Compile the graph and create the textures. If it's called again the
+	/// textures are re-created.
+	ANKI_USE_RESULT Error compile();
+
+	/// Get the texture of a handle. Call it after compile.
+	TexturePtr getTexture(U32 tex) const;
+
+	/// Get a sampler that samples the texture like it was declared. It's
+	/// needed when the physical texture was created with a different sampling.
+	/// @return The sampler or an empty pointer.
+	SamplerPtr getSampler(U32 tex) const
+	{
+		ANKI_ASSERT(m_compiled);
+		return m_textures[tex].m_sampler;
+	}
+
+	void setImportedTexture(U32 tex, TexturePtr ptr)
+	{
+		ANKI_ASSERT(m_textures[tex].m_imported);
+		m_textures[tex].m_importedTex = ptr;
+	}
+
+	void setImportedBuffer(U32 buff, BufferPtr ptr)
+	{
+		m_buffers[buff].m_buff = ptr;
+	}
+
+	/// Build the second level command buffers of the passes in parallel.
+	ANKI_USE_RESULT Error buildCommandBuffers(
+		RenderingContext& ctx, ThreadHive& hive);
+
+	/// Set the barriers and record the commands of the passes.
+	ANKI_USE_RESULT Error run(RenderingContext& ctx);
+
+	/// @name Statistics
+	/// @{
+	Bool isPassCulled(U32 pass) const
+	{
+		ANKI_ASSERT(m_compiled);
+		return m_passes[pass].m_level == NULL_HANDLE;
+	}
+
+	U32 getPassDependencyLevel(U32 pass) const
+	{
+		ANKI_ASSERT(!isPassCulled(pass));
+		return m_passes[pass].m_level;
+	}
+
+	U32 getDependencyLevelCount() const
+	{
+		ANKI_ASSERT(m_compiled);
+		return m_levelCount;
+	}
+
+	/// Get the number of textures that the graph created.
+	U32 getPhysicalTextureCount() const
+	{
+		return m_physicalTextures.getSize();
+	}
+
+	/// Get the barriers that run sets every frame.
+	U32 getBarrierCount() const
+	{
+		return m_barrierCount;
+	}
+	/// @}
+
+private:
+	class Pass
+	{
+	public:
+		CString m_name;
+		RenderGraphRunCallback m_run = nullptr;
+		RenderGraphBuildCallback m_build = nullptr;
+		void* m_userData = nullptr;
+		Bool8 m_sideEffects = false;
+		U32 m_level = NULL_HANDLE; ///< NULL_HANDLE if it's culled.
+		U32 m_firstBarrier = 0;
+		U32 m_barrierCount = 0;
+	};
+
+	class TextureResource
+	{
+	public:
+		CString m_name;
+		TextureInitInfo m_init;
+		TexturePtr m_importedTex;
+		SamplerPtr m_sampler;
+		U32 m_mipmapCount = 1;
+		U32 m_physical = NULL_HANDLE;
+		U32 m_firstPass = NULL_HANDLE;
+		U32 m_lastPass = NULL_HANDLE;
+		Bool8 m_imported = false;
+		Bool8 m_output = false;
+	};
+
+	class BufferResource
+	{
+	public:
+		CString m_name;
+		BufferPtr m_buff;
+	};
+
+	class PhysicalTexture
+	{
+	public:
+		TextureInitInfo m_init;
+		TexturePtr m_tex;
+		U32 m_lastPass = NULL_HANDLE;
+		Bool8 m_output = false;
+	};
+
+	class Dependency
+	{
+	public:
+		U32 m_pass;
+		U32 m_resource;
+		U32 m_usage;
+		Bool8 m_texture;
+		Bool8 m_write;
+	};
+
+	class Barrier
+	{
+	public:
+		U32 m_resource;
+		U32 m_prevUsage;
+		U32 m_nextUsage;
+		Bool8 m_texture;
+	};
+
+	GrManager* m_gr = nullptr;
+	HeapAllocator<U8> m_alloc;
+
+	DynamicArray<Pass> m_passes;
+	U32 m_passCount = 0;
+	DynamicArray<TextureResource> m_textures;
+	U32 m_textureCount = 0;
+	DynamicArray<BufferResource> m_buffers;
+	U32 m_bufferCount = 0;
+	DynamicArray<Dependency> m_deps;
+	U32 m_depCount = 0;
+
+	DynamicArray<PhysicalTexture> m_physicalTextures;
+	DynamicArray<Barrier> m_barriers;
+	U32 m_barrierCount = 0;
+	U32 m_levelCount = 0;
+	Bool8 m_compiled = false;
+
+	void newDependency(
+		U32 pass, U32 resource, Bool texture, U32 usage, Bool write);
+
+	/// Grow an array if it's full.
+	template<typename T>
+	void reserve(DynamicArray<T>& arr, U32 count);
+
+	void cullPasses();
+	void computeDependencyLevels();
+	ANKI_USE_RESULT Error createPhysicalTextures();
+	void computeBarriers();
+
+	/// The state of a texture is shared with the textures it aliases.
+	U32 getTextureStateIndex(U32 tex) const
+	{
+		const TextureResource& t = m_textures[tex];
+		return (t.m_imported) ? (m_physicalTextures.getSize() + tex)
+							  : t.m_physical;
+	}
+
+	static Bool compatible(const TextureInitInfo& a, const TextureInitInfo& b);
+};
+/// @}
+
+} // end namespace anki
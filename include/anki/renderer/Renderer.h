@@ -7,13 +7,14 @@
 
 #include <anki/renderer/Common.h>
 #include <anki/renderer/Drawer.h>
+#include <anki/renderer/RenderGraph.h>
 #include <anki/Math.h>
 #include <anki/Gr.h>
 #include <anki/scene/Forward.h>
 #include <anki/resource/Forward.h>
 #include <anki/resource/ShaderResource.h>
 #include <anki/core/Timestamp.h>
-#include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHive.h>
 #include <anki/collision/Forward.h>
 
 namespace anki
@@ -42,7 +43,7 @@ public:
 	class Ms
 	{
 	public:
-		Array<CommandBufferPtr, ThreadPool::MAX_THREADS> m_commandBuffers;
+		Array<CommandBufferPtr, ThreadHive::MAX_THREADS> m_commandBuffers;
 	} m_ms;
 	/// @}
 
@@ -60,24 +61,43 @@ public:
 	class Sm
 	{
 	public:
-		DynamicArrayAuto<FramebufferPtr> m_spotFramebuffers;
-		DynamicArrayAuto<Array<FramebufferPtr, 6>> m_omniFramebuffers;
-
-		/// [casterIdx][threadIdx]
-		DynamicArrayAuto<CommandBufferPtr> m_spotCommandBuffers;
-		/// [casterIdx][threadIdx][faceIdx]
-		DynamicArrayAuto<CommandBufferPtr> m_omniCommandBuffers;
-
-		DynamicArrayAuto<SceneNode*> m_spots;
-		DynamicArrayAuto<SceneNode*> m_omnis;
+		/// A range of the casters of a shadowmap face. Every job records one
+		/// second level command buffer.
+		class Job
+		{
+		public:
+			const FrustumComponent* m_frc = nullptr;
+			VisibleNode* m_begin = nullptr;
+			VisibleNode* m_end = nullptr;
+			FramebufferPtr m_fb;
+			CommandBufferPtr m_cmdb;
+		};
+
+		/// A shadowmap face that will be rendered. If the static casters
+		/// changed they are rendered to the static layer first. The static
+		/// layer is then copied to the shadowmap and the dynamic casters are
+		/// rendered on top.
+		class Face
+		{
+		public:
+			FramebufferPtr m_staticFb; ///< Empty if the static layer is valid.
+			FramebufferPtr m_fb;
+			TexturePtr m_staticTex;
+			TexturePtr m_tex;
+			TextureSurfaceInfo m_surf;
+			U32 m_firstStaticJob = 0;
+			U32 m_staticJobCount = 0;
+			U32 m_firstJob = 0;
+			U32 m_jobCount = 0;
+		};
+
+		DynamicArrayAuto<Face> m_faces;
+		DynamicArrayAuto<Job> m_jobs;
+		Atomic<U32> m_nextJob = {0};
 
 		Sm(const StackAllocator<U8>& alloc)
-			: m_spotFramebuffers(alloc)
-			, m_omniFramebuffers(alloc)
-			, m_spotCommandBuffers(alloc)
-			, m_omniCommandBuffers(alloc)
-			, m_spots(alloc)
-			, m_omnis(alloc)
+			: m_faces(alloc)
+			, m_jobs(alloc)
 		{
 		}
 	} m_sm;
@@ -88,7 +108,7 @@ public:
 	class Fs
 	{
 	public:
-		Array<CommandBufferPtr, ThreadPool::MAX_THREADS> m_commandBuffers;
+		Array<CommandBufferPtr, ThreadHive::MAX_THREADS> m_commandBuffers;
 	} m_fs;
 	/// @}
 
@@ -214,7 +234,7 @@ public:
 	}
 
 	/// Init the renderer.
-	ANKI_USE_RESULT Error init(ThreadPool* threadpool,
+	ANKI_USE_RESULT Error init(ThreadHive* threadHive,
 		ResourceManager* resources,
 		GrManager* gr,
 		HeapAllocator<U8> alloc,
@@ -322,6 +342,14 @@ anki_internal:
 	void createDrawQuadPipeline(
 		ShaderPtr frag, const ColorStateInfo& colorState, PipelinePtr& ppline);
 
+	/// Create the description of a framebuffer attachment texture.
+	TextureInitInfo createRenderTargetInitInfo(U32 w,
+		U32 h,
+		const PixelFormat& format,
+		U32 samples,
+		SamplingFilter filter,
+		U mipsCount) const;
+
 	/// Create a framebuffer attachment texture
 	void createRenderTarget(U32 w,
 		U32 h,
@@ -355,9 +383,29 @@ anki_internal:
 		return *m_resources;
 	}
 
-	ThreadPool& getThreadPool()
+	ThreadHive& getThreadHive()
+	{
+		return *m_threadHive;
+	}
+
+	/// The G buffer. The render graph creates it.
+	TexturePtr getMsRenderTarget(U idx) const
+	{
+		return m_graph.getTexture(m_graphHandles.m_msRts[idx]);
+	}
+
+	/// The output of the PPS. The render graph creates it.
+	TexturePtr getPpsRenderTarget() const
 	{
-		return *m_threadpool;
+		return m_graph.getTexture(m_graphHandles.m_ppsRt);
+	}
+
+	/// The PPS output may share a texture that samples differently. Sample it
+	/// with that.
+	/// @return The sampler or an empty pointer.
+	SamplerPtr getPpsRenderTargetSampler() const
+	{
+		return m_graph.getSampler(m_graphHandles.m_ppsRt);
 	}
 
 	const TransientMemoryToken& getCommonUniformsTransientMemoryToken() const
@@ -383,7 +431,7 @@ anki_internal:
 	}
 
 private:
-	ThreadPool* m_threadpool;
+	ThreadHive* m_threadHive;
 	ResourceManager* m_resources;
 	GrManager* m_gr;
 	Timestamp* m_globTimestamp;
@@ -434,9 +482,58 @@ private:
 	U64 m_prevAsyncTasksCompleted = 0;
 	Bool m_resourcesDirty = true;
 
+	/// The handles of the render graph resources.
+	class GraphHandles
+	{
+	public:
+		/// The 3 color attachments and the depth of the G buffer.
+		Array<U32, 4> m_msRts;
+		U32 m_isRt;
+		U32 m_fsRt;
+		U32 m_ssaoRt;
+		Array<U32, 2> m_bloomRts;
+		U32 m_smSpotRt;
+		U32 m_smOmniRt;
+		U32 m_ppsRt;
+		U32 m_tmBuff;
+	};
+
+	RenderGraph m_graph;
+	GraphHandles m_graphHandles;
+
 	ANKI_USE_RESULT Error initInternal(const ConfigSet& initializer);
 
+	/// Declare the passes and compile the graph. It runs before the stages
+	/// are initialized since they need the textures of the graph.
+	ANKI_USE_RESULT Error initRenderGraph(const ConfigSet& initializer);
+
+	/// Give the graph the resources that the stages own.
+	void importRenderGraphResources();
+
 	ANKI_USE_RESULT Error buildCommandBuffers(RenderingContext& ctx);
+
+	/// @name Render graph callbacks
+	/// @{
+	static Error runSm(void* userData, RenderingContext& ctx);
+	static Error runMs(void* userData, RenderingContext& ctx);
+	static Error runIs(void* userData, RenderingContext& ctx);
+	static Error runMsMipmaps(void* userData, RenderingContext& ctx);
+	static Error runFs(void* userData, RenderingContext& ctx);
+	static Error runSsao(void* userData, RenderingContext& ctx);
+	static Error runUpsample(void* userData, RenderingContext& ctx);
+	static Error runDownscale(void* userData, RenderingContext& ctx);
+	static Error runTm(void* userData, RenderingContext& ctx);
+	static Error runBloom(void* userData, RenderingContext& ctx);
+	static Error runPps(void* userData, RenderingContext& ctx);
+	static Error runDbg(void* userData, RenderingContext& ctx);
+
+	static Error buildSm(
+		void* userData, RenderingContext& ctx, U slice, U sliceCount);
+	static Error buildMs(
+		void* userData, RenderingContext& ctx, U slice, U sliceCount);
+	static Error buildFs(
+		void* userData, RenderingContext& ctx, U slice, U sliceCount);
+	/// @}
 };
 /// @}
 
@@ -8,6 +8,7 @@
 #include <anki/renderer/RenderingPass.h>
 #include <anki/Gr.h>
 #include <anki/resource/TextureResource.h>
+#include <anki/core/Timestamp.h>
 #include <anki/util/Array.h>
 
 namespace anki
@@ -15,6 +16,8 @@ namespace anki
 
 // Forward
 class SceneNode;
+class FrustumComponent;
+class VisibleNode;
 
 /// @addtogroup renderer
 /// @{
@@ -30,6 +33,13 @@ anki_internal:
 	{
 	}
 
+	/// The number of casters that a job renders.
+	static const U JOB_CASTER_COUNT = 64;
+
+	/// A caster that moved in that many frames is a dynamic caster. The rest
+	/// are static and they are cached.
+	static const U DYNAMIC_CASTER_FRAMES = 30;
+
 	~Sm()
 	{
 		m_spots.destroy(getAllocator());
@@ -40,6 +50,8 @@ anki_internal:
 
 	void prepareBuildCommandBuffers(RenderingContext& ctx);
 
+	/// Build the second level command buffers. The threads pick the jobs
+	/// dynamically so the slice is not used.
 	ANKI_USE_RESULT Error buildCommandBuffers(
 		RenderingContext& ctx, U threadId, U threadCount) const;
 
@@ -64,24 +76,47 @@ private:
 	TexturePtr m_spotTexArray;
 	TexturePtr m_omniTexArray;
 
+	/// The static casters of every shadowmap. Same layout as the shadowmaps.
+	TexturePtr m_spotStaticTexArray;
+	TexturePtr m_omniStaticTexArray;
+
 	class ShadowmapBase
 	{
 	public:
 		U32 m_layerId;
 		SceneNode* m_light = nullptr;
-		U32 m_timestamp = 0; ///< Timestamp of last render or light change
+		Timestamp m_timestamp = 0; ///< Timestamp of last render or light change
+
+		/// Timestamp of the last render of the static layer. Zero if the
+		/// static layer is not valid.
+		Timestamp m_staticTimestamp = 0;
+		U64 m_staticCastersHash = 0;
+		U64 m_dynamicCastersHash = 0;
 	};
 
 	class ShadowmapSpot : public ShadowmapBase
 	{
 	public:
 		FramebufferPtr m_fb;
+		FramebufferPtr m_staticFb;
 	};
 
 	class ShadowmapOmni : public ShadowmapBase
 	{
 	public:
 		Array<FramebufferPtr, 6> m_fb;
+		Array<FramebufferPtr, 6> m_staticFb;
+	};
+
+	/// The casters of a face split to static and dynamic.
+	class FaceCasters
+	{
+	public:
+		const FrustumComponent* m_frc = nullptr;
+		VisibleNode* m_static = nullptr;
+		VisibleNode* m_dynamic = nullptr;
+		U32 m_staticCount = 0;
+		U32 m_dynamicCount = 0;
 	};
 
 	DynamicArray<ShadowmapSpot> m_spots;
@@ -100,20 +135,18 @@ private:
 	template<typename TShadowmap, typename TContainer>
 	void bestCandidate(SceneNode& light, TContainer& arr, TShadowmap*& out);
 
-	/// Check if a shadow pass can be skipped.
-	Bool skip(SceneNode& light, ShadowmapBase& sm);
-
-	ANKI_USE_RESULT Error doSpotLight(SceneNode& light,
-		CommandBufferPtr& cmdBuff,
-		FramebufferPtr& fb,
-		U threadId,
-		U threadCount) const;
-
-	ANKI_USE_RESULT Error doOmniLight(SceneNode& light,
-		CommandBufferPtr cmdbs[],
-		Array<FramebufferPtr, 6>& fbs,
-		U threadId,
-		U threadCount) const;
+	/// Split the casters of the light to static and dynamic and decide what
+	/// needs to be rendered.
+	/// @param[out] faces The casters of every frustum of the light.
+	/// @param[out] renderStatic The static layer needs to be rendered.
+	/// @return False if the shadowmap is up to date.
+	Bool prepareLight(RenderingContext& ctx,
+		SceneNode& light,
+		ShadowmapBase& sm,
+		WeakArray<FaceCasters> faces,
+		Bool& renderStatic);
+
+	ANKI_USE_RESULT Error doJob(RenderingContext& ctx, U jobIdx) const;
 };
 
 /// @}
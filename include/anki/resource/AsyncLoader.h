@@ -8,6 +8,7 @@
 #include <anki/resource/Common.h>
 #include <anki/util/Thread.h>
 #include <anki/util/List.h>
+#include <anki/util/Ptr.h>
 
 namespace anki
 {
@@ -18,28 +19,133 @@ class AsyncLoader;
 /// @addtogroup resource
 /// @{
 
+/// The pipeline stages of the AsyncLoader.
+enum class AsyncLoaderStage : U8
+{
+	IO, ///< File reading and decompression. Runs on a pool of threads.
+	UPLOAD, ///< GPU uploads. Runs on one thread with a per-frame budget.
+
+	COUNT
+};
+
+/// A handle to a submitted task. It gets signaled when the task is done,
+/// failed or was canceled. It can be used to cancel the task and as a
+/// dependency of other tasks.
+class AsyncLoaderFence
+{
+	friend class IntrusivePtr<AsyncLoaderFence>;
+	friend IntrusivePtr<AsyncLoaderFence>::Deleter;
+	friend class AsyncLoader;
+
+public:
+	AsyncLoaderFence(HeapAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	/// Check if the task is done. It doesn't block.
+	Bool isSignaled() const
+	{
+		return m_signaled.load(AtomicMemoryOrder::ACQUIRE) != 0;
+	}
+
+	/// Ask the task to be canceled. If the task hasn't started it will never
+	/// run. If it runs it will not be resubmitted.
+	void cancel()
+	{
+		m_canceled.store(1);
+	}
+
+	Bool isCanceled() const
+	{
+		return m_canceled.load() != 0;
+	}
+
+	/// Check if the task failed. Valid after the fence is signaled.
+	Bool isFailed() const
+	{
+		return m_failed.load() != 0;
+	}
+
+private:
+	HeapAllocator<U8> m_alloc;
+	Atomic<I32> m_refcount = {0};
+	Atomic<U32> m_signaled = {0};
+	Atomic<U32> m_canceled = {0};
+	Atomic<U32> m_failed = {0};
+
+	Atomic<I32>& getRefcount()
+	{
+		return m_refcount;
+	}
+
+	HeapAllocator<U8> getAllocator() const
+	{
+		return m_alloc;
+	}
+};
+
+using AsyncLoaderFencePtr = IntrusivePtr<AsyncLoaderFence>;
+
 class AsyncLoaderTaskContext
 {
 public:
 	/// Pause the async loader.
 	Bool m_pause = false;
 
-	/// Resubmit the same task at the end of the queue.
+	/// Resubmit the same task at the end of the queue of its stage. The task
+	/// may change its stage before asking for a resubmit. If a task of the
+	/// UPLOAD stage asks for a resubmit the upload stage will wait for the
+	/// next frame.
 	Bool m_resubmitTask = false;
+
+	/// The bytes the task is allowed to upload. Valid in the UPLOAD stage.
+	PtrSize m_uploadBudget = 0;
+
+	/// The bytes the task uploaded. Set by UPLOAD stage tasks.
+	PtrSize m_uploadedBytes = 0;
 };
 
 /// Interface for tasks for the AsyncLoader.
 class AsyncLoaderTask : public IntrusiveListEnabled<AsyncLoaderTask>
 {
+	friend class AsyncLoader;
+
 public:
+	static const U MAX_DEPENDENCIES = 4;
+
+	/// Tasks with higher priority run first. The negative distance from the
+	/// camera is a good candidate.
+	F32 m_priority = 0.0;
+
+	/// The stage the task will run on.
+	AsyncLoaderStage m_stage = AsyncLoaderStage::IO;
+
 	virtual ~AsyncLoaderTask()
 	{
 	}
 
 	virtual ANKI_USE_RESULT Error operator()(AsyncLoaderTaskContext& ctx) = 0;
+
+	/// Don't run the task before the fence is signaled. Call it before
+	/// submitting the task.
+	void addDependency(AsyncLoaderFencePtr fence)
+	{
+		ANKI_ASSERT(fence);
+		m_dependencies[m_dependencyCount++] = fence;
+	}
+
+private:
+	Array<AsyncLoaderFencePtr, MAX_DEPENDENCIES> m_dependencies;
+	U8 m_dependencyCount = 0;
+	AsyncLoaderFencePtr m_fence;
+
+	Bool dependenciesSignaled() const;
 };
 
-/// Asynchronous resource loader.
+/// Asynchronous resource loader. It has two stages. The IO stage runs on a
+/// pool of threads and the UPLOAD stage on a single thread that consumes a
+/// budget of bytes per frame.
 class AsyncLoader
 {
 public:
@@ -47,10 +153,22 @@ public:
 
 	~AsyncLoader();
 
-	void init(const HeapAllocator<U8>& alloc);
+	/// Initialize.
+	/// @param alloc The allocator.
+	/// @param ioThreadCount The threads of the IO stage. If it's more than one
+	///        the tasks of the IO stage may run out of order.
+	/// @param uploadBudgetPerFrame The bytes the UPLOAD stage may upload
+	///        between two newFrame calls.
+	void init(const HeapAllocator<U8>& alloc,
+		U ioThreadCount = 1,
+		PtrSize uploadBudgetPerFrame = MAX_PTR_SIZE);
 
 	/// Submit a task.
-	void submitTask(AsyncLoaderTask* task);
+	/// @param task The task.
+	/// @param[out] fence Optional fence that will be signaled when the task is
+	///             done.
+	void submitTask(
+		AsyncLoaderTask* task, AsyncLoaderFencePtr* fence = nullptr);
 
 	/// Create a new asynchronous loading task.
 	template<typename TTask, typename... TArgs>
@@ -67,14 +185,22 @@ public:
 		submitTask(newTask<TTask>(std::forward<TArgs>(args)...));
 	}
 
-	/// Pause the loader. This method will block the main thread for the current
-	/// async task to finish. The rest of the tasks in the queue will not be
-	/// executed until resume is called.
+	/// Pause the loader. This method will block the main thread for the
+	/// current async tasks to finish. The rest of the tasks in the queues will
+	/// not be executed until resume is called.
 	void pause();
 
 	/// Resume the async loading.
 	void resume();
 
+	/// Block the UPLOAD stage. It waits only for the running upload task (if
+	/// any). Call it before GrManager::swapBuffers.
+	void syncUploads();
+
+	/// Refill the upload budget and unblock the UPLOAD stage. Call it after
+	/// GrManager::swapBuffers.
+	void newFrame();
+
 	HeapAllocator<U8> getAllocator() const
 	{
 		return m_alloc;
@@ -87,23 +213,55 @@ public:
 	}
 
 private:
+	class ThreadInfo
+	{
+	public:
+		AsyncLoader* m_loader = nullptr;
+		AsyncLoaderStage m_stage = AsyncLoaderStage::IO;
+	};
+
 	HeapAllocator<U8> m_alloc;
-	Thread m_thread;
-	Barrier m_barrier = {2};
+	DynamicArray<Thread*> m_ioThreads;
+	Thread m_uploadThread;
+	Array<ThreadInfo, U(AsyncLoaderStage::COUNT)> m_threadInfos;
 
 	Mutex m_mtx;
 	ConditionVariable m_condVar;
-	IntrusiveList<AsyncLoaderTask> m_taskQueue;
+
+	/// Tasks ready to run sorted by priority.
+	Array<IntrusiveList<AsyncLoaderTask>, U(AsyncLoaderStage::COUNT)>
+		m_taskQueues;
+
+	/// Tasks that wait for their dependencies.
+	IntrusiveList<AsyncLoaderTask> m_waitingTasks;
+
+	Array<U32, U(AsyncLoaderStage::COUNT)> m_runningTaskCounts = {{0, 0}};
+	PtrSize m_uploadBudgetPerFrame = 0;
+	PtrSize m_uploadBudget = 0;
 	Bool8 m_quit = false;
 	Bool8 m_paused = false;
-	Bool8 m_sync = false;
+	Bool8 m_uploadsBlocked = false;
 
 	Atomic<U64> m_completedTaskCount = {0};
 
 	/// Thread callback
 	static ANKI_USE_RESULT Error threadCallback(Thread::Info& info);
 
-	Error threadWorker();
+	/// The loop of the threads. A failed task doesn't stop it.
+	void threadWorker(AsyncLoaderStage stage);
+
+	/// Check if a thread of a stage can pick a task. Call it locked.
+	Bool canRunTask(AsyncLoaderStage stage) const;
+
+	/// Push a task to the queue of its stage. Call it locked.
+	void pushReadyTask(AsyncLoaderTask* task);
+
+	/// Move the tasks whose dependencies are done to the ready queues. Call it
+	/// locked.
+	void releaseWaitingTasks();
+
+	/// Signal the fence and delete the task. Call it locked.
+	void retireTask(AsyncLoaderTask* task);
 
 	void stop();
 };
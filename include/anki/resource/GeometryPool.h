@@ -0,0 +1,82 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/Gr.h>
+#include <anki/gr/common/GpuBlockAllocator.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// Two big buffers that hold the vertices and the indices of many meshes.
+/// The meshes that live in them can be drawn with the same ResourceGroup and
+/// go out in a single multi-draw indirect drawcall.
+///
+/// The buffers are sub-allocated in blocks. Meshes that don't fit in a block
+/// should use their own buffers.
+class GeometryPool : public NonCopyable
+{
+public:
+	GeometryPool()
+	{
+	}
+
+	/// @param gr The graphics manager.
+	/// @param alloc The allocator.
+	/// @param vertexMemorySize The size of the vertex buffer.
+	/// @param indexMemorySize The size of the index buffer.
+	void init(GrManager* gr,
+		GenericMemoryPoolAllocator<U8> alloc,
+		PtrSize vertexMemorySize,
+		PtrSize indexMemorySize);
+
+	Bool isCreated() const
+	{
+		return m_vertBuff.isCreated();
+	}
+
+	/// Allocate space for vertices.
+	/// @param size The size of the vertices.
+	/// @param stride The size of a vertex.
+	/// @param[out] baseVertex The first vertex in the vertex buffer.
+	/// @return False if there is no space.
+	Bool allocateVertices(PtrSize size, U32 stride, U32& baseVertex);
+
+	void freeVertices(U32 baseVertex, U32 stride);
+
+	/// Allocate space for indices.
+	/// @param size The size of the indices.
+	/// @param indexSize The size of an index.
+	/// @param[out] firstIndex The first index in the index buffer.
+	/// @return False if there is no space.
+	Bool allocateIndices(PtrSize size, U32 indexSize, U32& firstIndex);
+
+	void freeIndices(U32 firstIndex, U32 indexSize);
+
+	BufferPtr getVertexBuffer() const
+	{
+		return m_vertBuff;
+	}
+
+	BufferPtr getIndexBuffer() const
+	{
+		return m_indexBuff;
+	}
+
+private:
+	BufferPtr m_vertBuff;
+	BufferPtr m_indexBuff;
+	GpuBlockAllocator m_vertAlloc;
+	GpuBlockAllocator m_indexAlloc;
+	PtrSize m_blockSize = 0;
+};
+/// @}
+
+} // end namespace anki
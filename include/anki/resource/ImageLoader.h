@@ -54,6 +54,20 @@ public:
 		U32 m_height;
 		U32 m_mipLevel;
 		DynamicArray<U8> m_data;
+
+		/// Points to the mapped file. If it's set m_data is empty.
+		const U8* m_mappedData = nullptr;
+		PtrSize m_mappedDataSize = 0;
+
+		const U8* getData() const
+		{
+			return (m_mappedData) ? m_mappedData : &m_data[0];
+		}
+
+		PtrSize getDataSize() const
+		{
+			return (m_mappedData) ? m_mappedDataSize : m_data.getSize();
+		}
 	};
 
 	ImageLoader(GenericMemoryPoolAllocator<U8> alloc)
@@ -125,6 +139,9 @@ private:
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Atomic<I32> m_refcount = {0};
 
+	/// Hold the file if the surfaces point to its mapped memory.
+	ResourceFilePtr m_file;
+
 	/// [mip][depth or face or layer]. Loader doesn't support cube arrays ATM
 	/// so face and layer won't be used at the same time.
 	DynamicArray<Surface> m_surfaces;
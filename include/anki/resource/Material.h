@@ -12,6 +12,8 @@
 #include <anki/Math.h>
 #include <anki/util/Visitor.h>
 #include <anki/util/NonCopyable.h>
+#include <anki/util/Thread.h>
+#include <anki/util/Atomic.h>
 
 namespace anki
 {
@@ -162,7 +164,7 @@ private:
 		U idx, const MaterialLoaderInputVariable& in, Material& mtl);
 };
 
-/// Material variant.
+/// Material variant. It's created on demand the first time it's requested.
 class MaterialVariant : public NonCopyable
 {
 	friend class Material;
@@ -175,7 +177,8 @@ public:
 
 	ShaderPtr getShader(ShaderType type) const
 	{
-		return m_shaders[U(type)]->getGrShader();
+		ANKI_ASSERT(m_shaders[U(type)].isCreated());
+		return m_shaders[U(type)];
 	}
 
 	U getDefaultBlockSize() const
@@ -191,14 +194,24 @@ public:
 	}
 
 private:
+	enum class State : U8
+	{
+		NOT_CREATED,
+		QUEUED, ///< A background task will create it.
+		CREATED
+	};
+
 	/// All shaders except compute and geometry.
-	Array<ShaderResourcePtr, 5> m_shaders;
+	Array<ShaderPtr, 5> m_shaders;
 	U32 m_shaderBlockSize = 0;
 	DynamicArray<ShaderVariableBlockInfo> m_blockInfo;
 	DynamicArray<Bool8> m_varActive;
 
-	ANKI_USE_RESULT Error init(
-		const RenderingKey& key, Material& mtl, MaterialLoader& loader);
+	Atomic<U8> m_state = {U8(State::NOT_CREATED)};
+	Atomic<U8> m_used = {0}; ///< It was requested for drawing.
+	Bool8 m_inUsageLog = false; ///< It was in the usage log at load time.
+
+	void init(const RenderingKey& key, Material& mtl, MaterialLoader& loader);
 
 	void destroy(ResourceAllocator<U8> alloc)
 	{
@@ -267,10 +280,16 @@ private:
 /// (3): The \<const\> will mark a variable as constant and it cannot be changed
 ///      at all. Default is 0
 /// (4): Optimization. Set to 1 if the var will be used in shadow passes as well
+///
+/// The variants are created the first time they are requested. The variants
+/// that were requested are written to a usage log in the cache directory when
+/// the material is destroyed. The next time the material is loaded the variants
+/// of the log are created in the background.
 class Material : public ResourceObject
 {
 	friend class MaterialVariable;
 	friend class MaterialVariant;
+	friend class MaterialVariantCreateTask;
 
 public:
 	Material(ResourceManager* manager);
@@ -312,8 +331,17 @@ public:
 		return m_instanced;
 	}
 
+	/// Get a variant. If it's not created it's created now.
+	/// @note It's thread-safe.
 	const MaterialVariant& getVariant(const RenderingKey& key) const;
 
+	/// Get the key of a variant that can be used without waiting for it to be
+	/// created. If the variant of the key is not created it's created in the
+	/// background and the key of a similar variant that is created is
+	/// returned. If there is no such variant the key is returned as is.
+	/// @note It's thread-safe.
+	RenderingKey getVariantKeyAsync(const RenderingKey& key) const;
+
 	const DynamicArray<MaterialVariable*>& getVariables() const
 	{
 		return m_vars;
@@ -321,6 +349,11 @@ public:
 
 	void fillResourceGroupInitInfo(ResourceGroupInitInfo& rcinit);
 
+	/// Get the resources of the meshes that live in the GeometryPool. The
+	/// model patches of the material share them.
+	/// @note It's thread-safe.
+	ResourceGroupPtr getGeometryPoolResourceGroup();
+
 	static U getInstanceGroupIdx(U instanceCount);
 
 private:
@@ -333,7 +366,7 @@ private:
 	U8 m_lodCount = 1;
 	Bool8 m_instanced = false;
 
-	DynamicArray<MaterialVariant> m_variants;
+	mutable DynamicArray<MaterialVariant> m_variants;
 
 	/// This is a matrix of variants. It holds indices to m_variants. If the
 	/// idx is MAX_U16 then the variant is not present
@@ -342,15 +375,34 @@ private:
 
 	DynamicArray<MaterialVariable*> m_vars;
 
+	/// It's kept to create the variants on demand.
+	MaterialLoader* m_loader = nullptr;
+	Mutex m_loaderMtx;
+
+	String m_usageLogFilename;
+
+	ResourceGroupPtr m_geometryPoolGrResources;
+	Mutex m_geometryPoolGrResourcesMtx;
+
 	/// Populate the m_varNames.
 	ANKI_USE_RESULT Error createVars(const MaterialLoader& loader);
 
-	/// Create the variants.
-	ANKI_USE_RESULT Error createVariants(MaterialLoader& loader);
+	/// Init the variant matrix.
+	void initVariantMatrix();
+
+	U getVariantIndex(const RenderingKey& key) const;
+
+	/// Create a variant if it's not created.
+	void createVariant(const RenderingKey& key);
+
+	/// Submit a task to create a variant in the background.
+	void queueVariant(const RenderingKey& key);
+
+	/// Queue the variants of the usage log of a previous run.
+	ANKI_USE_RESULT Error loadUsageLog();
 
-	/// Create a unique shader source in chache. If already exists do nothing
-	ANKI_USE_RESULT Error createProgramSourceToCache(
-		const String& source, ShaderType type, StringAuto& out);
+	/// Write the variants that were used.
+	ANKI_USE_RESULT Error saveUsageLog() const;
 };
 
 //==============================================================================
@@ -15,6 +15,7 @@ namespace anki
 
 // Forward
 class XmlElement;
+class ResourceManager;
 
 /// Material loader variable. It's the information on whatever is inside
 /// \<input\>
@@ -113,6 +114,10 @@ public:
 		return m_sourceBaked[shaderType];
 	}
 
+	/// Resolve the #include of the sources. Call it after parsing so mutate
+	/// doesn't need to access the filesystem.
+	ANKI_USE_RESULT Error resolveIncludes(ResourceManager& manager);
+
 	/// After parsing the program mutate the sources for a specific use case.
 	void mutate(const RenderingKey& key);
 
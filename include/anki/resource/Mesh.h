@@ -83,6 +83,24 @@ public:
 		return m_indicesBuff;
 	}
 
+	/// The first vertex of the mesh in the vertex buffer.
+	U32 getBaseVertex() const
+	{
+		return m_baseVertex;
+	}
+
+	/// The first index of the mesh in the index buffer.
+	U32 getFirstIndex() const
+	{
+		return m_firstIndex;
+	}
+
+	/// True if the buffers are the buffers of the GeometryPool.
+	Bool isInGeometryPool() const
+	{
+		return m_pooled;
+	}
+
 	/// Helper function for correct loading
 	Bool isCompatible(const Mesh& other) const;
 
@@ -104,9 +122,13 @@ protected:
 	Obb m_obb;
 	U8 m_texChannelsCount;
 	Bool8 m_weights;
+	Bool8 m_pooled = false;
 
 	BufferPtr m_vertBuff;
 	BufferPtr m_indicesBuff;
+	U32 m_vertexSize = 0;
+	U32 m_baseVertex = 0;
+	U32 m_firstIndex = 0;
 };
 /// @}
 
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/resource/Common.h>
+#include <anki/resource/ResourceFilesystem.h>
 #include <anki/Math.h>
 #include <anki/util/Enum.h>
 
@@ -125,13 +126,13 @@ public:
 	const U8* getVertexData() const
 	{
 		ANKI_ASSERT(isLoaded());
-		return &m_verts[0];
+		return m_vertData;
 	}
 
 	PtrSize getVertexDataSize() const
 	{
 		ANKI_ASSERT(isLoaded());
-		return m_verts.getSizeInBytes();
+		return m_vertDataSize;
 	}
 
 	PtrSize getVertexSize() const
@@ -143,13 +144,13 @@ public:
 	const U8* getIndexData() const
 	{
 		ANKI_ASSERT(isLoaded());
-		return &m_indices[0];
+		return m_indexData;
 	}
 
 	PtrSize getIndexDataSize() const
 	{
 		ANKI_ASSERT(isLoaded());
-		return m_indices.getSizeInBytes();
+		return m_indexDataSize;
 	}
 
 	Bool hasBoneInfo() const
@@ -167,16 +168,30 @@ private:
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Header m_header;
 
+	/// If the file is mapped the vertex and index data point to it.
+	ResourceFilePtr m_file;
+
 	MDynamicArray<U8> m_verts;
 	MDynamicArray<U8> m_indices;
 	MDynamicArray<SubMesh> m_subMeshes;
+	const U8* m_vertData = nullptr;
+	PtrSize m_vertDataSize = 0;
+	const U8* m_indexData = nullptr;
+	PtrSize m_indexDataSize = 0;
 	U8 m_vertSize = 0;
 
 	Bool isLoaded() const
 	{
-		return m_verts.getSize() > 0;
+		return m_vertData != nullptr;
 	}
 
+	/// Read from the mapped file or copy to @a storage if the file is not
+	/// mapped or the data are not aligned to @a alignment.
+	ANKI_USE_RESULT Error readData(PtrSize size,
+		U alignment,
+		MDynamicArray<U8>& storage,
+		const U8*& data);
+
 	static ANKI_USE_RESULT Error checkFormat(
 		const Format& fmt, const CString& attrib, Bool cannotBeEmpty);
 };
@@ -76,13 +76,26 @@ public:
 		PipelinePtr& ppline,
 		Array<U32, ANKI_GL_MAX_SUB_DRAWCALLS>& indicesCountArray,
 		Array<PtrSize, ANKI_GL_MAX_SUB_DRAWCALLS>& indicesOffsetArray,
+		U32& baseVertex,
 		U32& drawcallCount) const;
 
+	/// True if all the meshes are in the GeometryPool. The patches of the
+	/// same material can be drawn with the same pipeline and resource group.
+	Bool isInGeometryPool() const
+	{
+		return m_inGeometryPool;
+	}
+
+	/// Get the geometry part of the drawcall of a mesh.
+	void getDrawcall(
+		const RenderingKey& key, DrawElementsIndirectInfo& draw) const;
+
 private:
 	Model* m_model ANKI_DBG_NULLIFY_PTR;
 
 	Array<MeshResourcePtr, MAX_LODS> m_meshes; ///< One for each LOD
 	U8 m_meshCount = 0;
+	Bool8 m_inGeometryPool = false;
 	MaterialResourcePtr m_mtl;
 
 	mutable Array4d<PipelinePtr,
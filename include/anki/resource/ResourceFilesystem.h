@@ -16,6 +16,7 @@ namespace anki
 
 // Forward
 class ConfigSet;
+class ResourceArchive;
 
 /// @addtogroup resource
 /// @{
@@ -59,6 +60,24 @@ public:
 	/// Get the size of the file.
 	virtual PtrSize getSize() const = 0;
 
+	/// Check if the file is mapped to memory. If it is readMapped can be used
+	/// to avoid copies.
+	virtual Bool isMapped() const
+	{
+		return false;
+	}
+
+	/// Get a read-only pointer to the next @a size bytes of a mapped file and
+	/// advance the position indicator like read does. The memory is valid for
+	/// as long as the file is alive.
+	virtual ANKI_USE_RESULT Error readMapped(PtrSize size, const U8*& data)
+	{
+		(void)size;
+		data = nullptr;
+		ANKI_ASSERT(0 && "The file is not mapped");
+		return ErrorCode::FUNCTION_FAILED;
+	}
+
 	Atomic<I32>& getRefcount()
 	{
 		return m_refcount;
@@ -95,30 +114,41 @@ public:
 	ANKI_USE_RESULT Error openFile(
 		const ResourceFilename& filename, ResourceFilePtr& file);
 
+	/// Same as openFile but it's not an error if the file doesn't exist.
+	/// @param[out] file It's not created if the file doesn't exist.
+	ANKI_USE_RESULT Error openFileOptional(
+		const ResourceFilename& filename, ResourceFilePtr& file);
+
+	/// Open a file and, if it exists, the file whose name is the filename
+	/// plus a suffix. Both are searched in one pass over the paths.
+	/// @param[out] sibling It's not created if the file doesn't exist.
+	ANKI_USE_RESULT Error openFileAndSibling(const ResourceFilename& filename,
+		const CString& siblingSuffix,
+		ResourceFilePtr& file,
+		ResourceFilePtr& sibling);
+
 private:
 	class Path : public NonCopyable
 	{
 	public:
 		StringList m_files; ///< Files inside the directory.
 		String m_path; ///< A directory or an archive.
-		Bool8 m_isArchive = false;
+		ResourceArchive* m_archive = nullptr; ///< Set if it's an archive.
 		Bool8 m_isCache = false;
 
 		Path() = default;
 
 		Path(Path&& b)
-			: m_files(std::move(b.m_files))
-			, m_path(std::move(b.m_path))
-			, m_isArchive(std::move(b.m_isArchive))
-			, m_isCache(std::move(b.m_isCache))
 		{
+			*this = std::move(b);
 		}
 
 		Path& operator=(Path&& b)
 		{
 			m_files = std::move(b.m_files);
 			m_path = std::move(b.m_path);
-			m_isArchive = std::move(b.m_isArchive);
+			m_archive = b.m_archive;
+			b.m_archive = nullptr;
 			m_isCache = std::move(b.m_isCache);
 			return *this;
 		}
@@ -132,6 +162,15 @@ private:
 	ANKI_USE_RESULT Error addNewPath(const CString& path);
 
 	void addCachePath(const CString& path);
+
+	/// Search the paths for some files. A file that is not found is not
+	/// created.
+	ANKI_USE_RESULT Error openFilesOptional(
+		const CString* filenames, ResourceFilePtr* files, U count);
+
+	/// Open a file of a directory. The file is mapped if possible.
+	ANKI_USE_RESULT Error openLooseFile(
+		const CString& filename, ResourceFile*& rfile);
 };
 /// @}
 
@@ -6,9 +6,11 @@
 #pragma once
 
 #include <anki/resource/Common.h>
-#include <anki/util/List.h>
+#include <anki/util/FlatHashMap.h>
 #include <anki/util/Functions.h>
 #include <anki/util/String.h>
+#include <anki/util/Thread.h>
+#include <anki/util/Hash.h>
 
 namespace anki
 {
@@ -19,19 +21,52 @@ class GrManager;
 class PhysicsWorld;
 class ResourceManager;
 class AsyncLoader;
+class GeometryPool;
 class ResourceManagerModel;
 class Renderer;
 
 /// @addtogroup resource
 /// @{
 
-/// Manage resources of a certain type
+/// Manage resources of a certain type. The registry is split in a few
+/// stripes, each with its own lock, so that threads that load different
+/// resources rarely contend.
 template<typename Type>
 class TypeResourceManager
 {
 protected:
 	/// @privatesection
-	using Container = List<Type*>;
+	static const U STRIPE_COUNT = 16;
+
+	class Hasher
+	{
+	public:
+		U64 operator()(const U64& b) const
+		{
+			return b;
+		}
+	};
+
+	class Compare
+	{
+	public:
+		Bool operator()(const U64& a, const U64& b) const
+		{
+			return a == b;
+		}
+	};
+
+	/// The key is the hash of the filename.
+	using Container = FlatHashMap<U64, Type*, Hasher, Compare>;
+
+	/// A part of the registry.
+	class Stripe
+	{
+	public:
+		Mutex m_mtx;
+		ConditionVariable m_condVar; ///< Signaled when a load ends.
+		Container m_ptrs;
+	};
 
 	TypeResourceManager()
 	{
@@ -39,28 +74,48 @@ protected:
 
 	~TypeResourceManager()
 	{
-		ANKI_ASSERT(m_ptrs.isEmpty() && "Forgot to delete some resources");
-		m_ptrs.destroy(m_alloc);
+		for(Stripe& stripe : m_stripes)
+		{
+			ANKI_ASSERT(
+				stripe.m_ptrs.isEmpty() && "Forgot to delete some resources");
+			stripe.m_ptrs.destroy(m_alloc);
+		}
 	}
 
-	Type* findLoadedResource(const CString& filename)
+	Stripe& getStripe(U64 hash)
 	{
-		auto it = find(filename);
-		return (it != m_ptrs.end()) ? *it : nullptr;
+		return m_stripes[(hash >> 32) % STRIPE_COUNT];
 	}
 
-	void registerResource(Type* ptr)
+	/// Add the resource to the registry. It replaces the resource with the
+	/// same key. Call it with the stripe locked.
+	void registerResource(Stripe& stripe, U64 hash, Type* ptr)
 	{
-		ANKI_ASSERT(ptr->getRefcount().load() == 0);
-		ANKI_ASSERT(find(ptr->getFilename()) == m_ptrs.getEnd());
-		m_ptrs.pushBack(m_alloc, ptr);
+		auto it = stripe.m_ptrs.find(hash);
+		if(it != stripe.m_ptrs.getEnd())
+		{
+			*it = ptr;
+		}
+		else
+		{
+			stripe.m_ptrs.pushBack(m_alloc, hash, ptr);
+		}
 	}
 
+	/// Remove the resource from the registry. It does nothing if another
+	/// resource took its place. Thread-safe.
 	void unregisterResource(Type* ptr)
 	{
-		auto it = find(ptr->getFilename());
-		ANKI_ASSERT(it != m_ptrs.end());
-		m_ptrs.erase(m_alloc, it);
+		CString filename = ptr->getFilename();
+		const U64 hash = computeHash(&filename[0], filename.getLength());
+		Stripe& stripe = getStripe(hash);
+
+		LockGuard<Mutex> lock(stripe.m_mtx);
+		auto it = stripe.m_ptrs.find(hash);
+		if(it != stripe.m_ptrs.getEnd() && *it == ptr)
+		{
+			stripe.m_ptrs.erase(m_alloc, it);
+		}
 	}
 
 	void init(ResourceAllocator<U8> alloc)
@@ -70,22 +125,7 @@ protected:
 
 private:
 	ResourceAllocator<U8> m_alloc;
-	Container m_ptrs;
-
-	typename Container::Iterator find(const CString& filename)
-	{
-		typename Container::Iterator it;
-
-		for(it = m_ptrs.getBegin(); it != m_ptrs.getEnd(); ++it)
-		{
-			if((*it)->getFilename() == filename)
-			{
-				break;
-			}
-		}
-
-		return it;
-	}
+	Array<Stripe, STRIPE_COUNT> m_stripes;
 };
 
 class ResourceManagerInitInfo
@@ -124,7 +164,8 @@ public:
 
 	ANKI_USE_RESULT Error create(ResourceManagerInitInfo& init);
 
-	/// Load a resource.
+	/// Load a resource. It's thread-safe. If another thread loads the same
+	/// resource it will wait for that load to finish.
 	template<typename T>
 	ANKI_USE_RESULT Error loadResource(
 		const CString& filename, ResourcePtr<T>& out);
@@ -150,10 +191,8 @@ anki_internal:
 		return m_alloc;
 	}
 
-	TempResourceAllocator<U8>& getTempAllocator()
-	{
-		return m_tmpAlloc;
-	}
+	/// Get the temp allocator of the calling thread.
+	TempResourceAllocator<U8>& getTempAllocator();
 
 	GrManager& getGrManager()
 	{
@@ -189,18 +228,6 @@ anki_internal:
 		return m_shadersPrependedSource;
 	}
 
-	template<typename T>
-	T* findLoadedResource(const CString& filename)
-	{
-		return TypeResourceManager<T>::findLoadedResource(filename);
-	}
-
-	template<typename T>
-	void registerResource(T* ptr)
-	{
-		TypeResourceManager<T>::registerResource(ptr);
-	}
-
 	template<typename T>
 	void unregisterResource(T* ptr)
 	{
@@ -212,10 +239,18 @@ anki_internal:
 		return *m_asyncLoader;
 	}
 
+	/// The pool that the meshes share. It's not created if there is no
+	/// GrManager.
+	GeometryPool& getGeometryPool()
+	{
+		ANKI_ASSERT(m_geometryPool);
+		return *m_geometryPool;
+	}
+
 	/// Get the number of times loadResource() was called.
 	U64 getLoadingRequestCount() const
 	{
-		return m_loadRequestCount;
+		return m_loadRequestCount.load();
 	}
 
 	/// Get the total number of completed async tasks.
@@ -226,14 +261,22 @@ private:
 	PhysicsWorld* m_physics = nullptr;
 	ResourceFilesystem* m_fs = nullptr;
 	ResourceAllocator<U8> m_alloc;
-	TempResourceAllocator<U8> m_tmpAlloc;
+	AllocAlignedCallback m_allocCallback = nullptr;
+	void* m_allocCallbackData = nullptr;
 	String m_cacheDir;
 	U32 m_maxTextureSize;
 	U32 m_textureAnisotropy;
 	String m_shadersPrependedSource;
 	AsyncLoader* m_asyncLoader = nullptr; ///< Async loading thread
-	U64 m_uuid = 0;
-	U64 m_loadRequestCount = 0;
+	GeometryPool* m_geometryPool = nullptr;
+	Atomic<U64> m_uuid = {0};
+	Atomic<U64> m_loadRequestCount = {0};
+
+	/// Unique among all the managers. Used to find the temp allocators of the
+	/// threads.
+	U64 m_id = 0;
+	Mutex m_tmpAllocsMtx;
+	DynamicArray<TempResourceAllocator<U8>*> m_tmpAllocs;
 };
 /// @}
 
@@ -14,45 +14,82 @@ Error ResourceManager::loadResource(
 	const CString& filename, ResourcePtr<T>& out)
 {
 	ANKI_ASSERT(!out.isCreated() && "Already loaded");
+	using LoadState = typename T::LoadState;
 
-	Error err = ErrorCode::NONE;
-	++m_loadRequestCount;
+	m_loadRequestCount.fetchAdd(1);
 
-	T* other = findLoadedResource<T>(filename);
+	const U64 hash = computeHash(&filename[0], filename.getLength());
+	auto& stripe = TypeResourceManager<T>::getStripe(hash);
+	T* ptr = nullptr;
+	Bool load = true;
 
-	if(other)
 	{
-		// Found
-		out.reset(other);
+		LockGuard<Mutex> lock(stripe.m_mtx);
+
+		auto it = stripe.m_ptrs.find(hash);
+		Bool collision = false;
+		if(it != stripe.m_ptrs.getEnd())
+		{
+			T* other = *it;
+			collision = other->getFilename() != filename;
+
+			// Take a reference if it's not being deleted or it hasn't failed
+			I32 refcount = other->getRefcount().load();
+			while(!collision && other->m_loadState != LoadState::FAILED
+				&& refcount > 0)
+			{
+				if(other->getRefcount().compareExchange(
+					   refcount, refcount + 1))
+				{
+					ptr = other;
+					load = false;
+					break;
+				}
+			}
+		}
+
+		if(load)
+		{
+			// Allocate ptr and register it so that other threads wait for it.
+			// Take the reference before registering it or other threads will
+			// think it's being deleted
+			ptr = m_alloc.newInstance<T>(this);
+			ANKI_ASSERT(ptr->getRefcount().load() == 0);
+			ptr->setFilename(filename);
+			ptr->setUuid(m_uuid.fetchAdd(1) + 1);
+			out.reset(ptr);
+
+			// On collision keep the other, this one will not be shared
+			if(!collision)
+			{
+				TypeResourceManager<T>::registerResource(stripe, hash, ptr);
+			}
+		}
+		else
+		{
+			// Swap the reference of the compareExchange with the one of out
+			out.reset(ptr);
+			ptr->getRefcount().fetchSub(1);
+		}
 	}
-	else
-	{
-		// Allocate ptr
-		T* ptr = m_alloc.newInstance<T>(this);
-		ANKI_ASSERT(ptr->getRefcount().load() == 0);
 
+	Error err = ErrorCode::NONE;
+
+	if(load)
+	{
 		// Populate the ptr. Use a block to cleanup temp_pool allocations
-		auto& pool = m_tmpAlloc.getMemoryPool();
+		auto& pool = getTempAllocator().getMemoryPool();
 
 		{
 			U allocsCountBefore = pool.getAllocationsCount();
 			(void)allocsCountBefore;
 
 			err = ptr->load(filename);
-			if(err)
-			{
-				ANKI_LOGE("Failed to load resource: %s", &filename[0]);
-				m_alloc.deleteInstance(ptr);
-				return err;
-			}
 
 			ANKI_ASSERT(pool.getAllocationsCount() == allocsCountBefore
 				&& "Forgot to deallocate");
 		}
 
-		ptr->setFilename(filename);
-		ptr->setUuid(++m_uuid);
-
 		// Reset the memory pool if no-one is using it.
 		// NOTE: Check because resources load other resources
 		if(pool.getAllocationsCount() == 0)
@@ -60,9 +97,31 @@ Error ResourceManager::loadResource(
 			pool.reset();
 		}
 
-		// Register resource
-		registerResource(ptr);
-		out.reset(ptr);
+		// Wake up the threads that wait for it
+		LockGuard<Mutex> lock(stripe.m_mtx);
+		ptr->m_loadState = (err) ? LoadState::FAILED : LoadState::LOADED;
+		stripe.m_condVar.notifyAll();
+	}
+	else
+	{
+		// Another thread loads it
+		LockGuard<Mutex> lock(stripe.m_mtx);
+		while(ptr->m_loadState == LoadState::LOADING)
+		{
+			stripe.m_condVar.wait(stripe.m_mtx);
+		}
+
+		if(ptr->m_loadState == LoadState::FAILED)
+		{
+			err = ErrorCode::FUNCTION_FAILED;
+		}
+	}
+
+	if(err)
+	{
+		// Release outside the lock because the deleter takes it
+		ANKI_LOGE("Failed to load resource: %s", &filename[0]);
+		out.reset(nullptr);
 	}
 
 	return err;
@@ -72,7 +131,7 @@ Error ResourceManager::loadResource(
 template<typename T, typename... TArgs>
 Error ResourceManager::loadResourceToCache(ResourcePtr<T>& out, TArgs&&... args)
 {
-	StringAuto fname(m_tmpAlloc);
+	StringAuto fname(getTempAllocator());
 
 	Error err = T::createToCache(args..., *this, fname);
 
@@ -80,14 +80,25 @@ anki_internal:
 	ANKI_USE_RESULT Error openFileReadAllText(
 		const ResourceFilename& filename, StringAuto& file);
 
+	/// Open an XML file and parse it. If the file has a baked document (see
+	/// XmlDocument::BAKED_FILENAME_SUFFIX) it loads that instead.
 	ANKI_USE_RESULT Error openFileParseXml(
 		const ResourceFilename& filename, XmlDocument& xml);
 
 private:
+	/// The state of the loading. Guarded by the lock of the registry.
+	enum class LoadState : U8
+	{
+		LOADING,
+		LOADED,
+		FAILED
+	};
+
 	ResourceManager* m_manager;
 	Atomic<I32> m_refcount;
 	String m_fname; ///< Unique resource name.
 	U64 m_uuid = 0;
+	LoadState m_loadState = LoadState::LOADING;
 };
 /// @}
 
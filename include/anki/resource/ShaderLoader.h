@@ -38,6 +38,10 @@ public:
 	/// @param filename The file to parse
 	ANKI_USE_RESULT Error parseFile(const ResourceFilename& filename);
 
+	/// Parse a PrePreprocessor formated GLSL source that lives in memory.
+	/// @param source The source to parse.
+	ANKI_USE_RESULT Error parseSource(const CString& source);
+
 	const String& getShaderSource() const
 	{
 		ANKI_ASSERT(!m_shaderSource.isEmpty());
@@ -74,6 +78,10 @@ protected:
 	ANKI_USE_RESULT Error parseFileIncludes(
 		ResourceFilename filename, U32 depth);
 
+	/// Resolve the #include of some lines and update the output.
+	ANKI_USE_RESULT Error parseSourceIncludes(
+		const StringList& lines, U32 depth);
+
 	void printSourceLines() const; ///< For debugging
 };
 
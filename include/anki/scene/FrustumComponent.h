@@ -16,6 +16,7 @@ namespace anki
 
 // Forward
 class VisibilityTestResults;
+class VisibilityCache;
 
 /// @addtogroup scene
 /// @{
@@ -55,6 +56,8 @@ public:
 	/// Pass the frustum here so we can avoid the virtuals
 	FrustumComponent(SceneNode* node, Frustum* frustum);
 
+	~FrustumComponent();
+
 	Frustum& getFrustum()
 	{
 		return *m_frustum;
@@ -118,6 +121,10 @@ public:
 		return m_visible != nullptr;
 	}
 
+	/// Get the results of the previous visibility tests that can be reused
+	/// by the next ones. It's created on first use.
+	VisibilityCache& getVisibilityCache();
+
 	const VisibilityStats& getLastVisibilityStats() const
 	{
 		return m_stats;
@@ -147,6 +154,13 @@ public:
 		return m_frustum->insideFrustum(cs);
 	}
 
+	/// Test many volumes at once. See batchTestPlanes.
+	U32 insideFrustum(
+		const BatchVolumes& volumes, U32 count, U32* visibleIndices) const
+	{
+		return m_frustum->insideFrustum(volumes, count, visibleIndices);
+	}
+
 	/// @name SceneComponent overrides
 	/// @{
 	ANKI_USE_RESULT Error update(SceneNode&, F32, F32, Bool& updated) override;
@@ -202,6 +216,9 @@ private:
 	VisibilityTestResults* m_visible = nullptr;
 	VisibilityStats m_stats;
 
+	/// It outlives the frame.
+	VisibilityCache* m_visCache = nullptr;
+
 	BitMask<U16> m_flags;
 
 	void computeProjectionParams();
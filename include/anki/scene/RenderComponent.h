@@ -9,6 +9,7 @@
 #include <anki/scene/SceneComponent.h>
 #include <anki/resource/Material.h>
 #include <anki/resource/Model.h>
+#include <anki/util/Thread.h>
 
 namespace anki
 {
@@ -115,6 +116,12 @@ public:
 	U32 m_subMeshIndicesCount;
 	CommandBufferPtr m_cmdb; ///< A command buffer to append to.
 	TransientMemoryInfo* m_dynamicBufferInfo ANKI_DBG_NULLIFY_PTR;
+
+	/// If it's not zero the renderable is batched with others. It should bind
+	/// its pipeline and resources and draw the m_indirectDrawcalls instead of
+	/// its own drawcall.
+	U32 m_indirectDrawcallCount = 0;
+	TransientMemoryToken m_indirectDrawcalls;
 };
 
 /// RenderComponent interface. Implemented by renderable scene nodes
@@ -125,14 +132,24 @@ public:
 
 	using Variables = DynamicArray<RenderComponentVariable*>;
 
-	RenderComponent(SceneNode* node, const Material* mtl, U64 hash = 0);
+	/// @param node The node.
+	/// @param mtl The material.
+	/// @param hash See canMergeDrawcalls.
+	/// @param batchable See canBatchDrawcalls.
+	RenderComponent(SceneNode* node,
+		const Material* mtl,
+		U64 hash = 0,
+		Bool batchable = false);
 
 	~RenderComponent();
 
 	ANKI_USE_RESULT Error init();
 
+	/// @note It assumes that the variables will change and it invalidates the
+	///       uniform cache.
 	Variables::Iterator getVariablesBegin()
 	{
+		++m_varsVersion;
 		return m_vars.begin();
 	}
 
@@ -164,6 +181,16 @@ public:
 		return *m_mtl;
 	}
 
+	/// Get the geometry part of the drawcall. It's used to batch the
+	/// renderable with others.
+	virtual void getDrawcall(
+		const RenderingKey& key, DrawElementsIndirectInfo& draw) const
+	{
+		(void)key;
+		(void)draw;
+		ANKI_ASSERT(0 && "Not batchable");
+	}
+
 	/// Information for movables. It's actualy an array of transformations.
 	virtual void getRenderWorldTransform(
 		Bool& hasWorldTransforms, Transform& trf) const
@@ -178,10 +205,11 @@ public:
 		return mtl.getShadowEnabled();
 	}
 
-	/// Iterate variables using a lambda
+	/// Iterate variables using a lambda. It invalidates the uniform cache.
 	template<typename Func>
 	ANKI_USE_RESULT Error iterateVariables(Func func)
 	{
+		++m_varsVersion;
 		Error err = ErrorCode::NONE;
 		Variables::Iterator it = m_vars.getBegin();
 		for(; it != m_vars.getEnd() && !err; it++)
@@ -192,18 +220,60 @@ public:
 		return err;
 	}
 
+	/// Get the hash that canMergeDrawcalls compares.
+	U64 getMergeHash() const
+	{
+		return m_hash;
+	}
+
 	Bool canMergeDrawcalls(const RenderComponent& b) const
 	{
 		return m_mtl->isInstanced() && m_hash != 0 && m_hash == b.m_hash;
 	}
 
+	/// Renderables that can be batched draw different geometry with the same
+	/// pipeline and resources. The renderer may draw them with a single
+	/// indirect drawcall.
+	Bool canBatchDrawcalls(const RenderComponent& b) const
+	{
+		return m_mtl->isInstanced() && m_batchable && b.m_batchable
+			&& m_mtl == b.m_mtl;
+	}
+
+	/// Write the values of the variables that are not builtins to the uniform
+	/// block of a variant. The values are kept in a persistent cache and they
+	/// are written again only when the variant or the variables change.
+	/// @note It's thread-safe.
+	void writeUniformBlock(const MaterialVariant& variant,
+		Pass pass,
+		WeakArray<U8> uniforms) const;
+
 private:
+	/// A copy of a uniform block with the non builtin variables written.
+	class UniformCache
+	{
+	public:
+		DynamicArray<U8> m_uniforms;
+		const MaterialVariant* m_variant = nullptr;
+		U32 m_varsVersion = 0;
+		SpinLock m_lock;
+	};
+
 	Variables m_vars;
 	const Material* m_mtl;
 
+	/// It changes every time the variables may have changed.
+	U32 m_varsVersion = 1;
+
+	/// One cache per pass since a renderable is drawn with different variants
+	/// per pass every frame.
+	mutable Array<UniformCache, U(Pass::COUNT)> m_uniformCaches;
+
 	/// If 2 components have the same hash the renderer may potentially try
 	/// to merge them.
 	U64 m_hash = 0;
+
+	Bool8 m_batchable = false;
 };
 /// @}
 
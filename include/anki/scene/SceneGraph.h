@@ -12,7 +12,7 @@
 #include <anki/Math.h>
 #include <anki/util/Singleton.h>
 #include <anki/util/HighRezTimer.h>
-#include <anki/util/HashMap.h>
+#include <anki/util/FlatHashMap.h>
 #include <anki/core/App.h>
 #include <anki/event/EventManager.h>
 
@@ -43,8 +43,7 @@ public:
 
 	ANKI_USE_RESULT Error init(AllocAlignedCallback allocCb,
 		void* allocCbData,
-		ThreadPool* threadpool,
-		ThreadHive* thraedHive,
+		ThreadHive* threadHive,
 		ResourceManager* resources,
 		Input* input,
 		const Timestamp* globalTimestamp,
@@ -100,11 +99,6 @@ public:
 		return m_events;
 	}
 
-	ThreadPool& _getThreadPool()
-	{
-		return *m_threadpool;
-	}
-
 	ThreadHive& getThreadHive()
 	{
 		return *m_threadHive;
@@ -187,6 +181,17 @@ anki_internal:
 		return m_maxReflectionProxyDistance;
 	}
 
+	/// The size of the depth buffer of the occlusion tests.
+	U32 getOcclusionRasterizerWidth() const
+	{
+		return m_occlusionRasterizerWidth;
+	}
+
+	U32 getOcclusionRasterizerHeight() const
+	{
+		return m_occlusionRasterizerHeight;
+	}
+
 	U64 getNewSceneNodeUuid()
 	{
 		return m_nodesUuid++;
@@ -202,7 +207,6 @@ private:
 	Timestamp m_timestamp = 0; ///< Cached timestamp
 
 	// Sub-systems
-	ThreadPool* m_threadpool = nullptr;
 	ThreadHive* m_threadHive = nullptr;
 	ResourceManager* m_resources = nullptr;
 	GrManager* m_gr = nullptr;
@@ -211,10 +215,11 @@ private:
 
 	SceneAllocator<U8> m_alloc;
 	SceneFrameAllocator<U8> m_frameAlloc;
+	U32 m_allocLockContentionCount = 0; ///< Used for the trace counters.
 
 	IntrusiveList<SceneNode> m_nodes;
 	U32 m_nodesCount = 0;
-	HashMap<CString, SceneNode*, CStringHasher, CStringCompare> m_nodesDict;
+	FlatHashMap<CString, SceneNode*, CStringHasher, CStringCompare> m_nodesDict;
 
 	SceneNode* m_mainCam = nullptr;
 	Timestamp m_activeCameraChangeTimestamp = getGlobalTimestamp();
@@ -227,6 +232,9 @@ private:
 
 	F32 m_maxReflectionProxyDistance = 0.0;
 
+	U32 m_occlusionRasterizerWidth = 0;
+	U32 m_occlusionRasterizerHeight = 0;
+
 	U64 m_nodesUuid = 0;
 
 	SceneComponentLists m_componentLists;
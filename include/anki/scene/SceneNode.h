@@ -99,7 +99,7 @@ public:
 	/// Return the last frame the node was updated. It checks all components
 	U32 getLastUpdateFrame() const;
 
-	/// Inform if a sector has visited this node.
+	/// Inform if a visibility test has visited this node.
 	/// @return The previous value.
 	Bool fetchSetSectorVisited(U testId, Bool visited)
 	{
@@ -219,7 +219,7 @@ private:
 	BitMask<Flag> m_flags;
 
 	/// A mask of bits for each test. If bit set then the node was visited by
-	/// a sector.
+	/// that visibility test.
 	BitSet<256> m_sectorVisitedBitset = {false};
 	SpinLock m_sectorVisitedBitsetLock;
 
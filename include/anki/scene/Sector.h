@@ -7,7 +7,9 @@
 
 #include <anki/scene/SceneNode.h>
 #include <anki/scene/SceneComponent.h>
+#include <anki/scene/SpatialCullingTable.h>
 #include <anki/Collision.h>
+#include <anki/collision/DynamicAabbTree.h>
 
 namespace anki
 {
@@ -160,6 +162,18 @@ private:
 		SpatialComponent* sp);
 };
 
+/// The structure that SectorGroup uses to find the spatials a frustum sees.
+enum class SpatialIndex : U8
+{
+	/// The spatials are binned to sectors and the visible sectors are found
+	/// through the portals.
+	SECTORS_AND_PORTALS,
+
+	/// The spatials are kept in a DynamicAabbTree. Good for open scenes
+	/// without portals and for scenes with a lot of moving spatials.
+	DYNAMIC_TREE
+};
+
 /// The context for visibility tests from a single FrustumComponent (not for
 /// all of them).
 class SectorGroupVisibilityTestsContext
@@ -167,24 +181,21 @@ class SectorGroupVisibilityTestsContext
 	friend class SectorGroup;
 
 public:
-	U getVisibleSceneNodeCount() const
+	/// Get the number of spatials found in the visible sectors.
+	U getVisibleSpatialCount() const
 	{
-		return m_visibleNodes.getSize();
+		return m_visibleSpatials.getSize();
 	}
 
-	template<typename Func>
-	void iterateVisibleSceneNodes(PtrSize begin, PtrSize end, Func func)
+	/// Get the SpatialCullingTable indices of the spatials found in the
+	/// visible sectors or the spatial tree. They are unique and sorted.
+	const U32* getVisibleSpatials() const
 	{
-		ANKI_ASSERT(begin <= end);
-
-		for(U i = begin; i < end; ++i)
-		{
-			func(*m_visibleNodes[i]);
-		}
+		return m_visibleSpatials.getBegin();
 	}
 
 private:
-	WeakArray<SceneNode*> m_visibleNodes;
+	WeakArray<U32> m_visibleSpatials;
 };
 
 /// Sector group. This is supposed to represent the whole scene
@@ -195,11 +206,36 @@ public:
 	SectorGroup(SceneGraph* scene)
 		: m_scene(scene)
 	{
+		m_tree.init(SPATIAL_TREE_MARGIN);
 	}
 
 	/// Destructor
 	~SectorGroup();
 
+	SpatialCullingTable& getCullingTable()
+	{
+		return m_cullingTable;
+	}
+
+	const SpatialCullingTable& getCullingTable() const
+	{
+		return m_cullingTable;
+	}
+
+	SpatialIndex getSpatialIndex() const
+	{
+		return m_spatialIndex;
+	}
+
+	/// Change the structure that holds the spatials. All spatials are moved
+	/// to the new one. Don't call it while visibility tests are running.
+	void setSpatialIndex(SpatialIndex index);
+
+	const DynamicAabbTree& getSpatialTree() const
+	{
+		return m_tree;
+	}
+
 	void spatialUpdated(SpatialComponent* sp);
 	void spatialDeleted(SpatialComponent* sp);
 
@@ -208,14 +244,67 @@ public:
 
 	void prepareForVisibilityTests();
 
-	void findVisibleNodes(const FrustumComponent& frc,
-		U threadId,
+	/// @name Visibility caching
+	/// What changed since the previous prepareForVisibilityTests.
+	/// @{
+
+	/// Get the number of prepareForVisibilityTests calls.
+	U64 getVisibilityTestsRun() const
+	{
+		return m_visibilityTestsRun;
+	}
+
+	/// Check if the sectors, the portals or the spatial index changed.
+	Bool getLayoutChanged() const
+	{
+		return m_layoutChangeRun == m_visibilityTestsRun;
+	}
+
+	/// Get the SpatialCullingTable entries that were updated, created or
+	/// released.
+	const WeakArray<U32>& getDirtySpatials() const
+	{
+		return m_dirtySpatials;
+	}
+
+	/// Check if a SpatialCullingTable entry is in getDirtySpatials.
+	Bool isSpatialDirty(U32 idx) const
+	{
+		ANKI_ASSERT(idx < m_cullingTable.getEntryCount());
+		return (m_dirtySpatialBits[idx / 64] & (U64(1) << (idx % 64))) != 0;
+	}
+	/// @}
+
+	/// Gather the spatials of the sectors a frustum can see.
+	void findVisibleSpatials(const FrustumComponent& frc,
 		const SoftwareRasterizer* r,
 		SectorGroupVisibilityTestsContext& ctx) const;
 
 private:
 	SceneGraph* m_scene; ///< Keep it here to access various allocators
 
+	SpatialCullingTable m_cullingTable;
+
+	/// The distance that the Aabbs of the tree leaves are fattened by.
+	static constexpr F32 SPATIAL_TREE_MARGIN = 0.2;
+
+	SpatialIndex m_spatialIndex = SpatialIndex::SECTORS_AND_PORTALS;
+	DynamicAabbTree m_tree;
+
+	U64 m_visibilityTestsRun = 0;
+	U64 m_layoutChangeRun = 0;
+
+	/// Entries released since the last prepareForVisibilityTests. Protected
+	/// by m_mtx.
+	DynamicArray<U32> m_releasedSpatials;
+	U32 m_releasedSpatialCount = 0;
+
+	/// @name Per frame dirty spatials
+	/// @{
+	WeakArray<U32> m_dirtySpatials;
+	U64* m_dirtySpatialBits = nullptr;
+	/// @}
+
 	List<SpatialComponent*> m_spatialsDeferredBinning;
 	SpinLock m_mtx;
 
@@ -237,6 +326,19 @@ private:
 		U& spatialsCount) const;
 
 	void binSpatial(SpatialComponent* sp);
+
+	/// Remove a spatial from all the sectors it's in.
+	void unbinSpatial(SpatialComponent* sp);
+
+	/// Gather the dirty spatials of this run.
+	void gatherDirtySpatials();
+
+	/// Insert or move a spatial in the tree.
+	void updateSpatialInTree(SpatialComponent* sp);
+
+	void findVisibleSpatialsInTree(const FrustumComponent& frc,
+		const SoftwareRasterizer* r,
+		SectorGroupVisibilityTestsContext& ctx) const;
 };
 /// @}
 
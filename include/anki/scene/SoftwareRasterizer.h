@@ -8,6 +8,7 @@
 #include <anki/scene/Common.h>
 #include <anki/Math.h>
 #include <anki/collision/Plane.h>
+#include <anki/util/Atomic.h>
 
 namespace anki
 {
@@ -15,18 +16,33 @@ namespace anki
 /// @addtogroup scene
 /// @{
 
-/// Software rasterizer for visibility tests.
+/// Software rasterizer for occlusion tests.
+///
+/// The depth buffer is split in tiles of TILE_SIZE pixels. The triangles are
+/// first binned to the tiles they touch, by a number of binners that can run
+/// in parallel. Then every tile is rasterized by a single thread in blocks of
+/// BLOCK_WIDTH x BLOCK_HEIGHT pixels so no atomics are needed. The last thread
+/// that finishes builds a min/max depth pyramid that the visibility tests
+/// use.
+///
+/// A single threaded usage is:
+/// @code
+/// r.prepare(mv, p, width, height);
+/// r.draw(verts, vertCount, stride);
+/// r.visibilityTest(cs, aabb);
+/// @endcode
 class SoftwareRasterizer
 {
 public:
+	static const U BLOCK_WIDTH = 8;
+	static const U BLOCK_HEIGHT = 4;
+	static const U TILE_SIZE = 32;
+
 	SoftwareRasterizer()
 	{
 	}
 
-	~SoftwareRasterizer()
-	{
-		m_zbuffer.destroy(m_alloc);
-	}
+	~SoftwareRasterizer();
 
 	/// Initialize.
 	void init(const GenericMemoryPoolAllocator<U8>& alloc)
@@ -34,10 +50,35 @@ public:
 		m_alloc = alloc;
 	}
 
-	/// Prepare for rendering. Call it before every draw.
-	void prepare(const Mat4& mv, const Mat4& p, U width, U height);
+	/// Prepare for rendering. Call it before binning.
+	/// @param mv The model view matrix.
+	/// @param p The projection matrix.
+	/// @param width The width of the depth buffer. It will be rounded up to
+	///        BLOCK_WIDTH.
+	/// @param height The height of the depth buffer. It will be rounded up to
+	///        BLOCK_HEIGHT.
+	/// @param binnerCount The number of threads that will call binTriangles.
+	void prepare(const Mat4& mv,
+		const Mat4& p,
+		U width,
+		U height,
+		U binnerCount = 1);
+
+	/// Transform, clip and bin some triangles. Different binners can run
+	/// concurrently.
+	/// @param binnerIdx The binner. Less than the binnerCount of prepare.
+	/// @param[in] verts Pointer to the first vertex to draw.
+	/// @param vertCount The number of verts to draw.
+	/// @param stride The stride (in bytes) of the next vertex.
+	void binTriangles(U binnerIdx, const F32* verts, U vertCount, U stride);
+
+	/// Rasterize a portion of the tiles. Call it after all binners are done.
+	/// Different tasks can run concurrently. Every task should be called once.
+	/// @param taskIdx The task.
+	/// @param taskCount The number of tasks.
+	void rasterizeTiles(U taskIdx, U taskCount);
 
-	/// Render some verts.
+	/// Bin and rasterize some verts in one go. Single threaded.
 	/// @param[in] verts Pointer to the first vertex to draw.
 	/// @param vertCount The number of verts to draw.
 	/// @param stride The stride (in bytes) of the next vertex.
@@ -49,33 +90,103 @@ public:
 	/// @return Return true if it's visible and false otherwise.
 	Bool visibilityTest(const CollisionShape& cs, const Aabb& aabb) const;
 
-public: // XXX
+	U32 getWidth() const
+	{
+		return m_width;
+	}
+
+	U32 getHeight() const
+	{
+		return m_height;
+	}
+
+	/// Get the depth of a pixel in [0, 1].
+	F32 getDepth(U x, U y) const
+	{
+		ANKI_ASSERT(x < m_width && y < m_height);
+		return m_zbuffer[y * m_width + x];
+	}
+
+private:
+	class Triangle;
+	class Binner;
+
+	static const U MAX_HIZ_LEVELS = 16;
+
+	/// The max number of pyramid cells a visibility test will visit.
+	static const U MAX_HIZ_TEST_CELLS = 32;
+
+	/// The number of pyramid levels that are built per tile. The cells of
+	/// these levels don't span multiple tiles.
+	static const U TILE_HIZ_LEVELS = 3;
+
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Mat4 m_mv; ///< ModelView.
 	Mat4 m_p; ///< Projection.
 	Mat4 m_mvp;
 	Array<Plane, 6> m_planesL; ///< In view space.
 	Array<Plane, 6> m_planesW; ///< In world space.
-	U32 m_width;
-	U32 m_height;
-	DynamicArray<Atomic<U32>> m_zbuffer;
+	U32 m_width = 0;
+	U32 m_height = 0;
+	U32 m_tileCountX = 0;
+	U32 m_tileCountY = 0;
+
+	DynamicArray<F32> m_zbuffer;
+
+	DynamicArray<Binner> m_binners;
+	U32 m_binnerCount = 0;
+
+	/// @name Depth pyramid
+	/// @{
+
+	/// The nearest depth of every cell of every level.
+	DynamicArray<F32> m_hizMin;
+	/// The farthest depth of every cell of every level.
+	DynamicArray<F32> m_hizMax;
+	Array<U32, MAX_HIZ_LEVELS> m_hizOffsets;
+	Array<U32, MAX_HIZ_LEVELS> m_hizWidths;
+	Array<U32, MAX_HIZ_LEVELS> m_hizHeights;
+	U32 m_hizLevelCount = 0;
+	/// @}
 
-	/// @param tri In clip space.
-	void rasterizeTriangle(const Vec4* tri);
+	/// The number of rasterizeTiles that have finished.
+	Atomic<U32> m_rasterizedTaskCount = {0};
 
-	Bool computeBarycetrinc(const Vec2& a,
-		const Vec2& b,
-		const Vec2& c,
-		const Vec2& p,
-		Vec3& uvw) const;
+	void destroyBinners();
+
+	/// Set a triangle that is in clip space.
+	/// @return False if it doesn't cover any pixel.
+	Bool setupTriangle(const Vec4* clip, Triangle& tri) const;
 
 	/// Clip triangle in the near plane.
 	/// @note Triangles in view space.
 	void clipTriangle(
 		const Vec4* inTriangle, Vec4* outTriangles, U& outTriangleCount) const;
 
+	void rasterizeTile(U tileX, U tileY);
+
+	void rasterizeTriangle(
+		const Triangle& tri, U minX, U minY, U maxX, U maxY);
+
+	/// Compute the depth pyramid cell of a level from the level below.
+	void reduceHizCell(U level, U cellX, U cellY);
+
+	/// Compute the pyramid levels whose cells are inside a tile.
+	void buildTileHiz(U tileX, U tileY);
+
+	/// Compute the rest of the pyramid levels.
+	void buildTopHiz();
+
 	Bool visibilityTestInternal(
 		const CollisionShape& cs, const Aabb& aabb) const;
+
+	/// Test a rectangle against a cell and its children.
+	Bool visibilityTestCell(U level,
+		U cellX,
+		U cellY,
+		const Array<U32, 4>& rect,
+		F32 minZ,
+		U& budget) const;
 };
 /// @}
 
@@ -110,6 +110,23 @@ public:
 		return m_flags.get(Flag::VISIBLE_CAMERA);
 	}
 
+	/// Get the index of the spatial in the SpatialCullingTable.
+	U32 getCullingTableIndex() const
+	{
+		return m_cullingTableIdx;
+	}
+
+	/// Get the leaf of the spatial in the DynamicAabbTree of the SectorGroup.
+	U32 getSpatialTreeLeaf() const
+	{
+		return m_spatialTreeLeaf;
+	}
+
+	void setSpatialTreeLeaf(U32 leaf)
+	{
+		m_spatialTreeLeaf = leaf;
+	}
+
 	/// @name SceneComponent overrides
 	/// @{
 	ANKI_USE_RESULT Error update(SceneNode&, F32, F32, Bool& updated) override;
@@ -133,6 +150,8 @@ private:
 	Aabb m_aabb; ///< A faster shape
 	Vec4 m_origin = Vec4(MAX_F32, MAX_F32, MAX_F32, 0.0);
 	List<Sector*> m_sectorInfo;
+	U32 m_cullingTableIdx;
+	U32 m_spatialTreeLeaf = MAX_U32;
 };
 /// @}
 
@@ -0,0 +1,141 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Common.h>
+#include <anki/collision/Plane.h>
+#include <anki/collision/BatchTests.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/Thread.h>
+
+namespace anki
+{
+
+// Forward
+class SpatialComponent;
+
+/// @addtogroup scene
+/// @{
+
+/// A structure of arrays that holds everything the visibility tests need to
+/// know about every SpatialComponent. The tests scan this table and touch a
+/// SceneNode only when one of its spatials passes.
+///
+/// Every entry has a bounding volume in the form of a center, the extents of
+/// a box and a radius. Spheres have zero extents and boxes zero radius. Shapes
+/// that are not boxes or spheres are represented by their Aabb.
+class SpatialCullingTable
+{
+public:
+	SpatialCullingTable()
+	{
+	}
+
+	~SpatialCullingTable()
+	{
+		ANKI_ASSERT(m_entryCount == 0 && "Forgot to call destroy");
+	}
+
+	void destroy(SceneAllocator<U8> alloc);
+
+	/// Allocate an entry for a spatial. Thread-safe against other newEntry
+	/// and deleteEntry calls.
+	/// @return The index of the entry.
+	U32 newEntry(SceneAllocator<U8> alloc, SpatialComponent* sp);
+
+	/// Release an entry. Thread-safe against other newEntry and deleteEntry
+	/// calls.
+	void deleteEntry(SceneAllocator<U8> alloc, U32 idx);
+
+	/// Gather the bounds and the component flags of an entry from its spatial.
+	/// It should be called after the spatial's shape or the components of its
+	/// node change. SceneNode::addComponent marks the spatials for update so
+	/// the latter goes through the same path.
+	void updateEntry(U32 idx);
+
+	/// Set the bounds and the component flags of an entry. updateEntry calls
+	/// it with what it gathered from the spatial.
+	/// @param idx The entry.
+	/// @param cs The collision shape of the spatial.
+	/// @param aabb The Aabb of the cs.
+	/// @param flags A mask of FrustumComponentVisibilityTestFlag.
+	void setEntry(
+		U32 idx, const CollisionShape& cs, const Aabb& aabb, U8 flags);
+
+	/// Get the number of entries, including the released ones.
+	U32 getEntryCount() const
+	{
+		return m_entryCount;
+	}
+
+	SpatialComponent& getSpatial(U32 idx) const
+	{
+		ANKI_ASSERT(idx < m_entryCount && m_spatials[idx]);
+		return *m_spatials[idx];
+	}
+
+	/// Check if the bounding volume of an entry is the exact shape of the
+	/// spatial.
+	Bool isExact(U32 idx) const
+	{
+		ANKI_ASSERT(idx < m_entryCount);
+		return (m_flags[idx] & EXACT_BIT) != 0;
+	}
+
+	/// Test the bounding volume of a single entry against some planes.
+	/// @return False if the volume is behind one of the planes.
+	Bool insidePlanes(U32 idx, const Plane* planes, U planeCount) const;
+
+	/// Test a number of entries against some planes and visibility flags. It
+	/// uses batchTestPlanesIndexed.
+	/// @param[in] indices The entries to test.
+	/// @param count The number of indices.
+	/// @param[in] planes The planes, usually of a frustum in world space.
+	/// @param planeCount The number of planes.
+	/// @param testFlags A mask of FrustumComponentVisibilityTestFlag. Entries
+	///        that don't share any of those bits are culled.
+	/// @param[out] visibleIndices The entries that passed. It can alias
+	///        indices.
+	/// @return The number of visibleIndices.
+	U32 test(const U32* indices,
+		U32 count,
+		const Plane* planes,
+		U planeCount,
+		U8 testFlags,
+		U32* visibleIndices) const;
+
+private:
+	/// Bit in m_flags that is not a FrustumComponentVisibilityTestFlag.
+	static const U8 EXACT_BIT = 1 << 7;
+
+	DynamicArray<F32> m_centerX;
+	DynamicArray<F32> m_centerY;
+	DynamicArray<F32> m_centerZ;
+	DynamicArray<F32> m_extentX;
+	DynamicArray<F32> m_extentY;
+	DynamicArray<F32> m_extentZ;
+	DynamicArray<F32> m_radius;
+
+	/// A mask of FrustumComponentVisibilityTestFlag the entry is interesting
+	/// for plus the EXACT_BIT. Released entries have zero.
+	DynamicArray<U8> m_flags;
+
+	DynamicArray<SpatialComponent*> m_spatials;
+
+	DynamicArray<U32> m_freeEntries;
+	U32 m_freeEntryCount = 0;
+	U32 m_entryCount = 0;
+
+	SpinLock m_mtx;
+
+	void grow(SceneAllocator<U8> alloc);
+
+	/// Get the arrays in the form the batch tests want.
+	BatchVolumes getVolumes() const;
+};
+/// @}
+
+} // end namespace anki
@@ -118,6 +118,12 @@ public:
 		VisibilityGroupType type,
 		VisibleNode& x);
 
+	/// Sort a group using a key per node. The keys are kept for the merging.
+	/// @param[in,out] keys The keys of the nodes. They get sorted as well.
+	void sort(SceneFrameAllocator<U8> alloc,
+		VisibilityGroupType type,
+		U64* keys);
+
 	U32 getCount(VisibilityGroupType type) const
 	{
 		return m_groups[type].m_count;
@@ -133,9 +139,27 @@ public:
 		m_shapeUpdateTimestamp = t;
 	}
 
+	/// Combine the results of other tests. The groups that are sorted in all
+	/// the results are only allocated and mergeSorted should fill them.
 	void combineWith(SceneFrameAllocator<U8> alloc,
 		WeakArray<VisibilityTestResults*>& results);
 
+	/// Check if combineWith left a group to mergeSorted.
+	Bool needsMerge(VisibilityGroupType type) const
+	{
+		return m_groups[type].m_needsMerge;
+	}
+
+	/// Merge a part of a group that is sorted in all the results that
+	/// combineWith got. The parts can be merged concurrently.
+	void mergeSorted(VisibilityGroupType type,
+		const WeakArray<VisibilityTestResults*>& results,
+		U partIdx,
+		U partCount);
+
+	/// The max number of results that can be merged.
+	static const U MAX_MERGE_RESULTS = 32;
+
 	template<typename TFunc>
 	void iterateAll(TFunc f)
 	{
@@ -161,6 +185,11 @@ private:
 	public:
 		Container m_nodes;
 		U32 m_count = 0;
+
+		/// The sort keys of the nodes if the group is sorted.
+		U64* m_keys = nullptr;
+
+		Bool m_needsMerge = false;
 	};
 
 	Array<Group, U(VisibilityGroupType::TYPE_COUNT)> m_groups;
@@ -22,28 +22,51 @@ class ThreadHive;
 /// @addtogroup scene
 /// @{
 
-/// Sort spatial scene nodes on distance
-class DistanceSortFunctor
+/// The results of the visibility tests of a frustum that the tests of the
+/// next frame can reuse if the frustum and the sectors didn't change. It keeps
+/// the SpatialCullingTable entries of all the spatials of the visible nodes so
+/// that the nodes with dirty spatials can be retested.
+class VisibilityCache
 {
 public:
-	Bool operator()(const VisibleNode& a, const VisibleNode& b)
+	/// A visible node.
+	class Node
 	{
-		ANKI_ASSERT(a.m_node && b.m_node);
-		return a.m_frustumDistanceSquared < b.m_frustumDistanceSquared;
-	}
-};
+	public:
+		SceneNode* m_node;
+		F32 m_frustumDistanceSquared;
+		U32 m_firstSpatialIndex; ///< In m_spatialIndices.
+		U32 m_firstEntry; ///< In m_entries.
+		U8 m_spatialCount;
+		U8 m_entryCount;
+		U8 m_groupMask; ///< A bit per VisibilityGroupType.
+	};
 
-/// Sort renderable scene nodes on material
-class MaterialSortFunctor
-{
-public:
-	Bool operator()(const VisibleNode& a, const VisibleNode& b)
-	{
-		ANKI_ASSERT(a.m_node && b.m_node);
+	static_assert(U(VisibilityGroupType::TYPE_COUNT) <= 8, "See m_groupMask");
+
+	DynamicArray<Node> m_nodes;
+	DynamicArray<U8> m_spatialIndices; ///< See VisibleNode::m_spatialIndices.
+	DynamicArray<U32> m_entries;
+	U32 m_nodeCount = 0;
+	U32 m_spatialIndexCount = 0;
+	U32 m_entryCount = 0;
 
-		return a.m_node->getComponent<RenderComponent>().getMaterial()
-			< b.m_node->getComponent<RenderComponent>().getMaterial();
+	U64 m_run = 0; ///< The SectorGroup::getVisibilityTestsRun it was built.
+	Timestamp m_timestamp = 0;
+	U8 m_testFlags = 0;
+	Bool m_valid = false;
+
+	~VisibilityCache()
+	{
+		ANKI_ASSERT(m_nodes.getSize() == 0 && "Forgot to call destroy");
 	}
+
+	void destroy(SceneAllocator<U8> alloc);
+
+	/// Check if the tests of this run can reuse it.
+	Bool canReuse(const FrustumComponent& frc,
+		const SectorGroup& sectors,
+		U8 testFlags) const;
 };
 
 /// Data common for all tasks.
@@ -84,7 +107,27 @@ private:
 	void gather();
 };
 
-/// ThreadHive task to rasterize triangles.
+/// ThreadHive task to bin a portion of the triangles to the tiles of the
+/// rasterizer.
+class BinTrianglesTask
+{
+public:
+	WeakPtr<GatherVisibleTrianglesTask> m_gatherTask;
+	U32 m_taskIdx;
+	U32 m_taskCount;
+
+	/// Thread hive task.
+	static void callback(void* ud, U32 threadId, ThreadHive& hive)
+	{
+		BinTrianglesTask& self = *static_cast<BinTrianglesTask*>(ud);
+		self.bin();
+	}
+
+private:
+	void bin();
+};
+
+/// ThreadHive task to rasterize a portion of the tiles.
 class RasterizeTrianglesTask
 {
 public:
@@ -125,10 +168,8 @@ private:
 	void gather()
 	{
 		ANKI_TRACE_START_EVENT(SCENE_VISIBILITY_ITERATE_SECTORS);
-		U testIdx = m_visCtx->m_testsCount.fetchAdd(1);
-
-		m_visCtx->m_scene->getSectorGroup().findVisibleNodes(
-			*m_frc, testIdx, m_r, m_sectorsCtx);
+		m_visCtx->m_scene->getSectorGroup().findVisibleSpatials(
+			*m_frc, m_r, m_sectorsCtx);
 		ANKI_TRACE_STOP_EVENT(SCENE_VISIBILITY_ITERATE_SECTORS);
 	}
 };
@@ -142,9 +183,30 @@ public:
 	WeakPtr<SectorGroupVisibilityTestsContext> m_sectorsCtx;
 	U32 m_taskIdx;
 	U32 m_taskCount;
+	U32 m_testIdx; ///< Unique per frustum. Used to visit a node once.
 	WeakPtr<VisibilityTestResults> m_result;
 	Timestamp m_timestamp = 0;
 
+	/// The cache of the frustum. Null if the frustum can't be cached.
+	VisibilityCache* m_cache = nullptr;
+
+	/// Replay the cache and test only the dirty spatials.
+	Bool m_reuseCache = false;
+
+	/// A visible node as the cache wants it.
+	class CacheRecord
+	{
+	public:
+		VisibleNode m_visibleNode;
+		U32* m_entries;
+		U8 m_entryCount;
+		U8 m_groupMask;
+	};
+
+	/// The visible nodes for the cache.
+	DynamicArray<CacheRecord> m_cacheRecords;
+	U32 m_cacheRecordCount = 0;
+
 	/// Thread hive task.
 	static void callback(void* ud, U32 threadId, ThreadHive& hive)
 	{
@@ -155,6 +217,11 @@ public:
 private:
 	void test(ThreadHive& hive);
 	void updateTimestamp(const SceneNode& node);
+
+	void recordForCache(const VisibleNode& visibleNode,
+		const U32* entries,
+		U entryCount,
+		U8 groupMask);
 };
 
 /// Task that combines and sorts the results.
@@ -169,11 +236,43 @@ public:
 	static void callback(void* ud, U32 threadId, ThreadHive& hive)
 	{
 		CombineResultsTask& self = *static_cast<CombineResultsTask*>(ud);
-		self.combine();
+		self.combine(hive);
 	}
 
 private:
-	void combine();
+	/// The min number of nodes a MergeResultsTask gets.
+	static const U MIN_NODES_PER_MERGE = 256;
+
+	void combine(ThreadHive& hive);
+
+	/// Rebuild the cache of the frustum from the results of the tests.
+	void updateCache();
+};
+
+/// Task that merges a part of a group of sorted results.
+class MergeResultsTask
+{
+public:
+	WeakPtr<VisibilityTestResults> m_visible;
+	WeakArray<VisibilityTestResults*> m_results;
+	VisibilityGroupType m_type;
+	U32 m_partIdx;
+	U32 m_partCount;
+
+	/// Thread hive task.
+	static void callback(void* ud, U32 threadId, ThreadHive& hive)
+	{
+		MergeResultsTask& self = *static_cast<MergeResultsTask*>(ud);
+		self.merge();
+	}
+
+private:
+	void merge()
+	{
+		ANKI_TRACE_START_EVENT(SCENE_VISIBILITY_MERGE_RESULTS);
+		m_visible->mergeSorted(m_type, m_results, m_partIdx, m_partCount);
+		ANKI_TRACE_STOP_EVENT(SCENE_VISIBILITY_MERGE_RESULTS);
+	}
 };
 /// @}
 
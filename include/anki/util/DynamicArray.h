@@ -331,9 +331,9 @@ public:
 
 	/// Copy.
 	WeakArray(const WeakArray& b)
-		: Base::m_data(b.m_data)
-		, Base::m_size(b.m_size)
+		: Base()
 	{
+		*this = b;
 	}
 
 	/// Move.
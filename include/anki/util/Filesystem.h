@@ -40,6 +40,21 @@ ANKI_USE_RESULT Error removeDirectory(const CString& dir);
 /// Equivalent to: mkdir dir
 ANKI_USE_RESULT Error createDirectory(const CString& dir);
 
+/// Rename a file. If the new file exists it's replaced atomically.
+ANKI_USE_RESULT Error renameFile(
+	const CString& oldName, const CString& newName);
+
+/// Map a whole file to memory for reading. The memory is read-only.
+/// @param filename The file.
+/// @param[out] data The start of the mapped memory. It's nullptr if the file
+///             is empty.
+/// @param[out] size The size of the file.
+ANKI_USE_RESULT Error mapFile(
+	const CString& filename, const U8*& data, PtrSize& size);
+
+/// Unmap a file mapped with mapFile.
+void unmapFile(const U8* data, PtrSize size);
+
 /// Get the home directory.
 /// Write the home directory to @a buff. The @a buffSize is the size of the
 /// @a buff. If the @buffSize is not enough the function will throw
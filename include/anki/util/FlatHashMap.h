@@ -0,0 +1,482 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/Allocator.h>
+#include <anki/util/Functions.h>
+#include <anki/util/NonCopyable.h>
+#include <cstring>
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+#include <emmintrin.h>
+#endif
+
+namespace anki
+{
+
+// Forward
+template<typename, typename, typename, typename>
+class FlatHashMap;
+
+/// @addtogroup util_containers
+/// @{
+
+namespace detail
+{
+
+/// The control bytes of a FlatHashMap. Every slot has one byte. If the slot is
+/// used the byte holds 7 bits of the hash, if not it holds one of the special
+/// values.
+/// @internal
+class FlatHashMapCtrl
+{
+public:
+	static const U8 EMPTY = 0x80;
+	static const U8 DELETED = 0xFE;
+
+	/// The slots that are tested at once.
+	static const U32 GROUP_SIZE = 16;
+
+	static Bool isFull(U8 ctrl)
+	{
+		return (ctrl & 0x80) == 0;
+	}
+
+	/// Get a bit mask of the slots in the group that match the hash bits.
+	static U32 match(const U8* group, U8 h2)
+	{
+#if ANKI_SIMD == ANKI_SIMD_SSE
+		__m128i ctrl =
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+#else
+		U32 mask = 0;
+		for(U32 i = 0; i < GROUP_SIZE; ++i)
+		{
+			mask |= U32(group[i] == h2) << i;
+		}
+		return mask;
+#endif
+	}
+
+	/// Get a bit mask of the empty slots in the group.
+	static U32 matchEmpty(const U8* group)
+	{
+		return match(group, EMPTY);
+	}
+
+	/// Get a bit mask of the empty or deleted slots in the group.
+	static U32 matchEmptyOrDeleted(const U8* group)
+	{
+#if ANKI_SIMD == ANKI_SIMD_SSE
+		__m128i ctrl =
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+		return _mm_movemask_epi8(ctrl);
+#else
+		U32 mask = 0;
+		for(U32 i = 0; i < GROUP_SIZE; ++i)
+		{
+			mask |= U32(!isFull(group[i])) << i;
+		}
+		return mask;
+#endif
+	}
+};
+
+/// FlatHashMap slot.
+/// @internal
+template<typename TValue>
+class FlatHashMapSlot
+{
+public:
+	U64 m_hash;
+	TValue m_value;
+
+	template<typename... TArgs>
+	FlatHashMapSlot(U64 hash, TArgs&&... args)
+		: m_hash(hash)
+		, m_value(std::forward<TArgs>(args)...)
+	{
+	}
+};
+
+/// FlatHashMap forward-only iterator.
+/// @internal
+template<typename TSlotPointer,
+	typename TValuePointer,
+	typename TValueReference>
+class FlatHashMapIterator
+{
+	template<typename, typename, typename, typename>
+	friend class anki::FlatHashMap;
+
+	template<typename, typename, typename>
+	friend class FlatHashMapIterator;
+
+public:
+	/// Default constructor.
+	FlatHashMapIterator() = default;
+
+	/// Copy.
+	FlatHashMapIterator(const FlatHashMapIterator& b) = default;
+
+	/// Allow conversion from iterator to const iterator.
+	template<typename YSlotPointer,
+		typename YValuePointer,
+		typename YValueReference>
+	FlatHashMapIterator(const FlatHashMapIterator<YSlotPointer,
+		YValuePointer,
+		YValueReference>& b)
+		: m_ctrl(b.m_ctrl)
+		, m_slots(b.m_slots)
+		, m_idx(b.m_idx)
+		, m_capacity(b.m_capacity)
+	{
+	}
+
+	FlatHashMapIterator(
+		const U8* ctrl, TSlotPointer slots, U32 idx, U32 capacity)
+		: m_ctrl(ctrl)
+		, m_slots(slots)
+		, m_idx(idx)
+		, m_capacity(capacity)
+	{
+	}
+
+	FlatHashMapIterator& operator=(const FlatHashMapIterator& b) = default;
+
+	TValueReference operator*() const
+	{
+		ANKI_ASSERT(m_idx < m_capacity);
+		return m_slots[m_idx].m_value;
+	}
+
+	TValuePointer operator->() const
+	{
+		ANKI_ASSERT(m_idx < m_capacity);
+		return &m_slots[m_idx].m_value;
+	}
+
+	FlatHashMapIterator& operator++()
+	{
+		ANKI_ASSERT(m_idx < m_capacity);
+		++m_idx;
+		skipUnused();
+		return *this;
+	}
+
+	FlatHashMapIterator operator++(int)
+	{
+		FlatHashMapIterator out = *this;
+		++(*this);
+		return out;
+	}
+
+	Bool operator==(const FlatHashMapIterator& b) const
+	{
+		return m_slots == b.m_slots && m_idx == b.m_idx;
+	}
+
+	Bool operator!=(const FlatHashMapIterator& b) const
+	{
+		return !(*this == b);
+	}
+
+private:
+	const U8* m_ctrl = nullptr;
+	TSlotPointer m_slots = nullptr;
+	U32 m_idx = 0;
+	U32 m_capacity = 0;
+
+	/// Move to the next used slot or the end.
+	void skipUnused()
+	{
+		while(m_idx < m_capacity && !FlatHashMapCtrl::isFull(m_ctrl[m_idx]))
+		{
+			++m_idx;
+		}
+	}
+};
+
+} // end namespace detail
+
+/// Hash map with open addressing. All the values live in one array and a
+/// separate array of control bytes is used to probe 16 slots at once. It's
+/// more cache friendly than HashMap and does one allocation for all values.
+/// Like HashMap the keys are identified by their 64bit hash only.
+/// @note Inserting may move the values around so don't keep pointers to them.
+/// @tparam TKey The key of the map.
+/// @tparam TValue The value of the map.
+/// @tparam THasher Functor to hash type of TKey.
+/// @tparam TCompare Functor to compare TKey.
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+class FlatHashMap : public NonCopyable
+{
+private:
+	using Slot = detail::FlatHashMapSlot<TValue>;
+	using Ctrl = detail::FlatHashMapCtrl;
+
+public:
+	using Key = TKey;
+	using Value = TValue;
+	using Reference = Value&;
+	using ConstReference = const Value&;
+	using Pointer = Value*;
+	using ConstPointer = const Value*;
+	using Iterator = detail::FlatHashMapIterator<Slot*, Pointer, Reference>;
+	using ConstIterator =
+		detail::FlatHashMapIterator<const Slot*, ConstPointer, ConstReference>;
+
+	/// Default constructor.
+	FlatHashMap() = default;
+
+	/// Move.
+	FlatHashMap(FlatHashMap&& b)
+	{
+		move(b);
+	}
+
+	/// You need to manually destroy the map.
+	/// @see FlatHashMap::destroy
+	~FlatHashMap()
+	{
+		ANKI_ASSERT(m_slots == nullptr && "Requires manual destruction");
+	}
+
+	/// Move.
+	FlatHashMap& operator=(FlatHashMap&& b)
+	{
+		ANKI_ASSERT(m_slots == nullptr && "Requires manual destruction");
+		move(b);
+		return *this;
+	}
+
+	/// Get begin.
+	Iterator getBegin()
+	{
+		Iterator it(m_ctrl, m_slots, 0, m_capacity);
+		it.skipUnused();
+		return it;
+	}
+
+	/// Get begin.
+	ConstIterator getBegin() const
+	{
+		ConstIterator it(m_ctrl, m_slots, 0, m_capacity);
+		it.skipUnused();
+		return it;
+	}
+
+	/// Get end.
+	Iterator getEnd()
+	{
+		return Iterator(m_ctrl, m_slots, m_capacity, m_capacity);
+	}
+
+	/// Get end.
+	ConstIterator getEnd() const
+	{
+		return ConstIterator(m_ctrl, m_slots, m_capacity, m_capacity);
+	}
+
+	/// Get begin.
+	Iterator begin()
+	{
+		return getBegin();
+	}
+
+	/// Get begin.
+	ConstIterator begin() const
+	{
+		return getBegin();
+	}
+
+	/// Get end.
+	Iterator end()
+	{
+		return getEnd();
+	}
+
+	/// Get end.
+	ConstIterator end() const
+	{
+		return getEnd();
+	}
+
+	/// Return true if map is empty.
+	Bool isEmpty() const
+	{
+		return m_size == 0;
+	}
+
+	/// Get the number of values in the map.
+	U32 getSize() const
+	{
+		return m_size;
+	}
+
+	/// Get the number of slots.
+	U32 getCapacity() const
+	{
+		return m_capacity;
+	}
+
+	/// Destroy the map.
+	template<typename TAllocator>
+	void destroy(TAllocator alloc);
+
+	/// Allocate enough slots for count values so that inserting up to that
+	/// number won't rehash.
+	template<typename TAllocator>
+	void reserve(TAllocator alloc, U32 count);
+
+	/// Rebuild the table. It gets rid of the erased slots and it will shrink
+	/// the storage if it's too big for the current values.
+	template<typename TAllocator>
+	void rehash(TAllocator alloc);
+
+	/// Copy an element in the map.
+	template<typename TAllocator>
+	Iterator pushBack(TAllocator alloc, const TKey& key, const TValue& x)
+	{
+		return emplaceBack(alloc, key, x);
+	}
+
+	/// Construct an element inside the map.
+	template<typename TAllocator, typename... TArgs>
+	Iterator emplaceBack(TAllocator alloc, const TKey& key, TArgs&&... args);
+
+	/// Erase element.
+	template<typename TAllocator>
+	void erase(TAllocator alloc, Iterator it);
+
+	/// Find item.
+	Iterator find(const Key& key)
+	{
+		U32 idx = findIndex(THasher()(key));
+		return Iterator(m_ctrl, m_slots, idx, m_capacity);
+	}
+
+	/// Find item.
+	ConstIterator find(const Key& key) const
+	{
+		U32 idx = findIndex(THasher()(key));
+		return ConstIterator(m_ctrl, m_slots, idx, m_capacity);
+	}
+
+private:
+	/// The probe sequence. It visits all groups if the capacity is a power of
+	/// two.
+	class ProbeSequence
+	{
+	public:
+		ProbeSequence(U64 h1, U32 mask)
+			: m_mask(mask)
+			, m_offset(h1 & mask)
+		{
+		}
+
+		U32 getOffset() const
+		{
+			return m_offset;
+		}
+
+		U32 getOffset(U32 i) const
+		{
+			return (m_offset + i) & m_mask;
+		}
+
+		void next()
+		{
+			m_index += Ctrl::GROUP_SIZE;
+			m_offset = (m_offset + m_index) & m_mask;
+		}
+
+	private:
+		U32 m_mask;
+		U32 m_offset;
+		U32 m_index = 0;
+	};
+
+	/// One allocation for the slots and the control bytes.
+	Slot* m_slots = nullptr;
+	/// It has GROUP_SIZE extra bytes that mirror the first group so a group can
+	/// be loaded from any slot.
+	U8* m_ctrl = nullptr;
+	U32 m_capacity = 0; ///< Always a power of two.
+	U32 m_size = 0;
+	U32 m_growthLeft = 0; ///< Empty slots that can be used before rehashing.
+
+	void move(FlatHashMap& b)
+	{
+		m_slots = b.m_slots;
+		m_ctrl = b.m_ctrl;
+		m_capacity = b.m_capacity;
+		m_size = b.m_size;
+		m_growthLeft = b.m_growthLeft;
+		b.m_slots = nullptr;
+		b.m_ctrl = nullptr;
+		b.m_capacity = b.m_size = b.m_growthLeft = 0;
+	}
+
+	/// Mix the user hash because the hashers are usually not that good.
+	static U64 mixHash(U64 hash)
+	{
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	static U64 getH1(U64 mixedHash)
+	{
+		return mixedHash >> 7;
+	}
+
+	static U8 getH2(U64 mixedHash)
+	{
+		return mixedHash & 0x7F;
+	}
+
+	/// The max number of values a table with that capacity can hold.
+	static U32 capacityToGrowth(U32 capacity)
+	{
+		return capacity - capacity / 8;
+	}
+
+	/// Set a control byte and its mirror.
+	void setCtrl(U32 idx, U8 ctrl)
+	{
+		ANKI_ASSERT(idx < m_capacity);
+		m_ctrl[idx] = ctrl;
+		if(idx < Ctrl::GROUP_SIZE)
+		{
+			m_ctrl[m_capacity + idx] = ctrl;
+		}
+	}
+
+	/// Return the index of the slot or m_capacity if not found.
+	U32 findIndex(U64 hash) const;
+
+	/// Find the first empty or deleted slot.
+	U32 findFirstNonFull(U64 mixedHash) const;
+
+	/// Find a slot for a new value and grow the table if needed.
+	template<typename TAllocator>
+	U32 prepareInsert(TAllocator alloc, U64 hash);
+
+	/// Move the values to new storage.
+	template<typename TAllocator>
+	void resize(TAllocator alloc, U32 newCapacity);
+
+	/// Get the capacity that is needed for count values.
+	static U32 computeCapacity(U32 count);
+};
+/// @}
+
+} // end namespace anki
+
+#include <anki/util/FlatHashMap.inl.h>
@@ -0,0 +1,274 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+namespace anki
+{
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+template<typename TAllocator>
+void FlatHashMap<TKey, TValue, THasher, TCompare>::destroy(TAllocator alloc)
+{
+	if(m_slots)
+	{
+		for(U32 i = 0; i < m_capacity; ++i)
+		{
+			if(Ctrl::isFull(m_ctrl[i]))
+			{
+				m_slots[i].~Slot();
+			}
+		}
+
+		typename TAllocator::template rebind<U8>::other ualloc(alloc);
+		ualloc.deallocate(m_slots, 1);
+
+		m_slots = nullptr;
+		m_ctrl = nullptr;
+		m_capacity = m_size = m_growthLeft = 0;
+	}
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+U32 FlatHashMap<TKey, TValue, THasher, TCompare>::computeCapacity(U32 count)
+{
+	U32 capacity = Ctrl::GROUP_SIZE;
+	while(capacityToGrowth(capacity) < count)
+	{
+		capacity *= 2;
+	}
+
+	return capacity;
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+template<typename TAllocator>
+void FlatHashMap<TKey, TValue, THasher, TCompare>::reserve(
+	TAllocator alloc, U32 count)
+{
+	U32 capacity = computeCapacity(count);
+	if(capacity > m_capacity)
+	{
+		resize(alloc, capacity);
+	}
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+template<typename TAllocator>
+void FlatHashMap<TKey, TValue, THasher, TCompare>::rehash(TAllocator alloc)
+{
+	if(m_size == 0)
+	{
+		destroy(alloc);
+	}
+	else
+	{
+		resize(alloc, computeCapacity(m_size));
+	}
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+template<typename TAllocator>
+void FlatHashMap<TKey, TValue, THasher, TCompare>::resize(
+	TAllocator alloc, U32 newCapacity)
+{
+	ANKI_ASSERT(isPowerOfTwo(newCapacity));
+	ANKI_ASSERT(newCapacity >= Ctrl::GROUP_SIZE);
+	ANKI_ASSERT(capacityToGrowth(newCapacity) >= m_size);
+
+	// Allocate the new storage. The control bytes go after the slots
+	const PtrSize slotsSize =
+		getAlignedRoundUp(Ctrl::GROUP_SIZE, sizeof(Slot) * newCapacity);
+	const PtrSize size = slotsSize + newCapacity + Ctrl::GROUP_SIZE;
+	PtrSize alignment = max<PtrSize>(alignof(Slot), Ctrl::GROUP_SIZE);
+
+	typename TAllocator::template rebind<U8>::other ualloc(alloc);
+	U8* mem = ualloc.allocate(size, &alignment);
+
+	Slot* oldSlots = m_slots;
+	U8* oldCtrl = m_ctrl;
+	const U32 oldCapacity = m_capacity;
+
+	m_slots = reinterpret_cast<Slot*>(mem);
+	m_ctrl = mem + slotsSize;
+	m_capacity = newCapacity;
+	m_growthLeft = capacityToGrowth(newCapacity) - m_size;
+	memset(m_ctrl, Ctrl::EMPTY, newCapacity + Ctrl::GROUP_SIZE);
+
+	// Move the values
+	for(U32 i = 0; i < oldCapacity; ++i)
+	{
+		if(Ctrl::isFull(oldCtrl[i]))
+		{
+			Slot& oldSlot = oldSlots[i];
+			const U64 mixedHash = mixHash(oldSlot.m_hash);
+			const U32 idx = findFirstNonFull(mixedHash);
+			setCtrl(idx, getH2(mixedHash));
+
+			::new(&m_slots[idx])
+				Slot(oldSlot.m_hash, std::move(oldSlot.m_value));
+			oldSlot.~Slot();
+		}
+	}
+
+	if(oldSlots)
+	{
+		ualloc.deallocate(oldSlots, 1);
+	}
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+U32 FlatHashMap<TKey, TValue, THasher, TCompare>::findIndex(U64 hash) const
+{
+	if(ANKI_UNLIKELY(m_capacity == 0))
+	{
+		return 0;
+	}
+
+	const U64 mixedHash = mixHash(hash);
+	const U8 h2 = getH2(mixedHash);
+	ProbeSequence seq(getH1(mixedHash), m_capacity - 1);
+
+	while(1)
+	{
+		const U8* group = m_ctrl + seq.getOffset();
+
+		U32 mask = Ctrl::match(group, h2);
+		while(mask)
+		{
+			const U32 idx = seq.getOffset(countTrailingZeros(mask));
+			if(m_slots[idx].m_hash == hash)
+			{
+				return idx;
+			}
+
+			mask &= mask - 1;
+		}
+
+		if(Ctrl::matchEmpty(group))
+		{
+			return m_capacity;
+		}
+
+		seq.next();
+	}
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+U32 FlatHashMap<TKey, TValue, THasher, TCompare>::findFirstNonFull(
+	U64 mixedHash) const
+{
+	ProbeSequence seq(getH1(mixedHash), m_capacity - 1);
+
+	while(1)
+	{
+		const U32 mask = Ctrl::matchEmptyOrDeleted(m_ctrl + seq.getOffset());
+		if(mask)
+		{
+			return seq.getOffset(countTrailingZeros(mask));
+		}
+
+		seq.next();
+	}
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+template<typename TAllocator>
+U32 FlatHashMap<TKey, TValue, THasher, TCompare>::prepareInsert(
+	TAllocator alloc, U64 hash)
+{
+	if(ANKI_UNLIKELY(m_capacity == 0))
+	{
+		resize(alloc, Ctrl::GROUP_SIZE);
+	}
+
+	const U64 mixedHash = mixHash(hash);
+	U32 idx = findFirstNonFull(mixedHash);
+
+	if(ANKI_UNLIKELY(m_growthLeft == 0 && m_ctrl[idx] != Ctrl::DELETED))
+	{
+		// Full. If most of the slots are deleted rehash in place, else grow
+		if(m_size <= capacityToGrowth(m_capacity) / 2)
+		{
+			resize(alloc, m_capacity);
+		}
+		else
+		{
+			resize(alloc, m_capacity * 2);
+		}
+
+		idx = findFirstNonFull(mixedHash);
+	}
+
+	if(m_ctrl[idx] == Ctrl::EMPTY)
+	{
+		ANKI_ASSERT(m_growthLeft > 0);
+		--m_growthLeft;
+	}
+
+	++m_size;
+	setCtrl(idx, getH2(mixedHash));
+	return idx;
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+template<typename TAllocator, typename... TArgs>
+typename FlatHashMap<TKey, TValue, THasher, TCompare>::Iterator
+FlatHashMap<TKey, TValue, THasher, TCompare>::emplaceBack(
+	TAllocator alloc, const TKey& key, TArgs&&... args)
+{
+	const U64 hash = THasher()(key);
+	ANKI_ASSERT(findIndex(hash) == m_capacity && "Not supported");
+
+	const U32 idx = prepareInsert(alloc, hash);
+	::new(&m_slots[idx]) Slot(hash, std::forward<TArgs>(args)...);
+
+	return Iterator(m_ctrl, m_slots, idx, m_capacity);
+}
+
+//==============================================================================
+template<typename TKey, typename TValue, typename THasher, typename TCompare>
+template<typename TAllocator>
+void FlatHashMap<TKey, TValue, THasher, TCompare>::erase(
+	TAllocator alloc, Iterator it)
+{
+	(void)alloc;
+	const U32 idx = it.m_idx;
+	ANKI_ASSERT(it.m_slots == m_slots && idx < m_capacity);
+	ANKI_ASSERT(Ctrl::isFull(m_ctrl[idx]));
+
+	m_slots[idx].~Slot();
+	--m_size;
+
+	// If there is an empty slot close enough on both sides then no probe
+	// sequence went past this slot and it can become empty again
+	const U32 idxBefore = (idx - Ctrl::GROUP_SIZE) & (m_capacity - 1);
+	const U32 emptyBefore = Ctrl::matchEmpty(m_ctrl + idxBefore);
+	const U32 emptyAfter = Ctrl::matchEmpty(m_ctrl + idx);
+
+	const Bool wasNeverFull = emptyBefore && emptyAfter
+		&& countTrailingZeros(emptyAfter)
+				+ countLeadingZeros(emptyBefore << 16)
+			< Ctrl::GROUP_SIZE;
+
+	if(wasNeverFull)
+	{
+		setCtrl(idx, Ctrl::EMPTY);
+		++m_growthLeft;
+	}
+	else
+	{
+		setCtrl(idx, Ctrl::DELETED);
+	}
+}
+
+} // end namespace anki
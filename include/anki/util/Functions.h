@@ -187,6 +187,39 @@ inline U32 countBits(U32 number)
 #endif
 }
 
+/// Count the trailing zero bits. The number shouldn't be zero.
+inline U32 countTrailingZeros(U32 number)
+{
+	ANKI_ASSERT(number != 0);
+#if defined(__GNUC__)
+	return __builtin_ctz(number);
+#else
+#error "Unimplemented"
+#endif
+}
+
+/// Count the trailing zero bits. The number shouldn't be zero.
+inline U32 countTrailingZeros(U64 number)
+{
+	ANKI_ASSERT(number != 0);
+#if defined(__GNUC__)
+	return __builtin_ctzll(number);
+#else
+#error "Unimplemented"
+#endif
+}
+
+/// Count the leading zero bits. The number shouldn't be zero.
+inline U32 countLeadingZeros(U32 number)
+{
+	ANKI_ASSERT(number != 0);
+#if defined(__GNUC__)
+	return __builtin_clz(number);
+#else
+#error "Unimplemented"
+#endif
+}
+
 /// Check if types are the same.
 template<class T, class Y>
 struct TypesAreTheSame
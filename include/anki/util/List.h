@@ -15,6 +15,8 @@ namespace anki
 // Forward
 template<typename T>
 class List;
+template<typename T>
+class IntrusiveList;
 
 /// @addtogroup util_containers
 /// @{
@@ -63,6 +65,9 @@ class ListIterator
 	template<typename>
 	friend class anki::List;
 
+	template<typename>
+	friend class anki::IntrusiveList;
+
 	template<typename, typename, typename, typename>
 	friend class ListIterator;
 
@@ -136,6 +136,10 @@ void ListBase<T, TNode>::insertNode(TNode* pos, TNode* node)
 			ANKI_ASSERT(m_tail != nullptr);
 			m_head = node;
 		}
+		else
+		{
+			node->m_prev->m_next = node;
+		}
 	}
 }
 
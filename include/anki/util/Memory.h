@@ -50,6 +50,27 @@ using AllocationSignature = U32;
 ///         nullptr on error. On deallocation mode returns nullptr
 void* allocAligned(void* userData, void* ptr, PtrSize size, PtrSize alignment);
 
+/// Memory pool statistics.
+class MemoryPoolStats
+{
+public:
+	/// The memory that is used by allocations.
+	PtrSize m_usedSize = 0;
+
+	/// The memory that the pool got from the allocation callback.
+	PtrSize m_reservedSize = 0;
+
+	/// The max m_reservedSize since the pool was created.
+	PtrSize m_peakReservedSize = 0;
+
+	U32 m_allocationsCount = 0;
+	U32 m_chunksCount = 0;
+
+	/// How many times a thread had to wait for another to release a lock
+	/// since the pool was created.
+	U32 m_lockContentionCount = 0;
+};
+
 /// Generic memory pool. The base of HeapMemoryPool or StackMemoryPool or
 /// ChainMemoryPool.
 class BaseMemoryPool : public NonCopyable
@@ -189,13 +210,19 @@ public:
 	///        errors
 	/// @param alignmentBytes The maximum supported alignment for returned
 	///        memory
+	/// @param threadLocalBlockSize If it's not zero every thread will grab
+	///        blocks of that size and do the small allocations from them
+	///        without touching the shared state. The allocations are not
+	///        counted individually then so ignoreDeallocationErrors should be
+	///        true.
 	void create(AllocAlignedCallback allocCb,
 		void* allocCbUserData,
 		PtrSize initialChunkSize,
 		F32 nextChunkScale = 2.0,
 		PtrSize nextChunkBias = 0,
 		Bool ignoreDeallocationErrors = true,
-		PtrSize alignmentBytes = ANKI_SAFE_ALIGNMENT);
+		PtrSize alignmentBytes = ANKI_SAFE_ALIGNMENT,
+		PtrSize threadLocalBlockSize = 0);
 
 	/// Allocate aligned memory. The operation is thread safe
 	/// @param size The size to allocate
@@ -213,7 +240,23 @@ public:
 	/// Get the current capacity of the pool. It's not thread safe.
 	PtrSize getMemoryCapacity() const;
 
+	/// Get the statistics. The allocations count is the number of allocations
+	/// since the last reset. It's not thread safe.
+	MemoryPoolStats getStats() const;
+
 private:
+	/// The block a thread is allocating from.
+	class alignas(64) ThreadSlot
+	{
+	public:
+		SpinLock m_lock;
+		U8* m_top = nullptr;
+		U8* m_end = nullptr;
+		U32 m_allocationsCount = 0;
+	};
+
+	static const U THREAD_SLOT_COUNT = 16;
+
 	/// The memory chunk.
 	class Chunk
 	{
@@ -271,6 +314,19 @@ private:
 
 	/// Protect the m_crntChunkIdx.
 	Mutex m_lock;
+
+	/// Thread local blocks. Only if m_threadLocalBlockSize is not zero.
+	ThreadSlot* m_threadSlots = nullptr;
+
+	PtrSize m_threadLocalBlockSize = 0;
+
+	Atomic<U32> m_lockContentionCount = {0};
+
+	/// Allocate from the shared chunks.
+	U8* allocateFromChunks(PtrSize size);
+
+	/// Get the memory used by the chunks.
+	PtrSize getUsedSize() const;
 };
 
 /// Chain memory pool. Almost similar to StackMemoryPool but more flexible and
@@ -317,7 +373,12 @@ public:
 	PtrSize getAllocatedSize() const;
 	/// @}
 
+	/// Get the statistics.
+	MemoryPoolStats getStats() const;
+
 private:
+	class ThreadSlot;
+
 	/// A chunk of memory
 	struct Chunk
 	{
@@ -338,19 +399,41 @@ private:
 
 		/// Next chunk in the list
 		Chunk* m_next = nullptr;
+
+		/// The thread slot that owns the chunk.
+		ThreadSlot* m_slot = nullptr;
+	};
+
+	/// Every thread allocates from the chunks of its own slot so threads
+	/// rarely wait for each other. A slot may be shared by many threads if
+	/// there are more threads than slots.
+	class alignas(64) ThreadSlot
+	{
+	public:
+		/// Fast thread locking.
+		SpinLock m_lock;
+
+		/// The first chunk.
+		Chunk* m_headChunk = nullptr;
+
+		/// Current chunk to allocate from.
+		Chunk* m_tailChunk = nullptr;
 	};
 
+	static const U THREAD_SLOT_COUNT = 16;
+
 	/// Alignment of allocations.
 	PtrSize m_alignmentBytes = 0;
 
-	/// The first chunk.
-	Chunk* m_headChunk = nullptr;
+	/// The slots. Allocated using the callback.
+	ThreadSlot* m_slots = nullptr;
 
-	/// Current chunk to allocate from.
-	Chunk* m_tailChunk = nullptr;
+	/// The memory of all chunks.
+	Atomic<PtrSize> m_reservedSize = {0};
 
-	/// Fast thread locking.
-	SpinLock* m_lock = nullptr;
+	Atomic<PtrSize> m_peakReservedSize = {0};
+
+	Atomic<U32> m_lockContentionCount = {0};
 
 	/// Size of the first chunk.
 	PtrSize m_initSize = 0;
@@ -364,12 +447,16 @@ private:
 	/// Cache a value.
 	PtrSize m_headerSize;
 
+	/// Lock a slot and count the contention.
+	void lockSlot(ThreadSlot& slot);
+
 	/// Compute the size for the next chunk.
+	/// @param slot The slot the chunk will go.
 	/// @param size The current allocation size.
-	PtrSize computeNewChunkSize(PtrSize size) const;
+	PtrSize computeNewChunkSize(const ThreadSlot& slot, PtrSize size) const;
 
 	/// Create a new chunk.
-	Chunk* createNewChunk(PtrSize size);
+	Chunk* createNewChunk(ThreadSlot& slot, PtrSize size);
 
 	/// Allocate from chunk.
 	void* allocateFromChunk(Chunk* ch, PtrSize size, PtrSize alignment);
@@ -7,6 +7,7 @@
 
 #include <anki/util/Assert.h>
 #include <anki/util/StdTypes.h>
+#include <anki/util/Atomic.h>
 
 namespace anki
 {
@@ -409,7 +410,9 @@ private:
 	{
 		if(Base::m_ptr)
 		{
-			auto count = Base::m_ptr->getRefcount().fetchSub(1);
+			// The last owner has to see the writes of the others
+			auto count = Base::m_ptr->getRefcount().fetchSub(
+				1, AtomicMemoryOrder::ACQ_REL);
 			if(count == 1)
 			{
 				TDeleter deleter;
@@ -0,0 +1,111 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/StdTypes.h>
+#include <anki/util/Array.h>
+#include <anki/util/Assert.h>
+#include <cstring>
+
+namespace anki
+{
+
+/// @addtogroup util_other
+/// @{
+
+/// Sort 64bit keys and move a value along with every key. It's a stable LSD
+/// radix sort that processes a byte per pass. The passes where all the keys
+/// have the same byte are skipped so keys that use only a few of their bits
+/// are cheap.
+/// @param[in,out] keys The keys.
+/// @param[in,out] values The values.
+/// @param count The number of keys and values.
+/// @param[out] tmpKeys Scratch memory for count keys.
+/// @param[out] tmpValues Scratch memory for count values.
+inline void radixSort(
+	U64* keys, U32* values, PtrSize count, U64* tmpKeys, U32* tmpValues)
+{
+	ANKI_ASSERT(count == 0 || (keys && values && tmpKeys && tmpValues));
+
+	// Small arrays are faster with insertion sort
+	const PtrSize INSERTION_SORT_THRESHOLD = 32;
+	if(count <= INSERTION_SORT_THRESHOLD)
+	{
+		for(PtrSize i = 1; i < count; ++i)
+		{
+			const U64 key = keys[i];
+			const U32 value = values[i];
+			PtrSize j = i;
+			while(j > 0 && keys[j - 1] > key)
+			{
+				keys[j] = keys[j - 1];
+				values[j] = values[j - 1];
+				--j;
+			}
+
+			keys[j] = key;
+			values[j] = value;
+		}
+
+		return;
+	}
+
+	// Compute the histograms of all the bytes at once
+	Array<Array<PtrSize, 256>, 8> histograms;
+	memset(&histograms[0][0], 0, sizeof(histograms));
+	for(PtrSize i = 0; i < count; ++i)
+	{
+		const U64 key = keys[i];
+		for(U b = 0; b < 8; ++b)
+		{
+			++histograms[b][(key >> (b * 8)) & 0xFF];
+		}
+	}
+
+	U64* srcKeys = keys;
+	U32* srcValues = values;
+	U64* dstKeys = tmpKeys;
+	U32* dstValues = tmpValues;
+	for(U b = 0; b < 8; ++b)
+	{
+		Array<PtrSize, 256>& histogram = histograms[b];
+
+		// Skip the pass if the byte is the same for all the keys
+		if(histogram[(srcKeys[0] >> (b * 8)) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		// Turn the histogram to offsets
+		PtrSize offset = 0;
+		for(U i = 0; i < 256; ++i)
+		{
+			const PtrSize c = histogram[i];
+			histogram[i] = offset;
+			offset += c;
+		}
+
+		for(PtrSize i = 0; i < count; ++i)
+		{
+			const PtrSize dst = histogram[(srcKeys[i] >> (b * 8)) & 0xFF]++;
+			dstKeys[dst] = srcKeys[i];
+			dstValues[dst] = srcValues[i];
+		}
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcValues, dstValues);
+	}
+
+	// The result should end up in the input
+	if(srcKeys != keys)
+	{
+		memcpy(keys, srcKeys, sizeof(U64) * count);
+		memcpy(values, srcValues, sizeof(U32) * count);
+	}
+}
+/// @}
+
+} // end namespace anki
@@ -138,6 +138,13 @@ public:
 		}
 	}
 
+	/// Try lock
+	/// @return True if it was locked successfully
+	Bool tryLock()
+	{
+		return !m_lock.test_and_set(std::memory_order_acquire);
+	}
+
 	/// Unlock
 	void unlock()
 	{
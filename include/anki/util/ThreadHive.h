@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/util/Thread.h>
+#include <anki/util/Atomic.h>
 #include <anki/util/DynamicArray.h>
 #include <anki/util/Allocator.h>
 
@@ -45,16 +46,41 @@ public:
 	ThreadHiveDependencyHandle m_outDependency;
 };
 
+/// Split a problem of problemSize elements in threadCount contiguous ranges
+/// and get the range of threadId.
+/// @memberof ThreadHive
+inline void splitThreadedProblem(PtrSize threadId,
+	PtrSize threadCount,
+	PtrSize problemSize,
+	PtrSize& start,
+	PtrSize& end)
+{
+	ANKI_ASSERT(threadId < threadCount);
+	start = threadId * problemSize / threadCount;
+	end = (threadId + 1) * problemSize / threadCount;
+}
+
 /// A scheduler of small tasks. It takes a number of tasks and schedules them in
 /// one of the threads. The tasks can depend on previously submitted tasks or be
 /// completely independent.
+///
+/// It has two modes. The default one keeps all tasks in a single queue
+/// protected by a mutex. The work stealing mode gives every thread a lock-free
+/// deque, resolves dependencies with atomic counters and pushes tasks that are
+/// submitted (or become ready) inside a task callback to the deque of the
+/// thread that runs that callback. Idle threads steal from the others.
 class ThreadHive : public NonCopyable
 {
 public:
 	static const U MAX_THREADS = 32;
 
 	/// Create the hive.
-	ThreadHive(U threadCount, GenericMemoryPoolAllocator<U8> alloc);
+	/// @param threadCount The number of threads.
+	/// @param alloc The allocator.
+	/// @param workStealing Use the work stealing scheduler.
+	ThreadHive(U threadCount,
+		GenericMemoryPoolAllocator<U8> alloc,
+		Bool workStealing = false);
 
 	~ThreadHive();
 
@@ -63,6 +89,11 @@ public:
 		return m_threadCount;
 	}
 
+	Bool isWorkStealing() const
+	{
+		return m_workStealing;
+	}
+
 	/// Submit tasks. The ThreadHiveTaskCallback callbacks can also call this.
 	void submitTasks(ThreadHiveTask* tasks, U taskCount);
 
@@ -79,14 +110,56 @@ public:
 	/// Wait for all tasks to finish. Will block.
 	void waitAllTasks();
 
+	/// Split the range [begin, end) in chunks of grainSize and run a functor
+	/// for every chunk. The threads grab chunks dynamically so uneven work
+	/// gets balanced. If it's called from a ThreadHiveTaskCallback the calling
+	/// thread will work on the range as well and it will run other tasks while
+	/// waiting. If it's called from another thread it will block and it will
+	/// end the current session like waitAllTasks() does.
+	/// @param begin The start of the range.
+	/// @param end The end of the range.
+	/// @param grainSize The size of the chunks.
+	/// @param func A functor with the signature
+	///        Error(PtrSize start, PtrSize end, U32 threadId).
+	/// @return The first error that the functor returned.
+	template<typename TFunc>
+	ANKI_USE_RESULT Error parallelFor(
+		PtrSize begin, PtrSize end, PtrSize grainSize, TFunc func);
+
 private:
 	static const U MAX_TASKS_PER_SESSION = 1024 * 2;
 
+	/// The state of a parallelFor.
+	class ParallelForContext
+	{
+	public:
+		using Callback = Error (*)(
+			void* func, PtrSize start, PtrSize end, U32 threadId);
+
+		Atomic<PtrSize> m_next;
+		PtrSize m_end;
+		PtrSize m_grainSize;
+		Callback m_callback;
+		void* m_func;
+		Atomic<U32> m_tasksLeft = {0};
+		Atomic<I32> m_err = {0};
+
+		/// Process chunks until there are no more.
+		void run(U32 threadId);
+	};
+
 	class Thread;
 
 	/// Lightweight task.
 	class Task;
 
+	/// A node in the list of tasks that depend on a task. Work stealing only.
+	class DependentNode;
+
+	/// A queue for tasks submitted from threads outside the hive. Work
+	/// stealing only.
+	class InjectionQueue;
+
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Thread* m_threads = nullptr;
 	U32 m_threadCount = 0;
@@ -103,17 +176,75 @@ private:
 	Mutex m_mtx;
 	ConditionVariable m_cvar;
 
+	/// @name Work stealing members
+	/// @{
+	Bool8 m_workStealing = false;
+	DynamicArray<DependentNode> m_dependents;
+	InjectionQueue* m_injection = nullptr;
+	Atomic<U32> m_wsAllocatedTasks = {0};
+	Atomic<U32> m_wsAllocatedDependents = {0};
+	Atomic<U32> m_wsPendingTasks = {0};
+	Atomic<I32> m_wsReadyTasks = {0}; ///< Tasks sitting in the queues.
+	Atomic<U32> m_wsSleepingThreads = {0};
+	ConditionVariable m_wsDoneCvar; ///< Signaled when all tasks are done.
+	/// @}
+
 	void threadRun(U threadId);
 
+	/// Run a task that is ready if there is one.
+	Bool tryRunTask(U32 threadId);
+
+	ANKI_USE_RESULT Error parallelForInternal(ParallelForContext& ctx);
+
+	static void parallelForTask(void* arg, U32 threadId, ThreadHive& hive);
+
 	/// Wait for more tasks.
 	Bool waitForWork(U threadId, Task*& task);
 
 	/// Get new work from the queue.
 	Task* getNewTask();
 
-	/// Complete a task.
-	void completeTask(U taskId);
+	/// Complete a task. The m_mtx should be locked.
+	void completeTask(Task& task);
+
+	/// @name Work stealing methods
+	/// @{
+	void wsSubmitTasks(ThreadHiveTask* tasks, U taskCount);
+
+	void wsThreadRun(Thread& thread);
+
+	/// Push tasks that have no pending dependencies.
+	void wsPushReadyTasks(const ThreadHiveDependencyHandle* tasks, U count);
+
+	/// Find a task in the local deque, the injection queue or steal one.
+	Bool wsFindTask(Thread& thread, ThreadHiveDependencyHandle& task);
+
+	/// Mark a task as done and release its dependents.
+	void wsCompleteTask(ThreadHiveDependencyHandle taskId);
+
+	void wsWaitAllTasks();
+	/// @}
 };
+
+//==============================================================================
+template<typename TFunc>
+inline Error ThreadHive::parallelFor(
+	PtrSize begin, PtrSize end, PtrSize grainSize, TFunc func)
+{
+	ANKI_ASSERT(begin <= end && grainSize > 0);
+
+	ParallelForContext ctx;
+	ctx.m_next.set(begin);
+	ctx.m_end = end;
+	ctx.m_grainSize = grainSize;
+	ctx.m_func = &func;
+	ctx.m_callback =
+		[](void* f, PtrSize start, PtrSize end, U32 threadId) -> Error {
+		return (*static_cast<TFunc*>(f))(start, end, threadId);
+	};
+
+	return parallelForInternal(ctx);
+}
 /// @}
 
 } // end namespace anki
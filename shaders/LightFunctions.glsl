@@ -23,11 +23,11 @@ void getClusterInfo(in uint clusterIdx,
 	out uint spotLightCount,
 	out uint probeCount)
 {
-	uint cluster = u_clusters[clusterIdx];
-	indexOffset = cluster >> 16u;
-	probeCount = (cluster >> 8u) & 0xFu;
-	pointLightCount = (cluster >> 4u) & 0xFu;
-	spotLightCount = cluster & 0xFu;
+	uvec2 cluster = u_clusters[clusterIdx];
+	indexOffset = cluster.x;
+	probeCount = cluster.y >> 20u;
+	pointLightCount = (cluster.y >> 10u) & 0x3FFu;
+	spotLightCount = cluster.y & 0x3FFu;
 }
 
 //==============================================================================
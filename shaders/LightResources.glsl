@@ -76,7 +76,7 @@ layout(std140,
 
 layout(SS_BINDING(LIGHT_SET, LIGHT_SS_BINDING + 0), std430) readonly buffer s0_
 {
-	uint u_clusters[];
+	uvec2 u_clusters[];
 };
 
 layout(std430, SS_BINDING(LIGHT_SET, LIGHT_SS_BINDING + 1)) readonly buffer s1_
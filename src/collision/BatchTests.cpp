@@ -0,0 +1,363 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/collision/BatchTests.h>
+#include <anki/collision/Plane.h>
+#include <anki/math/F32x4.h>
+
+namespace anki
+{
+
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+/// The planes in the layout the kernels want.
+class BatchPlanes
+{
+public:
+	U32 m_count;
+	Array<F32, MAX_BATCH_TEST_PLANES> m_nx, m_ny, m_nz;
+	Array<F32, MAX_BATCH_TEST_PLANES> m_absNx, m_absNy, m_absNz;
+	Array<F32, MAX_BATCH_TEST_PLANES> m_offset;
+
+#if ANKI_F32X4_SIMD
+	Array<F32x4, MAX_BATCH_TEST_PLANES> m_nx4, m_ny4, m_nz4;
+	Array<F32x4, MAX_BATCH_TEST_PLANES> m_absNx4, m_absNy4, m_absNz4;
+	Array<F32x4, MAX_BATCH_TEST_PLANES> m_offset4;
+#endif
+
+	BatchPlanes(const Plane* planes, U count)
+		: m_count(count)
+	{
+		ANKI_ASSERT(planes && count > 0 && count <= MAX_BATCH_TEST_PLANES);
+
+		for(U i = 0; i < count; ++i)
+		{
+			const Vec4& n = planes[i].getNormal();
+			m_nx[i] = n.x();
+			m_ny[i] = n.y();
+			m_nz[i] = n.z();
+			m_absNx[i] = absolute(n.x());
+			m_absNy[i] = absolute(n.y());
+			m_absNz[i] = absolute(n.z());
+			m_offset[i] = planes[i].getOffset();
+
+#if ANKI_F32X4_SIMD
+			m_nx4[i] = splat(m_nx[i]);
+			m_ny4[i] = splat(m_ny[i]);
+			m_nz4[i] = splat(m_nz[i]);
+			m_absNx4[i] = splat(m_absNx[i]);
+			m_absNy4[i] = splat(m_absNy[i]);
+			m_absNz4[i] = splat(m_absNz[i]);
+			m_offset4[i] = splat(m_offset[i]);
+#endif
+		}
+	}
+};
+
+/// The actual tests. The presence of extents and radius is known at compile
+/// time so the spheres and boxes don't pay for each other.
+template<Bool HAS_EXTENTS, Bool HAS_RADIUS>
+class BatchKernel
+{
+public:
+	/// Test a single volume.
+	static Bool test(const BatchPlanes& planes, const BatchVolumes& v, U32 i)
+	{
+		const F32 cx = v.m_centerX[i];
+		const F32 cy = v.m_centerY[i];
+		const F32 cz = v.m_centerZ[i];
+
+		for(U p = 0; p < planes.m_count; ++p)
+		{
+			// The distance of the center from the plane plus the projection of
+			// the volume on the normal. If negative the whole volume is behind
+			F32 dist = planes.m_nx[p] * cx;
+			dist += planes.m_ny[p] * cy;
+			dist += planes.m_nz[p] * cz;
+			dist -= planes.m_offset[p];
+
+			if(HAS_EXTENTS)
+			{
+				dist += planes.m_absNx[p] * v.m_extentX[i];
+				dist += planes.m_absNy[p] * v.m_extentY[i];
+				dist += planes.m_absNz[p] * v.m_extentZ[i];
+			}
+
+			if(HAS_RADIUS)
+			{
+				dist += v.m_radius[i];
+			}
+
+			if(dist < 0.0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+#if ANKI_F32X4_SIMD
+	/// Test 4 volumes.
+	/// @param load A functor that loads 4 lanes from an array.
+	/// @return A 4 bit mask with the volumes that passed.
+	template<typename TLoad>
+	static U32 test4(
+		const BatchPlanes& planes, const BatchVolumes& v, TLoad load)
+	{
+		const F32x4 cx = load(v.m_centerX);
+		const F32x4 cy = load(v.m_centerY);
+		const F32x4 cz = load(v.m_centerZ);
+
+		F32x4 ex, ey, ez, radius;
+		if(HAS_EXTENTS)
+		{
+			ex = load(v.m_extentX);
+			ey = load(v.m_extentY);
+			ez = load(v.m_extentZ);
+		}
+
+		if(HAS_RADIUS)
+		{
+			radius = load(v.m_radius);
+		}
+
+		// Keep the minimum distance of all planes. If that is negative then
+		// at least one plane has the volume behind it
+		F32x4 minDist = splat(MAX_F32);
+		for(U p = 0; p < planes.m_count; ++p)
+		{
+			F32x4 dist = mul(planes.m_nx4[p], cx);
+			dist = mulAdd(planes.m_ny4[p], cy, dist);
+			dist = mulAdd(planes.m_nz4[p], cz, dist);
+			dist = sub(dist, planes.m_offset4[p]);
+
+			if(HAS_EXTENTS)
+			{
+				dist = mulAdd(planes.m_absNx4[p], ex, dist);
+				dist = mulAdd(planes.m_absNy4[p], ey, dist);
+				dist = mulAdd(planes.m_absNz4[p], ez, dist);
+			}
+
+			if(HAS_RADIUS)
+			{
+				dist = add(dist, radius);
+			}
+
+			minDist = minPerLane(minDist, dist);
+		}
+
+		return nonNegativeMask(minDist);
+	}
+#endif
+};
+
+#if ANKI_F32X4_SIMD
+/// Load 4 consecutive volumes.
+class ContiguousLoad
+{
+public:
+	U32 m_first;
+
+	F32x4 operator()(const F32* arr) const
+	{
+		return load(arr + m_first);
+	}
+};
+
+/// Load 4 volumes using indices.
+class IndexedLoad
+{
+public:
+	const U32* m_indices;
+
+	F32x4 operator()(const F32* arr) const
+	{
+		return gather(arr, m_indices);
+	}
+};
+#endif
+
+//==============================================================================
+template<Bool HAS_EXTENTS, Bool HAS_RADIUS>
+static U32 testRange(const BatchVolumes& volumes,
+	U32 count,
+	const BatchPlanes& planes,
+	U32* visibleIndices,
+	U32* visibleMask)
+{
+	using Kernel = BatchKernel<HAS_EXTENTS, HAS_RADIUS>;
+	U32 visibleCount = 0;
+	U32 i = 0;
+
+#if ANKI_F32X4_SIMD
+	for(; i + 4 <= count; i += 4)
+	{
+		const U32 mask = Kernel::test4(planes, volumes, ContiguousLoad{i});
+
+		if(visibleMask)
+		{
+			visibleMask[i / 32] |= mask << (i % 32);
+		}
+		else
+		{
+			U32 bits = mask;
+			while(bits)
+			{
+				visibleIndices[visibleCount++] = i + countTrailingZeros(bits);
+				bits &= bits - 1;
+			}
+		}
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		if(Kernel::test(planes, volumes, i))
+		{
+			if(visibleMask)
+			{
+				visibleMask[i / 32] |= 1u << (i % 32);
+			}
+			else
+			{
+				visibleIndices[visibleCount++] = i;
+			}
+		}
+	}
+
+	return visibleCount;
+}
+
+//==============================================================================
+template<Bool HAS_EXTENTS, Bool HAS_RADIUS>
+static U32 testIndexed(const BatchVolumes& volumes,
+	const U32* indices,
+	U32 count,
+	const BatchPlanes& planes,
+	U32* visibleIndices)
+{
+	using Kernel = BatchKernel<HAS_EXTENTS, HAS_RADIUS>;
+	U32 visibleCount = 0;
+	U32 i = 0;
+
+#if ANKI_F32X4_SIMD
+	for(; i + 4 <= count; i += 4)
+	{
+		// Copy the indices first because the output can alias them
+		const U32 idx[4] = {
+			indices[i], indices[i + 1], indices[i + 2], indices[i + 3]};
+
+		U32 bits = Kernel::test4(planes, volumes, IndexedLoad{idx});
+		while(bits)
+		{
+			visibleIndices[visibleCount++] = idx[countTrailingZeros(bits)];
+			bits &= bits - 1;
+		}
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		const U32 idx = indices[i];
+		if(Kernel::test(planes, volumes, idx))
+		{
+			visibleIndices[visibleCount++] = idx;
+		}
+	}
+
+	return visibleCount;
+}
+
+//==============================================================================
+// Public                                                                      =
+//==============================================================================
+
+//==============================================================================
+U32 batchTestPlanes(const BatchVolumes& volumes,
+	U32 count,
+	const Plane* planes,
+	U planeCount,
+	U32* visibleIndices)
+{
+	ANKI_ASSERT(visibleIndices);
+	ANKI_ASSERT(volumes.m_extentX || volumes.m_radius);
+	const BatchPlanes bplanes(planes, planeCount);
+
+	if(volumes.m_extentX && volumes.m_radius)
+	{
+		return testRange<true, true>(
+			volumes, count, bplanes, visibleIndices, nullptr);
+	}
+	else if(volumes.m_extentX)
+	{
+		return testRange<true, false>(
+			volumes, count, bplanes, visibleIndices, nullptr);
+	}
+	else
+	{
+		return testRange<false, true>(
+			volumes, count, bplanes, visibleIndices, nullptr);
+	}
+}
+
+//==============================================================================
+void batchTestPlanesMask(const BatchVolumes& volumes,
+	U32 count,
+	const Plane* planes,
+	U planeCount,
+	U32* visibleMask)
+{
+	ANKI_ASSERT(visibleMask);
+	ANKI_ASSERT(volumes.m_extentX || volumes.m_radius);
+	const BatchPlanes bplanes(planes, planeCount);
+	memset(visibleMask, 0, sizeof(U32) * ((count + 31) / 32));
+
+	if(volumes.m_extentX && volumes.m_radius)
+	{
+		testRange<true, true>(volumes, count, bplanes, nullptr, visibleMask);
+	}
+	else if(volumes.m_extentX)
+	{
+		testRange<true, false>(volumes, count, bplanes, nullptr, visibleMask);
+	}
+	else
+	{
+		testRange<false, true>(volumes, count, bplanes, nullptr, visibleMask);
+	}
+}
+
+//==============================================================================
+U32 batchTestPlanesIndexed(const BatchVolumes& volumes,
+	const U32* indices,
+	U32 count,
+	const Plane* planes,
+	U planeCount,
+	U32* visibleIndices)
+{
+	ANKI_ASSERT(indices && visibleIndices);
+	ANKI_ASSERT(volumes.m_extentX || volumes.m_radius);
+	const BatchPlanes bplanes(planes, planeCount);
+
+	if(volumes.m_extentX && volumes.m_radius)
+	{
+		return testIndexed<true, true>(
+			volumes, indices, count, bplanes, visibleIndices);
+	}
+	else if(volumes.m_extentX)
+	{
+		return testIndexed<true, false>(
+			volumes, indices, count, bplanes, visibleIndices);
+	}
+	else
+	{
+		return testIndexed<false, true>(
+			volumes, indices, count, bplanes, visibleIndices);
+	}
+}
+
+} // end namespace anki
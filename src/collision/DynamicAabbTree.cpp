@@ -0,0 +1,394 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/collision/DynamicAabbTree.h>
+#include <anki/collision/Aabb.h>
+
+namespace anki
+{
+
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+static Vec4 minPerComponent(const Vec4& a, const Vec4& b)
+{
+	return Vec4(min(a.x(), b.x()), min(a.y(), b.y()), min(a.z(), b.z()), 0.0);
+}
+
+static Vec4 maxPerComponent(const Vec4& a, const Vec4& b)
+{
+	return Vec4(max(a.x(), b.x()), max(a.y(), b.y()), max(a.z(), b.z()), 0.0);
+}
+
+static Bool contains(const Vec4& outerMin,
+	const Vec4& outerMax,
+	const Vec4& innerMin,
+	const Vec4& innerMax)
+{
+	return outerMin.x() <= innerMin.x() && outerMin.y() <= innerMin.y()
+		&& outerMin.z() <= innerMin.z() && outerMax.x() >= innerMax.x()
+		&& outerMax.y() >= innerMax.y() && outerMax.z() >= innerMax.z();
+}
+
+//==============================================================================
+// DynamicAabbTree                                                             =
+//==============================================================================
+
+//==============================================================================
+void DynamicAabbTree::destroy(CollisionAllocator<U8> alloc)
+{
+	m_nodes.destroy(alloc);
+	m_root = NULL_NODE;
+	m_freeList = NULL_NODE;
+	m_usedNodeCount = 0;
+	m_leafCount = 0;
+}
+
+//==============================================================================
+F32 DynamicAabbTree::computeSurfaceArea(
+	const Vec4& aabbMin, const Vec4& aabbMax)
+{
+	const Vec4 d = aabbMax - aabbMin;
+	return 2.0 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+}
+
+//==============================================================================
+void DynamicAabbTree::reserveNodes(CollisionAllocator<U8> alloc, U32 count)
+{
+	if(m_nodes.getSize() - m_usedNodeCount >= count)
+	{
+		return;
+	}
+
+	// Grow and chain the new nodes in front of the free list
+	const U32 oldCount = m_nodes.getSize();
+	const U32 newCount = max<U32>(
+		max<U32>(16, oldCount * 2), m_usedNodeCount + count);
+	m_nodes.resize(alloc, newCount);
+
+	for(U32 i = oldCount; i < newCount; ++i)
+	{
+		m_nodes[i].m_parent = (i + 1 < newCount) ? i + 1 : m_freeList;
+		m_nodes[i].m_height = -1;
+	}
+
+	m_freeList = oldCount;
+}
+
+//==============================================================================
+U32 DynamicAabbTree::newNode()
+{
+	ANKI_ASSERT(m_freeList != NULL_NODE && "Forgot to reserve");
+
+	const U32 idx = m_freeList;
+	Node& node = m_nodes[idx];
+	m_freeList = node.m_parent;
+	++m_usedNodeCount;
+
+	node.m_parent = NULL_NODE;
+	node.m_children[0] = node.m_children[1] = NULL_NODE;
+	node.m_userData = 0;
+	node.m_height = 0;
+
+	return idx;
+}
+
+//==============================================================================
+void DynamicAabbTree::deleteNode(U32 idx)
+{
+	ANKI_ASSERT(idx < m_nodes.getSize() && m_nodes[idx].m_height >= 0);
+	m_nodes[idx].m_parent = m_freeList;
+	m_nodes[idx].m_height = -1;
+	m_freeList = idx;
+	ANKI_ASSERT(m_usedNodeCount > 0);
+	--m_usedNodeCount;
+}
+
+//==============================================================================
+U32 DynamicAabbTree::newLeaf(
+	CollisionAllocator<U8> alloc, const Aabb& aabb, U32 userData)
+{
+	// The leaf and the parent that insertLeaf will create
+	reserveNodes(alloc, 2);
+	const U32 leaf = newNode();
+
+	Node& node = m_nodes[leaf];
+	const Vec4 margin(m_margin, m_margin, m_margin, 0.0);
+	node.m_min = aabb.getMin().xyz0() - margin;
+	node.m_max = aabb.getMax().xyz0() + margin;
+	node.m_userData = userData;
+
+	insertLeaf(leaf);
+	++m_leafCount;
+
+	return leaf;
+}
+
+//==============================================================================
+void DynamicAabbTree::deleteLeaf(U32 leaf)
+{
+	ANKI_ASSERT(leaf < m_nodes.getSize() && m_nodes[leaf].isLeaf());
+	ANKI_ASSERT(m_leafCount > 0);
+
+	removeLeaf(leaf);
+	deleteNode(leaf);
+	--m_leafCount;
+}
+
+//==============================================================================
+Bool DynamicAabbTree::moveLeaf(U32 leaf, const Aabb& aabb)
+{
+	ANKI_ASSERT(leaf < m_nodes.getSize() && m_nodes[leaf].isLeaf());
+	Node& node = m_nodes[leaf];
+
+	const Vec4 margin(m_margin, m_margin, m_margin, 0.0);
+	const Vec4 newMin = aabb.getMin().xyz0() - margin;
+	const Vec4 newMax = aabb.getMax().xyz0() + margin;
+
+	if(contains(node.m_min, node.m_max, aabb.getMin(), aabb.getMax()))
+	{
+		// Still inside the fat box. Re-insert only if the fat box became too
+		// big for what it holds
+		const Vec4 hugeMargin = margin * 4.0;
+		if(contains(newMin - hugeMargin,
+			   newMax + hugeMargin,
+			   node.m_min,
+			   node.m_max))
+		{
+			return false;
+		}
+	}
+
+	// Removing the leaf frees its parent so insertLeaf won't allocate
+	removeLeaf(leaf);
+	node.m_min = newMin;
+	node.m_max = newMax;
+	insertLeaf(leaf);
+
+	return true;
+}
+
+//==============================================================================
+void DynamicAabbTree::insertLeaf(U32 leaf)
+{
+	if(m_root == NULL_NODE)
+	{
+		m_root = leaf;
+		m_nodes[leaf].m_parent = NULL_NODE;
+		return;
+	}
+
+	// Find the best sibling by descending to the child that costs less
+	const Vec4 leafMin = m_nodes[leaf].m_min;
+	const Vec4 leafMax = m_nodes[leaf].m_max;
+	U32 idx = m_root;
+	while(!m_nodes[idx].isLeaf())
+	{
+		const Node& node = m_nodes[idx];
+
+		const F32 area = computeSurfaceArea(node.m_min, node.m_max);
+		const F32 combinedArea =
+			computeSurfaceArea(minPerComponent(node.m_min, leafMin),
+				maxPerComponent(node.m_max, leafMax));
+
+		// The cost of making a new parent of this node and the leaf
+		const F32 cost = 2.0 * combinedArea;
+
+		// The minimum cost of pushing the leaf further down
+		const F32 inheritanceCost = 2.0 * (combinedArea - area);
+
+		Array<F32, 2> childCosts;
+		for(U i = 0; i < 2; ++i)
+		{
+			const Node& child = m_nodes[node.m_children[i]];
+			const F32 newArea =
+				computeSurfaceArea(minPerComponent(child.m_min, leafMin),
+					maxPerComponent(child.m_max, leafMax));
+
+			childCosts[i] = (child.isLeaf())
+				? newArea + inheritanceCost
+				: newArea - computeSurfaceArea(child.m_min, child.m_max)
+					+ inheritanceCost;
+		}
+
+		if(cost < childCosts[0] && cost < childCosts[1])
+		{
+			break;
+		}
+
+		idx = node.m_children[(childCosts[0] < childCosts[1]) ? 0 : 1];
+	}
+
+	// Create a new parent for the sibling and the leaf
+	const U32 sibling = idx;
+	const U32 oldParent = m_nodes[sibling].m_parent;
+	const U32 newParent = newNode();
+
+	Node& parentNode = m_nodes[newParent];
+	parentNode.m_parent = oldParent;
+	parentNode.m_min = minPerComponent(m_nodes[sibling].m_min, leafMin);
+	parentNode.m_max = maxPerComponent(m_nodes[sibling].m_max, leafMax);
+	parentNode.m_height = m_nodes[sibling].m_height + 1;
+	parentNode.m_children[0] = sibling;
+	parentNode.m_children[1] = leaf;
+
+	if(oldParent != NULL_NODE)
+	{
+		Node& old = m_nodes[oldParent];
+		old.m_children[(old.m_children[0] == sibling) ? 0 : 1] = newParent;
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	m_nodes[sibling].m_parent = newParent;
+	m_nodes[leaf].m_parent = newParent;
+
+	refitAncestors(leaf);
+}
+
+//==============================================================================
+void DynamicAabbTree::removeLeaf(U32 leaf)
+{
+	if(leaf == m_root)
+	{
+		m_root = NULL_NODE;
+		return;
+	}
+
+	const U32 parent = m_nodes[leaf].m_parent;
+	const U32 grandParent = m_nodes[parent].m_parent;
+	const U32 sibling =
+		m_nodes[parent].m_children[(m_nodes[parent].m_children[0] == leaf)
+				? 1
+				: 0];
+
+	if(grandParent != NULL_NODE)
+	{
+		// Replace the parent with the sibling
+		Node& gp = m_nodes[grandParent];
+		gp.m_children[(gp.m_children[0] == parent) ? 0 : 1] = sibling;
+		m_nodes[sibling].m_parent = grandParent;
+		deleteNode(parent);
+
+		refitAncestors(sibling);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].m_parent = NULL_NODE;
+		deleteNode(parent);
+	}
+}
+
+//==============================================================================
+void DynamicAabbTree::refit(U32 idx)
+{
+	Node& node = m_nodes[idx];
+	const Node& a = m_nodes[node.m_children[0]];
+	const Node& b = m_nodes[node.m_children[1]];
+
+	node.m_height = 1 + max(a.m_height, b.m_height);
+	node.m_min = minPerComponent(a.m_min, b.m_min);
+	node.m_max = maxPerComponent(a.m_max, b.m_max);
+}
+
+//==============================================================================
+void DynamicAabbTree::refitAncestors(U32 idx)
+{
+	idx = m_nodes[idx].m_parent;
+	while(idx != NULL_NODE)
+	{
+		idx = balance(idx);
+		refit(idx);
+		idx = m_nodes[idx].m_parent;
+	}
+}
+
+//==============================================================================
+U32 DynamicAabbTree::balance(U32 iA)
+{
+	Node& a = m_nodes[iA];
+	if(a.isLeaf() || a.m_height < 2)
+	{
+		return iA;
+	}
+
+	const U32 iB = a.m_children[0];
+	const U32 iC = a.m_children[1];
+	Node& b = m_nodes[iB];
+	Node& c = m_nodes[iC];
+
+	const I32 imbalance = c.m_height - b.m_height;
+
+	// Pick the child that is higher and move it up. Its higher child becomes
+	// its sibling and the other goes down to A
+	U32 iUp, iSibling;
+	U upSlot;
+	if(imbalance > 1)
+	{
+		iUp = iC;
+		iSibling = iB;
+		upSlot = 1;
+	}
+	else if(imbalance < -1)
+	{
+		iUp = iB;
+		iSibling = iC;
+		upSlot = 0;
+	}
+	else
+	{
+		return iA;
+	}
+
+	Node& up = m_nodes[iUp];
+	const U32 iF = up.m_children[0];
+	const U32 iG = up.m_children[1];
+	Node& f = m_nodes[iF];
+	Node& g = m_nodes[iG];
+
+	// Swap A and the child
+	up.m_children[0] = iA;
+	up.m_parent = a.m_parent;
+	a.m_parent = iUp;
+
+	if(up.m_parent != NULL_NODE)
+	{
+		Node& parent = m_nodes[up.m_parent];
+		parent.m_children[(parent.m_children[0] == iA) ? 0 : 1] = iUp;
+	}
+	else
+	{
+		m_root = iUp;
+	}
+
+	// The higher grandchild stays with the child that went up
+	const Bool keepF = f.m_height > g.m_height;
+	const U32 iKeep = (keepF) ? iF : iG;
+	const U32 iGive = (keepF) ? iG : iF;
+
+	up.m_children[1] = iKeep;
+	a.m_children[upSlot] = iGive;
+	m_nodes[iGive].m_parent = iA;
+
+	const Node& sibling = m_nodes[iSibling];
+	const Node& give = m_nodes[iGive];
+	const Node& keep = m_nodes[iKeep];
+
+	a.m_min = minPerComponent(sibling.m_min, give.m_min);
+	a.m_max = maxPerComponent(sibling.m_max, give.m_max);
+	a.m_height = 1 + max(sibling.m_height, give.m_height);
+
+	up.m_min = minPerComponent(a.m_min, keep.m_min);
+	up.m_max = maxPerComponent(a.m_max, keep.m_max);
+	up.m_height = 1 + max(a.m_height, keep.m_height);
+
+	return iUp;
+}
+
+} // end namespace anki
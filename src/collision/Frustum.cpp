@@ -6,6 +6,7 @@
 #include <anki/collision/Frustum.h>
 #include <anki/collision/LineSegment.h>
 #include <anki/collision/Aabb.h>
+#include <anki/collision/BatchTests.h>
 
 namespace anki
 {
@@ -71,6 +72,18 @@ Bool Frustum::insideFrustum(const CollisionShape& b) const
 	return true;
 }
 
+//==============================================================================
+U32 Frustum::insideFrustum(
+	const BatchVolumes& volumes, U32 count, U32* visibleIndices) const
+{
+	update();
+	return batchTestPlanes(volumes,
+		count,
+		&m_planesW[0],
+		m_planesW.getSize(),
+		visibleIndices);
+}
+
 //==============================================================================
 void Frustum::transform(const Transform& trf)
 {
@@ -9,7 +9,6 @@
 #include <anki/util/File.h>
 #include <anki/util/Filesystem.h>
 #include <anki/util/System.h>
-#include <anki/util/ThreadPool.h>
 #include <anki/util/ThreadHive.h>
 #include <anki/core/Trace.h>
 
@@ -94,12 +93,6 @@ void App::cleanup()
 		m_gr = nullptr;
 	}
 
-	if(m_threadpool)
-	{
-		m_heapAlloc.deleteInstance(m_threadpool);
-		m_threadpool = nullptr;
-	}
-
 	if(m_threadHive)
 	{
 		m_heapAlloc.deleteInstance(m_threadHive);
@@ -197,9 +190,12 @@ Error App::initInternal(const ConfigSet& config_,
 	nwinit.m_stencilBits = 0;
 	nwinit.m_fullscreenDesktopRez =
 		config.getNumber("fullscreenDesktopResolution");
+	// The null backend doesn't present anything so it doesn't need a window
+#if ANKI_GR_BACKEND != ANKI_GR_BACKEND_NULL
 	m_window = m_heapAlloc.newInstance<NativeWindow>();
 
 	ANKI_CHECK(m_window->init(nwinit, m_heapAlloc));
+#endif
 
 	//
 	// Input
@@ -209,11 +205,10 @@ Error App::initInternal(const ConfigSet& config_,
 	ANKI_CHECK(m_input->create(m_window));
 
 	//
-	// ThreadPool
+	// ThreadHive
 	//
-	m_threadpool = m_heapAlloc.newInstance<ThreadPool>(getCpuCoresCount());
-	m_threadHive =
-		m_heapAlloc.newInstance<ThreadHive>(getCpuCoresCount(), m_heapAlloc);
+	m_threadHive = m_heapAlloc.newInstance<ThreadHive>(
+		getCpuCoresCount(), m_heapAlloc, true);
 
 	//
 	// Graphics API
@@ -260,7 +255,7 @@ Error App::initInternal(const ConfigSet& config_,
 	//
 	// Renderer
 	//
-	if(nwinit.m_fullscreenDesktopRez)
+	if(m_window && nwinit.m_fullscreenDesktopRez)
 	{
 		config.set("width", m_window->getWidth());
 		config.set("height", m_window->getHeight());
@@ -268,7 +263,7 @@ Error App::initInternal(const ConfigSet& config_,
 
 	m_renderer = m_heapAlloc.newInstance<MainRenderer>();
 
-	ANKI_CHECK(m_renderer->create(m_threadpool,
+	ANKI_CHECK(m_renderer->create(m_threadHive,
 		m_resources,
 		m_gr,
 		m_allocCb,
@@ -286,7 +281,6 @@ Error App::initInternal(const ConfigSet& config_,
 
 	ANKI_CHECK(m_scene->init(m_allocCb,
 		m_allocCbData,
-		m_threadpool,
 		m_threadHive,
 		m_resources,
 		m_input,
@@ -319,15 +313,38 @@ Error App::initDirs()
 		ANKI_CHECK(createDirectory(m_settingsDir.toCString()));
 	}
 
-	// Cache
+	// Cache. It survives between runs unless the engine version changes
 	m_cacheDir.sprintf(m_heapAlloc, "%s/cache", &m_settingsDir[0]);
 
-	if(directoryExists(m_cacheDir.toCString()))
+	StringAuto version(m_heapAlloc);
+	version.sprintf("%u.%u", ANKI_VERSION_MAJOR, ANKI_VERSION_MINOR);
+
+	StringAuto versionFname(m_heapAlloc);
+	versionFname.sprintf("%s/version", &m_cacheDir[0]);
+
+	Bool valid = false;
+	if(fileExists(versionFname.toCString()))
 	{
-		ANKI_CHECK(removeDirectory(m_cacheDir.toCString()));
+		File file;
+		StringAuto cachedVersion(m_heapAlloc);
+		ANKI_CHECK(file.open(versionFname.toCString(), File::OpenFlag::READ));
+		ANKI_CHECK(file.readAllText(cachedVersion));
+		valid = cachedVersion == version;
 	}
 
-	ANKI_CHECK(createDirectory(m_cacheDir.toCString()));
+	if(!valid)
+	{
+		if(directoryExists(m_cacheDir.toCString()))
+		{
+			ANKI_CHECK(removeDirectory(m_cacheDir.toCString()));
+		}
+
+		ANKI_CHECK(createDirectory(m_cacheDir.toCString()));
+
+		File file;
+		ANKI_CHECK(file.open(versionFname.toCString(), File::OpenFlag::WRITE));
+		ANKI_CHECK(file.writeText("%s", &version[0]));
+	}
 #else
 	// ANKI_ASSERT(gAndroidApp);
 	// ANativeActivity* activity = gAndroidApp->activity;
@@ -381,9 +398,9 @@ Error App::mainLoop()
 
 		ANKI_CHECK(m_renderer->render(*m_scene));
 
-		// Pause and sync async loader. That will force all tasks before the
-		// pause to finish in this frame.
-		m_resources->getAsyncLoader().pause();
+		// Keep the uploads out of the frame switch. That waits only for the
+		// running upload, the rest of the loading continues
+		m_resources->getAsyncLoader().syncUploads();
 
 		m_gr->swapBuffers();
 
@@ -394,8 +411,8 @@ Error App::mainLoop()
 			asyncTaskCount - m_resourceCompletedAsyncTaskCount);
 		m_resourceCompletedAsyncTaskCount = asyncTaskCount;
 
-		// Now resume the loader
-		m_resources->getAsyncLoader().resume();
+		// Now give the uploads the budget of the new frame
+		m_resources->getAsyncLoader().newFrame();
 
 		// Sleep
 		timer.stop();
@@ -65,6 +65,9 @@ Config::Config()
 	newOption("tessellation", true);
 	newOption("clusterSizeZ", 32);
 	newOption("imageReflectionMaxDistance", 30.0);
+	newOption("occlusionRasterizerWidth", 256);
+	newOption("occlusionRasterizerHeight", 144);
+	newOption("sceneSpatialIndex", 0); // 0: sectors & portals, 1: dynamic tree
 
 	//
 	// GR
@@ -75,12 +78,17 @@ Config::Config()
 	newOption("gr.transferPerFrameMemorySize", 1024 * 1024 * 1);
 	newOption(
 		"gr.transferPersistentMemorySize", (4096 / 4) * (4096 / 4) * 16 * 4);
+	newOption("gr.diskShaderCache", true);
 
 	//
 	// Resource
 	//
 	newOption("maxTextureSize", 1024 * 1024);
 	newOption("textureAnisotropy", 8);
+	newOption("geometryPoolVertexMemorySize", 1024 * 1024 * 64);
+	newOption("geometryPoolIndexMemorySize", 1024 * 1024 * 16);
+	newOption("asyncLoaderThreadCount", 2);
+	newOption("asyncLoaderUploadBudgetPerFrame", 1024 * 1024 * 4);
 	newOption("dataPaths", ".");
 
 	//
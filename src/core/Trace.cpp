@@ -23,8 +23,10 @@ static Array<const char*, U(TraceEventType::COUNT)> eventNames = {
 		"SCENE_VISIBILITY_TESTS",
 		"VIS_TEST",
 		"VIS_COMBINE_RESULTS",
+		"VIS_MERGE_RESULTS",
 		"VIS_ITERATE_SECTORS",
 		"VIS_GATHER_TRIANGLES",
+		"VIS_BIN_TRIANGLES",
 		"VIS_RASTERIZE",
 		"VIS_RASTERIZER_TEST",
 		"RENDER",
@@ -47,6 +49,10 @@ static Array<const char*, U(TraceCounterType::COUNT)> counterNames = {
 	{"GR_DRAWCALLS",
 		"GR_DYNAMIC_UNIFORMS_SIZE",
 		"GR_DYNAMIC_STORAGE_SIZE",
+		"GR_TRANSIENT_UNIFORM_HIGH_WATER",
+		"GR_TRANSIENT_STORAGE_HIGH_WATER",
+		"GR_TRANSIENT_VERTEX_HIGH_WATER",
+		"GR_TRANSIENT_TRANSFER_HIGH_WATER",
 		"GR_VERTICES",
 		"GR_PIPELINES_CREATED",
 		"GR_PIPELINE_BINDS_SKIPPED",
@@ -54,9 +60,13 @@ static Array<const char*, U(TraceCounterType::COUNT)> counterNames = {
 		"RENDERER_LIGHTS",
 		"RENDERER_SHADOW_PASSES",
 		"RENDERER_MERGED_DRAWCALLS",
+		"RENDERER_BATCHED_DRAWCALLS",
 		"RENDERER_REFLECTIONS",
 		"RESOURCE_ASYNC_TASKS",
-		"SCENE_NODES_UPDATED"}};
+		"SCENE_NODES_UPDATED",
+		"SCENE_MEMORY",
+		"SCENE_FRAME_MEMORY",
+		"SCENE_ALLOCATOR_LOCK_CONTENTION"}};
 
 #define ANKI_TRACE_FILE_ERROR()                                                \
 	if(err)                                                                    \
@@ -85,14 +85,18 @@ Error GpuBlockAllocator::allocate(PtrSize size, U alignment, PtrSize& outOffset)
 
 	LockGuard<Mutex> lock(m_mtx);
 
-	if(m_currentBlock == MAX_U32
-		|| !blockHasEnoughSpace(m_currentBlock, size, alignment))
+	if(m_currentBlock != MAX_U32
+		&& blockHasEnoughSpace(m_currentBlock, size, alignment))
+	{
+		block = &m_blocks[m_currentBlock];
+	}
+	else
 	{
 		// Need new block
 		if(m_freeBlockCount > 0)
 		{
 			// Pop block from free
-			U blockIdx = --m_freeBlockCount;
+			U blockIdx = m_freeBlocksStack[--m_freeBlockCount];
 
 			block = &m_blocks[blockIdx];
 			block->m_offset = blockIdx * m_blockSize;
@@ -105,15 +109,12 @@ Error GpuBlockAllocator::allocate(PtrSize size, U alignment, PtrSize& outOffset)
 
 	if(block)
 	{
-		PtrSize outOffset = getAlignedRoundUp(alignment, block->m_offset);
+		outOffset = getAlignedRoundUp(alignment, block->m_offset);
 		block->m_offset = outOffset + size;
 		ANKI_ASSERT(
 			block->m_offset <= (block - &m_blocks[0] + 1) * m_blockSize);
 
 		++block->m_allocationCount;
-
-		// Update the handle
-		outOffset = outOffset;
 	}
 	else
 	{
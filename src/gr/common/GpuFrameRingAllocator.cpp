@@ -9,11 +9,43 @@ namespace anki
 {
 
 //==============================================================================
-void GpuFrameRingAllocator::init(
-	PtrSize size, U32 alignment, PtrSize maxAllocationSize)
+// Misc                                                                        =
+//==============================================================================
+
+/// The sub-block that a thread allocates from.
+class GpuFrameRingThreadCache
+{
+public:
+	U64 m_allocatorUuid;
+	U64 m_frame;
+	PtrSize m_offset;
+	PtrSize m_end;
+	U32 m_page;
+};
+
+/// The caches are indexed with the UUID of the allocator. There are a few
+/// allocators per GrManager so they rarely collide.
+static const U THREAD_CACHE_COUNT = 8;
+thread_local GpuFrameRingThreadCache g_threadCaches[THREAD_CACHE_COUNT];
+
+static Atomic<U64> g_allocatorUuid = {1};
+
+static const PtrSize MAX_SUB_BLOCK_SIZE = 16 * 1024;
+
+//==============================================================================
+// GpuFrameRingAllocator                                                       =
+//==============================================================================
+
+//==============================================================================
+void GpuFrameRingAllocator::init(PtrSize size,
+	U32 alignment,
+	PtrSize maxAllocationSize,
+	GpuFrameRingAllocatorPageInterface* pageInterface)
 {
 	ANKI_ASSERT(!isCreated());
 	ANKI_ASSERT(size > 0 && alignment > 0 && maxAllocationSize > 0);
+	static_assert(PAGE_RELEASE_FRAME_COUNT >= MAX_FRAMES_IN_FLIGHT,
+		"The GPU may still use the page");
 
 	PtrSize perFrameSize = size / MAX_FRAMES_IN_FLIGHT;
 	alignRoundDown(alignment, perFrameSize);
@@ -21,6 +53,33 @@ void GpuFrameRingAllocator::init(
 
 	m_alignment = alignment;
 	m_maxAllocationSize = maxAllocationSize;
+	m_pageInterface = pageInterface;
+	m_uuid = g_allocatorUuid.fetchAdd(1);
+
+	// Make the sub-blocks small enough to not waste a lot of the frame
+	m_subBlockSize = min<PtrSize>(perFrameSize / 64, MAX_SUB_BLOCK_SIZE);
+	alignRoundDown(alignment, m_subBlockSize);
+	if(m_subBlockSize < alignment * 4)
+	{
+		m_subBlockSize = 0;
+	}
+}
+
+//==============================================================================
+void GpuFrameRingAllocator::destroy()
+{
+	for(U32 i = MAIN_PAGE + 1; i < MAX_PAGES; ++i)
+	{
+		OverflowPage& page = m_pages[i];
+		if(page.m_size)
+		{
+			m_pageInterface->destroyPage(i);
+			page = OverflowPage();
+			--m_overflowPageCount;
+		}
+	}
+
+	ANKI_ASSERT(m_overflowPageCount == 0);
 }
 
 //==============================================================================
@@ -28,7 +87,7 @@ PtrSize GpuFrameRingAllocator::endFrame()
 {
 	ANKI_ASSERT(isCreated());
 
-	PtrSize perFrameSize = m_size / MAX_FRAMES_IN_FLIGHT;
+	PtrSize perFrameSize = getPerFrameSize();
 
 	PtrSize crntFrameStartOffset =
 		perFrameSize * (m_frame % MAX_FRAMES_IN_FLIGHT);
@@ -43,63 +102,193 @@ PtrSize GpuFrameRingAllocator::endFrame()
 	PtrSize bytesNotUsed =
 		(bytesUsed > perFrameSize) ? 0 : perFrameSize - bytesUsed;
 
+	// Statistics
+	m_highWaterMark = max(m_highWaterMark, m_frameUsedSize.exchange(0));
+
 	++m_frame;
+	m_activePage = MAIN_PAGE;
+	m_framePageCount = 0;
+
+	// Release the overflow pages that were quiet for a while
+	for(U32 i = MAIN_PAGE + 1; i < MAX_PAGES; ++i)
+	{
+		OverflowPage& page = m_pages[i];
+		if(page.m_size
+			&& m_frame - page.m_lastUsedFrame > PAGE_RELEASE_FRAME_COUNT)
+		{
+			m_pageInterface->destroyPage(i);
+			page = OverflowPage();
+			--m_overflowPageCount;
+		}
+	}
+
 	return bytesNotUsed;
 }
 
 //==============================================================================
-Error GpuFrameRingAllocator::allocate(PtrSize originalSize, PtrSize& outOffset)
+Error GpuFrameRingAllocator::allocate(
+	PtrSize originalSize, PtrSize& outOffset, U32& outPage)
 {
 	ANKI_ASSERT(isCreated());
 	ANKI_ASSERT(originalSize > 0);
-	Error err = ErrorCode::NONE;
 
 	// Align size
 	PtrSize size = getAlignedRoundUp(m_alignment, originalSize);
 	ANKI_ASSERT(size <= m_maxAllocationSize && "Too high!");
 
+	if(m_subBlockSize == 0 || size > m_subBlockSize / 4)
+	{
+		return allocateShared(size, outOffset, outPage);
+	}
+
+	// Small allocation, bump the sub-block of the thread
+	GpuFrameRingThreadCache& cache =
+		g_threadCaches[m_uuid % THREAD_CACHE_COUNT];
+	if(cache.m_allocatorUuid != m_uuid || cache.m_frame != m_frame
+		|| cache.m_offset + size > cache.m_end)
+	{
+		PtrSize offset;
+		U32 page;
+		Error err = allocateShared(m_subBlockSize, offset, page);
+		if(err)
+		{
+			outOffset = MAX_PTR_SIZE;
+			return err;
+		}
+
+		cache.m_allocatorUuid = m_uuid;
+		cache.m_frame = m_frame;
+		cache.m_offset = offset;
+		cache.m_end = offset + m_subBlockSize;
+		cache.m_page = page;
+	}
+
+	ANKI_ASSERT(isAligned(m_alignment, cache.m_offset));
+	outOffset = cache.m_offset;
+	outPage = cache.m_page;
+	cache.m_offset += size;
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error GpuFrameRingAllocator::allocateShared(
+	PtrSize size, PtrSize& outOffset, U32& outPage)
+{
 	PtrSize offset = m_offset.fetchAdd(size);
-	PtrSize perFrameSize = m_size / MAX_FRAMES_IN_FLIGHT;
+	PtrSize perFrameSize = getPerFrameSize();
 	PtrSize crntFrameStartOffset =
 		perFrameSize * (m_frame % MAX_FRAMES_IN_FLIGHT);
 
+	Error err = ErrorCode::NONE;
 	if(offset - crntFrameStartOffset + size <= perFrameSize)
 	{
 		ANKI_ASSERT(isAligned(m_alignment, offset));
 		ANKI_ASSERT((offset + size) <= m_size);
 
-#if ANKI_ENABLE_TRACE
-		m_lastAllocatedSize.store(size);
-#endif
-
-		// Encode token
 		outOffset = offset;
+		outPage = MAIN_PAGE;
+	}
+	else
+	{
+		// The slice of the frame is full, go to the slow path
+		LockGuard<Mutex> lock(m_pageMtx);
+		err = allocateFromOverflowPage(size, outOffset, outPage);
+	}
 
-		ANKI_ASSERT(outOffset + originalSize <= m_size);
+	if(!err)
+	{
+		m_frameUsedSize.fetchAdd(size);
 	}
 	else
 	{
 		outOffset = MAX_PTR_SIZE;
-		err = ErrorCode::OUT_OF_MEMORY;
 	}
 
 	return err;
 }
 
 //==============================================================================
-#if ANKI_ENABLE_TRACE
+Error GpuFrameRingAllocator::allocateFromOverflowPage(
+	PtrSize size, PtrSize& outOffset, U32& outPage)
+{
+	if(m_pageInterface == nullptr)
+	{
+		return ErrorCode::OUT_OF_MEMORY;
+	}
+
+	// Try the page that the frame is filling
+	U32 pageIdx = m_activePage;
+	ANKI_ASSERT(pageIdx < MAX_PAGES);
+	if(pageIdx == MAIN_PAGE || pageIdx >= MAX_PAGES
+		|| m_pages[pageIdx].m_offset + size > m_pages[pageIdx].m_size)
+	{
+		// Find a page that the GPU is done with or a free slot
+		U32 reuseIdx = MAX_PAGES;
+		U32 freeSlot = MAX_PAGES;
+		for(U32 i = MAIN_PAGE + 1; i < MAX_PAGES; ++i)
+		{
+			const OverflowPage& page = m_pages[i];
+			if(page.m_size == 0)
+			{
+				freeSlot = min(freeSlot, i);
+			}
+			else if(page.m_size >= size
+				&& page.m_lastUsedFrame + MAX_FRAMES_IN_FLIGHT <= m_frame)
+			{
+				reuseIdx = i;
+				break;
+			}
+		}
+
+		if(reuseIdx < MAX_PAGES)
+		{
+			pageIdx = reuseIdx;
+		}
+		else if(freeSlot < MAX_PAGES)
+		{
+			// Create a new one. Every page that the frame chains is bigger so
+			// a very busy frame doesn't need too many of them
+			const U32 shift = min<U32>(m_framePageCount, 4);
+			const PtrSize pageSize = max(getPerFrameSize() << shift, size);
+			ANKI_CHECK(m_pageInterface->createPage(freeSlot, pageSize));
+
+			m_pages[freeSlot].m_size = pageSize;
+			++m_overflowPageCount;
+			pageIdx = freeSlot;
+		}
+		else
+		{
+			ANKI_LOGE("Reached the max number of overflow pages");
+			return ErrorCode::OUT_OF_MEMORY;
+		}
+
+		m_pages[pageIdx].m_offset = 0;
+		m_activePage = pageIdx;
+		++m_framePageCount;
+	}
+
+	OverflowPage& page = m_pages[pageIdx];
+	ANKI_ASSERT(page.m_offset + size <= page.m_size);
+	outOffset = page.m_offset;
+	outPage = pageIdx;
+	page.m_offset += size;
+	page.m_lastUsedFrame = m_frame;
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
 PtrSize GpuFrameRingAllocator::getUnallocatedMemorySize() const
 {
-	PtrSize perFrameSize = m_size / MAX_FRAMES_IN_FLIGHT;
+	PtrSize perFrameSize = getPerFrameSize();
 	PtrSize crntFrameStartOffset =
 		perFrameSize * (m_frame % MAX_FRAMES_IN_FLIGHT);
-	PtrSize usedSize =
-		m_offset.get() - crntFrameStartOffset + m_lastAllocatedSize.get();
+	PtrSize usedSize = m_offset.load() - crntFrameStartOffset;
 
 	PtrSize remaining =
 		(perFrameSize >= usedSize) ? (perFrameSize - usedSize) : 0;
 	return remaining;
 }
-#endif
 
-} // end namespace anki
\ No newline at end of file
+} // end namespace anki
@@ -0,0 +1,236 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/common/ShaderCache.h>
+#include <anki/util/File.h>
+#include <anki/util/Filesystem.h>
+#include <anki/util/Hash.h>
+#include <anki/util/Logger.h>
+
+namespace anki
+{
+
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+/// Bump it when the layout of the blobs changes.
+static const U32 BLOB_VERSION = 1;
+
+static const Array<char, 8> BLOB_MAGIC = {
+	{'A', 'N', 'K', 'I', 'S', 'H', 'C', 0}};
+
+/// The header of every blob file.
+class ShaderCacheBlobHeader
+{
+public:
+	Array<char, 8> m_magic;
+	U32 m_version;
+	U32 m_padding;
+	U64 m_backendHash;
+	U64 m_key;
+	U64 m_dataSize;
+	U64 m_dataHash;
+};
+
+static_assert(sizeof(ShaderCacheBlobHeader) == 48, "Wrong size");
+
+/// Write a file through a temporary so readers never see half of it.
+static Error writeFileAtomically(const CString& filename,
+	const CString& tmpFilename,
+	const void* header,
+	PtrSize headerSize,
+	const void* data,
+	PtrSize dataSize)
+{
+	{
+		File file;
+		ANKI_CHECK(file.open(
+			tmpFilename, File::OpenFlag::WRITE | File::OpenFlag::BINARY));
+		ANKI_CHECK(file.write(const_cast<void*>(header), headerSize));
+		if(dataSize)
+		{
+			ANKI_CHECK(file.write(const_cast<void*>(data), dataSize));
+		}
+	}
+
+	return renameFile(tmpFilename, filename);
+}
+
+//==============================================================================
+// ShaderCache                                                                 =
+//==============================================================================
+
+//==============================================================================
+Error ShaderCache::init(GenericMemoryPoolAllocator<U8> alloc,
+	const CString& cacheDir,
+	U64 backendHash)
+{
+	ANKI_ASSERT(!isEnabled());
+	ANKI_ASSERT(!cacheDir.isEmpty());
+	m_alloc = alloc;
+	m_backendHash =
+		appendHash(&BLOB_VERSION, sizeof(BLOB_VERSION), backendHash);
+
+	StringAuto dir(alloc);
+	dir.sprintf("%s/shaders", &cacheDir[0]);
+
+	// The backend file holds the hash of the backend that wrote the blobs
+	StringAuto backendFname(alloc);
+	backendFname.sprintf("%s/backend", &dir[0]);
+
+	Bool valid = false;
+	if(fileExists(backendFname.toCString()))
+	{
+		File file;
+		U64 hash = 0;
+		ANKI_CHECK(file.open(backendFname.toCString(),
+			File::OpenFlag::READ | File::OpenFlag::BINARY));
+		if(file.getSize() == sizeof(hash))
+		{
+			ANKI_CHECK(file.read(&hash, sizeof(hash)));
+			valid = hash == m_backendHash;
+		}
+	}
+
+	if(!valid)
+	{
+		if(directoryExists(dir.toCString()))
+		{
+			ANKI_LOGI("The backend changed. Dropping the shader cache");
+			ANKI_CHECK(removeDirectory(dir.toCString()));
+		}
+
+		ANKI_CHECK(createDirectory(dir.toCString()));
+
+		StringAuto tmpFname(alloc);
+		tmpFname.sprintf("%s.tmp", &backendFname[0]);
+		ANKI_CHECK(writeFileAtomically(backendFname.toCString(),
+			tmpFname.toCString(),
+			&m_backendHash,
+			sizeof(m_backendHash),
+			nullptr,
+			0));
+	}
+
+	m_dir.create(alloc, dir.toCString());
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void ShaderCache::destroy()
+{
+	m_dir.destroy(m_alloc);
+}
+
+//==============================================================================
+U64 ShaderCache::computeKey(const void* data, PtrSize size) const
+{
+	ANKI_ASSERT(data && size > 0 && size <= MAX_U32);
+	return appendHash(data, size, m_backendHash);
+}
+
+//==============================================================================
+void ShaderCache::getBlobFilename(U64 key, StringAuto& out) const
+{
+	out.sprintf("%s/%016llx.bin",
+		&m_dir[0],
+		static_cast<unsigned long long>(key));
+}
+
+//==============================================================================
+Error ShaderCache::load(U64 key, DynamicArrayAuto<U8>& blob, Bool& found) const
+{
+	found = false;
+	if(!isEnabled())
+	{
+		return ErrorCode::NONE;
+	}
+
+	StringAuto fname(m_alloc);
+	getBlobFilename(key, fname);
+
+	if(!fileExists(fname.toCString()))
+	{
+		m_misses.fetchAdd(1);
+		return ErrorCode::NONE;
+	}
+
+	File file;
+	ANKI_CHECK(file.open(
+		fname.toCString(), File::OpenFlag::READ | File::OpenFlag::BINARY));
+
+	// Validate the header
+	ShaderCacheBlobHeader header;
+	const PtrSize fileSize = file.getSize();
+	if(fileSize >= sizeof(header))
+	{
+		ANKI_CHECK(file.read(&header, sizeof(header)));
+	}
+
+	if(fileSize < sizeof(header)
+		|| memcmp(&header.m_magic[0], &BLOB_MAGIC[0], sizeof(BLOB_MAGIC)) != 0
+		|| header.m_version != BLOB_VERSION
+		|| header.m_backendHash != m_backendHash
+		|| header.m_key != key
+		|| header.m_dataSize == 0
+		|| header.m_dataSize != fileSize - sizeof(header))
+	{
+		ANKI_LOGW("Ignoring a malformed shader cache blob: %s", &fname[0]);
+		m_misses.fetchAdd(1);
+		return ErrorCode::NONE;
+	}
+
+	// Read and validate the data
+	blob.create(header.m_dataSize);
+	ANKI_CHECK(file.read(&blob[0], header.m_dataSize));
+
+	if(computeHash(&blob[0], header.m_dataSize) != header.m_dataHash)
+	{
+		ANKI_LOGW("Ignoring a corrupted shader cache blob: %s", &fname[0]);
+		m_misses.fetchAdd(1);
+		return ErrorCode::NONE;
+	}
+
+	found = true;
+	m_hits.fetchAdd(1);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error ShaderCache::store(U64 key, const void* data, PtrSize size)
+{
+	ANKI_ASSERT(data && size > 0 && size <= MAX_U32);
+	if(!isEnabled())
+	{
+		return ErrorCode::NONE;
+	}
+
+	ShaderCacheBlobHeader header;
+	memcpy(&header.m_magic[0], &BLOB_MAGIC[0], sizeof(BLOB_MAGIC));
+	header.m_version = BLOB_VERSION;
+	header.m_padding = 0;
+	header.m_backendHash = m_backendHash;
+	header.m_key = key;
+	header.m_dataSize = size;
+	header.m_dataHash = computeHash(data, size);
+
+	StringAuto fname(m_alloc);
+	getBlobFilename(key, fname);
+
+	// Every store gets its own temporary since more than one thread may write
+	// the same key
+	StringAuto tmpFname(m_alloc);
+	tmpFname.sprintf("%s.%u.tmp", &fname[0], m_tmpFileCount.fetchAdd(1));
+
+	return writeFileAtomically(fname.toCString(),
+		tmpFname.toCString(),
+		&header,
+		sizeof(header),
+		data,
+		size);
+}
+
+} // end namespace anki
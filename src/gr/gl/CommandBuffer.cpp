@@ -12,13 +12,9 @@
 #include <anki/gr/gl/TransientMemoryManager.h>
 
 #include <anki/gr/Pipeline.h>
-#include <anki/gr/gl/PipelineImpl.h>
 #include <anki/gr/ResourceGroup.h>
-#include <anki/gr/gl/ResourceGroupImpl.h>
 #include <anki/gr/Framebuffer.h>
-#include <anki/gr/gl/FramebufferImpl.h>
 #include <anki/gr/OcclusionQuery.h>
-#include <anki/gr/gl/OcclusionQueryImpl.h>
 #include <anki/gr/Texture.h>
 #include <anki/gr/gl/TextureImpl.h>
 #include <anki/gr/Buffer.h>
@@ -85,140 +81,27 @@ void CommandBuffer::finish()
 }
 
 //==============================================================================
-class ViewportCommand final : public GlCommand
-{
-public:
-	Array<U16, 4> m_value;
-
-	ViewportCommand(U16 a, U16 b, U16 c, U16 d)
-	{
-		m_value = {{a, b, c, d}};
-	}
-
-	Error operator()(GlState& state)
-	{
-		if(state.m_viewport[0] != m_value[0]
-			|| state.m_viewport[1] != m_value[1]
-			|| state.m_viewport[2] != m_value[2]
-			|| state.m_viewport[3] != m_value[3])
-		{
-			glViewport(m_value[0], m_value[1], m_value[2], m_value[3]);
-
-			state.m_viewport = m_value;
-		}
-
-		return ErrorCode::NONE;
-	}
-};
-
 void CommandBuffer::setViewport(U16 minx, U16 miny, U16 maxx, U16 maxy)
 {
-#if ANKI_ASSERTS_ENABLED
-	m_impl->m_dbg.m_viewport = true;
-#endif
-	m_impl->pushBackNewCommand<ViewportCommand>(minx, miny, maxx, maxy);
+	m_impl->setViewport(minx, miny, maxx, maxy);
 }
 
 //==============================================================================
-class SetPolygonOffsetCommand final : public GlCommand
-{
-public:
-	F32 m_factor;
-	F32 m_units;
-
-	SetPolygonOffsetCommand(F32 factor, F32 units)
-		: m_factor(factor)
-		, m_units(units)
-	{
-	}
-
-	Error operator()(GlState& state)
-	{
-		if(m_factor == 0.0 && m_units == 0.0)
-		{
-			glDisable(GL_POLYGON_OFFSET_FILL);
-		}
-		else
-		{
-			glEnable(GL_POLYGON_OFFSET_FILL);
-			glPolygonOffset(m_factor, m_units);
-		}
-
-		return ErrorCode::NONE;
-	}
-};
-
 void CommandBuffer::setPolygonOffset(F32 factor, F32 units)
 {
-#if ANKI_ASSERTS_ENABLED
-	m_impl->m_dbg.m_polygonOffset = true;
-#endif
-	m_impl->pushBackNewCommand<SetPolygonOffsetCommand>(factor, units);
+	m_impl->setPolygonOffset(factor, units);
 }
 
 //==============================================================================
-class BindPipelineCommand final : public GlCommand
-{
-public:
-	PipelinePtr m_ppline;
-
-	BindPipelineCommand(PipelinePtr& ppline)
-		: m_ppline(ppline)
-	{
-	}
-
-	Error operator()(GlState& state)
-	{
-		if(state.m_lastPplineBoundUuid != m_ppline->getUuid())
-		{
-			ANKI_TRACE_START_EVENT(GL_BIND_PPLINE);
-
-			PipelineImpl& impl = m_ppline->getImplementation();
-			impl.bind(state);
-			state.m_lastPplineBoundUuid = m_ppline->getUuid();
-			ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_HAPPENED, 1);
-
-			ANKI_TRACE_STOP_EVENT(GL_BIND_PPLINE);
-		}
-		else
-		{
-			ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_SKIPPED, 1);
-		}
-
-		return ErrorCode::NONE;
-	}
-};
-
 void CommandBuffer::bindPipeline(PipelinePtr ppline)
 {
-	m_impl->pushBackNewCommand<BindPipelineCommand>(ppline);
+	m_impl->bindPipeline(ppline);
 }
 
 //==============================================================================
-class BindFramebufferCommand final : public GlCommand
-{
-public:
-	FramebufferPtr m_fb;
-
-	BindFramebufferCommand(FramebufferPtr fb)
-		: m_fb(fb)
-	{
-	}
-
-	Error operator()(GlState& state)
-	{
-		m_fb->getImplementation().bind(state);
-		return ErrorCode::NONE;
-	}
-};
-
 void CommandBuffer::beginRenderPass(FramebufferPtr fb)
 {
-	ANKI_ASSERT(!m_impl->m_dbg.m_insideRenderPass);
-#if ANKI_ASSERTS_ENABLED
-	m_impl->m_dbg.m_insideRenderPass = true;
-#endif
-	m_impl->pushBackNewCommand<BindFramebufferCommand>(fb);
+	m_impl->beginRenderPass(fb);
 }
 
 //==============================================================================
@@ -256,6 +139,13 @@ void CommandBuffer::drawArrays(
 	m_impl->drawArrays(count, instanceCount, first, baseInstance);
 }
 
+//==============================================================================
+void CommandBuffer::drawElementsIndirect(
+	U32 drawCount, const TransientMemoryToken& token)
+{
+	m_impl->drawElementsIndirect(drawCount, token);
+}
+
 //==============================================================================
 void CommandBuffer::drawElementsConditional(OcclusionQueryPtr query,
 	U32 count,
@@ -287,49 +177,15 @@ void CommandBuffer::dispatchCompute(
 }
 
 //==============================================================================
-class OqBeginCommand final : public GlCommand
-{
-public:
-	OcclusionQueryPtr m_handle;
-
-	OqBeginCommand(const OcclusionQueryPtr& handle)
-		: m_handle(handle)
-	{
-	}
-
-	Error operator()(GlState&)
-	{
-		m_handle->getImplementation().begin();
-		return ErrorCode::NONE;
-	}
-};
-
 void CommandBuffer::beginOcclusionQuery(OcclusionQueryPtr query)
 {
-	m_impl->pushBackNewCommand<OqBeginCommand>(query);
+	m_impl->beginOcclusionQuery(query);
 }
 
 //==============================================================================
-class OqEndCommand final : public GlCommand
-{
-public:
-	OcclusionQueryPtr m_handle;
-
-	OqEndCommand(const OcclusionQueryPtr& handle)
-		: m_handle(handle)
-	{
-	}
-
-	Error operator()(GlState&)
-	{
-		m_handle->getImplementation().end();
-		return ErrorCode::NONE;
-	}
-};
-
 void CommandBuffer::endOcclusionQuery(OcclusionQueryPtr query)
 {
-	m_impl->pushBackNewCommand<OqEndCommand>(query);
+	m_impl->endOcclusionQuery(query);
 }
 
 //==============================================================================
@@ -464,28 +320,9 @@ CommandBufferInitHints CommandBuffer::computeInitHints() const
 }
 
 //==============================================================================
-class ExecCmdbCommand final : public GlCommand
-{
-public:
-	CommandBufferPtr m_cmdb;
-
-	ExecCmdbCommand(const CommandBufferPtr& cmdb)
-		: m_cmdb(cmdb)
-	{
-	}
-
-	Error operator()(GlState&)
-	{
-		ANKI_TRACE_START_EVENT(GL_2ND_LEVEL_CMD_BUFFER);
-		Error err = m_cmdb->getImplementation().executeAllCommands();
-		ANKI_TRACE_STOP_EVENT(GL_2ND_LEVEL_CMD_BUFFER);
-		return err;
-	}
-};
-
 void CommandBuffer::pushSecondLevelCommandBuffer(CommandBufferPtr cmdb)
 {
-	m_impl->pushBackNewCommand<ExecCmdbCommand>(cmdb);
+	m_impl->pushSecondLevelCommandBuffer(cmdb);
 }
 
 //==============================================================================
@@ -534,23 +371,6 @@ void CommandBuffer::copyTextureToTexture(TexturePtr src,
 }
 
 //==============================================================================
-class SetBufferMemBarrierCommand final : public GlCommand
-{
-public:
-	GLenum m_barrier;
-
-	SetBufferMemBarrierCommand(GLenum barrier)
-		: m_barrier(barrier)
-	{
-	}
-
-	Error operator()(GlState&)
-	{
-		glMemoryBarrier(m_barrier);
-		return ErrorCode::NONE;
-	}
-};
-
 void CommandBuffer::setBufferBarrier(
 	BufferPtr buff, BufferUsageBit prevUsage, BufferUsageBit nextUsage)
 {
@@ -596,7 +416,7 @@ void CommandBuffer::setBufferBarrier(
 #endif
 
 	ANKI_ASSERT(d != GL_NONE);
-	m_impl->pushBackNewCommand<SetBufferMemBarrierCommand>(d);
+	m_impl->setMemoryBarrier(d);
 }
 
 //==============================================================================
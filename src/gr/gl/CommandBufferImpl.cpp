@@ -7,9 +7,15 @@
 #include <anki/gr/GrManager.h>
 #include <anki/gr/gl/GrManagerImpl.h>
 #include <anki/gr/gl/GlState.h>
+#include <anki/gr/gl/TransientMemoryManager.h>
 #include <anki/gr/gl/Error.h>
 
+#include <anki/gr/Pipeline.h>
+#include <anki/gr/gl/PipelineImpl.h>
+#include <anki/gr/ResourceGroup.h>
 #include <anki/gr/gl/ResourceGroupImpl.h>
+#include <anki/gr/Framebuffer.h>
+#include <anki/gr/gl/FramebufferImpl.h>
 #include <anki/gr/OcclusionQuery.h>
 #include <anki/gr/gl/OcclusionQueryImpl.h>
 
@@ -20,17 +26,382 @@
 namespace anki
 {
 
+//==============================================================================
+// Commands                                                                    =
+//==============================================================================
+
+/// The size of CommandBufferImpl::CommandHeader in the stream.
+static const U COMMAND_HEADER_SIZE = 8;
+
+static Bool viewportsEqual(const Array<U16, 4>& a, const Array<U16, 4>& b)
+{
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+class ViewportCommand
+{
+public:
+	Array<U16, 4> m_value;
+};
+
+class PolygonOffsetCommand
+{
+public:
+	F32 m_factor;
+	F32 m_units;
+};
+
+class BindPipelineCommand
+{
+public:
+	PipelinePtr m_ppline;
+};
+
+class BindFramebufferCommand
+{
+public:
+	FramebufferPtr m_fb;
+};
+
+/// If m_hasTransientInfo is true a TransientMemoryInfo follows.
+class BindResourceGroupCommand
+{
+public:
+	ResourceGroupPtr m_rc;
+	U8 m_slot;
+	Bool8 m_hasTransientInfo;
+};
+
+class DrawElementsCommand
+{
+public:
+	DrawElementsIndirectInfo m_info;
+};
+
+class DrawArraysCommand
+{
+public:
+	DrawArraysIndirectInfo m_info;
+};
+
+/// The drawcalls are in a transient buffer.
+class DrawElementsIndirectCommand
+{
+public:
+	GLuint m_buff;
+	U32 m_drawCount;
+	PtrSize m_offset;
+};
+
+class DrawElementsConditionalCommand
+{
+public:
+	DrawElementsIndirectInfo m_info;
+	OcclusionQueryPtr m_query;
+};
+
+class DrawArraysConditionalCommand
+{
+public:
+	DrawArraysIndirectInfo m_info;
+	OcclusionQueryPtr m_query;
+};
+
+class DispatchCommand
+{
+public:
+	Array<U32, 3> m_size;
+};
+
+class OcclusionQueryCommand
+{
+public:
+	OcclusionQueryPtr m_query;
+};
+
+class PushSecondLevelCommand
+{
+public:
+	CommandBufferPtr m_cmdb;
+};
+
+class MemoryBarrierCommand
+{
+public:
+	GLenum m_barrier;
+};
+
+//==============================================================================
+static void drawElements(GlState& state, const DrawElementsIndirectInfo& info)
+{
+	GLenum indicesType = 0;
+	switch(state.m_indexSize)
+	{
+	case 2:
+		indicesType = GL_UNSIGNED_SHORT;
+		break;
+	case 4:
+		indicesType = GL_UNSIGNED_INT;
+		break;
+	default:
+		ANKI_ASSERT(0);
+		break;
+	};
+
+	state.flushVertexState();
+
+	glDrawElementsInstancedBaseVertexBaseInstance(state.m_topology,
+		info.m_count,
+		indicesType,
+		(const void*)(PtrSize)(info.m_firstIndex * state.m_indexSize),
+		info.m_instanceCount,
+		info.m_baseVertex,
+		info.m_baseInstance);
+
+	ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, 1);
+	ANKI_TRACE_INC_COUNTER(GR_VERTICES, info.m_instanceCount * info.m_count);
+}
+
+//==============================================================================
+static void drawElementsIndirect(
+	GlState& state, const DrawElementsIndirectCommand& cmd)
+{
+	const GLenum indicesType =
+		(state.m_indexSize == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	ANKI_ASSERT(state.m_indexSize == 2 || state.m_indexSize == 4);
+
+	state.flushVertexState();
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cmd.m_buff);
+	glMultiDrawElementsIndirect(state.m_topology,
+		indicesType,
+		numberToPtr<const void*>(cmd.m_offset),
+		cmd.m_drawCount,
+		sizeof(DrawElementsIndirectInfo));
+
+	ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, cmd.m_drawCount);
+}
+
+//==============================================================================
+static void drawArrays(GlState& state, const DrawArraysIndirectInfo& info)
+{
+	state.flushVertexState();
+
+	glDrawArraysInstancedBaseInstance(state.m_topology,
+		info.m_first,
+		info.m_count,
+		info.m_instanceCount,
+		info.m_baseInstance);
+
+	ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, 1);
+}
+
+//==============================================================================
+static Error executeCommand(GlCommandType type, void* payload, GlState& state)
+{
+	Error err = ErrorCode::NONE;
+
+	switch(type)
+	{
+	case GlCommandType::VIEWPORT:
+	{
+		const ViewportCommand& cmd = *static_cast<ViewportCommand*>(payload);
+		if(!viewportsEqual(state.m_viewport, cmd.m_value))
+		{
+			glViewport(
+				cmd.m_value[0], cmd.m_value[1], cmd.m_value[2], cmd.m_value[3]);
+			state.m_viewport = cmd.m_value;
+		}
+		break;
+	}
+	case GlCommandType::POLYGON_OFFSET:
+	{
+		const PolygonOffsetCommand& cmd =
+			*static_cast<PolygonOffsetCommand*>(payload);
+		if(cmd.m_factor == 0.0 && cmd.m_units == 0.0)
+		{
+			glDisable(GL_POLYGON_OFFSET_FILL);
+		}
+		else
+		{
+			glEnable(GL_POLYGON_OFFSET_FILL);
+			glPolygonOffset(cmd.m_factor, cmd.m_units);
+		}
+		break;
+	}
+	case GlCommandType::BIND_PIPELINE:
+	{
+		BindPipelineCommand& cmd = *static_cast<BindPipelineCommand*>(payload);
+		if(state.m_lastPplineBoundUuid != cmd.m_ppline->getUuid())
+		{
+			ANKI_TRACE_START_EVENT(GL_BIND_PPLINE);
+
+			cmd.m_ppline->getImplementation().bind(state);
+			state.m_lastPplineBoundUuid = cmd.m_ppline->getUuid();
+			ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_HAPPENED, 1);
+
+			ANKI_TRACE_STOP_EVENT(GL_BIND_PPLINE);
+		}
+		else
+		{
+			ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_SKIPPED, 1);
+		}
+		break;
+	}
+	case GlCommandType::BIND_FRAMEBUFFER:
+	{
+		BindFramebufferCommand& cmd =
+			*static_cast<BindFramebufferCommand*>(payload);
+		cmd.m_fb->getImplementation().bind(state);
+		break;
+	}
+	case GlCommandType::BIND_RESOURCE_GROUP:
+	{
+		static const TransientMemoryInfo NO_TRANSIENT_INFO;
+
+		BindResourceGroupCommand& cmd =
+			*static_cast<BindResourceGroupCommand*>(payload);
+		const TransientMemoryInfo* info = &NO_TRANSIENT_INFO;
+		if(cmd.m_hasTransientInfo)
+		{
+			info = reinterpret_cast<const TransientMemoryInfo*>(&cmd + 1);
+		}
+
+		ANKI_TRACE_START_EVENT(GL_BIND_RESOURCES);
+		cmd.m_rc->getImplementation().bind(cmd.m_slot, *info, state);
+		ANKI_TRACE_STOP_EVENT(GL_BIND_RESOURCES);
+		break;
+	}
+	case GlCommandType::DRAW_ELEMENTS:
+		drawElements(state, static_cast<DrawElementsCommand*>(payload)->m_info);
+		break;
+	case GlCommandType::DRAW_ARRAYS:
+		drawArrays(state, static_cast<DrawArraysCommand*>(payload)->m_info);
+		break;
+	case GlCommandType::DRAW_ELEMENTS_INDIRECT:
+		drawElementsIndirect(
+			state, *static_cast<DrawElementsIndirectCommand*>(payload));
+		break;
+	case GlCommandType::DRAW_ELEMENTS_CONDITIONAL:
+	{
+		DrawElementsConditionalCommand& cmd =
+			*static_cast<DrawElementsConditionalCommand*>(payload);
+		if(!cmd.m_query.isCreated()
+			|| !cmd.m_query->getImplementation().skipDrawcall())
+		{
+			drawElements(state, cmd.m_info);
+		}
+		break;
+	}
+	case GlCommandType::DRAW_ARRAYS_CONDITIONAL:
+	{
+		DrawArraysConditionalCommand& cmd =
+			*static_cast<DrawArraysConditionalCommand*>(payload);
+		if(!cmd.m_query.isCreated()
+			|| !cmd.m_query->getImplementation().skipDrawcall())
+		{
+			drawArrays(state, cmd.m_info);
+		}
+		break;
+	}
+	case GlCommandType::DISPATCH:
+	{
+		const DispatchCommand& cmd = *static_cast<DispatchCommand*>(payload);
+		glDispatchCompute(cmd.m_size[0], cmd.m_size[1], cmd.m_size[2]);
+		break;
+	}
+	case GlCommandType::BEGIN_OCCLUSION_QUERY:
+		static_cast<OcclusionQueryCommand*>(payload)
+			->m_query->getImplementation()
+			.begin();
+		break;
+	case GlCommandType::END_OCCLUSION_QUERY:
+		static_cast<OcclusionQueryCommand*>(payload)
+			->m_query->getImplementation()
+			.end();
+		break;
+	case GlCommandType::PUSH_SECOND_LEVEL:
+	{
+		PushSecondLevelCommand& cmd =
+			*static_cast<PushSecondLevelCommand*>(payload);
+		ANKI_TRACE_START_EVENT(GL_2ND_LEVEL_CMD_BUFFER);
+		err = cmd.m_cmdb->getImplementation().executeAllCommands();
+		ANKI_TRACE_STOP_EVENT(GL_2ND_LEVEL_CMD_BUFFER);
+		break;
+	}
+	case GlCommandType::MEMORY_BARRIER:
+		glMemoryBarrier(static_cast<MemoryBarrierCommand*>(payload)->m_barrier);
+		break;
+	case GlCommandType::GENERIC:
+		err = (*static_cast<GlCommand*>(payload))(state);
+		break;
+	default:
+		ANKI_ASSERT(0);
+	}
+
+	return err;
+}
+
+//==============================================================================
+template<typename T>
+static void callDestructor(void* payload)
+{
+	static_cast<T*>(payload)->~T();
+}
+
+//==============================================================================
+static void destroyCommand(GlCommandType type, void* payload)
+{
+	switch(type)
+	{
+	case GlCommandType::BIND_PIPELINE:
+		callDestructor<BindPipelineCommand>(payload);
+		break;
+	case GlCommandType::BIND_FRAMEBUFFER:
+		callDestructor<BindFramebufferCommand>(payload);
+		break;
+	case GlCommandType::BIND_RESOURCE_GROUP:
+		callDestructor<BindResourceGroupCommand>(payload);
+		break;
+	case GlCommandType::DRAW_ELEMENTS_CONDITIONAL:
+		callDestructor<DrawElementsConditionalCommand>(payload);
+		break;
+	case GlCommandType::DRAW_ARRAYS_CONDITIONAL:
+		callDestructor<DrawArraysConditionalCommand>(payload);
+		break;
+	case GlCommandType::BEGIN_OCCLUSION_QUERY:
+	case GlCommandType::END_OCCLUSION_QUERY:
+		callDestructor<OcclusionQueryCommand>(payload);
+		break;
+	case GlCommandType::PUSH_SECOND_LEVEL:
+		callDestructor<PushSecondLevelCommand>(payload);
+		break;
+	case GlCommandType::GENERIC:
+		callDestructor<GlCommand>(payload);
+		break;
+	default:
+		// The rest are PODs
+		break;
+	}
+}
+
+//==============================================================================
+// CommandBufferImpl                                                           =
+//==============================================================================
+
 //==============================================================================
 void CommandBufferImpl::init(const CommandBufferInitInfo& init)
 {
 	auto& pool = m_manager->getAllocator().getMemoryPool();
 
-	m_alloc = CommandBufferAllocator<GlCommand*>(pool.getAllocationCallback(),
+	m_alloc = CommandBufferAllocator<U8>(pool.getAllocationCallback(),
 		pool.getAllocationCallbackUserData(),
 		init.m_hints.m_chunkSize,
 		1.0,
 		0,
 		false);
+
+	resetRecordState();
 }
 
 //==============================================================================
@@ -39,21 +410,33 @@ void CommandBufferImpl::destroy()
 	ANKI_TRACE_START_EVENT(GL_CMD_BUFFER_DESTROY);
 
 #if ANKI_DEBUG
-	if(!m_executed && m_firstCommand)
+	if(!m_executed && m_commandCount)
 	{
 		ANKI_LOGW("Chain contains commands but never executed. "
 				  "This should only happen on exceptions");
 	}
 #endif
 
-	GlCommand* command = m_firstCommand;
-	while(command != nullptr)
+	Chunk* chunk = m_firstChunk;
+	while(chunk != nullptr)
 	{
-		GlCommand* next = command->m_nextCommand; // Get next before deleting
-		m_alloc.deleteInstance(command);
-		command = next;
+		U8* it = reinterpret_cast<U8*>(chunk + 1);
+		U8* end = it + chunk->m_size;
+		while(it < end)
+		{
+			const CommandHeader& header =
+				*reinterpret_cast<const CommandHeader*>(it);
+			destroyCommand(header.m_type, it + COMMAND_HEADER_SIZE);
+			it += header.m_size;
+		}
+
+		// The memory goes away with the allocator
+		chunk = chunk->m_next;
 	}
 
+	m_firstChunk = m_lastChunk = nullptr;
+	m_commandCount = 0;
+
 	ANKI_ASSERT(m_alloc.getMemoryPool().getUsersCount() == 1
 		&& "Someone is holding a reference to the command buffer's allocator");
 
@@ -62,11 +445,71 @@ void CommandBufferImpl::destroy()
 	ANKI_TRACE_STOP_EVENT(GL_CMD_BUFFER_DESTROY);
 }
 
+//==============================================================================
+void* CommandBufferImpl::newCommand(GlCommandType type, PtrSize payloadSize)
+{
+	static_assert(sizeof(CommandHeader) <= COMMAND_HEADER_SIZE, "See file");
+	static_assert(sizeof(Chunk) % COMMAND_ALIGNMENT == 0, "See file");
+	ANKI_ASSERT(!m_immutable);
+
+	const U32 size = getAlignedRoundUp(
+		COMMAND_ALIGNMENT, COMMAND_HEADER_SIZE + U32(payloadSize));
+
+	// Grow the stream. Every chunk is double the size of the previous
+	if(m_lastChunk == nullptr
+		|| m_lastChunk->m_size + size > m_lastChunk->m_capacity)
+	{
+		U32 capacity = (m_lastChunk) ? min<U32>(m_lastChunk->m_capacity * 2,
+										   MAX_CHUNK_SIZE)
+									 : MIN_CHUNK_SIZE;
+		capacity = max(capacity, size);
+
+		Chunk* chunk = static_cast<Chunk*>(m_alloc.getMemoryPool().allocate(
+			sizeof(Chunk) + capacity, COMMAND_ALIGNMENT));
+		chunk->m_next = nullptr;
+		chunk->m_size = 0;
+		chunk->m_capacity = capacity;
+
+		if(m_lastChunk)
+		{
+			m_lastChunk->m_next = chunk;
+		}
+		else
+		{
+			m_firstChunk = chunk;
+		}
+
+		m_lastChunk = chunk;
+	}
+
+	U8* mem = reinterpret_cast<U8*>(m_lastChunk + 1) + m_lastChunk->m_size;
+	m_lastChunk->m_size += size;
+	++m_commandCount;
+
+	CommandHeader& header = *reinterpret_cast<CommandHeader*>(mem);
+	header.m_size = size;
+	header.m_type = type;
+
+	return mem + COMMAND_HEADER_SIZE;
+}
+
+//==============================================================================
+void CommandBufferImpl::resetRecordState()
+{
+	m_recState.m_pplineUuid = MAX_U64;
+	for(U64& uuid : m_recState.m_rcUuids)
+	{
+		uuid = MAX_U64;
+	}
+
+	m_recState.m_viewportSet = false;
+	m_recState.m_polygonOffsetSet = false;
+}
+
 //==============================================================================
 Error CommandBufferImpl::executeAllCommands()
 {
-	ANKI_ASSERT(m_firstCommand != nullptr && "Empty command buffer");
-	ANKI_ASSERT(m_lastCommand != nullptr && "Empty command buffer");
+	ANKI_ASSERT(m_commandCount > 0 && "Empty command buffer");
 #if ANKI_DEBUG
 	m_executed = true;
 #endif
@@ -74,14 +517,21 @@ Error CommandBufferImpl::executeAllCommands()
 	Error err = ErrorCode::NONE;
 	GlState& state = m_manager->getImplementation().getState();
 
-	GlCommand* command = m_firstCommand;
-
-	while(command != nullptr && !err)
+	for(Chunk* chunk = m_firstChunk; chunk != nullptr && !err;
+		chunk = chunk->m_next)
 	{
-		err = (*command)(state);
-		ANKI_CHECK_GL_ERROR();
+		U8* it = reinterpret_cast<U8*>(chunk + 1);
+		U8* end = it + chunk->m_size;
+		while(it < end && !err)
+		{
+			const CommandHeader& header =
+				*reinterpret_cast<const CommandHeader*>(it);
+			err = executeCommand(
+				header.m_type, it + COMMAND_HEADER_SIZE, state);
+			ANKI_CHECK_GL_ERROR();
 
-		command = command->m_nextCommand;
+			it += header.m_size;
+		}
 	}
 
 	return err;
@@ -103,147 +553,149 @@ GrAllocator<U8> CommandBufferImpl::getAllocator() const
 }
 
 //==============================================================================
-class BindResourcesCommand final : public GlCommand
+void CommandBufferImpl::setViewport(U16 minx, U16 miny, U16 maxx, U16 maxy)
 {
-public:
-	ResourceGroupPtr m_rc;
-	TransientMemoryInfo m_info;
-	U8 m_slot;
+#if ANKI_ASSERTS_ENABLED
+	m_dbg.m_viewport = true;
+#endif
 
-	BindResourcesCommand(
-		ResourceGroupPtr rc, U8 slot, const TransientMemoryInfo* info)
-		: m_rc(rc)
-		, m_slot(slot)
+	const Array<U16, 4> value = {{minx, miny, maxx, maxy}};
+	if(m_recState.m_viewportSet && viewportsEqual(m_recState.m_viewport, value))
 	{
-		if(info)
-		{
-			m_info = *info;
-		}
+		return;
 	}
 
-	Error operator()(GlState& state)
+	m_recState.m_viewport = value;
+	m_recState.m_viewportSet = true;
+	newCommand<ViewportCommand>(GlCommandType::VIEWPORT)->m_value = value;
+}
+
+//==============================================================================
+void CommandBufferImpl::setPolygonOffset(F32 factor, F32 units)
+{
+#if ANKI_ASSERTS_ENABLED
+	m_dbg.m_polygonOffset = true;
+#endif
+
+	if(m_recState.m_polygonOffsetSet
+		&& m_recState.m_polygonOffsetFactor == factor
+		&& m_recState.m_polygonOffsetUnits == units)
 	{
-		ANKI_TRACE_START_EVENT(GL_BIND_RESOURCES);
-		m_rc->getImplementation().bind(m_slot, m_info, state);
-		ANKI_TRACE_STOP_EVENT(GL_BIND_RESOURCES);
-		return ErrorCode::NONE;
+		return;
 	}
-};
 
-void CommandBufferImpl::bindResourceGroup(
-	ResourceGroupPtr rc, U slot, const TransientMemoryInfo* info)
-{
-	ANKI_ASSERT(rc.isCreated());
+	m_recState.m_polygonOffsetFactor = factor;
+	m_recState.m_polygonOffsetUnits = units;
+	m_recState.m_polygonOffsetSet = true;
 
-	pushBackNewCommand<BindResourcesCommand>(rc, slot, info);
+	PolygonOffsetCommand* cmd =
+		newCommand<PolygonOffsetCommand>(GlCommandType::POLYGON_OFFSET);
+	cmd->m_factor = factor;
+	cmd->m_units = units;
 }
 
 //==============================================================================
-class DrawElementsCondCommand : public GlCommand
+void CommandBufferImpl::bindPipeline(PipelinePtr ppline)
 {
-public:
-	DrawElementsIndirectInfo m_info;
-	OcclusionQueryPtr m_query;
+	ANKI_ASSERT(ppline.isCreated());
 
-	DrawElementsCondCommand(const DrawElementsIndirectInfo& info,
-		OcclusionQueryPtr query = OcclusionQueryPtr())
-		: m_info(info)
-		, m_query(query)
+	if(m_recState.m_pplineUuid == ppline->getUuid())
 	{
+		ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_SKIPPED, 1);
+		return;
 	}
 
-	Error operator()(GlState& state)
-	{
-		GLenum indicesType = 0;
-		switch(state.m_indexSize)
-		{
-		case 2:
-			indicesType = GL_UNSIGNED_SHORT;
-			break;
-		case 4:
-			indicesType = GL_UNSIGNED_INT;
-			break;
-		default:
-			ANKI_ASSERT(0);
-			break;
-		};
-
-		if(!m_query.isCreated() || !m_query->getImplementation().skipDrawcall())
-		{
-			state.flushVertexState();
-
-			glDrawElementsInstancedBaseVertexBaseInstance(state.m_topology,
-				m_info.m_count,
-				indicesType,
-				(const void*)(PtrSize)(m_info.m_firstIndex * state.m_indexSize),
-				m_info.m_instanceCount,
-				m_info.m_baseVertex,
-				m_info.m_baseInstance);
-
-			ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, 1);
-			ANKI_TRACE_INC_COUNTER(
-				GR_VERTICES, m_info.m_instanceCount * m_info.m_count);
-		}
-
-		return ErrorCode::NONE;
-	}
-};
+	m_recState.m_pplineUuid = ppline->getUuid();
+	::new(newCommand<BindPipelineCommand>(GlCommandType::BIND_PIPELINE))
+		BindPipelineCommand{ppline};
+}
 
-void CommandBufferImpl::drawElements(U32 count,
-	U32 instanceCount,
-	U32 firstIndex,
-	U32 baseVertex,
-	U32 baseInstance)
+//==============================================================================
+void CommandBufferImpl::beginRenderPass(FramebufferPtr fb)
 {
-	ANKI_ASSERT(m_dbg.m_insideRenderPass);
-	DrawElementsIndirectInfo info(
-		count, instanceCount, firstIndex, baseVertex, baseInstance);
+	ANKI_ASSERT(!m_dbg.m_insideRenderPass);
+#if ANKI_ASSERTS_ENABLED
+	m_dbg.m_insideRenderPass = true;
+#endif
 
-	checkDrawcall();
-	pushBackNewCommand<DrawElementsCondCommand>(info);
+	::new(newCommand<BindFramebufferCommand>(GlCommandType::BIND_FRAMEBUFFER))
+		BindFramebufferCommand{fb};
 }
 
 //==============================================================================
-class DrawArraysCondCommand final : public GlCommand
+void CommandBufferImpl::bindResourceGroup(
+	ResourceGroupPtr rc, U slot, const TransientMemoryInfo* info)
 {
-public:
-	DrawArraysIndirectInfo m_info;
-	OcclusionQueryPtr m_query;
+	ANKI_ASSERT(rc.isCreated());
+	ANKI_ASSERT(slot < MAX_BOUND_RESOURCE_GROUPS);
 
-	DrawArraysCondCommand(const DrawArraysIndirectInfo& info,
-		OcclusionQueryPtr query = OcclusionQueryPtr())
-		: m_info(info)
-		, m_query(query)
+	// The transient memory changes every time so it can't be skipped
+	if(info == nullptr && m_recState.m_rcUuids[slot] == rc->getUuid())
 	{
+		return;
 	}
 
-	Error operator()(GlState& state)
-	{
-		if(!m_query.isCreated() || !m_query->getImplementation().skipDrawcall())
-		{
-			state.flushVertexState();
-
-			glDrawArraysInstancedBaseInstance(state.m_topology,
-				m_info.m_first,
-				m_info.m_count,
-				m_info.m_instanceCount,
-				m_info.m_baseInstance);
+	m_recState.m_rcUuids[slot] = (info) ? MAX_U64 : rc->getUuid();
 
-			ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, 1);
-		}
+	// Inline the transient info after the command
+	static_assert(sizeof(BindResourceGroupCommand) % COMMAND_ALIGNMENT == 0,
+		"The TransientMemoryInfo should be aligned");
+	const PtrSize size = sizeof(BindResourceGroupCommand)
+		+ ((info) ? sizeof(TransientMemoryInfo) : 0);
+	BindResourceGroupCommand* cmd = ::new(
+		newCommand(GlCommandType::BIND_RESOURCE_GROUP, size))
+		BindResourceGroupCommand{rc, U8(slot), info != nullptr};
 
-		return ErrorCode::NONE;
+	if(info)
+	{
+		memcpy(cmd + 1, info, sizeof(*info));
 	}
-};
+}
+
+//==============================================================================
+void CommandBufferImpl::drawElements(U32 count,
+	U32 instanceCount,
+	U32 firstIndex,
+	U32 baseVertex,
+	U32 baseInstance)
+{
+	ANKI_ASSERT(m_dbg.m_insideRenderPass);
+	checkDrawcall();
+
+	::new(newCommand<DrawElementsCommand>(GlCommandType::DRAW_ELEMENTS))
+		DrawElementsCommand{DrawElementsIndirectInfo(
+			count, instanceCount, firstIndex, baseVertex, baseInstance)};
+}
 
+//==============================================================================
 void CommandBufferImpl::drawArrays(
 	U32 count, U32 instanceCount, U32 first, U32 baseInstance)
 {
 	ANKI_ASSERT(m_dbg.m_insideRenderPass);
-	DrawArraysIndirectInfo info(count, instanceCount, first, baseInstance);
+	checkDrawcall();
+
+	::new(newCommand<DrawArraysCommand>(GlCommandType::DRAW_ARRAYS))
+		DrawArraysCommand{
+			DrawArraysIndirectInfo(count, instanceCount, first, baseInstance)};
+}
 
+//==============================================================================
+void CommandBufferImpl::drawElementsIndirect(
+	U32 drawCount, const TransientMemoryToken& token)
+{
+	ANKI_ASSERT(m_dbg.m_insideRenderPass);
+	ANKI_ASSERT(drawCount > 0);
+	ANKI_ASSERT(
+		drawCount * sizeof(DrawElementsIndirectInfo) <= token.m_range);
 	checkDrawcall();
-	pushBackNewCommand<DrawArraysCondCommand>(info);
+
+	const GLuint name = m_manager->getImplementation()
+							.getTransientMemoryManager()
+							.getGlName(token);
+
+	::new(newCommand<DrawElementsIndirectCommand>(
+		GlCommandType::DRAW_ELEMENTS_INDIRECT))
+		DrawElementsIndirectCommand{name, drawCount, token.m_offset};
 }
 
 //==============================================================================
@@ -255,11 +707,14 @@ void CommandBufferImpl::drawElementsConditional(OcclusionQueryPtr query,
 	U32 baseInstance)
 {
 	ANKI_ASSERT(m_dbg.m_insideRenderPass);
-	DrawElementsIndirectInfo info(
-		count, instanceCount, firstIndex, baseVertex, baseInstance);
-
 	checkDrawcall();
-	pushBackNewCommand<DrawElementsCondCommand>(info, query);
+
+	::new(newCommand<DrawElementsConditionalCommand>(
+		GlCommandType::DRAW_ELEMENTS_CONDITIONAL))
+		DrawElementsConditionalCommand{
+			DrawElementsIndirectInfo(
+				count, instanceCount, firstIndex, baseVertex, baseInstance),
+			query};
 }
 
 //==============================================================================
@@ -270,35 +725,54 @@ void CommandBufferImpl::drawArraysConditional(OcclusionQueryPtr query,
 	U32 baseInstance)
 {
 	ANKI_ASSERT(m_dbg.m_insideRenderPass);
-	DrawArraysIndirectInfo info(count, instanceCount, first, baseInstance);
-
 	checkDrawcall();
-	pushBackNewCommand<DrawArraysCondCommand>(info, query);
+
+	::new(newCommand<DrawArraysConditionalCommand>(
+		GlCommandType::DRAW_ARRAYS_CONDITIONAL))
+		DrawArraysConditionalCommand{
+			DrawArraysIndirectInfo(count, instanceCount, first, baseInstance),
+			query};
 }
 
 //==============================================================================
-class DispatchCommand final : public GlCommand
+void CommandBufferImpl::dispatchCompute(
+	U32 groupCountX, U32 groupCountY, U32 groupCountZ)
 {
-public:
-	Array<U32, 3> m_size;
+	ANKI_ASSERT(!m_dbg.m_insideRenderPass);
 
-	DispatchCommand(U32 x, U32 y, U32 z)
-		: m_size({{x, y, z}})
-	{
-	}
+	newCommand<DispatchCommand>(GlCommandType::DISPATCH)->m_size = {
+		{groupCountX, groupCountY, groupCountZ}};
+}
 
-	Error operator()(GlState&)
-	{
-		glDispatchCompute(m_size[0], m_size[1], m_size[2]);
-		return ErrorCode::NONE;
-	}
-};
+//==============================================================================
+void CommandBufferImpl::beginOcclusionQuery(OcclusionQueryPtr query)
+{
+	::new(newCommand<OcclusionQueryCommand>(
+		GlCommandType::BEGIN_OCCLUSION_QUERY)) OcclusionQueryCommand{query};
+}
 
-void CommandBufferImpl::dispatchCompute(
-	U32 groupCountX, U32 groupCountY, U32 groupCountZ)
+//==============================================================================
+void CommandBufferImpl::endOcclusionQuery(OcclusionQueryPtr query)
 {
-	ANKI_ASSERT(!m_dbg.m_insideRenderPass);
-	pushBackNewCommand<DispatchCommand>(groupCountX, groupCountY, groupCountZ);
+	::new(newCommand<OcclusionQueryCommand>(
+		GlCommandType::END_OCCLUSION_QUERY)) OcclusionQueryCommand{query};
+}
+
+//==============================================================================
+void CommandBufferImpl::pushSecondLevelCommandBuffer(CommandBufferPtr cmdb)
+{
+	::new(newCommand<PushSecondLevelCommand>(GlCommandType::PUSH_SECOND_LEVEL))
+		PushSecondLevelCommand{cmdb};
+
+	// The second level changed the state behind our back
+	resetRecordState();
+}
+
+//==============================================================================
+void CommandBufferImpl::setMemoryBarrier(GLenum barrier)
+{
+	newCommand<MemoryBarrierCommand>(GlCommandType::MEMORY_BARRIER)->m_barrier =
+		barrier;
 }
 
 } // end namespace anki
@@ -112,6 +112,11 @@ void GlState::initRenderThread()
 		m_gpu = GpuVendor::NVIDIA;
 	}
 
+#if ANKI_GL == ANKI_GL_DESKTOP
+	m_shaderDrawParameters =
+		m_version >= 460 || GLEW_ARB_shader_draw_parameters;
+#endif
+
 // Enable debug messages
 #if ANKI_GL == ANKI_GL_DESKTOP
 	if(m_registerMessages)
@@ -5,6 +5,7 @@
 
 #include <anki/gr/GrManager.h>
 #include <anki/gr/gl/GrManagerImpl.h>
+#include <anki/gr/gl/GlState.h>
 #include <anki/gr/gl/RenderingThread.h>
 #include <anki/gr/gl/TransientMemoryManager.h>
 #include <anki/core/Timestamp.h>
@@ -71,4 +72,10 @@ void* GrManager::allocateFrameTransientMemory(
 	return data;
 }
 
+//==============================================================================
+Bool GrManager::getBaseInstanceSupported() const
+{
+	return m_impl->getState().m_shaderDrawParameters;
+}
+
 } // end namespace anki
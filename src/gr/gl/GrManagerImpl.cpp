@@ -8,6 +8,9 @@
 #include <anki/gr/gl/RenderingThread.h>
 #include <anki/gr/gl/GlState.h>
 #include <anki/gr/gl/TransientMemoryManager.h>
+#include <anki/core/Config.h>
+#include <anki/util/Hash.h>
+#include <anki/util/Logger.h>
 
 namespace anki
 {
@@ -27,6 +30,8 @@ GrManagerImpl::~GrManagerImpl()
 		m_manager->getAllocator().deleteInstance(m_state);
 	}
 
+	m_shaderCache.destroy();
+
 	destroyBackend();
 	m_manager = nullptr;
 }
@@ -43,6 +48,9 @@ Error GrManagerImpl::init(GrManagerInitInfo& init)
 	// Init the backend of the backend
 	ANKI_CHECK(createBackend(init));
 
+	m_diskShaderCache = init.m_config->getNumber("gr.diskShaderCache")
+		&& !init.m_cacheDirectory.isEmpty();
+
 	// First create the state
 	m_state = m_manager->getAllocator().newInstance<GlState>(m_manager);
 	m_state->initMainThread(*init.m_config);
@@ -50,7 +58,8 @@ Error GrManagerImpl::init(GrManagerInitInfo& init)
 	// Dyn manager
 	m_transManager =
 		m_manager->getAllocator().newInstance<TransientMemoryManager>();
-	m_transManager->initMainThread(m_manager->getAllocator(), *init.m_config);
+	m_transManager->initMainThread(
+		m_manager, m_manager->getAllocator(), *init.m_config);
 
 	// Create thread
 	m_thread =
@@ -63,4 +72,44 @@ Error GrManagerImpl::init(GrManagerInitInfo& init)
 	return ErrorCode::NONE;
 }
 
+//==============================================================================
+void GrManagerImpl::initShaderCacheRenderThread()
+{
+	if(!m_diskShaderCache)
+	{
+		return;
+	}
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if(formatCount == 0)
+	{
+		ANKI_LOGI("The driver doesn't support program binaries");
+		return;
+	}
+
+	// The binaries are valid only for the same driver
+	const U32 engineVersion = (ANKI_VERSION_MAJOR << 16) | ANKI_VERSION_MINOR;
+	U64 hash = computeHash(&engineVersion, sizeof(engineVersion));
+
+	const Array<GLenum, 3> strings = {{GL_VENDOR, GL_RENDERER, GL_VERSION}};
+	for(GLenum name : strings)
+	{
+		CString str = reinterpret_cast<const char*>(glGetString(name));
+		if(!str.isEmpty())
+		{
+			hash = appendHash(&str[0], str.getLength(), hash);
+		}
+	}
+
+	Error err = m_shaderCache.init(
+		getAllocator(), m_manager->getCacheDirectory(), hash);
+	if(err)
+	{
+		ANKI_LOGW("Failed to initialize the shader cache. Will continue "
+				  "without it");
+		m_shaderCache.destroy();
+	}
+}
+
 } // end namespace anki
@@ -6,6 +6,8 @@
 #include <anki/gr/gl/PipelineImpl.h>
 #include <anki/gr/gl/ShaderImpl.h>
 #include <anki/gr/gl/GlState.h>
+#include <anki/gr/GrManager.h>
+#include <anki/gr/gl/GrManagerImpl.h>
 #include <anki/util/Logger.h>
 #include <anki/util/Hash.h>
 
@@ -168,6 +170,29 @@ Error PipelineImpl::createGlPipeline()
 		}
 	}
 
+	m_tessellation = (mask & (1 << U(ShaderType::TESSELLATION_CONTROL))) != 0;
+
+	// Try the binary of a previous run first
+	ShaderCache& cache = m_manager->getImplementation().getShaderCache();
+	U64 key = 0;
+	if(cache.isEnabled())
+	{
+		Array<U64, 6> hashes;
+		for(U i = 0; i < m_in.m_shaders.getSize(); i++)
+		{
+			const ShaderPtr& shader = m_in.m_shaders[i];
+			hashes[i] = (shader.isCreated())
+				? shader->getImplementation().getSourceHash()
+				: 0;
+		}
+
+		key = cache.computeKey(&hashes[0], sizeof(hashes));
+		if(loadProgramBinary(cache, key))
+		{
+			return ErrorCode::NONE;
+		}
+	}
+
 	// Create and attach programs
 	m_glName = glCreateProgram();
 	ANKI_ASSERT(m_glName != 0);
@@ -178,16 +203,18 @@ Error PipelineImpl::createGlPipeline()
 
 		if(shader.isCreated())
 		{
-			glAttachShader(m_glName, shader->getImplementation().getGlName());
-
-			if(i == U(ShaderType::TESSELLATION_CONTROL)
-				|| i == U(ShaderType::TESSELLATION_EVALUATION))
-			{
-				m_tessellation = true;
-			}
+			ShaderImpl& impl = shader->getImplementation();
+			ANKI_CHECK(impl.compile());
+			glAttachShader(m_glName, impl.getGlName());
 		}
 	}
 
+	if(cache.isEnabled())
+	{
+		glProgramParameteri(
+			m_glName, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
 	// Validate and check error
 	glLinkProgram(m_glName);
 	GLint status = 0;
@@ -219,10 +246,76 @@ Error PipelineImpl::createGlPipeline()
 			&infoLogTxt[0]);
 		err = ErrorCode::USER_DATA;
 	}
+	else if(cache.isEnabled())
+	{
+		storeProgramBinary(cache, key);
+	}
 
 	return err;
 }
 
+//==============================================================================
+Bool PipelineImpl::loadProgramBinary(ShaderCache& cache, U64 key)
+{
+	ANKI_ASSERT(m_glName == 0);
+
+	DynamicArrayAuto<U8> blob(getAllocator());
+	Bool found = false;
+	Error err = cache.load(key, blob, found);
+	if(err || !found || blob.getSize() <= sizeof(U32))
+	{
+		return false;
+	}
+
+	// The blob is the binary format followed by the binary
+	U32 format;
+	memcpy(&format, &blob[0], sizeof(format));
+
+	m_glName = glCreateProgram();
+	ANKI_ASSERT(m_glName != 0);
+	glProgramBinary(m_glName,
+		format,
+		&blob[sizeof(format)],
+		blob.getSize() - sizeof(format));
+
+	// The driver can reject binaries even if they come from the same driver
+	GLint status = 0;
+	glGetProgramiv(m_glName, GL_LINK_STATUS, &status);
+	if(!status)
+	{
+		ANKI_LOGW("The driver rejected a cached program binary");
+		glDeleteProgram(m_glName);
+		m_glName = 0;
+		return false;
+	}
+
+	return true;
+}
+
+//==============================================================================
+void PipelineImpl::storeProgramBinary(ShaderCache& cache, U64 key)
+{
+	GLint size = 0;
+	glGetProgramiv(m_glName, GL_PROGRAM_BINARY_LENGTH, &size);
+	if(size <= 0)
+	{
+		return;
+	}
+
+	DynamicArrayAuto<U8> blob(getAllocator());
+	blob.create(sizeof(U32) + size);
+
+	GLenum format = 0;
+	glGetProgramBinary(m_glName, size, nullptr, &format, &blob[sizeof(U32)]);
+	const U32 format32 = format;
+	memcpy(&blob[0], &format32, sizeof(format32));
+
+	if(cache.store(key, &blob[0], blob.getSize()))
+	{
+		ANKI_LOGW("Failed to store a program binary in the shader cache");
+	}
+}
+
 //==============================================================================
 void PipelineImpl::bind(GlState& state)
 {
@@ -183,6 +183,8 @@ void RenderingThread::prepare()
 	m_manager->getImplementation()
 		.getTransientMemoryManager()
 		.initRenderThread();
+
+	m_manager->getImplementation().initShaderCacheRenderThread();
 }
 
 //==============================================================================
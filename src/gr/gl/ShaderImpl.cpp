@@ -5,8 +5,11 @@
 
 #include <anki/gr/gl/ShaderImpl.h>
 #include <anki/gr/GrManager.h>
+#include <anki/gr/gl/GrManagerImpl.h>
+#include <anki/gr/gl/GlState.h>
 #include <anki/util/StringList.h>
 #include <anki/util/Logger.h>
+#include <anki/util/Hash.h>
 
 #define ANKI_DUMP_SHADERS ANKI_DEBUG
 
@@ -31,8 +34,10 @@ static void deleteShaders(GLsizei n, const GLuint* names)
 }
 
 static const char* SHADER_HEADER = R"(#version %u %s
+%s
 #define ANKI_GL 1
 #define %s
+#define ANKI_INSTANCE_ID %s
 #define ANKI_UBO_BINDING(set_, binding_) binding = set_ * %u + binding_
 #define ANKI_SS_BINDING(set_, binding_) binding = set_ * %u + binding_
 #define ANKI_TEX_BINDING(set_, binding_) binding = set_ * %u + binding_
@@ -51,6 +56,7 @@ static const char* SHADER_HEADER = R"(#version %u %s
 ShaderImpl::~ShaderImpl()
 {
 	destroyDeferred(deleteShaders);
+	m_source.destroy(getAllocator());
 }
 
 //==============================================================================
@@ -94,17 +100,63 @@ Error ShaderImpl::init(ShaderType type, const CString& source)
 	static const char* versionType = "es";
 #endif
 
+	// The instance ID includes the baseInstance of the drawcall if possible
+	const GlState& state = m_manager->getImplementation().getState();
+	const char* extensions = "";
+	const char* instanceId = "gl_InstanceID";
+	if(type == ShaderType::VERTEX && state.m_shaderDrawParameters)
+	{
+		if(version >= 460)
+		{
+			instanceId = "(gl_BaseInstance + gl_InstanceID)";
+		}
+		else
+		{
+			extensions = "#extension GL_ARB_shader_draw_parameters : require";
+			instanceId = "(gl_BaseInstanceARB + gl_InstanceID)";
+		}
+	}
+
 	fullSrc.sprintf(SHADER_HEADER,
 		version,
 		versionType,
+		extensions,
 		shaderName[U(type)],
+		instanceId,
 		MAX_UNIFORM_BUFFER_BINDINGS,
 		MAX_STORAGE_BUFFER_BINDINGS,
 		MAX_TEXTURE_BINDINGS,
 		&source[0]);
 
-	// 2) Gen name, create, compile and link
+	m_sourceHash = computeHash(&fullSrc[0], fullSrc.getLength());
+	m_source.create(alloc, fullSrc.toCString());
+
+	// 2) Compile now if there are no program binaries to skip it
 	//
+	if(m_manager->getImplementation().getShaderCache().isEnabled())
+	{
+		return ErrorCode::NONE;
+	}
+
+	return compile();
+}
+
+//==============================================================================
+Error ShaderImpl::compile()
+{
+	if(m_compileFailed)
+	{
+		return ErrorCode::USER_DATA;
+	}
+	else if(isCreated())
+	{
+		return ErrorCode::NONE;
+	}
+
+	auto alloc = getAllocator();
+	const String& fullSrc = m_source;
+
+	// Gen name, create and compile
 	const char* sourceStrs[1] = {nullptr};
 	sourceStrs[0] = &fullSrc[0];
 	m_glName = glCreateShader(m_glType);
@@ -155,7 +207,6 @@ Error ShaderImpl::init(ShaderType type, const CString& source)
 	glGetShaderiv(m_glName, GL_COMPILE_STATUS, &status);
 	if(status == GL_FALSE)
 	{
-		auto alloc = getAllocator();
 		StringAuto compilerLog(alloc);
 		GLint compilerLogLen = 0;
 		GLint charsWritten = 0;
@@ -169,9 +220,11 @@ Error ShaderImpl::init(ShaderType type, const CString& source)
 		logShaderErrorCode(compilerLog.toCString(), fullSrc.toCString(), alloc);
 
 		// Compilation failed, set error anyway
+		m_compileFailed = true;
 		return ErrorCode::USER_DATA;
 	}
 
+	m_source.destroy(alloc);
 	return ErrorCode::NONE;
 }
 
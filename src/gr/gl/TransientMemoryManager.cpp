@@ -5,6 +5,7 @@
 
 #include <anki/gr/gl/TransientMemoryManager.h>
 #include <anki/gr/gl/Error.h>
+#include <anki/gr/GrManager.h>
 #include <anki/core/Config.h>
 #include <anki/core/Trace.h>
 
@@ -26,6 +27,11 @@ void TransientMemoryManager::destroyRenderThread()
 {
 	for(PerFrameBuffer& buff : m_perFrameBuffers)
 	{
+		if(buff.m_mappedMem)
+		{
+			buff.m_alloc.destroy();
+		}
+
 		if(buff.m_name != 0)
 		{
 			glDeleteBuffers(1, &buff.m_name);
@@ -37,11 +43,28 @@ void TransientMemoryManager::destroyRenderThread()
 }
 
 //==============================================================================
-void TransientMemoryManager::initMainThread(
-	GenericMemoryPoolAllocator<U8> alloc, const ConfigSet& cfg)
+void TransientMemoryManager::initMainThread(GrManager* manager,
+	GenericMemoryPoolAllocator<U8> alloc,
+	const ConfigSet& cfg)
 {
+	ANKI_ASSERT(manager);
+	m_manager = manager;
 	m_alloc = alloc;
 
+	Array<BufferUsageBit, U(TransientBufferType::COUNT)> usages = {
+		{BufferUsageBit::UNIFORM_ANY_SHADER,
+			BufferUsageBit::STORAGE_ANY | BufferUsageBit::INDIRECT,
+			BufferUsageBit::VERTEX,
+			BufferUsageBit::TRANSFER_SOURCE}};
+
+	for(TransientBufferType i = TransientBufferType::UNIFORM;
+		i < TransientBufferType::COUNT;
+		++i)
+	{
+		m_perFrameBuffers[i].m_manager = this;
+		m_perFrameBuffers[i].m_usage = usages[i];
+	}
+
 	m_perFrameBuffers[TransientBufferType::UNIFORM].m_size =
 		cfg.getNumber("gr.uniformPerFrameMemorySize");
 
@@ -77,7 +100,8 @@ void TransientMemoryManager::initRenderThread()
 		// Create the allocator
 		GLint64 blockAlignment;
 		glGetInteger64v(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &blockAlignment);
-		buff.m_alloc.init(size, blockAlignment, MAX_UNIFORM_BLOCK_SIZE);
+		buff.m_alloc.init(
+			size, blockAlignment, MAX_UNIFORM_BLOCK_SIZE, &buff);
 	}
 
 	// Storage
@@ -98,7 +122,8 @@ void TransientMemoryManager::initRenderThread()
 		GLint64 blockAlignment;
 		glGetInteger64v(
 			GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &blockAlignment);
-		buff.m_alloc.init(size, blockAlignment, MAX_STORAGE_BLOCK_SIZE);
+		buff.m_alloc.init(
+			size, blockAlignment, MAX_STORAGE_BLOCK_SIZE, &buff);
 	}
 
 	// Vertex
@@ -116,7 +141,7 @@ void TransientMemoryManager::initRenderThread()
 		ANKI_ASSERT(buff.m_mappedMem);
 
 		// Create the allocator
-		buff.m_alloc.init(size, 16, MAX_U32);
+		buff.m_alloc.init(size, 16, MAX_U32, &buff);
 	}
 
 	// Transfer
@@ -126,7 +151,7 @@ void TransientMemoryManager::initRenderThread()
 		buff.m_cpuBuff.create(m_alloc, size);
 
 		buff.m_mappedMem = reinterpret_cast<U8*>(&buff.m_cpuBuff[0]);
-		buff.m_alloc.init(size, 16, MAX_U32);
+		buff.m_alloc.init(size, 16, MAX_U32, &buff);
 	}
 }
 
@@ -145,8 +170,12 @@ void TransientMemoryManager::allocate(PtrSize size,
 	if(lifespan == TransientMemoryTokenLifetime::PER_FRAME)
 	{
 		PerFrameBuffer& buff = m_perFrameBuffers[bufferUsageToTransient(usage)];
-		err = buff.m_alloc.allocate(size, token.m_offset);
-		mappedMemBase = buff.m_mappedMem;
+		U32 page;
+		err = buff.m_alloc.allocate(size, token.m_offset, page);
+		token.m_page = page;
+		mappedMemBase = (page == GpuFrameRingAllocator::MAIN_PAGE)
+			? buff.m_mappedMem
+			: buff.m_pages[page].m_mappedMem;
 	}
 	else
 	{
@@ -197,8 +226,78 @@ void TransientMemoryManager::endFrame()
 			}
 
 			buff.m_alloc.endFrame();
+
+			const PtrSize highWater = buff.m_alloc.getHighWaterMark();
+			switch(usage)
+			{
+			case TransientBufferType::UNIFORM:
+				ANKI_TRACE_INC_COUNTER(
+					GR_TRANSIENT_UNIFORM_HIGH_WATER, highWater);
+				break;
+			case TransientBufferType::STORAGE:
+				ANKI_TRACE_INC_COUNTER(
+					GR_TRANSIENT_STORAGE_HIGH_WATER, highWater);
+				break;
+			case TransientBufferType::VERTEX:
+				ANKI_TRACE_INC_COUNTER(
+					GR_TRANSIENT_VERTEX_HIGH_WATER, highWater);
+				break;
+			default:
+				ANKI_TRACE_INC_COUNTER(
+					GR_TRANSIENT_TRANSFER_HIGH_WATER, highWater);
+				break;
+			}
+
+			(void)highWater;
 		}
 	}
 }
 
+//==============================================================================
+Error TransientMemoryManager::PerFrameBuffer::createPage(
+	U32 page, PtrSize size)
+{
+	OverflowPage& p = m_pages[page];
+
+	if(m_usage == BufferUsageBit::TRANSFER_SOURCE)
+	{
+		// Transfers read from CPU memory
+		p.m_cpuBuff.create(m_manager->m_alloc,
+			getAlignedRoundUp(sizeof(Aligned16Type), size)
+				/ sizeof(Aligned16Type));
+		p.m_mappedMem = reinterpret_cast<U8*>(&p.m_cpuBuff[0]);
+	}
+	else
+	{
+		// It's called from the client threads so create a Buffer that takes
+		// care of the synchronization with the server
+		p.m_buff = m_manager->m_manager->newInstance<Buffer>(
+			size, m_usage, BufferMapAccessBit::WRITE);
+		p.m_mappedMem = static_cast<U8*>(
+			p.m_buff->map(0, size, BufferMapAccessBit::WRITE));
+		if(!p.m_mappedMem)
+		{
+			p.m_buff = BufferPtr();
+			return ErrorCode::FUNCTION_FAILED;
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void TransientMemoryManager::PerFrameBuffer::destroyPage(U32 page)
+{
+	OverflowPage& p = m_pages[page];
+
+	if(p.m_buff.isCreated())
+	{
+		p.m_buff->unmap();
+		p.m_buff = BufferPtr();
+	}
+
+	p.m_cpuBuff.destroy(m_manager->m_alloc);
+	p.m_mappedMem = nullptr;
+}
+
 } // end namespace anki
@@ -0,0 +1,57 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/BufferImpl.h>
+#include <cstring>
+
+namespace anki
+{
+
+//==============================================================================
+BufferImpl::~BufferImpl()
+{
+	ANKI_ASSERT(!m_mapped);
+	m_storage.destroy(getAllocator());
+}
+
+//==============================================================================
+Error BufferImpl::init(
+	PtrSize size, BufferUsageBit usage, BufferMapAccessBit access)
+{
+	ANKI_ASSERT(!isCreated());
+	ANKI_ASSERT(size > 0);
+
+	m_storage.create(getAllocator(), size);
+	m_usage = usage;
+	m_access = access;
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void* BufferImpl::map(PtrSize offset, PtrSize range, BufferMapAccessBit access)
+{
+	ANKI_ASSERT(isCreated());
+	ANKI_ASSERT(offset + range <= getSize());
+	ANKI_ASSERT((access & m_access) != BufferMapAccessBit::NONE);
+	ANKI_ASSERT(!m_mapped);
+
+#if ANKI_ASSERTIONS
+	m_mapped = true;
+#endif
+
+	return &m_storage[offset];
+}
+
+//==============================================================================
+void BufferImpl::write(PtrSize offset, const void* data, PtrSize size)
+{
+	ANKI_ASSERT(isCreated());
+	ANKI_ASSERT(data && size > 0);
+	ANKI_ASSERT(offset + size <= getSize());
+	memcpy(&m_storage[offset], data, size);
+}
+
+} // end namespace anki
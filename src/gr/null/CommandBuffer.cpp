@@ -0,0 +1,561 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/CommandBuffer.h>
+#include <anki/gr/null/CommandBufferImpl.h>
+#include <anki/gr/null/GrManagerImpl.h>
+#include <anki/gr/null/BufferImpl.h>
+#include <anki/gr/null/TextureImpl.h>
+#include <anki/gr/null/PipelineImpl.h>
+#include <anki/gr/null/FramebufferImpl.h>
+#include <anki/gr/null/ResourceGroupImpl.h>
+#include <anki/gr/null/OcclusionQueryImpl.h>
+
+#include <anki/gr/Pipeline.h>
+#include <anki/gr/ResourceGroup.h>
+#include <anki/gr/OcclusionQuery.h>
+
+namespace anki
+{
+
+//==============================================================================
+CommandBuffer::CommandBuffer(GrManager* manager, U64 hash)
+	: GrObject(manager, CLASS_TYPE, hash)
+{
+}
+
+//==============================================================================
+CommandBuffer::~CommandBuffer()
+{
+}
+
+//==============================================================================
+void CommandBuffer::init(CommandBufferInitInfo& inf)
+{
+	m_impl.reset(getAllocator().newInstance<CommandBufferImpl>(&getManager()));
+	m_impl->init(inf);
+}
+
+//==============================================================================
+CommandBufferInitHints CommandBuffer::computeInitHints() const
+{
+	return m_impl->computeInitHints();
+}
+
+//==============================================================================
+void CommandBuffer::flush()
+{
+	m_impl->makeImmutable();
+	m_impl->getGrManagerImpl().flushCommandBuffer(CommandBufferPtr(this));
+}
+
+//==============================================================================
+void CommandBuffer::finish()
+{
+	// The commands run on flush so there is nothing to wait for
+	flush();
+}
+
+//==============================================================================
+class ViewportCommand final : public NullCommand
+{
+public:
+	Array<U16, 4> m_value;
+
+	ViewportCommand(U16 a, U16 b, U16 c, U16 d)
+		: m_value{{a, b, c, d}}
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		ANKI_ASSERT(m_value[0] <= m_value[2] && m_value[1] <= m_value[3]);
+		state.m_viewport = m_value;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::setViewport(U16 minx, U16 miny, U16 maxx, U16 maxy)
+{
+	m_impl->pushBackNewCommand<ViewportCommand>(minx, miny, maxx, maxy);
+}
+
+//==============================================================================
+class PolygonOffsetCommand final : public NullCommand
+{
+public:
+	F32 m_factor;
+	F32 m_units;
+
+	PolygonOffsetCommand(F32 factor, F32 units)
+		: m_factor(factor)
+		, m_units(units)
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		state.m_polygonOffsetFactor = m_factor;
+		state.m_polygonOffsetUnits = m_units;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::setPolygonOffset(F32 factor, F32 units)
+{
+	m_impl->pushBackNewCommand<PolygonOffsetCommand>(factor, units);
+}
+
+//==============================================================================
+class BindPipelineCommand final : public NullCommand
+{
+public:
+	PipelinePtr m_ppline;
+
+	BindPipelineCommand(PipelinePtr ppline)
+		: m_ppline(ppline)
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		state.m_ppline = &m_ppline->getImplementation();
+		++state.m_stats.m_pipelineBindCount;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::bindPipeline(PipelinePtr ppline)
+{
+	m_impl->pushBackNewCommand<BindPipelineCommand>(ppline);
+}
+
+//==============================================================================
+class BeginRenderPassCommand final : public NullCommand
+{
+public:
+	FramebufferPtr m_fb;
+
+	BeginRenderPassCommand(FramebufferPtr fb)
+		: m_fb(fb)
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		ANKI_ASSERT(state.m_fb == nullptr && "Already in a renderpass");
+		state.m_fb = &m_fb->getImplementation();
+		++state.m_stats.m_renderPassCount;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::beginRenderPass(FramebufferPtr fb)
+{
+	m_impl->pushBackNewCommand<BeginRenderPassCommand>(fb);
+}
+
+//==============================================================================
+class EndRenderPassCommand final : public NullCommand
+{
+public:
+	void operator()(NullState& state)
+	{
+		ANKI_ASSERT(state.m_fb != nullptr && "Not in a renderpass");
+		state.m_fb = nullptr;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::endRenderPass()
+{
+	m_impl->pushBackNewCommand<EndRenderPassCommand>();
+}
+
+//==============================================================================
+class BindResourceGroupCommand final : public NullCommand
+{
+public:
+	ResourceGroupPtr m_rc;
+	TransientMemoryInfo m_info;
+	U8 m_slot;
+	Bool8 m_hasInfo;
+
+	BindResourceGroupCommand(
+		ResourceGroupPtr rc, U8 slot, const TransientMemoryInfo* info)
+		: m_rc(rc)
+		, m_slot(slot)
+		, m_hasInfo(info != nullptr)
+	{
+		if(info)
+		{
+			m_info = *info;
+		}
+	}
+
+	void operator()(NullState& state)
+	{
+		ANKI_ASSERT(m_slot < MAX_BOUND_RESOURCE_GROUPS);
+		ANKI_ASSERT(m_rc->getImplementation().checkTransientMemoryInfo(
+			(m_hasInfo) ? &m_info : nullptr));
+		++state.m_stats.m_resourceGroupBindCount;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::bindResourceGroup(
+	ResourceGroupPtr rc, U slot, const TransientMemoryInfo* dynInfo)
+{
+	m_impl->pushBackNewCommand<BindResourceGroupCommand>(rc, slot, dynInfo);
+}
+
+//==============================================================================
+class DrawCommand final : public NullCommand
+{
+public:
+	OcclusionQueryPtr m_query;
+	U32 m_count;
+	U32 m_instanceCount;
+
+	DrawCommand(OcclusionQueryPtr query, U32 count, U32 instanceCount)
+		: m_query(query)
+		, m_count(count)
+		, m_instanceCount(instanceCount)
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		ANKI_ASSERT(state.m_ppline && !state.m_ppline->isCompute());
+
+		if(m_query.isCreated() && m_query->getImplementation().skipDrawcall())
+		{
+			return;
+		}
+
+		++state.m_stats.m_drawcallCount;
+		state.m_stats.m_instanceCount += m_instanceCount;
+		state.m_stats.m_vertexCount += U64(m_count) * m_instanceCount;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::drawElements(U32 count,
+	U32 instanceCount,
+	U32 firstIndex,
+	U32 baseVertex,
+	U32 baseInstance)
+{
+	m_impl->pushBackNewCommand<DrawCommand>(
+		OcclusionQueryPtr(), count, instanceCount);
+}
+
+//==============================================================================
+void CommandBuffer::drawArrays(
+	U32 count, U32 instanceCount, U32 first, U32 baseInstance)
+{
+	m_impl->pushBackNewCommand<DrawCommand>(
+		OcclusionQueryPtr(), count, instanceCount);
+}
+
+//==============================================================================
+class DrawIndirectCommand final : public NullCommand
+{
+public:
+	U32 m_drawCount;
+	TransientMemoryToken m_token;
+
+	DrawIndirectCommand(U32 drawCount, const TransientMemoryToken& token)
+		: m_drawCount(drawCount)
+		, m_token(token)
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		ANKI_ASSERT(state.m_ppline && !state.m_ppline->isCompute());
+		ANKI_ASSERT(
+			m_drawCount * sizeof(DrawElementsIndirectInfo) <= m_token.m_range);
+
+		const U8* data =
+			state.m_gr->getTransientMemoryManager().getBaseAddress(m_token);
+		const DrawElementsIndirectInfo* infos =
+			reinterpret_cast<const DrawElementsIndirectInfo*>(
+				data + m_token.m_offset);
+
+		for(U i = 0; i < m_drawCount; ++i)
+		{
+			const DrawElementsIndirectInfo& info = infos[i];
+			++state.m_stats.m_drawcallCount;
+			state.m_stats.m_instanceCount += info.m_instanceCount;
+			state.m_stats.m_vertexCount +=
+				U64(info.m_count) * info.m_instanceCount;
+		}
+	}
+};
+
+//==============================================================================
+void CommandBuffer::drawElementsIndirect(
+	U32 drawCount, const TransientMemoryToken& token)
+{
+	ANKI_ASSERT(drawCount > 0);
+	m_impl->pushBackNewCommand<DrawIndirectCommand>(drawCount, token);
+}
+
+//==============================================================================
+void CommandBuffer::drawElementsConditional(OcclusionQueryPtr query,
+	U32 count,
+	U32 instanceCount,
+	U32 firstIndex,
+	U32 baseVertex,
+	U32 baseInstance)
+{
+	m_impl->pushBackNewCommand<DrawCommand>(query, count, instanceCount);
+}
+
+//==============================================================================
+void CommandBuffer::drawArraysConditional(OcclusionQueryPtr query,
+	U32 count,
+	U32 instanceCount,
+	U32 first,
+	U32 baseInstance)
+{
+	m_impl->pushBackNewCommand<DrawCommand>(query, count, instanceCount);
+}
+
+//==============================================================================
+class DispatchCommand final : public NullCommand
+{
+public:
+	void operator()(NullState& state)
+	{
+		ANKI_ASSERT(state.m_ppline && state.m_ppline->isCompute());
+		++state.m_stats.m_dispatchCount;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::dispatchCompute(
+	U32 groupCountX, U32 groupCountY, U32 groupCountZ)
+{
+	ANKI_ASSERT(groupCountX > 0 && groupCountY > 0 && groupCountZ > 0);
+	m_impl->pushBackNewCommand<DispatchCommand>();
+}
+
+/// For the commands that only need to validate the texture surfaces.
+class TextureCommand final : public NullCommand
+{
+public:
+	Array<TexturePtr, 2> m_textures;
+	Array<TextureSurfaceInfo, 2> m_surfaces;
+
+	TextureCommand(TexturePtr tex,
+		const TextureSurfaceInfo& surf,
+		TexturePtr tex2 = TexturePtr(),
+		const TextureSurfaceInfo& surf2 = TextureSurfaceInfo())
+		: m_textures{{tex, tex2}}
+		, m_surfaces{{surf, surf2}}
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		for(U i = 0; i < m_textures.getSize(); ++i)
+		{
+			ANKI_ASSERT(!m_textures[i].isCreated()
+				|| m_textures[i]->getImplementation().isValidSurface(
+					   m_surfaces[i]));
+		}
+	}
+};
+
+//==============================================================================
+void CommandBuffer::generateMipmaps(TexturePtr tex, U depth, U face, U layer)
+{
+	m_impl->pushBackNewCommand<TextureCommand>(
+		tex, TextureSurfaceInfo(0, depth, face, layer));
+}
+
+//==============================================================================
+void CommandBuffer::copyTextureToTexture(TexturePtr src,
+	const TextureSurfaceInfo& srcSurf,
+	TexturePtr dest,
+	const TextureSurfaceInfo& destSurf)
+{
+	m_impl->pushBackNewCommand<TextureCommand>(src, srcSurf, dest, destSurf);
+}
+
+//==============================================================================
+void CommandBuffer::clearTexture(TexturePtr tex,
+	const TextureSurfaceInfo& surf,
+	const ClearValue& clearValue)
+{
+	m_impl->pushBackNewCommand<TextureCommand>(tex, surf);
+}
+
+//==============================================================================
+class UploadTextureCommand final : public NullCommand
+{
+public:
+	TexturePtr m_tex;
+	TextureSurfaceInfo m_surf;
+	TransientMemoryToken m_token;
+
+	UploadTextureCommand(TexturePtr tex,
+		const TextureSurfaceInfo& surf,
+		const TransientMemoryToken& token)
+		: m_tex(tex)
+		, m_surf(surf)
+		, m_token(token)
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		ANKI_ASSERT(m_tex->getImplementation().isValidSurface(m_surf));
+
+		// Touch the memory to check the token. The texels are not stored
+		const U8* data =
+			state.m_gr->getTransientMemoryManager().getBaseAddress(m_token);
+		(void)data;
+
+		state.m_stats.m_uploadedBytes += m_token.m_range;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::uploadTextureSurface(TexturePtr tex,
+	const TextureSurfaceInfo& surf,
+	const TransientMemoryToken& token)
+{
+	m_impl->pushBackNewCommand<UploadTextureCommand>(tex, surf, token);
+}
+
+//==============================================================================
+class UploadBufferCommand final : public NullCommand
+{
+public:
+	BufferPtr m_buff;
+	PtrSize m_offset;
+	TransientMemoryToken m_token;
+
+	UploadBufferCommand(
+		BufferPtr buff, PtrSize offset, const TransientMemoryToken& token)
+		: m_buff(buff)
+		, m_offset(offset)
+		, m_token(token)
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		const U8* data =
+			state.m_gr->getTransientMemoryManager().getBaseAddress(m_token);
+		m_buff->getImplementation().write(
+			m_offset, data + m_token.m_offset, m_token.m_range);
+
+		state.m_stats.m_uploadedBytes += m_token.m_range;
+	}
+};
+
+//==============================================================================
+void CommandBuffer::uploadBuffer(
+	BufferPtr buff, PtrSize offset, const TransientMemoryToken& token)
+{
+	m_impl->pushBackNewCommand<UploadBufferCommand>(buff, offset, token);
+}
+
+//==============================================================================
+void CommandBuffer::setTextureBarrier(TexturePtr tex,
+	TextureUsageBit prevUsage,
+	TextureUsageBit nextUsage,
+	const TextureSurfaceInfo& surf)
+{
+	m_impl->pushBackNewCommand<TextureCommand>(tex, surf);
+}
+
+//==============================================================================
+class BufferBarrierCommand final : public NullCommand
+{
+public:
+	BufferPtr m_buff;
+
+	BufferBarrierCommand(BufferPtr buff)
+		: m_buff(buff)
+	{
+	}
+
+	void operator()(NullState&)
+	{
+	}
+};
+
+//==============================================================================
+void CommandBuffer::setBufferBarrier(
+	BufferPtr buff, BufferUsageBit prevUsage, BufferUsageBit nextUsage)
+{
+	m_impl->pushBackNewCommand<BufferBarrierCommand>(buff);
+}
+
+//==============================================================================
+class OcclusionQueryCommand final : public NullCommand
+{
+public:
+	OcclusionQueryPtr m_query;
+
+	OcclusionQueryCommand(OcclusionQueryPtr query)
+		: m_query(query)
+	{
+	}
+
+	void operator()(NullState&)
+	{
+	}
+};
+
+//==============================================================================
+void CommandBuffer::beginOcclusionQuery(OcclusionQueryPtr query)
+{
+	m_impl->pushBackNewCommand<OcclusionQueryCommand>(query);
+}
+
+//==============================================================================
+void CommandBuffer::endOcclusionQuery(OcclusionQueryPtr query)
+{
+	m_impl->pushBackNewCommand<OcclusionQueryCommand>(query);
+}
+
+//==============================================================================
+class PushSecondLevelCommand final : public NullCommand
+{
+public:
+	CommandBufferPtr m_cmdb;
+
+	PushSecondLevelCommand(CommandBufferPtr cmdb)
+		: m_cmdb(cmdb)
+	{
+	}
+
+	void operator()(NullState& state)
+	{
+		m_cmdb->getImplementation().executeAllCommands(state);
+	}
+};
+
+//==============================================================================
+void CommandBuffer::pushSecondLevelCommandBuffer(CommandBufferPtr cmdb)
+{
+	ANKI_ASSERT(cmdb->getImplementation().isSecondLevel());
+	cmdb->getImplementation().makeImmutable();
+	m_impl->pushBackNewCommand<PushSecondLevelCommand>(cmdb);
+}
+
+//==============================================================================
+Bool CommandBuffer::isEmpty() const
+{
+	return m_impl->isEmpty();
+}
+
+} // end namespace anki
@@ -0,0 +1,62 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/CommandBufferImpl.h>
+#include <anki/gr/GrManager.h>
+
+namespace anki
+{
+
+//==============================================================================
+CommandBufferImpl::~CommandBufferImpl()
+{
+	NullCommand* command = m_firstCommand;
+	while(command != nullptr)
+	{
+		NullCommand* next = command->m_nextCommand; // Get next before deleting
+		m_alloc.deleteInstance(command);
+		command = next;
+	}
+}
+
+//==============================================================================
+void CommandBufferImpl::init(const CommandBufferInitInfo& init)
+{
+	GrAllocator<U8> alloc = getAllocator();
+	auto& pool = alloc.getMemoryPool();
+
+	m_alloc = CommandBufferAllocator<U8>(pool.getAllocationCallback(),
+		pool.getAllocationCallbackUserData(),
+		init.m_hints.m_chunkSize,
+		1.0,
+		0,
+		false);
+
+	m_flags = init.m_flags;
+}
+
+//==============================================================================
+CommandBufferInitHints CommandBufferImpl::computeInitHints() const
+{
+	CommandBufferInitHints out;
+	out.m_chunkSize = m_alloc.getMemoryPool().getMemoryCapacity();
+
+	return out;
+}
+
+//==============================================================================
+void CommandBufferImpl::executeAllCommands(NullState& state)
+{
+	NullCommand* command = m_firstCommand;
+	while(command != nullptr)
+	{
+		(*command)(state);
+		++state.m_stats.m_commandCount;
+
+		command = command->m_nextCommand;
+	}
+}
+
+} // end namespace anki
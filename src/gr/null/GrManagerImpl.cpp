@@ -0,0 +1,86 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/GrManagerImpl.h>
+#include <anki/gr/GrManager.h>
+#include <anki/gr/null/CommandBufferImpl.h>
+#include <anki/util/Logger.h>
+
+namespace anki
+{
+
+//==============================================================================
+GrManagerImpl::~GrManagerImpl()
+{
+	m_transientMem.destroy();
+}
+
+//==============================================================================
+Error GrManagerImpl::init(const GrManagerInitInfo& init)
+{
+	ANKI_LOGI("Initializing the NULL graphics backend. Nothing will be drawn");
+
+	ANKI_ASSERT(init.m_config);
+	ANKI_CHECK(m_transientMem.init(*init.m_config));
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+GrAllocator<U8> GrManagerImpl::getAllocator() const
+{
+	return m_manager->getAllocator();
+}
+
+//==============================================================================
+void GrManagerImpl::beginFrame()
+{
+	// Nothing
+}
+
+//==============================================================================
+void GrManagerImpl::endFrame()
+{
+	m_transientMem.endFrame();
+	++m_frame;
+}
+
+//==============================================================================
+void GrManagerImpl::flushCommandBuffer(CommandBufferPtr cmdb)
+{
+	CommandBufferImpl& impl = cmdb->getImplementation();
+	ANKI_ASSERT(!impl.isSecondLevel());
+
+	NullState state;
+	state.m_gr = this;
+	impl.executeAllCommands(state);
+	ANKI_ASSERT(state.m_fb == nullptr && "Forgot to end the renderpass");
+
+	++state.m_stats.m_commandBufferCount;
+	addStatistics(state.m_stats);
+}
+
+//==============================================================================
+GrStatistics GrManagerImpl::getStatistics() const
+{
+	GrStatistics stats;
+	{
+		LockGuard<SpinLock> lock(m_statsLock);
+		stats = m_stats;
+	}
+
+	stats.m_transientBytes = m_transientMem.getAllocatedBytes();
+	return stats;
+}
+
+//==============================================================================
+void GrManagerImpl::resetStatistics()
+{
+	LockGuard<SpinLock> lock(m_statsLock);
+	m_stats = GrStatistics();
+	m_transientMem.resetAllocatedBytes();
+}
+
+} // end namespace anki
@@ -0,0 +1,25 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/NullObject.h>
+#include <anki/gr/GrManager.h>
+#include <anki/gr/null/GrManagerImpl.h>
+
+namespace anki
+{
+
+//==============================================================================
+GrAllocator<U8> NullObject::getAllocator() const
+{
+	return m_manager->getAllocator();
+}
+
+//==============================================================================
+GrManagerImpl& NullObject::getGrManagerImpl()
+{
+	return m_manager->getImplementation();
+}
+
+} // end namespace anki
@@ -0,0 +1,30 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/Pipeline.h>
+#include <anki/gr/null/PipelineImpl.h>
+
+namespace anki
+{
+
+//==============================================================================
+Pipeline::Pipeline(GrManager* manager, U64 hash)
+	: GrObject(manager, CLASS_TYPE, hash)
+{
+}
+
+//==============================================================================
+Pipeline::~Pipeline()
+{
+}
+
+//==============================================================================
+void Pipeline::init(const PipelineInitInfo& init)
+{
+	m_impl.reset(getAllocator().newInstance<PipelineImpl>(&getManager()));
+	m_impl->init(init);
+}
+
+} // end namespace anki
@@ -0,0 +1,30 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/ResourceGroup.h>
+#include <anki/gr/null/ResourceGroupImpl.h>
+
+namespace anki
+{
+
+//==============================================================================
+ResourceGroup::ResourceGroup(GrManager* manager, U64 hash)
+	: GrObject(manager, CLASS_TYPE, hash)
+{
+}
+
+//==============================================================================
+ResourceGroup::~ResourceGroup()
+{
+}
+
+//==============================================================================
+void ResourceGroup::init(const ResourceGroupInitInfo& init)
+{
+	m_impl.reset(getAllocator().newInstance<ResourceGroupImpl>(&getManager()));
+	m_impl->init(init);
+}
+
+} // end namespace anki
@@ -0,0 +1,88 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/ResourceGroupImpl.h>
+
+namespace anki
+{
+
+//==============================================================================
+template<typename TBindings>
+static U32 countBufferBindings(const TBindings& bindings, Bool& uploaded)
+{
+	U32 count = 0;
+	for(const BufferBinding& b : bindings)
+	{
+		if(b.m_buffer.isCreated() || b.m_uploadedMemory)
+		{
+			++count;
+		}
+
+		uploaded = uploaded || b.m_uploadedMemory;
+	}
+
+	return count;
+}
+
+//==============================================================================
+template<typename TBindings, typename TTokens>
+static Bool checkTokens(const TBindings& bindings, const TTokens& tokens)
+{
+	ANKI_ASSERT(bindings.getSize() == tokens.getSize());
+	for(U i = 0; i < bindings.getSize(); ++i)
+	{
+		if(bindings[i].m_uploadedMemory && tokens[i].m_range == 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//==============================================================================
+void ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
+{
+	m_init = init;
+
+	m_bindingCount = 0;
+	for(const TextureBinding& b : init.m_textures)
+	{
+		if(b.m_texture.isCreated())
+		{
+			++m_bindingCount;
+		}
+	}
+
+	Bool uploaded = false;
+	m_bindingCount += countBufferBindings(init.m_uniformBuffers, uploaded);
+	m_bindingCount += countBufferBindings(init.m_storageBuffers, uploaded);
+	m_bindingCount += countBufferBindings(init.m_atomicBuffers, uploaded);
+	m_bindingCount += countBufferBindings(init.m_vertexBuffers, uploaded);
+
+	if(init.m_indexBuffer.m_buffer.isCreated())
+	{
+		ANKI_ASSERT(init.m_indexSize == 2 || init.m_indexSize == 4);
+		++m_bindingCount;
+	}
+
+	m_hasUploadedMemory = uploaded;
+}
+
+//==============================================================================
+Bool ResourceGroupImpl::checkTransientMemoryInfo(
+	const TransientMemoryInfo* info) const
+{
+	if(info == nullptr)
+	{
+		return !m_hasUploadedMemory;
+	}
+
+	return checkTokens(m_init.m_uniformBuffers, info->m_uniformBuffers)
+		&& checkTokens(m_init.m_storageBuffers, info->m_storageBuffers)
+		&& checkTokens(m_init.m_vertexBuffers, info->m_vertexBuffers);
+}
+
+} // end namespace anki
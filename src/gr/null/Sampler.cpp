@@ -0,0 +1,30 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/Sampler.h>
+#include <anki/gr/null/SamplerImpl.h>
+
+namespace anki
+{
+
+//==============================================================================
+Sampler::Sampler(GrManager* manager, U64 hash)
+	: GrObject(manager, CLASS_TYPE, hash)
+{
+}
+
+//==============================================================================
+Sampler::~Sampler()
+{
+}
+
+//==============================================================================
+void Sampler::init(const SamplerInitInfo& init)
+{
+	m_impl.reset(getAllocator().newInstance<SamplerImpl>(&getManager()));
+	m_impl->init(init);
+}
+
+} // end namespace anki
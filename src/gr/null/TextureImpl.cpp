@@ -0,0 +1,27 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/TextureImpl.h>
+
+namespace anki
+{
+
+//==============================================================================
+Bool TextureImpl::isValidSurface(const TextureSurfaceInfo& surf) const
+{
+	const TextureType type = m_init.m_type;
+	const U faceCount =
+		(type == TextureType::CUBE || type == TextureType::CUBE_ARRAY) ? 6 : 1;
+	const U depth = (type == TextureType::_3D) ? m_init.m_depth : 1;
+	const Bool array =
+		type == TextureType::_2D_ARRAY || type == TextureType::CUBE_ARRAY;
+	const U layerCount = (array) ? m_init.m_layerCount : 1;
+
+	return surf.m_level < m_init.m_mipmapsCount && surf.m_depth < depth
+		&& surf.m_face < faceCount
+		&& surf.m_layer < layerCount;
+}
+
+} // end namespace anki
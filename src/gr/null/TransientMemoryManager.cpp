@@ -0,0 +1,144 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/TransientMemoryManager.h>
+#include <anki/gr/GrManager.h>
+#include <anki/core/Config.h>
+#include <anki/core/Trace.h>
+
+namespace anki
+{
+
+//==============================================================================
+Error TransientMemoryManager::init(const ConfigSet& cfg)
+{
+	Array<const char*, U(TransientBufferType::COUNT)> configVars = {
+		{"gr.uniformPerFrameMemorySize",
+			"gr.storagePerFrameMemorySize",
+			"gr.vertexPerFrameMemorySize",
+			"gr.transferPerFrameMemorySize"}};
+
+	// Use the alignments of a common desktop GPU so the memory usage is close
+	// to the one of the other backends
+	Array<U32, U(TransientBufferType::COUNT)> alignments = {
+		{256, 16, sizeof(F32) * 4, sizeof(F32) * 4}};
+
+	auto alloc = m_manager->getAllocator();
+	for(TransientBufferType i = TransientBufferType::UNIFORM;
+		i < TransientBufferType::COUNT;
+		++i)
+	{
+		PerFrameBuffer& frame = m_perFrameBuffers[i];
+		const PtrSize size = cfg.getNumber(configVars[i]);
+		ANKI_ASSERT(size);
+
+		frame.m_manager = m_manager;
+		frame.m_pages[GpuFrameRingAllocator::MAIN_PAGE].create(alloc, size);
+		frame.m_alloc.init(size, alignments[i], MAX_PTR_SIZE, &frame);
+	}
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void TransientMemoryManager::destroy()
+{
+	for(PerFrameBuffer& frame : m_perFrameBuffers)
+	{
+		if(frame.m_manager)
+		{
+			frame.m_alloc.destroy();
+		}
+
+		frame.m_pages[GpuFrameRingAllocator::MAIN_PAGE].destroy(
+			m_manager->getAllocator());
+	}
+}
+
+//==============================================================================
+void TransientMemoryManager::endFrame()
+{
+	for(TransientBufferType type = TransientBufferType::UNIFORM;
+		type < TransientBufferType::COUNT;
+		++type)
+	{
+		PerFrameBuffer& frame = m_perFrameBuffers[type];
+		if(!frame.m_manager)
+		{
+			continue;
+		}
+
+		frame.m_alloc.endFrame();
+
+		const PtrSize highWater = frame.m_alloc.getHighWaterMark();
+		switch(type)
+		{
+		case TransientBufferType::UNIFORM:
+			ANKI_TRACE_INC_COUNTER(GR_TRANSIENT_UNIFORM_HIGH_WATER, highWater);
+			break;
+		case TransientBufferType::STORAGE:
+			ANKI_TRACE_INC_COUNTER(GR_TRANSIENT_STORAGE_HIGH_WATER, highWater);
+			break;
+		case TransientBufferType::VERTEX:
+			ANKI_TRACE_INC_COUNTER(GR_TRANSIENT_VERTEX_HIGH_WATER, highWater);
+			break;
+		default:
+			ANKI_TRACE_INC_COUNTER(
+				GR_TRANSIENT_TRANSFER_HIGH_WATER, highWater);
+			break;
+		}
+
+		(void)highWater;
+	}
+}
+
+//==============================================================================
+void TransientMemoryManager::allocate(PtrSize size,
+	BufferUsageBit usage,
+	TransientMemoryToken& token,
+	void*& ptr,
+	Error* outErr)
+{
+	Error err = ErrorCode::NONE;
+	ptr = nullptr;
+
+	PerFrameBuffer& buff = m_perFrameBuffers[bufferUsageToTransient(usage)];
+	U32 page;
+	err = buff.m_alloc.allocate(size, token.m_offset, page);
+
+	if(!err)
+	{
+		token.m_usage = usage;
+		token.m_range = size;
+		token.m_lifetime = TransientMemoryTokenLifetime::PER_FRAME;
+		token.m_page = page;
+		ptr = &buff.m_pages[page][token.m_offset];
+		m_allocatedBytes.fetchAdd(size);
+	}
+	else if(outErr)
+	{
+		*outErr = err;
+	}
+	else
+	{
+		ANKI_LOGF("Out of transient memory");
+	}
+}
+
+//==============================================================================
+Error TransientMemoryManager::PerFrameBuffer::createPage(
+	U32 page, PtrSize size)
+{
+	m_pages[page].create(m_manager->getAllocator(), size);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void TransientMemoryManager::PerFrameBuffer::destroyPage(U32 page)
+{
+	m_pages[page].destroy(m_manager->getAllocator());
+}
+
+} // end namespace anki
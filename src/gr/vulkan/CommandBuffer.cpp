@@ -113,6 +113,13 @@ void CommandBuffer::drawArrays(
 	m_impl->drawArrays(count, instanceCount, first, baseInstance);
 }
 
+//==============================================================================
+void CommandBuffer::drawElementsIndirect(
+	U32 drawCount, const TransientMemoryToken& token)
+{
+	m_impl->drawElementsIndirect(drawCount, token);
+}
+
 //==============================================================================
 void CommandBuffer::drawElementsConditional(OcclusionQueryPtr query,
 	U32 count,
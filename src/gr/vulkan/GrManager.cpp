@@ -62,4 +62,10 @@ void* GrManager::allocateFrameTransientMemory(
 	return ptr;
 }
 
+//==============================================================================
+Bool GrManager::getBaseInstanceSupported() const
+{
+	return true;
+}
+
 } // end namespace anki
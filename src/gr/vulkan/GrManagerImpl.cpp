@@ -122,6 +122,14 @@ GrManagerImpl::~GrManagerImpl()
 		getAllocator().deleteInstance(m_renderPasses);
 	}
 
+	if(m_pipelineCache)
+	{
+		savePipelineCache();
+		vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+	}
+
+	m_shaderCache.destroy();
+
 	if(m_globalPipelineLayout)
 	{
 		vkDestroyPipelineLayout(m_device, m_globalPipelineLayout, nullptr);
@@ -198,6 +206,8 @@ Error GrManagerImpl::initInternal(const GrManagerInitInfo& init)
 	ANKI_CHECK(initGlobalDsetLayout());
 	ANKI_CHECK(initGlobalDsetPool());
 	ANKI_CHECK(initGlobalPplineLayout());
+	initShaderCache(init);
+	ANKI_CHECK(initPipelineCache());
 
 	m_renderPasses = getAllocator().newInstance<CompatibleRenderPassHashMap>();
 
@@ -213,6 +223,109 @@ Error GrManagerImpl::initInternal(const GrManagerInitInfo& init)
 	return ErrorCode::NONE;
 }
 
+//==============================================================================
+void GrManagerImpl::initShaderCache(const GrManagerInitInfo& init)
+{
+	if(!init.m_config->getNumber("gr.diskShaderCache")
+		|| init.m_cacheDirectory.isEmpty())
+	{
+		return;
+	}
+
+	// The SPIR-V depends only on the engine but the pipeline cache depends on
+	// the device and the driver as well
+	class
+	{
+	public:
+		Array<char, 4> m_backend = {{'V', 'K', 0, 0}};
+		U32 m_engineVersion = (ANKI_VERSION_MAJOR << 16) | ANKI_VERSION_MINOR;
+		U32 m_vendorId;
+		U32 m_deviceId;
+		U32 m_driverVersion;
+		Array<U8, VK_UUID_SIZE> m_pipelineCacheUuid;
+	} backend;
+
+	backend.m_vendorId = m_devProps.vendorID;
+	backend.m_deviceId = m_devProps.deviceID;
+	backend.m_driverVersion = m_devProps.driverVersion;
+	memcpy(&backend.m_pipelineCacheUuid[0],
+		&m_devProps.pipelineCacheUUID[0],
+		VK_UUID_SIZE);
+
+	Error err = m_shaderCache.init(getAllocator(),
+		init.m_cacheDirectory,
+		computeHash(&backend, sizeof(backend)));
+	if(err)
+	{
+		ANKI_LOGW("Failed to initialize the shader cache. Will continue "
+				  "without it");
+		m_shaderCache.destroy();
+	}
+}
+
+//==============================================================================
+static const char* PIPELINE_CACHE_NAME = "VkPipelineCache";
+
+Error GrManagerImpl::initPipelineCache()
+{
+	DynamicArrayAuto<U8> data(getAllocator());
+	Bool found = false;
+	if(m_shaderCache.isEnabled())
+	{
+		const U64 key = m_shaderCache.computeKey(
+			PIPELINE_CACHE_NAME, strlen(PIPELINE_CACHE_NAME));
+		if(m_shaderCache.load(key, data, found))
+		{
+			found = false;
+		}
+	}
+
+	// The driver validates the data against the device and ignores it if it
+	// doesn't match
+	VkPipelineCacheCreateInfo ci = {};
+	ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	if(found)
+	{
+		ci.initialDataSize = data.getSize();
+		ci.pInitialData = &data[0];
+	}
+
+	ANKI_VK_CHECK(
+		vkCreatePipelineCache(m_device, &ci, nullptr, &m_pipelineCache));
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void GrManagerImpl::savePipelineCache()
+{
+	ANKI_ASSERT(m_pipelineCache);
+	if(!m_shaderCache.isEnabled())
+	{
+		return;
+	}
+
+	size_t size = 0;
+	ANKI_VK_CHECKF(
+		vkGetPipelineCacheData(m_device, m_pipelineCache, &size, nullptr));
+	if(size == 0)
+	{
+		return;
+	}
+
+	DynamicArrayAuto<U8> data(getAllocator());
+	data.create(size);
+	ANKI_VK_CHECKF(
+		vkGetPipelineCacheData(m_device, m_pipelineCache, &size, &data[0]));
+
+	const U64 key = m_shaderCache.computeKey(
+		PIPELINE_CACHE_NAME, strlen(PIPELINE_CACHE_NAME));
+	if(m_shaderCache.store(key, &data[0], size))
+	{
+		ANKI_LOGW("Failed to save the pipeline cache");
+	}
+}
+
 //==============================================================================
 Error GrManagerImpl::initInstance(const GrManagerInitInfo& init)
 {
@@ -4,6 +4,7 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/gr/vulkan/ShaderImpl.h>
+#include <anki/gr/vulkan/GrManagerImpl.h>
 #include <glslang/Public/ShaderLang.h>
 #include <SPIRV/GlslangToSpv.h>
 
@@ -152,6 +153,7 @@ static const char* SHADER_HEADER = R"(#version 450 core
 #define ANKI_VK 1
 #define %s
 #define gl_VertexID gl_VertexIndex
+#define ANKI_INSTANCE_ID gl_InstanceIndex
 #define ANKI_UBO_BINDING(set_, binding_) set = set_, binding = %u + binding_
 #define ANKI_SS_BINDING(set_, binding_) set = set_, binding = %u + binding_
 #define ANKI_TEX_BINDING(set_, binding_) set = set_, binding = %u + binding_
@@ -235,9 +237,37 @@ Error ShaderImpl::init(ShaderType shaderType, const CString& source)
 		0,
 		&source[0]);
 
+	// Try the SPIR-V of a previous run before invoking glslang
+	ShaderCache& cache = getGrManagerImpl().getShaderCache();
+	DynamicArrayAuto<U8> cached(alloc);
+	Bool found = false;
+	U64 key = 0;
+	if(cache.isEnabled())
+	{
+		key = cache.computeKey(&fullSrc[0], fullSrc.getLength());
+		Error err = cache.load(key, cached, found);
+		found = !err && found
+			&& (cached.getSize() % sizeof(unsigned int)) == 0;
+	}
+
 	std::vector<unsigned int> spirv;
-	ANKI_CHECK(genSpirv(fullSrc.toCString(), spirv));
-	ANKI_ASSERT(!spirv.empty());
+	if(found)
+	{
+		// Copy it since the SPIR-V needs to be aligned to words
+		spirv.resize(cached.getSize() / sizeof(unsigned int));
+		memcpy(&spirv[0], &cached[0], cached.getSize());
+	}
+	else
+	{
+		ANKI_CHECK(genSpirv(fullSrc.toCString(), spirv));
+		ANKI_ASSERT(!spirv.empty());
+
+		const PtrSize size = spirv.size() * sizeof(unsigned int);
+		if(cache.isEnabled() && cache.store(key, &spirv[0], size))
+		{
+			ANKI_LOGW("Failed to store a shader in the shader cache");
+		}
+	}
 
 	VkShaderModuleCreateInfo ci = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
 		nullptr,
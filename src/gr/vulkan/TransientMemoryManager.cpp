@@ -31,7 +31,7 @@ Error TransientMemoryManager::init(const ConfigSet& cfg)
 
 	Array<BufferUsageBit, U(TransientBufferType::COUNT)> usages = {
 		{BufferUsageBit::UNIFORM_ANY_SHADER,
-			BufferUsageBit::STORAGE_ANY,
+			BufferUsageBit::STORAGE_ANY | BufferUsageBit::INDIRECT,
 			BufferUsageBit::VERTEX,
 			BufferUsageBit::TRANSFER_SOURCE}};
 
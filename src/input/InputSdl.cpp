@@ -15,8 +15,12 @@ namespace anki
 //==============================================================================
 Error Input::init(NativeWindow* nativeWindow)
 {
-	ANKI_ASSERT(nativeWindow);
 	m_nativeWindow = nativeWindow;
+	if(m_nativeWindow == nullptr)
+	{
+		// Windowless, there will be no events
+		return ErrorCode::NONE;
+	}
 
 	// Init native
 	HeapAllocator<std::pair<const SDL_Keycode, KeyCode>> alloc =
@@ -283,8 +287,6 @@ void Input::destroy()
 //==============================================================================
 Error Input::handleEvents()
 {
-	ANKI_ASSERT(m_nativeWindow != nullptr);
-
 	// add the times a key is being pressed
 	for(auto& k : m_keys)
 	{
@@ -301,6 +303,11 @@ Error Input::handleEvents()
 		}
 	}
 
+	if(m_nativeWindow == nullptr)
+	{
+		return ErrorCode::NONE;
+	}
+
 	SDL_Event event;
 	KeyCode akkey;
 	SDL_StartTextInput();
@@ -348,7 +355,7 @@ Error Input::handleEvents()
 //==============================================================================
 void Input::moveCursor(const Vec2& pos)
 {
-	if(pos != m_mousePosNdc)
+	if(m_nativeWindow && pos != m_mousePosNdc)
 	{
 		SDL_WarpMouseInWindow(m_nativeWindow->getNative().m_window,
 			m_nativeWindow->getWidth() * (pos.x() * 0.5 + 0.5),
@@ -359,7 +366,10 @@ void Input::moveCursor(const Vec2& pos)
 //==============================================================================
 void Input::hideCursor(Bool hide)
 {
-	SDL_ShowCursor(!hide);
+	if(m_nativeWindow)
+	{
+		SDL_ShowCursor(!hide);
+	}
 }
 
 } // end namespace anki
@@ -7,10 +7,243 @@
 #include <anki/util/StringList.h>
 #include <anki/util/File.h>
 #include <anki/util/Logger.h>
+#include <anki/util/Hash.h>
+#include <cstring>
+#include <cmath>
 
 namespace anki
 {
 
+//==============================================================================
+// Baked format                                                                =
+//==============================================================================
+
+static const U32 BAKED_NONE = MAX_U32;
+
+/// The header of a baked document. The header is followed by the numbers,
+/// the elements and the strings. The first element is the document itself.
+class XmlBakedHeader
+{
+public:
+	Array<U8, 8> m_magic; ///< Magic word. It's also the version.
+	U32 m_elementCount;
+	U32 m_numberCount;
+	U32 m_stringsSize;
+	U32 m_sourceSize; ///< The size of the XML text it was baked from.
+	U64 m_sourceHash; ///< The hash of the XML text it was baked from.
+};
+
+static_assert(sizeof(XmlBakedHeader) % sizeof(F64) == 0, "Keep it aligned");
+
+/// A baked element. The elements are stored in depth first order.
+class XmlBakedElement
+{
+public:
+	U32 m_name; ///< Offset in the strings.
+	U32 m_text; ///< Offset in the strings or BAKED_NONE.
+	U32 m_firstChild; ///< Element index or BAKED_NONE.
+	U32 m_nextSibling; ///< Element index or BAKED_NONE.
+	U32 m_firstNumber; ///< Index in the numbers.
+	U32 m_numberCount; ///< BAKED_NONE if the text is not a list of numbers.
+};
+
+static_assert(sizeof(XmlBakedElement) % sizeof(F64) == 0, "Keep it aligned");
+
+static const char* BAKED_MAGIC = "ANKIXML2";
+
+/// Helper that bakes a tinyxml2 document.
+class XmlBaker
+{
+public:
+	DynamicArrayAuto<XmlBakedElement> m_elements;
+	DynamicArrayAuto<F64> m_numbers;
+	DynamicArrayAuto<char> m_strings;
+	DynamicArrayAuto<U32> m_names; ///< Offsets of the unique names.
+	U32 m_elementCount = 0;
+	U32 m_numberCount = 0;
+	U32 m_stringsSize = 0;
+	U32 m_nameCount = 0;
+
+	XmlBaker(GenericMemoryPoolAllocator<U8> alloc)
+		: m_elements(alloc)
+		, m_numbers(alloc)
+		, m_strings(alloc)
+		, m_names(alloc)
+		, m_alloc(alloc)
+	{
+	}
+
+	/// Bake an element and its children.
+	/// @return The index of the element.
+	U32 bakeElement(const tinyxml2::XMLElement& xel);
+
+	/// Bake the document element.
+	void bakeDocument(const tinyxml2::XMLDocument& doc);
+
+private:
+	GenericMemoryPoolAllocator<U8> m_alloc;
+
+	template<typename T>
+	static void grow(DynamicArrayAuto<T>& arr, U32 count)
+	{
+		if(count > arr.getSize())
+		{
+			arr.resize(max<PtrSize>(count, arr.getSize() * 2));
+		}
+	}
+
+	U32 newElement();
+
+	U32 addString(const char* str);
+
+	/// Element names repeat a lot. Store them once.
+	U32 addName(const char* name);
+
+	/// Parse the text like XmlElement::getFloats does. If it's not a list of
+	/// numbers leave the element as it is.
+	void addNumbers(const char* text, U32 elIdx);
+};
+
+//==============================================================================
+U32 XmlBaker::newElement()
+{
+	grow(m_elements, m_elementCount + 1);
+
+	XmlBakedElement& el = m_elements[m_elementCount];
+	el.m_name = 0;
+	el.m_text = BAKED_NONE;
+	el.m_firstChild = BAKED_NONE;
+	el.m_nextSibling = BAKED_NONE;
+	el.m_firstNumber = 0;
+	el.m_numberCount = BAKED_NONE;
+
+	return m_elementCount++;
+}
+
+//==============================================================================
+U32 XmlBaker::addString(const char* str)
+{
+	U32 len = std::strlen(str) + 1;
+	grow(m_strings, m_stringsSize + len);
+	std::memcpy(&m_strings[m_stringsSize], str, len);
+
+	U32 offset = m_stringsSize;
+	m_stringsSize += len;
+	return offset;
+}
+
+//==============================================================================
+U32 XmlBaker::addName(const char* name)
+{
+	for(U i = 0; i < m_nameCount; ++i)
+	{
+		if(std::strcmp(&m_strings[m_names[i]], name) == 0)
+		{
+			return m_names[i];
+		}
+	}
+
+	grow(m_names, m_nameCount + 1);
+	m_names[m_nameCount] = addString(name);
+	return m_names[m_nameCount++];
+}
+
+//==============================================================================
+void XmlBaker::addNumbers(const char* text, U32 elIdx)
+{
+	StringListAuto list(m_alloc);
+	list.splitString(text, ' ');
+
+	if(list.isEmpty())
+	{
+		return;
+	}
+
+	U32 first = m_numberCount;
+	for(const String& str : list)
+	{
+		// The whole token should be a number. If not the element will parse
+		// its text at runtime and it will behave exactly like the XML
+		const char* begin = &str[0];
+		char* end;
+		F64 number = std::strtod(begin, &end);
+
+		if(end != begin + str.getLength() || number == HUGE_VAL)
+		{
+			m_numberCount = first;
+			return;
+		}
+
+		grow(m_numbers, m_numberCount + 1);
+		m_numbers[m_numberCount++] = number;
+	}
+
+	m_elements[elIdx].m_firstNumber = first;
+	m_elements[elIdx].m_numberCount = m_numberCount - first;
+}
+
+//==============================================================================
+U32 XmlBaker::bakeElement(const tinyxml2::XMLElement& xel)
+{
+	U32 idx = newElement();
+	m_elements[idx].m_name = addName(xel.Name());
+
+	const char* text = xel.GetText();
+	if(text)
+	{
+		U32 textOffset = addString(text);
+		m_elements[idx].m_text = textOffset;
+		addNumbers(text, idx);
+	}
+
+	// Bake the children. Don't keep references to the elements, they may move
+	U32 prevIdx = BAKED_NONE;
+	for(const tinyxml2::XMLElement* child = xel.FirstChildElement(); child;
+		child = child->NextSiblingElement())
+	{
+		U32 childIdx = bakeElement(*child);
+
+		if(prevIdx == BAKED_NONE)
+		{
+			m_elements[idx].m_firstChild = childIdx;
+		}
+		else
+		{
+			m_elements[prevIdx].m_nextSibling = childIdx;
+		}
+
+		prevIdx = childIdx;
+	}
+
+	return idx;
+}
+
+//==============================================================================
+void XmlBaker::bakeDocument(const tinyxml2::XMLDocument& doc)
+{
+	U32 idx = newElement();
+	ANKI_ASSERT(idx == 0);
+	m_elements[idx].m_name = addName("");
+
+	U32 prevIdx = BAKED_NONE;
+	for(const tinyxml2::XMLElement* child = doc.FirstChildElement(); child;
+		child = child->NextSiblingElement())
+	{
+		U32 childIdx = bakeElement(*child);
+
+		if(prevIdx == BAKED_NONE)
+		{
+			m_elements[idx].m_firstChild = childIdx;
+		}
+		else
+		{
+			m_elements[prevIdx].m_nextSibling = childIdx;
+		}
+
+		prevIdx = childIdx;
+	}
+}
+
 //==============================================================================
 // XmlElement                                                                  =
 //==============================================================================
@@ -19,7 +252,7 @@ namespace anki
 ANKI_USE_RESULT Error XmlElement::check() const
 {
 	Error err = ErrorCode::NONE;
-	if(m_el == nullptr)
+	if(m_el == nullptr && m_baked == nullptr)
 	{
 		ANKI_LOGE("Empty element");
 		err = ErrorCode::USER_DATA;
@@ -27,13 +260,82 @@ ANKI_USE_RESULT Error XmlElement::check() const
 	return err;
 }
 
+//==============================================================================
+const XmlBakedElement& XmlElement::getBakedElement() const
+{
+	ANKI_ASSERT(m_baked && m_bakedIdx < m_baked->m_elementCount);
+	return m_baked->m_elements[m_bakedIdx];
+}
+
+//==============================================================================
+const char* XmlElement::getName() const
+{
+	if(m_el)
+	{
+		return m_el->Value();
+	}
+	else if(m_baked)
+	{
+		return &m_baked->m_strings[getBakedElement().m_name];
+	}
+	else
+	{
+		return "";
+	}
+}
+
+//==============================================================================
+const char* XmlElement::getTextPtr() const
+{
+	if(m_el)
+	{
+		return m_el->GetText();
+	}
+
+	const XmlBakedElement& el = getBakedElement();
+	return (el.m_text != BAKED_NONE) ? &m_baked->m_strings[el.m_text] : nullptr;
+}
+
+//==============================================================================
+Bool XmlElement::getBakedNumbers(const F64*& numbers, U32& count) const
+{
+	if(m_baked == nullptr || getBakedElement().m_numberCount == BAKED_NONE)
+	{
+		return false;
+	}
+
+	const XmlBakedElement& el = getBakedElement();
+	numbers = &m_baked->m_numbers[el.m_firstNumber];
+	count = el.m_numberCount;
+	return true;
+}
+
+//==============================================================================
+XmlElement XmlElement::findBakedElement(U32 idx, const CString& name) const
+{
+	ANKI_ASSERT(m_baked);
+
+	while(idx != BAKED_NONE)
+	{
+		const XmlBakedElement& el = m_baked->m_elements[idx];
+		if(std::strcmp(&m_baked->m_strings[el.m_name], &name[0]) == 0)
+		{
+			return XmlElement(m_baked, idx, m_alloc);
+		}
+
+		idx = el.m_nextSibling;
+	}
+
+	return XmlElement();
+}
+
 //==============================================================================
 Error XmlElement::getText(CString& out) const
 {
 	Error err = check();
-	if(!err && m_el->GetText())
+	if(!err && getTextPtr())
 	{
-		out = CString(m_el->GetText());
+		out = CString(getTextPtr());
 	}
 	else
 	{
@@ -50,14 +352,14 @@ Error XmlElement::getI64(I64& out) const
 
 	if(!err)
 	{
-		const char* txt = m_el->GetText();
+		const char* txt = getTextPtr();
 		if(txt != nullptr)
 		{
 			err = CString(txt).toI64(out);
 		}
 		else
 		{
-			ANKI_LOGE("Failed to return int. Element: %s", m_el->Value());
+			ANKI_LOGE("Failed to return int. Element: %s", getName());
 			err = ErrorCode::USER_DATA;
 		}
 	}
@@ -70,16 +372,22 @@ Error XmlElement::getF64(F64& out) const
 {
 	Error err = check();
 
-	if(!err)
+	const F64* numbers;
+	U32 count;
+	if(!err && getBakedNumbers(numbers, count) && count == 1)
 	{
-		const char* txt = m_el->GetText();
+		out = numbers[0];
+	}
+	else if(!err)
+	{
+		const char* txt = getTextPtr();
 		if(txt != nullptr)
 		{
 			err = CString(txt).toF64(out);
 		}
 		else
 		{
-			ANKI_LOGE("Failed to return float. Element: %s", m_el->Value());
+			ANKI_LOGE("Failed to return float. Element: %s", getName());
 			err = ErrorCode::USER_DATA;
 		}
 	}
@@ -92,10 +400,21 @@ Error XmlElement::getFloats(DynamicArrayAuto<F64>& out) const
 {
 	Error err = check();
 
+	// Baked elements have their numbers ready
+	const F64* numbers;
+	U32 count;
+	if(!err && getBakedNumbers(numbers, count))
+	{
+		out = DynamicArrayAuto<F64>(m_alloc);
+		out.create(count);
+		std::memcpy(&out[0], numbers, count * sizeof(F64));
+		return ErrorCode::NONE;
+	}
+
 	const char* txt;
 	if(!err)
 	{
-		txt = m_el->GetText();
+		txt = getTextPtr();
 		if(txt == nullptr)
 		{
 			err = ErrorCode::USER_DATA;
@@ -124,7 +443,7 @@ Error XmlElement::getFloats(DynamicArrayAuto<F64>& out) const
 
 	if(err)
 	{
-		ANKI_LOGE("Failed to return floats. Element: %s", m_el->Value());
+		ANKI_LOGE("Failed to return floats. Element: %s", getName());
 	}
 
 	list.destroy(m_alloc);
@@ -154,7 +473,7 @@ Error XmlElement::getMat4(Mat4& out) const
 
 	if(err)
 	{
-		ANKI_LOGE("Failed to return Mat4. Element: %s", m_el->Value());
+		ANKI_LOGE("Failed to return Mat4. Element: %s", getName());
 	}
 
 	return err;
@@ -182,7 +501,7 @@ Error XmlElement::getVec3(Vec3& out) const
 
 	if(err)
 	{
-		ANKI_LOGE("Failed to return Vec3. Element: %s", m_el->Value());
+		ANKI_LOGE("Failed to return Vec3. Element: %s", getName());
 	}
 
 	return err;
@@ -209,7 +528,7 @@ Error XmlElement::getVec4(Vec4& out) const
 
 	if(err)
 	{
-		ANKI_LOGE("Failed to return Vec4. Element: %s", m_el->Value());
+		ANKI_LOGE("Failed to return Vec4. Element: %s", getName());
 	}
 
 	return err;
@@ -220,7 +539,11 @@ Error XmlElement::getChildElementOptional(
 	const CString& name, XmlElement& out) const
 {
 	Error err = check();
-	if(!err)
+	if(!err && m_baked)
+	{
+		out = findBakedElement(getBakedElement().m_firstChild, name);
+	}
+	else if(!err)
 	{
 		out = XmlElement(m_el->FirstChildElement(&name[0]), m_alloc);
 	}
@@ -262,7 +585,11 @@ Error XmlElement::getNextSiblingElement(
 	const CString& name, XmlElement& out) const
 {
 	Error err = check();
-	if(!err)
+	if(!err && m_baked)
+	{
+		out = findBakedElement(getBakedElement().m_nextSibling, name);
+	}
+	else if(!err)
 	{
 		out = XmlElement(m_el->NextSiblingElement(&name[0]), m_alloc);
 	}
@@ -278,7 +605,19 @@ Error XmlElement::getNextSiblingElement(
 Error XmlElement::getSiblingElementsCount(U32& out) const
 {
 	Error err = check();
-	if(!err)
+	if(!err && m_baked)
+	{
+		CString name(getName());
+		XmlElement el = findBakedElement(getBakedElement().m_nextSibling, name);
+
+		out = 0;
+		while(el)
+		{
+			++out;
+			el = findBakedElement(el.getBakedElement().m_nextSibling, name);
+		}
+	}
+	else if(!err)
 	{
 		const tinyxml2::XMLElement* el = m_el;
 
@@ -306,6 +645,15 @@ Error XmlElement::getSiblingElementsCount(U32& out) const
 //==============================================================================
 CString XmlDocument::XML_HEADER = R"(<?xml version="1.0" encoding="UTF-8" ?>)";
 
+//==============================================================================
+CString XmlDocument::BAKED_FILENAME_SUFFIX = ".baked";
+
+//==============================================================================
+XmlDocument::~XmlDocument()
+{
+	m_bakedStorage.destroy(m_alloc);
+}
+
 //==============================================================================
 Error XmlDocument::loadFile(
 	const CString& filename, GenericMemoryPoolAllocator<U8> alloc)
@@ -326,6 +674,8 @@ Error XmlDocument::parse(
 	const CString& xmlText, GenericMemoryPoolAllocator<U8> alloc)
 {
 	m_alloc = alloc;
+	m_sourceSize = xmlText.getLength();
+	m_sourceHash = computeHash(&xmlText[0], m_sourceSize);
 
 	if(m_doc.Parse(&xmlText[0]))
 	{
@@ -339,12 +689,170 @@ Error XmlDocument::parse(
 	return ErrorCode::NONE;
 }
 
+//==============================================================================
+Error XmlDocument::parseBaked(
+	const void* data, PtrSize size, GenericMemoryPoolAllocator<U8> alloc)
+{
+	ANKI_ASSERT(data);
+	ANKI_ASSERT(!isBaked() && m_bakedStorage.getSize() == 0);
+	m_alloc = alloc;
+
+	if(size < sizeof(XmlBakedHeader))
+	{
+		ANKI_LOGE("Baked XML is too small");
+		return ErrorCode::USER_DATA;
+	}
+
+	// Copy it to memory that is aligned for the numbers
+	m_bakedStorage.create(m_alloc, (size + sizeof(F64) - 1) / sizeof(F64));
+	std::memcpy(&m_bakedStorage[0], data, size);
+
+	const U8* base = reinterpret_cast<const U8*>(&m_bakedStorage[0]);
+	const XmlBakedHeader& header =
+		*reinterpret_cast<const XmlBakedHeader*>(base);
+
+	if(std::memcmp(&header.m_magic[0], BAKED_MAGIC, 8) != 0)
+	{
+		ANKI_LOGE("Wrong magic word in baked XML. Bake it again");
+		return ErrorCode::USER_DATA;
+	}
+
+	PtrSize numbersOffset = sizeof(XmlBakedHeader);
+	PtrSize elementsOffset =
+		numbersOffset + PtrSize(header.m_numberCount) * sizeof(F64);
+	PtrSize stringsOffset = elementsOffset
+		+ PtrSize(header.m_elementCount) * sizeof(XmlBakedElement);
+
+	if(header.m_elementCount == 0 || header.m_stringsSize == 0
+		|| stringsOffset + header.m_stringsSize != size
+		|| base[size - 1] != '\0')
+	{
+		ANKI_LOGE("Baked XML is corrupted");
+		return ErrorCode::USER_DATA;
+	}
+
+	XmlBakedTables tables;
+	tables.m_elements =
+		reinterpret_cast<const XmlBakedElement*>(base + elementsOffset);
+	tables.m_numbers = reinterpret_cast<const F64*>(base + numbersOffset);
+	tables.m_strings = reinterpret_cast<const char*>(base + stringsOffset);
+	tables.m_elementCount = header.m_elementCount;
+	tables.m_numberCount = header.m_numberCount;
+	tables.m_stringsSize = header.m_stringsSize;
+
+	// Validate the elements. The links point forward so there are no cycles
+	for(U32 i = 0; i < tables.m_elementCount; ++i)
+	{
+		const XmlBakedElement& el = tables.m_elements[i];
+
+		Bool ok = el.m_name < tables.m_stringsSize;
+		ok = ok
+			&& (el.m_text == BAKED_NONE || el.m_text < tables.m_stringsSize);
+		ok = ok
+			&& (el.m_firstChild == BAKED_NONE
+				   || (el.m_firstChild > i
+					   && el.m_firstChild < tables.m_elementCount));
+		ok = ok
+			&& (el.m_nextSibling == BAKED_NONE
+				   || (el.m_nextSibling > i
+					   && el.m_nextSibling < tables.m_elementCount));
+		ok = ok
+			&& (el.m_numberCount == BAKED_NONE
+				   || U64(el.m_firstNumber) + el.m_numberCount
+					   <= tables.m_numberCount);
+
+		if(!ok)
+		{
+			ANKI_LOGE("Baked XML is corrupted");
+			return ErrorCode::USER_DATA;
+		}
+	}
+
+	m_baked = tables;
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Bool XmlDocument::isBakedFromText(
+	const void* data, PtrSize size, const CString& xmlText)
+{
+	if(size < sizeof(XmlBakedHeader))
+	{
+		return false;
+	}
+
+	// The blob might not be aligned
+	XmlBakedHeader header;
+	std::memcpy(&header, data, sizeof(header));
+
+	const U32 sourceSize = xmlText.getLength();
+	return std::memcmp(&header.m_magic[0], BAKED_MAGIC, 8) == 0
+		&& header.m_sourceSize == sourceSize
+		&& header.m_sourceHash == computeHash(&xmlText[0], sourceSize);
+}
+
+//==============================================================================
+Error XmlDocument::bake(DynamicArrayAuto<U8>& out) const
+{
+	ANKI_ASSERT(!isBaked() && "Parse the XML text first");
+
+	if(m_doc.FirstChildElement() == nullptr)
+	{
+		ANKI_LOGE("The XML document is empty");
+		return ErrorCode::USER_DATA;
+	}
+
+	XmlBaker baker(m_alloc);
+	baker.bakeDocument(m_doc);
+
+	XmlBakedHeader header;
+	std::memcpy(&header.m_magic[0], BAKED_MAGIC, 8);
+	header.m_elementCount = baker.m_elementCount;
+	header.m_numberCount = baker.m_numberCount;
+	header.m_stringsSize = baker.m_stringsSize;
+	header.m_sourceSize = m_sourceSize;
+	header.m_sourceHash = m_sourceHash;
+
+	PtrSize numbersSize = baker.m_numberCount * sizeof(F64);
+	PtrSize elementsSize = baker.m_elementCount * sizeof(XmlBakedElement);
+
+	out = DynamicArrayAuto<U8>(m_alloc);
+	out.create(
+		sizeof(header) + numbersSize + elementsSize + baker.m_stringsSize);
+
+	U8* ptr = &out[0];
+	std::memcpy(ptr, &header, sizeof(header));
+	ptr += sizeof(header);
+
+	if(numbersSize)
+	{
+		std::memcpy(ptr, &baker.m_numbers[0], numbersSize);
+		ptr += numbersSize;
+	}
+
+	std::memcpy(ptr, &baker.m_elements[0], elementsSize);
+	ptr += elementsSize;
+
+	std::memcpy(ptr, &baker.m_strings[0], baker.m_stringsSize);
+
+	return ErrorCode::NONE;
+}
+
 //==============================================================================
 ANKI_USE_RESULT Error XmlDocument::getChildElement(
 	const CString& name, XmlElement& out) const
 {
 	Error err = ErrorCode::NONE;
-	out = XmlElement(m_doc.FirstChildElement(&name[0]), m_alloc);
+
+	if(isBaked())
+	{
+		XmlElement root(&m_baked, 0, m_alloc);
+		out = root.findBakedElement(m_baked.m_elements[0].m_firstChild, name);
+	}
+	else
+	{
+		out = XmlElement(m_doc.FirstChildElement(&name[0]), m_alloc);
+	}
 
 	if(!out)
 	{
@@ -8,7 +8,7 @@
 #include <anki/scene/MoveComponent.h>
 #include <anki/scene/SceneNode.h>
 #include <anki/util/Rtti.h>
-#include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHive.h>
 
 namespace anki
 {
@@ -17,20 +17,6 @@ namespace anki
 // Misc                                                                        =
 //==============================================================================
 
-//==============================================================================
-class UpdatePlanesPerspectiveCameraTask : public ThreadPoolTask
-{
-public:
-	Clusterer* m_clusterer = nullptr;
-	Bool m_frustumChanged;
-
-	Error operator()(U32 threadId, PtrSize threadsCount)
-	{
-		m_clusterer->update(threadId, threadsCount, m_frustumChanged);
-		return ErrorCode::NONE;
-	}
-};
-
 //==============================================================================
 static Vec4 unproject(const F32 depth, const Vec2& ndc, const Vec4& projParams)
 {
@@ -157,7 +143,7 @@ void Clusterer::init(const GenericMemoryPoolAllocator<U8>& alloc,
 }
 
 //==============================================================================
-void Clusterer::prepare(ThreadPool& threadPool, const FrustumComponent& frc)
+void Clusterer::prepare(ThreadHive& threadHive, const FrustumComponent& frc)
 {
 	// Get some things
 	Timestamp frcTimestamp = frc.getTimestamp();
@@ -174,33 +160,38 @@ void Clusterer::prepare(ThreadPool& threadPool, const FrustumComponent& frc)
 	m_calcNearOpt = (m_far - m_near) / pow(m_counts[2], 2.0);
 	m_shaderMagicVal = -1.0 / m_calcNearOpt;
 
-	//
-	// Issue parallel jobs
-	//
-	Array<UpdatePlanesPerspectiveCameraTask, ThreadPool::MAX_THREADS> jobs;
-
 	// Do a job that transforms only the planes when:
 	// - it's the same frustum component as before and
 	// - the component has not changed
 	Bool frustumChanged =
 		frcTimestamp > m_planesLSpaceTimestamp || m_node != node;
 
-	for(U i = 0; i < threadPool.getThreadsCount(); i++)
-	{
-		jobs[i].m_clusterer = this;
-		jobs[i].m_frustumChanged = frustumChanged;
-		threadPool.assignNewTask(i, &jobs[i]);
-	}
+	// Update the Y and X planes in parallel. The range covers both
+	const PtrSize planeCount = m_planesYW.getSize() + m_planesXW.getSize();
+	const PtrSize PLANES_PER_CHUNK = 4;
+	Error err = threadHive.parallelFor(0,
+		planeCount,
+		PLANES_PER_CHUNK,
+		[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+			update(start, end, frustumChanged);
+			return ErrorCode::NONE;
+		});
+	(void)err;
+
+	// Finaly tranform the near and far planes
+	const Transform& trf = frc.getFrustum().getTransform();
+
+	*m_nearPlane = Plane(Vec4(0.0, 0.0, -1.0, 0.0), m_near);
+	m_nearPlane->transform(trf);
+
+	*m_farPlane = Plane(Vec4(0.0, 0.0, 1.0, 0.0), -m_far);
+	m_farPlane->transform(trf);
 
 	// Update timestamp
 	if(frustumChanged)
 	{
 		m_planesLSpaceTimestamp = frcTimestamp;
 	}
-
-	// Sync threads
-	Error err = threadPool.waitForAllThreadsToFinish();
-	(void)err;
 }
 
 //==============================================================================
@@ -535,73 +526,41 @@ void Clusterer::binGeneric(const CollisionShape& cs,
 }
 
 //==============================================================================
-void Clusterer::update(U32 threadId, PtrSize threadsCount, Bool frustumChanged)
+void Clusterer::update(PtrSize start, PtrSize end, Bool frustumChanged)
 {
-	PtrSize start, end;
 	const FrustumComponent& frc = *m_frc;
 	ANKI_ASSERT(frc.getFrustum().getType() == Frustum::Type::PERSPECTIVE);
 
 	const Transform& trf = frc.getFrustum().getTransform();
 	const Vec4& projParams = frc.getProjectionParameters();
+	const U yCount = m_planesYW.getSize();
 
-	if(frustumChanged)
+	for(PtrSize idx = start; idx < end; ++idx)
 	{
-		// Re-calculate the planes in local space
-
-		// First the top looking planes
-		ThreadPoolTask::choseStartEnd(
-			threadId, threadsCount, m_planesYW.getSize(), start, end);
-
-		for(U i = start; i < end; i++)
+		if(idx < yCount)
 		{
-			calcPlaneY(i, projParams);
+			// A top looking plane
+			const U i = idx;
+			if(frustumChanged)
+			{
+				// Re-calculate the plane in local space
+				calcPlaneY(i, projParams);
+			}
 
 			m_planesYW[i] = m_planesY[i].getTransformed(trf);
 		}
-
-		// Then the right looking planes
-		ThreadPoolTask::choseStartEnd(
-			threadId, threadsCount, m_planesXW.getSize(), start, end);
-
-		for(U j = start; j < end; j++)
-		{
-			calcPlaneX(j, projParams);
-
-			m_planesXW[j] = m_planesX[j].getTransformed(trf);
-		}
-	}
-	else
-	{
-		// Only transform planes
-
-		// First the top looking planes
-		ThreadPoolTask::choseStartEnd(
-			threadId, threadsCount, m_planesYW.getSize(), start, end);
-
-		for(U i = start; i < end; i++)
+		else
 		{
-			m_planesYW[i] = m_planesY[i].getTransformed(trf);
-		}
-
-		// Then the right looking planes
-		ThreadPoolTask::choseStartEnd(
-			threadId, threadsCount, m_planesXW.getSize(), start, end);
+			// A right looking plane
+			const U j = idx - yCount;
+			if(frustumChanged)
+			{
+				calcPlaneX(j, projParams);
+			}
 
-		for(U j = start; j < end; j++)
-		{
 			m_planesXW[j] = m_planesX[j].getTransformed(trf);
 		}
 	}
-
-	// Finaly tranform the near and far planes
-	if(threadId == 0)
-	{
-		*m_nearPlane = Plane(Vec4(0.0, 0.0, -1.0, 0.0), m_near);
-		m_nearPlane->transform(trf);
-
-		*m_farPlane = Plane(Vec4(0.0, 0.0, 1.0, 0.0), -m_far);
-		m_farPlane->transform(trf);
-	}
 }
 
 } // end namespace anki
@@ -228,8 +228,7 @@ Error Dbg::run(RenderingContext& ctx)
 		{
 			for(U x = 0; x < m_r->getTileCountXY().x(); ++x)
 			{
-				F32 d = r.m_zbuffer[y * m_r->getTileCountXY().x() + x].get()
-					/ F32(MAX_U32);
+				F32 d = r.getDepth(x, y);
 
 				if(d < 1.0)
 				{
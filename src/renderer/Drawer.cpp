@@ -38,6 +38,13 @@ public:
 	F32 m_flod = 0.0;
 	VisibleNode* m_visibleNode = nullptr;
 	VisibleNode* m_nextVisibleNode = nullptr;
+
+	/// The drawcalls of the renderables that are batched. Every drawcall
+	/// draws the merged instances of a model.
+	Array<DrawElementsIndirectInfo, MAX_INSTANCES> m_batchedDrawcalls;
+	U m_batchedDrawcallCount = 0;
+	Bool8 m_newDrawcall = true; ///< The next renderable starts a drawcall.
+	Bool8 m_batchDrawcalls = false;
 };
 
 /// Visitor that sets a uniform
@@ -68,7 +75,6 @@ template<typename TRenderableVariableTemplate>
 Error SetupRenderableVariableVisitor::visit(
 	const TRenderableVariableTemplate& rvar)
 {
-	using DataType = typename TRenderableVariableTemplate::Type;
 	const MaterialVariable& mvar = rvar.getMaterialVariable();
 
 	// Array size
@@ -82,9 +88,6 @@ Error SetupRenderableVariableVisitor::visit(
 
 	switch(mvar.getBuiltin())
 	{
-	case BuiltinMaterialVariableId::NONE:
-		uniSet<DataType>(mvar, &rvar.getValue(), 1);
-		break;
 	case BuiltinMaterialVariableId::MVP_MATRIX:
 	{
 		ANKI_ASSERT(cachedTrfs > 0);
@@ -184,16 +187,6 @@ Error SetupRenderableVariableVisitor::visit(
 	return ErrorCode::NONE;
 }
 
-//==============================================================================
-// Texture specialization
-template<>
-void SetupRenderableVariableVisitor::uniSet<TextureResourcePtr>(
-	const MaterialVariable& mtlvar, const TextureResourcePtr* values, U32 size)
-{
-	ANKI_ASSERT(size == 1);
-	// Do nothing
-}
-
 //==============================================================================
 // RenderableDrawer                                                            =
 //==============================================================================
@@ -219,20 +212,25 @@ void RenderableDrawer::setupUniforms(DrawContext& ctx,
 			BufferUsageBit::UNIFORM_ANY_SHADER,
 			ctx.m_dynBufferInfo.m_uniformBuffers[0]));
 
-	// Call the visitor
+	// Copy the variables that don't change from frame to frame
+	WeakArray<U8> uniformBuffer(uniforms, variant.getDefaultBlockSize());
+	renderable.writeUniformBlock(variant, key.m_pass, uniformBuffer);
+
+	// Call the visitor for the rest
 	SetupRenderableVariableVisitor visitor;
 	visitor.m_ctx = &ctx;
 	visitor.m_drawer = this;
-	visitor.m_uniformBuffer =
-		WeakArray<U8>(uniforms, variant.getDefaultBlockSize());
+	visitor.m_uniformBuffer = uniformBuffer;
 
 	for(auto it = renderable.getVariablesBegin();
 		it != renderable.getVariablesEnd();
 		++it)
 	{
 		RenderComponentVariable* rvar = *it;
+		const MaterialVariable& mvar = rvar->getMaterialVariable();
 
-		if(variant.variableActive(rvar->getMaterialVariable()))
+		if(mvar.getBuiltin() != BuiltinMaterialVariableId::NONE
+			&& variant.variableActive(mvar))
 		{
 			Error err = rvar->acceptVisitor(visitor);
 			(void)err;
@@ -253,6 +251,7 @@ Error RenderableDrawer::drawRange(Pass pass,
 	ctx.m_frc = &frc;
 	ctx.m_pass = pass;
 	ctx.m_cmdb = cmdb;
+	ctx.m_batchDrawcalls = m_r->getGrManager().getBaseInstanceSupported();
 
 	for(; begin != end; ++begin)
 	{
@@ -273,6 +272,33 @@ Error RenderableDrawer::drawRange(Pass pass,
 	return ErrorCode::NONE;
 }
 
+//==============================================================================
+void RenderableDrawer::stashDrawcall(
+	DrawContext& ctx, const RenderComponent& renderable)
+{
+	ANKI_ASSERT(ctx.m_cachedTrfCount > 0);
+
+	if(ctx.m_newDrawcall)
+	{
+		DrawElementsIndirectInfo& draw =
+			ctx.m_batchedDrawcalls[ctx.m_batchedDrawcallCount++];
+
+		RenderingKey key(ctx.m_pass, U8(ctx.m_flod), false, 1);
+		renderable.getDrawcall(key, draw);
+
+		// The instances of the drawcall start from the current transform
+		draw.m_instanceCount = 1;
+		draw.m_baseInstance = ctx.m_cachedTrfCount - 1;
+	}
+	else
+	{
+		// Merged with the previous renderable
+		ANKI_ASSERT(ctx.m_batchedDrawcallCount > 0);
+		++ctx.m_batchedDrawcalls[ctx.m_batchedDrawcallCount - 1]
+			  .m_instanceCount;
+	}
+}
+
 //==============================================================================
 Error RenderableDrawer::drawSingle(DrawContext& ctx)
 {
@@ -281,25 +307,30 @@ Error RenderableDrawer::drawSingle(DrawContext& ctx)
 		ctx.m_visibleNode->m_node->getComponent<RenderComponent>();
 	const Material& mtl = renderable.getMaterial();
 
-	// Check if it can merge drawcalls
-	if(ctx.m_nextVisibleNode)
+	// Calculate the LOD
+	F32 flod =
+		m_r->calculateLod(sqrt(ctx.m_visibleNode->m_frustumDistanceSquared));
+	flod = min<F32>(flod, MAX_LODS - 1);
+	ctx.m_flod = flod;
+
+	// Check if it can merge drawcalls with the next renderable (same model)
+	// or batch them (same material, different model)
+	Bool skipDrawcall = false;
+	Bool batch = false;
+	if(ctx.m_nextVisibleNode && ctx.m_cachedTrfCount < MAX_INSTANCES - 1)
 	{
 		const RenderComponent& nextRenderable =
 			ctx.m_nextVisibleNode->m_node->getComponent<RenderComponent>();
 
-		if(nextRenderable.canMergeDrawcalls(renderable)
-			&& ctx.m_cachedTrfCount < MAX_INSTANCES - 1)
+		if(nextRenderable.canMergeDrawcalls(renderable))
 		{
-			// Can merge, will cache the drawcall and skip the drawcall
-			Bool hasTransform;
-			Transform trf;
-			renderable.getRenderWorldTransform(hasTransform, trf);
-			ANKI_ASSERT(hasTransform);
-
-			ctx.m_cachedTrfs[ctx.m_cachedTrfCount] = Mat4(trf);
-			++ctx.m_cachedTrfCount;
-
-			return ErrorCode::NONE;
+			skipDrawcall = true;
+		}
+		else if(ctx.m_batchDrawcalls
+			&& nextRenderable.canBatchDrawcalls(renderable))
+		{
+			skipDrawcall = true;
+			batch = true;
 		}
 	}
 
@@ -308,6 +339,7 @@ Error RenderableDrawer::drawSingle(DrawContext& ctx)
 		Bool hasTransform;
 		Transform trf;
 		renderable.getRenderWorldTransform(hasTransform, trf);
+		ANKI_ASSERT(hasTransform || !skipDrawcall);
 
 		if(hasTransform)
 		{
@@ -316,12 +348,20 @@ Error RenderableDrawer::drawSingle(DrawContext& ctx)
 		}
 	}
 
-	// Calculate the key
-	F32 flod =
-		m_r->calculateLod(sqrt(ctx.m_visibleNode->m_frustumDistanceSquared));
-	flod = min<F32>(flod, MAX_LODS - 1);
-	ctx.m_flod = flod;
+	// Stash the drawcall in case it's batched with others
+	if(ctx.m_batchDrawcalls && renderable.canBatchDrawcalls(renderable))
+	{
+		stashDrawcall(ctx, renderable);
+	}
 
+	if(skipDrawcall)
+	{
+		// Will draw it with the next renderable
+		ctx.m_newDrawcall = batch;
+		return ErrorCode::NONE;
+	}
+
+	// Calculate the key
 	RenderingBuildInfo build;
 	build.m_key.m_lod = flod;
 	build.m_key.m_pass = ctx.m_pass;
@@ -335,6 +375,10 @@ Error RenderableDrawer::drawSingle(DrawContext& ctx)
 		build.m_key.m_tessellation = false;
 	}
 
+	// Don't wait for variants that are not created. Draw with a similar one
+	// while they are created in the background
+	build.m_key = mtl.getVariantKeyAsync(build.m_key);
+
 	// Enqueue uniform state updates
 	setupUniforms(ctx, renderable, build.m_key);
 
@@ -344,6 +388,21 @@ Error RenderableDrawer::drawSingle(DrawContext& ctx)
 	build.m_cmdb = ctx.m_cmdb;
 	build.m_dynamicBufferInfo = &ctx.m_dynBufferInfo;
 
+	if(ctx.m_batchedDrawcallCount > 1)
+	{
+		// Draw all the batched renderables with one indirect drawcall
+		const PtrSize size =
+			ctx.m_batchedDrawcallCount * sizeof(DrawElementsIndirectInfo);
+		void* mem = m_r->getGrManager().allocateFrameTransientMemory(
+			size, BufferUsageBit::INDIRECT, build.m_indirectDrawcalls);
+		memcpy(mem, &ctx.m_batchedDrawcalls[0], size);
+
+		build.m_indirectDrawcallCount = ctx.m_batchedDrawcallCount;
+
+		ANKI_TRACE_INC_COUNTER(
+			RENDERER_BATCHED_DRAWCALLS, ctx.m_batchedDrawcallCount - 1);
+	}
+
 	ANKI_CHECK(renderable.buildRendering(build));
 
 	// Rendered something, reset the cached transforms
@@ -353,6 +412,8 @@ Error RenderableDrawer::drawSingle(DrawContext& ctx)
 			RENDERER_MERGED_DRAWCALLS, ctx.m_cachedTrfCount - 1);
 	}
 	ctx.m_cachedTrfCount = 0;
+	ctx.m_batchedDrawcallCount = 0;
+	ctx.m_newDrawcall = true;
 
 	return ErrorCode::NONE;
 }
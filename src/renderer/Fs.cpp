@@ -10,6 +10,7 @@
 #include <anki/renderer/Sm.h>
 #include <anki/scene/SceneGraph.h>
 #include <anki/scene/FrustumComponent.h>
+#include <anki/util/ThreadHive.h>
 
 namespace anki
 {
@@ -80,8 +81,7 @@ Error Fs::buildCommandBuffers(
 
 	U problemSize = vis.getCount(VisibilityGroupType::RENDERABLES_FS);
 	PtrSize start, end;
-	ThreadPoolTask::choseStartEnd(
-		threadId, threadCount, problemSize, start, end);
+	splitThreadedProblem(threadId, threadCount, problemSize, start, end);
 
 	if(start == end)
 	{
@@ -119,7 +119,7 @@ void Fs::run(RenderingContext& ctx)
 	cmdb->setViewport(0, 0, m_width, m_height);
 	cmdb->setPolygonOffset(0.0, 0.0);
 
-	for(U i = 0; i < m_r->getThreadPool().getThreadsCount(); ++i)
+	for(U i = 0; i < m_r->getThreadHive().getThreadCount(); ++i)
 	{
 		if(ctx.m_fs.m_commandBuffers[i].isCreated())
 		{
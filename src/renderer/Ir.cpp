@@ -65,7 +65,7 @@ Error Ir::init(const ConfigSet& config)
 	nestedRConfig.set("ir.enabled", false); // Very important to disable that
 	nestedRConfig.set("sslr.enabled", false); // And that
 
-	ANKI_CHECK(m_nestedR.init(&m_r->getThreadPool(),
+	ANKI_CHECK(m_nestedR.init(&m_r->getThreadHive(),
 		&m_r->getResourceManager(),
 		&m_r->getGrManager(),
 		m_r->getAllocator(),
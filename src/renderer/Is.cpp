@@ -85,7 +85,7 @@ Error Is::initInternal(const ConfigSet& config)
 		m_r->getTileCountXY().x(),
 		m_r->getTileCountXY().y(),
 		config.getNumber("clusterSizeZ"),
-		&m_r->getThreadPool(),
+		&m_r->getThreadHive(),
 		&getGrManager());
 
 	//
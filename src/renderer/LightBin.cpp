@@ -8,9 +8,10 @@
 #include <anki/scene/Visibility.h>
 #include <anki/scene/MoveComponent.h>
 #include <anki/scene/LightComponent.h>
+#include <anki/scene/SpatialComponent.h>
 #include <anki/scene/ReflectionProbeComponent.h>
 #include <anki/core/Trace.h>
-#include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHive.h>
 
 namespace anki
 {
@@ -25,10 +26,12 @@ namespace anki
 
 struct ShaderCluster
 {
-	/// If m_combo = 0xFFFF?CAB then FFFF is the light index offset, A the
-	/// number of point lights and B the number of spot lights, C the number
-	/// of probes
-	U32 m_combo;
+	/// Offset in the light index buffer.
+	U32 m_indexOffset;
+
+	/// If m_counts = 0xCCCBBBAAA then A is the number of spot lights, B the
+	/// number of point lights and C the number of probes. 10 bits each.
+	U32 m_counts;
 };
 
 struct ShaderLight
@@ -63,197 +66,74 @@ struct ShaderProbe
 	}
 };
 
-static const U MAX_TYPED_LIGHTS_PER_CLUSTER = 16;
-static const U MAX_PROBES_PER_CLUSTER = 12;
+static const U MAX_ELEMENTS_PER_CLUSTER = 0x3FF;
 static const F32 INVALID_TEXTURE_INDEX = 128.0;
 
-class ClusterLightIndex
+/// The types of the binned elements. It's also the order of their indices
+/// in a cluster.
+enum ElementType
 {
-public:
-	ClusterLightIndex()
-	{
-		// Do nothing. No need to initialize
-	}
-
-	U getIndex() const
-	{
-		return m_index;
-	}
-
-	void setIndex(U i)
-	{
-		ANKI_ASSERT(i <= MAX_U16);
-		m_index = i;
-	}
-
-private:
-	U16 m_index;
+	POINT_LIGHT,
+	SPOT_LIGHT,
+	PROBE,
+	ELEMENT_TYPE_COUNT
 };
 
-static Bool operator<(const ClusterLightIndex& a, const ClusterLightIndex& b)
-{
-	return a.getIndex() < b.getIndex();
-}
-
-/// Store the probe radius for sorting the indices.
-/// WARNING: Keep it as small as possible, that's why the members are U16
-class ClusterProbeIndex
+/// The elements of a cluster. Their indices are stored in
+/// LightBinContext::m_indices starting from m_offset.
+class ClusterData
 {
 public:
-	ClusterProbeIndex()
-	{
-		// Do nothing. No need to initialize
-	}
+	/// The number of elements per type. It's used as a cursor when the
+	/// indices are scattered.
+	Array<Atomic<U32>, ELEMENT_TYPE_COUNT> m_cursors;
+	Array<U32, ELEMENT_TYPE_COUNT> m_counts;
+	U32 m_offset;
 
-	U getIndex() const
-	{
-		return m_index;
-	}
-
-	void setIndex(U i)
+	ClusterData()
 	{
-		ANKI_ASSERT(i <= MAX_U16);
-		m_index = i;
+		// Do nothing. No need to initialize
 	}
 
-	F32 getProbeRadius() const
+	void reset()
 	{
-		return F32(m_probeRadius) / F32(MAX_U16) * F32(MAX_PROBE_RADIUS);
+		for(Atomic<U32>& c : m_cursors)
+		{
+			c.set(0);
+		}
 	}
 
-	void setProbeRadius(F32 r)
+	U getCount() const
 	{
-		ANKI_ASSERT(r < MAX_PROBE_RADIUS);
-		m_probeRadius = r / F32(MAX_PROBE_RADIUS) * F32(MAX_U16);
+		return m_counts[POINT_LIGHT] + m_counts[SPOT_LIGHT] + m_counts[PROBE];
 	}
-
-private:
-	static const U MAX_PROBE_RADIUS = 1000;
-	U16 m_index;
-	U16 m_probeRadius;
 };
-static_assert(
-	sizeof(ClusterProbeIndex) == sizeof(U16) * 2, "Because we memcmp");
 
-/// WARNING: Keep it as small as possible. The number of clusters is huge
-class alignas(U32) ClusterData
+/// Get the last time an element changed.
+static Timestamp getElementTimestamp(const SceneNode& node)
 {
-public:
-	Atomic<U8> m_pointCount;
-	Atomic<U8> m_spotCount;
-	Atomic<U8> m_probeCount;
-
-	Array<ClusterLightIndex, MAX_TYPED_LIGHTS_PER_CLUSTER> m_pointIds;
-	Array<ClusterLightIndex, MAX_TYPED_LIGHTS_PER_CLUSTER> m_spotIds;
-	Array<ClusterProbeIndex, MAX_PROBES_PER_CLUSTER> m_probeIds;
+	Timestamp time = 0;
 
-	ClusterData()
-	{
-		// Do nothing. No need to initialize
-	}
-
-	void reset()
+	const MoveComponent* movc = node.tryGetComponent<MoveComponent>();
+	if(movc)
 	{
-		// Set the counts to zero and try to be faster
-		*reinterpret_cast<U32*>(&m_pointCount) = 0;
+		time = max(time, movc->getTimestamp());
 	}
 
-	void normalizeCounts()
+	const SpatialComponent* spc = node.tryGetComponent<SpatialComponent>();
+	if(spc)
 	{
-		normalize(m_pointCount, MAX_TYPED_LIGHTS_PER_CLUSTER, "point lights");
-		normalize(m_spotCount, MAX_TYPED_LIGHTS_PER_CLUSTER, "spot lights");
-		normalize(m_probeCount, MAX_PROBES_PER_CLUSTER, "probes");
+		time = max(time, spc->getTimestamp());
 	}
 
-	void sortLightIds()
+	const LightComponent* lightc = node.tryGetComponent<LightComponent>();
+	if(lightc)
 	{
-		const U pointCount = m_pointCount.get();
-		if(pointCount > 1)
-		{
-			std::sort(&m_pointIds[0], &m_pointIds[0] + pointCount);
-		}
-
-		const U spotCount = m_spotCount.get();
-		if(spotCount > 1)
-		{
-			std::sort(&m_spotIds[0], &m_spotIds[0] + spotCount);
-		}
-
-		const U probeCount = m_probeCount.get();
-		if(probeCount > 1)
-		{
-			std::sort(m_probeIds.getBegin(),
-				m_probeIds.getBegin() + probeCount,
-				[](const ClusterProbeIndex& a, const ClusterProbeIndex& b) {
-					ANKI_ASSERT(
-						a.getProbeRadius() > 0.0 && b.getProbeRadius() > 0.0);
-					return a.getProbeRadius() < b.getProbeRadius();
-				});
-		}
-	}
-
-	Bool operator==(const ClusterData& b) const
-	{
-		const U pointCount = m_pointCount.get();
-		const U spotCount = m_spotCount.get();
-		const U probeCount = m_probeCount.get();
-		const U pointCount2 = b.m_pointCount.get();
-		const U spotCount2 = b.m_spotCount.get();
-		const U probeCount2 = b.m_probeCount.get();
-
-		if(pointCount != pointCount2 || spotCount != spotCount2
-			|| probeCount != probeCount2)
-		{
-			return false;
-		}
-
-		if(pointCount > 0)
-		{
-			if(memcmp(&m_pointIds[0],
-				   &b.m_pointIds[0],
-				   sizeof(m_pointIds[0]) * pointCount)
-				!= 0)
-			{
-				return false;
-			}
-		}
-
-		if(spotCount > 0)
-		{
-			if(memcmp(&m_spotIds[0],
-				   &b.m_spotIds[0],
-				   sizeof(m_spotIds[0]) * spotCount)
-				!= 0)
-			{
-				return false;
-			}
-		}
-
-		if(probeCount > 0)
-		{
-			if(memcmp(&m_probeIds[0],
-				   &b.m_probeIds[0],
-				   sizeof(b.m_probeIds[0]) * probeCount)
-				!= 0)
-			{
-				return false;
-			}
-		}
-
-		return true;
+		time = max(time, lightc->getTimestamp());
 	}
 
-private:
-	static void normalize(Atomic<U8>& count, const U maxCount, CString what)
-	{
-		U8 a = count.get();
-		count.set(a % maxCount);
-		if(ANKI_UNLIKELY(a >= maxCount))
-		{
-			ANKI_LOGW("Increase cluster limit: %s", &what[0]);
-		}
-	}
-};
+	return time;
+}
 
 /// Common data for all tasks.
 class LightBinContext
@@ -270,6 +150,10 @@ public:
 	Bool m_shadowsEnabled = false;
 	StackAllocator<U8> m_alloc;
 
+	/// Bins made before that time are stale.
+	Timestamp m_cameraTimestamp = 0;
+	Timestamp m_crntTimestamp = 0;
+
 	// To fill the light buffers
 	WeakArray<ShaderPointLight> m_pointLights;
 	WeakArray<ShaderSpotLight> m_spotLights;
@@ -278,13 +162,15 @@ public:
 	WeakArray<U32> m_lightIds;
 	WeakArray<ShaderCluster> m_clusters;
 
-	Atomic<U32> m_pointLightsCount = {0};
-	Atomic<U32> m_spotLightsCount = {0};
-	Atomic<U32> m_probeCount = {0};
-
 	// To fill the tile buffers
 	DynamicArrayAuto<ClusterData> m_tempClusters;
 
+	/// The indices of all the clusters one after the other.
+	WeakArray<U32> m_indices;
+
+	/// The radius of the probes to sort them.
+	WeakArray<F32> m_probeRadii;
+
 	// To fill the light index buffer
 	Atomic<U32> m_lightIdsCount = {0};
 
@@ -293,22 +179,42 @@ public:
 	WeakArray<VisibleNode> m_vSpotLights;
 	WeakArray<VisibleNode> m_vProbes;
 
-	Atomic<U32> m_count = {0};
-	Atomic<U32> m_count2 = {0};
+	/// The bins of all the elements. Point lights, spot lights and then probes.
+	WeakArray<LightBin::CachedBin*> m_bins;
 
-	LightBin* m_bin = nullptr;
-};
+	/// One per thread.
+	Array<ClustererTestResult, ThreadHive::MAX_THREADS> m_testResults;
 
-/// Write the lights to the GPU buffers.
-class WriteLightsTask : public ThreadPoolTask
-{
-public:
-	LightBinContext* m_ctx = nullptr;
+	U getElementCount() const
+	{
+		return m_vPointLights.getSize() + m_vSpotLights.getSize()
+			+ m_vProbes.getSize();
+	}
 
-	Error operator()(U32 threadId, PtrSize threadsCount)
+	/// Get the node, the type and the index per type of an element.
+	SceneNode& getElement(U elementIdx, U& type, U& idx) const
 	{
-		m_ctx->m_bin->binLights(threadId, threadsCount, *m_ctx);
-		return ErrorCode::NONE;
+		const U pointCount = m_vPointLights.getSize();
+		const U lightCount = pointCount + m_vSpotLights.getSize();
+
+		if(elementIdx >= lightCount)
+		{
+			type = PROBE;
+			idx = elementIdx - lightCount;
+			return *m_vProbes[idx].m_node;
+		}
+		else if(elementIdx >= pointCount)
+		{
+			type = SPOT_LIGHT;
+			idx = elementIdx - pointCount;
+			return *m_vSpotLights[idx].m_node;
+		}
+		else
+		{
+			type = POINT_LIGHT;
+			idx = elementIdx;
+			return *m_vPointLights[idx].m_node;
+		}
 	}
 };
 
@@ -321,13 +227,12 @@ LightBin::LightBin(const GenericMemoryPoolAllocator<U8>& alloc,
 	U clusterCountX,
 	U clusterCountY,
 	U clusterCountZ,
-	ThreadPool* threadPool,
+	ThreadHive* threadHive,
 	GrManager* gr)
 	: m_alloc(alloc)
 	, m_clusterCount(clusterCountX * clusterCountY * clusterCountZ)
-	, m_threadPool(threadPool)
+	, m_threadHive(threadHive)
 	, m_gr(gr)
-	, m_barrier(threadPool->getThreadsCount())
 {
 	m_clusterer.init(alloc, clusterCountX, clusterCountY, clusterCountZ);
 }
@@ -335,6 +240,13 @@ LightBin::LightBin(const GenericMemoryPoolAllocator<U8>& alloc,
 //==============================================================================
 LightBin::~LightBin()
 {
+	for(CachedBin* bin : m_cache)
+	{
+		bin->m_clusters.destroy(m_alloc);
+		m_alloc.deleteInstance(bin);
+	}
+
+	m_cache.destroy(m_alloc);
 }
 
 //==============================================================================
@@ -351,7 +263,7 @@ Error LightBin::bin(FrustumComponent& frc,
 	ANKI_TRACE_START_EVENT(RENDERER_LIGHT_BINNING);
 
 	// Prepare the clusterer
-	m_clusterer.prepare(*m_threadPool, frc);
+	m_clusterer.prepare(*m_threadHive, frc);
 
 	VisibilityTestResults& vi = frc.getVisibilityTestResults();
 
@@ -368,13 +280,18 @@ Error LightBin::bin(FrustumComponent& frc,
 	//
 	// Write the lights and tiles UBOs
 	//
-	Array<WriteLightsTask, ThreadPool::MAX_THREADS> tasks;
 	LightBinContext ctx(frameAlloc);
 	ctx.m_frc = &frc;
 	ctx.m_maxLightIndices = maxLightIndices;
 	ctx.m_shadowsEnabled = shadowsEnabled;
 	ctx.m_tempClusters.create(m_clusterCount);
 
+	// The bins depend on the camera as well
+	const SceneNode& camNode = frc.getSceneNode();
+	const MoveComponent& camMove = camNode.getComponent<MoveComponent>();
+	ctx.m_cameraTimestamp = max(frc.getTimestamp(), camMove.getTimestamp());
+	ctx.m_crntTimestamp = camNode.getGlobalTimestamp();
+
 	if(visiblePointLightsCount)
 	{
 		ShaderPointLight* data =
@@ -430,6 +347,9 @@ Error LightBin::bin(FrustumComponent& frc,
 			ctx.m_vProbes = WeakArray<VisibleNode>(
 				vi.getBegin(VisibilityGroupType::REFLECTION_PROBES),
 				visibleProbeCount);
+
+			ctx.m_probeRadii = WeakArray<F32>(
+				frameAlloc.newArray<F32>(visibleProbeCount), visibleProbeCount);
 		}
 		else
 		{
@@ -437,8 +357,6 @@ Error LightBin::bin(FrustumComponent& frc,
 		}
 	}
 
-	ctx.m_bin = this;
-
 	// Get mem for clusters
 	ShaderCluster* data =
 		static_cast<ShaderCluster*>(m_gr->allocateFrameTransientMemory(
@@ -456,207 +374,310 @@ Error LightBin::bin(FrustumComponent& frc,
 
 	ctx.m_lightIds = WeakArray<U32>(data2, maxLightIndices);
 
-	// Fire the async job
-	for(U i = 0; i < m_threadPool->getThreadsCount(); i++)
+	// Initialize the temp clusters
+	const PtrSize CLUSTERS_PER_CHUNK = 16;
+	ANKI_CHECK(m_threadHive->parallelFor(0,
+		m_clusterCount,
+		CLUSTERS_PER_CHUNK * 4,
+		[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+			for(PtrSize i = start; i < end; ++i)
+			{
+				ctx.m_tempClusters[i].reset();
+			}
+
+			return ErrorCode::NONE;
+		}));
+
+	// Get the bins of the previous frames
+	updateCache(ctx);
+
+	// Write the lights and probes and count them in the clusters
+	for(U i = 0; i < m_threadHive->getThreadCount(); ++i)
+	{
+		m_clusterer.initTestResults(ctx.m_alloc, ctx.m_testResults[i]);
+	}
+
+	const U totalCount = ctx.getElementCount();
+	ANKI_CHECK(m_threadHive->parallelFor(0,
+		totalCount,
+		1,
+		[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+			binLights(start, end, ctx, ctx.m_testResults[threadId]);
+			return ErrorCode::NONE;
+		}));
+
+	// Prefix sum to find where the indices of every cluster go
+	U32 indexCount = 0;
+	for(ClusterData& cluster : ctx.m_tempClusters)
 	{
-		tasks[i].m_ctx = &ctx;
+		cluster.m_offset = indexCount;
 
-		m_threadPool->assignNewTask(i, &tasks[i]);
+		for(U t = 0; t < ELEMENT_TYPE_COUNT; ++t)
+		{
+			cluster.m_counts[t] = cluster.m_cursors[t].get();
+			cluster.m_cursors[t].set(0);
+		}
+
+		indexCount += cluster.getCount();
 	}
 
-	// Sync
-	ANKI_CHECK(m_threadPool->waitForAllThreadsToFinish());
+	if(indexCount > 0)
+	{
+		ctx.m_indices =
+			WeakArray<U32>(frameAlloc.newArray<U32>(indexCount), indexCount);
+
+		// Scatter the indices of the elements
+		ANKI_CHECK(m_threadHive->parallelFor(0,
+			totalCount,
+			1,
+			[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+				scatterLights(start, end, ctx);
+				return ErrorCode::NONE;
+			}));
+	}
+
+	// Last thing, update the real clusters. The merging of identical clusters
+	// happens inside a chunk
+	ANKI_CHECK(m_threadHive->parallelFor(0,
+		m_clusterCount,
+		CLUSTERS_PER_CHUNK,
+		[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+			writeClusters(start, end, ctx);
+			return ErrorCode::NONE;
+		}));
 
 	ANKI_TRACE_STOP_EVENT(RENDERER_LIGHT_BINNING);
 	return ErrorCode::NONE;
 }
 
 //==============================================================================
-void LightBin::binLights(
-	U32 threadId, PtrSize threadsCount, LightBinContext& ctx)
+void LightBin::updateCache(LightBinContext& ctx)
+{
+	++m_frame;
+
+	const U count = ctx.getElementCount();
+	if(count > 0)
+	{
+		ctx.m_bins = WeakArray<CachedBin*>(
+			ctx.m_alloc.newArray<CachedBin*>(count), count);
+	}
+
+	for(U i = 0; i < count; ++i)
+	{
+		U type, idx;
+		const SceneNode& node = ctx.getElement(i, type, idx);
+		const U64 key = ptrToNumber(&node);
+
+		auto it = m_cache.find(key);
+		CachedBin* bin;
+		if(it != m_cache.getEnd())
+		{
+			bin = *it;
+		}
+		else
+		{
+			bin = m_alloc.newInstance<CachedBin>();
+			m_cache.pushBack(m_alloc, key, bin);
+		}
+
+		bin->m_frame = m_frame;
+		ctx.m_bins[i] = bin;
+	}
+
+	// Throw away the bins of the nodes that are not visible
+	auto it = m_cache.getBegin();
+	while(it != m_cache.getEnd())
+	{
+		auto next = it;
+		++next;
+
+		CachedBin* bin = *it;
+		if(bin->m_frame != m_frame)
+		{
+			bin->m_clusters.destroy(m_alloc);
+			m_alloc.deleteInstance(bin);
+			m_cache.erase(m_alloc, it);
+		}
+
+		it = next;
+	}
+}
+
+//==============================================================================
+void LightBin::binLights(PtrSize start,
+	PtrSize end,
+	LightBinContext& ctx,
+	ClustererTestResult& testResult)
 {
 	ANKI_TRACE_START_EVENT(RENDERER_LIGHT_BINNING);
 	const FrustumComponent& camfrc = *ctx.m_frc;
 	const MoveComponent& cammove =
 		camfrc.getSceneNode().getComponent<MoveComponent>();
-	U clusterCount = m_clusterCount;
-	PtrSize start, end;
-
-	//
-	// Initialize the temp clusters
-	//
-	ThreadPoolTask::choseStartEnd(
-		threadId, threadsCount, clusterCount, start, end);
 
-	for(U i = start; i < end; ++i)
+	for(U j = start; j < end; ++j)
 	{
-		ctx.m_tempClusters[i].reset();
+		U type, i;
+		SceneNode& snode = ctx.getElement(j, type, i);
+
+		switch(type)
+		{
+		case POINT_LIGHT:
+		{
+			MoveComponent& move = snode.getComponent<MoveComponent>();
+			LightComponent& light = snode.getComponent<LightComponent>();
+
+			writePointLight(light, move, camfrc, i, ctx);
+			break;
+		}
+		case SPOT_LIGHT:
+		{
+			MoveComponent& move = snode.getComponent<MoveComponent>();
+			LightComponent& light = snode.getComponent<LightComponent>();
+			const FrustumComponent* frc =
+				snode.tryGetComponent<FrustumComponent>();
+
+			writeSpotLight(light, move, frc, cammove, camfrc, i, ctx);
+			break;
+		}
+		default:
+			ANKI_ASSERT(type == PROBE);
+			writeProbe(camfrc, snode, i, ctx);
+		}
+
+		binElement(snode, j, type, ctx, testResult);
 	}
 
 	ANKI_TRACE_STOP_EVENT(RENDERER_LIGHT_BINNING);
-	m_barrier.wait();
-	ANKI_TRACE_START_EVENT(RENDERER_LIGHT_BINNING);
+}
 
-	//
-	// Iterate lights and probes and bin them
-	//
-	ClustererTestResult testResult;
-	m_clusterer.initTestResults(ctx.m_alloc, testResult);
-	U lightCount = ctx.m_vPointLights.getSize() + ctx.m_vSpotLights.getSize();
-	U totalCount = lightCount + ctx.m_vProbes.getSize();
+//==============================================================================
+void LightBin::scatterLights(PtrSize start, PtrSize end, LightBinContext& ctx)
+{
+	ANKI_TRACE_START_EVENT(RENDERER_LIGHT_BINNING);
 
-	const U TO_BIN_COUNT = 1;
-	while((start = ctx.m_count2.fetchAdd(TO_BIN_COUNT)) < totalCount)
+	for(U j = start; j < end; ++j)
 	{
-		end = min<U>(start + TO_BIN_COUNT, totalCount);
+		U type, idx;
+		ctx.getElement(j, type, idx);
 
-		for(U j = start; j < end; ++j)
+		const CachedBin& bin = *ctx.m_bins[j];
+		for(U i = 0; i < bin.m_clusterCount; ++i)
 		{
-			if(j >= lightCount)
-			{
-				U i = j - lightCount;
-				SceneNode& snode = *ctx.m_vProbes[i].m_node;
-				writeAndBinProbe(camfrc, snode, ctx, testResult);
-			}
-			else if(j >= ctx.m_vPointLights.getSize())
-			{
-				U i = j - ctx.m_vPointLights.getSize();
+			ClusterData& cluster = ctx.m_tempClusters[bin.m_clusters[i]];
 
-				SceneNode& snode = *ctx.m_vSpotLights[i].m_node;
-				MoveComponent& move = snode.getComponent<MoveComponent>();
-				LightComponent& light = snode.getComponent<LightComponent>();
-				SpatialComponent& sp = snode.getComponent<SpatialComponent>();
-				const FrustumComponent* frc =
-					snode.tryGetComponent<FrustumComponent>();
-
-				I pos = writeSpotLight(light, move, frc, cammove, camfrc, ctx);
-				binLight(sp, pos, 1, ctx, testResult);
-			}
-			else
+			// The types are one after the other
+			U pos = cluster.m_offset + cluster.m_cursors[type].fetchAdd(1);
+			for(U t = 0; t < type; ++t)
 			{
-				U i = j;
-
-				SceneNode& snode = *ctx.m_vPointLights[i].m_node;
-				MoveComponent& move = snode.getComponent<MoveComponent>();
-				LightComponent& light = snode.getComponent<LightComponent>();
-				SpatialComponent& sp = snode.getComponent<SpatialComponent>();
-
-				I pos = writePointLight(light, move, camfrc, ctx);
-				binLight(sp, pos, 0, ctx, testResult);
+				pos += cluster.m_counts[t];
 			}
+
+			ctx.m_indices[pos] = idx;
 		}
 	}
 
-	//
-	// Last thing, update the real clusters
-	//
 	ANKI_TRACE_STOP_EVENT(RENDERER_LIGHT_BINNING);
-	m_barrier.wait();
+}
+
+//==============================================================================
+void LightBin::writeClusters(PtrSize start, PtrSize end, LightBinContext& ctx)
+{
 	ANKI_TRACE_START_EVENT(RENDERER_LIGHT_BINNING);
 
-	// Run per cluster
-	const U CLUSTER_GROUP = 16;
-	while((start = ctx.m_count.fetchAdd(CLUSTER_GROUP)) < clusterCount)
+	for(U i = start; i < end; ++i)
 	{
-		end = min<U>(start + CLUSTER_GROUP, clusterCount);
-
-		for(U i = start; i < end; ++i)
+		const ClusterData& cluster = ctx.m_tempClusters[i];
+		U countP = cluster.m_counts[POINT_LIGHT];
+		U countS = cluster.m_counts[SPOT_LIGHT];
+		U countProbe = cluster.m_counts[PROBE];
+
+		auto& c = ctx.m_clusters[i];
+		c.m_indexOffset = 0;
+		c.m_counts = 0;
+
+		// Early exit
+		const U count = countP + countS + countProbe;
+		if(ANKI_UNLIKELY(count == 0))
 		{
-			auto& cluster = ctx.m_tempClusters[i];
-			cluster.normalizeCounts();
+			continue;
+		}
 
-			const U countP = cluster.m_pointCount.get();
-			const U countS = cluster.m_spotCount.get();
-			const U countProbe = cluster.m_probeCount.get();
-			const U count = countP + countS + countProbe;
+		// Sort the indices so identical clusters compare equal
+		U32* indices = &ctx.m_indices[cluster.m_offset];
+		std::sort(indices, indices + countP);
+		std::sort(indices + countP, indices + countP + countS);
 
-			auto& c = ctx.m_clusters[i];
-			c.m_combo = 0;
+		const WeakArray<F32>& radii = ctx.m_probeRadii;
+		std::sort(indices + countP + countS,
+			indices + count,
+			[&radii](U32 a, U32 b) { return radii[a] < radii[b]; });
 
-			// Early exit
-			if(ANKI_UNLIKELY(count == 0))
+		// Check if the previous cluster contains the same lights as this
+		// one and if yes then merge them. This will avoid allocating new
+		// IDs (and thrashing GPU caches).
+		if(i != start)
+		{
+			const ClusterData& clusterB = ctx.m_tempClusters[i - 1];
+
+			if(memcmp(&cluster.m_counts[0],
+				   &clusterB.m_counts[0],
+				   sizeof(cluster.m_counts))
+					== 0
+				&& memcmp(indices,
+					   &ctx.m_indices[clusterB.m_offset],
+					   sizeof(U32) * count)
+					== 0)
 			{
+				c = ctx.m_clusters[i - 1];
 				continue;
 			}
+		}
 
-			// Check if the previous cluster contains the same lights as this
-			// one and if yes then merge them. This will avoid allocating new
-			// IDs (and thrashing GPU caches).
-			cluster.sortLightIds();
-			if(i != start)
-			{
-				const auto& clusterB = ctx.m_tempClusters[i - 1];
+		if(ANKI_UNLIKELY(countP > MAX_ELEMENTS_PER_CLUSTER
+			   || countS > MAX_ELEMENTS_PER_CLUSTER
+			   || countProbe > MAX_ELEMENTS_PER_CLUSTER))
+		{
+			ANKI_LOGW("Too many lights in a cluster");
+			countP = min<U>(countP, MAX_ELEMENTS_PER_CLUSTER);
+			countS = min<U>(countS, MAX_ELEMENTS_PER_CLUSTER);
+			countProbe = min<U>(countProbe, MAX_ELEMENTS_PER_CLUSTER);
+		}
 
-				if(cluster == clusterB)
-				{
-					c.m_combo = ctx.m_clusters[i - 1].m_combo;
-					continue;
-				}
-			}
+		U offset = ctx.m_lightIdsCount.fetchAdd(count);
 
-			U offset = ctx.m_lightIdsCount.fetchAdd(count);
+		if(offset + count <= ctx.m_maxLightIndices)
+		{
+			c.m_indexOffset = offset;
+			c.m_counts = (countProbe << 20) | (countP << 10) | countS;
 
-			if(offset + count <= ctx.m_maxLightIndices)
-			{
-				ANKI_ASSERT(offset <= 0xFFFF);
-				c.m_combo = offset << 16;
-
-				if(countP > 0)
-				{
-					ANKI_ASSERT(countP <= 0xF);
-					c.m_combo |= countP << 4;
-
-					for(U i = 0; i < countP; ++i)
-					{
-						ctx.m_lightIds[offset++] =
-							cluster.m_pointIds[i].getIndex();
-					}
-				}
-
-				if(countS > 0)
-				{
-					ANKI_ASSERT(countS <= 0xF);
-					c.m_combo |= countS;
-
-					for(U i = 0; i < countS; ++i)
-					{
-						ctx.m_lightIds[offset++] =
-							cluster.m_spotIds[i].getIndex();
-					}
-				}
-
-				if(countProbe > 0)
-				{
-					ANKI_ASSERT(countProbe <= 0xF);
-					c.m_combo |= countProbe << 8;
-
-					for(U i = 0; i < countProbe; ++i)
-					{
-						ctx.m_lightIds[offset++] =
-							cluster.m_probeIds[i].getIndex();
-					}
-				}
-			}
-			else
-			{
-				ANKI_LOGW("Light IDs buffer too small");
-			}
-		} // end for
-	} // end while
+			const U32* in = indices;
+			memcpy(&ctx.m_lightIds[offset], in, sizeof(U32) * countP);
+			offset += countP;
+			in += cluster.m_counts[POINT_LIGHT];
+
+			memcpy(&ctx.m_lightIds[offset], in, sizeof(U32) * countS);
+			offset += countS;
+			in += cluster.m_counts[SPOT_LIGHT];
+
+			memcpy(&ctx.m_lightIds[offset], in, sizeof(U32) * countProbe);
+		}
+		else
+		{
+			ANKI_LOGW("Light IDs buffer too small");
+		}
+	}
 
 	ANKI_TRACE_STOP_EVENT(RENDERER_LIGHT_BINNING);
 }
 
 //==============================================================================
-I LightBin::writePointLight(const LightComponent& lightc,
+void LightBin::writePointLight(const LightComponent& lightc,
 	const MoveComponent& lightMove,
 	const FrustumComponent& camFrc,
+	U idx,
 	LightBinContext& ctx)
 {
-	// Get GPU light
-	I i = ctx.m_pointLightsCount.fetchAdd(1);
-
-	ShaderPointLight& slight = ctx.m_pointLights[i];
+	ShaderPointLight& slight = ctx.m_pointLights[idx];
 
 	Vec4 pos = camFrc.getViewMatrix()
 		* lightMove.getWorldTransform().getOrigin().xyz1();
@@ -675,21 +696,18 @@ I LightBin::writePointLight(const LightComponent& lightc,
 	}
 
 	slight.m_specularColorTexId = lightc.getSpecularColor();
-
-	return i;
 }
 
 //==============================================================================
-I LightBin::writeSpotLight(const LightComponent& lightc,
+void LightBin::writeSpotLight(const LightComponent& lightc,
 	const MoveComponent& lightMove,
 	const FrustumComponent* lightFrc,
 	const MoveComponent& camMove,
 	const FrustumComponent& camFrc,
+	U idx,
 	LightBinContext& ctx)
 {
-	I i = ctx.m_spotLightsCount.fetchAdd(1);
-
-	ShaderSpotLight& light = ctx.m_spotLights[i];
+	ShaderSpotLight& light = ctx.m_spotLights[idx];
 	F32 shadowmapIndex = INVALID_TEXTURE_INDEX;
 
 	if(lightc.getShadowEnabled() && ctx.m_shadowsEnabled)
@@ -740,89 +758,74 @@ I LightBin::writeSpotLight(const LightComponent& lightc,
 	// Angles
 	light.m_outerCosInnerCos =
 		Vec4(lightc.getOuterAngleCos(), lightc.getInnerAngleCos(), 1.0, 1.0);
-
-	return i;
 }
 
 //==============================================================================
-void LightBin::binLight(SpatialComponent& sp,
-	U pos,
-	U lightType,
-	LightBinContext& ctx,
-	ClustererTestResult& testResult)
-{
-	m_clusterer.bin(sp.getSpatialCollisionShape(), sp.getAabb(), testResult);
-
-	// Bin to the correct tiles
-	auto it = testResult.getClustersBegin();
-	auto end = testResult.getClustersEnd();
-	for(; it != end; ++it)
-	{
-		U x = (*it)[0];
-		U y = (*it)[1];
-		U z = (*it)[2];
-
-		U i = m_clusterer.getClusterCountX()
-				* (z * m_clusterer.getClusterCountY() + y)
-			+ x;
-
-		auto& cluster = ctx.m_tempClusters[i];
-
-		switch(lightType)
-		{
-		case 0:
-			i = cluster.m_pointCount.fetchAdd(1) % MAX_TYPED_LIGHTS_PER_CLUSTER;
-			cluster.m_pointIds[i].setIndex(pos);
-			break;
-		case 1:
-			i = cluster.m_spotCount.fetchAdd(1) % MAX_TYPED_LIGHTS_PER_CLUSTER;
-			cluster.m_spotIds[i].setIndex(pos);
-			break;
-		default:
-			ANKI_ASSERT(0);
-		}
-	}
-}
-
-//==============================================================================
-void LightBin::writeAndBinProbe(const FrustumComponent& camFrc,
+void LightBin::writeProbe(const FrustumComponent& camFrc,
 	const SceneNode& node,
-	LightBinContext& ctx,
-	ClustererTestResult& testResult)
+	U idx,
+	LightBinContext& ctx)
 {
 	const ReflectionProbeComponent& reflc =
 		node.getComponent<ReflectionProbeComponent>();
-	const SpatialComponent& sp = node.getComponent<SpatialComponent>();
 
-	// Write it
 	ShaderProbe probe;
 	probe.m_pos = (camFrc.getViewMatrix() * reflc.getPosition().xyz1()).xyz();
 	probe.m_radiusSq = reflc.getRadius() * reflc.getRadius();
 	probe.m_cubemapIndex = reflc.getTextureArrayIndex();
 
-	U idx = ctx.m_probeCount.fetchAdd(1);
 	ctx.m_probes[idx] = probe;
+	ctx.m_probeRadii[idx] = reflc.getRadius();
+}
 
-	// Bin it
-	m_clusterer.bin(sp.getSpatialCollisionShape(), sp.getAabb(), testResult);
+//==============================================================================
+void LightBin::binElement(const SceneNode& node,
+	U elementIdx,
+	U type,
+	LightBinContext& ctx,
+	ClustererTestResult& testResult)
+{
+	CachedBin& bin = *ctx.m_bins[elementIdx];
 
-	auto it = testResult.getClustersBegin();
-	auto end = testResult.getClustersEnd();
-	for(; it != end; ++it)
+	// Re-bin if the element or the camera changed after the last bin
+	const Timestamp lastChange =
+		max(getElementTimestamp(node), ctx.m_cameraTimestamp);
+	if(bin.m_frc != ctx.m_frc || lastChange >= bin.m_timestamp)
 	{
-		U x = (*it)[0];
-		U y = (*it)[1];
-		U z = (*it)[2];
+		const SpatialComponent& sp = node.getComponent<SpatialComponent>();
+		m_clusterer.bin(
+			sp.getSpatialCollisionShape(), sp.getAabb(), testResult);
+
+		const U count = testResult.getClusterCount();
+		if(bin.m_clusters.getSize() < count)
+		{
+			bin.m_clusters.destroy(m_alloc);
+			bin.m_clusters.create(m_alloc, count);
+		}
 
-		U i = m_clusterer.getClusterCountX()
-				* (z * m_clusterer.getClusterCountY() + y)
-			+ x;
+		U c = 0;
+		auto it = testResult.getClustersBegin();
+		auto end = testResult.getClustersEnd();
+		for(; it != end; ++it)
+		{
+			U x = (*it)[0];
+			U y = (*it)[1];
+			U z = (*it)[2];
 
-		auto& cluster = ctx.m_tempClusters[i];
+			bin.m_clusters[c++] = m_clusterer.getClusterCountX()
+					* (z * m_clusterer.getClusterCountY() + y)
+				+ x;
+		}
 
-		i = cluster.m_probeCount.fetchAdd(1) % MAX_PROBES_PER_CLUSTER;
-		cluster.m_probeIds[i].setIndex(idx);
-		cluster.m_probeIds[i].setProbeRadius(reflc.getRadius());
+		bin.m_clusterCount = count;
+		bin.m_frc = ctx.m_frc;
+		bin.m_timestamp = ctx.m_crntTimestamp;
+	}
+
+	// Count it
+	for(U i = 0; i < bin.m_clusterCount; ++i)
+	{
+		ctx.m_tempClusters[bin.m_clusters[i]].m_cursors[type].fetchAdd(1);
 	}
 }
 
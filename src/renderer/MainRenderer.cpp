@@ -35,7 +35,7 @@ MainRenderer::~MainRenderer()
 }
 
 //==============================================================================
-Error MainRenderer::create(ThreadPool* threadpool,
+Error MainRenderer::create(ThreadHive* threadHive,
 	ResourceManager* resources,
 	GrManager* gr,
 	AllocAlignedCallback allocCb,
@@ -70,7 +70,7 @@ Error MainRenderer::create(ThreadPool* threadpool,
 	config2.set("height", size.y());
 
 	m_r.reset(m_alloc.newInstance<Renderer>());
-	ANKI_CHECK(m_r->init(threadpool,
+	ANKI_CHECK(m_r->init(threadHive,
 		resources,
 		gr,
 		m_alloc,
@@ -105,7 +105,9 @@ Error MainRenderer::create(ThreadPool* threadpool,
 	ResourceGroupInitInfo rcinit;
 	if(m_r->getPpsEnabled())
 	{
+		// The RT may share a texture that samples differently
 		rcinit.m_textures[0].m_texture = m_r->getPps().getRt();
+		rcinit.m_textures[0].m_sampler = m_r->getPpsRenderTargetSampler();
 	}
 	else
 	{
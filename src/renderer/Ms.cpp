@@ -6,11 +6,11 @@
 #include <anki/renderer/Ms.h>
 #include <anki/renderer/Renderer.h>
 #include <anki/util/Logger.h>
-#include <anki/util/ThreadPool.h>
 #include <anki/scene/SceneGraph.h>
 #include <anki/scene/FrustumComponent.h>
 #include <anki/misc/ConfigSet.h>
 #include <anki/core/Trace.h>
+#include <anki/util/ThreadHive.h>
 
 namespace anki
 {
@@ -33,37 +33,12 @@ Ms::~Ms()
 //==============================================================================
 Error Ms::createRt(U32 samples)
 {
-	m_r->createRenderTarget(m_r->getWidth(),
-		m_r->getHeight(),
-		DEPTH_RT_PIXEL_FORMAT,
-		samples,
-		SamplingFilter::NEAREST,
-		log2(SSAO_FRACTION) + 1,
-		m_depthRt);
-
-	m_r->createRenderTarget(m_r->getWidth(),
-		m_r->getHeight(),
-		RT_PIXEL_FORMATS[0],
-		samples,
-		SamplingFilter::NEAREST,
-		1,
-		m_rt0);
-
-	m_r->createRenderTarget(m_r->getWidth(),
-		m_r->getHeight(),
-		RT_PIXEL_FORMATS[1],
-		samples,
-		SamplingFilter::NEAREST,
-		1,
-		m_rt1);
-
-	m_r->createRenderTarget(m_r->getWidth(),
-		m_r->getHeight(),
-		RT_PIXEL_FORMATS[2],
-		samples,
-		SamplingFilter::NEAREST,
-		log2(SSAO_FRACTION) + 1,
-		m_rt2);
+	// The render graph creates them
+	ANKI_ASSERT(samples == m_r->getSamples());
+	m_rt0 = m_r->getMsRenderTarget(0);
+	m_rt1 = m_r->getMsRenderTarget(1);
+	m_rt2 = m_r->getMsRenderTarget(2);
+	m_depthRt = m_r->getMsRenderTarget(3);
 
 	AttachmentLoadOperation loadop = AttachmentLoadOperation::DONT_CARE;
 #if ANKI_DEBUG
@@ -109,7 +84,7 @@ Error Ms::initInternal(const ConfigSet& initializer)
 	ANKI_CHECK(createRt(initializer.getNumber("samples")));
 
 	m_secondLevelCmdbs.create(
-		getAllocator(), m_r->getThreadPool().getThreadsCount());
+		getAllocator(), m_r->getThreadHive().getThreadCount());
 
 	getGrManager().finish();
 
@@ -128,8 +103,7 @@ Error Ms::buildCommandBuffers(
 
 	U problemSize = vis.getCount(VisibilityGroupType::RENDERABLES_MS);
 	PtrSize start, end;
-	ThreadPoolTask::choseStartEnd(
-		threadId, threadCount, problemSize, start, end);
+	splitThreadedProblem(threadId, threadCount, problemSize, start, end);
 
 	if(start != end)
 	{
@@ -167,7 +141,7 @@ void Ms::run(RenderingContext& ctx)
 	cmdb->setViewport(0, 0, m_r->getWidth(), m_r->getHeight());
 	cmdb->setPolygonOffset(0.0, 0.0);
 
-	for(U i = 0; i < m_r->getThreadPool().getThreadsCount(); ++i)
+	for(U i = 0; i < m_r->getThreadHive().getThreadCount(); ++i)
 	{
 		if(ctx.m_ms.m_commandBuffers[i].isCreated())
 		{
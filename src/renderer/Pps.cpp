@@ -21,7 +21,7 @@ namespace anki
 
 //==============================================================================
 const PixelFormat Pps::RT_PIXEL_FORMAT(
-	ComponentFormat::R8G8B8, TransformFormat::UNORM);
+	ComponentFormat::R8G8B8A8, TransformFormat::UNORM);
 
 //==============================================================================
 Pps::Pps(Renderer* r)
@@ -39,14 +39,8 @@ Error Pps::initInternal(const ConfigSet& config)
 {
 	ANKI_ASSERT("Initializing PPS");
 
-	// FBO
-	m_r->createRenderTarget(m_r->getWidth(),
-		m_r->getHeight(),
-		RT_PIXEL_FORMAT,
-		1,
-		SamplingFilter::LINEAR,
-		1,
-		m_rt);
+	// FBO. The render graph creates the RT
+	m_rt = m_r->getPpsRenderTarget();
 
 	FramebufferInitInfo fbInit;
 	fbInit.m_colorAttachmentCount = 1;
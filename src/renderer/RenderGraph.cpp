@@ -0,0 +1,591 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/RenderGraph.h>
+#include <anki/renderer/Renderer.h>
+
+namespace anki
+{
+
+//==============================================================================
+RenderGraph::~RenderGraph()
+{
+	m_passes.destroy(m_alloc);
+	m_textures.destroy(m_alloc);
+	m_buffers.destroy(m_alloc);
+	m_deps.destroy(m_alloc);
+	m_physicalTextures.destroy(m_alloc);
+	m_barriers.destroy(m_alloc);
+}
+
+//==============================================================================
+template<typename T>
+void RenderGraph::reserve(DynamicArray<T>& arr, U32 count)
+{
+	if(count > arr.getSize())
+	{
+		arr.resize(m_alloc, max<U32>(count, arr.getSize() * 2));
+	}
+}
+
+//==============================================================================
+U32 RenderGraph::newTexture(CString name, const TextureInitInfo& init)
+{
+	ANKI_ASSERT(init.isValid());
+	reserve(m_textures, m_textureCount + 1);
+
+	TextureResource& tex = m_textures[m_textureCount];
+	tex = TextureResource();
+	tex.m_name = name;
+	tex.m_init = init;
+	tex.m_mipmapCount = init.m_mipmapsCount;
+
+	m_compiled = false;
+	return m_textureCount++;
+}
+
+//==============================================================================
+U32 RenderGraph::importTexture(CString name, U mipmapCount)
+{
+	ANKI_ASSERT(mipmapCount > 0);
+	reserve(m_textures, m_textureCount + 1);
+
+	TextureResource& tex = m_textures[m_textureCount];
+	tex = TextureResource();
+	tex.m_name = name;
+	tex.m_mipmapCount = mipmapCount;
+	tex.m_imported = true;
+
+	m_compiled = false;
+	return m_textureCount++;
+}
+
+//==============================================================================
+U32 RenderGraph::importBuffer(CString name)
+{
+	reserve(m_buffers, m_bufferCount + 1);
+
+	BufferResource& buff = m_buffers[m_bufferCount];
+	buff = BufferResource();
+	buff.m_name = name;
+
+	m_compiled = false;
+	return m_bufferCount++;
+}
+
+//==============================================================================
+U32 RenderGraph::newPass(CString name,
+	RenderGraphRunCallback run,
+	void* userData,
+	RenderGraphBuildCallback build)
+{
+	ANKI_ASSERT(run);
+	reserve(m_passes, m_passCount + 1);
+
+	Pass& pass = m_passes[m_passCount];
+	pass = Pass();
+	pass.m_name = name;
+	pass.m_run = run;
+	pass.m_build = build;
+	pass.m_userData = userData;
+
+	m_compiled = false;
+	return m_passCount++;
+}
+
+//==============================================================================
+void RenderGraph::newDependency(
+	U32 pass, U32 resource, Bool texture, U32 usage, Bool write)
+{
+	ANKI_ASSERT(pass < m_passCount);
+	ANKI_ASSERT(resource < ((texture) ? m_textureCount : m_bufferCount));
+	ANKI_ASSERT(usage != 0);
+	m_compiled = false;
+
+	// If the pass already uses the resource merge the usages
+	for(U i = 0; i < m_depCount; ++i)
+	{
+		Dependency& dep = m_deps[i];
+		if(dep.m_pass == pass && dep.m_resource == resource
+			&& dep.m_texture == texture)
+		{
+			dep.m_usage |= usage;
+			dep.m_write = dep.m_write || write;
+			return;
+		}
+	}
+
+	reserve(m_deps, m_depCount + 1);
+	Dependency& dep = m_deps[m_depCount++];
+	dep.m_pass = pass;
+	dep.m_resource = resource;
+	dep.m_usage = usage;
+	dep.m_texture = texture;
+	dep.m_write = write;
+}
+
+//==============================================================================
+Error RenderGraph::compile()
+{
+	ANKI_ASSERT(m_gr);
+
+	cullPasses();
+	computeDependencyLevels();
+	ANKI_CHECK(createPhysicalTextures());
+	computeBarriers();
+
+	m_compiled = true;
+
+	U culledCount = 0;
+	for(U i = 0; i < m_passCount; ++i)
+	{
+		culledCount += isPassCulled(i);
+	}
+
+	ANKI_LOGI("Render graph compiled. Passes %u (culled %u), dependency "
+			  "levels %u, textures %u (physical %u), barriers %u",
+		m_passCount,
+		culledCount,
+		m_levelCount,
+		m_textureCount,
+		m_physicalTextures.getSize(),
+		m_barrierCount);
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void RenderGraph::cullPasses()
+{
+	DynamicArrayAuto<Bool8> texNeeded(m_alloc);
+	DynamicArrayAuto<Bool8> buffNeeded(m_alloc);
+	if(m_textureCount)
+	{
+		texNeeded.create(m_textureCount, false);
+	}
+
+	if(m_bufferCount)
+	{
+		buffNeeded.create(m_bufferCount, false);
+	}
+
+	for(U i = 0; i < m_textureCount; ++i)
+	{
+		texNeeded[i] = m_textures[i].m_output;
+	}
+
+	// Walk the passes backwards. A pass is alive if it writes something that
+	// an alive pass or the outside needs
+	for(I p = m_passCount - 1; p >= 0; --p)
+	{
+		Pass& pass = m_passes[p];
+		Bool alive = pass.m_sideEffects;
+
+		for(U i = 0; i < m_depCount && !alive; ++i)
+		{
+			const Dependency& dep = m_deps[i];
+			if(dep.m_pass == U(p) && dep.m_write)
+			{
+				alive = (dep.m_texture) ? texNeeded[dep.m_resource]
+										: buffNeeded[dep.m_resource];
+			}
+		}
+
+		// Mark as culled. The levels are computed later
+		pass.m_level = (alive) ? 0 : NULL_HANDLE;
+		if(!alive)
+		{
+			continue;
+		}
+
+		for(U i = 0; i < m_depCount; ++i)
+		{
+			const Dependency& dep = m_deps[i];
+			if(dep.m_pass == U(p) && !dep.m_write)
+			{
+				if(dep.m_texture)
+				{
+					texNeeded[dep.m_resource] = true;
+				}
+				else
+				{
+					buffNeeded[dep.m_resource] = true;
+				}
+			}
+		}
+	}
+}
+
+//==============================================================================
+void RenderGraph::computeDependencyLevels()
+{
+	// The level of the last pass that wrote a resource and the max level of
+	// the passes that read it after that
+	const U resourceCount = m_textureCount + m_bufferCount;
+	DynamicArrayAuto<I32> writeLevels(m_alloc);
+	DynamicArrayAuto<I32> readLevels(m_alloc);
+	if(resourceCount)
+	{
+		writeLevels.create(resourceCount, -1);
+		readLevels.create(resourceCount, -1);
+	}
+
+	m_levelCount = 0;
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		Pass& pass = m_passes[p];
+		if(pass.m_level == NULL_HANDLE)
+		{
+			continue;
+		}
+
+		// A pass goes after the writers of what it uses and after the readers
+		// of what it writes
+		I32 level = 0;
+		for(U i = 0; i < m_depCount; ++i)
+		{
+			const Dependency& dep = m_deps[i];
+			if(dep.m_pass == p)
+			{
+				const U r = (dep.m_texture) ? dep.m_resource
+											: m_textureCount + dep.m_resource;
+				level = max(level, writeLevels[r] + 1);
+				if(dep.m_write)
+				{
+					level = max(level, readLevels[r] + 1);
+				}
+			}
+		}
+
+		for(U i = 0; i < m_depCount; ++i)
+		{
+			const Dependency& dep = m_deps[i];
+			if(dep.m_pass == p)
+			{
+				const U r = (dep.m_texture) ? dep.m_resource
+											: m_textureCount + dep.m_resource;
+				if(dep.m_write)
+				{
+					writeLevels[r] = level;
+					readLevels[r] = -1;
+				}
+				else
+				{
+					readLevels[r] = max(readLevels[r], level);
+				}
+			}
+		}
+
+		pass.m_level = level;
+		m_levelCount = max<U32>(m_levelCount, level + 1);
+	}
+}
+
+//==============================================================================
+Bool RenderGraph::compatible(const TextureInitInfo& a, const TextureInitInfo& b)
+{
+	// The sampling and the usage are not part of the memory
+	return a.m_type == b.m_type && a.m_width == b.m_width
+		&& a.m_height == b.m_height && a.m_depth == b.m_depth
+		&& a.m_layerCount == b.m_layerCount
+		&& a.m_mipmapsCount == b.m_mipmapsCount && a.m_format == b.m_format
+		&& a.m_samples == b.m_samples;
+}
+
+//==============================================================================
+Error RenderGraph::createPhysicalTextures()
+{
+	// Compute the lifetimes
+	for(U i = 0; i < m_textureCount; ++i)
+	{
+		TextureResource& tex = m_textures[i];
+		tex.m_firstPass = tex.m_lastPass = NULL_HANDLE;
+		tex.m_physical = NULL_HANDLE;
+		tex.m_sampler.reset(nullptr);
+		if(!tex.m_imported)
+		{
+			tex.m_init.m_usage = TextureUsageBit::NONE;
+		}
+	}
+
+	for(U i = 0; i < m_depCount; ++i)
+	{
+		const Dependency& dep = m_deps[i];
+		if(!dep.m_texture || m_passes[dep.m_pass].m_level == NULL_HANDLE)
+		{
+			continue;
+		}
+
+		TextureResource& tex = m_textures[dep.m_resource];
+		tex.m_firstPass = min(tex.m_firstPass, dep.m_pass);
+		tex.m_lastPass = (tex.m_lastPass == NULL_HANDLE)
+			? dep.m_pass
+			: max(tex.m_lastPass, dep.m_pass);
+		tex.m_init.m_usage |= TextureUsageBit(dep.m_usage);
+	}
+
+	// Assign the textures to physical textures in the order they start. A
+	// physical texture can be re-used when the last texture that used it is
+	// done. The outputs live until the end of the frame so nothing can take
+	// their physical texture
+	m_physicalTextures.destroy(m_alloc);
+	DynamicArrayAuto<PhysicalTexture> physicals(m_alloc);
+	if(m_textureCount)
+	{
+		physicals.create(m_textureCount);
+	}
+
+	U physicalCount = 0;
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		for(U i = 0; i < m_textureCount; ++i)
+		{
+			TextureResource& tex = m_textures[i];
+			if(tex.m_imported || tex.m_firstPass != p)
+			{
+				continue;
+			}
+
+			U physIdx = NULL_HANDLE;
+			for(U j = 0; j < physicalCount; ++j)
+			{
+				const PhysicalTexture& phys = physicals[j];
+				if(!phys.m_output && phys.m_lastPass < p
+					&& compatible(phys.m_init, tex.m_init))
+				{
+					physIdx = j;
+					break;
+				}
+			}
+
+			if(physIdx == NULL_HANDLE)
+			{
+				physIdx = physicalCount++;
+				physicals[physIdx].m_init = tex.m_init;
+			}
+
+			PhysicalTexture& phys = physicals[physIdx];
+			phys.m_init.m_usage |= tex.m_init.m_usage;
+			phys.m_lastPass = tex.m_lastPass;
+			phys.m_output = tex.m_output;
+			tex.m_physical = physIdx;
+		}
+	}
+
+	// Create them
+	if(physicalCount)
+	{
+		m_physicalTextures.create(m_alloc, physicalCount);
+	}
+
+	for(U i = 0; i < physicalCount; ++i)
+	{
+		PhysicalTexture& phys = physicals[i];
+		phys.m_tex = m_gr->newInstance<anki::Texture>(phys.m_init);
+		m_physicalTextures[i] = phys;
+	}
+
+	// The physical texture samples like the first texture that used it. The
+	// rest need their own sampler
+	for(U i = 0; i < m_textureCount; ++i)
+	{
+		TextureResource& tex = m_textures[i];
+		if(tex.m_physical == NULL_HANDLE)
+		{
+			continue;
+		}
+
+		const SamplerInitInfo& a = tex.m_init.m_sampling;
+		const SamplerInitInfo& b =
+			m_physicalTextures[tex.m_physical].m_init.m_sampling;
+		if(a.computeHash() != b.computeHash())
+		{
+			tex.m_sampler = m_gr->newInstance<Sampler>(a);
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void RenderGraph::computeBarriers()
+{
+	// Imported textures get their state after the physical textures
+	const U texStateCount = m_physicalTextures.getSize() + m_textureCount;
+	DynamicArrayAuto<U32> texStates(m_alloc);
+	DynamicArrayAuto<U32> buffStates(m_alloc);
+	if(texStateCount)
+	{
+		texStates.create(texStateCount, 0);
+	}
+
+	if(m_bufferCount)
+	{
+		buffStates.create(m_bufferCount, 0);
+	}
+
+	// The graph runs every frame so the resources start the frame with the
+	// usage they had at the end of the previous one
+	for(U i = 0; i < m_depCount; ++i)
+	{
+		const Dependency& dep = m_deps[i];
+		if(m_passes[dep.m_pass].m_level == NULL_HANDLE)
+		{
+			continue;
+		}
+
+		if(dep.m_texture)
+		{
+			texStates[getTextureStateIndex(dep.m_resource)] = dep.m_usage;
+		}
+		else
+		{
+			buffStates[dep.m_resource] = dep.m_usage;
+		}
+	}
+
+	m_barrierCount = 0;
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		Pass& pass = m_passes[p];
+		pass.m_firstBarrier = m_barrierCount;
+		pass.m_barrierCount = 0;
+		if(pass.m_level == NULL_HANDLE)
+		{
+			continue;
+		}
+
+		for(U i = 0; i < m_depCount; ++i)
+		{
+			const Dependency& dep = m_deps[i];
+			if(dep.m_pass != p)
+			{
+				continue;
+			}
+
+			U32& state = (dep.m_texture)
+				? texStates[getTextureStateIndex(dep.m_resource)]
+				: buffStates[dep.m_resource];
+
+			// Reads after reads of the same usage need no barrier
+			if(state != dep.m_usage || dep.m_write)
+			{
+				reserve(m_barriers, m_barrierCount + 1);
+				Barrier& barrier = m_barriers[m_barrierCount++];
+				barrier.m_resource = dep.m_resource;
+				barrier.m_prevUsage = state;
+				barrier.m_nextUsage = dep.m_usage;
+				barrier.m_texture = dep.m_texture;
+				++pass.m_barrierCount;
+			}
+
+			state = dep.m_usage;
+		}
+	}
+}
+
+//==============================================================================
+TexturePtr RenderGraph::getTexture(U32 tex) const
+{
+	ANKI_ASSERT(m_compiled);
+	const TextureResource& t = m_textures[tex];
+	if(t.m_imported)
+	{
+		return t.m_importedTex;
+	}
+
+	ANKI_ASSERT(t.m_physical != NULL_HANDLE && "Texture is not used");
+	return m_physicalTextures[t.m_physical].m_tex;
+}
+
+//==============================================================================
+Error RenderGraph::buildCommandBuffers(RenderingContext& ctx, ThreadHive& hive)
+{
+	ANKI_ASSERT(m_compiled);
+
+	// Gather the passes that have something to build
+	Array<U32, 32> passes;
+	U passCount = 0;
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		if(!isPassCulled(p) && m_passes[p].m_build)
+		{
+			ANKI_ASSERT(passCount < passes.getSize());
+			passes[passCount++] = p;
+		}
+	}
+
+	if(passCount == 0)
+	{
+		return ErrorCode::NONE;
+	}
+
+	// Every pass is split in as many slices as the threads and the threads
+	// pick slices dynamically. The slices keep the order of the second level
+	// command buffers
+	const U sliceCount = hive.getThreadCount();
+
+	return hive.parallelFor(0,
+		passCount * sliceCount,
+		1,
+		[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+			for(PtrSize i = start; i < end; ++i)
+			{
+				const Pass& pass = m_passes[passes[i / sliceCount]];
+				ANKI_CHECK(pass.m_build(
+					pass.m_userData, ctx, i % sliceCount, sliceCount));
+			}
+
+			return ErrorCode::NONE;
+		});
+}
+
+//==============================================================================
+Error RenderGraph::run(RenderingContext& ctx)
+{
+	ANKI_ASSERT(m_compiled);
+	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
+
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		const Pass& pass = m_passes[p];
+		if(pass.m_level == NULL_HANDLE)
+		{
+			continue;
+		}
+
+		for(U i = 0; i < pass.m_barrierCount; ++i)
+		{
+			const Barrier& barrier = m_barriers[pass.m_firstBarrier + i];
+			if(barrier.m_texture)
+			{
+				TexturePtr tex = getTexture(barrier.m_resource);
+				ANKI_ASSERT(tex.isCreated());
+				const U mipCount = m_textures[barrier.m_resource].m_mipmapCount;
+				for(U mip = 0; mip < mipCount; ++mip)
+				{
+					cmdb->setTextureBarrier(tex,
+						TextureUsageBit(barrier.m_prevUsage),
+						TextureUsageBit(barrier.m_nextUsage),
+						TextureSurfaceInfo(mip, 0, 0, 0));
+				}
+			}
+			else
+			{
+				BufferPtr buff = m_buffers[barrier.m_resource].m_buff;
+				ANKI_ASSERT(buff.isCreated());
+				cmdb->setBufferBarrier(buff,
+					BufferUsageBit(barrier.m_prevUsage),
+					BufferUsageBit(barrier.m_nextUsage));
+			}
+		}
+
+		ANKI_CHECK(pass.m_run(pass.m_userData, ctx));
+	}
+
+	return ErrorCode::NONE;
+}
+
+} // end namespace anki
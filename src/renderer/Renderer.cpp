@@ -58,7 +58,7 @@ Renderer::~Renderer()
 }
 
 //==============================================================================
-Error Renderer::init(ThreadPool* threadpool,
+Error Renderer::init(ThreadHive* threadHive,
 	ResourceManager* resources,
 	GrManager* gl,
 	HeapAllocator<U8> alloc,
@@ -67,7 +67,7 @@ Error Renderer::init(ThreadPool* threadpool,
 	Timestamp* globTimestamp)
 {
 	m_globTimestamp = globTimestamp;
-	m_threadpool = threadpool;
+	m_threadHive = threadHive;
 	m_resources = resources;
 	m_gr = gl;
 	m_alloc = alloc;
@@ -131,6 +131,8 @@ Error Renderer::initInternal(const ConfigSet& config)
 	ANKI_CHECK(
 		m_resources->loadResource("shaders/Quad.vert.glsl", m_drawQuadVert));
 
+	ANKI_CHECK(initRenderGraph(config));
+
 	// Init the stages. Careful with the order!!!!!!!!!!
 	if(config.getNumber("ir.enabled"))
 	{
@@ -205,14 +207,233 @@ Error Renderer::initInternal(const ConfigSet& config)
 	m_dbg.reset(m_alloc.newInstance<Dbg>(this));
 	ANKI_CHECK(m_dbg->init(config));
 
+	importRenderGraphResources();
+
 	return ErrorCode::NONE;
 }
 
+//==============================================================================
+Error Renderer::initRenderGraph(const ConfigSet& config)
+{
+	RenderGraph& g = m_graph;
+	GraphHandles& h = m_graphHandles;
+	g.init(m_gr, m_alloc);
+
+	const Bool pps = config.getNumber("pps.enabled");
+	const Bool sm = config.getNumber("sm.enabled");
+	const Bool ssao = config.getNumber("ssao.enabled") && pps;
+	const Bool tm = config.getNumber("tm.enabled") && pps;
+	const Bool bloom = config.getNumber("bloom.enabled") && pps;
+
+	const TextureUsageBit sampled = TextureUsageBit::FRAGMENT_SHADER_SAMPLED;
+	const TextureUsageBit attachment =
+		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE;
+	const TextureUsageBit attachmentRw =
+		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
+
+	// The G buffer and the PPS output are created by the graph. The PPS
+	// output can take the memory of the G buffer since it's written after
+	// the G buffer is consumed
+	const U gbufferMips = log2(SSAO_FRACTION) + 1;
+	for(U i = 0; i < Ms::ATTACHMENT_COUNT; ++i)
+	{
+		h.m_msRts[i] = g.newTexture("MS RT",
+			createRenderTargetInitInfo(m_width,
+				m_height,
+				Ms::RT_PIXEL_FORMATS[i],
+				m_samples,
+				SamplingFilter::NEAREST,
+				(i == 2) ? gbufferMips : 1));
+	}
+
+	const U32 depth = g.newTexture("MS depth",
+		createRenderTargetInitInfo(m_width,
+			m_height,
+			Ms::DEPTH_RT_PIXEL_FORMAT,
+			m_samples,
+			SamplingFilter::NEAREST,
+			gbufferMips));
+	h.m_msRts[3] = depth;
+
+	// The rest are owned by the stages
+	h.m_isRt = g.importTexture("IS RT", IS_MIPMAP_COUNT);
+	h.m_fsRt = g.importTexture("FS RT");
+
+	U32 pass;
+	if(sm)
+	{
+		h.m_smSpotRt = g.importTexture("SM spot");
+		h.m_smOmniRt = g.importTexture("SM omni");
+
+		pass = g.newPass("SM", runSm, this, buildSm);
+		g.writeTexture(pass, h.m_smSpotRt, attachmentRw);
+		g.writeTexture(pass, h.m_smOmniRt, attachmentRw);
+	}
+
+	pass = g.newPass("MS", runMs, this, buildMs);
+	for(U i = 0; i < Ms::ATTACHMENT_COUNT; ++i)
+	{
+		g.writeTexture(pass, h.m_msRts[i], attachment);
+	}
+	g.writeTexture(pass, depth, attachmentRw);
+
+	pass = g.newPass("IS", runIs, this);
+	for(U i = 0; i < h.m_msRts.getSize(); ++i)
+	{
+		g.readTexture(pass, h.m_msRts[i], sampled);
+	}
+
+	if(sm)
+	{
+		g.readTexture(pass, h.m_smSpotRt, sampled);
+		g.readTexture(pass, h.m_smOmniRt, sampled);
+	}
+	g.writeTexture(pass, h.m_isRt, attachment);
+
+	pass = g.newPass("MS mipmaps", runMsMipmaps, this);
+	g.writeTexture(pass, depth, TextureUsageBit::GENERATE_MIPMAPS);
+	g.writeTexture(pass, h.m_msRts[2], TextureUsageBit::GENERATE_MIPMAPS);
+
+	pass = g.newPass("FS", runFs, this, buildFs);
+	g.readTexture(
+		pass, depth, sampled | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ);
+	if(sm)
+	{
+		g.readTexture(pass, h.m_smSpotRt, sampled);
+		g.readTexture(pass, h.m_smOmniRt, sampled);
+	}
+	g.writeTexture(pass, h.m_fsRt, attachment);
+
+	if(ssao)
+	{
+		h.m_ssaoRt = g.importTexture("SSAO RT");
+
+		pass = g.newPass("SSAO", runSsao, this);
+		g.readTexture(pass, depth, sampled);
+		g.readTexture(pass, h.m_msRts[2], sampled);
+		g.writeTexture(pass, h.m_ssaoRt, attachment);
+	}
+
+	pass = g.newPass("Upsample", runUpsample, this);
+	g.readTexture(pass, depth, sampled);
+	g.readTexture(pass, h.m_fsRt, sampled);
+	if(ssao)
+	{
+		g.readTexture(pass, h.m_ssaoRt, sampled);
+	}
+	g.writeTexture(pass, h.m_isRt, attachmentRw);
+
+	if(tm)
+	{
+		h.m_tmBuff = g.importBuffer("TM luminance");
+
+		pass = g.newPass("Downscale", runDownscale, this);
+		g.readTexture(pass, h.m_isRt, sampled);
+		g.writeTexture(pass, h.m_isRt, attachment);
+
+		pass = g.newPass("TM", runTm, this);
+		g.readTexture(pass, h.m_isRt, TextureUsageBit::COMPUTE_SHADER_SAMPLED);
+		g.writeBuffer(
+			pass, h.m_tmBuff, BufferUsageBit::STORAGE_COMPUTE_SHADER_WRITE);
+	}
+
+	if(bloom)
+	{
+		h.m_bloomRts[0] = g.importTexture("Bloom RT");
+		h.m_bloomRts[1] = g.importTexture("Bloom RT1");
+
+		// The SSLF draws in the render pass that bloom leaves open
+		pass = g.newPass("Bloom", runBloom, this);
+		g.readTexture(pass, h.m_isRt, sampled);
+		if(tm)
+		{
+			g.readBuffer(
+				pass, h.m_tmBuff, BufferUsageBit::STORAGE_FRAGMENT_SHADER);
+		}
+		g.writeTexture(pass, h.m_bloomRts[0], attachmentRw);
+		g.writeTexture(pass, h.m_bloomRts[1], attachmentRw);
+	}
+
+	// The output
+	U32 output;
+	if(pps)
+	{
+		TextureInitInfo init = createRenderTargetInitInfo(m_width,
+			m_height,
+			Pps::RT_PIXEL_FORMAT,
+			1,
+			SamplingFilter::LINEAR,
+			1);
+		h.m_ppsRt = output = g.newTexture("PPS RT", init);
+
+		// It may draw to the output framebuffer instead
+		pass = g.newPass("PPS", runPps, this);
+		g.setSideEffects(pass);
+		g.readTexture(pass, h.m_isRt, sampled);
+		if(bloom)
+		{
+			g.readTexture(pass, h.m_bloomRts[0], sampled);
+		}
+
+		if(tm)
+		{
+			g.readBuffer(
+				pass, h.m_tmBuff, BufferUsageBit::STORAGE_FRAGMENT_SHADER);
+		}
+		g.writeTexture(pass, output, attachment);
+	}
+	else
+	{
+		output = h.m_isRt;
+	}
+
+	g.markOutput(output);
+
+	// It's enabled at runtime
+	pass = g.newPass("DBG", runDbg, this);
+	g.setSideEffects(pass);
+	g.readTexture(pass, depth, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ);
+	g.writeTexture(pass, output, attachmentRw);
+
+	return g.compile();
+}
+
+//==============================================================================
+void Renderer::importRenderGraphResources()
+{
+	RenderGraph& g = m_graph;
+	const GraphHandles& h = m_graphHandles;
+
+	g.setImportedTexture(h.m_isRt, m_is->getRt());
+	g.setImportedTexture(h.m_fsRt, m_fs->getRt());
+
+	if(m_sm)
+	{
+		g.setImportedTexture(h.m_smSpotRt, m_sm->getSpotTextureArray());
+		g.setImportedTexture(h.m_smOmniRt, m_sm->getOmniTextureArray());
+	}
+
+	if(m_ssao)
+	{
+		g.setImportedTexture(h.m_ssaoRt, m_ssao->getRt());
+	}
+
+	if(m_tm)
+	{
+		g.setImportedBuffer(h.m_tmBuff, m_tm->getAverageLuminanceBuffer());
+	}
+
+	if(m_bloom)
+	{
+		g.setImportedTexture(h.m_bloomRts[0], m_bloom->getRt());
+		g.setImportedTexture(h.m_bloomRts[1], m_bloom->getRt1());
+	}
+}
+
 //==============================================================================
 Error Renderer::render(RenderingContext& ctx)
 {
 	FrustumComponent& frc = *ctx.m_frustumComponent;
-	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
 
 	// Misc
 	ANKI_ASSERT(frc.getFrustum().getType() == Frustum::Type::PERSPECTIVE);
@@ -256,62 +477,7 @@ Error Renderer::render(RenderingContext& ctx)
 
 	ANKI_CHECK(m_is->binLights(ctx));
 	ANKI_CHECK(buildCommandBuffers(ctx));
-
-	if(m_sm)
-	{
-		m_sm->run(ctx);
-	}
-
-	m_ms->run(ctx);
-	m_lf->runOcclusionTests(ctx);
-	cmdb->endRenderPass();
-
-	m_is->run(ctx);
-
-	cmdb->generateMipmaps(m_ms->getDepthRt(), 0, 0, 0);
-	cmdb->generateMipmaps(m_ms->getRt2(), 0, 0, 0);
-
-	m_fs->run(ctx);
-	m_lf->run(ctx);
-	m_vol->run(ctx);
-	cmdb->endRenderPass();
-
-	if(m_ssao)
-	{
-		m_ssao->run(ctx);
-	}
-
-	m_upsample->run(ctx);
-
-	if(m_downscale)
-	{
-		m_downscale->run(ctx);
-	}
-
-	if(m_tm)
-	{
-		m_tm->run(ctx);
-	}
-
-	if(m_bloom)
-	{
-		m_bloom->run(ctx);
-	}
-
-	if(m_sslf)
-	{
-		m_sslf->run(ctx);
-	}
-
-	if(m_pps)
-	{
-		m_pps->run(ctx);
-	}
-
-	if(m_dbg->getEnabled())
-	{
-		ANKI_CHECK(m_dbg->run(ctx));
-	}
+	ANKI_CHECK(m_graph.run(ctx));
 
 	++m_frameCount;
 
@@ -340,13 +506,12 @@ Vec3 Renderer::unproject(const Vec3& windowCoords,
 }
 
 //==============================================================================
-void Renderer::createRenderTarget(U32 w,
+TextureInitInfo Renderer::createRenderTargetInitInfo(U32 w,
 	U32 h,
 	const PixelFormat& format,
 	U32 samples,
 	SamplingFilter filter,
-	U mipsCount,
-	TexturePtr& rt)
+	U mipsCount) const
 {
 	// Not very important but keep the resolution of render targets aligned to
 	// 16
@@ -378,7 +543,20 @@ void Renderer::createRenderTarget(U32 w,
 	init.m_sampling.m_repeat = false;
 	init.m_sampling.m_anisotropyLevel = 0;
 
-	rt = m_gr->newInstance<Texture>(init);
+	return init;
+}
+
+//==============================================================================
+void Renderer::createRenderTarget(U32 w,
+	U32 h,
+	const PixelFormat& format,
+	U32 samples,
+	SamplingFilter filter,
+	U mipsCount,
+	TexturePtr& rt)
+{
+	rt = m_gr->newInstance<Texture>(createRenderTargetInitInfo(
+		w, h, format, samples, filter, mipsCount));
 }
 
 //==============================================================================
@@ -425,43 +603,140 @@ Error Renderer::buildCommandBuffers(RenderingContext& ctx)
 	}
 
 	// Build
-	class Task : public ThreadPoolTask
-	{
-	public:
-		Renderer* m_r ANKI_DBG_NULLIFY_PTR;
-		RenderingContext* m_ctx ANKI_DBG_NULLIFY_PTR;
+	Error err = m_graph.buildCommandBuffers(ctx, getThreadHive());
 
-		Error operator()(U32 threadId, PtrSize threadsCount)
-		{
-			ANKI_CHECK(m_r->getMs().buildCommandBuffers(
-				*m_ctx, threadId, threadsCount));
+	ANKI_TRACE_STOP_EVENT(RENDERER_COMMAND_BUFFER_BUILDING);
 
-			if(m_r->getSmEnabled())
-			{
-				ANKI_CHECK(m_r->getSm().buildCommandBuffers(
-					*m_ctx, threadId, threadsCount));
-			}
+	return err;
+}
 
-			ANKI_CHECK(m_r->getFs().buildCommandBuffers(
-				*m_ctx, threadId, threadsCount));
+//==============================================================================
+Error Renderer::runSm(void* userData, RenderingContext& ctx)
+{
+	static_cast<Renderer*>(userData)->m_sm->run(ctx);
+	return ErrorCode::NONE;
+}
 
-			return ErrorCode::NONE;
-		}
-	};
+//==============================================================================
+Error Renderer::runMs(void* userData, RenderingContext& ctx)
+{
+	Renderer& r = *static_cast<Renderer*>(userData);
+	r.m_ms->run(ctx);
+	r.m_lf->runOcclusionTests(ctx);
+	ctx.m_commandBuffer->endRenderPass();
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::runIs(void* userData, RenderingContext& ctx)
+{
+	static_cast<Renderer*>(userData)->m_is->run(ctx);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::runMsMipmaps(void* userData, RenderingContext& ctx)
+{
+	Renderer& r = *static_cast<Renderer*>(userData);
+	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
+	cmdb->generateMipmaps(r.m_ms->getDepthRt(), 0, 0, 0);
+	cmdb->generateMipmaps(r.m_ms->getRt2(), 0, 0, 0);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::runFs(void* userData, RenderingContext& ctx)
+{
+	Renderer& r = *static_cast<Renderer*>(userData);
+	r.m_fs->run(ctx);
+	r.m_lf->run(ctx);
+	r.m_vol->run(ctx);
+	ctx.m_commandBuffer->endRenderPass();
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::runSsao(void* userData, RenderingContext& ctx)
+{
+	static_cast<Renderer*>(userData)->m_ssao->run(ctx);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::runUpsample(void* userData, RenderingContext& ctx)
+{
+	static_cast<Renderer*>(userData)->m_upsample->run(ctx);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::runDownscale(void* userData, RenderingContext& ctx)
+{
+	static_cast<Renderer*>(userData)->m_downscale->run(ctx);
+	return ErrorCode::NONE;
+}
 
-	ThreadPool& threadPool = getThreadPool();
-	Task task;
-	task.m_r = this;
-	task.m_ctx = &ctx;
-	for(U i = 0; i < threadPool.getThreadsCount(); i++)
+//==============================================================================
+Error Renderer::runTm(void* userData, RenderingContext& ctx)
+{
+	static_cast<Renderer*>(userData)->m_tm->run(ctx);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::runBloom(void* userData, RenderingContext& ctx)
+{
+	Renderer& r = *static_cast<Renderer*>(userData);
+	r.m_bloom->run(ctx);
+	if(r.m_sslf)
 	{
-		threadPool.assignNewTask(i, &task);
+		r.m_sslf->run(ctx);
 	}
 
-	Error err = threadPool.waitForAllThreadsToFinish();
-	ANKI_TRACE_STOP_EVENT(RENDERER_COMMAND_BUFFER_BUILDING);
+	return ErrorCode::NONE;
+}
 
-	return err;
+//==============================================================================
+Error Renderer::runPps(void* userData, RenderingContext& ctx)
+{
+	static_cast<Renderer*>(userData)->m_pps->run(ctx);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::runDbg(void* userData, RenderingContext& ctx)
+{
+	Renderer& r = *static_cast<Renderer*>(userData);
+	if(r.m_dbg->getEnabled())
+	{
+		ANKI_CHECK(r.m_dbg->run(ctx));
+	}
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Renderer::buildSm(
+	void* userData, RenderingContext& ctx, U slice, U sliceCount)
+{
+	return static_cast<Renderer*>(userData)->m_sm->buildCommandBuffers(
+		ctx, slice, sliceCount);
+}
+
+//==============================================================================
+Error Renderer::buildMs(
+	void* userData, RenderingContext& ctx, U slice, U sliceCount)
+{
+	return static_cast<Renderer*>(userData)->m_ms->buildCommandBuffers(
+		ctx, slice, sliceCount);
+}
+
+//==============================================================================
+Error Renderer::buildFs(
+	void* userData, RenderingContext& ctx, U slice, U sliceCount)
+{
+	return static_cast<Renderer*>(userData)->m_fs->buildCommandBuffers(
+		ctx, slice, sliceCount);
 }
 
 } // end namespace anki
@@ -11,12 +11,81 @@
 #include <anki/scene/Light.h>
 #include <anki/scene/FrustumComponent.h>
 #include <anki/scene/MoveComponent.h>
+#include <anki/scene/SpatialComponent.h>
+#include <anki/scene/Visibility.h>
 #include <anki/misc/ConfigSet.h>
-#include <anki/util/ThreadPool.h>
 
 namespace anki
 {
 
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+/// Get the last time a caster moved or changed shape.
+static Timestamp getCasterTimestamp(const SceneNode& node)
+{
+	Timestamp time = 0;
+
+	const MoveComponent* movc = node.tryGetComponent<MoveComponent>();
+	if(movc)
+	{
+		time = max(time, movc->getTimestamp());
+	}
+
+	const SpatialComponent* spc = node.tryGetComponent<SpatialComponent>();
+	if(spc)
+	{
+		time = max(time, spc->getTimestamp());
+	}
+
+	return time;
+}
+
+/// Add the node to a hash of a set of nodes. The order doesn't matter.
+static void hashCaster(const SceneNode& node, U64& hash)
+{
+	hash += U64(ptrToNumber(&node)) * 0x9E3779B97F4A7C15;
+}
+
+/// Split the casters of a shadowmap face in jobs.
+static void newJobs(RenderingContext& ctx,
+	const FrustumComponent& frc,
+	VisibleNode* casters,
+	U casterCount,
+	FramebufferPtr fb,
+	U32& nextJob,
+	U32& firstJob,
+	U32& jobCount)
+{
+	firstJob = nextJob;
+	jobCount = 0;
+
+	for(U i = 0; i < casterCount; i += Sm::JOB_CASTER_COUNT)
+	{
+		RenderingContext::Sm::Job& job = ctx.m_sm.m_jobs[nextJob++];
+		job.m_frc = &frc;
+		job.m_begin = casters + i;
+		job.m_end = casters + min<U>(i + Sm::JOB_CASTER_COUNT, casterCount);
+		job.m_fb = fb;
+		++jobCount;
+	}
+}
+
+/// Push the command buffers of some jobs.
+static void pushJobs(RenderingContext& ctx, U firstJob, U jobCount)
+{
+	for(U i = firstJob; i < firstJob + jobCount; ++i)
+	{
+		ctx.m_commandBuffer->pushSecondLevelCommandBuffer(
+			ctx.m_sm.m_jobs[i].m_cmdb);
+	}
+}
+
+//==============================================================================
+// Sm                                                                          =
+//==============================================================================
+
 //==============================================================================
 const PixelFormat Sm::DEPTH_RT_PIXEL_FORMAT(
 	ComponentFormat::D16, TransformFormat::FLOAT);
@@ -46,18 +115,28 @@ Error Sm::init(const ConfigSet& config)
 	sminit.m_sampling.m_compareOperation = CompareOperation::LESS_EQUAL;
 
 	m_spotTexArray = getGrManager().newInstance<Texture>(sminit);
+	m_spotStaticTexArray = getGrManager().newInstance<Texture>(sminit);
 
 	sminit.m_type = TextureType::CUBE_ARRAY;
 	m_omniTexArray = getGrManager().newInstance<Texture>(sminit);
+	m_omniStaticTexArray = getGrManager().newInstance<Texture>(sminit);
 
 	// Init 2D layers
 	m_spots.create(getAllocator(), config.getNumber("sm.maxLights"));
 
+	// The static layers are cleared and the shadowmaps start from a copy of
+	// the static layers
+	FramebufferInitInfo staticFbInit;
+	staticFbInit.m_depthStencilAttachment.m_texture = m_spotStaticTexArray;
+	staticFbInit.m_depthStencilAttachment.m_loadOperation =
+		AttachmentLoadOperation::CLEAR;
+	staticFbInit.m_depthStencilAttachment.m_clearValue.m_depthStencil.m_depth =
+		1.0;
+
 	FramebufferInitInfo fbInit;
 	fbInit.m_depthStencilAttachment.m_texture = m_spotTexArray;
 	fbInit.m_depthStencilAttachment.m_loadOperation =
-		AttachmentLoadOperation::CLEAR;
-	fbInit.m_depthStencilAttachment.m_clearValue.m_depthStencil.m_depth = 1.0;
+		AttachmentLoadOperation::LOAD;
 
 	U layer = 0;
 	for(ShadowmapSpot& sm : m_spots)
@@ -67,6 +146,9 @@ Error Sm::init(const ConfigSet& config)
 		fbInit.m_depthStencilAttachment.m_surface.m_layer = layer;
 		sm.m_fb = getGrManager().newInstance<Framebuffer>(fbInit);
 
+		staticFbInit.m_depthStencilAttachment.m_surface.m_layer = layer;
+		sm.m_staticFb = getGrManager().newInstance<Framebuffer>(staticFbInit);
+
 		++layer;
 	}
 
@@ -74,6 +156,7 @@ Error Sm::init(const ConfigSet& config)
 	m_omnis.create(getAllocator(), config.getNumber("sm.maxLights"));
 
 	fbInit.m_depthStencilAttachment.m_texture = m_omniTexArray;
+	staticFbInit.m_depthStencilAttachment.m_texture = m_omniStaticTexArray;
 
 	layer = 0;
 	for(ShadowmapOmni& sm : m_omnis)
@@ -85,6 +168,11 @@ Error Sm::init(const ConfigSet& config)
 			fbInit.m_depthStencilAttachment.m_surface.m_layer = layer;
 			fbInit.m_depthStencilAttachment.m_surface.m_face = i;
 			sm.m_fb[i] = getGrManager().newInstance<Framebuffer>(fbInit);
+
+			staticFbInit.m_depthStencilAttachment.m_surface.m_layer = layer;
+			staticFbInit.m_depthStencilAttachment.m_surface.m_face = i;
+			sm.m_staticFb[i] =
+				getGrManager().newInstance<Framebuffer>(staticFbInit);
 		}
 
 		++layer;
@@ -100,40 +188,23 @@ void Sm::run(RenderingContext& ctx)
 	ANKI_TRACE_START_EVENT(RENDER_SM);
 	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
 
-	const U threadCount = m_r->getThreadPool().getThreadsCount();
-
-	// Spot lights
-	for(U i = 0; i < ctx.m_sm.m_spots.getSize(); ++i)
+	for(const RenderingContext::Sm::Face& face : ctx.m_sm.m_faces)
 	{
-		cmdb->beginRenderPass(ctx.m_sm.m_spotFramebuffers[i]);
-		for(U j = 0; j < threadCount; ++j)
+		if(face.m_staticFb.isCreated())
 		{
-			U idx = i * threadCount + j;
-			CommandBufferPtr& cmdb2 = ctx.m_sm.m_spotCommandBuffers[idx];
-			if(cmdb2.isCreated())
-			{
-				cmdb->pushSecondLevelCommandBuffer(cmdb2);
-			}
+			cmdb->beginRenderPass(face.m_staticFb);
+			pushJobs(ctx, face.m_firstStaticJob, face.m_staticJobCount);
+			cmdb->endRenderPass();
 		}
-		cmdb->endRenderPass();
-	}
 
-	// Omni lights
-	for(U i = 0; i < ctx.m_sm.m_omnis.getSize(); ++i)
-	{
-		for(U j = 0; j < 6; ++j)
-		{
-			cmdb->beginRenderPass(ctx.m_sm.m_omniFramebuffers[i][j]);
+		// Start from the static casters and add the dynamic on top
+		cmdb->copyTextureToTexture(
+			face.m_staticTex, face.m_surf, face.m_tex, face.m_surf);
 
-			for(U k = 0; k < threadCount; ++k)
-			{
-				U idx = i * threadCount * 6 + k * 6 + j;
-				CommandBufferPtr& cmdb2 = ctx.m_sm.m_omniCommandBuffers[idx];
-				if(cmdb2.isCreated())
-				{
-					cmdb->pushSecondLevelCommandBuffer(cmdb2);
-				}
-			}
+		if(face.m_jobCount > 0)
+		{
+			cmdb->beginRenderPass(face.m_fb);
+			pushJobs(ctx, face.m_firstJob, face.m_jobCount);
 			cmdb->endRenderPass();
 		}
 	}
@@ -162,6 +233,7 @@ void Sm::bestCandidate(SceneNode& light, TContainer& arr, TShadowmap*& out)
 		{
 			sm.m_light = &light;
 			sm.m_timestamp = 0;
+			sm.m_staticTimestamp = 0;
 			out = &sm;
 			return;
 		}
@@ -179,146 +251,132 @@ void Sm::bestCandidate(SceneNode& light, TContainer& arr, TShadowmap*& out)
 
 	sm->m_light = &light;
 	sm->m_timestamp = 0;
+	sm->m_staticTimestamp = 0;
 	out = sm;
 }
 
 //==============================================================================
-Bool Sm::skip(SceneNode& light, ShadowmapBase& sm)
+Bool Sm::prepareLight(RenderingContext& ctx,
+	SceneNode& light,
+	ShadowmapBase& sm,
+	WeakArray<FaceCasters> faces,
+	Bool& renderStatic)
 {
-	MoveComponent* movc = light.tryGetComponent<MoveComponent>();
-
-	Timestamp lastUpdate = movc->getTimestamp();
+	const Timestamp crntTime = m_r->getGlobalTimestamp();
+	Timestamp lightTime = light.getComponent<MoveComponent>().getTimestamp();
+	Timestamp dynamicTime = 0;
+	U64 staticHash = 0;
+	U64 dynamicHash = 0;
+	U count = 0;
 
 	Error err = light.iterateComponentsOfType<FrustumComponent>(
-		[&](FrustumComponent& fr) {
-			lastUpdate = max(lastUpdate, fr.getTimestamp());
+		[&](FrustumComponent& frc) -> Error {
+			lightTime = max(lightTime, frc.getTimestamp());
 
-			VisibilityTestResults& vi = fr.getVisibilityTestResults();
-			lastUpdate = max(lastUpdate, vi.getShapeUpdateTimestamp());
+			FaceCasters& face = faces[count++];
+			face = FaceCasters();
+			face.m_frc = &frc;
+
+			VisibilityTestResults& vis = frc.getVisibilityTestResults();
+			VisibleNode* it = vis.getBegin(VisibilityGroupType::RENDERABLES_MS);
+			VisibleNode* end = vis.getEnd(VisibilityGroupType::RENDERABLES_MS);
+			const U casterCount = end - it;
+			if(casterCount == 0)
+			{
+				return ErrorCode::NONE;
+			}
+
+			// Split them keeping the order of the visibility
+			face.m_static =
+				ctx.m_tempAllocator.newArray<VisibleNode>(casterCount);
+			face.m_dynamic =
+				ctx.m_tempAllocator.newArray<VisibleNode>(casterCount);
+
+			for(; it != end; ++it)
+			{
+				const SceneNode& node = *it->m_node;
+				const Timestamp casterTime = getCasterTimestamp(node);
+
+				if(casterTime + DYNAMIC_CASTER_FRAMES > crntTime)
+				{
+					face.m_dynamic[face.m_dynamicCount++] = *it;
+					hashCaster(node, dynamicHash);
+					dynamicTime = max(dynamicTime, casterTime);
+				}
+				else
+				{
+					face.m_static[face.m_staticCount++] = *it;
+					hashCaster(node, staticHash);
+				}
+			}
 
 			return ErrorCode::NONE;
 		});
 	(void)err;
-
-	Bool shouldUpdate = lastUpdate >= sm.m_timestamp || m_r->resourcesLoaded();
-	if(shouldUpdate)
-	{
-		sm.m_timestamp = m_r->getGlobalTimestamp();
-	}
+	ANKI_ASSERT(count == faces.getSize());
 
 	// Update the layer ID anyway
 	LightComponent& lcomp = light.getComponent<LightComponent>();
 	lcomp.setShadowMapIndex(sm.m_layerId);
 
-	return !shouldUpdate;
-}
+	// The static layer is valid while the light and the static casters stay
+	// the same. A caster that moves leaves the static casters and it changes
+	// the hash
+	renderStatic = sm.m_staticTimestamp == 0
+		|| lightTime >= sm.m_staticTimestamp
+		|| staticHash != sm.m_staticCastersHash || m_r->resourcesLoaded();
 
-//==============================================================================
-Error Sm::buildCommandBuffers(
-	RenderingContext& ctx, U threadId, U threadCount) const
-{
-	ANKI_TRACE_START_EVENT(RENDER_SM);
+	Bool render = renderStatic || dynamicHash != sm.m_dynamicCastersHash
+		|| dynamicTime >= sm.m_timestamp;
 
-	for(U i = 0; i < ctx.m_sm.m_spots.getSize(); ++i)
+	if(renderStatic)
 	{
-		U idx = i * threadCount + threadId;
-
-		ANKI_CHECK(doSpotLight(*ctx.m_sm.m_spots[i],
-			ctx.m_sm.m_spotCommandBuffers[idx],
-			ctx.m_sm.m_spotFramebuffers[i],
-			threadId,
-			threadCount));
+		sm.m_staticTimestamp = crntTime;
+		sm.m_staticCastersHash = staticHash;
 	}
 
-	for(U i = 0; i < ctx.m_sm.m_omnis.getSize(); ++i)
+	if(render)
 	{
-		U idx = i * threadCount * 6 + threadId * 6 + 0;
-
-		ANKI_CHECK(doOmniLight(*ctx.m_sm.m_omnis[i],
-			&ctx.m_sm.m_omniCommandBuffers[idx],
-			ctx.m_sm.m_omniFramebuffers[i],
-			threadId,
-			threadCount));
+		sm.m_timestamp = crntTime;
+		sm.m_dynamicCastersHash = dynamicHash;
 	}
 
-	ANKI_TRACE_STOP_EVENT(RENDER_SM);
-	return ErrorCode::NONE;
+	return render;
 }
 
 //==============================================================================
-Error Sm::doSpotLight(SceneNode& light,
-	CommandBufferPtr& cmdb,
-	FramebufferPtr& fb,
-	U threadId,
-	U threadCount) const
+Error Sm::buildCommandBuffers(
+	RenderingContext& ctx, U threadId, U threadCount) const
 {
-	FrustumComponent& frc = light.getComponent<FrustumComponent>();
-	VisibilityTestResults& vis = frc.getVisibilityTestResults();
-	U problemSize = vis.getCount(VisibilityGroupType::RENDERABLES_MS);
-	PtrSize start, end;
-	ThreadPoolTask::choseStartEnd(
-		threadId, threadCount, problemSize, start, end);
-
-	if(start == end)
+	ANKI_TRACE_START_EVENT(RENDER_SM);
+
+	// Pick jobs until there are no more
+	RenderingContext::Sm& rctx = ctx.m_sm;
+	Error err = ErrorCode::NONE;
+	U jobIdx;
+	while(!err && (jobIdx = rctx.m_nextJob.fetchAdd(1)) < rctx.m_jobs.getSize())
 	{
-		return ErrorCode::NONE;
+		err = doJob(ctx, jobIdx);
 	}
 
-	CommandBufferInitInfo cinf;
-	cinf.m_flags = CommandBufferFlag::SECOND_LEVEL;
-	cinf.m_framebuffer = fb;
-	cmdb = m_r->getGrManager().newInstance<CommandBuffer>(cinf);
-	cmdb->setViewport(0, 0, m_resolution, m_resolution);
-	cmdb->setPolygonOffset(1.0, 2.0);
-
-	Error err = m_r->getSceneDrawer().drawRange(Pass::SM,
-		frc,
-		cmdb,
-		vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + start,
-		vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + end);
-
+	ANKI_TRACE_STOP_EVENT(RENDER_SM);
 	return err;
 }
 
 //==============================================================================
-Error Sm::doOmniLight(SceneNode& light,
-	CommandBufferPtr cmdbs[],
-	Array<FramebufferPtr, 6>& fbs,
-	U threadId,
-	U threadCount) const
+Error Sm::doJob(RenderingContext& ctx, U jobIdx) const
 {
-	U frCount = 0;
+	RenderingContext::Sm::Job& job = ctx.m_sm.m_jobs[jobIdx];
 
-	Error err = light.iterateComponentsOfType<FrustumComponent>(
-		[&](FrustumComponent& frc) -> Error {
-			VisibilityTestResults& vis = frc.getVisibilityTestResults();
-			U problemSize = vis.getCount(VisibilityGroupType::RENDERABLES_MS);
-			PtrSize start, end;
-			ThreadPoolTask::choseStartEnd(
-				threadId, threadCount, problemSize, start, end);
-
-			if(start != end)
-			{
-				CommandBufferInitInfo cinf;
-				cinf.m_flags = CommandBufferFlag::SECOND_LEVEL;
-				cinf.m_framebuffer = fbs[frCount];
-				cmdbs[frCount] =
-					m_r->getGrManager().newInstance<CommandBuffer>(cinf);
-				cmdbs[frCount]->setViewport(0, 0, m_resolution, m_resolution);
-				cmdbs[frCount]->setPolygonOffset(1.0, 2.0);
-
-				ANKI_CHECK(m_r->getSceneDrawer().drawRange(Pass::SM,
-					frc,
-					cmdbs[frCount],
-					vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + start,
-					vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + end));
-			}
-
-			++frCount;
-			return ErrorCode::NONE;
-		});
+	CommandBufferInitInfo cinf;
+	cinf.m_flags = CommandBufferFlag::SECOND_LEVEL;
+	cinf.m_framebuffer = job.m_fb;
+	job.m_cmdb = m_r->getGrManager().newInstance<CommandBuffer>(cinf);
+	job.m_cmdb->setViewport(0, 0, m_resolution, m_resolution);
+	job.m_cmdb->setPolygonOffset(1.0, 2.0);
 
-	return err;
+	return m_r->getSceneDrawer().drawRange(
+		Pass::SM, *job.m_frc, job.m_cmdb, job.m_begin, job.m_end);
 }
 
 //==============================================================================
@@ -326,15 +384,30 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 {
 	ANKI_TRACE_START_EVENT(RENDER_SM);
 
-	// Gather the lights
+	RenderingContext::Sm& rctx = ctx.m_sm;
 	VisibilityTestResults& vi =
 		ctx.m_frustumComponent->getVisibilityTestResults();
 
-	const U MAX = 64;
-	Array<SceneNode*, MAX> spotCasters;
-	Array<SceneNode*, MAX> omniCasters;
-	U spotCastersCount = 0;
-	U omniCastersCount = 0;
+	const U maxOmnis = min<U>(
+		vi.getCount(VisibilityGroupType::LIGHTS_POINT), m_omnis.getSize());
+	const U maxSpots = min<U>(
+		vi.getCount(VisibilityGroupType::LIGHTS_SPOT), m_spots.getSize());
+	const U maxFaces = maxOmnis * 6 + maxSpots;
+	if(maxFaces == 0)
+	{
+		ANKI_TRACE_STOP_EVENT(RENDER_SM);
+		return;
+	}
+
+	// Gather the faces that need rendering
+	DynamicArrayAuto<RenderingContext::Sm::Face> faces(ctx.m_tempAllocator);
+	faces.create(maxFaces);
+	DynamicArrayAuto<FaceCasters> faceCasters(ctx.m_tempAllocator);
+	faceCasters.create(maxFaces);
+	U faceCount = 0;
+	U omniCount = 0;
+	U spotCount = 0;
+	Bool tooMany = false;
 
 	auto it = vi.getBegin(VisibilityGroupType::LIGHTS_POINT);
 	auto lend = vi.getEnd(VisibilityGroupType::LIGHTS_POINT);
@@ -344,15 +417,42 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 		LightComponent& light = node->getComponent<LightComponent>();
 		ANKI_ASSERT(light.getLightType() == LightComponent::LightType::POINT);
 
-		if(light.getShadowEnabled())
+		if(!light.getShadowEnabled())
+		{
+			continue;
+		}
+
+		if(omniCount == maxOmnis)
 		{
-			ShadowmapOmni* sm;
-			bestCandidate(*node, m_omnis, sm);
+			tooMany = true;
+			break;
+		}
+		++omniCount;
 
-			if(!skip(*node, *sm))
+		ShadowmapOmni* sm;
+		bestCandidate(*node, m_omnis, sm);
+
+		Bool renderStatic;
+		if(!prepareLight(ctx,
+			   *node,
+			   *sm,
+			   WeakArray<FaceCasters>(&faceCasters[faceCount], 6),
+			   renderStatic))
+		{
+			continue;
+		}
+
+		for(U i = 0; i < 6; ++i)
+		{
+			RenderingContext::Sm::Face& face = faces[faceCount++];
+			face.m_fb = sm->m_fb[i];
+			if(renderStatic)
 			{
-				omniCasters[omniCastersCount++] = node;
+				face.m_staticFb = sm->m_staticFb[i];
 			}
+			face.m_tex = m_omniTexArray;
+			face.m_staticTex = m_omniStaticTexArray;
+			face.m_surf = TextureSurfaceInfo(0, 0, i, sm->m_layerId);
 		}
 	}
 
@@ -364,70 +464,107 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 		LightComponent& light = node->getComponent<LightComponent>();
 		ANKI_ASSERT(light.getLightType() == LightComponent::LightType::SPOT);
 
-		if(light.getShadowEnabled())
+		if(!light.getShadowEnabled())
 		{
-			ShadowmapSpot* sm;
-			bestCandidate(*node, m_spots, sm);
+			continue;
+		}
 
-			if(!skip(*node, *sm))
-			{
-				spotCasters[spotCastersCount++] = node;
-			}
+		if(spotCount == maxSpots)
+		{
+			tooMany = true;
+			break;
+		}
+		++spotCount;
+
+		ShadowmapSpot* sm;
+		bestCandidate(*node, m_spots, sm);
+
+		Bool renderStatic;
+		if(!prepareLight(ctx,
+			   *node,
+			   *sm,
+			   WeakArray<FaceCasters>(&faceCasters[faceCount], 1),
+			   renderStatic))
+		{
+			continue;
 		}
+
+		RenderingContext::Sm::Face& face = faces[faceCount++];
+		face.m_fb = sm->m_fb;
+		if(renderStatic)
+		{
+			face.m_staticFb = sm->m_staticFb;
+		}
+		face.m_tex = m_spotTexArray;
+		face.m_staticTex = m_spotStaticTexArray;
+		face.m_surf = TextureSurfaceInfo(0, 0, 0, sm->m_layerId);
 	}
 
-	if(omniCastersCount > m_omnis.getSize()
-		|| spotCastersCount > m_spots.getSize())
+	if(tooMany)
 	{
 		ANKI_LOGW("Too many shadow casters");
-		omniCastersCount = min<U>(omniCastersCount, m_omnis.getSize());
-		spotCastersCount = min<U>(spotCastersCount, m_spots.getSize());
 	}
 
-	if(spotCastersCount > 0)
-	{
-		ctx.m_sm.m_spots.create(spotCastersCount);
-		memcpy(&ctx.m_sm.m_spots[0],
-			&spotCasters[0],
-			sizeof(SceneNode*) * spotCastersCount);
+	ANKI_TRACE_INC_COUNTER(RENDERER_SHADOW_PASSES, faceCount);
 
-		ctx.m_sm.m_spotCommandBuffers.create(
-			spotCastersCount * m_r->getThreadPool().getThreadsCount());
+	if(faceCount == 0)
+	{
+		ANKI_TRACE_STOP_EVENT(RENDER_SM);
+		return;
+	}
 
-		ctx.m_sm.m_spotFramebuffers.create(spotCastersCount);
-		for(U i = 0; i < spotCastersCount; ++i)
+	// Count the jobs
+	U jobCount = 0;
+	for(U i = 0; i < faceCount; ++i)
+	{
+		const FaceCasters& casters = faceCasters[i];
+		if(faces[i].m_staticFb.isCreated())
 		{
-			const LightComponent& lightc =
-				ctx.m_sm.m_spots[i]->getComponent<LightComponent>();
-			U idx = lightc.getShadowMapIndex();
-
-			ctx.m_sm.m_spotFramebuffers[i] = m_spots[idx].m_fb;
+			jobCount += (casters.m_staticCount + JOB_CASTER_COUNT - 1)
+				/ JOB_CASTER_COUNT;
 		}
+
+		jobCount += (casters.m_dynamicCount + JOB_CASTER_COUNT - 1)
+			/ JOB_CASTER_COUNT;
 	}
 
-	if(omniCastersCount > 0)
+	if(jobCount > 0)
 	{
-		ctx.m_sm.m_omnis.create(omniCastersCount);
-		memcpy(&ctx.m_sm.m_omnis[0],
-			&omniCasters[0],
-			sizeof(SceneNode*) * omniCastersCount);
+		rctx.m_jobs.create(jobCount);
+	}
 
-		ctx.m_sm.m_omniCommandBuffers.create(
-			omniCastersCount * 6 * m_r->getThreadPool().getThreadsCount());
+	// Create the jobs and the faces
+	rctx.m_faces.create(faceCount);
+	U32 nextJob = 0;
+	for(U i = 0; i < faceCount; ++i)
+	{
+		const FaceCasters& casters = faceCasters[i];
+		RenderingContext::Sm::Face& face = faces[i];
 
-		ctx.m_sm.m_omniFramebuffers.create(omniCastersCount);
-		for(U i = 0; i < omniCastersCount; ++i)
+		if(face.m_staticFb.isCreated())
 		{
-			const LightComponent& lightc =
-				ctx.m_sm.m_omnis[i]->getComponent<LightComponent>();
-			U idx = lightc.getShadowMapIndex();
-
-			for(U j = 0; j < 6; ++j)
-			{
-				ctx.m_sm.m_omniFramebuffers[i][j] = m_omnis[idx].m_fb[j];
-			}
+			newJobs(ctx,
+				*casters.m_frc,
+				casters.m_static,
+				casters.m_staticCount,
+				face.m_staticFb,
+				nextJob,
+				face.m_firstStaticJob,
+				face.m_staticJobCount);
 		}
+
+		newJobs(ctx,
+			*casters.m_frc,
+			casters.m_dynamic,
+			casters.m_dynamicCount,
+			face.m_fb,
+			nextJob,
+			face.m_firstJob,
+			face.m_jobCount);
+
+		rctx.m_faces[i] = face;
 	}
+	ANKI_ASSERT(nextJob == jobCount);
 
 	ANKI_TRACE_STOP_EVENT(RENDER_SM);
 }
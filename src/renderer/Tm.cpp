@@ -69,9 +69,6 @@ void Tm::run(RenderingContext& ctx)
 	cmdb->bindResourceGroup(m_rcGroup, 0, nullptr);
 
 	cmdb->dispatchCompute(1, 1, 1);
-	cmdb->setBufferBarrier(m_luminanceBuff,
-		BufferUsageBit::STORAGE_COMPUTE_SHADER_WRITE,
-		BufferUsageBit::UNIFORM_FRAGMENT_SHADER);
 }
 
 } // end namespace anki
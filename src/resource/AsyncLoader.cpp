@@ -9,9 +9,31 @@
 namespace anki
 {
 
+//==============================================================================
+// AsyncLoaderTask                                                             =
+//==============================================================================
+
+//==============================================================================
+Bool AsyncLoaderTask::dependenciesSignaled() const
+{
+	for(U i = 0; i < m_dependencyCount; ++i)
+	{
+		if(!m_dependencies[i]->isSignaled())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//==============================================================================
+// AsyncLoader                                                                 =
+//==============================================================================
+
 //==============================================================================
 AsyncLoader::AsyncLoader()
-	: m_thread("anki_asyload")
+	: m_uploadThread("anki_asyupload")
 {
 }
 
@@ -20,24 +42,68 @@ AsyncLoader::~AsyncLoader()
 {
 	stop();
 
-	if(!m_taskQueue.isEmpty())
+	Bool hasWork = !m_waitingTasks.isEmpty();
+	for(IntrusiveList<AsyncLoaderTask>& queue : m_taskQueues)
+	{
+		hasWork = hasWork || !queue.isEmpty();
+	}
+
+	if(hasWork)
 	{
 		ANKI_LOGW("Stoping loading thread while there is work to do");
 
-		while(!m_taskQueue.isEmpty())
+		for(IntrusiveList<AsyncLoaderTask>& queue : m_taskQueues)
+		{
+			while(!queue.isEmpty())
+			{
+				AsyncLoaderTask* task = &queue.getFront();
+				queue.popFront();
+				retireTask(task);
+			}
+		}
+
+		while(!m_waitingTasks.isEmpty())
 		{
-			AsyncLoaderTask* task = &m_taskQueue.getFront();
-			m_taskQueue.popFront();
-			m_alloc.deleteInstance(task);
+			AsyncLoaderTask* task = &m_waitingTasks.getFront();
+			m_waitingTasks.popFront();
+			retireTask(task);
 		}
 	}
+
+	for(Thread* thread : m_ioThreads)
+	{
+		m_alloc.deleteInstance(thread);
+	}
+
+	m_ioThreads.destroy(m_alloc);
 }
 
 //==============================================================================
-void AsyncLoader::init(const HeapAllocator<U8>& alloc)
+void AsyncLoader::init(const HeapAllocator<U8>& alloc,
+	U ioThreadCount,
+	PtrSize uploadBudgetPerFrame)
 {
+	ANKI_ASSERT(ioThreadCount > 0);
+	ANKI_ASSERT(uploadBudgetPerFrame > 0);
+
 	m_alloc = alloc;
-	m_thread.start(this, threadCallback);
+	m_uploadBudgetPerFrame = uploadBudgetPerFrame;
+	m_uploadBudget = uploadBudgetPerFrame;
+
+	m_threadInfos[AsyncLoaderStage::IO].m_loader = this;
+	m_threadInfos[AsyncLoaderStage::IO].m_stage = AsyncLoaderStage::IO;
+	m_threadInfos[AsyncLoaderStage::UPLOAD].m_loader = this;
+	m_threadInfos[AsyncLoaderStage::UPLOAD].m_stage = AsyncLoaderStage::UPLOAD;
+
+	m_ioThreads.create(m_alloc, ioThreadCount);
+	for(Thread*& thread : m_ioThreads)
+	{
+		thread = m_alloc.newInstance<Thread>("anki_asyload");
+		thread->start(&m_threadInfos[AsyncLoaderStage::IO], threadCallback);
+	}
+
+	m_uploadThread.start(
+		&m_threadInfos[AsyncLoaderStage::UPLOAD], threadCallback);
 }
 
 //==============================================================================
@@ -46,24 +112,30 @@ void AsyncLoader::stop()
 	{
 		LockGuard<Mutex> lock(m_mtx);
 		m_quit = true;
-		m_condVar.notifyOne();
+		m_condVar.notifyAll();
+	}
+
+	for(Thread* thread : m_ioThreads)
+	{
+		Error err = thread->join();
+		(void)err;
 	}
 
-	Error err = m_thread.join();
+	Error err = m_uploadThread.join();
 	(void)err;
 }
 
 //==============================================================================
 void AsyncLoader::pause()
 {
+	LockGuard<Mutex> lock(m_mtx);
+	m_paused = true;
+
+	while(m_runningTaskCounts[AsyncLoaderStage::IO] > 0
+		|| m_runningTaskCounts[AsyncLoaderStage::UPLOAD] > 0)
 	{
-		LockGuard<Mutex> lock(m_mtx);
-		m_paused = true;
-		m_sync = true;
-		m_condVar.notifyOne();
+		m_condVar.wait(m_mtx);
 	}
-
-	m_barrier.wait();
 }
 
 //==============================================================================
@@ -71,65 +143,89 @@ void AsyncLoader::resume()
 {
 	LockGuard<Mutex> lock(m_mtx);
 	m_paused = false;
-	m_condVar.notifyOne();
+	m_condVar.notifyAll();
+}
+
+//==============================================================================
+void AsyncLoader::syncUploads()
+{
+	LockGuard<Mutex> lock(m_mtx);
+	m_uploadsBlocked = true;
+
+	while(m_runningTaskCounts[AsyncLoaderStage::UPLOAD] > 0)
+	{
+		m_condVar.wait(m_mtx);
+	}
+}
+
+//==============================================================================
+void AsyncLoader::newFrame()
+{
+	LockGuard<Mutex> lock(m_mtx);
+	m_uploadsBlocked = false;
+	m_uploadBudget = m_uploadBudgetPerFrame;
+	m_condVar.notifyAll();
 }
 
 //==============================================================================
 Error AsyncLoader::threadCallback(Thread::Info& info)
 {
-	AsyncLoader& self = *reinterpret_cast<AsyncLoader*>(info.m_userData);
-	return self.threadWorker();
+	ThreadInfo& tinfo = *reinterpret_cast<ThreadInfo*>(info.m_userData);
+	tinfo.m_loader->threadWorker(tinfo.m_stage);
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Bool AsyncLoader::canRunTask(AsyncLoaderStage stage) const
+{
+	if(m_paused || m_taskQueues[stage].isEmpty())
+	{
+		return false;
+	}
+
+	if(stage == AsyncLoaderStage::UPLOAD)
+	{
+		return !m_uploadsBlocked && m_uploadBudget > 0;
+	}
+
+	return true;
 }
 
 //==============================================================================
-Error AsyncLoader::threadWorker()
+void AsyncLoader::threadWorker(AsyncLoaderStage stage)
 {
-	Error err = ErrorCode::NONE;
+	IntrusiveList<AsyncLoaderTask>& queue = m_taskQueues[stage];
 
-	while(!err)
+	while(1)
 	{
 		AsyncLoaderTask* task = nullptr;
-		Bool quit = false;
-		Bool sync = false;
+		AsyncLoaderTaskContext ctx;
 
 		{
 			// Wait for something
 			LockGuard<Mutex> lock(m_mtx);
-			while((m_taskQueue.isEmpty() || m_paused) && !m_quit && !m_sync)
+			while(!canRunTask(stage) && !m_quit)
 			{
 				m_condVar.wait(m_mtx);
 			}
 
-			// Do some work
 			if(m_quit)
 			{
-				quit = true;
+				break;
 			}
-			else if(m_sync)
-			{
-				sync = true;
-				m_sync = false;
-			}
-			else
-			{
-				task = &m_taskQueue.getFront();
-				m_taskQueue.popFront();
-			}
-		}
 
-		if(quit)
-		{
-			break;
-		}
-		else if(sync)
-		{
-			m_barrier.wait();
+			task = &queue.getFront();
+			queue.popFront();
+			++m_runningTaskCounts[stage];
+			ctx.m_uploadBudget = m_uploadBudget;
 		}
-		else
+
+		// Exec the task if no one canceled it
+		ANKI_ASSERT(task);
+		Bool canceled = task->m_fence && task->m_fence->isCanceled();
+		Error err = ErrorCode::NONE;
+		if(!canceled)
 		{
-			// Exec the task
-			ANKI_ASSERT(task);
-			AsyncLoaderTaskContext ctx;
 			err = (*task)(ctx);
 			if(!err)
 			{
@@ -137,45 +233,126 @@ Error AsyncLoader::threadWorker()
 			}
 			else
 			{
+				// Keep going. Only the owner of the task cares
 				ANKI_LOGE("Async loader task failed");
+
+				if(task->m_fence)
+				{
+					task->m_fence->m_failed.store(1);
+				}
 			}
+		}
 
-			// Do other stuff
+		// Do other stuff
+		LockGuard<Mutex> lock(m_mtx);
+		--m_runningTaskCounts[stage];
+
+		if(stage == AsyncLoaderStage::UPLOAD)
+		{
+			// A resubmitted upload ran out of budget or transient memory. Wait
+			// for the next frame
+			m_uploadBudget -= min(ctx.m_uploadedBytes, m_uploadBudget);
 			if(ctx.m_resubmitTask)
 			{
-				LockGuard<Mutex> lock(m_mtx);
-				m_taskQueue.pushBack(task);
-			}
-			else
-			{
-				// Delete the task
-				m_alloc.deleteInstance(task);
+				m_uploadBudget = 0;
 			}
+		}
 
-			if(ctx.m_pause)
-			{
-				LockGuard<Mutex> lock(m_mtx);
-				m_paused = true;
-			}
+		if(ctx.m_resubmitTask && !canceled && !err)
+		{
+			pushReadyTask(task);
+		}
+		else
+		{
+			retireTask(task);
+		}
+
+		if(ctx.m_pause)
+		{
+			m_paused = true;
 		}
+
+		m_condVar.notifyAll();
 	}
+}
 
-	return err;
+//==============================================================================
+void AsyncLoader::pushReadyTask(AsyncLoaderTask* task)
+{
+	// Keep the queue sorted by priority. Tasks with the same priority run in
+	// submission order
+	IntrusiveList<AsyncLoaderTask>& queue = m_taskQueues[task->m_stage];
+
+	auto it = queue.getBegin();
+	while(it != queue.getEnd() && it->m_priority >= task->m_priority)
+	{
+		++it;
+	}
+
+	queue.insert(it, task);
+}
+
+//==============================================================================
+void AsyncLoader::releaseWaitingTasks()
+{
+	auto it = m_waitingTasks.getBegin();
+	while(it != m_waitingTasks.getEnd())
+	{
+		AsyncLoaderTask* task = &(*it);
+		++it;
+
+		if(task->dependenciesSignaled())
+		{
+			m_waitingTasks.erase(task);
+			pushReadyTask(task);
+		}
+	}
 }
 
 //==============================================================================
-void AsyncLoader::submitTask(AsyncLoaderTask* task)
+void AsyncLoader::retireTask(AsyncLoaderTask* task)
+{
+	Bool hasFence = task->m_fence.isCreated();
+	if(hasFence)
+	{
+		// Release to publish the results of the task and the failed flag
+		task->m_fence->m_signaled.store(1, AtomicMemoryOrder::RELEASE);
+	}
+
+	m_alloc.deleteInstance(task);
+
+	if(hasFence)
+	{
+		releaseWaitingTasks();
+	}
+}
+
+//==============================================================================
+void AsyncLoader::submitTask(AsyncLoaderTask* task, AsyncLoaderFencePtr* fence)
 {
 	ANKI_ASSERT(task);
 
-	// Append task to the list
 	LockGuard<Mutex> lock(m_mtx);
-	m_taskQueue.pushBack(task);
 
-	if(!m_paused)
+	if(fence)
+	{
+		task->m_fence.reset(m_alloc.newInstance<AsyncLoaderFence>(m_alloc));
+		*fence = task->m_fence;
+	}
+
+	if(task->dependenciesSignaled())
+	{
+		pushReadyTask(task);
+
+		if(!m_paused)
+		{
+			// Wake up the threads if they are not paused
+			m_condVar.notifyAll();
+		}
+	}
+	else
 	{
-		// Wake up the thread if it's not paused
-		m_condVar.notifyOne();
+		m_waitingTasks.pushBack(task);
 	}
 }
 
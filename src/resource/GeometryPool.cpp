@@ -0,0 +1,107 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/GeometryPool.h>
+
+namespace anki
+{
+
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+/// The meshes are allocated in blocks of that size.
+static const PtrSize BLOCK_SIZE = 4 * 1024 * 1024;
+
+//==============================================================================
+// GeometryPool                                                                =
+//==============================================================================
+
+//==============================================================================
+void GeometryPool::init(GrManager* gr,
+	GenericMemoryPoolAllocator<U8> alloc,
+	PtrSize vertexMemorySize,
+	PtrSize indexMemorySize)
+{
+	ANKI_ASSERT(gr);
+	ANKI_ASSERT(!isCreated());
+
+	// Round to a few blocks
+	m_blockSize = BLOCK_SIZE;
+	vertexMemorySize =
+		max(getAlignedRoundUp(m_blockSize, vertexMemorySize), 2 * m_blockSize);
+	indexMemorySize =
+		max(getAlignedRoundUp(m_blockSize, indexMemorySize), 2 * m_blockSize);
+
+	m_vertBuff = gr->newInstance<Buffer>(vertexMemorySize,
+		BufferUsageBit::VERTEX | BufferUsageBit::TRANSFER_DESTINATION,
+		BufferMapAccessBit::NONE);
+	m_vertAlloc.init(alloc, vertexMemorySize, m_blockSize);
+
+	m_indexBuff = gr->newInstance<Buffer>(indexMemorySize,
+		BufferUsageBit::INDEX | BufferUsageBit::TRANSFER_DESTINATION,
+		BufferMapAccessBit::NONE);
+	m_indexAlloc.init(alloc, indexMemorySize, m_blockSize);
+}
+
+//==============================================================================
+Bool GeometryPool::allocateVertices(PtrSize size, U32 stride, U32& baseVertex)
+{
+	ANKI_ASSERT(isCreated());
+	ANKI_ASSERT(size > 0 && stride > 0 && (size % stride) == 0);
+
+	// The offset should be a multiple of the stride. Allocate one more vertex
+	// since the stride may not be a power of two
+	const PtrSize allocSize = size + stride;
+	if(allocSize >= m_blockSize)
+	{
+		return false;
+	}
+
+	PtrSize offset;
+	if(m_vertAlloc.allocate(allocSize, 4, offset))
+	{
+		return false;
+	}
+
+	baseVertex = (offset + stride - 1) / stride;
+	return true;
+}
+
+//==============================================================================
+void GeometryPool::freeVertices(U32 baseVertex, U32 stride)
+{
+	// The rounded offset is in the same block as the real one
+	m_vertAlloc.free(PtrSize(baseVertex) * stride);
+}
+
+//==============================================================================
+Bool GeometryPool::allocateIndices(PtrSize size, U32 indexSize, U32& firstIndex)
+{
+	ANKI_ASSERT(isCreated());
+	ANKI_ASSERT(size > 0 && isPowerOfTwo(indexSize));
+
+	if(size >= m_blockSize)
+	{
+		return false;
+	}
+
+	PtrSize offset;
+	if(m_indexAlloc.allocate(size, indexSize, offset))
+	{
+		return false;
+	}
+
+	firstIndex = offset / indexSize;
+	return true;
+}
+
+//==============================================================================
+void GeometryPool::freeIndices(U32 firstIndex, U32 indexSize)
+{
+	m_indexAlloc.free(PtrSize(firstIndex) * indexSize);
+}
+
+} // end namespace anki
@@ -477,9 +477,17 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 				surf.m_width = mipWidth;
 				surf.m_height = mipHeight;
 
-				surf.m_data.create(alloc, dataSize);
-
-				ANKI_CHECK(file->read(&surf.m_data[0], dataSize));
+				if(file->isMapped())
+				{
+					// Point to the mapped file to avoid copies
+					ANKI_CHECK(file->readMapped(dataSize, surf.m_mappedData));
+					surf.m_mappedDataSize = dataSize;
+				}
+				else
+				{
+					surf.m_data.create(alloc, dataSize);
+					ANKI_CHECK(file->read(&surf.m_data[0], dataSize));
+				}
 			}
 			else
 			{
@@ -554,6 +562,12 @@ Error ImageLoader::load(
 		m_compression = ImageLoader::DataCompression::ETC;
 #endif
 
+		// The surfaces may point to the mapped file
+		if(file->isMapped())
+		{
+			m_file = file;
+		}
+
 		ANKI_CHECK(loadAnkiTexture(file,
 			maxTextureSize,
 			m_compression,
@@ -612,6 +626,7 @@ void ImageLoader::destroy()
 	}
 
 	m_surfaces.destroy(m_alloc);
+	m_file.reset(nullptr);
 }
 
 } // end namespace anki
@@ -6,6 +6,8 @@
 #include <anki/resource/Material.h>
 #include <anki/resource/MaterialLoader.h>
 #include <anki/resource/ResourceManager.h>
+#include <anki/resource/AsyncLoader.h>
+#include <anki/resource/GeometryPool.h>
 #include <anki/core/App.h>
 #include <anki/util/Logger.h>
 #include <anki/resource/ShaderResource.h>
@@ -50,6 +52,31 @@ Error UpdateTexturesVisitor::
 	return ErrorCode::NONE;
 }
 
+/// Create a variant in the background. It holds a reference so the material
+/// outlives the task even if the task never runs.
+class MaterialVariantCreateTask : public AsyncLoaderTask
+{
+public:
+	MaterialResourcePtr m_mtl;
+	RenderingKey m_key;
+
+	MaterialVariantCreateTask(Material* mtl, const RenderingKey& key)
+		: m_key(key)
+	{
+		m_mtl.reset(mtl);
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx) final
+	{
+		m_mtl->createVariant(m_key);
+
+		// Release it here and not when the loader deletes the task with its
+		// lock held. It may be the last reference
+		m_mtl.reset(nullptr);
+		return ErrorCode::NONE;
+	}
+};
+
 //==============================================================================
 // MaterialVariableTemplate                                                    =
 //==============================================================================
@@ -145,7 +172,7 @@ MaterialVariant::~MaterialVariant()
 }
 
 //==============================================================================
-Error MaterialVariant::init(
+void MaterialVariant::init(
 	const RenderingKey& key2, Material& mtl, MaterialLoader& loader)
 {
 	RenderingKey key = key2;
@@ -211,20 +238,16 @@ Error MaterialVariant::init(
 			continue;
 		}
 
-		const String& src = loader.getShaderSource(stype);
-
-		StringAuto filename(mtl.getTempAllocator());
-		ANKI_CHECK(mtl.createProgramSourceToCache(src, stype, filename));
+		// The includes are already resolved so create the shader directly.
+		// That way the variants can be created from any thread
+		StringAuto source(mtl.getAllocator());
+		source.append(mtl.getManager()._getShadersPrependedSource());
+		source.append(loader.getShaderSource(stype));
 
-		ShaderResourcePtr& shader = m_shaders[U(stype)];
-
-		ANKI_CHECK(mtl.getManager().loadResource(filename.toCString(), shader));
-
-		// Update the hash
-		mtl.m_hash ^= computeHash(&src[0], src.getLength());
+		m_shaders[U(stype)] =
+			mtl.getManager().getGrManager().newInstance<Shader>(
+				stype, source.toCString());
 	}
-
-	return ErrorCode::NONE;
 }
 
 //==============================================================================
@@ -247,8 +270,24 @@ Material::Material(ResourceManager* manager)
 //==============================================================================
 Material::~Material()
 {
+	if(!m_usageLogFilename.isEmpty())
+	{
+		Error err = saveUsageLog();
+		if(err)
+		{
+			ANKI_LOGW("Failed to write the usage log of a material");
+		}
+	}
+
 	auto alloc = getAllocator();
 
+	if(m_loader)
+	{
+		alloc.deleteInstance(m_loader);
+	}
+
+	m_usageLogFilename.destroy(alloc);
+
 	for(MaterialVariant& var : m_variants)
 	{
 		var.destroy(alloc);
@@ -269,8 +308,10 @@ Error Material::load(const ResourceFilename& filename)
 	XmlDocument doc;
 	ANKI_CHECK(openFileParseXml(filename, doc));
 
-	MaterialLoader loader(getTempAllocator());
+	m_loader = getAllocator().newInstance<MaterialLoader>(getAllocator());
+	MaterialLoader& loader = *m_loader;
 	ANKI_CHECK(loader.parseXmlDocument(doc));
+	ANKI_CHECK(loader.resolveIncludes(getManager()));
 
 	m_lodCount = loader.getLodCount();
 	m_shadow = loader.getShadowEnabled();
@@ -278,9 +319,19 @@ Error Material::load(const ResourceFilename& filename)
 	m_tessellation = loader.getTessellationEnabled();
 	m_instanced = loader.isInstanced();
 
-	// Start initializing
+	// Start initializing. The variants are created on demand
 	ANKI_CHECK(createVars(loader));
-	ANKI_CHECK(createVariants(loader));
+	initVariantMatrix();
+
+	m_hash = computeHash(&filename[0], filename.getLength());
+
+	// Prewarm the variants of the previous runs
+	m_usageLogFilename.sprintf(getAllocator(),
+		"%s/mtl_%016llx.usage",
+		&getManager()._getCacheDirectory()[0],
+		static_cast<unsigned long long>(m_hash));
+
+	ANKI_CHECK(loadUsageLog());
 
 	return ErrorCode::NONE;
 }
@@ -353,13 +404,12 @@ Error Material::createVars(const MaterialLoader& loader)
 }
 
 //==============================================================================
-Error Material::createVariants(MaterialLoader& loader)
+void Material::initVariantMatrix()
 {
 	U tessStates = m_tessellation ? 2 : 1;
 	U instStates = m_instanced ? MAX_INSTANCE_GROUPS : 1;
 	U passStates = m_shadow ? 2 : 1;
 
-	// Init the variant matrix
 	U variantsCount = 0;
 	for(U p = 0; p < passStates; ++p)
 	{
@@ -376,16 +426,119 @@ Error Material::createVariants(MaterialLoader& loader)
 		}
 	}
 
-	// Create the variants
 	m_variants.create(getAllocator(), variantsCount);
+}
 
-	for(U p = 0; p < passStates; ++p)
+//==============================================================================
+U Material::getVariantIndex(const RenderingKey& key) const
+{
+	U lod = min<U>(m_lodCount - 1, key.m_lod);
+	U16 idx = m_variantMatrix[U(key.m_pass)][lod][key.m_tessellation]
+							 [getInstanceGroupIdx(key.m_instanceCount)];
+
+	ANKI_ASSERT(idx != MAX_U16);
+	return idx;
+}
+
+//==============================================================================
+void Material::createVariant(const RenderingKey& key)
+{
+	MaterialVariant& variant = m_variants[getVariantIndex(key)];
+
+	// The loader is mutated so create one variant at a time
+	LockGuard<Mutex> lock(m_loaderMtx);
+
+	if(variant.m_state.load(AtomicMemoryOrder::ACQUIRE)
+		!= U8(MaterialVariant::State::CREATED))
 	{
-		for(U l = 0; l < m_lodCount; ++l)
+		// The shaders are sized for the whole instance group
+		RenderingKey groupKey(key.m_pass,
+			min<U>(m_lodCount - 1, key.m_lod),
+			key.m_tessellation,
+			1 << getInstanceGroupIdx(key.m_instanceCount));
+
+		variant.init(groupKey, *this, *m_loader);
+
+		// Publish the variant to the threads that don't take the lock
+		variant.m_state.store(
+			U8(MaterialVariant::State::CREATED), AtomicMemoryOrder::RELEASE);
+	}
+}
+
+//==============================================================================
+void Material::queueVariant(const RenderingKey& key)
+{
+	MaterialVariant& variant = m_variants[getVariantIndex(key)];
+
+	U8 expected = U8(MaterialVariant::State::NOT_CREATED);
+	if(variant.m_state.compareExchange(
+		   expected, U8(MaterialVariant::State::QUEUED)))
+	{
+		getManager().getAsyncLoader().submitNewTask<MaterialVariantCreateTask>(
+			this, key);
+	}
+}
+
+//==============================================================================
+Error Material::loadUsageLog()
+{
+	if(!fileExists(m_usageLogFilename.toCString()))
+	{
+		return ErrorCode::NONE;
+	}
+
+	File file;
+	ANKI_CHECK(file.open(m_usageLogFilename.toCString(),
+		File::OpenFlag::READ | File::OpenFlag::BINARY));
+
+	// Every record is the pass, the LOD, the tessellation and the instance
+	// group of a variant
+	Array<U8, 4> rec;
+	const PtrSize size = file.getSize();
+	if(size % sizeof(rec) != 0)
+	{
+		ANKI_LOGW("Ignoring a malformed material usage log: %s",
+			&m_usageLogFilename[0]);
+		return ErrorCode::NONE;
+	}
+
+	for(PtrSize i = 0; i < size / sizeof(rec); ++i)
+	{
+		ANKI_CHECK(file.read(&rec[0], sizeof(rec)));
+
+		// Skip the variants that don't exist any more
+		if(rec[0] >= U(Pass::COUNT) || rec[1] >= MAX_LODS || rec[2] > 1
+			|| rec[3] >= MAX_INSTANCE_GROUPS
+			|| m_variantMatrix[rec[0]][rec[1]][rec[2]][rec[3]] == MAX_U16)
 		{
-			for(U t = 0; t < tessStates; ++t)
+			continue;
+		}
+
+		RenderingKey key(Pass(rec[0]), rec[1], rec[2], 1 << rec[3]);
+		m_variants[getVariantIndex(key)].m_inUsageLog = true;
+		queueVariant(key);
+	}
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error Material::saveUsageLog() const
+{
+	// Write the log only if there are new variants. Keep the variants of the
+	// log since they may be used in other parts of the game
+	DynamicArrayAuto<Array<U8, 4>> recs(getAllocator());
+	recs.create(m_variants.getSize());
+	U recCount = 0;
+	Bool newVariants = false;
+
+	for(U p = 0; p < U(Pass::COUNT); ++p)
+	{
+		for(U l = 0; l < MAX_LODS; ++l)
+		{
+			for(U t = 0; t < 2; ++t)
 			{
-				for(U i = 0; i < instStates; ++i)
+				for(U i = 0; i < MAX_INSTANCE_GROUPS; ++i)
 				{
 					U idx = m_variantMatrix[p][l][t][i];
 					if(idx == MAX_U16)
@@ -393,46 +546,28 @@ Error Material::createVariants(MaterialLoader& loader)
 						continue;
 					}
 
-					RenderingKey key;
-					key.m_pass = Pass(p);
-					key.m_lod = l;
-					key.m_tessellation = t;
-					key.m_instanceCount = 1 << i;
-
-					ANKI_CHECK(m_variants[idx].init(key, *this, loader));
+					const MaterialVariant& variant = m_variants[idx];
+					const Bool used = variant.m_used.load();
+					if(used || variant.m_inUsageLog)
+					{
+						recs[recCount++] = {{U8(p), U8(l), U8(t), U8(i)}};
+						newVariants = newVariants || !variant.m_inUsageLog;
+					}
 				}
 			}
 		}
 	}
 
-	return ErrorCode::NONE;
-}
-
-//==============================================================================
-Error Material::createProgramSourceToCache(
-	const String& source, ShaderType type, StringAuto& out)
-{
-	auto alloc = getTempAllocator();
-
-	// Create the hash
-	U64 h = computeHash(&source[0], source.getLength());
-
-	// Create out
-	out.sprintf("mtl_%llu%s", h, &shaderTypeToFileExtension(type)[0]);
-
-	// Create path
-	StringAuto fullFname(alloc);
-	fullFname.sprintf("%s/%s", &getManager()._getCacheDirectory()[0], &out[0]);
-
-	// If file not exists write it
-	if(!fileExists(fullFname.toCString()))
+	if(!newVariants)
 	{
-		// If not create it
-		File f;
-		ANKI_CHECK(f.open(fullFname.toCString(), File::OpenFlag::WRITE));
-		ANKI_CHECK(f.writeText("%s\n", &source[0]));
+		return ErrorCode::NONE;
 	}
 
+	File file;
+	ANKI_CHECK(file.open(m_usageLogFilename.toCString(),
+		File::OpenFlag::WRITE | File::OpenFlag::BINARY));
+	ANKI_CHECK(file.write(&recs[0], recCount * sizeof(recs[0])));
+
 	return ErrorCode::NONE;
 }
 
@@ -452,15 +587,84 @@ void Material::fillResourceGroupInitInfo(ResourceGroupInitInfo& rcinit)
 	}
 }
 
+//==============================================================================
+ResourceGroupPtr Material::getGeometryPoolResourceGroup()
+{
+	// Models that share the material are loaded from many threads
+	LockGuard<Mutex> lock(m_geometryPoolGrResourcesMtx);
+
+	if(!m_geometryPoolGrResources.isCreated())
+	{
+		const GeometryPool& pool = getManager().getGeometryPool();
+
+		ResourceGroupInitInfo rcinit;
+		fillResourceGroupInitInfo(rcinit);
+		rcinit.m_vertexBuffers[0].m_buffer = pool.getVertexBuffer();
+		rcinit.m_indexBuffer.m_buffer = pool.getIndexBuffer();
+		rcinit.m_indexSize = 2;
+
+		m_geometryPoolGrResources =
+			getManager().getGrManager().newInstance<ResourceGroup>(rcinit);
+	}
+
+	return m_geometryPoolGrResources;
+}
+
 //==============================================================================
 const MaterialVariant& Material::getVariant(const RenderingKey& key) const
 {
-	U lod = min<U>(m_lodCount - 1, key.m_lod);
-	U16 idx = m_variantMatrix[U(key.m_pass)][lod][key.m_tessellation]
-							 [getInstanceGroupIdx(key.m_instanceCount)];
+	MaterialVariant& variant = m_variants[getVariantIndex(key)];
 
-	ANKI_ASSERT(idx != MAX_U16);
-	return m_variants[idx];
+	if(ANKI_UNLIKELY(variant.m_state.load(AtomicMemoryOrder::ACQUIRE)
+		   != U8(MaterialVariant::State::CREATED)))
+	{
+		const_cast<Material&>(*this).createVariant(key);
+	}
+
+	// Avoid writing to the shared cache line every time
+	if(ANKI_UNLIKELY(!variant.m_used.load()))
+	{
+		variant.m_used.store(1);
+	}
+
+	return variant;
+}
+
+//==============================================================================
+RenderingKey Material::getVariantKeyAsync(const RenderingKey& key) const
+{
+	const MaterialVariant& variant = m_variants[getVariantIndex(key)];
+	if(variant.m_state.load(AtomicMemoryOrder::ACQUIRE)
+		== U8(MaterialVariant::State::CREATED))
+	{
+		return key;
+	}
+
+	const_cast<Material&>(*this).queueVariant(key);
+
+	// Find a similar variant. Try the same LOD without tessellation and then
+	// the closest LODs
+	const I lod = min<U>(m_lodCount - 1, key.m_lod);
+	for(I dist = 0; dist < m_lodCount; ++dist)
+	{
+		for(I l : {lod - dist, lod + dist})
+		{
+			if(l < 0 || l >= m_lodCount)
+			{
+				continue;
+			}
+
+			RenderingKey similar(key.m_pass, l, false, key.m_instanceCount);
+			const MaterialVariant& other = m_variants[getVariantIndex(similar)];
+			if(other.m_state.load(AtomicMemoryOrder::ACQUIRE)
+				== U8(MaterialVariant::State::CREATED))
+			{
+				return similar;
+			}
+		}
+	}
+
+	return key;
 }
 
 //==============================================================================
@@ -4,6 +4,7 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/resource/MaterialLoader.h>
+#include <anki/resource/ShaderLoader.h>
 #include <anki/util/Assert.h>
 #include <anki/misc/Xml.h>
 #include <anki/util/Logger.h>
@@ -421,7 +422,7 @@ Error MaterialLoader::parseProgramTag(const XmlElement& programEl)
 		"#define INSTANCE_ID\n"
 		"#define INSTANCED\n"
 		"#endif\n",
-		glshader == ShaderType::VERTEX ? "gl_InstanceID" : "in_instanceId");
+		glshader == ShaderType::VERTEX ? "ANKI_INSTANCE_ID" : "in_instanceId");
 
 	// <includes></includes>
 	XmlElement includesEl;
@@ -893,6 +894,29 @@ Error MaterialLoader::parseOperationTag(const XmlElement& operationTag,
 	return ErrorCode::NONE;
 }
 
+//==============================================================================
+Error MaterialLoader::resolveIncludes(ResourceManager& manager)
+{
+	for(StringList& source : m_source)
+	{
+		if(source.isEmpty())
+		{
+			continue;
+		}
+
+		StringAuto tmp(m_alloc);
+		source.join(m_alloc, "\n", tmp);
+
+		ShaderLoader pars(&manager);
+		ANKI_CHECK(pars.parseSource(tmp.toCString()));
+
+		source.destroy(m_alloc);
+		source.pushBackSprintf(m_alloc, "%s", &pars.getShaderSource()[0]);
+	}
+
+	return ErrorCode::NONE;
+}
+
 //==============================================================================
 void MaterialLoader::mutate(const RenderingKey& key)
 {
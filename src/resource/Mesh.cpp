@@ -7,6 +7,7 @@
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/MeshLoader.h>
 #include <anki/resource/AsyncLoader.h>
+#include <anki/resource/GeometryPool.h>
 #include <anki/util/Functions.h>
 #include <anki/misc/Xml.h>
 
@@ -24,12 +25,15 @@ public:
 	ResourceManager* m_manager ANKI_DBG_NULLIFY_PTR;
 	BufferPtr m_vertBuff;
 	BufferPtr m_indicesBuff;
+	PtrSize m_vertBuffOffset = 0;
+	PtrSize m_indicesBuffOffset = 0;
 	MeshLoader m_loader;
 
 	MeshLoadTask(ResourceManager* manager)
 		: m_manager(manager)
 		, m_loader(manager, manager->getAsyncLoader().getAllocator())
 	{
+		m_stage = AsyncLoaderStage::UPLOAD;
 	}
 
 	Error operator()(AsyncLoaderTaskContext& ctx) final;
@@ -57,37 +61,45 @@ Error MeshLoadTask::operator()(AsyncLoaderTaskContext& ctx)
 			memcpy(
 				data, m_loader.getVertexData(), m_loader.getVertexDataSize());
 			cmdb = gr.newInstance<CommandBuffer>(CommandBufferInitInfo());
-			cmdb->uploadBuffer(m_vertBuff, 0, token);
+			cmdb->uploadBuffer(m_vertBuff, m_vertBuffOffset, token);
 			m_vertBuff.reset(nullptr);
+			ctx.m_uploadedBytes += m_loader.getVertexDataSize();
 		}
 		else
 		{
-			ctx.m_pause = true;
 			ctx.m_resubmitTask = true;
 			return ErrorCode::NONE;
 		}
 	}
 
 	// Create index buffer
+	const PtrSize indexSize = m_loader.getIndexDataSize();
+	if(ctx.m_uploadedBytes > 0
+		&& ctx.m_uploadedBytes + indexSize > ctx.m_uploadBudget)
+	{
+		// Out of budget, continue in the next frame
+		cmdb->flush();
+		ctx.m_resubmitTask = true;
+		return ErrorCode::NONE;
+	}
+
 	{
 		TransientMemoryToken token;
 		Error err = ErrorCode::NONE;
-		void* data =
-			gr.allocateFrameTransientMemory(m_loader.getIndexDataSize(),
-				BufferUsageBit::TRANSFER_SOURCE,
-				token,
-				&err);
+		void* data = gr.allocateFrameTransientMemory(
+			indexSize, BufferUsageBit::TRANSFER_SOURCE, token, &err);
 
 		if(!err)
 		{
-			memcpy(data, m_loader.getIndexData(), m_loader.getIndexDataSize());
+			memcpy(data, m_loader.getIndexData(), indexSize);
+			ctx.m_uploadedBytes += indexSize;
 
 			if(!cmdb)
 			{
 				cmdb = gr.newInstance<CommandBuffer>(CommandBufferInitInfo());
 			}
 
-			cmdb->uploadBuffer(m_indicesBuff, 0, token);
+			cmdb->uploadBuffer(m_indicesBuff, m_indicesBuffOffset, token);
 			cmdb->flush();
 		}
 		else
@@ -98,7 +110,6 @@ Error MeshLoadTask::operator()(AsyncLoaderTaskContext& ctx)
 				cmdb->flush();
 			}
 
-			ctx.m_pause = true;
 			ctx.m_resubmitTask = true;
 			return ErrorCode::NONE;
 		}
@@ -121,6 +132,13 @@ Mesh::Mesh(ResourceManager* manager)
 Mesh::~Mesh()
 {
 	m_subMeshes.destroy(getAllocator());
+
+	if(m_pooled)
+	{
+		GeometryPool& pool = getManager().getGeometryPool();
+		pool.freeVertices(m_baseVertex, m_vertexSize);
+		pool.freeIndices(m_firstIndex, sizeof(U16));
+	}
 }
 
 //==============================================================================
@@ -158,20 +176,50 @@ Error Mesh::load(const ResourceFilename& filename)
 	m_texChannelsCount = header.m_uvsChannelCount;
 	m_weights = loader.hasBoneInfo();
 
-	// Allocate the buffers
-	GrManager& gr = getManager().getGrManager();
+	// Try to put the mesh in the geometry pool. If it doesn't fit allocate
+	// some buffers
+	GeometryPool& pool = getManager().getGeometryPool();
+	m_vertexSize = vertexSize;
 
-	m_vertBuff = gr.newInstance<Buffer>(loader.getVertexDataSize(),
-		BufferUsageBit::VERTEX | BufferUsageBit::TRANSFER_DESTINATION,
-		BufferMapAccessBit::NONE);
+	if(pool.allocateVertices(
+		   loader.getVertexDataSize(), m_vertexSize, m_baseVertex))
+	{
+		if(pool.allocateIndices(
+			   loader.getIndexDataSize(), sizeof(U16), m_firstIndex))
+		{
+			m_pooled = true;
+		}
+		else
+		{
+			pool.freeVertices(m_baseVertex, m_vertexSize);
+		}
+	}
 
-	m_indicesBuff = gr.newInstance<Buffer>(loader.getIndexDataSize(),
-		BufferUsageBit::INDEX | BufferUsageBit::TRANSFER_DESTINATION,
-		BufferMapAccessBit::NONE);
+	if(m_pooled)
+	{
+		m_vertBuff = pool.getVertexBuffer();
+		m_indicesBuff = pool.getIndexBuffer();
+	}
+	else
+	{
+		GrManager& gr = getManager().getGrManager();
+
+		m_baseVertex = 0;
+		m_vertBuff = gr.newInstance<Buffer>(loader.getVertexDataSize(),
+			BufferUsageBit::VERTEX | BufferUsageBit::TRANSFER_DESTINATION,
+			BufferMapAccessBit::NONE);
+
+		m_firstIndex = 0;
+		m_indicesBuff = gr.newInstance<Buffer>(loader.getIndexDataSize(),
+			BufferUsageBit::INDEX | BufferUsageBit::TRANSFER_DESTINATION,
+			BufferMapAccessBit::NONE);
+	}
 
 	// Submit the loading task
 	task->m_indicesBuff = m_indicesBuff;
+	task->m_indicesBuffOffset = PtrSize(m_firstIndex) * sizeof(U16);
 	task->m_vertBuff = m_vertBuff;
+	task->m_vertBuffOffset = PtrSize(m_baseVertex) * m_vertexSize;
 	getManager().getAsyncLoader().submitTask(task);
 
 	return ErrorCode::NONE;
@@ -32,8 +32,8 @@ Error MeshLoader::load(const ResourceFilename& filename)
 	auto& alloc = m_alloc;
 
 	// Load header
-	ResourceFilePtr file;
-	ANKI_CHECK(m_manager->getFilesystem().openFile(filename, file));
+	ANKI_CHECK(m_manager->getFilesystem().openFile(filename, m_file));
+	ResourceFile* file = m_file.get();
 	ANKI_CHECK(file->read(&m_header, sizeof(m_header)));
 
 	//
@@ -209,8 +209,9 @@ Error MeshLoader::load(const ResourceFilename& filename)
 	//
 	// Read indices
 	//
-	m_indices.create(alloc, m_header.m_totalIndicesCount * sizeof(U16));
-	ANKI_CHECK(file->read(&m_indices[0], m_indices.getSizeInBytes()));
+	m_indexDataSize = m_header.m_totalIndicesCount * sizeof(U16);
+	ANKI_CHECK(
+		readData(m_indexDataSize, sizeof(U16), m_indices, m_indexData));
 
 	//
 	// Read vertices
@@ -221,9 +222,44 @@ Error MeshLoader::load(const ResourceFilename& filename)
 		+ 2 * sizeof(U16) // uvs
 		+ ((hasBoneInfo) ? (4 * sizeof(U8) + 4 * sizeof(U16)) : 0);
 
-	m_verts.create(alloc, m_header.m_totalVerticesCount * m_vertSize);
-	ANKI_CHECK(file->read(&m_verts[0], m_verts.getSizeInBytes()));
+	m_vertDataSize = m_header.m_totalVerticesCount * m_vertSize;
+	ANKI_CHECK(readData(m_vertDataSize, sizeof(F32), m_verts, m_vertData));
 
+	// Don't hold the file if nothing points to it
+	if(m_verts.getSize() > 0 && m_indices.getSize() > 0)
+	{
+		m_file.reset(nullptr);
+	}
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error MeshLoader::readData(PtrSize size,
+	U alignment,
+	MDynamicArray<U8>& storage,
+	const U8*& data)
+{
+	if(m_file->isMapped())
+	{
+		ANKI_CHECK(m_file->readMapped(size, data));
+
+		if(isAligned(alignment, data))
+		{
+			return ErrorCode::NONE;
+		}
+
+		// Users cast the data so copy them to aligned memory
+		storage.create(m_alloc, size);
+		memcpy(&storage[0], data, size);
+	}
+	else
+	{
+		storage.create(m_alloc, size);
+		ANKI_CHECK(m_file->read(&storage[0], size));
+	}
+
+	data = &storage[0];
 	return ErrorCode::NONE;
 }
 
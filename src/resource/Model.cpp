@@ -40,6 +40,7 @@ void ModelPatch::getRenderingDataSub(const RenderingKey& key,
 	PipelinePtr& ppline,
 	Array<U32, ANKI_GL_MAX_SUB_DRAWCALLS>& indicesCountArray,
 	Array<PtrSize, ANKI_GL_MAX_SUB_DRAWCALLS>& indicesOffsetArray,
+	U32& baseVertex,
 	U32& drawcallCount) const
 {
 	// Get the resources
@@ -54,10 +55,12 @@ void ModelPatch::getRenderingDataSub(const RenderingKey& key,
 
 	ppline = getPipeline(mtlKey);
 
+	baseVertex = mesh.getBaseVertex();
+
 	if(subMeshIndicesArray.getSize() == 0 || mesh.getSubMeshesCount() == 0)
 	{
 		drawcallCount = 1;
-		indicesOffsetArray[0] = 0;
+		indicesOffsetArray[0] = PtrSize(mesh.getFirstIndex()) * sizeof(U16);
 		indicesCountArray[0] = mesh.getIndicesCount();
 	}
 	else
@@ -66,6 +69,19 @@ void ModelPatch::getRenderingDataSub(const RenderingKey& key,
 	}
 }
 
+//==============================================================================
+void ModelPatch::getDrawcall(
+	const RenderingKey& key, DrawElementsIndirectInfo& draw) const
+{
+	const Mesh& mesh = *m_meshes[min<U>(key.m_lod, m_meshCount - 1)];
+
+	draw.m_count = mesh.getIndicesCount();
+	draw.m_instanceCount = 1;
+	draw.m_firstIndex = mesh.getFirstIndex();
+	draw.m_baseVertex = mesh.getBaseVertex();
+	draw.m_baseInstance = 0;
+}
+
 //==============================================================================
 U ModelPatch::getLodCount() const
 {
@@ -88,6 +104,7 @@ Error ModelPatch::create(WeakArray<CString> meshFNames,
 
 	// Load meshes and update resource group
 	m_meshCount = 0;
+	m_inGeometryPool = true;
 	for(U i = 0; i < meshFNames.getSize(); i++)
 	{
 		ANKI_CHECK(manager->loadResource(meshFNames[i], m_meshes[i]));
@@ -99,12 +116,22 @@ Error ModelPatch::create(WeakArray<CString> meshFNames,
 			return ErrorCode::USER_DATA;
 		}
 
-		rcinit.m_vertexBuffers[0].m_buffer = m_meshes[i]->getVertexBuffer();
-		rcinit.m_indexBuffer.m_buffer = m_meshes[i]->getIndexBuffer();
-		rcinit.m_indexSize = 2;
-
-		m_grResources[i] =
-			manager->getGrManager().newInstance<ResourceGroup>(rcinit);
+		if(m_meshes[i]->isInGeometryPool())
+		{
+			// Share the resources with the other patches of the material
+			m_grResources[i] = m_mtl->getGeometryPoolResourceGroup();
+		}
+		else
+		{
+			rcinit.m_vertexBuffers[0].m_buffer =
+				m_meshes[i]->getVertexBuffer();
+			rcinit.m_indexBuffer.m_buffer = m_meshes[i]->getIndexBuffer();
+			rcinit.m_indexSize = 2;
+
+			m_grResources[i] =
+				manager->getGrManager().newInstance<ResourceGroup>(rcinit);
+			m_inGeometryPool = false;
+		}
 
 		++m_meshCount;
 	}
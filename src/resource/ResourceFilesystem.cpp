@@ -5,12 +5,106 @@
 
 #include <anki/resource/ResourceFilesystem.h>
 #include <anki/util/Filesystem.h>
+#include <anki/util/FlatHashMap.h>
+#include <anki/util/Hash.h>
 #include <anki/misc/ConfigSet.h>
-#include <contrib/minizip/unzip.h>
+#include <zlib.h>
 
 namespace anki
 {
 
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+//==============================================================================
+template<typename T>
+static T readLittleEndian(const U8* data)
+{
+	T out = 0;
+	for(U i = 0; i < sizeof(T); ++i)
+	{
+		out |= T(data[i]) << (i * 8);
+	}
+
+	return out;
+}
+
+//==============================================================================
+/// Compute the new position of a seek for the files that know their size.
+static ANKI_USE_RESULT Error computeSeekPosition(PtrSize offset,
+	ResourceFile::SeekOrigin origin,
+	PtrSize size,
+	PtrSize& pos)
+{
+	PtrSize newPos = offset;
+	if(origin == ResourceFile::SeekOrigin::CURRENT)
+	{
+		newPos += pos;
+	}
+	else if(origin == ResourceFile::SeekOrigin::END)
+	{
+		newPos += size;
+	}
+
+	if(newPos > size)
+	{
+		ANKI_LOGE("Seeking out of the file");
+		return ErrorCode::FUNCTION_FAILED;
+	}
+
+	pos = newPos;
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+// Archive format                                                              =
+//==============================================================================
+
+/// The compression methods of the archived files.
+enum class ArchiveCompression : U16
+{
+	STORED = 0,
+	DEFLATE = 8,
+
+	/// AnKi specific. The file is split in chunks that are compressed on their
+	/// own so it can be read from any position. See ArchiveChunkedHeader.
+	CHUNKED = 0x414B
+};
+
+/// The codecs of ArchiveCompression::CHUNKED files.
+enum class ArchiveChunkCodec : U32
+{
+	NONE,
+	DEFLATE, ///< Raw deflate.
+
+	COUNT
+};
+
+/// The header of ArchiveCompression::CHUNKED files. It's followed by an array
+/// of U32 offsets of the chunks relative to the start of the header. The array
+/// has one more offset that marks the end of the last chunk. A chunk whose
+/// compressed size is equal to its uncompressed size is not compressed.
+class ArchiveChunkedHeader
+{
+public:
+	Array<U8, 8> m_magic; ///< "ANKICHK1"
+	ArchiveChunkCodec m_codec;
+	U32 m_chunkSize; ///< The uncompressed size of all chunks but the last.
+	U32 m_chunkCount;
+	U32 m_padding;
+};
+
+static_assert(sizeof(ArchiveChunkedHeader) == 24, "Check size of struct");
+
+static const U32 ARCHIVE_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const U32 ARCHIVE_LOCAL_HEADER_SIZE = 30;
+static const U32 ARCHIVE_CENTRAL_DIR_SIGNATURE = 0x02014b50;
+static const U32 ARCHIVE_CENTRAL_DIR_RECORD_SIZE = 46;
+static const U32 ARCHIVE_END_SIGNATURE = 0x06054b50;
+static const U32 ARCHIVE_END_RECORD_SIZE = 22;
+static const U16 ARCHIVE_ENCRYPTED_FLAG = 1 << 0;
+
 //==============================================================================
 // File classes                                                                =
 //==============================================================================
@@ -58,142 +152,679 @@ public:
 	}
 };
 
-/// ZIP file
-class ZipResourceFile final : public ResourceFile
+/// A file mapped to memory. It's either a loose file or an archived file
+/// stored without compression.
+class MappedResourceFile final : public ResourceFile
 {
 public:
-	unzFile m_archive = nullptr;
+	const U8* m_data = nullptr;
 	PtrSize m_size = 0;
+	PtrSize m_pos = 0;
+	Bool8 m_ownsMapping = false; ///< If false it points to a mapped archive.
 
-	ZipResourceFile(GenericMemoryPoolAllocator<U8> alloc)
+	MappedResourceFile(GenericMemoryPoolAllocator<U8> alloc)
 		: ResourceFile(alloc)
 	{
 	}
 
-	~ZipResourceFile()
+	~MappedResourceFile()
 	{
-		if(m_archive)
+		if(m_data && m_ownsMapping)
 		{
-			// It's open
-			unzClose(m_archive);
-			m_archive = nullptr;
-			m_size = 0;
+			unmapFile(m_data, m_size);
 		}
 	}
 
-	ANKI_USE_RESULT Error open(
-		const CString& archive, const CString& archivedFname)
+	ANKI_USE_RESULT Error read(void* buff, PtrSize size) override
 	{
-		// Open archive
-		m_archive = unzOpen(&archive[0]);
-		if(m_archive == nullptr)
-		{
-			ANKI_LOGE("Failed to open archive");
-			return ErrorCode::FILE_ACCESS;
-		}
+		const U8* data;
+		ANKI_CHECK(readMapped(size, data));
+		memcpy(buff, data, size);
+		return ErrorCode::NONE;
+	}
 
-		// Locate archived
-		const int caseSensitive = 1;
-		if(unzLocateFile(m_archive, &archivedFname[0], caseSensitive) != UNZ_OK)
+	ANKI_USE_RESULT Error readAllText(
+		GenericMemoryPoolAllocator<U8> alloc, String& out) override
+	{
+		// Behave like File::readAllText
+		const PtrSize size = m_size - m_pos;
+		if(size == 0)
 		{
-			ANKI_LOGE("Failed to locate file in archive");
-			return ErrorCode::FILE_ACCESS;
+			return ErrorCode::FUNCTION_FAILED;
 		}
 
-		// Open file
-		if(unzOpenCurrentFile(m_archive) != UNZ_OK)
+		out.create(alloc, '?', size);
+		return read(&out[0], size);
+	}
+
+	ANKI_USE_RESULT Error readU32(U32& u) override
+	{
+		// Assume machine and file have same endianness
+		return read(&u, sizeof(u));
+	}
+
+	ANKI_USE_RESULT Error readF32(F32& u) override
+	{
+		// Assume machine and file have same endianness
+		return read(&u, sizeof(u));
+	}
+
+	ANKI_USE_RESULT Error seek(PtrSize offset, SeekOrigin origin) override
+	{
+		return computeSeekPosition(offset, origin, m_size, m_pos);
+	}
+
+	PtrSize getSize() const override
+	{
+		return m_size;
+	}
+
+	Bool isMapped() const override
+	{
+		return true;
+	}
+
+	ANKI_USE_RESULT Error readMapped(PtrSize size, const U8*& data) override
+	{
+		if(size > m_size - m_pos)
 		{
-			ANKI_LOGE("unzOpenCurrentFile() failed");
+			ANKI_LOGE("File read failed");
 			return ErrorCode::FILE_ACCESS;
 		}
 
-		// Get size just in case
-		unz_file_info zinfo;
-		zinfo.uncompressed_size = 0;
-		unzGetCurrentFileInfo(
-			m_archive, &zinfo, nullptr, 0, nullptr, 0, nullptr, 0);
-		m_size = zinfo.uncompressed_size;
-		ANKI_ASSERT(m_size != 0);
-
+		data = m_data + m_pos;
+		m_pos += size;
 		return ErrorCode::NONE;
 	}
+};
 
-	void close()
+/// An archived file compressed with deflate. It's decompressed from the mapped
+/// archive while reading. Seeking backwards restarts the decompression.
+class InflateResourceFile final : public ResourceFile
+{
+public:
+	const U8* m_compressedData = nullptr;
+	PtrSize m_compressedSize = 0;
+	PtrSize m_size = 0;
+	PtrSize m_pos = 0;
+	z_stream m_stream;
+	Bool8 m_streamInitialized = false;
+
+	InflateResourceFile(GenericMemoryPoolAllocator<U8> alloc)
+		: ResourceFile(alloc)
 	{
-		if(m_archive)
+		memset(&m_stream, 0, sizeof(m_stream));
+	}
+
+	~InflateResourceFile()
+	{
+		if(m_streamInitialized)
 		{
-			unzClose(m_archive);
-			m_archive = nullptr;
-			m_size = 0;
+			inflateEnd(&m_stream);
 		}
 	}
 
-	ANKI_USE_RESULT Error read(void* buff, PtrSize size) override
+	ANKI_USE_RESULT Error init(
+		const U8* compressedData, PtrSize compressedSize, PtrSize size)
 	{
-		I64 readSize = unzReadCurrentFile(m_archive, buff, size);
+		m_compressedData = compressedData;
+		m_compressedSize = compressedSize;
+		m_size = size;
 
-		if(I64(size) != readSize)
+		// The archived files don't have a zlib header
+		if(inflateInit2(&m_stream, -MAX_WBITS) != Z_OK)
+		{
+			ANKI_LOGE("inflateInit2() failed");
+			return ErrorCode::FUNCTION_FAILED;
+		}
+
+		m_streamInitialized = true;
+		rewind();
+		return ErrorCode::NONE;
+	}
+
+	ANKI_USE_RESULT Error read(void* buff, PtrSize size) override
+	{
+		if(size > m_size - m_pos)
 		{
 			ANKI_LOGE("File read failed");
 			return ErrorCode::FILE_ACCESS;
 		}
 
+		m_stream.next_out = static_cast<Bytef*>(buff);
+		m_stream.avail_out = size;
+		while(m_stream.avail_out > 0)
+		{
+			int ret = inflate(&m_stream, Z_NO_FLUSH);
+			if(ret != Z_OK && ret != Z_STREAM_END)
+			{
+				ANKI_LOGE("inflate() failed");
+				return ErrorCode::FILE_ACCESS;
+			}
+
+			if(ret == Z_STREAM_END && m_stream.avail_out > 0)
+			{
+				ANKI_LOGE("Compressed file is smaller than expected");
+				return ErrorCode::FILE_ACCESS;
+			}
+		}
+
+		m_pos += size;
 		return ErrorCode::NONE;
 	}
 
 	ANKI_USE_RESULT Error readAllText(
 		GenericMemoryPoolAllocator<U8> alloc, String& out) override
 	{
-		ANKI_ASSERT(m_size);
-		out.create(alloc, '?', m_size);
-		return read(&out[0], m_size);
+		// Behave like File::readAllText
+		const PtrSize size = m_size - m_pos;
+		if(size == 0)
+		{
+			return ErrorCode::FUNCTION_FAILED;
+		}
+
+		out.create(alloc, '?', size);
+		return read(&out[0], size);
 	}
 
 	ANKI_USE_RESULT Error readU32(U32& u) override
 	{
 		// Assume machine and file have same endianness
-		ANKI_CHECK(read(&u, sizeof(u)));
-		return ErrorCode::NONE;
+		return read(&u, sizeof(u));
 	}
 
 	ANKI_USE_RESULT Error readF32(F32& u) override
 	{
 		// Assume machine and file have same endianness
-		ANKI_CHECK(read(&u, sizeof(u)));
-		return ErrorCode::NONE;
+		return read(&u, sizeof(u));
 	}
 
 	ANKI_USE_RESULT Error seek(PtrSize offset, SeekOrigin origin) override
 	{
-		// Rewind if needed
-		if(origin == SeekOrigin::BEGINNING)
+		PtrSize pos = m_pos;
+		ANKI_CHECK(computeSeekPosition(offset, origin, m_size, pos));
+
+		if(pos < m_pos)
+		{
+			rewind();
+		}
+
+		// Move forward by decompressing dummy data
+		Array<U8, 512> buff;
+		while(m_pos < pos)
 		{
-			if(unzCloseCurrentFile(m_archive) || unzOpenCurrentFile(m_archive))
+			ANKI_CHECK(read(&buff[0], min(pos - m_pos, sizeof(buff))));
+		}
+
+		return ErrorCode::NONE;
+	}
+
+	PtrSize getSize() const override
+	{
+		return m_size;
+	}
+
+private:
+	void rewind()
+	{
+		inflateReset(&m_stream);
+		m_stream.next_in = const_cast<Bytef*>(m_compressedData);
+		m_stream.avail_in = m_compressedSize;
+		m_pos = 0;
+	}
+};
+
+/// An archived file of the ArchiveCompression::CHUNKED method. Only the chunk
+/// that is read gets decompressed so seeking doesn't decompress anything.
+class ChunkedResourceFile final : public ResourceFile
+{
+public:
+	const U8* m_data = nullptr; ///< Points to the header in the archive.
+	PtrSize m_compressedSize = 0;
+	PtrSize m_size = 0;
+	PtrSize m_pos = 0;
+	ArchiveChunkedHeader m_header;
+	DynamicArray<U8> m_chunk; ///< The last decompressed chunk.
+	U32 m_chunkIdx = MAX_U32;
+	z_stream m_stream;
+	Bool8 m_streamInitialized = false;
+
+	ChunkedResourceFile(GenericMemoryPoolAllocator<U8> alloc)
+		: ResourceFile(alloc)
+	{
+		memset(&m_stream, 0, sizeof(m_stream));
+	}
+
+	~ChunkedResourceFile()
+	{
+		m_chunk.destroy(getAllocator());
+
+		if(m_streamInitialized)
+		{
+			inflateEnd(&m_stream);
+		}
+	}
+
+	ANKI_USE_RESULT Error init(
+		const U8* data, PtrSize compressedSize, PtrSize size)
+	{
+		m_data = data;
+		m_compressedSize = compressedSize;
+		m_size = size;
+
+		if(compressedSize < sizeof(m_header))
+		{
+			ANKI_LOGE("Chunked file is too small");
+			return ErrorCode::USER_DATA;
+		}
+
+		// The header is not aligned in the archive
+		memcpy(&m_header, data, sizeof(m_header));
+
+		if(memcmp(&m_header.m_magic[0], "ANKICHK1", 8) != 0
+			|| m_header.m_codec >= ArchiveChunkCodec::COUNT
+			|| m_header.m_chunkSize == 0
+			|| m_header.m_chunkCount
+				!= (size + m_header.m_chunkSize - 1) / m_header.m_chunkSize
+			|| sizeof(m_header) + (m_header.m_chunkCount + 1) * sizeof(U32)
+				> compressedSize)
+		{
+			ANKI_LOGE("Incorrect or unsupported chunked file header");
+			return ErrorCode::USER_DATA;
+		}
+
+		if(m_header.m_codec == ArchiveChunkCodec::DEFLATE)
+		{
+			if(inflateInit2(&m_stream, -MAX_WBITS) != Z_OK)
 			{
-				ANKI_LOGE("Rewind failed");
+				ANKI_LOGE("inflateInit2() failed");
 				return ErrorCode::FUNCTION_FAILED;
 			}
+
+			m_streamInitialized = true;
 		}
 
-		// Move forward by reading dummy data
-		Array<char, 128> buff;
-		while(offset != 0)
+		m_chunk.create(
+			getAllocator(), min<PtrSize>(m_header.m_chunkSize, size));
+		return ErrorCode::NONE;
+	}
+
+	ANKI_USE_RESULT Error read(void* buff, PtrSize size) override
+	{
+		if(size > m_size - m_pos)
 		{
-			PtrSize toRead = min(offset, sizeof(buff));
-			ANKI_CHECK(read(&buff[0], toRead));
-			offset -= toRead;
+			ANKI_LOGE("File read failed");
+			return ErrorCode::FILE_ACCESS;
+		}
+
+		U8* out = static_cast<U8*>(buff);
+		while(size > 0)
+		{
+			const U32 idx = m_pos / m_header.m_chunkSize;
+			ANKI_CHECK(loadChunk(idx));
+
+			const PtrSize offset = m_pos - PtrSize(idx) * m_header.m_chunkSize;
+			const PtrSize toCopy = min(size, m_header.m_chunkSize - offset);
+			memcpy(out, &m_chunk[offset], toCopy);
+
+			out += toCopy;
+			size -= toCopy;
+			m_pos += toCopy;
 		}
 
 		return ErrorCode::NONE;
 	}
 
+	ANKI_USE_RESULT Error readAllText(
+		GenericMemoryPoolAllocator<U8> alloc, String& out) override
+	{
+		// Behave like File::readAllText
+		const PtrSize size = m_size - m_pos;
+		if(size == 0)
+		{
+			return ErrorCode::FUNCTION_FAILED;
+		}
+
+		out.create(alloc, '?', size);
+		return read(&out[0], size);
+	}
+
+	ANKI_USE_RESULT Error readU32(U32& u) override
+	{
+		// Assume machine and file have same endianness
+		return read(&u, sizeof(u));
+	}
+
+	ANKI_USE_RESULT Error readF32(F32& u) override
+	{
+		// Assume machine and file have same endianness
+		return read(&u, sizeof(u));
+	}
+
+	ANKI_USE_RESULT Error seek(PtrSize offset, SeekOrigin origin) override
+	{
+		return computeSeekPosition(offset, origin, m_size, m_pos);
+	}
+
 	PtrSize getSize() const override
 	{
-		ANKI_ASSERT(m_size > 0);
 		return m_size;
 	}
+
+private:
+	PtrSize getChunkOffset(U32 idx) const
+	{
+		return readLittleEndian<U32>(
+			m_data + sizeof(m_header) + idx * sizeof(U32));
+	}
+
+	ANKI_USE_RESULT Error loadChunk(U32 idx)
+	{
+		if(idx == m_chunkIdx)
+		{
+			return ErrorCode::NONE;
+		}
+
+		ANKI_ASSERT(idx < m_header.m_chunkCount);
+		const PtrSize begin = getChunkOffset(idx);
+		const PtrSize end = getChunkOffset(idx + 1);
+		const PtrSize size = min<PtrSize>(m_header.m_chunkSize,
+			m_size - PtrSize(idx) * m_header.m_chunkSize);
+
+		if(begin > end || end > m_compressedSize)
+		{
+			ANKI_LOGE("Incorrect chunk offsets");
+			return ErrorCode::USER_DATA;
+		}
+
+		if(end - begin == size)
+		{
+			// Not compressed
+			memcpy(&m_chunk[0], m_data + begin, size);
+		}
+		else if(m_header.m_codec == ArchiveChunkCodec::DEFLATE)
+		{
+			inflateReset(&m_stream);
+			m_stream.next_in = const_cast<Bytef*>(m_data + begin);
+			m_stream.avail_in = end - begin;
+			m_stream.next_out = &m_chunk[0];
+			m_stream.avail_out = size;
+
+			if(inflate(&m_stream, Z_FINISH) != Z_STREAM_END
+				|| m_stream.avail_out != 0)
+			{
+				ANKI_LOGE("Chunk decompression failed");
+				return ErrorCode::FILE_ACCESS;
+			}
+		}
+		else
+		{
+			ANKI_LOGE("Incorrect chunk size");
+			return ErrorCode::USER_DATA;
+		}
+
+		m_chunkIdx = idx;
+		return ErrorCode::NONE;
+	}
 };
 
+//==============================================================================
+// ResourceArchive                                                             =
+//==============================================================================
+
+/// A mapped archive. The central directory is parsed once into an index so the
+/// files are found without walking the archive. The archive is never modified
+/// so any number of threads can open and decompress its files at the same
+/// time.
+class ResourceArchive : public NonCopyable
+{
+public:
+	ResourceArchive(GenericMemoryPoolAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	~ResourceArchive()
+	{
+		m_index.destroy(m_alloc);
+
+		if(m_data)
+		{
+			unmapFile(m_data, m_size);
+		}
+	}
+
+	/// Map the archive and index its files.
+	ANKI_USE_RESULT Error init(const CString& filename);
+
+	/// Open an archived file. If the file is not in the archive @a rfile will
+	/// be nullptr.
+	ANKI_USE_RESULT Error openFile(
+		const CString& filename, ResourceFile*& rfile);
+
+private:
+	class Entry
+	{
+	public:
+		const char* m_name; ///< Points to the central directory.
+		U16 m_nameLength;
+		ArchiveCompression m_compression;
+		PtrSize m_localHeaderOffset;
+		PtrSize m_compressedSize;
+		PtrSize m_size;
+	};
+
+	class Hasher
+	{
+	public:
+		U64 operator()(const U64& b) const
+		{
+			return b;
+		}
+	};
+
+	class Compare
+	{
+	public:
+		Bool operator()(const U64& a, const U64& b) const
+		{
+			return a == b;
+		}
+	};
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	const U8* m_data = nullptr;
+	PtrSize m_size = 0;
+
+	/// The key is the hash of the filename.
+	FlatHashMap<U64, Entry, Hasher, Compare> m_index;
+};
+
+//==============================================================================
+Error ResourceArchive::init(const CString& filename)
+{
+	ANKI_CHECK(mapFile(filename, m_data, m_size));
+
+	// Find the end of central directory record. It's at the end of the file
+	// followed by a comment of up to 64K
+	if(m_size < ARCHIVE_END_RECORD_SIZE)
+	{
+		ANKI_LOGE("Archive is too small: %s", &filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	PtrSize end = m_size - ARCHIVE_END_RECORD_SIZE;
+	const PtrSize minEnd = (end > MAX_U16) ? end - MAX_U16 : 0;
+	while(readLittleEndian<U32>(m_data + end) != ARCHIVE_END_SIGNATURE)
+	{
+		if(end == minEnd)
+		{
+			ANKI_LOGE("Not an archive: %s", &filename[0]);
+			return ErrorCode::USER_DATA;
+		}
+
+		--end;
+	}
+
+	const U16 entryCount = readLittleEndian<U16>(m_data + end + 10);
+	const PtrSize dirSize = readLittleEndian<U32>(m_data + end + 12);
+	const PtrSize dirOffset = readLittleEndian<U32>(m_data + end + 16);
+	if(entryCount == MAX_U16 || dirOffset == MAX_U32
+		|| dirOffset + dirSize > end)
+	{
+		ANKI_LOGE("Corrupted or ZIP64 archive: %s", &filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	// Index the files
+	m_index.reserve(m_alloc, entryCount);
+
+	const PtrSize dirEnd = dirOffset + dirSize;
+	PtrSize offset = dirOffset;
+	for(U i = 0; i < entryCount; ++i)
+	{
+		const U8* record = m_data + offset;
+		if(offset + ARCHIVE_CENTRAL_DIR_RECORD_SIZE > dirEnd
+			|| readLittleEndian<U32>(record) != ARCHIVE_CENTRAL_DIR_SIGNATURE)
+		{
+			ANKI_LOGE("Corrupted central directory: %s", &filename[0]);
+			return ErrorCode::USER_DATA;
+		}
+
+		Entry e;
+		const U16 flags = readLittleEndian<U16>(record + 8);
+		e.m_compression =
+			ArchiveCompression(readLittleEndian<U16>(record + 10));
+		e.m_compressedSize = readLittleEndian<U32>(record + 20);
+		e.m_size = readLittleEndian<U32>(record + 24);
+		e.m_nameLength = readLittleEndian<U16>(record + 28);
+		e.m_localHeaderOffset = readLittleEndian<U32>(record + 42);
+		e.m_name = reinterpret_cast<const char*>(
+			record + ARCHIVE_CENTRAL_DIR_RECORD_SIZE);
+
+		offset += ARCHIVE_CENTRAL_DIR_RECORD_SIZE + e.m_nameLength
+			+ readLittleEndian<U16>(record + 30)
+			+ readLittleEndian<U16>(record + 32);
+		if(offset > dirEnd)
+		{
+			ANKI_LOGE("Corrupted central directory: %s", &filename[0]);
+			return ErrorCode::USER_DATA;
+		}
+
+		// If uncompressed size is zero then it's a dir
+		if(e.m_size == 0)
+		{
+			continue;
+		}
+
+		if(flags & ARCHIVE_ENCRYPTED_FLAG)
+		{
+			ANKI_LOGE("Encrypted files are not supported: %s", &filename[0]);
+			return ErrorCode::USER_DATA;
+		}
+
+		const U64 hash = computeHash(e.m_name, e.m_nameLength);
+		if(m_index.find(hash) != m_index.getEnd())
+		{
+			ANKI_LOGE("Duplicate filename or hash collision: %.*s",
+				I(e.m_nameLength),
+				e.m_name);
+			return ErrorCode::USER_DATA;
+		}
+
+		m_index.emplaceBack(m_alloc, hash, e);
+	}
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error ResourceArchive::openFile(
+	const CString& filename, ResourceFile*& rfile)
+{
+	rfile = nullptr;
+
+	auto it = m_index.find(computeHash(&filename[0], filename.getLength()));
+	if(it == m_index.getEnd())
+	{
+		return ErrorCode::NONE;
+	}
+
+	const Entry& e = *it;
+	if(e.m_nameLength != filename.getLength()
+		|| memcmp(e.m_name, &filename[0], e.m_nameLength) != 0)
+	{
+		// A hash collision with a file that is not in the archive
+		return ErrorCode::NONE;
+	}
+
+	// The local header may have a different extra field than the central
+	// directory record
+	const U8* header = m_data + e.m_localHeaderOffset;
+	if(e.m_localHeaderOffset + ARCHIVE_LOCAL_HEADER_SIZE > m_size
+		|| readLittleEndian<U32>(header) != ARCHIVE_LOCAL_HEADER_SIGNATURE)
+	{
+		ANKI_LOGE("Corrupted local header: %s", &filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	const PtrSize dataOffset = e.m_localHeaderOffset + ARCHIVE_LOCAL_HEADER_SIZE
+		+ readLittleEndian<U16>(header + 26)
+		+ readLittleEndian<U16>(header + 28);
+	if(dataOffset + e.m_compressedSize > m_size)
+	{
+		ANKI_LOGE("Corrupted archived file: %s", &filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	const U8* data = m_data + dataOffset;
+	switch(e.m_compression)
+	{
+	case ArchiveCompression::STORED:
+	{
+		if(e.m_compressedSize != e.m_size)
+		{
+			ANKI_LOGE("Corrupted archived file: %s", &filename[0]);
+			return ErrorCode::USER_DATA;
+		}
+
+		// Point to the mapped archive
+		MappedResourceFile* file =
+			m_alloc.newInstance<MappedResourceFile>(m_alloc);
+		rfile = file;
+
+		file->m_data = data;
+		file->m_size = e.m_size;
+		break;
+	}
+	case ArchiveCompression::DEFLATE:
+	{
+		InflateResourceFile* file =
+			m_alloc.newInstance<InflateResourceFile>(m_alloc);
+		rfile = file;
+
+		ANKI_CHECK(file->init(data, e.m_compressedSize, e.m_size));
+		break;
+	}
+	case ArchiveCompression::CHUNKED:
+	{
+		ChunkedResourceFile* file =
+			m_alloc.newInstance<ChunkedResourceFile>(m_alloc);
+		rfile = file;
+
+		ANKI_CHECK(file->init(data, e.m_compressedSize, e.m_size));
+		break;
+	}
+	default:
+		ANKI_LOGE("Unsupported compression method %u: %s",
+			U(e.m_compression),
+			&filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	return ErrorCode::NONE;
+}
+
 //==============================================================================
 // ResourceFilesystem                                                          =
 //==============================================================================
@@ -205,6 +836,7 @@ ResourceFilesystem::~ResourceFilesystem()
 	{
 		p.m_files.destroy(m_alloc);
 		p.m_path.destroy(m_alloc);
+		m_alloc.deleteInstance(p.m_archive);
 	}
 
 	m_paths.destroy(m_alloc);
@@ -253,56 +885,12 @@ Error ResourceFilesystem::addNewPath(const CString& path)
 	if(pos != CString::NPOS && pos == path.getLength() - extension.getLength())
 	{
 		// It's an archive
-
-		// Open
-		unzFile zfile = unzOpen(&path[0]);
-		if(!zfile)
-		{
-			ANKI_LOGE("Failed to open archive");
-			return ErrorCode::FILE_ACCESS;
-		}
-
-		// List files
-		if(unzGoToFirstFile(zfile) != UNZ_OK)
-		{
-			unzClose(zfile);
-			ANKI_LOGE("unzGoToFirstFile() failed. Empty archive?");
-			return ErrorCode::FILE_ACCESS;
-		}
-
 		Path p;
-		p.m_isArchive = true;
 		p.m_path.sprintf(m_alloc, "%s", &path[0]);
-
-		do
-		{
-			Array<char, 1024> filename;
-
-			unz_file_info info;
-			if(unzGetCurrentFileInfo(zfile,
-				   &info,
-				   &filename[0],
-				   filename.getSize(),
-				   nullptr,
-				   0,
-				   nullptr,
-				   0)
-				!= UNZ_OK)
-			{
-				unzClose(zfile);
-				ANKI_LOGE("unzGetCurrentFileInfo() failed");
-				return ErrorCode::FILE_ACCESS;
-			}
-
-			// If compressed size is zero then it's a dir
-			if(info.uncompressed_size > 0)
-			{
-				p.m_files.pushBackSprintf(m_alloc, "%s", &filename[0]);
-			}
-		} while(unzGoToNextFile(zfile) == UNZ_OK);
+		p.m_archive = m_alloc.newInstance<ResourceArchive>(m_alloc);
 
 		m_paths.emplaceFront(m_alloc, std::move(p));
-		unzClose(zfile);
+		ANKI_CHECK(m_paths.getFront().m_archive->init(path));
 	}
 	else
 	{
@@ -311,7 +899,6 @@ Error ResourceFilesystem::addNewPath(const CString& path)
 		m_paths.emplaceFront(m_alloc, Path());
 		Path& p = m_paths.getFront();
 		p.m_path.sprintf(m_alloc, "%s", &path[0]);
-		p.m_isArchive = false;
 
 		ANKI_CHECK(walkDirectoryTree(path,
 			this,
@@ -342,68 +929,133 @@ Error ResourceFilesystem::addNewPath(const CString& path)
 Error ResourceFilesystem::openFile(
 	const ResourceFilename& filename, ResourceFilePtr& filePtr)
 {
+	ANKI_CHECK(openFileOptional(filename, filePtr));
+
+	if(!filePtr.isCreated())
+	{
+		ANKI_LOGE("File not found: %s", &filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error ResourceFilesystem::openFileOptional(
+	const ResourceFilename& filename, ResourceFilePtr& filePtr)
+{
+	return openFilesOptional(&filename, &filePtr, 1);
+}
+
+//==============================================================================
+Error ResourceFilesystem::openFileAndSibling(const ResourceFilename& filename,
+	const CString& siblingSuffix,
+	ResourceFilePtr& file,
+	ResourceFilePtr& sibling)
+{
+	StringAuto siblingFname(m_alloc);
+	siblingFname.sprintf("%s%s", &filename[0], &siblingSuffix[0]);
+
+	Array<CString, 2> filenames = {{filename, siblingFname.toCString()}};
+	Array<ResourceFilePtr, 2> files;
+	ANKI_CHECK(openFilesOptional(&filenames[0], &files[0], 2));
+
+	if(!files[0].isCreated())
+	{
+		ANKI_LOGE("File not found: %s", &filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	file = files[0];
+	sibling = files[1];
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error ResourceFilesystem::openFilesOptional(
+	const CString* filenames, ResourceFilePtr* filePtrs, U count)
+{
+	ANKI_ASSERT(count > 0 && count <= 32);
+	const U32 allFoundMask = MAX_U32 >> (32 - count);
+	U32 foundMask = 0;
 	ResourceFile* rfile = nullptr;
 	Error err = ErrorCode::NONE;
 
-	// Search for the fname in reverse order
+	// Search for the fnames in reverse order
 	for(const Path& p : m_paths)
 	{
-		// Check if it's cache
-		if(p.m_isCache)
+		if(p.m_isCache || p.m_archive)
 		{
-			StringAuto newFname(m_alloc);
-			newFname.sprintf("%s/%s", &p.m_path[0], &filename[0]);
-
-			if(fileExists(newFname.toCString()))
+			for(U i = 0; i < count && !err; ++i)
 			{
-				// In cache
+				if(foundMask & (1u << i))
+				{
+					continue;
+				}
 
-				CResourceFile* file =
-					m_alloc.newInstance<CResourceFile>(m_alloc);
-				rfile = file;
+				if(p.m_archive)
+				{
+					// In archive
+					err = p.m_archive->openFile(filenames[i], rfile);
+				}
+				else
+				{
+					// Check if it's in cache
+					StringAuto newFname(m_alloc);
+					newFname.sprintf("%s/%s", &p.m_path[0], &filenames[i][0]);
+
+					if(fileExists(newFname.toCString()))
+					{
+						err = openLooseFile(newFname.toCString(), rfile);
+					}
+				}
 
-				err = file->m_file.open(&newFname[0], File::OpenFlag::READ);
+				if(rfile && !err)
+				{
+					filePtrs[i].reset(rfile);
+					rfile = nullptr;
+					foundMask |= 1u << i;
+				}
 			}
 		}
 		else
 		{
-			// In data path or archive
-
+			// In data path. Look for all the files in one pass
 			for(const String& pfname : p.m_files)
 			{
-				if(pfname != filename)
-				{
-					continue;
-				}
-
-				// Found
-				if(p.m_isArchive)
+				for(U i = 0; i < count && !err; ++i)
 				{
-					ZipResourceFile* file =
-						m_alloc.newInstance<ZipResourceFile>(m_alloc);
-					rfile = file;
+					if((foundMask & (1u << i)) || pfname != filenames[i])
+					{
+						continue;
+					}
 
-					err = file->open(p.m_path.toCString(), filename);
-				}
-				else
-				{
+					// Found
 					StringAuto newFname(m_alloc);
-					newFname.sprintf("%s/%s", &p.m_path[0], &filename[0]);
+					newFname.sprintf("%s/%s", &p.m_path[0], &filenames[i][0]);
 
-					CResourceFile* file =
-						m_alloc.newInstance<CResourceFile>(m_alloc);
-					rfile = file;
-
-					err = file->m_file.open(&newFname[0], File::OpenFlag::READ);
+					err = openLooseFile(newFname.toCString(), rfile);
 
 #if 0
 					printf("Opening asset %s\n", &newFname[0]);
 #endif
+
+					if(!err)
+					{
+						filePtrs[i].reset(rfile);
+						rfile = nullptr;
+						foundMask |= 1u << i;
+					}
+				}
+
+				if(foundMask == allFoundMask || err)
+				{
+					break;
 				}
 			}
 		} // end if cache
 
-		if(rfile)
+		if(foundMask == allFoundMask || err)
 		{
 			break;
 		}
@@ -415,14 +1067,30 @@ Error ResourceFilesystem::openFile(
 		return err;
 	}
 
-	if(!rfile)
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+Error ResourceFilesystem::openLooseFile(
+	const CString& filename, ResourceFile*& rfile)
+{
+#if ANKI_OS == ANKI_OS_ANDROID
+	// The files of the APK can't be mapped
+	if(filename[0] == '$')
 	{
-		ANKI_LOGE("File not found: %s", &filename[0]);
-		return ErrorCode::USER_DATA;
+		CResourceFile* file = m_alloc.newInstance<CResourceFile>(m_alloc);
+		rfile = file;
+		return file->m_file.open(filename, File::OpenFlag::READ);
 	}
+#endif
+
+	// Empty files are not mapped. They become empty in-memory files
+	MappedResourceFile* file = m_alloc.newInstance<MappedResourceFile>(m_alloc);
+	rfile = file;
+
+	ANKI_CHECK(mapFile(filename, file->m_data, file->m_size));
+	file->m_ownsMapping = true;
 
-	// Done
-	filePtr.reset(rfile);
 	return ErrorCode::NONE;
 }
 
@@ -5,6 +5,7 @@
 
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/AsyncLoader.h>
+#include <anki/resource/GeometryPool.h>
 #include <anki/resource/Animation.h>
 #include <anki/resource/Material.h>
 #include <anki/resource/Mesh.h>
@@ -21,17 +22,50 @@
 namespace anki
 {
 
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+static const PtrSize TEMP_ALLOCATOR_SIZE = 10 * 1024 * 1024;
+
+/// The temp allocator of a thread.
+class ThreadTempAllocator
+{
+public:
+	U64 m_managerId = 0;
+	TempResourceAllocator<U8>* m_alloc = nullptr;
+};
+
+static thread_local ThreadTempAllocator g_threadTmpAlloc;
+
+static Atomic<U64> g_managerCount = {0};
+
+//==============================================================================
+// ResourceManager                                                             =
+//==============================================================================
+
 //==============================================================================
 ResourceManager::ResourceManager()
+	: m_id(g_managerCount.fetchAdd(1) + 1)
 {
 }
 
 //==============================================================================
 ResourceManager::~ResourceManager()
 {
+	// Delete it first because the pending tasks may hold resources
+	m_alloc.deleteInstance(m_asyncLoader);
 	m_cacheDir.destroy(m_alloc);
 	m_shadersPrependedSource.destroy(m_alloc);
-	m_alloc.deleteInstance(m_asyncLoader);
+	m_alloc.deleteInstance(m_geometryPool);
+
+	// Delete them last because the async tasks might use them
+	for(TempResourceAllocator<U8>* alloc : m_tmpAllocs)
+	{
+		m_alloc.deleteInstance(alloc);
+	}
+
+	m_tmpAllocs.destroy(m_alloc);
 }
 
 //==============================================================================
@@ -42,9 +76,8 @@ Error ResourceManager::create(ResourceManagerInitInfo& init)
 	m_fs = init.m_resourceFs;
 	m_alloc =
 		ResourceAllocator<U8>(init.m_allocCallback, init.m_allocCallbackData);
-
-	m_tmpAlloc = TempResourceAllocator<U8>(
-		init.m_allocCallback, init.m_allocCallbackData, 10 * 1024 * 1024);
+	m_allocCallback = init.m_allocCallback;
+	m_allocCallbackData = init.m_allocCallbackData;
 
 	m_cacheDir.create(m_alloc, init.m_cacheDir);
 
@@ -74,11 +107,44 @@ Error ResourceManager::create(ResourceManagerInitInfo& init)
 
 	// Init the thread
 	m_asyncLoader = m_alloc.newInstance<AsyncLoader>();
-	m_asyncLoader->init(m_alloc);
+	m_asyncLoader->init(m_alloc,
+		init.m_config->getNumber("asyncLoaderThreadCount"),
+		init.m_config->getNumber("asyncLoaderUploadBudgetPerFrame"));
+
+	// Init the geometry pool
+	m_geometryPool = m_alloc.newInstance<GeometryPool>();
+	if(m_gr)
+	{
+		m_geometryPool->init(m_gr,
+			m_alloc,
+			init.m_config->getNumber("geometryPoolVertexMemorySize"),
+			init.m_config->getNumber("geometryPoolIndexMemorySize"));
+	}
 
 	return ErrorCode::NONE;
 }
 
+//==============================================================================
+TempResourceAllocator<U8>& ResourceManager::getTempAllocator()
+{
+	ThreadTempAllocator& tls = g_threadTmpAlloc;
+
+	if(ANKI_UNLIKELY(tls.m_managerId != m_id))
+	{
+		// First time this thread asks, create one
+		LockGuard<Mutex> lock(m_tmpAllocsMtx);
+
+		tls.m_alloc = m_alloc.newInstance<TempResourceAllocator<U8>>(
+			m_allocCallback, m_allocCallbackData, TEMP_ALLOCATOR_SIZE);
+		tls.m_managerId = m_id;
+
+		m_tmpAllocs.resize(m_alloc, m_tmpAllocs.getSize() + 1);
+		m_tmpAllocs.getBack() = tls.m_alloc;
+	}
+
+	return *tls.m_alloc;
+}
+
 //==============================================================================
 U64 ResourceManager::getAsyncTaskCompletedCount() const
 {
@@ -60,8 +60,44 @@ Error ResourceObject::openFileReadAllText(
 Error ResourceObject::openFileParseXml(
 	const CString& filename, XmlDocument& xml)
 {
+	// Open the XML and the baked document if there is one
+	ResourceFilePtr file;
+	ResourceFilePtr bakedFile;
+	ANKI_CHECK(m_manager->getFilesystem().openFileAndSibling(filename,
+		XmlDocument::BAKED_FILENAME_SUFFIX,
+		file,
+		bakedFile));
+
 	StringAuto txt(getTempAllocator());
-	ANKI_CHECK(openFileReadAllText(filename, txt));
+	ANKI_CHECK(file->readAllText(getTempAllocator(), txt));
+
+	// Prefer the baked document if it was baked from this XML
+	if(bakedFile.isCreated())
+	{
+		PtrSize size = bakedFile->getSize();
+		DynamicArrayAuto<U8> storage(getTempAllocator());
+		const U8* data = nullptr;
+
+		if(bakedFile->isMapped())
+		{
+			ANKI_CHECK(bakedFile->readMapped(size, data));
+		}
+		else if(size > 0)
+		{
+			storage.create(size);
+			ANKI_CHECK(bakedFile->read(&storage[0], size));
+			data = &storage[0];
+		}
+
+		if(XmlDocument::isBakedFromText(data, size, txt.toCString()))
+		{
+			ANKI_CHECK(xml.parseBaked(data, size, getTempAllocator()));
+			return ErrorCode::NONE;
+		}
+
+		ANKI_LOGW("Ignoring the stale baked file of %s. Bake it again",
+			&filename[0]);
+	}
 
 	ANKI_CHECK(xml.parse(txt.toCString(), getTempAllocator()));
 
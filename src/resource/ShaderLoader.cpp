@@ -73,6 +73,28 @@ Error ShaderLoader::parseFileIncludes(ResourceFilename filename, U32 depth)
 		return ErrorCode::USER_DATA;
 	}
 
+	return parseSourceIncludes(lines, depth);
+}
+
+//==============================================================================
+Error ShaderLoader::parseSource(const CString& source)
+{
+	StringListAuto lines(m_alloc);
+	lines.splitString(source, '\n');
+
+	Error err = parseSourceIncludes(lines, 0);
+
+	if(!err)
+	{
+		m_sourceLines.join(m_alloc, "\n", m_shaderSource);
+	}
+
+	return err;
+}
+
+//==============================================================================
+Error ShaderLoader::parseSourceIncludes(const StringList& lines, U32 depth)
+{
 	for(const String& line : lines)
 	{
 		static const CString token = "#include \"";
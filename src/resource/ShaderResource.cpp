@@ -78,11 +78,21 @@ Error ShaderResource::createToCache(const ResourceFilename& filename,
 		return ErrorCode::NONE;
 	}
 
-	// Create suffix
+	// Read file and append code
+	StringAuto src(alloc);
+
+	ResourceFilePtr file;
+	ANKI_CHECK(manager.getFilesystem().openFile(filename, file));
+	ANKI_CHECK(file->readAllText(alloc, src));
+
+	StringAuto srcfull(alloc);
+	srcfull.sprintf("%s%s", &preAppendedSrcCode[0], &src[0]);
+
+	// Create suffix. The cache outlives the runs so hash the content as well
 	StringAuto unique(alloc);
 
 	unique.create(filename);
-	unique.append(preAppendedSrcCode);
+	unique.append(srcfull.toCString());
 
 	U64 h = computeHash(&unique[0], unique.getLength());
 
@@ -108,16 +118,6 @@ Error ShaderResource::createToCache(const ResourceFilename& filename,
 		return ErrorCode::NONE;
 	}
 
-	// Read file and append code
-	StringAuto src(alloc);
-
-	ResourceFilePtr file;
-	ANKI_CHECK(manager.getFilesystem().openFile(filename, file));
-	ANKI_CHECK(file->readAllText(alloc, src));
-
-	StringAuto srcfull(alloc);
-	srcfull.sprintf("%s%s", &preAppendedSrcCode[0], &src[0]);
-
 	// Write cached file
 	File f;
 	ANKI_CHECK(f.open(newFilename.toCString(), File::OpenFlag::WRITE));
@@ -38,6 +38,7 @@ public:
 	TexUploadTask(GenericMemoryPoolAllocator<U8> alloc)
 		: m_loader(alloc)
 	{
+		m_stage = AsyncLoaderStage::UPLOAD;
 	}
 
 	Error operator()(AsyncLoaderTaskContext& ctx) final;
@@ -60,20 +61,28 @@ Error TexUploadTask::operator()(AsyncLoaderTaskContext& ctx)
 				{
 					const auto& surf =
 						m_loader.getSurface(mip, depth, face, layer);
+					const PtrSize size = surf.getDataSize();
 
-					TransientMemoryToken token;
+					// Always upload something even if the surface doesn't fit
+					// the budget
 					Error err = ErrorCode::NONE;
-					void* data = m_gr->allocateFrameTransientMemory(
-						surf.m_data.getSize(),
-						BufferUsageBit::TRANSFER_SOURCE,
-						token,
-						&err);
+					void* data = nullptr;
+					TransientMemoryToken token;
+					if(ctx.m_uploadedBytes == 0
+						|| ctx.m_uploadedBytes + size <= ctx.m_uploadBudget)
+					{
+						data = m_gr->allocateFrameTransientMemory(size,
+							BufferUsageBit::TRANSFER_SOURCE,
+							token,
+							&err);
+					}
 
-					if(!err)
+					if(data && !err)
 					{
-						// There is enough transfer memory
+						// There is enough transfer memory and budget
 
-						memcpy(data, &surf.m_data[0], surf.m_data.getSize());
+						memcpy(data, surf.getData(), size);
+						ctx.m_uploadedBytes += size;
 
 						if(!cmdb)
 						{
@@ -87,8 +96,8 @@ Error TexUploadTask::operator()(AsyncLoaderTaskContext& ctx)
 					}
 					else
 					{
-						// Not enough transfer memory. Move the work to the
-						// future
+						// Not enough transfer memory or budget. Move the work
+						// to the next frame
 
 						if(cmdb)
 						{
@@ -100,14 +109,20 @@ Error TexUploadTask::operator()(AsyncLoaderTaskContext& ctx)
 						m_ctx.m_face = face;
 						m_ctx.m_layer = layer;
 
-						ctx.m_pause = true;
 						ctx.m_resubmitTask = true;
 
 						return ErrorCode::NONE;
 					}
 				}
+
+				// The next loops start from the beginning
+				m_ctx.m_mip = 0;
 			}
+
+			m_ctx.m_face = 0;
 		}
+
+		m_ctx.m_depth = 0;
 	}
 
 	// Finaly enque the command buffer
@@ -5,6 +5,7 @@
 
 #include <anki/scene/FrustumComponent.h>
 #include <anki/scene/Visibility.h>
+#include <anki/scene/VisibilityInternal.h>
 #include <anki/util/Rtti.h>
 
 namespace anki
@@ -24,6 +25,28 @@ FrustumComponent::FrustumComponent(SceneNode* node, Frustum* frustum)
 	setEnabledVisibilityTests(FrustumComponentVisibilityTestFlag::NONE);
 }
 
+//==============================================================================
+FrustumComponent::~FrustumComponent()
+{
+	if(m_visCache)
+	{
+		auto alloc = getAllocator();
+		m_visCache->destroy(alloc);
+		alloc.deleteInstance(m_visCache);
+	}
+}
+
+//==============================================================================
+VisibilityCache& FrustumComponent::getVisibilityCache()
+{
+	if(m_visCache == nullptr)
+	{
+		m_visCache = getAllocator().newInstance<VisibilityCache>();
+	}
+
+	return *m_visCache;
+}
+
 //==============================================================================
 void FrustumComponent::setVisibilityTestResults(VisibilityTestResults* visible)
 {
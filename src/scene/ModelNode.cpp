@@ -31,7 +31,8 @@ public:
 	ModelPatchRenderComponent(ModelPatchNode* node)
 		: RenderComponent(node,
 			  &node->m_modelPatch->getMaterial(),
-			  node->m_modelPatch->getModel().getUuid())
+			  node->m_modelPatch->getModel().getUuid(),
+			  node->m_modelPatch->isInGeometryPool())
 	{
 	}
 
@@ -41,6 +42,12 @@ public:
 		return getNode().buildRendering(data);
 	}
 
+	void getDrawcall(const RenderingKey& key,
+		DrawElementsIndirectInfo& draw) const override
+	{
+		getNode().m_modelPatch->getDrawcall(key, draw);
+	}
+
 	void getRenderWorldTransform(
 		Bool& hasTransform, Transform& trf) const override
 	{
@@ -100,6 +107,7 @@ Error ModelPatchNode::buildRendering(RenderingBuildInfo& data) const
 
 	Array<U32, ANKI_GL_MAX_SUB_DRAWCALLS> indicesCountArray;
 	Array<PtrSize, ANKI_GL_MAX_SUB_DRAWCALLS> indicesOffsetArray;
+	U32 baseVertex;
 	U32 drawcallCount;
 
 	PipelinePtr ppline;
@@ -111,6 +119,7 @@ Error ModelPatchNode::buildRendering(RenderingBuildInfo& data) const
 		ppline,
 		indicesCountArray,
 		indicesOffsetArray,
+		baseVertex,
 		drawcallCount);
 
 	// Cannot accept multi-draw
@@ -121,9 +130,20 @@ Error ModelPatchNode::buildRendering(RenderingBuildInfo& data) const
 	data.m_cmdb->bindResourceGroup(grResources, 0, data.m_dynamicBufferInfo);
 
 	// Drawcall
-	U32 offset = indicesOffsetArray[0] / sizeof(U16);
-	data.m_cmdb->drawElements(
-		indicesCountArray[0], data.m_key.m_instanceCount, offset);
+	if(data.m_indirectDrawcallCount > 0)
+	{
+		ANKI_ASSERT(m_modelPatch->isInGeometryPool());
+		data.m_cmdb->drawElementsIndirect(
+			data.m_indirectDrawcallCount, data.m_indirectDrawcalls);
+	}
+	else
+	{
+		U32 offset = indicesOffsetArray[0] / sizeof(U16);
+		data.m_cmdb->drawElements(indicesCountArray[0],
+			data.m_key.m_instanceCount,
+			offset,
+			baseVertex);
+	}
 
 	return ErrorCode::NONE;
 }
@@ -42,6 +42,39 @@ struct CreateNewRenderComponentVariableVisitor
 	}
 };
 
+/// Write the non builtin variables to a uniform block.
+class WriteUniformCacheVisitor
+{
+public:
+	const MaterialVariant* m_variant ANKI_DBG_NULLIFY_PTR;
+	WeakArray<U8> m_uniforms;
+
+	template<typename TRenderComponentVariableTemplate>
+	Error visit(const TRenderComponentVariableTemplate& rvar)
+	{
+		using Type = typename TRenderComponentVariableTemplate::Type;
+		write<Type>(rvar.getMaterialVariable(), rvar.getValue());
+		return ErrorCode::NONE;
+	}
+
+	template<typename T>
+	void write(const MaterialVariable& mvar, const T& value)
+	{
+		mvar.writeShaderBlockMemory<T>(*m_variant,
+			&value,
+			1,
+			&m_uniforms[0],
+			&m_uniforms[0] + m_uniforms.getSize());
+	}
+};
+
+// Textures are not part of the uniform block
+template<>
+void WriteUniformCacheVisitor::write<TextureResourcePtr>(
+	const MaterialVariable& mvar, const TextureResourcePtr& value)
+{
+}
+
 //==============================================================================
 // RenderComponentVariable                                                     =
 //==============================================================================
@@ -63,10 +96,12 @@ RenderComponentVariable::~RenderComponentVariable()
 //==============================================================================
 
 //==============================================================================
-RenderComponent::RenderComponent(SceneNode* node, const Material* mtl, U64 hash)
+RenderComponent::RenderComponent(
+	SceneNode* node, const Material* mtl, U64 hash, Bool batchable)
 	: SceneComponent(SceneComponentType::RENDER, node)
 	, m_mtl(mtl)
 	, m_hash(hash)
+	, m_batchable(batchable)
 {
 }
 
@@ -80,6 +115,11 @@ RenderComponent::~RenderComponent()
 	}
 
 	m_vars.destroy(alloc);
+
+	for(UniformCache& cache : m_uniformCaches)
+	{
+		cache.m_uniforms.destroy(alloc);
+	}
 }
 
 //==============================================================================
@@ -104,4 +144,47 @@ Error RenderComponent::init()
 	return ErrorCode::NONE;
 }
 
+//==============================================================================
+void RenderComponent::writeUniformBlock(const MaterialVariant& variant,
+	Pass pass,
+	WeakArray<U8> uniforms) const
+{
+	ANKI_ASSERT(uniforms.getSize() == variant.getDefaultBlockSize());
+	UniformCache& cache = m_uniformCaches[U(pass)];
+	LockGuard<SpinLock> lock(cache.m_lock);
+
+	if(cache.m_variant != &variant || cache.m_varsVersion != m_varsVersion)
+	{
+		// Out of date, write the variables again
+		if(cache.m_uniforms.getSize() != uniforms.getSize())
+		{
+			auto alloc = m_node->getSceneAllocator();
+			cache.m_uniforms.destroy(alloc);
+			cache.m_uniforms.create(alloc, uniforms.getSize());
+			memset(&cache.m_uniforms[0], 0, uniforms.getSize());
+		}
+
+		WriteUniformCacheVisitor vis;
+		vis.m_variant = &variant;
+		vis.m_uniforms = WeakArray<U8>(
+			&cache.m_uniforms[0], cache.m_uniforms.getSize());
+
+		for(const RenderComponentVariable* rvar : m_vars)
+		{
+			const MaterialVariable& mvar = rvar->getMaterialVariable();
+			if(mvar.getBuiltin() == BuiltinMaterialVariableId::NONE
+				&& variant.variableActive(mvar))
+			{
+				Error err = rvar->acceptVisitor(vis);
+				(void)err;
+			}
+		}
+
+		cache.m_variant = &variant;
+		cache.m_varsVersion = m_varsVersion;
+	}
+
+	memcpy(&uniforms[0], &cache.m_uniforms[0], uniforms.getSize());
+}
+
 } // end namespace anki
@@ -13,7 +13,7 @@
 #include <anki/renderer/MainRenderer.h>
 #include <anki/renderer/Renderer.h>
 #include <anki/misc/ConfigSet.h>
-#include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHive.h>
 
 namespace anki
 {
@@ -26,97 +26,33 @@ namespace
 {
 
 //==============================================================================
-class UpdateSceneNodesTask : public ThreadPoolTask
+ANKI_USE_RESULT Error updateNode(
+	SceneNode& node, F32 prevTime, F32 crntTime)
 {
-public:
-	SceneGraph* m_scene = nullptr;
-	F32 m_prevUpdateTime;
-	F32 m_crntTime;
+	Error err = ErrorCode::NONE;
 
-	IntrusiveList<SceneNode>::Iterator* m_crntNode;
-	SpinLock* m_crntNodeLock;
-	IntrusiveList<SceneNode>::Iterator m_nodesEnd;
+	// Components update
+	err = node.iterateComponents([&](SceneComponent& comp) -> Error {
+		Bool updated = false;
+		return comp.updateReal(node, prevTime, crntTime, updated);
+	});
 
-	Error operator()(U32 taskId, PtrSize threadsCount)
+	// Update children
+	if(!err)
 	{
-		ANKI_TRACE_START_EVENT(SCENE_NODES_UPDATE);
-
-		IntrusiveList<SceneNode>::Iterator& it = *m_crntNode;
-		SpinLock& lock = *m_crntNodeLock;
-
-		Bool quit = false;
-		Error err = ErrorCode::NONE;
-		while(!quit && !err)
-		{
-			// Fetch a few scene nodes
-			Array<SceneNode*, 5> nodes = {{
-				nullptr,
-			}};
-			lock.lock();
-			for(SceneNode*& node : nodes)
-			{
-				if(it != m_nodesEnd)
-				{
-					node = &(*it);
-					++it;
-				}
-			}
-			lock.unlock();
-
-			// Process nodes
-			U count = 0;
-			for(U i = 0; i < nodes.getSize(); ++i)
-			{
-				if(nodes[i])
-				{
-					if(nodes[i]->getParent() == nullptr)
-					{
-						err = updateInternal(
-							*nodes[i], m_prevUpdateTime, m_crntTime);
-						ANKI_TRACE_INC_COUNTER(SCENE_NODES_UPDATED, 1);
-					}
-					++count;
-				}
-			}
-
-			if(ANKI_UNLIKELY(count == 0))
-			{
-				quit = true;
-			}
-		}
-
-		ANKI_TRACE_STOP_EVENT(SCENE_NODES_UPDATE);
-		return err;
+		err = node.visitChildren([&](SceneNode& child) -> Error {
+			return updateNode(child, prevTime, crntTime);
+		});
 	}
 
-	ANKI_USE_RESULT Error updateInternal(
-		SceneNode& node, F32 prevTime, F32 crntTime)
+	// Frame update
+	if(!err)
 	{
-		Error err = ErrorCode::NONE;
-
-		// Components update
-		err = node.iterateComponents([&](SceneComponent& comp) -> Error {
-			Bool updated = false;
-			return comp.updateReal(node, prevTime, crntTime, updated);
-		});
-
-		// Update children
-		if(!err)
-		{
-			err = node.visitChildren([&](SceneNode& child) -> Error {
-				return updateInternal(child, prevTime, crntTime);
-			});
-		}
-
-		// Frame update
-		if(!err)
-		{
-			err = node.frameUpdateComplete(prevTime, crntTime);
-		}
-
-		return err;
+		err = node.frameUpdateComplete(prevTime, crntTime);
 	}
-};
+
+	return err;
+}
 
 } // end namespace anonymous
 
@@ -139,6 +75,7 @@ SceneGraph::~SceneGraph()
 	(void)err;
 
 	deleteNodesMarkedForDeletion();
+	m_nodesDict.destroy(m_alloc);
 
 	if(m_sectors)
 	{
@@ -150,7 +87,6 @@ SceneGraph::~SceneGraph()
 //==============================================================================
 Error SceneGraph::init(AllocAlignedCallback allocCb,
 	void* allocCbData,
-	ThreadPool* threadpool,
 	ThreadHive* threadHive,
 	ResourceManager* resources,
 	Input* input,
@@ -158,7 +94,6 @@ Error SceneGraph::init(AllocAlignedCallback allocCb,
 	const ConfigSet& config)
 {
 	m_globalTimestamp = globalTimestamp;
-	m_threadpool = threadpool;
 	m_threadHive = threadHive;
 	m_resources = resources;
 	m_objectsMarkedForDeletionCount.store(0);
@@ -167,16 +102,34 @@ Error SceneGraph::init(AllocAlignedCallback allocCb,
 	m_input = input;
 
 	m_alloc = SceneAllocator<U8>(allocCb, allocCbData, 1024 * 10, 1.0, 0);
-	m_frameAlloc =
-		SceneFrameAllocator<U8>(allocCb, allocCbData, 1 * 1024 * 1024);
+	// The threads do the small frame allocations from their own blocks
+	m_frameAlloc = SceneFrameAllocator<U8>(allocCb,
+		allocCbData,
+		1 * 1024 * 1024,
+		2.0,
+		0,
+		true,
+		ANKI_SAFE_ALIGNMENT,
+		16 * 1024);
 
 	ANKI_CHECK(m_events.create(this));
 
 	m_sectors = m_alloc.newInstance<SectorGroup>(this);
+	m_sectors->setSpatialIndex(config.getNumber("sceneSpatialIndex") != 0.0
+			? SpatialIndex::DYNAMIC_TREE
+			: SpatialIndex::SECTORS_AND_PORTALS);
 
 	m_maxReflectionProxyDistance =
 		config.getNumber("imageReflectionMaxDistance");
 
+	m_occlusionRasterizerWidth = config.getNumber("occlusionRasterizerWidth");
+	m_occlusionRasterizerHeight = config.getNumber("occlusionRasterizerHeight");
+	if(m_occlusionRasterizerWidth == 0 || m_occlusionRasterizerHeight == 0)
+	{
+		ANKI_LOGE("Wrong occlusion rasterizer size");
+		return ErrorCode::USER_DATA;
+	}
+
 	m_componentLists.init(m_alloc);
 
 	// Init the default main camera
@@ -286,6 +239,22 @@ Error SceneGraph::update(
 
 	m_timestamp = *m_globalTimestamp;
 
+#if ANKI_ENABLE_TRACE
+	// Gather the allocator stats of the previous frame
+	{
+		MemoryPoolStats stats = m_alloc.getMemoryPool().getStats();
+		MemoryPoolStats frameStats = m_frameAlloc.getMemoryPool().getStats();
+
+		U32 contention =
+			stats.m_lockContentionCount + frameStats.m_lockContentionCount;
+		ANKI_TRACE_INC_COUNTER(SCENE_MEMORY, stats.m_usedSize);
+		ANKI_TRACE_INC_COUNTER(SCENE_FRAME_MEMORY, frameStats.m_usedSize);
+		ANKI_TRACE_INC_COUNTER(SCENE_ALLOCATOR_LOCK_CONTENTION,
+			contention - m_allocLockContentionCount);
+		m_allocLockContentionCount = contention;
+	}
+#endif
+
 	// Reset the framepool
 	m_frameAlloc.getMemoryPool().reset();
 
@@ -295,9 +264,6 @@ Error SceneGraph::update(
 	deleteNodesMarkedForDeletion();
 	ANKI_TRACE_STOP_EVENT(SCENE_DELETE_STUFF);
 
-	ThreadPool& threadPool = *m_threadpool;
-	(void)threadPool;
-
 	// Update
 	ANKI_TRACE_START_EVENT(SCENE_PHYSICS_UPDATE);
 	m_physics->updateAsync(crntTime - prevUpdateTime);
@@ -307,26 +273,31 @@ Error SceneGraph::update(
 	ANKI_TRACE_START_EVENT(SCENE_NODES_UPDATE);
 	ANKI_CHECK(m_events.updateAllEvents(prevUpdateTime, crntTime));
 
-	// Then the rest
-	Array<UpdateSceneNodesTask, ThreadPool::MAX_THREADS> jobs2;
-	IntrusiveList<SceneNode>::Iterator nodeIt = m_nodes.getBegin();
-	SpinLock nodeItLock;
-
-	for(U i = 0; i < threadPool.getThreadsCount(); i++)
+	// Then the rest. Gather the roots, the children are updated by their
+	// parents
+	SceneNode** roots = m_frameAlloc.newArray<SceneNode*>(m_nodesCount);
+	U rootCount = 0;
+	for(SceneNode& node : m_nodes)
 	{
-		UpdateSceneNodesTask& job = jobs2[i];
-
-		job.m_scene = this;
-		job.m_prevUpdateTime = prevUpdateTime;
-		job.m_crntTime = crntTime;
-		job.m_crntNode = &nodeIt;
-		job.m_crntNodeLock = &nodeItLock;
-		job.m_nodesEnd = m_nodes.getEnd();
-
-		threadPool.assignNewTask(i, &job);
+		if(node.getParent() == nullptr)
+		{
+			roots[rootCount++] = &node;
+		}
 	}
 
-	ANKI_CHECK(threadPool.waitForAllThreadsToFinish());
+	const PtrSize NODES_PER_CHUNK = 4;
+	ANKI_CHECK(m_threadHive->parallelFor(0,
+		rootCount,
+		NODES_PER_CHUNK,
+		[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+			for(PtrSize i = start; i < end; ++i)
+			{
+				ANKI_CHECK(updateNode(*roots[i], prevUpdateTime, crntTime));
+				ANKI_TRACE_INC_COUNTER(SCENE_NODES_UPDATED, 1);
+			}
+
+			return ErrorCode::NONE;
+		}));
 	ANKI_TRACE_STOP_EVENT(SCENE_NODES_UPDATE);
 
 	renderer.getOffscreenRenderer().prepareForVisibilityTests(*m_mainCam);
@@ -5,6 +5,7 @@
 
 #include <anki/scene/SceneNode.h>
 #include <anki/scene/SceneGraph.h>
+#include <anki/scene/SpatialComponent.h>
 
 namespace anki
 {
@@ -120,6 +121,16 @@ void SceneNode::addComponent(SceneComponent* comp, Bool transferOwnership)
 
 	m_components[m_componentsCount++] = comp;
 	comp->setAutomaticCleanup(transferOwnership);
+
+	// The culling table keeps what components the node has. Have the
+	// spatials refresh their entries even if they don't move
+	for(U i = 0; i < m_componentsCount; ++i)
+	{
+		if(m_components[i]->getType() == SpatialComponent::CLASS_TYPE)
+		{
+			static_cast<SpatialComponent*>(m_components[i])->markForUpdate();
+		}
+	}
 }
 
 //==============================================================================
@@ -13,6 +13,7 @@
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/MeshLoader.h>
 #include <anki/renderer/Renderer.h>
+#include <algorithm>
 
 namespace anki
 {
@@ -444,6 +445,42 @@ void Sector::deferredUpdate()
 //==============================================================================
 SectorGroup::~SectorGroup()
 {
+	m_tree.destroy(m_scene->getAllocator());
+	m_releasedSpatials.destroy(m_scene->getAllocator());
+	m_cullingTable.destroy(m_scene->getAllocator());
+}
+
+//==============================================================================
+void SectorGroup::setSpatialIndex(SpatialIndex index)
+{
+	if(index == m_spatialIndex)
+	{
+		return;
+	}
+
+	m_spatialIndex = index;
+	m_layoutChangeRun = m_visibilityTestsRun + 1;
+
+	if(index == SpatialIndex::DYNAMIC_TREE)
+	{
+		// Take the spatials out of the sectors and put them in the tree
+		m_scene->getSceneComponentLists().iterateComponents<SpatialComponent>(
+			[&](SpatialComponent& sp) {
+				unbinSpatial(&sp);
+				updateSpatialInTree(&sp);
+			});
+	}
+	else
+	{
+		// Drop the tree and bin everything again
+		m_tree.destroy(m_scene->getAllocator());
+
+		m_scene->getSceneComponentLists().iterateComponents<SpatialComponent>(
+			[&](SpatialComponent& sp) {
+				sp.setSpatialTreeLeaf(DynamicAabbTree::NULL_NODE);
+				binSpatial(&sp);
+			});
+	}
 }
 
 //==============================================================================
@@ -528,15 +565,60 @@ void SectorGroup::binSpatial(SpatialComponent* sp)
 	});
 }
 
+//==============================================================================
+void SectorGroup::updateSpatialInTree(SpatialComponent* sp)
+{
+	ANKI_ASSERT(sp);
+
+	const U32 leaf = sp->getSpatialTreeLeaf();
+	if(leaf == DynamicAabbTree::NULL_NODE)
+	{
+		sp->setSpatialTreeLeaf(m_tree.newLeaf(m_scene->getAllocator(),
+			sp->getAabb(),
+			sp->getCullingTableIndex()));
+	}
+	else
+	{
+		m_tree.moveLeaf(leaf, sp->getAabb());
+	}
+}
+
 //==============================================================================
 void SectorGroup::spatialDeleted(SpatialComponent* sp)
 {
-	auto it = sp->getSectorInfo().getBegin();
-	auto end = sp->getSectorInfo().getEnd();
-	while(it != end)
 	{
-		(*it)->tryRemoveSpatialComponent(sp);
-		++it;
+		LockGuard<SpinLock> lock(m_mtx);
+
+		const U32 leaf = sp->getSpatialTreeLeaf();
+		if(leaf != DynamicAabbTree::NULL_NODE)
+		{
+			m_tree.deleteLeaf(leaf);
+			sp->setSpatialTreeLeaf(DynamicAabbTree::NULL_NODE);
+		}
+
+		// Remember the entry so the visibility caches forget it
+		if(m_releasedSpatialCount + 1 > m_releasedSpatials.getSize())
+		{
+			m_releasedSpatials.resize(m_scene->getAllocator(),
+				max<U32>(16, m_releasedSpatials.getSize() * 2));
+		}
+
+		m_releasedSpatials[m_releasedSpatialCount++] =
+			sp->getCullingTableIndex();
+	}
+
+	unbinSpatial(sp);
+}
+
+//==============================================================================
+void SectorGroup::unbinSpatial(SpatialComponent* sp)
+{
+	ANKI_ASSERT(sp);
+
+	// tryRemoveSpatialComponent() erases from the sector info list
+	while(!sp->getSectorInfo().isEmpty())
+	{
+		sp->getSectorInfo().getFront()->tryRemoveSpatialComponent(sp);
 	}
 }
 
@@ -644,6 +726,12 @@ void SectorGroup::findVisibleSectorsInternal(const FrustumComponent& frc,
 //==============================================================================
 void SectorGroup::prepareForVisibilityTests()
 {
+	++m_visibilityTestsRun;
+	if(!m_portalsUpdated.isEmpty() || !m_sectorsUpdated.isEmpty())
+	{
+		m_layoutChangeRun = m_visibilityTestsRun;
+	}
+
 	// Update portals
 	Error err = m_portalsUpdated.iterateForward([](Portal* portal) {
 		portal->deferredUpdate();
@@ -660,22 +748,82 @@ void SectorGroup::prepareForVisibilityTests()
 	(void)err;
 	m_sectorsUpdated.destroy(m_scene->getFrameAllocator());
 
-	// Bin spatials
+	// Bin spatials and refresh their culling data
 	err =
 		m_spatialsDeferredBinning.iterateForward([this](SpatialComponent* spc) {
-			binSpatial(spc);
+			if(m_spatialIndex == SpatialIndex::DYNAMIC_TREE)
+			{
+				updateSpatialInTree(spc);
+			}
+			else
+			{
+				binSpatial(spc);
+			}
+
+			m_cullingTable.updateEntry(spc->getCullingTableIndex());
 			return ErrorCode::NONE;
 		});
 	(void)err;
+
+	gatherDirtySpatials();
 	m_spatialsDeferredBinning.destroy(m_scene->getFrameAllocator());
 }
 
 //==============================================================================
-void SectorGroup::findVisibleNodes(const FrustumComponent& frc,
-	U testId,
+void SectorGroup::gatherDirtySpatials()
+{
+	auto alloc = m_scene->getFrameAllocator();
+	LockGuard<SpinLock> lock(m_mtx);
+
+	const U entryCount = m_cullingTable.getEntryCount();
+	const U wordCount = max<U>(1, (entryCount + 63) / 64);
+	m_dirtySpatialBits = alloc.newArray<U64>(wordCount, 0);
+
+	const U maxCount =
+		m_releasedSpatialCount + m_spatialsDeferredBinning.getSize();
+	if(maxCount == 0)
+	{
+		m_dirtySpatials = WeakArray<U32>();
+		return;
+	}
+
+	// Released entries may have been taken by new spatials so skip the
+	// duplicates
+	U32* dirty = alloc.newArray<U32>(maxCount);
+	U count = 0;
+	auto markDirty = [&](U32 idx) {
+		if(!isSpatialDirty(idx))
+		{
+			m_dirtySpatialBits[idx / 64] |= U64(1) << (idx % 64);
+			dirty[count++] = idx;
+		}
+	};
+
+	for(U i = 0; i < m_releasedSpatialCount; ++i)
+	{
+		markDirty(m_releasedSpatials[i]);
+	}
+	m_releasedSpatialCount = 0;
+
+	for(SpatialComponent* sp : m_spatialsDeferredBinning)
+	{
+		markDirty(sp->getCullingTableIndex());
+	}
+
+	m_dirtySpatials = WeakArray<U32>(dirty, count);
+}
+
+//==============================================================================
+void SectorGroup::findVisibleSpatials(const FrustumComponent& frc,
 	const SoftwareRasterizer* r,
 	SectorGroupVisibilityTestsContext& ctx) const
 {
+	if(m_spatialIndex == SpatialIndex::DYNAMIC_TREE)
+	{
+		findVisibleSpatialsInTree(frc, r, ctx);
+		return;
+	}
+
 	auto alloc = m_scene->getFrameAllocator();
 
 	// Find visible sectors
@@ -688,35 +836,80 @@ void SectorGroup::findVisibleNodes(const FrustumComponent& frc,
 		return;
 	}
 
-	// Initiate storage of nodes
-	SceneNode** visibleNodesMem = reinterpret_cast<SceneNode**>(
-		alloc.allocate(spatialsCount * sizeof(void*)));
-
-	WeakArray<SceneNode*> visibleNodes(visibleNodesMem, spatialsCount);
+	// Mark the spatials of the visible sectors in a bitset that covers the
+	// whole culling table. A spatial may live in more than one sector
+	const U wordCount = (m_cullingTable.getEntryCount() + 63) / 64;
+	U64* visited = alloc.newArray<U64>(wordCount, 0);
 
-	// Iterate visible sectors and get the scene nodes. The array will contain
-	// duplicates
-	U nodesCount = 0;
 	auto it = visSectors.getBegin();
 	auto end = visSectors.getEnd();
 	for(; it != end; ++it)
 	{
 		const Sector& s = *(*it);
-		for(auto itsp : s.m_spatials)
+		for(const SpatialComponent* sp : s.m_spatials)
 		{
-			const SpatialComponent& spc = *itsp;
-			SceneNode& node = const_cast<SceneNode&>(spc.getSceneNode());
+			const U32 idx = sp->getCullingTableIndex();
+			visited[idx / 64] |= U64(1) << (idx % 64);
+		}
+	}
 
-			// Check if alrady visited
-			if(!node.fetchSetSectorVisited(testId, true))
-			{
-				visibleNodes[nodesCount++] = &node;
-			}
+	// Gather the indices. They come out unique and in the order of the table
+	U32* indices = alloc.newArray<U32>(spatialsCount);
+	U count = 0;
+	for(U w = 0; w < wordCount; ++w)
+	{
+		U64 bits = visited[w];
+		while(bits)
+		{
+			ANKI_ASSERT(count < spatialsCount);
+			indices[count++] = w * 64 + countTrailingZeros(bits);
+			bits &= bits - 1;
 		}
 	}
 
 	// Update the context
-	ctx.m_visibleNodes = WeakArray<SceneNode*>(visibleNodesMem, nodesCount);
+	ctx.m_visibleSpatials = WeakArray<U32>(indices, count);
+}
+
+//==============================================================================
+void SectorGroup::findVisibleSpatialsInTree(const FrustumComponent& frc,
+	const SoftwareRasterizer* r,
+	SectorGroupVisibilityTestsContext& ctx) const
+{
+	const U leafCount = m_tree.getLeafCount();
+	if(ANKI_UNLIKELY(leafCount == 0))
+	{
+		return;
+	}
+
+	U32* indices = m_scene->getFrameAllocator().newArray<U32>(leafCount);
+	U count = 0;
+	auto gather = [&](U32 idx) {
+		ANKI_ASSERT(count < leafCount);
+		indices[count++] = idx;
+	};
+
+	const auto& planes = frc.getFrustum().getPlanesWorldSpace();
+	if(r)
+	{
+		// Skip the subtrees that are hidden behind the occluders
+		m_tree.visitPlanes(&planes[0],
+			planes.getSize(),
+			[r](const Vec4& aabbMin, const Vec4& aabbMax) -> Bool {
+				const Aabb box(aabbMin, aabbMax);
+				return r->visibilityTest(box, box);
+			},
+			gather);
+	}
+	else
+	{
+		m_tree.visitPlanes(&planes[0], planes.getSize(), gather);
+	}
+
+	// Keep the order of the culling table like the sectors do
+	std::sort(indices, indices + count);
+
+	ctx.m_visibleSpatials = WeakArray<U32>(indices, count);
 }
 
-} // end namespace anki
\ No newline at end of file
+} // end namespace anki
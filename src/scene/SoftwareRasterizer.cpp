@@ -5,14 +5,100 @@
 
 #include <anki/scene/SoftwareRasterizer.h>
 #include <anki/collision/Functions.h>
+#include <anki/math/F32x4.h>
 #include <anki/core/Trace.h>
 
 namespace anki
 {
 
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+static_assert(SoftwareRasterizer::BLOCK_WIDTH % 4 == 0, "Wrong block size");
+static_assert(SoftwareRasterizer::TILE_SIZE % SoftwareRasterizer::BLOCK_WIDTH
+			== 0
+		&& SoftwareRasterizer::TILE_SIZE % SoftwareRasterizer::BLOCK_HEIGHT
+			== 0,
+	"Tiles should be made of blocks");
+
+/// Create an array if the existing one is smaller. It doesn't preserve the
+/// contents.
+template<typename T>
+static void ensureArraySize(
+	GenericMemoryPoolAllocator<U8> alloc, DynamicArray<T>& arr, PtrSize size)
+{
+	if(arr.getSize() < size)
+	{
+		arr.destroy(alloc);
+		arr.create(alloc, size);
+	}
+}
+
+/// A triangle in screen space.
+class SoftwareRasterizer::Triangle
+{
+public:
+	/// The edge functions are a * x + b * y + c. They are non negative in the
+	/// inside of the triangle.
+	Array<F32, 3> m_edgeA;
+	Array<F32, 3> m_edgeB;
+	Array<F32, 3> m_edgeC;
+
+	/// The depth in [0, 1] is a * x + b * y + c.
+	F32 m_depthA;
+	F32 m_depthB;
+	F32 m_depthC;
+
+	/// The rectangle in pixels. The max is exclusive.
+	U16 m_minX;
+	U16 m_minY;
+	U16 m_maxX;
+	U16 m_maxY;
+};
+
+/// The triangles of a binTriangles call sorted per tile.
+class SoftwareRasterizer::Binner
+{
+public:
+	DynamicArray<Triangle> m_tris;
+	U32 m_triCount = 0;
+
+	/// The triangles of tile i are in the range [m_tileOffsets[i],
+	/// m_tileOffsets[i + 1]) of m_triIndices.
+	DynamicArray<U32> m_tileOffsets;
+	DynamicArray<U32> m_triIndices;
+};
+
+//==============================================================================
+// SoftwareRasterizer                                                          =
+//==============================================================================
+
+//==============================================================================
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	destroyBinners();
+	m_zbuffer.destroy(m_alloc);
+	m_hizMin.destroy(m_alloc);
+	m_hizMax.destroy(m_alloc);
+}
+
+//==============================================================================
+void SoftwareRasterizer::destroyBinners()
+{
+	for(Binner& b : m_binners)
+	{
+		b.m_tris.destroy(m_alloc);
+		b.m_tileOffsets.destroy(m_alloc);
+		b.m_triIndices.destroy(m_alloc);
+	}
+
+	m_binners.destroy(m_alloc);
+}
+
 //==============================================================================
 void SoftwareRasterizer::prepare(
-	const Mat4& mv, const Mat4& p, U width, U height)
+	const Mat4& mv, const Mat4& p, U width, U height, U binnerCount)
 {
 	m_mv = mv;
 	m_p = p;
@@ -36,15 +122,60 @@ void SoftwareRasterizer::prepare(
 
 	// Reset z buffer
 	ANKI_ASSERT(width > 0 && height > 0);
-	m_width = width;
-	m_height = height;
-	U size = width * height;
-	if(m_zbuffer.getSize() < size)
+	m_width = getAlignedRoundUp(BLOCK_WIDTH, width);
+	m_height = getAlignedRoundUp(BLOCK_HEIGHT, height);
+	m_tileCountX = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileCountY = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+
+	const U size = m_width * m_height;
+	ensureArraySize(m_alloc, m_zbuffer, size);
+	for(U i = 0; i < size; ++i)
 	{
-		m_zbuffer.destroy(m_alloc);
-		m_zbuffer.create(m_alloc, size);
+		m_zbuffer[i] = 1.0;
 	}
-	memset(&m_zbuffer[0], 0xFF, sizeof(m_zbuffer[0]) * size);
+
+	// Set the pyramid levels. The first has a cell per block and the last a
+	// single cell
+	U cellCount = 0;
+	U levelWidth = m_width / BLOCK_WIDTH;
+	U levelHeight = m_height / BLOCK_HEIGHT;
+	m_hizLevelCount = 0;
+	while(1)
+	{
+		ANKI_ASSERT(m_hizLevelCount < MAX_HIZ_LEVELS);
+		m_hizOffsets[m_hizLevelCount] = cellCount;
+		m_hizWidths[m_hizLevelCount] = levelWidth;
+		m_hizHeights[m_hizLevelCount] = levelHeight;
+		++m_hizLevelCount;
+		cellCount += levelWidth * levelHeight;
+
+		if(levelWidth == 1 && levelHeight == 1)
+		{
+			break;
+		}
+
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+
+	ensureArraySize(m_alloc, m_hizMin, cellCount);
+	ensureArraySize(m_alloc, m_hizMax, cellCount);
+
+	// Reset the binners
+	ANKI_ASSERT(binnerCount > 0);
+	if(m_binners.getSize() < binnerCount)
+	{
+		destroyBinners();
+		m_binners.create(m_alloc, binnerCount);
+	}
+
+	m_binnerCount = binnerCount;
+	for(Binner& b : m_binners)
+	{
+		b.m_triCount = 0;
+	}
+
+	m_rasterizedTaskCount.set(0);
 }
 
 //==============================================================================
@@ -179,11 +310,111 @@ void SoftwareRasterizer::clipTriangle(
 }
 
 //==============================================================================
-void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride)
+Bool SoftwareRasterizer::setupTriangle(const Vec4* clip, Triangle& tri) const
 {
-	ANKI_ASSERT(verts && vertCount > 0 && (vertCount % 3) == 0);
+	ANKI_ASSERT(clip);
+
+	// To window space
+	const Vec2 windowSize(m_width, m_height);
+	Array<Vec2, 3> window;
+	Array<F32, 3> depth;
+	for(U i = 0; i < 3; ++i)
+	{
+		ANKI_ASSERT(clip[i].w() > 0.0f);
+		const Vec3 ndc = clip[i].xyz() / clip[i].w();
+		window[i] = (ndc.xy() / 2.0 + 0.5) * windowSize;
+		depth[i] = ndc.z() / 2.0 + 0.5;
+	}
+
+	// Make it counter clockwise
+	F32 area = (window[1].x() - window[0].x()) * (window[2].y() - window[0].y())
+		- (window[2].x() - window[0].x()) * (window[1].y() - window[0].y());
+	if(area < 0.0)
+	{
+		std::swap(window[1], window[2]);
+		std::swap(depth[1], depth[2]);
+		area = -area;
+	}
+
+	if(area <= getEpsilon<F32>())
+	{
+		return false;
+	}
+
+	// Bounding rectangle
+	Vec2 bboxMin(MAX_F32), bboxMax(MIN_F32);
+	for(U i = 0; i < 3; ++i)
+	{
+		for(U j = 0; j < 2; ++j)
+		{
+			bboxMin[j] = min(bboxMin[j], window[i][j]);
+			bboxMax[j] = max(bboxMax[j], window[i][j]);
+		}
+	}
+
+	for(U j = 0; j < 2; ++j)
+	{
+		bboxMin[j] = clamp(floorf(bboxMin[j]), 0.0f, windowSize[j]);
+		bboxMax[j] = clamp(ceilf(bboxMax[j]), 0.0f, windowSize[j]);
+	}
+
+	if(bboxMin.x() >= bboxMax.x() || bboxMin.y() >= bboxMax.y())
+	{
+		return false;
+	}
+
+	tri.m_minX = bboxMin.x();
+	tri.m_minY = bboxMin.y();
+	tri.m_maxX = bboxMax.x();
+	tri.m_maxY = bboxMax.y();
+
+	// The edge i goes from the vertex i to the next
+	for(U i = 0; i < 3; ++i)
+	{
+		const Vec2& a = window[i];
+		const Vec2& b = window[(i + 1) % 3];
+
+		tri.m_edgeA[i] = a.y() - b.y();
+		tri.m_edgeB[i] = b.x() - a.x();
+		tri.m_edgeC[i] = a.x() * b.y() - a.y() * b.x();
+	}
+
+	// The barycentric of a vertex is the edge function of the opposite edge
+	const F32 invArea = 1.0 / area;
+	const Array<F32, 3> bcDepth = {
+		{depth[2] * invArea, depth[0] * invArea, depth[1] * invArea}};
+
+	tri.m_depthA = tri.m_depthB = tri.m_depthC = 0.0;
+	for(U i = 0; i < 3; ++i)
+	{
+		tri.m_depthA += tri.m_edgeA[i] * bcDepth[i];
+		tri.m_depthB += tri.m_edgeB[i] * bcDepth[i];
+		tri.m_depthC += tri.m_edgeC[i] * bcDepth[i];
+	}
+
+	return true;
+}
+
+//==============================================================================
+void SoftwareRasterizer::binTriangles(
+	U binnerIdx, const F32* verts, U vertCount, U stride)
+{
+	ANKI_ASSERT(binnerIdx < m_binnerCount);
+	ANKI_ASSERT((vertCount % 3) == 0);
 	ANKI_ASSERT(stride >= sizeof(F32) * 3 && (stride % sizeof(F32)) == 0);
 
+	Binner& binner = m_binners[binnerIdx];
+	binner.m_triCount = 0;
+	if(vertCount == 0)
+	{
+		return;
+	}
+
+	ANKI_ASSERT(verts);
+
+	// Near clipping can split a triangle to two
+	ensureArraySize(m_alloc, binner.m_tris, vertCount / 3 * 2);
+
 	U floatStride = stride / sizeof(F32);
 	const F32* vertsEnd = verts + vertCount * floatStride;
 	while(verts != vertsEnd)
@@ -211,100 +442,326 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride)
 		Array<Vec4, 6> clippedTrisVspace;
 		U clippedCount = 0;
 		clipTriangle(&triVspace[0], &clippedTrisVspace[0], clippedCount);
-		if(clippedCount == 0)
-		{
-			// Outside view
-			continue;
-		}
 
-		// Rasterize
+		// Setup
 		Array<Vec4, 3> clip;
 		for(U j = 0; j < clippedCount; j += 3)
 		{
 			for(U k = 0; k < 3; k++)
 			{
 				clip[k] = m_p * clippedTrisVspace[j + k].xyz1();
-				ANKI_ASSERT(clip[k].w() > 0.0f);
 			}
 
-			rasterizeTriangle(&clip[0]);
+			if(setupTriangle(&clip[0], binner.m_tris[binner.m_triCount]))
+			{
+				++binner.m_triCount;
+			}
+		}
+	}
+
+	// Count the triangles per tile
+	const U tileCount = m_tileCountX * m_tileCountY;
+	ensureArraySize(m_alloc, binner.m_tileOffsets, tileCount + 1);
+	DynamicArray<U32>& offsets = binner.m_tileOffsets;
+	memset(&offsets[0], 0, sizeof(offsets[0]) * (tileCount + 1));
+
+	for(U i = 0; i < binner.m_triCount; ++i)
+	{
+		const Triangle& tri = binner.m_tris[i];
+		for(U y = tri.m_minY / TILE_SIZE; y <= (tri.m_maxY - 1U) / TILE_SIZE;
+			++y)
+		{
+			for(U x = tri.m_minX / TILE_SIZE;
+				x <= (tri.m_maxX - 1U) / TILE_SIZE;
+				++x)
+			{
+				++offsets[y * m_tileCountX + x];
+			}
+		}
+	}
+
+	// Make the counts the ends of the ranges and fill backwards. In the end
+	// they will be the beginnings
+	U32 total = 0;
+	for(U i = 0; i < tileCount; ++i)
+	{
+		total += offsets[i];
+		offsets[i] = total;
+	}
+	offsets[tileCount] = total;
+
+	if(total == 0)
+	{
+		return;
+	}
+
+	ensureArraySize(m_alloc, binner.m_triIndices, total);
+	for(U i = 0; i < binner.m_triCount; ++i)
+	{
+		const Triangle& tri = binner.m_tris[i];
+		for(U y = tri.m_minY / TILE_SIZE; y <= (tri.m_maxY - 1U) / TILE_SIZE;
+			++y)
+		{
+			for(U x = tri.m_minX / TILE_SIZE;
+				x <= (tri.m_maxX - 1U) / TILE_SIZE;
+				++x)
+			{
+				binner.m_triIndices[--offsets[y * m_tileCountX + x]] = i;
+			}
 		}
 	}
 }
 
 //==============================================================================
-Bool SoftwareRasterizer::computeBarycetrinc(
-	const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const
+void SoftwareRasterizer::rasterizeTiles(U taskIdx, U taskCount)
 {
-	Vec2 dca = c - a;
-	Vec2 dba = b - a;
-	Vec2 dap = a - p;
+	ANKI_ASSERT(taskIdx < taskCount);
+
+	// Interleave the tiles because the center of the screen is usually denser
+	const U tileCount = m_tileCountX * m_tileCountY;
+	for(U i = taskIdx; i < tileCount; i += taskCount)
+	{
+		const U tileX = i % m_tileCountX;
+		const U tileY = i / m_tileCountX;
+
+		rasterizeTile(tileX, tileY);
+		buildTileHiz(tileX, tileY);
+	}
 
-	Vec3 n(dca.x(), dba.x(), dap.x());
-	Vec3 m(dca.y(), dba.y(), dap.y());
+	// The last task builds the top of the pyramid. It needs to see the tiles
+	// of the other tasks
+	if(m_rasterizedTaskCount.fetchAdd(1, AtomicMemoryOrder::ACQ_REL) + 1
+		== taskCount)
+	{
+		buildTopHiz();
+	}
+}
+
+//==============================================================================
+void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride)
+{
+	m_rasterizedTaskCount.set(0);
+	binTriangles(0, verts, vertCount, stride);
+	rasterizeTiles(0, 1);
+}
 
-	Vec3 k = n.cross(m);
+//==============================================================================
+void SoftwareRasterizer::rasterizeTile(U tileX, U tileY)
+{
+	const U tileMinX = tileX * TILE_SIZE;
+	const U tileMinY = tileY * TILE_SIZE;
+	const U tileMaxX = min<U>(tileMinX + TILE_SIZE, m_width);
+	const U tileMaxY = min<U>(tileMinY + TILE_SIZE, m_height);
+	const U tileIdx = tileY * m_tileCountX + tileX;
 
-	Bool skip = false;
-	if(!isZero(k.z()))
+	for(U b = 0; b < m_binnerCount; ++b)
 	{
-		uvw = Vec3(1.0 - (k.x() + k.y()) / k.z(), k.y() / k.z(), k.x() / k.z());
+		const Binner& binner = m_binners[b];
+		if(binner.m_triCount == 0)
+		{
+			continue;
+		}
 
-		if(uvw.x() < 0.0f || uvw.y() < 0.0f || uvw.z() < 0.0f)
+		for(U i = binner.m_tileOffsets[tileIdx];
+			i < binner.m_tileOffsets[tileIdx + 1];
+			++i)
 		{
-			skip = true;
+			const Triangle& tri = binner.m_tris[binner.m_triIndices[i]];
+
+			rasterizeTriangle(tri,
+				max<U>(tileMinX, tri.m_minX),
+				max<U>(tileMinY, tri.m_minY),
+				min<U>(tileMaxX, tri.m_maxX),
+				min<U>(tileMaxY, tri.m_maxY));
 		}
 	}
-	else
+}
+
+//==============================================================================
+void SoftwareRasterizer::rasterizeTriangle(
+	const Triangle& tri, U minX, U minY, U maxX, U maxY)
+{
+	ANKI_ASSERT(minX < maxX && minY < maxY);
+	ANKI_ASSERT(maxX <= m_width && maxY <= m_height);
+
+	const F32x4 pixelOffsets = setLanes(0.5, 1.5, 2.5, 3.5);
+	const F32x4 depthA = splat(tri.m_depthA);
+	Array<F32x4, 3> edgeA;
+	for(U i = 0; i < 3; ++i)
 	{
-		skip = true;
+		edgeA[i] = splat(tri.m_edgeA[i]);
 	}
 
-	return skip;
+	for(U by = minY / BLOCK_HEIGHT; by <= (maxY - 1) / BLOCK_HEIGHT; ++by)
+	{
+		const F32 blockMinY = by * BLOCK_HEIGHT + 0.5f;
+		const F32 blockMaxY = blockMinY + F32(BLOCK_HEIGHT - 1);
+
+		for(U bx = minX / BLOCK_WIDTH; bx <= (maxX - 1) / BLOCK_WIDTH; ++bx)
+		{
+			const F32 blockMinX = bx * BLOCK_WIDTH + 0.5f;
+			const F32 blockMaxX = blockMinX + F32(BLOCK_WIDTH - 1);
+
+			// Evaluate the edges in the pixel centers of the block corners
+			// to reject the block or skip the edge tests
+			Bool outside = false;
+			U edgesContainingBlock = 0;
+			for(U i = 0; i < 3; ++i)
+			{
+				const F32 a = tri.m_edgeA[i];
+				const F32 b = tri.m_edgeB[i];
+				const F32 c = tri.m_edgeC[i];
+
+				const F32 maxE = a * ((a > 0.0) ? blockMaxX : blockMinX)
+					+ b * ((b > 0.0) ? blockMaxY : blockMinY) + c;
+				const F32 minE = a * ((a > 0.0) ? blockMinX : blockMaxX)
+					+ b * ((b > 0.0) ? blockMinY : blockMaxY) + c;
+
+				outside = outside || maxE < 0.0;
+				edgesContainingBlock += (minE >= 0.0) ? 1 : 0;
+			}
+
+			if(outside)
+			{
+				continue;
+			}
+
+			const Bool fullyCovered = edgesContainingBlock == 3;
+
+			for(U row = 0; row < BLOCK_HEIGHT; ++row)
+			{
+				const F32 y = blockMinY + F32(row);
+				F32* depths = &m_zbuffer[(by * BLOCK_HEIGHT + row) * m_width
+					+ bx * BLOCK_WIDTH];
+
+				const F32x4 depthRow = splat(tri.m_depthB * y + tri.m_depthC);
+				Array<F32x4, 3> edgeRow;
+				for(U i = 0; i < 3; ++i)
+				{
+					edgeRow[i] = splat(tri.m_edgeB[i] * y + tri.m_edgeC[i]);
+				}
+
+				for(U col = 0; col < BLOCK_WIDTH; col += 4)
+				{
+					const F32x4 x =
+						add(splat(F32(bx * BLOCK_WIDTH + col)), pixelOffsets);
+					const F32x4 z = mulAdd(depthA, x, depthRow);
+					const F32x4 depth = load(depths + col);
+
+					if(fullyCovered)
+					{
+						store(depths + col, minPerLane(depth, z));
+					}
+					else
+					{
+						store(depths + col,
+							minInside(depth,
+								z,
+								mulAdd(edgeA[0], x, edgeRow[0]),
+								mulAdd(edgeA[1], x, edgeRow[1]),
+								mulAdd(edgeA[2], x, edgeRow[2])));
+					}
+				}
+			}
+		}
+	}
 }
 
 //==============================================================================
-void SoftwareRasterizer::rasterizeTriangle(const Vec4* tri)
+void SoftwareRasterizer::reduceHizCell(U level, U cellX, U cellY)
 {
-	ANKI_ASSERT(tri);
+	ANKI_ASSERT(level > 0 && level < m_hizLevelCount);
+	ANKI_ASSERT(cellX < m_hizWidths[level] && cellY < m_hizHeights[level]);
 
-	const Vec2 windowSize(m_width, m_height);
-	Array<Vec3, 3> ndc;
-	Array<Vec2, 3> window;
-	Vec2 bboxMin(MAX_F32), bboxMax(MIN_F32);
-	for(U i = 0; i < 3; i++)
+	const U childLevel = level - 1;
+	const U childMaxX = min<U>(cellX * 2 + 2, m_hizWidths[childLevel]);
+	const U childMaxY = min<U>(cellY * 2 + 2, m_hizHeights[childLevel]);
+
+	F32 minZ = MAX_F32;
+	F32 maxZ = MIN_F32;
+	for(U y = cellY * 2; y < childMaxY; ++y)
 	{
-		ndc[i] = tri[i].xyz() / tri[i].w();
-		window[i] = (ndc[i].xy() / 2.0 + 0.5) * windowSize;
+		for(U x = cellX * 2; x < childMaxX; ++x)
+		{
+			const U idx = m_hizOffsets[childLevel]
+				+ y * m_hizWidths[childLevel] + x;
+			minZ = min(minZ, m_hizMin[idx]);
+			maxZ = max(maxZ, m_hizMax[idx]);
+		}
+	}
 
-		for(U j = 0; j < 2; j++)
+	const U idx = m_hizOffsets[level] + cellY * m_hizWidths[level] + cellX;
+	m_hizMin[idx] = minZ;
+	m_hizMax[idx] = maxZ;
+}
+
+//==============================================================================
+void SoftwareRasterizer::buildTileHiz(U tileX, U tileY)
+{
+	static_assert((BLOCK_WIDTH << (TILE_HIZ_LEVELS - 1)) <= TILE_SIZE
+			&& (BLOCK_HEIGHT << (TILE_HIZ_LEVELS - 1)) <= TILE_SIZE,
+		"The cells of the tile levels should fit in a tile");
+
+	const U tileMinX = tileX * TILE_SIZE;
+	const U tileMinY = tileY * TILE_SIZE;
+	const U tileMaxX = min<U>(tileMinX + TILE_SIZE, m_width);
+	const U tileMaxY = min<U>(tileMinY + TILE_SIZE, m_height);
+
+	// The first level has the min and max of the blocks
+	for(U by = tileMinY / BLOCK_HEIGHT; by < tileMaxY / BLOCK_HEIGHT; ++by)
+	{
+		for(U bx = tileMinX / BLOCK_WIDTH; bx < tileMaxX / BLOCK_WIDTH; ++bx)
 		{
-			bboxMin[j] = floor(min(bboxMin[j], window[i][j]));
-			bboxMin[j] = clamp(bboxMin[j], 0.0f, windowSize[j]);
+			F32x4 minZ = splat(MAX_F32);
+			F32x4 maxZ = splat(MIN_F32);
+			for(U row = 0; row < BLOCK_HEIGHT; ++row)
+			{
+				const F32* depths = &m_zbuffer[(by * BLOCK_HEIGHT + row)
+						* m_width
+					+ bx * BLOCK_WIDTH];
+
+				for(U col = 0; col < BLOCK_WIDTH; col += 4)
+				{
+					const F32x4 depth = load(depths + col);
+					minZ = minPerLane(minZ, depth);
+					maxZ = maxPerLane(maxZ, depth);
+				}
+			}
 
-			bboxMax[j] = ceil(max(bboxMax[j], window[i][j]));
-			bboxMax[j] = clamp(bboxMax[j], 0.0f, windowSize[j]);
+			const U idx = by * m_hizWidths[0] + bx;
+			m_hizMin[idx] = horizontalMin(minZ);
+			m_hizMax[idx] = horizontalMax(maxZ);
 		}
 	}
 
-	for(F32 y = bboxMin.y() + 0.5; y < bboxMax.y() + 0.5; y += 1.0)
+	// The next levels
+	const U levelCount = min<U>(TILE_HIZ_LEVELS, m_hizLevelCount);
+	for(U level = 1; level < levelCount; ++level)
 	{
-		for(F32 x = bboxMin.x() + 0.5; x < bboxMax.x() + 0.5; x += 1.0)
+		const U cellWidth = BLOCK_WIDTH << level;
+		const U cellHeight = BLOCK_HEIGHT << level;
+
+		for(U y = tileMinY / cellHeight; y <= (tileMaxY - 1) / cellHeight; ++y)
 		{
-			Vec2 p(x, y);
-			Vec3 bc;
-			if(!computeBarycetrinc(window[0], window[1], window[2], p, bc))
+			for(U x = tileMinX / cellWidth; x <= (tileMaxX - 1) / cellWidth;
+				++x)
 			{
-				F32 z0 = ndc[0].z() / 2.0 + 0.5;
-				F32 z1 = ndc[1].z() / 2.0 + 0.5;
-				F32 z2 = ndc[2].z() / 2.0 + 0.5;
-
-				F32 depth = z0 * bc[0] + z1 * bc[1] + z2 * bc[2];
-				ANKI_ASSERT(depth >= 0.0 && depth <= 1.0);
+				reduceHizCell(level, x, y);
+			}
+		}
+	}
+}
 
-				// Store the min of the current value and new one
-				U32 depthi = depth * MAX_U32;
-				m_zbuffer[U(y) * m_width + U(x)].min(depthi);
+//==============================================================================
+void SoftwareRasterizer::buildTopHiz()
+{
+	for(U level = TILE_HIZ_LEVELS; level < m_hizLevelCount; ++level)
+	{
+		for(U y = 0; y < m_hizHeights[level]; ++y)
+		{
+			for(U x = 0; x < m_hizWidths[level]; ++x)
+			{
+				reduceHizCell(level, x, y);
 			}
 		}
 	}
@@ -325,6 +782,8 @@ Bool SoftwareRasterizer::visibilityTest(
 Bool SoftwareRasterizer::visibilityTestInternal(
 	const CollisionShape& cs, const Aabb& aabb) const
 {
+	ANKI_ASSERT(m_rasterizedTaskCount.get() > 0 && "Nothing rasterized");
+
 	// Set the AABB points
 	const Vec4& minv = aabb.getMin();
 	const Vec4& maxv = aabb.getMax();
@@ -368,14 +827,101 @@ Bool SoftwareRasterizer::visibilityTestInternal(
 		minZ = min(minZ, p.z() / 2.0f + 0.5f);
 	}
 
-	for(U y = bboxMin.y(); y < bboxMax.y(); y += 1.0f)
+	const Array<U32, 4> rect = {{U32(bboxMin.x()),
+		U32(bboxMin.y()),
+		U32(bboxMax.x()),
+		U32(bboxMax.y())}};
+	if(rect[0] >= rect[2] || rect[1] >= rect[3])
+	{
+		return false;
+	}
+
+	// Find the first level that the rectangle touches up to 2x2 cells
+	U level = 0;
+	U cellWidth = BLOCK_WIDTH;
+	U cellHeight = BLOCK_HEIGHT;
+	while(level + 1 < m_hizLevelCount
+		&& ((rect[2] - 1) / cellWidth - rect[0] / cellWidth > 1
+			   || (rect[3] - 1) / cellHeight - rect[1] / cellHeight > 1))
+	{
+		++level;
+		cellWidth *= 2;
+		cellHeight *= 2;
+	}
+
+	U budget = MAX_HIZ_TEST_CELLS;
+	for(U y = rect[1] / cellHeight; y <= (rect[3] - 1) / cellHeight; ++y)
+	{
+		for(U x = rect[0] / cellWidth; x <= (rect[2] - 1) / cellWidth; ++x)
+		{
+			if(visibilityTestCell(level, x, y, rect, minZ, budget))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+//==============================================================================
+Bool SoftwareRasterizer::visibilityTestCell(U level,
+	U cellX,
+	U cellY,
+	const Array<U32, 4>& rect,
+	F32 minZ,
+	U& budget) const
+{
+	ANKI_ASSERT(level < m_hizLevelCount);
+	ANKI_ASSERT(cellX < m_hizWidths[level] && cellY < m_hizHeights[level]);
+
+	const U idx = m_hizOffsets[level] + cellY * m_hizWidths[level] + cellX;
+	if(minZ >= m_hizMax[idx])
+	{
+		// Behind everything in the cell
+		return false;
+	}
+
+	if(minZ < m_hizMin[idx] || budget == 0)
+	{
+		// In front of everything in the cell or it's too expensive to find out
+		return true;
+	}
+
+	--budget;
+
+	// The part of the rectangle inside the cell
+	const U cellWidth = BLOCK_WIDTH << level;
+	const U cellHeight = BLOCK_HEIGHT << level;
+	const U minX = max<U>(rect[0], cellX * cellWidth);
+	const U minY = max<U>(rect[1], cellY * cellHeight);
+	const U maxX = min<U>(rect[2], (cellX + 1) * cellWidth);
+	const U maxY = min<U>(rect[3], (cellY + 1) * cellHeight);
+	ANKI_ASSERT(minX < maxX && minY < maxY);
+
+	if(level == 0)
+	{
+		for(U y = minY; y < maxY; ++y)
+		{
+			for(U x = minX; x < maxX; ++x)
+			{
+				if(minZ < m_zbuffer[y * m_width + x])
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	const U childWidth = cellWidth / 2;
+	const U childHeight = cellHeight / 2;
+	for(U y = minY / childHeight; y <= (maxY - 1) / childHeight; ++y)
 	{
-		for(U x = bboxMin.x(); x < bboxMax.x(); x += 1.0f)
+		for(U x = minX / childWidth; x <= (maxX - 1) / childWidth; ++x)
 		{
-			U idx = U(y) * m_width + U(x);
-			U32 depthi = m_zbuffer[idx].get();
-			F32 depthf = depthi / F32(MAX_U32);
-			if(minZ < depthf)
+			if(visibilityTestCell(level - 1, x, y, rect, minZ, budget))
 			{
 				return true;
 			}
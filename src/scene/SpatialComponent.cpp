@@ -18,12 +18,19 @@ SpatialComponent::SpatialComponent(SceneNode* node, const CollisionShape* shape)
 {
 	ANKI_ASSERT(shape);
 	markForUpdate();
+
+	m_cullingTableIdx =
+		getSceneGraph().getSectorGroup().getCullingTable().newEntry(
+			getSceneGraph().getAllocator(), this);
 }
 
 //==============================================================================
 SpatialComponent::~SpatialComponent()
 {
-	getSceneGraph().getSectorGroup().spatialDeleted(this);
+	SectorGroup& sectors = getSceneGraph().getSectorGroup();
+	sectors.spatialDeleted(this);
+	sectors.getCullingTable().deleteEntry(
+		getSceneGraph().getAllocator(), m_cullingTableIdx);
 }
 
 //==============================================================================
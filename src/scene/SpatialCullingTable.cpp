@@ -0,0 +1,244 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/SpatialCullingTable.h>
+#include <anki/scene/SpatialComponent.h>
+#include <anki/scene/FrustumComponent.h>
+#include <anki/scene/RenderComponent.h>
+#include <anki/scene/LightComponent.h>
+#include <anki/scene/LensFlareComponent.h>
+#include <anki/scene/ReflectionProbeComponent.h>
+#include <anki/scene/ReflectionProxyComponent.h>
+#include <anki/scene/SceneNode.h>
+
+namespace anki
+{
+
+//==============================================================================
+void SpatialCullingTable::destroy(SceneAllocator<U8> alloc)
+{
+	m_centerX.destroy(alloc);
+	m_centerY.destroy(alloc);
+	m_centerZ.destroy(alloc);
+	m_extentX.destroy(alloc);
+	m_extentY.destroy(alloc);
+	m_extentZ.destroy(alloc);
+	m_radius.destroy(alloc);
+	m_flags.destroy(alloc);
+	m_spatials.destroy(alloc);
+	m_freeEntries.destroy(alloc);
+
+	m_freeEntryCount = 0;
+	m_entryCount = 0;
+}
+
+//==============================================================================
+void SpatialCullingTable::grow(SceneAllocator<U8> alloc)
+{
+	const U32 capacity = max<U32>(64, m_flags.getSize() * 2);
+
+	m_centerX.resize(alloc, capacity);
+	m_centerY.resize(alloc, capacity);
+	m_centerZ.resize(alloc, capacity);
+	m_extentX.resize(alloc, capacity);
+	m_extentY.resize(alloc, capacity);
+	m_extentZ.resize(alloc, capacity);
+	m_radius.resize(alloc, capacity);
+	m_flags.resize(alloc, capacity);
+	m_spatials.resize(alloc, capacity);
+}
+
+//==============================================================================
+U32 SpatialCullingTable::newEntry(
+	SceneAllocator<U8> alloc, SpatialComponent* sp)
+{
+	ANKI_ASSERT(sp);
+	LockGuard<SpinLock> lock(m_mtx);
+
+	U32 idx;
+	if(m_freeEntryCount > 0)
+	{
+		idx = m_freeEntries[--m_freeEntryCount];
+	}
+	else
+	{
+		if(m_entryCount == m_flags.getSize())
+		{
+			grow(alloc);
+		}
+
+		idx = m_entryCount++;
+	}
+
+	m_centerX[idx] = m_centerY[idx] = m_centerZ[idx] = 0.0;
+	m_extentX[idx] = m_extentY[idx] = m_extentZ[idx] = 0.0;
+	m_radius[idx] = 0.0;
+	m_flags[idx] = 0;
+	m_spatials[idx] = sp;
+
+	return idx;
+}
+
+//==============================================================================
+void SpatialCullingTable::deleteEntry(SceneAllocator<U8> alloc, U32 idx)
+{
+	LockGuard<SpinLock> lock(m_mtx);
+	ANKI_ASSERT(idx < m_entryCount && m_spatials[idx]);
+
+	// Zero flags will make the tests skip it
+	m_flags[idx] = 0;
+	m_spatials[idx] = nullptr;
+
+	if(m_freeEntryCount == m_freeEntries.getSize())
+	{
+		m_freeEntries.resize(
+			alloc, max<U32>(16, m_freeEntries.getSize() * 2));
+	}
+
+	m_freeEntries[m_freeEntryCount++] = idx;
+}
+
+//==============================================================================
+void SpatialCullingTable::updateEntry(U32 idx)
+{
+	ANKI_ASSERT(idx < m_entryCount && m_spatials[idx]);
+	const SpatialComponent& sp = *m_spatials[idx];
+	U8 flags = 0;
+
+	// What the entry is interesting for
+	const SceneNode& node = sp.getSceneNode();
+
+	const RenderComponent* rc = node.tryGetComponent<RenderComponent>();
+	if(rc)
+	{
+		flags |= U8(FrustumComponentVisibilityTestFlag::RENDER_COMPONENTS);
+
+		if(rc->getCastsShadow())
+		{
+			flags |= U8(FrustumComponentVisibilityTestFlag::SHADOW_CASTERS);
+		}
+	}
+
+	if(node.tryGetComponent<LightComponent>())
+	{
+		flags |= U8(FrustumComponentVisibilityTestFlag::LIGHT_COMPONENTS);
+	}
+
+	if(node.tryGetComponent<LensFlareComponent>())
+	{
+		flags |=
+			U8(FrustumComponentVisibilityTestFlag::LENS_FLARE_COMPONENTS);
+	}
+
+	if(node.tryGetComponent<ReflectionProbeComponent>())
+	{
+		flags |= U8(FrustumComponentVisibilityTestFlag::REFLECTION_PROBES);
+	}
+
+	if(node.tryGetComponent<ReflectionProxyComponent>())
+	{
+		flags |= U8(FrustumComponentVisibilityTestFlag::REFLECTION_PROXIES);
+	}
+
+	setEntry(idx, sp.getSpatialCollisionShape(), sp.getAabb(), flags);
+}
+
+//==============================================================================
+void SpatialCullingTable::setEntry(
+	U32 idx, const CollisionShape& cs, const Aabb& aabb, U8 flags)
+{
+	ANKI_ASSERT(idx < m_entryCount && m_spatials[idx]);
+	ANKI_ASSERT((flags & EXACT_BIT) == 0);
+
+	if(cs.getType() == CollisionShape::Type::SPHERE)
+	{
+		const Sphere& sphere = static_cast<const Sphere&>(cs);
+		m_centerX[idx] = sphere.getCenter().x();
+		m_centerY[idx] = sphere.getCenter().y();
+		m_centerZ[idx] = sphere.getCenter().z();
+		m_extentX[idx] = m_extentY[idx] = m_extentZ[idx] = 0.0;
+		m_radius[idx] = sphere.getRadius();
+
+		flags |= EXACT_BIT;
+	}
+	else
+	{
+		const Vec4 center = (aabb.getMax() + aabb.getMin()) * 0.5;
+		const Vec4 extent = (aabb.getMax() - aabb.getMin()) * 0.5;
+		m_centerX[idx] = center.x();
+		m_centerY[idx] = center.y();
+		m_centerZ[idx] = center.z();
+		m_extentX[idx] = extent.x();
+		m_extentY[idx] = extent.y();
+		m_extentZ[idx] = extent.z();
+		m_radius[idx] = 0.0;
+
+		if(cs.getType() == CollisionShape::Type::AABB)
+		{
+			flags |= EXACT_BIT;
+		}
+	}
+
+	m_flags[idx] = flags;
+}
+
+//==============================================================================
+BatchVolumes SpatialCullingTable::getVolumes() const
+{
+	BatchVolumes volumes;
+	volumes.m_centerX = m_centerX.getBegin();
+	volumes.m_centerY = m_centerY.getBegin();
+	volumes.m_centerZ = m_centerZ.getBegin();
+	volumes.m_extentX = m_extentX.getBegin();
+	volumes.m_extentY = m_extentY.getBegin();
+	volumes.m_extentZ = m_extentZ.getBegin();
+	volumes.m_radius = m_radius.getBegin();
+
+	return volumes;
+}
+
+//==============================================================================
+Bool SpatialCullingTable::insidePlanes(
+	U32 idx, const Plane* planes, U planeCount) const
+{
+	ANKI_ASSERT(idx < m_entryCount);
+	U32 visible;
+	return batchTestPlanesIndexed(
+			   getVolumes(), &idx, 1, planes, planeCount, &visible)
+		== 1;
+}
+
+//==============================================================================
+U32 SpatialCullingTable::test(const U32* indices,
+	U32 count,
+	const Plane* planes,
+	U planeCount,
+	U8 testFlags,
+	U32* visibleIndices) const
+{
+	ANKI_ASSERT((testFlags & EXACT_BIT) == 0);
+
+	// Cull using the flags first. It only needs a byte per entry
+	U32 candidateCount = 0;
+	for(U32 i = 0; i < count; ++i)
+	{
+		const U32 idx = indices[i];
+		ANKI_ASSERT(idx < m_entryCount);
+
+		if(m_flags[idx] & testFlags)
+		{
+			visibleIndices[candidateCount++] = idx;
+		}
+	}
+
+	return batchTestPlanesIndexed(getVolumes(),
+		visibleIndices,
+		candidateCount,
+		planes,
+		planeCount,
+		visibleIndices);
+}
+
+} // end namespace anki
@@ -83,6 +83,7 @@ Error StaticGeometryPatchNode::buildRendering(RenderingBuildInfo& data) const
 {
 	Array<U32, ANKI_GL_MAX_SUB_DRAWCALLS> indicesCountArray;
 	Array<PtrSize, ANKI_GL_MAX_SUB_DRAWCALLS> indicesOffsetArray;
+	U32 baseVertex;
 	U32 drawCount;
 	ResourceGroupPtr grResources;
 	PipelinePtr ppline;
@@ -94,6 +95,7 @@ Error StaticGeometryPatchNode::buildRendering(RenderingBuildInfo& data) const
 		ppline,
 		indicesCountArray,
 		indicesOffsetArray,
+		baseVertex,
 		drawCount);
 
 	data.m_cmdb->bindPipeline(ppline);
@@ -103,8 +105,10 @@ Error StaticGeometryPatchNode::buildRendering(RenderingBuildInfo& data) const
 		data.m_cmdb->bindResourceGroup(
 			grResources, 0, data.m_dynamicBufferInfo);
 
-		data.m_cmdb->drawElements(
-			indicesCountArray[0], 1, indicesOffsetArray[0] / sizeof(U16));
+		data.m_cmdb->drawElements(indicesCountArray[0],
+			1,
+			indicesOffsetArray[0] / sizeof(U16),
+			baseVertex);
 	}
 	else if(drawCount == 0)
 	{
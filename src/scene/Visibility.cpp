@@ -7,6 +7,7 @@
 #include <anki/scene/VisibilityInternal.h>
 #include <anki/scene/SceneGraph.h>
 #include <anki/scene/Sector.h>
+#include <anki/scene/SpatialCullingTable.h>
 #include <anki/scene/FrustumComponent.h>
 #include <anki/scene/LensFlareComponent.h>
 #include <anki/scene/ReflectionProbeComponent.h>
@@ -17,11 +18,153 @@
 #include <anki/renderer/MainRenderer.h>
 #include <anki/util/Logger.h>
 #include <anki/util/ThreadHive.h>
-#include <anki/util/ThreadPool.h>
+#include <anki/util/RadixSort.h>
 
 namespace anki
 {
 
+//==============================================================================
+// Misc                                                                        =
+//==============================================================================
+
+//==============================================================================
+/// Gather the enabled tests of a frustum in a mask for the culling table.
+static U8 computeTestFlags(const FrustumComponent& frc)
+{
+	const U8 allTests =
+		enumToValue(FrustumComponentVisibilityTestFlag::ALL_TESTS);
+	U8 testFlags = 0;
+	for(U bit = 0; bit < 8; ++bit)
+	{
+		const U8 flag = 1 << bit;
+		if((allTests & flag)
+			&& frc.visibilityTestsEnabled(
+				   FrustumComponentVisibilityTestFlag(flag)))
+		{
+			testFlags |= flag;
+		}
+	}
+
+	return testFlags;
+}
+
+//==============================================================================
+static U8 groupBit(VisibilityGroupType type)
+{
+	return 1 << U(type);
+}
+
+//==============================================================================
+/// Fold a 64bit hash to 16 bits.
+static U16 foldHash(U64 hash)
+{
+	const U32 h = U32(hash ^ (hash >> 32));
+	return U16(h ^ (h >> 16));
+}
+
+//==============================================================================
+/// Compute the key that sorts a visible node. The low 32 bits have the
+/// distance. The high ones group the nodes that the drawer can merge or that
+/// share a material.
+static U64 computeSortKey(const VisibleNode& node, Bool groupByMaterial)
+{
+	// The bits of a positive float sort like the float
+	ANKI_ASSERT(node.m_frustumDistanceSquared >= 0.0);
+	U32 distance;
+	memcpy(&distance, &node.m_frustumDistanceSquared, sizeof(distance));
+	U64 key = distance;
+
+	if(groupByMaterial)
+	{
+		const RenderComponent& rc =
+			node.m_node->getComponent<RenderComponent>();
+		U64 hash;
+		if(rc.canBatchDrawcalls(rc))
+		{
+			// Group by material and then by model. The drawer merges the
+			// instances of a model and batches the models of a material
+			hash = (U64(foldHash(ptrToNumber(&rc.getMaterial()))) << 16)
+				| foldHash(rc.getMergeHash());
+		}
+		else
+		{
+			hash = (rc.canMergeDrawcalls(rc)) ? rc.getMergeHash()
+											  : ptrToNumber(&rc.getMaterial());
+		}
+		key |= U64(U32(hash ^ (hash >> 32))) << 32;
+	}
+
+	return key;
+}
+
+//==============================================================================
+/// Sort the groups that the renderer wants sorted.
+static void sortVisibleNodes(
+	SceneFrameAllocator<U8> alloc, VisibilityTestResults& results)
+{
+	Array<VisibilityGroupType, 3> types = {
+		{VisibilityGroupType::RENDERABLES_MS,
+			VisibilityGroupType::RENDERABLES_FS,
+			VisibilityGroupType::REFLECTION_PROBES}};
+
+	for(VisibilityGroupType type : types)
+	{
+		const U count = results.getCount(type);
+		if(count == 0)
+		{
+			continue;
+		}
+
+		// TODO: Reverse the sort of the forward shaded
+		const Bool groupByMaterial =
+			type == VisibilityGroupType::RENDERABLES_MS;
+		U64* keys = alloc.newArray<U64>(count);
+		const VisibleNode* nodes = results.getBegin(type);
+		for(U i = 0; i < count; ++i)
+		{
+			keys[i] = computeSortKey(nodes[i], groupByMaterial);
+		}
+
+		results.sort(alloc, type, keys);
+	}
+}
+
+//==============================================================================
+template<typename T>
+static void growCacheStorage(
+	SceneAllocator<U8> alloc, DynamicArray<T>& arr, U32 count)
+{
+	if(count > arr.getSize())
+	{
+		arr.resize(alloc, max<U32>(count, arr.getSize() * 2));
+	}
+}
+
+//==============================================================================
+// VisibilityCache                                                             =
+//==============================================================================
+
+//==============================================================================
+void VisibilityCache::destroy(SceneAllocator<U8> alloc)
+{
+	m_nodes.destroy(alloc);
+	m_spatialIndices.destroy(alloc);
+	m_entries.destroy(alloc);
+	m_valid = false;
+}
+
+//==============================================================================
+Bool VisibilityCache::canReuse(const FrustumComponent& frc,
+	const SectorGroup& sectors,
+	U8 testFlags) const
+{
+	// It has to be built by the previous run, before any change to the frustum
+	// and to the sectors and portals
+	return m_valid && m_run + 1 == sectors.getVisibilityTestsRun()
+		&& !sectors.getLayoutChanged() && frc.getTimestamp() <= m_timestamp
+		&& m_testFlags == testFlags;
+}
+
 //==============================================================================
 // VisibilityContext                                                           =
 //==============================================================================
@@ -58,6 +201,18 @@ void VisibilityContext::submitNewWork(FrustumComponent& frc, ThreadHive& hive)
 	// Submit new work
 	//
 
+	// Check if the results of the previous tests can be reused. The occlusion
+	// tests depend on the whole scene so they are never cached
+	VisibilityCache* cache = nullptr;
+	Bool reuseCache = false;
+	if(!frc.visibilityTestsEnabled(
+		   FrustumComponentVisibilityTestFlag::OCCLUDERS))
+	{
+		cache = &frc.getVisibilityCache();
+		reuseCache = cache->canReuse(
+			frc, m_scene->getSectorGroup(), computeTestFlags(frc));
+	}
+
 	// Software rasterizer tasks
 	SoftwareRasterizer* r = nullptr;
 	Array<ThreadHiveDependencyHandle, ThreadHive::MAX_THREADS> rasterizeDeps;
@@ -79,8 +234,37 @@ void VisibilityContext::submitNewWork(FrustumComponent& frc, ThreadHive& hive)
 
 		hive.submitTasks(&gatherTask, 1);
 
-		// Rasterize triangles task
+		// Bin triangles tasks
 		U count = hive.getThreadCount();
+		BinTrianglesTask* bin = alloc.newArray<BinTrianglesTask>(count);
+
+		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> binTasks;
+		while(count--)
+		{
+			BinTrianglesTask& b = bin[count];
+			b.m_gatherTask = gather;
+			b.m_taskIdx = count;
+			b.m_taskCount = hive.getThreadCount();
+
+			binTasks[count].m_callback = BinTrianglesTask::callback;
+			binTasks[count].m_argument = &b;
+			binTasks[count].m_inDependencies =
+				WeakArray<ThreadHiveDependencyHandle>(
+					&gatherTask.m_outDependency, 1);
+		}
+
+		count = hive.getThreadCount();
+		hive.submitTasks(&binTasks[0], count);
+
+		WeakArray<ThreadHiveDependencyHandle> binDeps(
+			alloc.newArray<ThreadHiveDependencyHandle>(count), count);
+		while(count--)
+		{
+			binDeps[count] = binTasks[count].m_outDependency;
+		}
+
+		// Rasterize triangles tasks. They need all the bins
+		count = hive.getThreadCount();
 		RasterizeTrianglesTask* rasterize =
 			alloc.newArray<RasterizeTrianglesTask>(count);
 
@@ -94,9 +278,7 @@ void VisibilityContext::submitNewWork(FrustumComponent& frc, ThreadHive& hive)
 
 			rastTasks[count].m_callback = RasterizeTrianglesTask::callback;
 			rastTasks[count].m_argument = &rast;
-			rastTasks[count].m_inDependencies =
-				WeakArray<ThreadHiveDependencyHandle>(
-					&gatherTask.m_outDependency, 1);
+			rastTasks[count].m_inDependencies = binDeps;
 		}
 
 		count = hive.getThreadCount();
@@ -107,25 +289,30 @@ void VisibilityContext::submitNewWork(FrustumComponent& frc, ThreadHive& hive)
 		}
 	}
 
-	// Gather task
-	GatherVisiblesFromSectorsTask* gather =
-		alloc.newInstance<GatherVisiblesFromSectorsTask>();
-	gather->m_visCtx = this;
-	gather->m_frc = &frc;
-	gather->m_r = r;
-
+	// Gather task. Not needed if the cache is reused
+	GatherVisiblesFromSectorsTask* gather = nullptr;
 	ThreadHiveTask gatherTask;
-	gatherTask.m_callback = GatherVisiblesFromSectorsTask::callback;
-	gatherTask.m_argument = gather;
-	if(r)
+	if(!reuseCache)
 	{
-		gatherTask.m_inDependencies = WeakArray<ThreadHiveDependencyHandle>(
-			&rasterizeDeps[0], hive.getThreadCount());
-	}
+		gather = alloc.newInstance<GatherVisiblesFromSectorsTask>();
+		gather->m_visCtx = this;
+		gather->m_frc = &frc;
+		gather->m_r = r;
 
-	hive.submitTasks(&gatherTask, 1);
+		gatherTask.m_callback = GatherVisiblesFromSectorsTask::callback;
+		gatherTask.m_argument = gather;
+		if(r)
+		{
+			gatherTask.m_inDependencies =
+				WeakArray<ThreadHiveDependencyHandle>(
+					&rasterizeDeps[0], hive.getThreadCount());
+		}
+
+		hive.submitTasks(&gatherTask, 1);
+	}
 
 	// Test tasks
+	const U32 testIdx = m_testsCount.fetchAdd(1);
 	U testCount = hive.getThreadCount();
 	WeakArray<VisibilityTestTask> tests(
 		alloc.newArray<VisibilityTestTask>(testCount), testCount);
@@ -137,15 +324,21 @@ void VisibilityContext::submitNewWork(FrustumComponent& frc, ThreadHive& hive)
 		auto& test = tests[i];
 		test.m_visCtx = this;
 		test.m_frc = &frc;
-		test.m_sectorsCtx = &gather->m_sectorsCtx;
+		test.m_sectorsCtx = (gather) ? &gather->m_sectorsCtx : nullptr;
 		test.m_taskIdx = i;
 		test.m_taskCount = testCount;
+		test.m_testIdx = testIdx;
+		test.m_cache = cache;
+		test.m_reuseCache = reuseCache;
 
 		auto& task = testTasks[i];
 		task.m_callback = VisibilityTestTask::callback;
 		task.m_argument = &test;
-		task.m_inDependencies = WeakArray<ThreadHiveDependencyHandle>(
-			&gatherTask.m_outDependency, 1);
+		if(gather)
+		{
+			task.m_inDependencies = WeakArray<ThreadHiveDependencyHandle>(
+				&gatherTask.m_outDependency, 1);
+		}
 	}
 
 	hive.submitTasks(&testTasks[0], testCount);
@@ -205,34 +398,50 @@ void GatherVisibleTrianglesTask::gather()
 		}
 	});
 
+	SceneGraph& scene = *m_visCtx->m_scene;
 	m_r.init(alloc);
-	m_r.prepare(m_frc->getViewMatrix(), m_frc->getProjectionMatrix(), 80, 50);
+	m_r.prepare(m_frc->getViewMatrix(),
+		m_frc->getProjectionMatrix(),
+		scene.getOcclusionRasterizerWidth(),
+		scene.getOcclusionRasterizerHeight(),
+		scene.getThreadHive().getThreadCount());
 
 	ANKI_TRACE_STOP_EVENT(SCENE_VISIBILITY_GATHER_TRIANGLES);
 }
 
 //==============================================================================
-// RasterizeTrianglesTask                                                      =
+// BinTrianglesTask                                                            =
 //==============================================================================
 
 //==============================================================================
-void RasterizeTrianglesTask::rasterize()
+void BinTrianglesTask::bin()
 {
-	ANKI_TRACE_START_EVENT(SCENE_VISIBILITY_RASTERIZE);
+	ANKI_TRACE_START_EVENT(SCENE_VISIBILITY_BIN_TRIANGLES);
 
 	PtrSize start, end;
-	ThreadPoolTask::choseStartEnd(
+	splitThreadedProblem(
 		m_taskIdx, m_taskCount, m_gatherTask->m_vertCount / 3, start, end);
 
-	if(start != end)
-	{
-		const Vec3* first = &m_gatherTask->m_verts[start * 3];
-		U count = (end - start) * 3;
-		ANKI_ASSERT(count <= m_gatherTask->m_vertCount);
+	// Bin even if there is nothing to bin to reset the binner
+	const Vec3* first = m_gatherTask->m_verts.getBegin() + start * 3;
+	U count = (end - start) * 3;
+	ANKI_ASSERT(count <= m_gatherTask->m_vertCount);
 
-		m_gatherTask->m_r.draw(&first[0][0], count, sizeof(Vec3));
-	}
+	m_gatherTask->m_r.binTriangles(
+		m_taskIdx, &first[0][0], count, sizeof(Vec3));
+
+	ANKI_TRACE_STOP_EVENT(SCENE_VISIBILITY_BIN_TRIANGLES);
+}
+
+//==============================================================================
+// RasterizeTrianglesTask                                                      =
+//==============================================================================
 
+//==============================================================================
+void RasterizeTrianglesTask::rasterize()
+{
+	ANKI_TRACE_START_EVENT(SCENE_VISIBILITY_RASTERIZE);
+	m_gatherTask->m_r.rasterizeTiles(m_taskIdx, m_taskCount);
 	ANKI_TRACE_STOP_EVENT(SCENE_VISIBILITY_RASTERIZE);
 }
 
@@ -250,6 +459,8 @@ void VisibilityTestTask::test(ThreadHive& hive)
 
 	SceneNode& testedNode = testedFrc.getSceneNode();
 	auto alloc = m_visCtx->m_scene->getFrameAllocator();
+	const SpatialCullingTable& table =
+		m_visCtx->m_scene->getSectorGroup().getCullingTable();
 
 	// Init test results
 	VisibilityTestResults* visible = alloc.newInstance<VisibilityTestResults>();
@@ -274,21 +485,61 @@ void VisibilityTestTask::test(ThreadHive& hive)
 	Bool wantsReflectionProxies = testedFrc.visibilityTestsEnabled(
 		FrustumComponentVisibilityTestFlag::REFLECTION_PROXIES);
 
-	// Chose the test range and a few other things
-	PtrSize start, end;
-	ThreadPoolTask::choseStartEnd(m_taskIdx,
-		m_taskCount,
-		m_sectorsCtx->getVisibleSceneNodeCount(),
-		start,
-		end);
+	const U8 testFlags = computeTestFlags(testedFrc);
+	const auto& planes = testedFrc.getFrustum().getPlanesWorldSpace();
+
+	// Add a visible node to the results
+	auto acceptNode = [&](SceneNode& node,
+		const VisibleNode& visibleNode,
+		U8 groupMask,
+		const U32* entries,
+		U entryCount) {
+		VisibleNode tmp;
+		for(VisibilityGroupType t = VisibilityGroupType::FIRST;
+			t < VisibilityGroupType::TYPE_COUNT;
+			++t)
+		{
+			if(groupMask & groupBit(t))
+			{
+				tmp = visibleNode;
+				visible->moveBack(alloc, t, tmp);
+			}
+		}
+
+		const U8 renderables = groupBit(VisibilityGroupType::RENDERABLES_MS)
+			| groupBit(VisibilityGroupType::RENDERABLES_FS);
+		if(wantsShadowCasters && (groupMask & renderables))
+		{
+			updateTimestamp(node);
+		}
+
+		// Add more frustums to the list
+		Error err = node.iterateComponentsOfType<FrustumComponent>(
+			[&](FrustumComponent& frc) {
+				m_visCtx->submitNewWork(frc, hive);
+				return ErrorCode::NONE;
+			});
+		(void)err;
 
-	m_sectorsCtx->iterateVisibleSceneNodes(start, end, [&](SceneNode& node) {
+		if(m_cache)
+		{
+			recordForCache(visibleNode, entries, entryCount, groupMask);
+		}
+	};
+
+	auto testNode = [&](SceneNode& node) {
 		// Skip if it is the same
 		if(ANKI_UNLIKELY(&testedNode == &node))
 		{
 			return;
 		}
 
+		// A node with more than one spatials might have been visited already
+		if(node.fetchSetSectorVisited(m_testIdx, true))
+		{
+			return;
+		}
+
 		// Check what components the frustum needs
 		Bool wantNode = false;
 
@@ -343,12 +594,17 @@ void VisibilityTestTask::test(ThreadHive& hive)
 			Vec4 m_origin;
 		};
 		Array<SpatialTemp, ANKI_GL_MAX_SUB_DRAWCALLS> sps;
+		Array<U32, ANKI_GL_MAX_SUB_DRAWCALLS> entries;
 
 		U spIdx = 0;
 		U count = 0;
 		Error err = node.iterateComponentsOfType<SpatialComponent>(
 			[&](SpatialComponent& sp) {
-				if(testedFrc.insideFrustum(sp))
+				const U32 idx = sp.getCullingTableIndex();
+				entries[spIdx] = idx;
+
+				if(table.insidePlanes(idx, &planes[0], planes.getSize())
+					&& (table.isExact(idx) || testedFrc.insideFrustum(sp)))
 				{
 					// Inside
 					ANKI_ASSERT(spIdx < MAX_U8);
@@ -400,72 +656,163 @@ void VisibilityTestTask::test(ThreadHive& hive)
 			visibleNode.m_spatialIndices[i] = sps[i].m_idx;
 		}
 
-		if(rc)
+		// Find the groups the node goes to
+		U8 groupMask = 0;
+		if(rc
+			&& (wantsRenderComponents
+				   || (wantsShadowCasters && rc->getCastsShadow())))
 		{
-			if(wantsRenderComponents
-				|| (wantsShadowCasters && rc->getCastsShadow()))
-			{
-				visible->moveBack(alloc,
-					rc->getMaterial().getForwardShading()
-						? VisibilityGroupType::RENDERABLES_FS
-						: VisibilityGroupType::RENDERABLES_MS,
-					visibleNode);
-
-				if(wantsShadowCasters)
-				{
-					updateTimestamp(node);
-				}
-			}
+			groupMask |= groupBit(rc->getMaterial().getForwardShading()
+					? VisibilityGroupType::RENDERABLES_FS
+					: VisibilityGroupType::RENDERABLES_MS);
 		}
 
 		if(lc && wantsLightComponents)
 		{
-			VisibilityGroupType gt;
 			switch(lc->getLightType())
 			{
 			case LightComponent::LightType::POINT:
-				gt = VisibilityGroupType::LIGHTS_POINT;
+				groupMask |= groupBit(VisibilityGroupType::LIGHTS_POINT);
 				break;
 			case LightComponent::LightType::SPOT:
-				gt = VisibilityGroupType::LIGHTS_SPOT;
+				groupMask |= groupBit(VisibilityGroupType::LIGHTS_SPOT);
 				break;
 			default:
 				ANKI_ASSERT(0);
-				gt = VisibilityGroupType::TYPE_COUNT;
 			}
-
-			visible->moveBack(alloc, gt, visibleNode);
 		}
 
 		if(lfc && wantsFlareComponents)
 		{
-			visible->moveBack(alloc, VisibilityGroupType::FLARES, visibleNode);
+			groupMask |= groupBit(VisibilityGroupType::FLARES);
 		}
 
 		if(reflc && wantsReflectionProbes)
 		{
-			visible->moveBack(
-				alloc, VisibilityGroupType::REFLECTION_PROBES, visibleNode);
+			groupMask |= groupBit(VisibilityGroupType::REFLECTION_PROBES);
 		}
 
 		if(proxyc && wantsReflectionProxies)
 		{
-			visible->moveBack(
-				alloc, VisibilityGroupType::REFLECTION_PROXIES, visibleNode);
+			groupMask |= groupBit(VisibilityGroupType::REFLECTION_PROXIES);
 		}
 
-		// Add more frustums to the list
-		err = node.iterateComponentsOfType<FrustumComponent>(
-			[&](FrustumComponent& frc) {
-				m_visCtx->submitNewWork(frc, hive);
-				return ErrorCode::NONE;
-			});
-		(void)err;
-	}); // end for
+		acceptNode(node, visibleNode, groupMask, &entries[0], spIdx);
+	};
+
+	// Cull some entries using only the culling table. Touch the nodes that
+	// pass
+	auto testEntries = [&](const U32* indices, U indexCount) {
+		if(indexCount == 0)
+		{
+			return;
+		}
+
+		U32* candidates = alloc.newArray<U32>(indexCount);
+		const U32 candidateCount = table.test(indices,
+			indexCount,
+			&planes[0],
+			planes.getSize(),
+			testFlags,
+			candidates);
+
+		for(U32 i = 0; i < candidateCount; ++i)
+		{
+			testNode(table.getSpatial(candidates[i]).getSceneNode());
+		}
+	};
+
+	PtrSize start, end;
+	if(m_reuseCache)
+	{
+		const SectorGroup& sectors = m_visCtx->m_scene->getSectorGroup();
+		const VisibilityCache& cache = *m_cache;
+
+		// Replay the cached nodes. Nodes with dirty spatials are tested again
+		// as a whole since their clean spatials might still be visible
+		splitThreadedProblem(
+			m_taskIdx, m_taskCount, cache.m_nodeCount, start, end);
+
+		for(PtrSize i = start; i < end; ++i)
+		{
+			const VisibilityCache::Node& cached = cache.m_nodes[i];
+			const U32* entries = &cache.m_entries[cached.m_firstEntry];
+
+			Bool dirty = false;
+			for(U j = 0; j < cached.m_entryCount && !dirty; ++j)
+			{
+				dirty = sectors.isSpatialDirty(entries[j]);
+			}
+
+			SceneNode& node = *cached.m_node;
+			if(dirty)
+			{
+				testNode(node);
+				continue;
+			}
+
+			if(node.fetchSetSectorVisited(m_testIdx, true))
+			{
+				continue;
+			}
+
+			VisibleNode visibleNode;
+			visibleNode.m_node = &node;
+			visibleNode.m_frustumDistanceSquared =
+				cached.m_frustumDistanceSquared;
+			visibleNode.m_spatialsCount = cached.m_spatialCount;
+			visibleNode.m_spatialIndices =
+				alloc.newArray<U8>(cached.m_spatialCount);
+			memcpy(visibleNode.m_spatialIndices,
+				&cache.m_spatialIndices[cached.m_firstSpatialIndex],
+				cached.m_spatialCount);
+
+			// The visible spatials didn't move so they are still visible
+			U spIdx = 0;
+			Error err = node.iterateComponentsOfType<SpatialComponent>(
+				[&](SpatialComponent& sp) {
+					for(U j = 0; j < cached.m_spatialCount; ++j)
+					{
+						if(visibleNode.m_spatialIndices[j] == spIdx)
+						{
+							sp.setVisibleByCamera(true);
+							break;
+						}
+					}
+
+					++spIdx;
+					return ErrorCode::NONE;
+				});
+			(void)err;
+
+			acceptNode(node,
+				visibleNode,
+				cached.m_groupMask,
+				entries,
+				cached.m_entryCount);
+		}
+
+		// Test the dirty spatials. They might have entered the frustum
+		const WeakArray<U32>& dirty = sectors.getDirtySpatials();
+		splitThreadedProblem(
+			m_taskIdx, m_taskCount, dirty.getSize(), start, end);
+		testEntries(dirty.getBegin() + start, end - start);
+	}
+	else
+	{
+		splitThreadedProblem(m_taskIdx,
+			m_taskCount,
+			m_sectorsCtx->getVisibleSpatialCount(),
+			start,
+			end);
+		testEntries(m_sectorsCtx->getVisibleSpatials() + start, end - start);
+	}
+
+	// Sort the slice of this task. CombineResultsTask will merge the slices
+	sortVisibleNodes(alloc, *visible);
 
 	ANKI_TRACE_STOP_EVENT(SCENE_VISIBILITY_TEST);
 }
-
 //==============================================================================
 void VisibilityTestTask::updateTimestamp(const SceneNode& node)
 {
@@ -492,28 +839,52 @@ void VisibilityTestTask::updateTimestamp(const SceneNode& node)
 	m_timestamp = max(m_timestamp, lastUpdate);
 }
 
+//==============================================================================
+void VisibilityTestTask::recordForCache(const VisibleNode& visibleNode,
+	const U32* entries,
+	U entryCount,
+	U8 groupMask)
+{
+	auto alloc = m_visCtx->m_scene->getFrameAllocator();
+
+	if(m_cacheRecordCount + 1 > m_cacheRecords.getSize())
+	{
+		m_cacheRecords.resize(
+			alloc, max<U32>(16, m_cacheRecords.getSize() * 2));
+	}
+
+	CacheRecord& record = m_cacheRecords[m_cacheRecordCount++];
+	record.m_visibleNode = visibleNode;
+	record.m_entries = alloc.newArray<U32>(entryCount);
+	memcpy(record.m_entries, entries, sizeof(U32) * entryCount);
+	ANKI_ASSERT(entryCount < MAX_U8);
+	record.m_entryCount = entryCount;
+	record.m_groupMask = groupMask;
+}
+
 //==============================================================================
 // CombineResultsTask                                                          =
 //==============================================================================
 
 //==============================================================================
-void CombineResultsTask::combine()
+void CombineResultsTask::combine(ThreadHive& hive)
 {
 	ANKI_TRACE_START_EVENT(SCENE_VISIBILITY_COMBINE_RESULTS);
 
 	auto alloc = m_visCtx->m_scene->getFrameAllocator();
 
-	// Prepare
-	Array<VisibilityTestResults*, 32> rezArr;
+	// Prepare. The merge tasks will need the results after this task is done
+	const U resultCount = m_tests.getSize();
+	ANKI_ASSERT(resultCount <= VisibilityTestResults::MAX_MERGE_RESULTS);
+	WeakArray<VisibilityTestResults*> rez(
+		alloc.newArray<VisibilityTestResults*>(resultCount), resultCount);
 	Timestamp timestamp = 0;
-	for(U i = 0; i < m_tests.getSize(); ++i)
+	for(U i = 0; i < resultCount; ++i)
 	{
-		rezArr[i] = m_tests[i].m_result;
+		rez[i] = m_tests[i].m_result;
 		timestamp = max(timestamp, m_tests[i].m_timestamp);
 	}
 
-	WeakArray<VisibilityTestResults*> rez(&rezArr[0], m_tests.getSize());
-
 	// Create the new combined results
 	VisibilityTestResults* visible = alloc.newInstance<VisibilityTestResults>();
 	visible->combineWith(alloc, rez);
@@ -522,24 +893,122 @@ void CombineResultsTask::combine()
 	// Set the frustumable
 	m_frc->setVisibilityTestResults(visible);
 
-	// Sort some of the arrays
-	DistanceSortFunctor comp;
-	std::sort(visible->getBegin(VisibilityGroupType::RENDERABLES_MS),
-		visible->getEnd(VisibilityGroupType::RENDERABLES_MS),
-		comp);
+	// Merge the sorted groups. The big ones are split to parts that are
+	// merged in parallel
+	for(VisibilityGroupType t = VisibilityGroupType::FIRST;
+		t < VisibilityGroupType::TYPE_COUNT;
+		++t)
+	{
+		if(!visible->needsMerge(t))
+		{
+			continue;
+		}
 
-	// TODO: Reverse the sort
-	std::sort(visible->getBegin(VisibilityGroupType::RENDERABLES_FS),
-		visible->getEnd(VisibilityGroupType::RENDERABLES_FS),
-		comp);
+		const U partCount = min<U>(hive.getThreadCount(),
+			max<U>(1, visible->getCount(t) / MIN_NODES_PER_MERGE));
 
-	std::sort(visible->getBegin(VisibilityGroupType::REFLECTION_PROBES),
-		visible->getEnd(VisibilityGroupType::REFLECTION_PROBES),
-		comp);
+		if(partCount == 1)
+		{
+			visible->mergeSorted(t, rez, 0, 1);
+			continue;
+		}
+
+		MergeResultsTask* merges =
+			alloc.newArray<MergeResultsTask>(partCount);
+		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> tasks;
+		for(U i = 0; i < partCount; ++i)
+		{
+			MergeResultsTask& merge = merges[i];
+			merge.m_visible = visible;
+			merge.m_results = rez;
+			merge.m_type = t;
+			merge.m_partIdx = i;
+			merge.m_partCount = partCount;
+
+			tasks[i].m_callback = MergeResultsTask::callback;
+			tasks[i].m_argument = &merge;
+		}
+
+		hive.submitTasks(&tasks[0], partCount);
+	}
+
+	if(m_tests[0].m_cache)
+	{
+		updateCache();
+	}
 
 	ANKI_TRACE_STOP_EVENT(SCENE_VISIBILITY_COMBINE_RESULTS);
 }
 
+//==============================================================================
+void CombineResultsTask::updateCache()
+{
+	VisibilityCache& cache = *m_tests[0].m_cache;
+	auto alloc = m_visCtx->m_scene->getAllocator();
+
+	// Count and grow the storage. It never shrinks
+	U32 nodeCount = 0;
+	U32 spatialIndexCount = 0;
+	U32 entryCount = 0;
+	for(const VisibilityTestTask& test : m_tests)
+	{
+		for(U i = 0; i < test.m_cacheRecordCount; ++i)
+		{
+			const VisibilityTestTask::CacheRecord& record =
+				test.m_cacheRecords[i];
+			++nodeCount;
+			spatialIndexCount += record.m_visibleNode.m_spatialsCount;
+			entryCount += record.m_entryCount;
+		}
+	}
+
+	growCacheStorage(alloc, cache.m_nodes, nodeCount);
+	growCacheStorage(alloc, cache.m_spatialIndices, spatialIndexCount);
+	growCacheStorage(alloc, cache.m_entries, entryCount);
+
+	// Copy
+	cache.m_nodeCount = 0;
+	cache.m_spatialIndexCount = 0;
+	cache.m_entryCount = 0;
+	for(const VisibilityTestTask& test : m_tests)
+	{
+		for(U i = 0; i < test.m_cacheRecordCount; ++i)
+		{
+			const VisibilityTestTask::CacheRecord& record =
+				test.m_cacheRecords[i];
+			const VisibleNode& visibleNode = record.m_visibleNode;
+
+			VisibilityCache::Node& node = cache.m_nodes[cache.m_nodeCount++];
+			node.m_node = visibleNode.m_node;
+			node.m_frustumDistanceSquared =
+				visibleNode.m_frustumDistanceSquared;
+			node.m_firstSpatialIndex = cache.m_spatialIndexCount;
+			node.m_firstEntry = cache.m_entryCount;
+			node.m_spatialCount = visibleNode.m_spatialsCount;
+			node.m_entryCount = record.m_entryCount;
+			node.m_groupMask = record.m_groupMask;
+
+			if(visibleNode.m_spatialsCount)
+			{
+				memcpy(&cache.m_spatialIndices[cache.m_spatialIndexCount],
+					visibleNode.m_spatialIndices,
+					visibleNode.m_spatialsCount);
+				cache.m_spatialIndexCount += visibleNode.m_spatialsCount;
+			}
+
+			memcpy(&cache.m_entries[cache.m_entryCount],
+				record.m_entries,
+				sizeof(U32) * record.m_entryCount);
+			cache.m_entryCount += record.m_entryCount;
+		}
+	}
+
+	cache.m_run = m_visCtx->m_scene->getSectorGroup().getVisibilityTestsRun();
+	cache.m_timestamp = m_visCtx->m_scene->getGlobalTimestamp();
+	cache.m_testFlags = computeTestFlags(*m_frc);
+	cache.m_valid = true;
+}
+
 //==============================================================================
 // VisibilityTestResults                                                       =
 //==============================================================================
@@ -569,6 +1038,40 @@ void VisibilityTestResults::moveBack(
 	group.m_nodes[group.m_count++] = x;
 }
 
+//==============================================================================
+void VisibilityTestResults::sort(
+	SceneFrameAllocator<U8> alloc, VisibilityGroupType type, U64* keys)
+{
+	Group& group = m_groups[type];
+	const U count = group.m_count;
+	if(count == 0)
+	{
+		return;
+	}
+
+	U32* indices = alloc.newArray<U32>(count);
+	for(U i = 0; i < count; ++i)
+	{
+		indices[i] = i;
+	}
+
+	U64* tmpKeys = alloc.newArray<U64>(count);
+	U32* tmpIndices = alloc.newArray<U32>(count);
+	radixSort(keys, indices, count, tmpKeys, tmpIndices);
+
+	// Reorder the nodes
+	Container sorted;
+	sorted.create(alloc, count);
+	for(U i = 0; i < count; ++i)
+	{
+		sorted[i] = group.m_nodes[indices[i]];
+	}
+
+	group.m_nodes.destroy(alloc);
+	group.m_nodes = std::move(sorted);
+	group.m_keys = keys;
+}
+
 //==============================================================================
 void VisibilityTestResults::combineWith(
 	SceneFrameAllocator<U8> alloc, WeakArray<VisibilityTestResults*>& results)
@@ -591,7 +1094,7 @@ void VisibilityTestResults::combineWith(
 		}
 	}
 
-	// Allocate
+	// Allocate. The groups that are sorted everywhere will be merged later
 	for(VisibilityGroupType t = VisibilityGroupType::FIRST;
 		t < VisibilityGroupType::TYPE_COUNT;
 		++t)
@@ -600,6 +1103,15 @@ void VisibilityTestResults::combineWith(
 		{
 			m_groups[t].m_nodes.create(alloc, counts[t]);
 			m_groups[t].m_count = counts[t];
+
+			Bool sorted = true;
+			for(U i = 0; i < results.getSize() && sorted; ++i)
+			{
+				const Group& group = results[i]->m_groups[t];
+				sorted = group.m_count == 0 || group.m_keys != nullptr;
+			}
+
+			m_groups[t].m_needsMerge = sorted;
 		}
 	}
 
@@ -614,7 +1126,7 @@ void VisibilityTestResults::combineWith(
 			++t)
 		{
 			U copyCount = rez.m_groups[t].m_count;
-			if(copyCount > 0)
+			if(copyCount > 0 && !m_groups[t].m_needsMerge)
 			{
 				memcpy(&m_groups[t].m_nodes[0] + counts[t],
 					&rez.m_groups[t].m_nodes[0],
@@ -626,6 +1138,88 @@ void VisibilityTestResults::combineWith(
 	}
 }
 
+//==============================================================================
+void VisibilityTestResults::mergeSorted(VisibilityGroupType type,
+	const WeakArray<VisibilityTestResults*>& results,
+	U partIdx,
+	U partCount)
+{
+	Group& out = m_groups[type];
+	ANKI_ASSERT(out.m_needsMerge);
+	ANKI_ASSERT(partIdx < partCount);
+	const U resultCount = results.getSize();
+	ANKI_ASSERT(resultCount <= MAX_MERGE_RESULTS);
+
+	// The keys that split the parts are picked from the biggest result. A
+	// part gets the nodes with keys from its splitter up to the next
+	U biggest = 0;
+	for(U i = 1; i < resultCount; ++i)
+	{
+		if(results[i]->m_groups[type].m_count
+			> results[biggest]->m_groups[type].m_count)
+		{
+			biggest = i;
+		}
+	}
+
+	const Group& biggestGroup = results[biggest]->m_groups[type];
+	auto findSplit = [&](const Group& group, U part) -> U32 {
+		if(part == 0)
+		{
+			return 0;
+		}
+		else if(part == partCount)
+		{
+			return group.m_count;
+		}
+
+		const U64 splitter =
+			biggestGroup.m_keys[biggestGroup.m_count * part / partCount];
+		return std::lower_bound(
+				   group.m_keys, group.m_keys + group.m_count, splitter)
+			- group.m_keys;
+	};
+
+	// Find the range of every result and where the part starts
+	Array<U32, MAX_MERGE_RESULTS> begins;
+	Array<U32, MAX_MERGE_RESULTS> ends;
+	U outIdx = 0;
+	for(U i = 0; i < resultCount; ++i)
+	{
+		const Group& group = results[i]->m_groups[type];
+		begins[i] = findSplit(group, partIdx);
+		ends[i] = findSplit(group, partIdx + 1);
+		outIdx += begins[i];
+	}
+
+	// K-way merge. The ties go to the first result
+	while(true)
+	{
+		U best = MAX_U32;
+		U64 bestKey = 0;
+		for(U i = 0; i < resultCount; ++i)
+		{
+			if(begins[i] < ends[i])
+			{
+				const U64 key = results[i]->m_groups[type].m_keys[begins[i]];
+				if(best == MAX_U32 || key < bestKey)
+				{
+					best = i;
+					bestKey = key;
+				}
+			}
+		}
+
+		if(best == MAX_U32)
+		{
+			break;
+		}
+
+		out.m_nodes[outIdx++] =
+			results[best]->m_groups[type].m_nodes[begins[best]++];
+	}
+}
+
 //==============================================================================
 // doVisibilityTests                                                           =
 //==============================================================================
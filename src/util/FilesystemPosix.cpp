@@ -9,10 +9,14 @@
 #include <cstring>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <dirent.h>
 #include <cerrno>
 #include <fts.h> // For walkDirectoryTree
 #include <cstdlib>
+#include <cstdio> // For rename
 
 // Define PATH_MAX if needed
 #ifndef PATH_MAX
@@ -115,12 +119,9 @@ Error walkDirectoryTree(
 }
 
 //==============================================================================
-// To avoid having the g_removeDirectoryPath in stack or having to allocate it,
-// make it global.
-static char g_removeDirectoryPath[PATH_MAX];
-Mutex g_removeDirectoryLock;
-
-Error removeDirectory(const CString& dirname)
+/// Recursive part of removeDirectory. Every level keeps its own path since the
+/// levels below overwrite theirs.
+static Error removeDirectoryInternal(const CString& dirname)
 {
 	DIR* dir;
 	struct dirent* entry;
@@ -132,12 +133,13 @@ Error removeDirectory(const CString& dirname)
 		return ErrorCode::FUNCTION_FAILED;
 	}
 
-	LockGuard<Mutex> lock(g_removeDirectoryLock);
-	while((entry = readdir(dir)) != nullptr)
+	Error err = ErrorCode::NONE;
+	char path[PATH_MAX];
+	while(!err && (entry = readdir(dir)) != nullptr)
 	{
 		if(strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
 		{
-			std::snprintf(g_removeDirectoryPath,
+			std::snprintf(path,
 				size_t(PATH_MAX),
 				"%s/%s",
 				dirname.get(),
@@ -145,23 +147,31 @@ Error removeDirectory(const CString& dirname)
 
 			if(entry->d_type == DT_DIR)
 			{
-				Error err = removeDirectory(CString(g_removeDirectoryPath));
-				if(err)
-				{
-					return err;
-				}
+				err = removeDirectoryInternal(CString(path));
 			}
 			else
 			{
-				remove(g_removeDirectoryPath);
+				remove(path);
 			}
 		}
 	}
 
 	closedir(dir);
-	remove(dirname.get());
+	if(!err)
+	{
+		remove(dirname.get());
+	}
 
-	return ErrorCode::NONE;
+	return err;
+}
+
+// readdir() is not reentrant so serialize the removals.
+static Mutex g_removeDirectoryLock;
+
+Error removeDirectory(const CString& dirname)
+{
+	LockGuard<Mutex> lock(g_removeDirectoryLock);
+	return removeDirectoryInternal(dirname);
 }
 
 //==============================================================================
@@ -182,6 +192,69 @@ Error createDirectory(const CString& dir)
 	return err;
 }
 
+//==============================================================================
+Error renameFile(const CString& oldName, const CString& newName)
+{
+	Error err = ErrorCode::NONE;
+	if(rename(oldName.get(), newName.get()))
+	{
+		ANKI_LOGE("%s : %s", strerror(errno), oldName.get());
+		err = ErrorCode::FUNCTION_FAILED;
+	}
+
+	return err;
+}
+
+//==============================================================================
+Error mapFile(const CString& filename, const U8*& data, PtrSize& size)
+{
+	int fd = open(filename.get(), O_RDONLY);
+	if(fd < 0)
+	{
+		ANKI_LOGE("%s : %s", strerror(errno), filename.get());
+		return ErrorCode::FILE_ACCESS;
+	}
+
+	Error err = ErrorCode::NONE;
+	struct stat s;
+	if(fstat(fd, &s) != 0)
+	{
+		ANKI_LOGE("%s : %s", strerror(errno), filename.get());
+		err = ErrorCode::FILE_ACCESS;
+	}
+
+	data = nullptr;
+	size = 0;
+	if(!err && s.st_size > 0)
+	{
+		void* mem = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mem == MAP_FAILED)
+		{
+			ANKI_LOGE("%s : %s", strerror(errno), filename.get());
+			err = ErrorCode::FILE_ACCESS;
+		}
+		else
+		{
+			data = static_cast<const U8*>(mem);
+			size = s.st_size;
+		}
+	}
+
+	// The mapping keeps the file open
+	close(fd);
+	return err;
+}
+
+//==============================================================================
+void unmapFile(const U8* data, PtrSize size)
+{
+	if(data)
+	{
+		ANKI_ASSERT(size > 0);
+		munmap(const_cast<U8*>(data), size);
+	}
+}
+
 //==============================================================================
 Error getHomeDirectory(GenericMemoryPoolAllocator<U8> alloc, String& out)
 {
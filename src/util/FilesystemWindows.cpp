@@ -84,6 +84,86 @@ Error createDirectory(const CString& dir)
 	return err;
 }
 
+//==============================================================================
+Error renameFile(const CString& oldName, const CString& newName)
+{
+	Error err = ErrorCode::NONE;
+	if(MoveFileEx(oldName.get(), newName.get(), MOVEFILE_REPLACE_EXISTING)
+		== 0)
+	{
+		ANKI_LOGE("Failed to rename file %s", oldName.get());
+		err = ErrorCode::FUNCTION_FAILED;
+	}
+
+	return err;
+}
+
+//==============================================================================
+Error mapFile(const CString& filename, const U8*& data, PtrSize& size)
+{
+	HANDLE file = CreateFile(&filename[0],
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		ANKI_LOGE("CreateFile() failed: %s", &filename[0]);
+		return ErrorCode::FILE_ACCESS;
+	}
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize))
+	{
+		ANKI_LOGE("GetFileSizeEx() failed: %s", &filename[0]);
+		CloseHandle(file);
+		return ErrorCode::FILE_ACCESS;
+	}
+
+	// Empty files can't be mapped
+	data = nullptr;
+	size = 0;
+	if(fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return ErrorCode::NONE;
+	}
+
+	HANDLE mapping =
+		CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if(mapping == nullptr)
+	{
+		ANKI_LOGE("CreateFileMapping() failed: %s", &filename[0]);
+		return ErrorCode::FILE_ACCESS;
+	}
+
+	// The view keeps the mapping alive
+	void* mem = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if(mem == nullptr)
+	{
+		ANKI_LOGE("MapViewOfFile() failed: %s", &filename[0]);
+		return ErrorCode::FILE_ACCESS;
+	}
+
+	data = static_cast<const U8*>(mem);
+	size = fileSize.QuadPart;
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+void unmapFile(const U8* data, PtrSize size)
+{
+	if(data)
+	{
+		ANKI_ASSERT(size > 0);
+		UnmapViewOfFile(data);
+	}
+}
+
 //==============================================================================
 Error getHomeDirectory(GenericMemoryPoolAllocator<U8> alloc, String& out)
 {
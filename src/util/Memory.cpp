@@ -49,6 +49,21 @@ static void invalidateMemory(TPtr ptr, TSize size)
 #endif
 }
 
+/// Get a number that is unique for every thread. The pools use it to pick a
+/// thread slot.
+static U32 getThreadIndex()
+{
+	static Atomic<U32> threadCount = {0};
+	static thread_local U32 idx = MAX_U32;
+
+	if(ANKI_UNLIKELY(idx == MAX_U32))
+	{
+		idx = threadCount.fetchAdd(1);
+	}
+
+	return idx;
+}
+
 //==============================================================================
 // Other                                                                       =
 //==============================================================================
@@ -325,6 +340,16 @@ StackMemoryPool::~StackMemoryPool()
 		}
 	}
 
+	if(m_threadSlots)
+	{
+		for(U i = 0; i < THREAD_SLOT_COUNT; ++i)
+		{
+			m_threadSlots[i].~ThreadSlot();
+		}
+
+		m_allocCb(m_allocCbUserData, m_threadSlots, 0, 0);
+	}
+
 	// Do some error checks
 	auto allocCount = m_allocationsCount.load();
 	if(!m_ignoreDeallocationErrors && allocCount != 0)
@@ -340,13 +365,16 @@ void StackMemoryPool::create(AllocAlignedCallback allocCb,
 	F32 nextChunkScale,
 	PtrSize nextChunkBias,
 	Bool ignoreDeallocationErrors,
-	PtrSize alignmentBytes)
+	PtrSize alignmentBytes,
+	PtrSize threadLocalBlockSize)
 {
 	ANKI_ASSERT(!isCreated());
 	ANKI_ASSERT(allocCb);
 	ANKI_ASSERT(initialChunkSize > 0);
 	ANKI_ASSERT(nextChunkScale >= 1.0);
 	ANKI_ASSERT(alignmentBytes > 0);
+	ANKI_ASSERT(threadLocalBlockSize <= initialChunkSize);
+	ANKI_ASSERT(threadLocalBlockSize == 0 || ignoreDeallocationErrors);
 
 	m_allocCb = allocCb;
 	m_allocCbUserData = allocCbUserData;
@@ -374,6 +402,27 @@ void StackMemoryPool::create(AllocAlignedCallback allocCb,
 	{
 		ANKI_CREATION_OOM_ACTION();
 	}
+
+	// Create the thread slots
+	if(threadLocalBlockSize > 0)
+	{
+		m_threadLocalBlockSize =
+			getAlignedRoundUp(m_alignmentBytes, threadLocalBlockSize);
+
+		m_threadSlots = static_cast<ThreadSlot*>(m_allocCb(m_allocCbUserData,
+			nullptr,
+			sizeof(ThreadSlot) * THREAD_SLOT_COUNT,
+			alignof(ThreadSlot)));
+		if(!m_threadSlots)
+		{
+			ANKI_CREATION_OOM_ACTION();
+		}
+
+		for(U i = 0; i < THREAD_SLOT_COUNT; ++i)
+		{
+			::new(&m_threadSlots[i]) ThreadSlot();
+		}
+	}
 }
 
 //==============================================================================
@@ -389,6 +438,52 @@ void* StackMemoryPool::allocate(PtrSize size, PtrSize alignment)
 		&& "The chunks should have enough "
 		   "space to hold at least one allocation");
 
+	// Small allocations go to the thread's block
+	if(m_threadSlots && size <= m_threadLocalBlockSize / 4)
+	{
+		ThreadSlot& slot =
+			m_threadSlots[getThreadIndex() % THREAD_SLOT_COUNT];
+
+		if(!slot.m_lock.tryLock())
+		{
+			m_lockContentionCount.fetchAdd(1);
+			slot.m_lock.lock();
+		}
+
+		if(PtrSize(slot.m_end - slot.m_top) < size)
+		{
+			// Need a new block. Abandon the rest of the old one
+			U8* block = allocateFromChunks(m_threadLocalBlockSize);
+			if(ANKI_UNLIKELY(block == nullptr))
+			{
+				slot.m_lock.unlock();
+				return nullptr;
+			}
+
+			slot.m_top = block;
+			slot.m_end = block + m_threadLocalBlockSize;
+		}
+
+		U8* out = slot.m_top;
+		slot.m_top += size;
+		++slot.m_allocationsCount;
+		slot.m_lock.unlock();
+
+		return out;
+	}
+
+	U8* out = allocateFromChunks(size);
+	if(out)
+	{
+		m_allocationsCount.fetchAdd(1);
+	}
+
+	return out;
+}
+
+//==============================================================================
+U8* StackMemoryPool::allocateFromChunks(PtrSize size)
+{
 	Chunk* crntChunk = nullptr;
 	Bool retry = true;
 	U8* out = nullptr;
@@ -406,7 +501,6 @@ void* StackMemoryPool::allocate(PtrSize size, PtrSize alignment)
 			// All is fine, there is enough space in the chunk
 
 			retry = false;
-			m_allocationsCount.fetchAdd(1);
 		}
 		else
 		{
@@ -473,7 +567,7 @@ void* StackMemoryPool::allocate(PtrSize size, PtrSize alignment)
 		}
 	} while(retry);
 
-	return static_cast<void*>(out);
+	return out;
 }
 
 //==============================================================================
@@ -485,9 +579,13 @@ void StackMemoryPool::free(void* ptr)
 	// allocated by this class
 	ANKI_ASSERT(ptr != nullptr && isAligned(m_alignmentBytes, ptr));
 
-	auto count = m_allocationsCount.fetchSub(1);
-	ANKI_ASSERT(count > 0);
-	(void)count;
+	// The thread local allocations are not counted so there is nothing to do
+	if(m_threadSlots == nullptr)
+	{
+		auto count = m_allocationsCount.fetchSub(1);
+		ANKI_ASSERT(count > 0);
+		(void)count;
+	}
 }
 
 //==============================================================================
@@ -495,6 +593,17 @@ void StackMemoryPool::reset()
 {
 	ANKI_ASSERT(isCreated());
 
+	// Forget the thread blocks
+	if(m_threadSlots)
+	{
+		for(U i = 0; i < THREAD_SLOT_COUNT; ++i)
+		{
+			ThreadSlot& slot = m_threadSlots[i];
+			slot.m_top = slot.m_end = nullptr;
+			slot.m_allocationsCount = 0;
+		}
+	}
+
 	// Iterate all until you find an unused
 	for(Chunk& ch : m_chunks)
 	{
@@ -536,6 +645,54 @@ PtrSize StackMemoryPool::getMemoryCapacity() const
 	return sum;
 }
 
+//==============================================================================
+PtrSize StackMemoryPool::getUsedSize() const
+{
+	PtrSize sum = 0;
+	U crntChunkIdx = m_crntChunkIdx.load();
+	for(U i = 0; i <= crntChunkIdx; ++i)
+	{
+		const Chunk& ch = m_chunks[i];
+		sum += min<PtrSize>(ch.m_mem.load() - ch.m_baseMem, ch.m_size);
+	}
+
+	return sum;
+}
+
+//==============================================================================
+MemoryPoolStats StackMemoryPool::getStats() const
+{
+	ANKI_ASSERT(isCreated());
+
+	MemoryPoolStats stats;
+	stats.m_usedSize = getUsedSize();
+	stats.m_allocationsCount = m_allocationsCount.load();
+	stats.m_lockContentionCount = m_lockContentionCount.load();
+
+	if(m_threadSlots)
+	{
+		for(U i = 0; i < THREAD_SLOT_COUNT; ++i)
+		{
+			stats.m_allocationsCount += m_threadSlots[i].m_allocationsCount;
+		}
+	}
+
+	// The chunks are never released
+	for(const Chunk& ch : m_chunks)
+	{
+		if(ch.m_baseMem == nullptr)
+		{
+			break;
+		}
+
+		stats.m_reservedSize += ch.m_size;
+		++stats.m_chunksCount;
+	}
+
+	stats.m_peakReservedSize = stats.m_reservedSize;
+	return stats;
+}
+
 //==============================================================================
 // ChainMemoryPool                                                             =
 //==============================================================================
@@ -554,19 +711,25 @@ ChainMemoryPool::~ChainMemoryPool()
 		ANKI_LOGW("Memory pool destroyed before all memory being released");
 	}
 
-	Chunk* ch = m_headChunk;
-	while(ch)
-	{
-		Chunk* next = ch->m_next;
-		destroyChunk(ch);
-		ch = next;
-	}
-
-	if(m_lock)
+	if(m_slots)
 	{
 		ANKI_ASSERT(m_allocCb);
-		m_lock->~SpinLock();
-		m_allocCb(m_allocCbUserData, m_lock, 0, 0);
+		for(U i = 0; i < THREAD_SLOT_COUNT; ++i)
+		{
+			ThreadSlot& slot = m_slots[i];
+
+			Chunk* ch = slot.m_headChunk;
+			while(ch)
+			{
+				Chunk* next = ch->m_next;
+				destroyChunk(ch);
+				ch = next;
+			}
+
+			slot.~ThreadSlot();
+		}
+
+		m_allocCb(m_allocCbUserData, m_slots, 0, 0);
 	}
 }
 
@@ -592,13 +755,19 @@ void ChainMemoryPool::create(AllocAlignedCallback allocCb,
 	m_bias = nextChunkBias;
 	m_headerSize = max(m_alignmentBytes, sizeof(Chunk*));
 
-	m_lock = reinterpret_cast<SpinLock*>(m_allocCb(
-		m_allocCbUserData, nullptr, sizeof(SpinLock), alignof(SpinLock)));
-	if(!m_lock)
+	m_slots = reinterpret_cast<ThreadSlot*>(m_allocCb(m_allocCbUserData,
+		nullptr,
+		sizeof(ThreadSlot) * THREAD_SLOT_COUNT,
+		alignof(ThreadSlot)));
+	if(!m_slots)
 	{
 		ANKI_CREATION_OOM_ACTION();
 	}
-	::new(m_lock) SpinLock();
+
+	for(U i = 0; i < THREAD_SLOT_COUNT; ++i)
+	{
+		::new(&m_slots[i]) ThreadSlot();
+	}
 
 	// Initial size should be > 0
 	ANKI_ASSERT(m_initSize > 0 && "Wrong arg");
@@ -610,6 +779,16 @@ void ChainMemoryPool::create(AllocAlignedCallback allocCb,
 	}
 }
 
+//==============================================================================
+void ChainMemoryPool::lockSlot(ThreadSlot& slot)
+{
+	if(!slot.m_lock.tryLock())
+	{
+		m_lockContentionCount.fetchAdd(1);
+		slot.m_lock.lock();
+	}
+}
+
 //==============================================================================
 void* ChainMemoryPool::allocate(PtrSize size, PtrSize alignment)
 {
@@ -618,22 +797,24 @@ void* ChainMemoryPool::allocate(PtrSize size, PtrSize alignment)
 	Chunk* ch;
 	void* mem = nullptr;
 
-	LockGuard<SpinLock> lock(*m_lock);
+	ThreadSlot& slot = m_slots[getThreadIndex() % THREAD_SLOT_COUNT];
+	lockSlot(slot);
 
 	// Get chunk
-	ch = m_tailChunk;
+	ch = slot.m_tailChunk;
 
 	// Create new chunk if needed
 	if(ch == nullptr
 		|| (mem = allocateFromChunk(ch, size, alignment)) == nullptr)
 	{
 		// Create new chunk
-		PtrSize chunkSize = computeNewChunkSize(size);
-		ch = createNewChunk(chunkSize);
+		PtrSize chunkSize = computeNewChunkSize(slot, size);
+		ch = createNewChunk(slot, chunkSize);
 
 		// Chunk creation failed
 		if(ch == nullptr)
 		{
+			slot.m_lock.unlock();
 			return mem;
 		}
 	}
@@ -644,6 +825,7 @@ void* ChainMemoryPool::allocate(PtrSize size, PtrSize alignment)
 		ANKI_ASSERT(mem != nullptr && "The chunk should have space");
 	}
 
+	slot.m_lock.unlock();
 	m_allocationsCount.fetchAdd(1);
 
 	return mem;
@@ -668,7 +850,10 @@ void ChainMemoryPool::free(void* ptr)
 		(mem >= chunk->m_memory && mem < (chunk->m_memory + chunk->m_memsize))
 		&& "Wrong chunk");
 
-	LockGuard<SpinLock> lock(*m_lock);
+	// The memory may be freed by a thread other than the one that allocated
+	// it. Lock the slot that owns the chunk
+	ThreadSlot& slot = *chunk->m_slot;
+	lockSlot(slot);
 
 	// Decrease the deallocation refcount and if it's zero delete the chunk
 	ANKI_ASSERT(chunk->m_allocationsCount > 0);
@@ -678,6 +863,7 @@ void ChainMemoryPool::free(void* ptr)
 		destroyChunk(chunk);
 	}
 
+	slot.m_lock.unlock();
 	m_allocationsCount.fetchSub(1);
 }
 
@@ -687,11 +873,14 @@ PtrSize ChainMemoryPool::getChunksCount() const
 	ANKI_ASSERT(isCreated());
 
 	PtrSize count = 0;
-	Chunk* ch = m_headChunk;
-	while(ch)
+	for(U i = 0; i < THREAD_SLOT_COUNT; ++i)
 	{
-		++count;
-		ch = ch->m_next;
+		Chunk* ch = m_slots[i].m_headChunk;
+		while(ch)
+		{
+			++count;
+			ch = ch->m_next;
+		}
 	}
 
 	return count;
@@ -703,26 +892,46 @@ PtrSize ChainMemoryPool::getAllocatedSize() const
 	ANKI_ASSERT(isCreated());
 
 	PtrSize sum = 0;
-	Chunk* ch = m_headChunk;
-	while(ch)
+	for(U i = 0; i < THREAD_SLOT_COUNT; ++i)
 	{
-		sum += ch->m_top - ch->m_memory;
-		ch = ch->m_next;
+		Chunk* ch = m_slots[i].m_headChunk;
+		while(ch)
+		{
+			sum += ch->m_top - ch->m_memory;
+			ch = ch->m_next;
+		}
 	}
 
 	return sum;
 }
 
 //==============================================================================
-PtrSize ChainMemoryPool::computeNewChunkSize(PtrSize size) const
+MemoryPoolStats ChainMemoryPool::getStats() const
+{
+	ANKI_ASSERT(isCreated());
+
+	MemoryPoolStats stats;
+	stats.m_usedSize = getAllocatedSize();
+	stats.m_reservedSize = m_reservedSize.load();
+	stats.m_peakReservedSize = m_peakReservedSize.load();
+	stats.m_allocationsCount = m_allocationsCount.load();
+	stats.m_chunksCount = getChunksCount();
+	stats.m_lockContentionCount = m_lockContentionCount.load();
+
+	return stats;
+}
+
+//==============================================================================
+PtrSize ChainMemoryPool::computeNewChunkSize(
+	const ThreadSlot& slot, PtrSize size) const
 {
 	size += m_headerSize;
 
 	PtrSize crntMaxSize;
-	if(m_tailChunk != nullptr)
+	if(slot.m_tailChunk != nullptr)
 	{
 		// Get the size of previous
-		crntMaxSize = m_tailChunk->m_memsize;
+		crntMaxSize = slot.m_tailChunk->m_memsize;
 
 		// Compute new size
 		crntMaxSize = F32(crntMaxSize) * m_scale + m_bias;
@@ -730,7 +939,7 @@ PtrSize ChainMemoryPool::computeNewChunkSize(PtrSize size) const
 	else
 	{
 		// No chunks. Choose initial size
-		ANKI_ASSERT(m_headChunk == nullptr);
+		ANKI_ASSERT(slot.m_headChunk == nullptr);
 		crntMaxSize = m_initSize;
 	}
 
@@ -742,7 +951,8 @@ PtrSize ChainMemoryPool::computeNewChunkSize(PtrSize size) const
 }
 
 //==============================================================================
-ChainMemoryPool::Chunk* ChainMemoryPool::createNewChunk(PtrSize size)
+ChainMemoryPool::Chunk* ChainMemoryPool::createNewChunk(
+	ThreadSlot& slot, PtrSize size)
 {
 	ANKI_ASSERT(size > 0);
 
@@ -759,26 +969,31 @@ ChainMemoryPool::Chunk* ChainMemoryPool::createNewChunk(PtrSize size)
 		invalidateMemory(chunk, allocationSize);
 
 		// Construct it
-		memset(chunk, 0, sizeof(Chunk));
+		::new(chunk) Chunk();
 
 		// Initialize it
 		chunk->m_memory = reinterpret_cast<U8*>(chunk) + chunkAllocSize;
 
 		chunk->m_memsize = memAllocSize;
 		chunk->m_top = chunk->m_memory;
+		chunk->m_slot = &slot;
 
 		// Register it
-		if(m_tailChunk)
+		if(slot.m_tailChunk)
 		{
-			m_tailChunk->m_next = chunk;
-			chunk->m_prev = m_tailChunk;
-			m_tailChunk = chunk;
+			slot.m_tailChunk->m_next = chunk;
+			chunk->m_prev = slot.m_tailChunk;
+			slot.m_tailChunk = chunk;
 		}
 		else
 		{
-			ANKI_ASSERT(m_headChunk == nullptr);
-			m_headChunk = m_tailChunk = chunk;
+			ANKI_ASSERT(slot.m_headChunk == nullptr);
+			slot.m_headChunk = slot.m_tailChunk = chunk;
 		}
+
+		// Update the stats
+		PtrSize reserved = m_reservedSize.fetchAdd(memAllocSize) + memAllocSize;
+		m_peakReservedSize.max(reserved);
 	}
 	else
 	{
@@ -820,15 +1035,16 @@ void* ChainMemoryPool::allocateFromChunk(
 void ChainMemoryPool::destroyChunk(Chunk* ch)
 {
 	ANKI_ASSERT(ch);
+	ThreadSlot& slot = *ch->m_slot;
 
-	if(ch == m_tailChunk)
+	if(ch == slot.m_tailChunk)
 	{
-		m_tailChunk = ch->m_prev;
+		slot.m_tailChunk = ch->m_prev;
 	}
 
-	if(ch == m_headChunk)
+	if(ch == slot.m_headChunk)
 	{
-		m_headChunk = ch->m_next;
+		slot.m_headChunk = ch->m_next;
 	}
 
 	if(ch->m_prev)
@@ -843,6 +1059,8 @@ void ChainMemoryPool::destroyChunk(Chunk* ch)
 		ch->m_next->m_prev = ch->m_prev;
 	}
 
+	m_reservedSize.fetchSub(ch->m_memsize);
+
 	invalidateMemory(
 		ch, getAlignedRoundUp(m_alignmentBytes, sizeof(Chunk)) + ch->m_memsize);
 	m_allocCb(m_allocCbUserData, ch, 0, 0);
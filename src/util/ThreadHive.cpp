@@ -6,6 +6,7 @@
 #include <anki/util/ThreadHive.h>
 #include <cstring>
 #include <cstdio>
+#include <thread>
 
 namespace anki
 {
@@ -22,16 +23,46 @@ namespace anki
 #define ANKI_HIVE_DEBUG_PRINT(...) ((void)0)
 #endif
 
+/// Marks an empty list of dependents.
+static const U32 WS_LIST_EMPTY = MAX_U32;
+
+/// Marks the list of dependents of a task that is done.
+static const U32 WS_LIST_CLOSED = MAX_U32 - 1;
+
+/// How many times a thread will look for work before going to sleep.
+static const U WS_SPIN_COUNT = 64;
+
+/// Max tasks to move from the injection queue to a thread's deque at once.
+static const U WS_MAX_INJECTION_GRAB = 16;
+
+/// Size of the stack buffers that gather ready tasks.
+static const U WS_READY_BATCH = 64;
+
+/// The hive that owns the current thread. Used to identify submissions and
+/// waits from inside task callbacks.
+static thread_local ThreadHive* g_hive = nullptr;
+static thread_local U32 g_threadId = 0;
+
 //==============================================================================
 // ThreadHive::Thread                                                          =
 //==============================================================================
 class ThreadHive::Thread
 {
 public:
+	static const U DEQUE_MASK = MAX_TASKS_PER_SESSION - 1;
+
 	U32 m_id; ///< An ID
 	anki::Thread m_thread; ///< Runs the workingFunc
 	ThreadHive* m_hive;
 
+	/// @name Chase-Lev deque of the work stealing mode
+	/// @{
+	Array<Atomic<U32>, MAX_TASKS_PER_SESSION> m_deque;
+	Atomic<I64> m_top = {0}; ///< Thieves steal from the top.
+	Array<U8, 64> m_padding; ///< Keep top and bottom in different cachelines.
+	Atomic<I64> m_bottom = {0}; ///< The owner pushes and pops at the bottom.
+	/// @}
+
 	/// Constructor
 	Thread(U32 id, ThreadHive* hive)
 		: m_id(id)
@@ -39,9 +70,71 @@ public:
 		, m_hive(hive)
 	{
 		ANKI_ASSERT(hive);
+	}
+
+	void start()
+	{
 		m_thread.start(this, threadCallback);
 	}
 
+	/// Push a task. Only the owner thread can call it.
+	void push(ThreadHiveDependencyHandle task)
+	{
+		const I64 b = m_bottom.load(AtomicMemoryOrder::RELAXED);
+		ANKI_ASSERT(b - m_top.load(AtomicMemoryOrder::RELAXED)
+			< I64(MAX_TASKS_PER_SESSION));
+
+		m_deque[b & DEQUE_MASK].store(task, AtomicMemoryOrder::RELAXED);
+		m_bottom.store(b + 1, AtomicMemoryOrder::RELEASE);
+	}
+
+	/// Pop the most recent task. Only the owner thread can call it.
+	Bool pop(ThreadHiveDependencyHandle& task)
+	{
+		const I64 b = m_bottom.load(AtomicMemoryOrder::RELAXED) - 1;
+		m_bottom.store(b, AtomicMemoryOrder::RELAXED);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		I64 t = m_top.load(AtomicMemoryOrder::RELAXED);
+
+		Bool found = false;
+		if(t <= b)
+		{
+			task = m_deque[b & DEQUE_MASK].load(AtomicMemoryOrder::RELAXED);
+			found = true;
+
+			if(t == b)
+			{
+				// Last task, race against the thieves
+				found = m_top.compareExchange(
+					t, t + 1, AtomicMemoryOrder::SEQ_CST);
+				m_bottom.store(b + 1, AtomicMemoryOrder::RELAXED);
+			}
+		}
+		else
+		{
+			// Empty
+			m_bottom.store(b + 1, AtomicMemoryOrder::RELAXED);
+		}
+
+		return found;
+	}
+
+	/// Steal the oldest task. Any thread can call it.
+	Bool steal(ThreadHiveDependencyHandle& task)
+	{
+		I64 t = m_top.load(AtomicMemoryOrder::ACQUIRE);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const I64 b = m_bottom.load(AtomicMemoryOrder::ACQUIRE);
+
+		if(t < b)
+		{
+			task = m_deque[t & DEQUE_MASK].load(AtomicMemoryOrder::RELAXED);
+			return m_top.compareExchange(t, t + 1, AtomicMemoryOrder::SEQ_CST);
+		}
+
+		return false;
+	}
+
 private:
 	/// Thread callaback
 	static Error threadCallback(anki::Thread::Info& info)
@@ -68,6 +161,12 @@ public:
 	U16 m_depCount;
 	Bool8 m_othersDepend; ///< Other tasks depend on this one.
 
+	/// @name Work stealing members
+	/// @{
+	Atomic<U32> m_wsPendingDeps; ///< Unresolved dependencies.
+	Atomic<U32> m_wsDependents; ///< Head of the list of DependentNode.
+	/// @}
+
 	Task()
 	{
 	}
@@ -81,15 +180,53 @@ public:
 	}
 };
 
+//==============================================================================
+// ThreadHive::DependentNode                                                   =
+//==============================================================================
+class ThreadHive::DependentNode
+{
+public:
+	U32 m_next; ///< Next node in the list.
+	ThreadHiveDependencyHandle m_task; ///< The task that waits.
+};
+
+//==============================================================================
+// ThreadHive::InjectionQueue                                                  =
+//==============================================================================
+class ThreadHive::InjectionQueue
+{
+public:
+	SpinLock m_lock;
+	Array<ThreadHiveDependencyHandle, MAX_TASKS_PER_SESSION> m_tasks;
+	U32 m_begin = 0;
+	U32 m_end = 0;
+};
+
 //==============================================================================
 // ThreadHive                                                                  =
 //==============================================================================
 
 //==============================================================================
-ThreadHive::ThreadHive(U threadCount, GenericMemoryPoolAllocator<U8> alloc)
+ThreadHive::ThreadHive(
+	U threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool workStealing)
 	: m_alloc(alloc)
 	, m_threadCount(threadCount)
+	, m_workStealing(workStealing)
 {
+	m_storage.create(m_alloc, MAX_TASKS_PER_SESSION);
+
+	if(m_workStealing)
+	{
+		m_dependents.create(m_alloc, MAX_TASKS_PER_SESSION * threadCount);
+		m_injection = m_alloc.newInstance<InjectionQueue>();
+	}
+	else
+	{
+		m_deps.create(m_alloc, MAX_TASKS_PER_SESSION * threadCount);
+	}
+
+	// Start the threads after all of them are constructed because in work
+	// stealing mode they access each other
 	m_threads =
 		reinterpret_cast<Thread*>(alloc.allocate(sizeof(Thread) * threadCount));
 	for(U i = 0; i < threadCount; ++i)
@@ -97,16 +234,15 @@ ThreadHive::ThreadHive(U threadCount, GenericMemoryPoolAllocator<U8> alloc)
 		::new(&m_threads[i]) Thread(i, this);
 	}
 
-	m_storage.create(m_alloc, MAX_TASKS_PER_SESSION);
-	m_deps.create(m_alloc, MAX_TASKS_PER_SESSION * threadCount);
+	for(U i = 0; i < threadCount; ++i)
+	{
+		m_threads[i].start();
+	}
 }
 
 //==============================================================================
 ThreadHive::~ThreadHive()
 {
-	m_storage.destroy(m_alloc);
-	m_deps.destroy(m_alloc);
-
 	if(m_threads)
 	{
 		{
@@ -129,6 +265,15 @@ ThreadHive::~ThreadHive()
 		m_alloc.deallocate(
 			static_cast<void*>(m_threads), m_threadCount * sizeof(Thread));
 	}
+
+	m_storage.destroy(m_alloc);
+	m_deps.destroy(m_alloc);
+	m_dependents.destroy(m_alloc);
+
+	if(m_injection)
+	{
+		m_alloc.deleteInstance(m_injection);
+	}
 }
 
 //==============================================================================
@@ -136,6 +281,12 @@ void ThreadHive::submitTasks(ThreadHiveTask* tasks, U taskCount)
 {
 	ANKI_ASSERT(tasks && taskCount > 0);
 
+	if(m_workStealing)
+	{
+		wsSubmitTasks(tasks, taskCount);
+		return;
+	}
+
 	U allocatedTasks;
 
 	// Push work
@@ -213,6 +364,15 @@ void ThreadHive::submitTasks(ThreadHiveTask* tasks, U taskCount)
 //==============================================================================
 void ThreadHive::threadRun(U threadId)
 {
+	g_hive = this;
+	g_threadId = threadId;
+
+	if(m_workStealing)
+	{
+		wsThreadRun(m_threads[threadId]);
+		return;
+	}
+
 	Task* task = nullptr;
 
 	while(!waitForWork(threadId, task))
@@ -236,15 +396,7 @@ Bool ThreadHive::waitForWork(U threadId, Task*& task)
 	// Complete the previous task
 	if(task)
 	{
-		task->m_cb = nullptr;
-		--m_pendingTasks;
-
-		if(task->m_othersDepend || m_pendingTasks == 0)
-		{
-			// A dependency got resolved or we are out of tasks. Wake them all
-			ANKI_HIVE_DEBUG_PRINT("tid: %lu wake all\n", threadId);
-			m_cvar.notifyAll();
-		}
+		completeTask(*task);
 	}
 
 	while(!m_quit && (task = getNewTask()) == nullptr)
@@ -258,6 +410,20 @@ Bool ThreadHive::waitForWork(U threadId, Task*& task)
 	return m_quit;
 }
 
+//==============================================================================
+void ThreadHive::completeTask(Task& task)
+{
+	task.m_cb = nullptr;
+	--m_pendingTasks;
+
+	if(task.m_othersDepend || m_pendingTasks == 0)
+	{
+		// A dependency got resolved or we are out of tasks. Wake them all
+		ANKI_HIVE_DEBUG_PRINT("wake all\n");
+		m_cvar.notifyAll();
+	}
+}
+
 //==============================================================================
 ThreadHive::Task* ThreadHive::getNewTask()
 {
@@ -319,6 +485,12 @@ void ThreadHive::waitAllTasks()
 {
 	ANKI_HIVE_DEBUG_PRINT("mt: waiting all\n");
 
+	if(m_workStealing)
+	{
+		wsWaitAllTasks();
+		return;
+	}
+
 	LockGuard<Mutex> lock(m_mtx);
 	while(m_pendingTasks > 0)
 	{
@@ -333,4 +505,411 @@ void ThreadHive::waitAllTasks()
 	ANKI_HIVE_DEBUG_PRINT("mt: done waiting all\n");
 }
 
+//==============================================================================
+void ThreadHive::wsSubmitTasks(ThreadHiveTask* tasks, U taskCount)
+{
+	m_wsPendingTasks.fetchAdd(taskCount, AtomicMemoryOrder::ACQ_REL);
+
+	const U32 firstTask = m_wsAllocatedTasks.fetchAdd(taskCount);
+	ANKI_ASSERT(firstTask + taskCount <= MAX_TASKS_PER_SESSION);
+
+	Array<ThreadHiveDependencyHandle, WS_READY_BATCH> ready;
+	U readyCount = 0;
+
+	for(U i = 0; i < taskCount; ++i)
+	{
+		const ThreadHiveTask& inTask = tasks[i];
+		const ThreadHiveDependencyHandle taskId = firstTask + i;
+		Task& outTask = m_storage[taskId];
+
+		outTask.m_cb = inTask.m_callback;
+		outTask.m_arg = inTask.m_argument;
+		outTask.m_wsDependents.store(WS_LIST_EMPTY, AtomicMemoryOrder::RELAXED);
+
+		// The extra count guards the task until all the dependencies are
+		// registered
+		const U depCount = inTask.m_inDependencies.getSize();
+		outTask.m_wsPendingDeps.store(
+			depCount + 1, AtomicMemoryOrder::RELAXED);
+
+		for(U j = 0; j < depCount; ++j)
+		{
+			const ThreadHiveDependencyHandle dep = inTask.m_inDependencies[j];
+			ANKI_ASSERT(dep < taskId);
+			Task& depTask = m_storage[dep];
+
+			const U32 nodeIdx = m_wsAllocatedDependents.fetchAdd(1);
+			DependentNode& node = m_dependents[nodeIdx];
+			node.m_task = taskId;
+
+			// Add the node to the dependents of the other task unless that task
+			// is already done
+			Bool registered = false;
+			U32 head = depTask.m_wsDependents.load(AtomicMemoryOrder::ACQUIRE);
+			while(head != WS_LIST_CLOSED)
+			{
+				node.m_next = head;
+				if(depTask.m_wsDependents.compareExchange(
+					   head, nodeIdx, AtomicMemoryOrder::ACQ_REL))
+				{
+					registered = true;
+					break;
+				}
+
+				head = depTask.m_wsDependents.load(AtomicMemoryOrder::ACQUIRE);
+			}
+
+			if(!registered)
+			{
+				outTask.m_wsPendingDeps.fetchSub(1, AtomicMemoryOrder::RELAXED);
+			}
+		}
+
+		// Drop the guard
+		if(outTask.m_wsPendingDeps.fetchSub(1, AtomicMemoryOrder::ACQ_REL) == 1)
+		{
+			if(readyCount == ready.getSize())
+			{
+				wsPushReadyTasks(&ready[0], readyCount);
+				readyCount = 0;
+			}
+
+			ready[readyCount++] = taskId;
+		}
+
+		tasks[i].m_outDependency = taskId;
+	}
+
+	if(readyCount > 0)
+	{
+		wsPushReadyTasks(&ready[0], readyCount);
+	}
+}
+
+//==============================================================================
+void ThreadHive::wsPushReadyTasks(
+	const ThreadHiveDependencyHandle* tasks, U count)
+{
+	ANKI_ASSERT(tasks && count > 0);
+
+	const Bool fromHiveThread = g_hive == this;
+	if(fromHiveThread)
+	{
+		// Local first. The other threads will steal if they are idle
+		Thread& thread = m_threads[g_threadId];
+		for(U i = 0; i < count; ++i)
+		{
+			thread.push(tasks[i]);
+		}
+	}
+	else
+	{
+		LockGuard<SpinLock> lock(m_injection->m_lock);
+		for(U i = 0; i < count; ++i)
+		{
+			m_injection->m_tasks[m_injection->m_end++] = tasks[i];
+		}
+	}
+
+	m_wsReadyTasks.fetchAdd(count, AtomicMemoryOrder::SEQ_CST);
+
+	// Wake sleeping threads. A hive thread will run one of the tasks itself
+	const U toWake = (fromHiveThread) ? count - 1 : count;
+	if(toWake > 0
+		&& m_wsSleepingThreads.load(AtomicMemoryOrder::SEQ_CST) > 0)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		if(toWake == 1)
+		{
+			m_cvar.notifyOne();
+		}
+		else
+		{
+			m_cvar.notifyAll();
+		}
+	}
+}
+
+//==============================================================================
+Bool ThreadHive::wsFindTask(Thread& thread, ThreadHiveDependencyHandle& task)
+{
+	Bool found = thread.pop(task);
+
+	// Try the injection queue
+	if(!found)
+	{
+		LockGuard<SpinLock> lock(m_injection->m_lock);
+
+		const U count = m_injection->m_end - m_injection->m_begin;
+		if(count > 0)
+		{
+			task = m_injection->m_tasks[m_injection->m_begin++];
+			found = true;
+
+			// Take a share of the rest so the other threads can steal them
+			U share = min<U>((count - 1) / m_threadCount, WS_MAX_INJECTION_GRAB);
+			while(share-- != 0)
+			{
+				thread.push(m_injection->m_tasks[m_injection->m_begin++]);
+			}
+		}
+	}
+
+	// Steal
+	for(U i = 1; i < m_threadCount && !found; ++i)
+	{
+		found = m_threads[(thread.m_id + i) % m_threadCount].steal(task);
+	}
+
+	if(found)
+	{
+		m_wsReadyTasks.fetchSub(1, AtomicMemoryOrder::RELAXED);
+	}
+
+	return found;
+}
+
+//==============================================================================
+void ThreadHive::wsThreadRun(Thread& thread)
+{
+	U spins = 0;
+	while(true)
+	{
+		ThreadHiveDependencyHandle taskId;
+		if(wsFindTask(thread, taskId))
+		{
+			Task& task = m_storage[taskId];
+			ANKI_ASSERT(task.m_cb);
+			task.m_cb(task.m_arg, thread.m_id, *this);
+			ANKI_HIVE_DEBUG_PRINT("tid: %u executed\n", thread.m_id);
+
+			wsCompleteTask(taskId);
+			spins = 0;
+		}
+		else if(++spins < WS_SPIN_COUNT)
+		{
+			// Give the core to someone else in case the hive oversubscribes it
+			std::this_thread::yield();
+		}
+		else
+		{
+			spins = 0;
+
+			LockGuard<Mutex> lock(m_mtx);
+			m_wsSleepingThreads.fetchAdd(1, AtomicMemoryOrder::SEQ_CST);
+
+			while(!m_quit
+				&& m_wsReadyTasks.load(AtomicMemoryOrder::SEQ_CST) <= 0)
+			{
+				ANKI_HIVE_DEBUG_PRINT("tid: %u waiting\n", thread.m_id);
+				m_cvar.wait(m_mtx);
+			}
+
+			m_wsSleepingThreads.fetchSub(1, AtomicMemoryOrder::SEQ_CST);
+
+			if(m_quit)
+			{
+				break;
+			}
+		}
+	}
+
+	ANKI_HIVE_DEBUG_PRINT("tid: %u thread quits!\n", thread.m_id);
+}
+
+//==============================================================================
+void ThreadHive::wsCompleteTask(ThreadHiveDependencyHandle taskId)
+{
+	Task& task = m_storage[taskId];
+
+	// Close the list so no new dependents get added and release the ones that
+	// are there
+	U32 nodeIdx =
+		task.m_wsDependents.exchange(WS_LIST_CLOSED, AtomicMemoryOrder::ACQ_REL);
+	ANKI_ASSERT(nodeIdx != WS_LIST_CLOSED);
+
+	Array<ThreadHiveDependencyHandle, WS_READY_BATCH> ready;
+	U readyCount = 0;
+
+	while(nodeIdx != WS_LIST_EMPTY)
+	{
+		const DependentNode& node = m_dependents[nodeIdx];
+		Task& dependent = m_storage[node.m_task];
+
+		if(dependent.m_wsPendingDeps.fetchSub(1, AtomicMemoryOrder::ACQ_REL)
+			== 1)
+		{
+			if(readyCount == ready.getSize())
+			{
+				wsPushReadyTasks(&ready[0], readyCount);
+				readyCount = 0;
+			}
+
+			ready[readyCount++] = node.m_task;
+		}
+
+		nodeIdx = node.m_next;
+	}
+
+	if(readyCount > 0)
+	{
+		wsPushReadyTasks(&ready[0], readyCount);
+	}
+
+	if(m_wsPendingTasks.fetchSub(1, AtomicMemoryOrder::ACQ_REL) == 1)
+	{
+		// That was the last one, wake the waiters
+		LockGuard<Mutex> lock(m_mtx);
+		m_wsDoneCvar.notifyAll();
+	}
+}
+
+//==============================================================================
+void ThreadHive::wsWaitAllTasks()
+{
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		while(m_wsPendingTasks.load(AtomicMemoryOrder::ACQUIRE) > 0)
+		{
+			m_wsDoneCvar.wait(m_mtx);
+		}
+	}
+
+	ANKI_ASSERT(m_wsReadyTasks.load() == 0);
+	m_wsAllocatedTasks.store(0);
+	m_wsAllocatedDependents.store(0);
+
+	{
+		LockGuard<SpinLock> lock(m_injection->m_lock);
+		ANKI_ASSERT(m_injection->m_begin == m_injection->m_end);
+		m_injection->m_begin = 0;
+		m_injection->m_end = 0;
+	}
+
+	ANKI_HIVE_DEBUG_PRINT("mt: done waiting all\n");
+}
+
+//==============================================================================
+Bool ThreadHive::tryRunTask(U32 threadId)
+{
+	if(m_workStealing)
+	{
+		ThreadHiveDependencyHandle taskId;
+		if(!wsFindTask(m_threads[threadId], taskId))
+		{
+			return false;
+		}
+
+		Task& task = m_storage[taskId];
+		task.m_cb(task.m_arg, threadId, *this);
+		wsCompleteTask(taskId);
+	}
+	else
+	{
+		Task* task;
+		{
+			LockGuard<Mutex> lock(m_mtx);
+			task = getNewTask();
+		}
+
+		if(task == nullptr)
+		{
+			return false;
+		}
+
+		task->m_cb(task->m_arg, threadId, *this);
+
+		LockGuard<Mutex> lock(m_mtx);
+		completeTask(*task);
+	}
+
+	return true;
+}
+
+//==============================================================================
+void ThreadHive::ParallelForContext::run(U32 threadId)
+{
+	PtrSize start;
+	while((start = m_next.fetchAdd(m_grainSize)) < m_end)
+	{
+		// Stop early if something failed
+		if(m_err.load() != 0)
+		{
+			break;
+		}
+
+		const PtrSize end = min(start + m_grainSize, m_end);
+		Error err = m_callback(m_func, start, end, threadId);
+		if(err)
+		{
+			I32 expected = 0;
+			m_err.compareExchange(expected, err._getCodeInt());
+		}
+	}
+}
+
+//==============================================================================
+void ThreadHive::parallelForTask(void* arg, U32 threadId, ThreadHive& hive)
+{
+	ParallelForContext& ctx = *static_cast<ParallelForContext*>(arg);
+	ctx.run(threadId);
+
+	// Don't touch the ctx after that, it lives in the stack of the caller
+	ctx.m_tasksLeft.fetchSub(1, AtomicMemoryOrder::RELEASE);
+}
+
+//==============================================================================
+Error ThreadHive::parallelForInternal(ParallelForContext& ctx)
+{
+	const PtrSize begin = ctx.m_next.get();
+	if(begin >= ctx.m_end)
+	{
+		return ErrorCode::NONE;
+	}
+
+	const PtrSize chunkCount =
+		(ctx.m_end - begin + ctx.m_grainSize - 1) / ctx.m_grainSize;
+	const Bool nested = g_hive == this;
+
+	// A nested caller works on the range as well so it needs one task less
+	U taskCount = min<PtrSize>(chunkCount, min<U>(m_threadCount, MAX_THREADS));
+	if(nested)
+	{
+		--taskCount;
+	}
+
+	ctx.m_tasksLeft.set(taskCount);
+	if(taskCount > 0)
+	{
+		Array<ThreadHiveTask, MAX_THREADS> tasks;
+		for(U i = 0; i < taskCount; ++i)
+		{
+			tasks[i].m_callback = parallelForTask;
+			tasks[i].m_argument = &ctx;
+		}
+
+		submitTasks(&tasks[0], taskCount);
+	}
+
+	if(nested)
+	{
+		ctx.run(g_threadId);
+
+		// Help with other work while the rest of the chunks are in flight
+		while(ctx.m_tasksLeft.load(AtomicMemoryOrder::ACQUIRE) > 0)
+		{
+			if(!tryRunTask(g_threadId))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+	else
+	{
+		waitAllTasks();
+	}
+
+	return static_cast<ErrorCode>(ctx.m_err.load());
+}
+
 } // end namespace anki
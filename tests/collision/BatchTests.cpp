@@ -0,0 +1,250 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/Collision.h"
+#include "anki/util/DynamicArray.h"
+#include "anki/util/HighRezTimer.h"
+
+using namespace anki;
+
+/// Random boxes and spheres around a frustum in SoA layout.
+class BatchTestShapes
+{
+public:
+	DynamicArrayAuto<F32> m_centerX, m_centerY, m_centerZ;
+	DynamicArrayAuto<F32> m_extentX, m_extentY, m_extentZ;
+	DynamicArrayAuto<F32> m_radius;
+
+	BatchTestShapes(HeapAllocator<U8> alloc, U count)
+		: m_centerX(alloc)
+		, m_centerY(alloc)
+		, m_centerZ(alloc)
+		, m_extentX(alloc)
+		, m_extentY(alloc)
+		, m_extentZ(alloc)
+		, m_radius(alloc)
+	{
+		m_centerX.create(count);
+		m_centerY.create(count);
+		m_centerZ.create(count);
+		m_extentX.create(count);
+		m_extentY.create(count);
+		m_extentZ.create(count);
+		m_radius.create(count);
+
+		for(U i = 0; i < count; ++i)
+		{
+			m_centerX[i] = randRange(-100.0f, 100.0f);
+			m_centerY[i] = randRange(-100.0f, 100.0f);
+			m_centerZ[i] = randRange(-100.0f, 100.0f);
+			m_extentX[i] = randRange(0.1f, 5.0f);
+			m_extentY[i] = randRange(0.1f, 5.0f);
+			m_extentZ[i] = randRange(0.1f, 5.0f);
+			m_radius[i] = randRange(0.1f, 5.0f);
+		}
+	}
+
+	Vec4 getCenter(U i) const
+	{
+		return Vec4(m_centerX[i], m_centerY[i], m_centerZ[i], 0.0);
+	}
+
+	Aabb getAabb(U i) const
+	{
+		const Vec4 extent(m_extentX[i], m_extentY[i], m_extentZ[i], 0.0);
+		return Aabb(getCenter(i) - extent, getCenter(i) + extent);
+	}
+
+	Sphere getSphere(U i) const
+	{
+		return Sphere(getCenter(i), m_radius[i]);
+	}
+
+	BatchVolumes getBoxes() const
+	{
+		BatchVolumes v;
+		v.m_centerX = &m_centerX[0];
+		v.m_centerY = &m_centerY[0];
+		v.m_centerZ = &m_centerZ[0];
+		v.m_extentX = &m_extentX[0];
+		v.m_extentY = &m_extentY[0];
+		v.m_extentZ = &m_extentZ[0];
+		return v;
+	}
+
+	BatchVolumes getSpheres() const
+	{
+		BatchVolumes v;
+		v.m_centerX = &m_centerX[0];
+		v.m_centerY = &m_centerY[0];
+		v.m_centerZ = &m_centerZ[0];
+		v.m_radius = &m_radius[0];
+		return v;
+	}
+};
+
+static PerspectiveFrustum createTestFrustum()
+{
+	PerspectiveFrustum fr(toRad(70.0f), toRad(50.0f), 0.1f, 80.0f);
+	fr.resetTransform(Transform(Vec4(5.0, -2.0, 10.0, 0.0),
+		Mat3x4(Euler(toRad(10.0f), toRad(30.0f), 0.0f)),
+		1.0));
+	return fr;
+}
+
+ANKI_TEST(Collision, BatchTestPlanes)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const U COUNT = 1001;
+	BatchTestShapes shapes(alloc, COUNT);
+	PerspectiveFrustum fr = createTestFrustum();
+	const auto& planes = fr.getPlanesWorldSpace();
+
+	DynamicArrayAuto<U32> visible(alloc);
+	visible.create(COUNT);
+	DynamicArrayAuto<U32> mask(alloc);
+	mask.create((COUNT + 31) / 32);
+
+	// Boxes
+	{
+		U32 visibleCount = fr.insideFrustum(
+			shapes.getBoxes(), COUNT, &visible[0]);
+		batchTestPlanesMask(shapes.getBoxes(),
+			COUNT,
+			&planes[0],
+			planes.getSize(),
+			&mask[0]);
+
+		U32 expectedCount = 0;
+		for(U i = 0; i < COUNT; ++i)
+		{
+			const Bool inside = fr.insideFrustum(shapes.getAabb(i));
+			if(inside)
+			{
+				ANKI_TEST_EXPECT_EQ(visible[expectedCount], i);
+				++expectedCount;
+			}
+
+			ANKI_TEST_EXPECT_EQ(((mask[i / 32] >> (i % 32)) & 1) != 0, inside);
+		}
+
+		ANKI_TEST_EXPECT_EQ(visibleCount, expectedCount);
+		ANKI_TEST_EXPECT_GT(visibleCount, 0);
+	}
+
+	// Spheres
+	{
+		U32 visibleCount = fr.insideFrustum(
+			shapes.getSpheres(), COUNT, &visible[0]);
+
+		U32 expectedCount = 0;
+		for(U i = 0; i < COUNT; ++i)
+		{
+			if(fr.insideFrustum(shapes.getSphere(i)))
+			{
+				ANKI_TEST_EXPECT_EQ(visible[expectedCount], i);
+				++expectedCount;
+			}
+		}
+
+		ANKI_TEST_EXPECT_EQ(visibleCount, expectedCount);
+	}
+
+	// Indexed with aliasing output. Test every third box
+	{
+		U32 indexCount = 0;
+		for(U i = 0; i < COUNT; i += 3)
+		{
+			visible[indexCount++] = i;
+		}
+
+		U32 visibleCount = batchTestPlanesIndexed(shapes.getBoxes(),
+			&visible[0],
+			indexCount,
+			&planes[0],
+			planes.getSize(),
+			&visible[0]);
+
+		U32 expectedCount = 0;
+		for(U i = 0; i < COUNT; i += 3)
+		{
+			if(fr.insideFrustum(shapes.getAabb(i)))
+			{
+				ANKI_TEST_EXPECT_EQ(visible[expectedCount], i);
+				++expectedCount;
+			}
+		}
+
+		ANKI_TEST_EXPECT_EQ(visibleCount, expectedCount);
+	}
+}
+
+ANKI_TEST(Collision, BatchTestPlanesBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const U COUNT = 100000;
+	const U ITERATIONS = 10;
+	BatchTestShapes shapes(alloc, COUNT);
+	PerspectiveFrustum fr = createTestFrustum();
+
+	DynamicArrayAuto<U32> visible(alloc);
+	visible.create(COUNT);
+
+	// Build the shapes of the scalar path up front
+	DynamicArrayAuto<Aabb> aabbs(alloc);
+	aabbs.create(COUNT);
+	DynamicArrayAuto<Sphere> spheres(alloc);
+	spheres.create(COUNT);
+	for(U i = 0; i < COUNT; ++i)
+	{
+		aabbs[i] = shapes.getAabb(i);
+		spheres[i] = shapes.getSphere(i);
+	}
+
+	HighRezTimer timer;
+	U32 checksum = 0;
+
+	for(U s = 0; s < 2; ++s)
+	{
+		const Bool boxes = s == 0;
+
+		// Scalar
+		timer.start();
+		for(U it = 0; it < ITERATIONS; ++it)
+		{
+			for(U i = 0; i < COUNT; ++i)
+			{
+				const CollisionShape& cs = (boxes)
+					? static_cast<const CollisionShape&>(aabbs[i])
+					: static_cast<const CollisionShape&>(spheres[i]);
+
+				checksum += fr.insideFrustum(cs);
+			}
+		}
+		timer.stop();
+		const HighRezTimer::Scalar scalarTime = timer.getElapsedTime();
+
+		// Batch
+		timer.start();
+		for(U it = 0; it < ITERATIONS; ++it)
+		{
+			checksum += fr.insideFrustum(
+				(boxes) ? shapes.getBoxes() : shapes.getSpheres(),
+				COUNT,
+				&visible[0]);
+		}
+		timer.stop();
+		const HighRezTimer::Scalar batchTime = timer.getElapsedTime();
+
+		printf("%s: scalar %f batch %f | %f%%\n",
+			(boxes) ? "Aabbs" : "Spheres",
+			scalarTime,
+			batchTime,
+			batchTime / scalarTime * 100.0);
+	}
+
+	ANKI_TEST_EXPECT_GT(checksum, 0);
+}
@@ -0,0 +1,240 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/Collision.h"
+#include "anki/collision/DynamicAabbTree.h"
+#include "anki/util/DynamicArray.h"
+#include "anki/util/HighRezTimer.h"
+
+using namespace anki;
+
+static Aabb randomBox()
+{
+	const Vec4 center(randRange(-200.0f, 200.0f),
+		randRange(-50.0f, 50.0f),
+		randRange(-200.0f, 200.0f),
+		0.0);
+	const Vec4 extent(randRange(0.1f, 4.0f),
+		randRange(0.1f, 4.0f),
+		randRange(0.1f, 4.0f),
+		0.0);
+	return Aabb(center - extent, center + extent);
+}
+
+/// Check that a query visits all the boxes that pass a test and nothing that
+/// doesn't pass against the fat boxes.
+template<typename TTest>
+static void checkVisited(const DynamicAabbTree& tree,
+	const DynamicArrayAuto<Aabb>& boxes,
+	const DynamicArrayAuto<U32>& leaves,
+	const DynamicArrayAuto<U8>& visited,
+	TTest test)
+{
+	for(U i = 0; i < boxes.getSize(); ++i)
+	{
+		if(leaves[i] == DynamicAabbTree::NULL_NODE)
+		{
+			ANKI_TEST_EXPECT_EQ(visited[i], 0);
+			continue;
+		}
+
+		if(test(boxes[i]))
+		{
+			ANKI_TEST_EXPECT_EQ(visited[i], 1);
+		}
+
+		if(visited[i])
+		{
+			Vec4 fatMin, fatMax;
+			tree.getFatAabb(leaves[i], fatMin, fatMax);
+			ANKI_TEST_EXPECT_EQ(test(Aabb(fatMin, fatMax)), true);
+		}
+	}
+}
+
+ANKI_TEST(Collision, DynamicAabbTree)
+{
+	HeapAllocator<U8> halloc(allocAligned, nullptr);
+	CollisionAllocator<U8> alloc(allocAligned, nullptr, 1024 * 64);
+	const U COUNT = 3000;
+
+	DynamicAabbTree tree;
+	tree.init(0.2);
+
+	DynamicArrayAuto<Aabb> boxes(halloc);
+	boxes.create(COUNT);
+	DynamicArrayAuto<U32> leaves(halloc);
+	leaves.create(COUNT);
+	DynamicArrayAuto<U8> visited(halloc);
+	visited.create(COUNT);
+
+	// Insert
+	for(U i = 0; i < COUNT; ++i)
+	{
+		boxes[i] = randomBox();
+		leaves[i] = tree.newLeaf(alloc, boxes[i], i);
+	}
+
+	ANKI_TEST_EXPECT_EQ(tree.getLeafCount(), COUNT);
+	ANKI_TEST_EXPECT_LEQ(tree.getHeight(), 24);
+
+	// Move some a little and some a lot
+	U reinsertedCount = 0;
+	for(U i = 0; i < COUNT; i += 2)
+	{
+		if(i % 4 == 0)
+		{
+			const Vec4 offset(0.05, 0.0, -0.05, 0.0);
+			boxes[i] = Aabb(boxes[i].getMin() + offset,
+				boxes[i].getMax() + offset);
+		}
+		else
+		{
+			boxes[i] = randomBox();
+		}
+
+		reinsertedCount += tree.moveLeaf(leaves[i], boxes[i]);
+		ANKI_TEST_EXPECT_EQ(tree.getUserData(leaves[i]), i);
+	}
+
+	ANKI_TEST_EXPECT_LEQ(reinsertedCount, COUNT / 4 + 1);
+
+	// Delete some
+	for(U i = 1; i < COUNT; i += 3)
+	{
+		tree.deleteLeaf(leaves[i]);
+		leaves[i] = DynamicAabbTree::NULL_NODE;
+	}
+
+	ANKI_TEST_EXPECT_LEQ(tree.getHeight(), 24);
+
+	// Frustum
+	PerspectiveFrustum fr(toRad(70.0f), toRad(50.0f), 0.1f, 150.0f);
+	fr.resetTransform(Transform(Vec4(5.0, 2.0, 10.0, 0.0),
+		Mat3x4(Euler(toRad(-10.0f), toRad(30.0f), 0.0f)),
+		1.0));
+	const auto& planes = fr.getPlanesWorldSpace();
+
+	memset(&visited[0], 0, COUNT);
+	U visitedCount = 0;
+	tree.visitPlanes(&planes[0], planes.getSize(), [&](U32 userData) {
+		++visited[userData];
+		++visitedCount;
+	});
+
+	ANKI_TEST_EXPECT_GT(visitedCount, 0);
+	checkVisited(tree, boxes, leaves, visited, [&](const Aabb& box) {
+		return fr.insideFrustum(box);
+	});
+
+	// Sphere
+	const Sphere sphere(Vec4(10.0, 0.0, -20.0, 0.0), 30.0);
+	memset(&visited[0], 0, COUNT);
+	visitedCount = 0;
+	tree.visitSphere(
+		sphere.getCenter(), sphere.getRadius(), [&](U32 userData) {
+			++visited[userData];
+			++visitedCount;
+		});
+
+	ANKI_TEST_EXPECT_GT(visitedCount, 0);
+	checkVisited(tree, boxes, leaves, visited, [&](const Aabb& box) {
+		return testCollisionShapes(sphere, box);
+	});
+
+	// Ray. Aim at one of the boxes
+	const Vec4 origin(-210.0, 0.0, -1.0, 0.0);
+	const Vec4 target = (boxes[3].getMin() + boxes[3].getMax()) * 0.5;
+	const Vec4 dir = (target - origin).getNormalized();
+	const F32 length = 500.0;
+	const LineSegment segment(origin, dir * length);
+	memset(&visited[0], 0, COUNT);
+	visitedCount = 0;
+	tree.visitRay(origin, dir, length, [&](U32 userData) {
+		++visited[userData];
+		++visitedCount;
+	});
+
+	ANKI_TEST_EXPECT_GT(visitedCount, 0);
+	checkVisited(tree, boxes, leaves, visited, [&](const Aabb& box) {
+		return testCollisionShapes(segment, box);
+	});
+
+	// Delete the rest
+	for(U i = 0; i < COUNT; ++i)
+	{
+		if(leaves[i] != DynamicAabbTree::NULL_NODE)
+		{
+			tree.deleteLeaf(leaves[i]);
+		}
+	}
+
+	ANKI_TEST_EXPECT_EQ(tree.getLeafCount(), 0);
+	ANKI_TEST_EXPECT_EQ(tree.getHeight(), 0);
+
+	tree.destroy(alloc);
+}
+
+ANKI_TEST(Collision, DynamicAabbTreeBench)
+{
+	HeapAllocator<U8> halloc(allocAligned, nullptr);
+	CollisionAllocator<U8> alloc(allocAligned, nullptr, 1024 * 1024);
+	const U COUNT = 100000;
+	const U ITERATIONS = 10;
+
+	DynamicAabbTree tree;
+	tree.init(0.2);
+
+	DynamicArrayAuto<Aabb> boxes(halloc);
+	boxes.create(COUNT);
+
+	HighRezTimer timer;
+	timer.start();
+	for(U i = 0; i < COUNT; ++i)
+	{
+		boxes[i] = randomBox();
+		tree.newLeaf(alloc, boxes[i], i);
+	}
+	timer.stop();
+	printf("Insert %u: %f\n", U32(COUNT), timer.getElapsedTime());
+
+	PerspectiveFrustum fr(toRad(70.0f), toRad(50.0f), 0.1f, 80.0f);
+	const auto& planes = fr.getPlanesWorldSpace();
+
+	// Brute force
+	U32 checksum = 0;
+	timer.start();
+	for(U it = 0; it < ITERATIONS; ++it)
+	{
+		for(U i = 0; i < COUNT; ++i)
+		{
+			checksum += fr.insideFrustum(boxes[i]);
+		}
+	}
+	timer.stop();
+	const HighRezTimer::Scalar bruteTime = timer.getElapsedTime();
+
+	// Tree
+	timer.start();
+	for(U it = 0; it < ITERATIONS; ++it)
+	{
+		tree.visitPlanes(&planes[0], planes.getSize(), [&](U32 userData) {
+			checksum += userData;
+		});
+	}
+	timer.stop();
+	const HighRezTimer::Scalar treeTime = timer.getElapsedTime();
+
+	printf("Frustum: brute force %f tree %f | %f%% | height %u\n",
+		bruteTime,
+		treeTime,
+		treeTime / bruteTime * 100.0,
+		tree.getHeight());
+
+	ANKI_TEST_EXPECT_GT(checksum, 0);
+
+	tree.destroy(alloc);
+}
@@ -0,0 +1,52 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/gr/common/GpuBlockAllocator.h>
+
+namespace anki
+{
+
+ANKI_TEST(Gr, GpuBlockAllocator)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const PtrSize BLOCK_SIZE = 1024;
+
+	GpuBlockAllocator galloc;
+	galloc.init(alloc, BLOCK_SIZE * 4, BLOCK_SIZE);
+
+	// Many allocations fit in the same block
+	PtrSize a, b, c;
+	ANKI_TEST_EXPECT_NO_ERR(galloc.allocate(100, 16, a));
+	ANKI_TEST_EXPECT_NO_ERR(galloc.allocate(100, 16, b));
+	ANKI_TEST_EXPECT_EQ(a / BLOCK_SIZE, b / BLOCK_SIZE);
+	ANKI_TEST_EXPECT_EQ(b % 16, 0);
+	ANKI_TEST_EXPECT_GEQ(b, a + 100);
+
+	// That doesn't fit so it goes to another block
+	ANKI_TEST_EXPECT_NO_ERR(galloc.allocate(1000, 4, c));
+	ANKI_TEST_EXPECT_NEQ(a / BLOCK_SIZE, c / BLOCK_SIZE);
+	ANKI_TEST_EXPECT_EQ(c % BLOCK_SIZE, 0);
+
+	// Fill the rest of the blocks
+	PtrSize d, e;
+	ANKI_TEST_EXPECT_NO_ERR(galloc.allocate(1000, 4, d));
+	ANKI_TEST_EXPECT_NO_ERR(galloc.allocate(1000, 4, e));
+	PtrSize f;
+	ANKI_TEST_EXPECT_ERR(galloc.allocate(1000, 4, f), ErrorCode::OUT_OF_MEMORY);
+
+	// Free a block and use it again
+	galloc.free(d);
+	ANKI_TEST_EXPECT_NO_ERR(galloc.allocate(1000, 4, f));
+	ANKI_TEST_EXPECT_EQ(f, d);
+
+	galloc.free(a);
+	galloc.free(b);
+	galloc.free(c);
+	galloc.free(e);
+	galloc.free(f);
+}
+
+} // end namespace anki
@@ -0,0 +1,212 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/gr/common/GpuFrameRingAllocator.h>
+#include <anki/util/Thread.h>
+#include <vector>
+#include <algorithm>
+
+namespace anki
+{
+
+/// Pretends to create the memory of the pages.
+class TestPageInterface : public GpuFrameRingAllocatorPageInterface
+{
+public:
+	Array<PtrSize, GpuFrameRingAllocator::MAX_PAGES> m_sizes = {{}};
+	U32 m_createCount = 0;
+	U32 m_destroyCount = 0;
+
+	Error createPage(U32 page, PtrSize size) override
+	{
+		ANKI_TEST_EXPECT_EQ(m_sizes[page], 0);
+		m_sizes[page] = size;
+		++m_createCount;
+		return ErrorCode::NONE;
+	}
+
+	void destroyPage(U32 page) override
+	{
+		ANKI_TEST_EXPECT_GT(m_sizes[page], 0);
+		m_sizes[page] = 0;
+		++m_destroyCount;
+	}
+};
+
+class TestAllocation
+{
+public:
+	U32 m_page;
+	PtrSize m_offset;
+	PtrSize m_size;
+
+	Bool operator<(const TestAllocation& b) const
+	{
+		return (m_page != b.m_page) ? (m_page < b.m_page)
+									: (m_offset < b.m_offset);
+	}
+};
+
+/// Check that the allocations of a frame are inside their pages and that they
+/// don't overlap.
+static void checkAllocations(std::vector<TestAllocation>& allocs,
+	const TestPageInterface& pages,
+	PtrSize ringSize)
+{
+	std::sort(allocs.begin(), allocs.end());
+	for(U i = 0; i < allocs.size(); ++i)
+	{
+		const TestAllocation& a = allocs[i];
+		const PtrSize pageSize = (a.m_page == GpuFrameRingAllocator::MAIN_PAGE)
+			? ringSize
+			: pages.m_sizes[a.m_page];
+		ANKI_TEST_EXPECT_LEQ(a.m_offset + a.m_size, pageSize);
+
+		if(i > 0 && allocs[i - 1].m_page == a.m_page)
+		{
+			ANKI_TEST_EXPECT_LEQ(
+				allocs[i - 1].m_offset + allocs[i - 1].m_size, a.m_offset);
+		}
+	}
+}
+
+class TestThreadContext
+{
+public:
+	GpuFrameRingAllocator* m_alloc;
+	std::vector<TestAllocation> m_allocs;
+};
+
+ANKI_TEST(Gr, GpuFrameRingAllocator)
+{
+	const PtrSize PER_FRAME_SIZE = 64 * 1024;
+	const PtrSize RING_SIZE = PER_FRAME_SIZE * MAX_FRAMES_IN_FLIGHT;
+	const U32 ALIGNMENT = 16;
+
+	// Without pages it runs out of memory
+	{
+		GpuFrameRingAllocator alloc;
+		alloc.init(RING_SIZE, ALIGNMENT);
+
+		PtrSize offset;
+		ANKI_TEST_EXPECT_NO_ERR(alloc.allocate(PER_FRAME_SIZE, offset));
+		ANKI_TEST_EXPECT_EQ(offset, 0);
+		ANKI_TEST_EXPECT_ERR(
+			alloc.allocate(ALIGNMENT, offset), ErrorCode::OUT_OF_MEMORY);
+		ANKI_TEST_EXPECT_EQ(alloc.getUnallocatedMemorySize(), 0);
+
+		alloc.endFrame();
+		ANKI_TEST_EXPECT_NO_ERR(alloc.allocate(ALIGNMENT, offset));
+		ANKI_TEST_EXPECT_EQ(offset, PER_FRAME_SIZE);
+		alloc.destroy();
+	}
+
+	// Overflow
+	TestPageInterface pages;
+	GpuFrameRingAllocator alloc;
+	alloc.init(RING_SIZE, ALIGNMENT, MAX_PTR_SIZE, &pages);
+
+	std::vector<TestAllocation> allocs;
+	for(U frame = 0; frame < MAX_FRAMES_IN_FLIGHT * 2; ++frame)
+	{
+		// Mix small allocations that go to the sub-blocks and big ones
+		allocs.clear();
+		PtrSize allocated = 0;
+		for(U i = 0; allocated < PER_FRAME_SIZE * 5 / 2; ++i)
+		{
+			TestAllocation a;
+			a.m_size = (i % 8 == 0) ? 5000 : 40;
+			ANKI_TEST_EXPECT_NO_ERR(
+				alloc.allocate(a.m_size, a.m_offset, a.m_page));
+			ANKI_TEST_EXPECT_EQ(a.m_offset % ALIGNMENT, 0);
+			allocs.push_back(a);
+			allocated += a.m_size;
+		}
+
+		checkAllocations(allocs, pages, RING_SIZE);
+		alloc.endFrame();
+	}
+
+	// Every frame needs 2 pages. They are recycled after the GPU is done with
+	// them
+	ANKI_TEST_EXPECT_EQ(
+		alloc.getOverflowPageCount(), 2 * MAX_FRAMES_IN_FLIGHT);
+	ANKI_TEST_EXPECT_EQ(pages.m_createCount, 2 * MAX_FRAMES_IN_FLIGHT);
+	ANKI_TEST_EXPECT_GEQ(alloc.getHighWaterMark(), PER_FRAME_SIZE * 5 / 2);
+
+	// A big allocation gets its own page
+	{
+		TestAllocation a;
+		a.m_size = PER_FRAME_SIZE * 2;
+		ANKI_TEST_EXPECT_NO_ERR(
+			alloc.allocate(a.m_size, a.m_offset, a.m_page));
+		ANKI_TEST_EXPECT_NEQ(a.m_page, GpuFrameRingAllocator::MAIN_PAGE);
+		ANKI_TEST_EXPECT_GEQ(pages.m_sizes[a.m_page], a.m_size);
+		alloc.endFrame();
+	}
+
+	// Some quiet frames release the pages
+	for(U frame = 0; frame <= GpuFrameRingAllocator::PAGE_RELEASE_FRAME_COUNT;
+		++frame)
+	{
+		PtrSize offset;
+		U32 page;
+		ANKI_TEST_EXPECT_NO_ERR(alloc.allocate(1024, offset, page));
+		ANKI_TEST_EXPECT_EQ(page, GpuFrameRingAllocator::MAIN_PAGE);
+		alloc.endFrame();
+	}
+
+	ANKI_TEST_EXPECT_EQ(alloc.getOverflowPageCount(), 0);
+	ANKI_TEST_EXPECT_EQ(pages.m_destroyCount, pages.m_createCount);
+
+	// Many threads
+	const U THREAD_COUNT = 4;
+	Array<TestThreadContext, THREAD_COUNT> contexts;
+	for(U frame = 0; frame < 3; ++frame)
+	{
+		Array<Thread*, THREAD_COUNT> threads;
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			contexts[i].m_alloc = &alloc;
+			contexts[i].m_allocs.clear();
+
+			threads[i] = new Thread("test");
+			threads[i]->start(&contexts[i], [](Thread::Info& info) -> Error {
+				TestThreadContext& ctx =
+					*static_cast<TestThreadContext*>(info.m_userData);
+				for(U j = 0; j < 500; ++j)
+				{
+					TestAllocation a;
+					a.m_size = 16 + (j % 7) * 16;
+					ANKI_CHECK(ctx.m_alloc->allocate(
+						a.m_size, a.m_offset, a.m_page));
+					ctx.m_allocs.push_back(a);
+				}
+
+				return ErrorCode::NONE;
+			});
+		}
+
+		allocs.clear();
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(threads[i]->join());
+			delete threads[i];
+
+			allocs.insert(allocs.end(),
+				contexts[i].m_allocs.begin(),
+				contexts[i].m_allocs.end());
+		}
+
+		checkAllocations(allocs, pages, RING_SIZE);
+		alloc.endFrame();
+	}
+
+	alloc.destroy();
+	ANKI_TEST_EXPECT_EQ(pages.m_destroyCount, pages.m_createCount);
+}
+
+} // end namespace anki
@@ -0,0 +1,178 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/Gr.h>
+
+#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_NULL
+
+#include <anki/gr/null/GrManagerImpl.h>
+#include <anki/core/Config.h>
+
+namespace anki
+{
+
+//==============================================================================
+static GrManager* createNullGrManager(Config& cfg)
+{
+	GrManager* gr = new GrManager();
+
+	GrManagerInitInfo inf;
+	inf.m_allocCallback = allocAligned;
+	inf.m_cacheDirectory = "./";
+	inf.m_config = &cfg;
+	ANKI_TEST_EXPECT_NO_ERR(gr->init(inf));
+
+	return gr;
+}
+
+//==============================================================================
+ANKI_TEST(Gr, NullBackend)
+{
+	Config cfg;
+	GrManager* gr = createNullGrManager(cfg);
+	GrManagerImpl& impl = gr->getImplementation();
+
+	{
+		// Mapped buffers
+		BufferPtr buff = gr->newInstance<Buffer>(64,
+			BufferUsageBit::STORAGE_ANY | BufferUsageBit::TRANSFER_DESTINATION,
+			BufferMapAccessBit::WRITE | BufferMapAccessBit::READ);
+
+		void* ptr = buff->map(0, 64, BufferMapAccessBit::WRITE);
+		ANKI_TEST_EXPECT_NEQ(ptr, nullptr);
+		memset(ptr, 0xCC, 64);
+		buff->unmap();
+
+		// Upload through transient memory
+		TransientMemoryToken token;
+		U8* data = static_cast<U8*>(gr->allocateFrameTransientMemory(
+			32, BufferUsageBit::TRANSFER_SOURCE, token));
+		ANKI_TEST_EXPECT_NEQ(data, nullptr);
+		memset(data, 0xAB, 32);
+
+		// Some objects to draw with
+		ShaderPtr vert = gr->newInstance<Shader>(ShaderType::VERTEX, "void");
+		ShaderPtr frag = gr->newInstance<Shader>(ShaderType::FRAGMENT, "void");
+		PipelineInitInfo pinit;
+		pinit.m_shaders[ShaderType::VERTEX] = vert;
+		pinit.m_shaders[ShaderType::FRAGMENT] = frag;
+		PipelinePtr ppline = gr->newInstance<Pipeline>(pinit);
+
+		FramebufferInitInfo fbinit;
+		fbinit.m_colorAttachmentCount = 1;
+		FramebufferPtr fb = gr->newInstance<Framebuffer>(fbinit);
+
+		ResourceGroupInitInfo rcinit;
+		rcinit.m_storageBuffers[0].m_buffer = buff;
+		rcinit.m_uniformBuffers[0].m_uploadedMemory = true;
+		ResourceGroupPtr rc = gr->newInstance<ResourceGroup>(rcinit);
+
+		TransientMemoryInfo transientInfo;
+		gr->allocateFrameTransientMemory(sizeof(Vec4),
+			BufferUsageBit::UNIFORM_ANY_SHADER,
+			transientInfo.m_uniformBuffers[0]);
+
+		// Record a second level command buffer
+		CommandBufferInitInfo cinit;
+		cinit.m_flags = CommandBufferFlag::SECOND_LEVEL;
+		cinit.m_framebuffer = fb;
+		CommandBufferPtr cmdb2 = gr->newInstance<CommandBuffer>(cinit);
+		cmdb2->bindPipeline(ppline);
+		cmdb2->bindResourceGroup(rc, 0, &transientInfo);
+		cmdb2->drawElements(36, 2);
+
+		// And the primary
+		CommandBufferPtr cmdb =
+			gr->newInstance<CommandBuffer>(CommandBufferInitInfo());
+		ANKI_TEST_EXPECT_EQ(cmdb->isEmpty(), true);
+		cmdb->uploadBuffer(buff, 16, token);
+		cmdb->setViewport(0, 0, 64, 64);
+		cmdb->setPolygonOffset(0.0, 0.0);
+		cmdb->bindPipeline(ppline);
+		cmdb->beginRenderPass(fb);
+		cmdb->drawArrays(3);
+		cmdb->pushSecondLevelCommandBuffer(cmdb2);
+		cmdb->endRenderPass();
+		ANKI_TEST_EXPECT_EQ(cmdb->isEmpty(), false);
+
+		// Nothing runs before the flush
+		ANKI_TEST_EXPECT_EQ(impl.getStatistics().m_drawcallCount, 0);
+		cmdb->flush();
+
+		GrStatistics stats = impl.getStatistics();
+		ANKI_TEST_EXPECT_EQ(stats.m_commandBufferCount, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_commandCount, 11);
+		ANKI_TEST_EXPECT_EQ(stats.m_drawcallCount, 2);
+		ANKI_TEST_EXPECT_EQ(stats.m_instanceCount, 3);
+		ANKI_TEST_EXPECT_EQ(stats.m_vertexCount, 3 + 36 * 2);
+		ANKI_TEST_EXPECT_EQ(stats.m_renderPassCount, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_pipelineBindCount, 2);
+		ANKI_TEST_EXPECT_EQ(stats.m_resourceGroupBindCount, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_uploadedBytes, 32);
+		ANKI_TEST_EXPECT_GEQ(stats.m_transientBytes, 32 + sizeof(Vec4));
+
+		// The upload reached the buffer
+		ptr = buff->map(0, 64, BufferMapAccessBit::READ);
+		const U8* bytes = static_cast<const U8*>(ptr);
+		ANKI_TEST_EXPECT_EQ(bytes[15], 0xCC);
+		ANKI_TEST_EXPECT_EQ(bytes[16], 0xAB);
+		ANKI_TEST_EXPECT_EQ(bytes[47], 0xAB);
+		ANKI_TEST_EXPECT_EQ(bytes[48], 0xCC);
+		buff->unmap();
+
+		impl.resetStatistics();
+		ANKI_TEST_EXPECT_EQ(impl.getStatistics().m_drawcallCount, 0);
+		ANKI_TEST_EXPECT_EQ(impl.getStatistics().m_transientBytes, 0);
+	}
+
+	// The transient memory gets recycled
+	for(U i = 0; i < MAX_FRAMES_IN_FLIGHT * 4; ++i)
+	{
+		gr->beginFrame();
+
+		Error err = ErrorCode::NONE;
+		TransientMemoryToken token;
+		void* ptr = gr->allocateFrameTransientMemory(
+			1024 * 1024, BufferUsageBit::VERTEX, token, &err);
+		ANKI_TEST_EXPECT_NO_ERR(err);
+		ANKI_TEST_EXPECT_NEQ(ptr, nullptr);
+
+		gr->swapBuffers();
+	}
+
+	ANKI_TEST_EXPECT_EQ(impl.getFrameCount(), MAX_FRAMES_IN_FLIGHT * 4);
+
+	// A frame that doesn't fit chains an overflow page
+	{
+		TransientMemoryManager& transMem = impl.getTransientMemoryManager();
+		const PtrSize size =
+			cfg.getNumber("gr.transferPerFrameMemorySize") * 2;
+
+		gr->beginFrame();
+
+		Error err = ErrorCode::NONE;
+		TransientMemoryToken token;
+		U8* ptr = static_cast<U8*>(gr->allocateFrameTransientMemory(
+			size, BufferUsageBit::TRANSFER_SOURCE, token, &err));
+		ANKI_TEST_EXPECT_NO_ERR(err);
+		ANKI_TEST_EXPECT_NEQ(ptr, nullptr);
+		ANKI_TEST_EXPECT_EQ(
+			ptr, transMem.getBaseAddress(token) + token.m_offset);
+		memset(ptr, 0xAB, size);
+
+		ANKI_TEST_EXPECT_EQ(
+			transMem.getOverflowPageCount(TransientBufferType::TRANSFER), 1);
+		gr->swapBuffers();
+		ANKI_TEST_EXPECT_GEQ(
+			transMem.getHighWaterMark(TransientBufferType::TRANSFER), size);
+	}
+
+	delete gr;
+}
+
+} // end namespace anki
+
+#endif
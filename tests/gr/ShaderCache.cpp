@@ -0,0 +1,105 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/gr/common/ShaderCache.h>
+#include <anki/util/File.h>
+#include <anki/util/Filesystem.h>
+
+namespace anki
+{
+
+ANKI_TEST(Gr, ShaderCache)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const CString dir = "./shader_cache";
+
+	if(directoryExists(dir))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+
+	const char* src = "void main() {}";
+	const Array<U8, 5> spirv = {{1, 2, 3, 4, 5}};
+	U64 key;
+
+	// Store in one run
+	{
+		ShaderCache cache;
+		ANKI_TEST_EXPECT_NO_ERR(cache.init(alloc, dir, 0xAA));
+		ANKI_TEST_EXPECT_EQ(cache.isEnabled(), true);
+
+		key = cache.computeKey(src, strlen(src));
+
+		DynamicArrayAuto<U8> blob(alloc);
+		Bool found;
+		ANKI_TEST_EXPECT_NO_ERR(cache.load(key, blob, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+
+		ANKI_TEST_EXPECT_NO_ERR(cache.store(key, &spirv[0], spirv.getSize()));
+		ANKI_TEST_EXPECT_EQ(cache.getMissCount(), 1);
+	}
+
+	// Load in the next
+	{
+		ShaderCache cache;
+		ANKI_TEST_EXPECT_NO_ERR(cache.init(alloc, dir, 0xAA));
+		ANKI_TEST_EXPECT_EQ(cache.computeKey(src, strlen(src)), key);
+
+		DynamicArrayAuto<U8> blob(alloc);
+		Bool found;
+		ANKI_TEST_EXPECT_NO_ERR(cache.load(key, blob, found));
+		ANKI_TEST_EXPECT_EQ(found, true);
+		ANKI_TEST_EXPECT_EQ(blob.getSize(), spirv.getSize());
+		ANKI_TEST_EXPECT_EQ(memcmp(&blob[0], &spirv[0], spirv.getSize()), 0);
+		ANKI_TEST_EXPECT_EQ(cache.getHitCount(), 1);
+	}
+
+	// Corrupt the blob
+	{
+		StringAuto fname(alloc);
+		fname.sprintf("%s/shaders/%016llx.bin",
+			&dir[0],
+			static_cast<unsigned long long>(key));
+
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open(fname.toCString(),
+			File::OpenFlag::WRITE | File::OpenFlag::BINARY));
+		U8 garbage[64] = {};
+		ANKI_TEST_EXPECT_NO_ERR(file.write(&garbage[0], sizeof(garbage)));
+	}
+
+	{
+		ShaderCache cache;
+		ANKI_TEST_EXPECT_NO_ERR(cache.init(alloc, dir, 0xAA));
+
+		DynamicArrayAuto<U8> blob(alloc);
+		Bool found;
+		ANKI_TEST_EXPECT_NO_ERR(cache.load(key, blob, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+
+		// The next store repairs it
+		ANKI_TEST_EXPECT_NO_ERR(cache.store(key, &spirv[0], spirv.getSize()));
+		ANKI_TEST_EXPECT_NO_ERR(cache.load(key, blob, found));
+		ANKI_TEST_EXPECT_EQ(found, true);
+	}
+
+	// A different driver drops the cache
+	{
+		ShaderCache cache;
+		ANKI_TEST_EXPECT_NO_ERR(cache.init(alloc, dir, 0xBB));
+
+		DynamicArrayAuto<U8> blob(alloc);
+		Bool found;
+		ANKI_TEST_EXPECT_NO_ERR(cache.load(key, blob, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+		ANKI_TEST_EXPECT_NEQ(cache.computeKey(src, strlen(src)), key);
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+}
+
+} // end namespace anki
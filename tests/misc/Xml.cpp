@@ -0,0 +1,139 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/misc/Xml.h"
+
+namespace anki
+{
+
+static const char* XML = R"(<?xml version="1.0" encoding="UTF-8" ?>
+<model>
+	<name>box</name>
+	<count>12</count>
+	<scale>0.5</scale>
+	<position>1.0 2.0 3.0</position>
+	<modelPatches>
+		<modelPatch><mesh>a.ankimesh</mesh></modelPatch>
+		<modelPatch><mesh>b.ankimesh</mesh></modelPatch>
+		<modelPatch><mesh>c.ankimesh</mesh></modelPatch>
+	</modelPatches>
+</model>)";
+
+//==============================================================================
+static void testDocument(const XmlDocument& doc)
+{
+	XmlElement rootEl;
+	ANKI_TEST_EXPECT_NO_ERR(doc.getChildElement("model", rootEl));
+
+	// Text
+	XmlElement el;
+	CString txt;
+	ANKI_TEST_EXPECT_NO_ERR(rootEl.getChildElement("name", el));
+	ANKI_TEST_EXPECT_NO_ERR(el.getText(txt));
+	ANKI_TEST_EXPECT_EQ(txt, "box");
+
+	// Numbers
+	I64 i;
+	ANKI_TEST_EXPECT_NO_ERR(rootEl.getChildElement("count", el));
+	ANKI_TEST_EXPECT_NO_ERR(el.getI64(i));
+	ANKI_TEST_EXPECT_EQ(i, 12);
+
+	F64 f;
+	ANKI_TEST_EXPECT_NO_ERR(rootEl.getChildElement("scale", el));
+	ANKI_TEST_EXPECT_NO_ERR(el.getF64(f));
+	ANKI_TEST_EXPECT_EQ(f, 0.5);
+
+	Vec3 v;
+	ANKI_TEST_EXPECT_NO_ERR(rootEl.getChildElement("position", el));
+	ANKI_TEST_EXPECT_NO_ERR(el.getVec3(v));
+	ANKI_TEST_EXPECT_EQ(v, Vec3(1.0, 2.0, 3.0));
+	Vec4 v4;
+	ANKI_TEST_EXPECT_ANY_ERR(el.getVec4(v4));
+
+	// Siblings
+	ANKI_TEST_EXPECT_NO_ERR(rootEl.getChildElement("modelPatches", el));
+	XmlElement patchEl;
+	ANKI_TEST_EXPECT_NO_ERR(el.getChildElement("modelPatch", patchEl));
+
+	U32 count;
+	ANKI_TEST_EXPECT_NO_ERR(patchEl.getSiblingElementsCount(count));
+	ANKI_TEST_EXPECT_EQ(count, 2);
+
+	U patches = 0;
+	while(patchEl)
+	{
+		XmlElement meshEl;
+		ANKI_TEST_EXPECT_NO_ERR(patchEl.getChildElement("mesh", meshEl));
+		ANKI_TEST_EXPECT_NO_ERR(meshEl.getText(txt));
+		ANKI_TEST_EXPECT_EQ(U(txt[0]), 'a' + patches);
+
+		++patches;
+		ANKI_TEST_EXPECT_NO_ERR(
+			patchEl.getNextSiblingElement("modelPatch", patchEl));
+	}
+	ANKI_TEST_EXPECT_EQ(patches, 3);
+
+	// Missing
+	ANKI_TEST_EXPECT_NO_ERR(rootEl.getChildElementOptional("mesh", el));
+	ANKI_TEST_EXPECT_EQ(!el, true);
+	ANKI_TEST_EXPECT_ANY_ERR(rootEl.getChildElement("mesh", el));
+}
+
+//==============================================================================
+ANKI_TEST(Misc, XmlBaked)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	XmlDocument doc;
+	ANKI_TEST_EXPECT_NO_ERR(doc.parse(XML, alloc));
+	ANKI_TEST_EXPECT_EQ(doc.isBaked(), false);
+	testDocument(doc);
+
+	DynamicArrayAuto<U8> blob(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(doc.bake(blob));
+
+	// Load it from unaligned memory
+	DynamicArrayAuto<U8> unaligned(alloc);
+	unaligned.create(blob.getSize() + 1);
+	memcpy(&unaligned[1], &blob[0], blob.getSize());
+
+	{
+		XmlDocument baked;
+		ANKI_TEST_EXPECT_NO_ERR(
+			baked.parseBaked(&unaligned[1], blob.getSize(), alloc));
+		ANKI_TEST_EXPECT_EQ(baked.isBaked(), true);
+		testDocument(baked);
+	}
+
+	// Stale
+	ANKI_TEST_EXPECT_EQ(
+		XmlDocument::isBakedFromText(&blob[0], blob.getSize(), XML), true);
+	ANKI_TEST_EXPECT_EQ(XmlDocument::isBakedFromText(
+							&unaligned[1], blob.getSize(), XML),
+		true);
+	ANKI_TEST_EXPECT_EQ(
+		XmlDocument::isBakedFromText(&blob[0], blob.getSize(), &XML[1]),
+		false);
+	ANKI_TEST_EXPECT_EQ(
+		XmlDocument::isBakedFromText(&blob[0], 8, XML), false);
+
+	// Corrupted
+	{
+		XmlDocument baked;
+		ANKI_TEST_EXPECT_ANY_ERR(
+			baked.parseBaked(&blob[0], blob.getSize() - 1, alloc));
+		ANKI_TEST_EXPECT_EQ(baked.isBaked(), false);
+	}
+
+	{
+		blob[0] = 'X';
+		XmlDocument baked;
+		ANKI_TEST_EXPECT_ANY_ERR(
+			baked.parseBaked(&blob[0], blob.getSize(), alloc));
+	}
+}
+
+} // end namespace anki
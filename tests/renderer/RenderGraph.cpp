@@ -0,0 +1,183 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/Gr.h>
+
+#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_NULL
+
+#include <anki/renderer/RenderGraph.h>
+#include <anki/renderer/Renderer.h>
+#include <anki/core/Config.h>
+
+namespace anki
+{
+
+class RenderGraphTestContext
+{
+public:
+	Array<U32, 8> m_runOrder;
+	U32 m_runCount = 0;
+	Atomic<U32> m_buildCount = {0};
+	Atomic<U32> m_culledBuildCount = {0};
+};
+
+class RenderGraphTestPass
+{
+public:
+	RenderGraphTestContext* m_ctx;
+	U32 m_idx;
+};
+
+static Error testRun(void* userData, RenderingContext&)
+{
+	RenderGraphTestPass& pass = *static_cast<RenderGraphTestPass*>(userData);
+	pass.m_ctx->m_runOrder[pass.m_ctx->m_runCount++] = pass.m_idx;
+	return ErrorCode::NONE;
+}
+
+static Error testBuild(void* userData, RenderingContext&, U, U)
+{
+	RenderGraphTestPass& pass = *static_cast<RenderGraphTestPass*>(userData);
+	pass.m_ctx->m_buildCount.fetchAdd(1);
+	return ErrorCode::NONE;
+}
+
+static Error testBuildCulled(void* userData, RenderingContext&, U, U)
+{
+	RenderGraphTestPass& pass = *static_cast<RenderGraphTestPass*>(userData);
+	pass.m_ctx->m_culledBuildCount.fetchAdd(1);
+	return ErrorCode::NONE;
+}
+
+static TextureInitInfo newRtInit(PixelFormat fmt, SamplingFilter filter)
+{
+	TextureInitInfo init;
+	init.m_width = init.m_height = 64;
+	init.m_depth = init.m_layerCount = 1;
+	init.m_format = fmt;
+	init.m_mipmapsCount = 1;
+	init.m_sampling.m_minMagFilter = filter;
+	return init;
+}
+
+ANKI_TEST(Renderer, RenderGraph)
+{
+	Config cfg;
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	GrManager* gr = new GrManager();
+
+	GrManagerInitInfo inf;
+	inf.m_allocCallback = allocAligned;
+	inf.m_cacheDirectory = "./";
+	inf.m_config = &cfg;
+	ANKI_TEST_EXPECT_NO_ERR(gr->init(inf));
+
+	{
+		RenderGraphTestContext ctx;
+		Array<RenderGraphTestPass, 5> userData;
+		for(U i = 0; i < userData.getSize(); ++i)
+		{
+			userData[i].m_ctx = &ctx;
+			userData[i].m_idx = i;
+		}
+
+		RenderGraph g;
+		g.init(gr, alloc);
+
+		const PixelFormat rgba(
+			ComponentFormat::R8G8B8A8, TransformFormat::UNORM);
+		const PixelFormat rgb(ComponentFormat::R8G8B8, TransformFormat::UNORM);
+		const U32 a =
+			g.newTexture("A", newRtInit(rgba, SamplingFilter::NEAREST));
+		const U32 b =
+			g.newTexture("B", newRtInit(rgba, SamplingFilter::NEAREST));
+		const U32 c =
+			g.newTexture("C", newRtInit(rgba, SamplingFilter::LINEAR));
+		const U32 d =
+			g.newTexture("D", newRtInit(rgb, SamplingFilter::NEAREST));
+		const U32 buff = g.importBuffer("Buffer");
+		g.setImportedBuffer(buff,
+			gr->newInstance<Buffer>(64,
+				BufferUsageBit::STORAGE_ANY,
+				BufferMapAccessBit::NONE));
+		g.markOutput(c);
+
+		const TextureUsageBit write =
+			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE;
+		const TextureUsageBit read = TextureUsageBit::FRAGMENT_SHADER_SAMPLED;
+
+		// A -> B -> C and a pass that writes something nobody reads
+		U32 p0 = g.newPass("0", testRun, &userData[0]);
+		g.writeTexture(p0, a, write);
+
+		U32 p1 = g.newPass("1", testRun, &userData[1], testBuild);
+		g.readTexture(p1, a, read);
+		g.writeTexture(p1, b, write);
+
+		U32 p2 = g.newPass("2", testRun, &userData[2], testBuildCulled);
+		g.readTexture(p2, b, read);
+		g.writeTexture(p2, d, write);
+
+		U32 p3 = g.newPass("3", testRun, &userData[3], testBuild);
+		g.readTexture(p3, b, read);
+		g.writeTexture(p3, c, write);
+
+		U32 p4 = g.newPass("4", testRun, &userData[4]);
+		g.writeBuffer(
+			p4, buff, BufferUsageBit::STORAGE_COMPUTE_SHADER_WRITE);
+		g.setSideEffects(p4);
+
+		ANKI_TEST_EXPECT_NO_ERR(g.compile());
+
+		// Culling
+		ANKI_TEST_EXPECT_EQ(g.isPassCulled(p0), false);
+		ANKI_TEST_EXPECT_EQ(g.isPassCulled(p1), false);
+		ANKI_TEST_EXPECT_EQ(g.isPassCulled(p2), true);
+		ANKI_TEST_EXPECT_EQ(g.isPassCulled(p3), false);
+		ANKI_TEST_EXPECT_EQ(g.isPassCulled(p4), false);
+
+		// Levels
+		ANKI_TEST_EXPECT_EQ(g.getPassDependencyLevel(p0), 0);
+		ANKI_TEST_EXPECT_EQ(g.getPassDependencyLevel(p1), 1);
+		ANKI_TEST_EXPECT_EQ(g.getPassDependencyLevel(p3), 2);
+		ANKI_TEST_EXPECT_EQ(g.getPassDependencyLevel(p4), 0);
+		ANKI_TEST_EXPECT_EQ(g.getDependencyLevelCount(), 3);
+
+		// C takes the memory of A since A is done before C starts
+		ANKI_TEST_EXPECT_EQ(g.getPhysicalTextureCount(), 2);
+		ANKI_TEST_EXPECT_EQ(g.getTexture(a), g.getTexture(c));
+		ANKI_TEST_EXPECT_NEQ(g.getTexture(a), g.getTexture(b));
+		ANKI_TEST_EXPECT_EQ(g.getSampler(a).isCreated(), false);
+		ANKI_TEST_EXPECT_EQ(g.getSampler(c).isCreated(), true);
+
+		// A/C: write, read, write. B: write, read. Buffer: write
+		ANKI_TEST_EXPECT_EQ(g.getBarrierCount(), 6);
+
+		// Run
+		StackAllocator<U8> stackAlloc(allocAligned, nullptr, 1024);
+		RenderingContext rctx(stackAlloc);
+		rctx.m_commandBuffer =
+			gr->newInstance<CommandBuffer>(CommandBufferInitInfo());
+
+		ThreadHive hive(3, alloc);
+		ANKI_TEST_EXPECT_NO_ERR(g.buildCommandBuffers(rctx, hive));
+		ANKI_TEST_EXPECT_EQ(ctx.m_buildCount.load(), 2 * 3);
+		ANKI_TEST_EXPECT_EQ(ctx.m_culledBuildCount.load(), 0);
+
+		ANKI_TEST_EXPECT_NO_ERR(g.run(rctx));
+		ANKI_TEST_EXPECT_EQ(ctx.m_runCount, 4);
+		ANKI_TEST_EXPECT_EQ(ctx.m_runOrder[0], 0);
+		ANKI_TEST_EXPECT_EQ(ctx.m_runOrder[1], 1);
+		ANKI_TEST_EXPECT_EQ(ctx.m_runOrder[2], 3);
+		ANKI_TEST_EXPECT_EQ(ctx.m_runOrder[3], 4);
+	}
+
+	delete gr;
+}
+
+} // end namespace anki
+
+#endif
@@ -104,6 +104,35 @@ public:
 	}
 };
 
+//==============================================================================
+class UploadTask : public AsyncLoaderTask
+{
+public:
+	PtrSize m_size;
+	Atomic<U32>* m_runs;
+
+	UploadTask(PtrSize size, Atomic<U32>* runs)
+		: m_size(size)
+		, m_runs(runs)
+	{
+		m_stage = AsyncLoaderStage::UPLOAD;
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx)
+	{
+		m_runs->fetchAdd(1);
+
+		while(m_size > 0 && ctx.m_uploadedBytes + 10 <= ctx.m_uploadBudget)
+		{
+			m_size -= 10;
+			ctx.m_uploadedBytes += 10;
+		}
+
+		ctx.m_resubmitTask = m_size > 0;
+		return ErrorCode::NONE;
+	}
+};
+
 //==============================================================================
 ANKI_TEST(Resource, AsyncLoader)
 {
@@ -275,6 +304,105 @@ ANKI_TEST(Resource, AsyncLoader)
 		barrier.wait();
 		ANKI_TEST_EXPECT_EQ(counter.load(), 10);
 	}
+
+	// Priorities
+	{
+		AsyncLoader a;
+		a.init(alloc);
+		Atomic<U32> counter(0);
+		Barrier barrier(2);
+
+		a.pause();
+
+		Task* low = a.newTask<Task>(0.0, &barrier, &counter, 1);
+		low->m_priority = -1.0;
+		a.submitTask(low);
+
+		Task* high = a.newTask<Task>(0.0, nullptr, &counter, 0);
+		high->m_priority = 1.0;
+		a.submitTask(high);
+
+		a.resume();
+		barrier.wait();
+		ANKI_TEST_EXPECT_EQ(counter.load(), 2);
+	}
+
+	// Dependencies and cancel
+	{
+		AsyncLoader a;
+		a.init(alloc, 2);
+		Atomic<U32> counter(0);
+		Barrier barrier(2);
+		AsyncLoaderFencePtr fence0, fence1, fence2;
+
+		a.submitTask(a.newTask<Task>(0.2, nullptr, &counter, 0), &fence0);
+
+		Task* task = a.newTask<Task>(0.0, nullptr, &counter, 1);
+		task->addDependency(fence0);
+		a.submitTask(task, &fence1);
+
+		task = a.newTask<Task>(0.0, nullptr, &counter);
+		task->addDependency(fence1);
+		a.submitTask(task, &fence2);
+		fence2->cancel();
+
+		task = a.newTask<Task>(0.0, &barrier, &counter, 2);
+		task->addDependency(fence2);
+		a.submitTask(task);
+
+		barrier.wait();
+		ANKI_TEST_EXPECT_EQ(counter.load(), 3);
+		ANKI_TEST_EXPECT_EQ(fence0->isSignaled(), true);
+		ANKI_TEST_EXPECT_EQ(fence1->isSignaled(), true);
+		ANKI_TEST_EXPECT_EQ(fence2->isSignaled(), true);
+	}
+
+	// Upload budget
+	{
+		AsyncLoader a;
+		a.init(alloc, 1, 20);
+		Atomic<U32> runs(0);
+		AsyncLoaderFencePtr fence;
+
+		a.submitTask(a.newTask<UploadTask>(50, &runs), &fence);
+		HighRezTimer::sleep(0.2);
+		ANKI_TEST_EXPECT_EQ(runs.load(), 1);
+
+		a.syncUploads();
+		a.newFrame();
+		HighRezTimer::sleep(0.2);
+		ANKI_TEST_EXPECT_EQ(runs.load(), 2);
+		ANKI_TEST_EXPECT_EQ(fence->isSignaled(), false);
+
+		a.syncUploads();
+		a.newFrame();
+		HighRezTimer::sleep(0.2);
+		ANKI_TEST_EXPECT_EQ(runs.load(), 3);
+		ANKI_TEST_EXPECT_EQ(fence->isSignaled(), true);
+		ANKI_TEST_EXPECT_EQ(fence->isFailed(), false);
+	}
+
+	// A failed upload doesn't stop the next ones
+	{
+		AsyncLoader a;
+		a.init(alloc, 1);
+		Atomic<U32> counter(0);
+		Atomic<U32> runs(0);
+		AsyncLoaderFencePtr fence0, fence1;
+
+		// Wrong order makes it fail
+		Task* task = a.newTask<Task>(0.0, nullptr, &counter, 1);
+		task->m_stage = AsyncLoaderStage::UPLOAD;
+		a.submitTask(task, &fence0);
+		a.submitTask(a.newTask<UploadTask>(10, &runs), &fence1);
+
+		HighRezTimer::sleep(0.2);
+		ANKI_TEST_EXPECT_EQ(fence0->isSignaled(), true);
+		ANKI_TEST_EXPECT_EQ(fence0->isFailed(), true);
+		ANKI_TEST_EXPECT_EQ(fence1->isSignaled(), true);
+		ANKI_TEST_EXPECT_EQ(fence1->isFailed(), false);
+		ANKI_TEST_EXPECT_EQ(runs.load(), 1);
+	}
 }
 
 } // end namespace anki
@@ -6,10 +6,166 @@
 #include "tests/framework/Framework.h"
 #define private public
 #include "anki/resource/ResourceFilesystem.h"
+#include "anki/util/Filesystem.h"
+#include <zlib.h>
 
 namespace anki
 {
 
+//==============================================================================
+static void write16(U8*& out, U32 v)
+{
+	out[0] = v & 0xFF;
+	out[1] = (v >> 8) & 0xFF;
+	out += 2;
+}
+
+//==============================================================================
+static void write32(U8*& out, U32 v)
+{
+	write16(out, v & 0xFFFF);
+	write16(out, v >> 16);
+}
+
+//==============================================================================
+static PtrSize deflateRaw(const U8* in, PtrSize size, U8* out, PtrSize outSize)
+{
+	z_stream s;
+	memset(&s, 0, sizeof(s));
+	deflateInit2(
+		&s, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+	s.next_in = const_cast<U8*>(in);
+	s.avail_in = size;
+	s.next_out = out;
+	s.avail_out = outSize;
+	deflate(&s, Z_FINISH);
+	deflateEnd(&s);
+	return s.total_out;
+}
+
+//==============================================================================
+/// Write an archive with the same text stored, deflated and chunked.
+static void writeTestArchive(const CString& filename, const CString& text)
+{
+	const PtrSize size = text.getLength();
+	const U8* in = reinterpret_cast<const U8*>(&text[0]);
+	const U CHUNK_SIZE = 16;
+	const U CHUNK_COUNT = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+	Array<U8, 1024> deflated;
+	const PtrSize deflatedSize =
+		deflateRaw(in, size, &deflated[0], deflated.getSize());
+
+	// Chunked. Store the chunks that don't compress
+	Array<U8, 1024> chunked;
+	U8* out = &chunked[0];
+	memcpy(out, "ANKICHK1", 8);
+	out += 8;
+	write32(out, 1);
+	write32(out, CHUNK_SIZE);
+	write32(out, CHUNK_COUNT);
+	write32(out, 0);
+	U8* offsets = out;
+	out += (CHUNK_COUNT + 1) * sizeof(U32);
+	for(U i = 0; i < CHUNK_COUNT; ++i)
+	{
+		write32(offsets, out - &chunked[0]);
+
+		const PtrSize chunkSize =
+			min<PtrSize>(CHUNK_SIZE, size - i * CHUNK_SIZE);
+		Array<U8, 128> tmp;
+		PtrSize compressedSize =
+			deflateRaw(in + i * CHUNK_SIZE, chunkSize, &tmp[0], tmp.getSize());
+		if(compressedSize >= chunkSize)
+		{
+			memcpy(out, in + i * CHUNK_SIZE, chunkSize);
+			out += chunkSize;
+		}
+		else
+		{
+			memcpy(out, &tmp[0], compressedSize);
+			out += compressedSize;
+		}
+	}
+	write32(offsets, out - &chunked[0]);
+	const PtrSize chunkedSize = out - &chunked[0];
+
+	class Entry
+	{
+	public:
+		CString m_name;
+		U16 m_method;
+		const U8* m_data;
+		PtrSize m_size;
+		PtrSize m_offset;
+	};
+
+	Array<Entry, 3> entries = {{{"stored.txt", 0, in, size, 0},
+		{"deflated.txt", 8, &deflated[0], deflatedSize, 0},
+		{"chunked.txt", 0x414B, &chunked[0], chunkedSize, 0}}};
+
+	Array<U8, 4096> archive;
+	out = &archive[0];
+	for(Entry& e : entries)
+	{
+		e.m_offset = out - &archive[0];
+		write32(out, 0x04034b50);
+		write16(out, 20);
+		write16(out, 0);
+		write16(out, e.m_method);
+		write32(out, 0);
+		write32(out, 0);
+		write32(out, e.m_size);
+		write32(out, size);
+		write16(out, e.m_name.getLength());
+		write16(out, 0);
+		memcpy(out, &e.m_name[0], e.m_name.getLength());
+		out += e.m_name.getLength();
+		memcpy(out, e.m_data, e.m_size);
+		out += e.m_size;
+	}
+
+	const PtrSize dirOffset = out - &archive[0];
+	for(const Entry& e : entries)
+	{
+		write32(out, 0x02014b50);
+		write16(out, 20);
+		write16(out, 20);
+		write16(out, 0);
+		write16(out, e.m_method);
+		write32(out, 0);
+		write32(out, 0);
+		write32(out, e.m_size);
+		write32(out, size);
+		write16(out, e.m_name.getLength());
+		write16(out, 0);
+		write16(out, 0);
+		write16(out, 0);
+		write16(out, 0);
+		write32(out, 0);
+		write32(out, e.m_offset);
+		memcpy(out, &e.m_name[0], e.m_name.getLength());
+		out += e.m_name.getLength();
+	}
+
+	const PtrSize dirSize = out - &archive[0] - dirOffset;
+	write32(out, 0x06054b50);
+	write16(out, 0);
+	write16(out, 0);
+	write16(out, entries.getSize());
+	write16(out, entries.getSize());
+	write32(out, dirSize);
+	write32(out, dirOffset);
+	write16(out, 0);
+
+	// File can't open archives for writing
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open("./tmp.zip", File::OpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(file.write(&archive[0], out - &archive[0]));
+	file.close();
+	ANKI_TEST_EXPECT_NO_ERR(renameFile("./tmp.zip", filename));
+}
+
 //==============================================================================
 ANKI_TEST(Resource, ResourceFilesystem)
 {
@@ -25,6 +181,15 @@ ANKI_TEST(Resource, ResourceFilesystem)
 		StringAuto txt(alloc);
 		ANKI_TEST_EXPECT_NO_ERR(file->readAllText(alloc, txt));
 		ANKI_TEST_EXPECT_EQ(txt, "hello\n");
+
+		// Loose files are mapped
+		ANKI_TEST_EXPECT_EQ(file->isMapped(), true);
+		ANKI_TEST_EXPECT_NO_ERR(
+			file->seek(1, ResourceFile::SeekOrigin::BEGINNING));
+		const U8* data;
+		ANKI_TEST_EXPECT_NO_ERR(file->readMapped(4, data));
+		ANKI_TEST_EXPECT_EQ(memcmp(data, "ello", 4), 0);
+		ANKI_TEST_EXPECT_ERR(file->readMapped(2, data), ErrorCode::FILE_ACCESS);
 	}
 
 	{
@@ -35,6 +200,104 @@ ANKI_TEST(Resource, ResourceFilesystem)
 		ANKI_TEST_EXPECT_NO_ERR(file->readAllText(alloc, txt));
 		ANKI_TEST_EXPECT_EQ(txt, "hell\n");
 	}
+
+	// Empty files can be opened
+	{
+		if(directoryExists("./tmp_empty"))
+		{
+			ANKI_TEST_EXPECT_NO_ERR(removeDirectory("./tmp_empty"));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory("./tmp_empty"));
+
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(
+			file.open("./tmp_empty/empty.txt", File::OpenFlag::WRITE));
+		file.close();
+		ANKI_TEST_EXPECT_NO_ERR(
+			file.open("./tmp_empty/empty.txt.baked", File::OpenFlag::WRITE));
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("baked"));
+		file.close();
+
+		ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath("./tmp_empty"));
+		ResourceFilePtr rfile;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("empty.txt", rfile));
+		ANKI_TEST_EXPECT_EQ(rfile->getSize(), 0);
+
+		U8 c;
+		ANKI_TEST_EXPECT_ANY_ERR(rfile->read(&c, 1));
+		StringAuto txt(alloc);
+		ANKI_TEST_EXPECT_ANY_ERR(rfile->readAllText(alloc, txt));
+
+		// Open a file and its sibling
+		ResourceFilePtr sibling;
+		ANKI_TEST_EXPECT_NO_ERR(
+			fs.openFileAndSibling("empty.txt", ".baked", rfile, sibling));
+		ANKI_TEST_EXPECT_EQ(rfile->getSize(), 0);
+		ANKI_TEST_EXPECT_EQ(sibling->getSize(), 5);
+
+		ResourceFilePtr noSibling;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFileAndSibling(
+			"subdir0/hello.txt", ".baked", rfile, noSibling));
+		ANKI_TEST_EXPECT_EQ(rfile->getSize(), 5);
+		ANKI_TEST_EXPECT_EQ(noSibling.isCreated(), false);
+
+		ANKI_TEST_EXPECT_ERR(
+			fs.openFileAndSibling("missing.txt", ".baked", rfile, sibling),
+			ErrorCode::USER_DATA);
+	}
+}
+
+//==============================================================================
+ANKI_TEST(Resource, ResourceArchive)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const CString text = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+						 "0123456789abcdefghijklmnopqrstuvwxyz";
+	writeTestArchive("./tmp.ankizip", text);
+
+	ResourceFilesystem fs(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath("./tmp.ankizip"));
+
+	Array<CString, 3> fnames = {{"stored.txt", "deflated.txt", "chunked.txt"}};
+	for(CString fname : fnames)
+	{
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile(fname, file));
+		ANKI_TEST_EXPECT_EQ(file->getSize(), text.getLength());
+		ANKI_TEST_EXPECT_EQ(file->isMapped(), fname == "stored.txt");
+
+		// Read across chunks
+		Array<char, 32> buff;
+		ANKI_TEST_EXPECT_NO_ERR(
+			file->seek(50, ResourceFile::SeekOrigin::BEGINNING));
+		ANKI_TEST_EXPECT_NO_ERR(file->read(&buff[0], 20));
+		ANKI_TEST_EXPECT_EQ(memcmp(&buff[0], &text[50], 20), 0);
+
+		// Seek back
+		ANKI_TEST_EXPECT_NO_ERR(
+			file->seek(3, ResourceFile::SeekOrigin::BEGINNING));
+		ANKI_TEST_EXPECT_NO_ERR(
+			file->seek(2, ResourceFile::SeekOrigin::CURRENT));
+		ANKI_TEST_EXPECT_NO_ERR(file->read(&buff[0], 10));
+		ANKI_TEST_EXPECT_EQ(memcmp(&buff[0], &text[5], 10), 0);
+
+		ANKI_TEST_EXPECT_NO_ERR(
+			file->seek(0, ResourceFile::SeekOrigin::BEGINNING));
+		StringAuto txt(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(file->readAllText(alloc, txt));
+		ANKI_TEST_EXPECT_EQ(txt, text);
+
+		// Nothing left to read
+		StringAuto txt2(alloc);
+		ANKI_TEST_EXPECT_ANY_ERR(file->readAllText(alloc, txt2));
+	}
+
+	ResourceFilePtr file;
+	ANKI_TEST_EXPECT_ERR(
+		fs.openFile("missing.txt", file), ErrorCode::USER_DATA);
+	ANKI_TEST_EXPECT_NO_ERR(fs.openFileOptional("missing.txt", file));
+	ANKI_TEST_EXPECT_EQ(file.isCreated(), false);
 }
 
 } // end namespace anki
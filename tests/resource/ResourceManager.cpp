@@ -7,6 +7,7 @@
 #include "anki/resource/DummyRsrc.h"
 #include "anki/resource/ResourceManager.h"
 #include "anki/core/Config.h"
+#include "anki/util/Thread.h"
 
 namespace anki
 {
@@ -86,6 +87,80 @@ ANKI_TEST(Resource, ResourceManager)
 		}
 	}
 
+	// Load from many threads
+	{
+		const U THREAD_COUNT = 8;
+		const U RESOURCE_COUNT = 8;
+
+		class In
+		{
+		public:
+			ResourceManager* m_resources = nullptr;
+			Barrier* m_barrier = nullptr;
+			U m_idx = 0;
+			Array<DummyResourcePtr, RESOURCE_COUNT> m_ptrs;
+		};
+
+		Barrier barrier(THREAD_COUNT);
+		Array<In, THREAD_COUNT> ins;
+		Array<Thread*, THREAD_COUNT> threads;
+
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			ins[i].m_resources = resources;
+			ins[i].m_barrier = &barrier;
+			ins[i].m_idx = i;
+
+			threads[i] = alloc.newInstance<Thread>("anki_test");
+			threads[i]->start(&ins[i], [](Thread::Info& info) -> Error {
+				In& in = *reinterpret_cast<In*>(info.m_userData);
+				in.m_barrier->wait();
+
+				// Load and release many times to race with the other threads
+				for(U i = 0; i < 100; ++i)
+				{
+					U r = (in.m_idx + i) % RESOURCE_COUNT;
+					StringAuto fname(in.m_resources->getAllocator());
+					fname.sprintf("blah%u", r);
+
+					DummyResourcePtr ptr;
+					ANKI_CHECK(in.m_resources->loadResource(
+						fname.toCString(), ptr));
+				}
+
+				for(U r = 0; r < RESOURCE_COUNT; ++r)
+				{
+					StringAuto fname(in.m_resources->getAllocator());
+					fname.sprintf("blah%u", r);
+
+					ANKI_CHECK(in.m_resources->loadResource(
+						fname.toCString(), in.m_ptrs[r]));
+				}
+
+				return ErrorCode::NONE;
+			});
+		}
+
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(threads[i]->join());
+			alloc.deleteInstance(threads[i]);
+		}
+
+		// All threads should share the same resources
+		for(U r = 0; r < RESOURCE_COUNT; ++r)
+		{
+			for(U i = 1; i < THREAD_COUNT; ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(
+					ins[i].m_ptrs[r].get(), ins[0].m_ptrs[r].get());
+			}
+
+			ANKI_TEST_EXPECT_EQ(
+				ins[0].m_ptrs[r]->getRefcount().load(), I32(THREAD_COUNT));
+		}
+	}
+
 	// Delete
 	alloc.deleteInstance(resources);
 }
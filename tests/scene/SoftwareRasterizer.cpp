@@ -0,0 +1,123 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/scene/SoftwareRasterizer.h"
+#include "anki/Collision.h"
+
+using namespace anki;
+
+static const U WIDTH = 256;
+static const U HEIGHT = 144;
+
+static Mat4 createTestProjection()
+{
+	PerspectiveFrustum fr(toRad(70.0f), toRad(45.0f), 0.1f, 200.0f);
+	return fr.calculateProjectionMatrix();
+}
+
+static Bool isVisible(
+	const SoftwareRasterizer& r, const Vec4& center, const Vec4& extent)
+{
+	Aabb box(center - extent, center + extent);
+	return r.visibilityTest(box, box);
+}
+
+ANKI_TEST(Scene, SoftwareRasterizer)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const Mat4 proj = createTestProjection();
+	const Mat4 view = Mat4::getIdentity();
+	const Vec4 extent(1.0, 1.0, 1.0, 0.0);
+
+	// A quad that faces the camera
+	{
+		const Vec3 quad[] = {Vec3(-2.0, -2.0, -10.0),
+			Vec3(2.0, -2.0, -10.0),
+			Vec3(2.0, 2.0, -10.0),
+			Vec3(2.0, 2.0, -10.0),
+			Vec3(-2.0, 2.0, -10.0),
+			Vec3(-2.0, -2.0, -10.0)};
+
+		SoftwareRasterizer r;
+		r.init(alloc);
+		r.prepare(view, proj, WIDTH, HEIGHT);
+		r.draw(&quad[0][0], 6, sizeof(Vec3));
+
+		ANKI_TEST_EXPECT_EQ(r.getWidth(), WIDTH);
+		ANKI_TEST_EXPECT_EQ(r.getHeight(), HEIGHT);
+		ANKI_TEST_EXPECT_LT(r.getDepth(WIDTH / 2, HEIGHT / 2), 1.0f);
+		ANKI_TEST_EXPECT_EQ(r.getDepth(0, 0), 1.0f);
+		ANKI_TEST_EXPECT_EQ(r.getDepth(WIDTH - 1, HEIGHT - 1), 1.0f);
+
+		// Behind
+		ANKI_TEST_EXPECT_EQ(
+			isVisible(r, Vec4(0.0, 0.0, -20.0, 0.0), extent), false);
+		ANKI_TEST_EXPECT_EQ(
+			isVisible(r, Vec4(0.5, -0.5, -60.0, 0.0), extent), false);
+
+		// Beside
+		ANKI_TEST_EXPECT_EQ(
+			isVisible(r, Vec4(8.0, 0.0, -20.0, 0.0), extent), true);
+		ANKI_TEST_EXPECT_EQ(
+			isVisible(r, Vec4(0.0, -6.0, -20.0, 0.0), extent), true);
+
+		// Partially behind
+		ANKI_TEST_EXPECT_EQ(
+			isVisible(r, Vec4(4.0, 0.0, -20.0, 0.0), extent), true);
+
+		// In front
+		ANKI_TEST_EXPECT_EQ(
+			isVisible(r, Vec4(0.0, 0.0, -5.0, 0.0), extent), true);
+
+		// Crossing the near plane
+		ANKI_TEST_EXPECT_EQ(isVisible(r,
+								Vec4(0.0, 0.0, -1.0, 0.0),
+								Vec4(0.5, 0.5, 2.0, 0.0)),
+			true);
+	}
+
+	// A quad that crosses the near plane and covers the whole screen. It lies
+	// on the plane z = -5 - y / 10
+	{
+		const Vec3 quad[] = {Vec3(-100.0, -100.0, 5.0),
+			Vec3(100.0, -100.0, 5.0),
+			Vec3(100.0, 100.0, -15.0),
+			Vec3(100.0, 100.0, -15.0),
+			Vec3(-100.0, 100.0, -15.0),
+			Vec3(-100.0, -100.0, 5.0)};
+
+		SoftwareRasterizer r;
+		r.init(alloc);
+		r.prepare(view, proj, WIDTH, HEIGHT);
+		r.draw(&quad[0][0], 6, sizeof(Vec3));
+
+		for(U y = 0; y < HEIGHT; ++y)
+		{
+			for(U x = 0; x < WIDTH; ++x)
+			{
+				ANKI_TEST_EXPECT_LT(r.getDepth(x, y), 1.0f);
+			}
+		}
+
+		// Behind
+		ANKI_TEST_EXPECT_EQ(
+			isVisible(r, Vec4(0.0, 0.0, -30.0, 0.0), extent), false);
+		ANKI_TEST_EXPECT_EQ(
+			isVisible(r, Vec4(10.0, -5.0, -40.0, 0.0), extent), false);
+
+		// In front
+		ANKI_TEST_EXPECT_EQ(isVisible(r,
+								Vec4(0.0, 0.0, -2.0, 0.0),
+								Vec4(0.5, 0.5, 0.5, 0.0)),
+			true);
+
+		// Crossing the near plane
+		ANKI_TEST_EXPECT_EQ(isVisible(r,
+								Vec4(0.0, 0.0, 0.0, 0.0),
+								Vec4(0.5, 0.5, 0.5, 0.0)),
+			true);
+	}
+}
@@ -0,0 +1,218 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/scene/SpatialCullingTable.h"
+#include "anki/scene/FrustumComponent.h"
+#include "anki/Collision.h"
+#include "anki/util/DynamicArray.h"
+
+using namespace anki;
+
+static const U8 RENDER_FLAG =
+	U8(FrustumComponentVisibilityTestFlag::RENDER_COMPONENTS);
+static const U8 LIGHT_FLAG =
+	U8(FrustumComponentVisibilityTestFlag::LIGHT_COMPONENTS);
+static const U8 ALL_FLAGS = U8(FrustumComponentVisibilityTestFlag::ALL_TESTS);
+
+/// The table never dereferences the spatials outside of updateEntry so fake
+/// ones will do.
+static SpatialComponent* fakeSpatial(U i)
+{
+	return reinterpret_cast<SpatialComponent*>(PtrSize(i + 1) * 16);
+}
+
+/// Fill an entry with a random box, sphere or obb. Every fifth entry is a
+/// light.
+/// @return The result of the scalar frustum test. Entries that are not exact
+///         are tested by their Aabb.
+static Bool setRandomEntry(
+	SpatialCullingTable& table, U32 idx, const Frustum& fr)
+{
+	const Vec4 center(randRange(-100.0f, 100.0f),
+		randRange(-100.0f, 100.0f),
+		randRange(-100.0f, 100.0f),
+		0.0);
+	const Vec4 extent(randRange(0.1f, 5.0f),
+		randRange(0.1f, 5.0f),
+		randRange(0.1f, 5.0f),
+		0.0);
+	const U8 flags = (idx % 5 == 0) ? LIGHT_FLAG : RENDER_FLAG;
+
+	Aabb aabb;
+	switch(idx % 3)
+	{
+	case 0:
+	{
+		aabb = Aabb(center - extent, center + extent);
+		table.setEntry(idx, aabb, aabb, flags);
+		ANKI_TEST_EXPECT_EQ(table.isExact(idx), true);
+		return fr.insideFrustum(aabb);
+	}
+	case 1:
+	{
+		Sphere sphere(center, extent.x());
+		sphere.computeAabb(aabb);
+		table.setEntry(idx, sphere, aabb, flags);
+		ANKI_TEST_EXPECT_EQ(table.isExact(idx), true);
+		return fr.insideFrustum(sphere);
+	}
+	default:
+	{
+		const Mat3x4 rot(Euler(toRad(20.0f), toRad(45.0f), 0.0f));
+		Obb obb(center, rot, extent);
+		obb.computeAabb(aabb);
+		table.setEntry(idx, obb, aabb, flags);
+		ANKI_TEST_EXPECT_EQ(table.isExact(idx), false);
+		return fr.insideFrustum(aabb);
+	}
+	}
+}
+
+ANKI_TEST(Scene, SpatialCullingTable)
+{
+	HeapAllocator<U8> halloc(allocAligned, nullptr);
+	SceneAllocator<U8> alloc(allocAligned, nullptr, 1024 * 10, 1.0, 0);
+	const U COUNT = 1001;
+
+	PerspectiveFrustum fr(toRad(70.0f), toRad(50.0f), 0.1f, 80.0f);
+	fr.resetTransform(Transform(Vec4(5.0, -2.0, 10.0, 0.0),
+		Mat3x4(Euler(toRad(10.0f), toRad(30.0f), 0.0f)),
+		1.0));
+	const auto& planes = fr.getPlanesWorldSpace();
+
+	// The results of the scalar tests
+	DynamicArrayAuto<U8> inside(halloc);
+	inside.create(COUNT);
+
+	DynamicArrayAuto<U32> indices(halloc);
+	indices.create(COUNT);
+	DynamicArrayAuto<U32> visible(halloc);
+	visible.create(COUNT);
+
+	SpatialCullingTable table;
+
+	// Insert
+	for(U i = 0; i < COUNT; ++i)
+	{
+		ANKI_TEST_EXPECT_EQ(table.newEntry(alloc, fakeSpatial(i)), i);
+		inside[i] = setRandomEntry(table, i, fr);
+	}
+
+	ANKI_TEST_EXPECT_EQ(table.getEntryCount(), COUNT);
+	for(U i = 0; i < COUNT; ++i)
+	{
+		ANKI_TEST_EXPECT_EQ(&table.getSpatial(i), fakeSpatial(i));
+	}
+
+	// Compare the batch tests against the scalar ones
+	U insideCount = 0;
+	for(U i = 0; i < COUNT; ++i)
+	{
+		ANKI_TEST_EXPECT_EQ(
+			table.insidePlanes(i, &planes[0], planes.getSize()),
+			inside[i] != 0);
+		insideCount += inside[i];
+	}
+	ANKI_TEST_EXPECT_GT(insideCount, 0);
+
+	for(U i = 0; i < COUNT; ++i)
+	{
+		indices[i] = i;
+	}
+
+	// All flags with aliasing output
+	U32 visibleCount = table.test(&indices[0],
+		COUNT,
+		&planes[0],
+		planes.getSize(),
+		ALL_FLAGS,
+		&indices[0]);
+
+	U32 expectedCount = 0;
+	for(U i = 0; i < COUNT; ++i)
+	{
+		if(inside[i])
+		{
+			ANKI_TEST_EXPECT_EQ(indices[expectedCount], i);
+			++expectedCount;
+		}
+	}
+	ANKI_TEST_EXPECT_EQ(visibleCount, expectedCount);
+
+	// Only the lights
+	for(U i = 0; i < COUNT; ++i)
+	{
+		indices[i] = i;
+	}
+
+	visibleCount = table.test(&indices[0],
+		COUNT,
+		&planes[0],
+		planes.getSize(),
+		LIGHT_FLAG,
+		&visible[0]);
+
+	expectedCount = 0;
+	for(U i = 0; i < COUNT; ++i)
+	{
+		if(inside[i] && i % 5 == 0)
+		{
+			ANKI_TEST_EXPECT_EQ(visible[expectedCount], i);
+			++expectedCount;
+		}
+	}
+	ANKI_TEST_EXPECT_EQ(visibleCount, expectedCount);
+
+	// Remove every third entry
+	U removedCount = 0;
+	for(U i = 0; i < COUNT; i += 3)
+	{
+		table.deleteEntry(alloc, i);
+		++removedCount;
+	}
+	ANKI_TEST_EXPECT_EQ(table.getEntryCount(), COUNT);
+
+	visibleCount = table.test(&indices[0],
+		COUNT,
+		&planes[0],
+		planes.getSize(),
+		ALL_FLAGS,
+		&visible[0]);
+
+	expectedCount = 0;
+	for(U i = 0; i < COUNT; ++i)
+	{
+		if(inside[i] && i % 3 != 0)
+		{
+			ANKI_TEST_EXPECT_EQ(visible[expectedCount], i);
+			++expectedCount;
+		}
+	}
+	ANKI_TEST_EXPECT_EQ(visibleCount, expectedCount);
+
+	// The new entries fill the holes before the table grows
+	for(U i = 0; i < removedCount; ++i)
+	{
+		const U32 idx = table.newEntry(alloc, fakeSpatial(COUNT + i));
+		ANKI_TEST_EXPECT_EQ(idx % 3, 0);
+		ANKI_TEST_EXPECT_EQ(&table.getSpatial(idx), fakeSpatial(COUNT + i));
+	}
+	ANKI_TEST_EXPECT_EQ(table.getEntryCount(), COUNT);
+
+	// They are not visible until they get their bounds
+	visibleCount = table.test(&indices[0],
+		COUNT,
+		&planes[0],
+		planes.getSize(),
+		ALL_FLAGS,
+		&visible[0]);
+	ANKI_TEST_EXPECT_EQ(visibleCount, expectedCount);
+
+	ANKI_TEST_EXPECT_EQ(table.newEntry(alloc, fakeSpatial(0)), COUNT);
+	ANKI_TEST_EXPECT_EQ(table.getEntryCount(), COUNT + 1);
+
+	table.destroy(alloc);
+}
@@ -107,3 +107,29 @@ ANKI_TEST(Util, WalkDir)
 
 	ANKI_TEST_EXPECT_EQ(count, 1);
 }
+
+ANKI_TEST(Util, MapFile)
+{
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open("./tmp", File::OpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("mapped"));
+	file.close();
+
+	const U8* data = nullptr;
+	PtrSize size = 0;
+	ANKI_TEST_EXPECT_NO_ERR(mapFile("./tmp", data, size));
+	ANKI_TEST_EXPECT_EQ(size, 6);
+	ANKI_TEST_EXPECT_EQ(memcmp(data, "mapped", size), 0);
+	unmapFile(data, size);
+
+	// Empty files have nothing to map
+	ANKI_TEST_EXPECT_NO_ERR(file.open("./tmp", File::OpenFlag::WRITE));
+	file.close();
+	ANKI_TEST_EXPECT_NO_ERR(mapFile("./tmp", data, size));
+	ANKI_TEST_EXPECT_EQ(data, static_cast<const U8*>(nullptr));
+	ANKI_TEST_EXPECT_EQ(size, 0);
+	unmapFile(data, size);
+
+	ANKI_TEST_EXPECT_ERR(
+		mapFile("./does_not_exist", data, size), ErrorCode::FILE_ACCESS);
+}
@@ -6,6 +6,7 @@
 #include "tests/framework/Framework.h"
 #include "tests/util/Foo.h"
 #include "anki/util/HashMap.h"
+#include "anki/util/FlatHashMap.h"
 #include "anki/util/DynamicArray.h"
 #include "anki/util/HighRezTimer.h"
 #include <unordered_map>
@@ -157,7 +158,7 @@ ANKI_TEST(Util, HashMap)
 			int,
 			std::hash<int>,
 			std::equal_to<int>,
-			HeapAllocator<std::pair<int, int>>>
+			HeapAllocator<std::pair<const int, int>>>
 			stdMap(10, std::hash<int>(), std::equal_to<int>(), alloc);
 
 		std::unordered_map<int, int> tmpMap;
@@ -270,3 +271,267 @@ ANKI_TEST(Util, IntrusiveHashMap)
 	map.pushBack(10, &c);
 	ANKI_TEST_EXPECT_NEQ(map.find(10), map.getEnd());
 }
+
+ANKI_TEST(Util, FlatHashMap)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	int vals[] = {20, 15, 5, 1, 10, 0, 18, 6, 7, 11, 13, 3};
+	U valsSize = sizeof(vals) / sizeof(vals[0]);
+
+	// Simple
+	{
+		FlatHashMap<int, int, Hasher, Compare> map;
+		map.pushBack(alloc, 20, 1);
+		map.pushBack(alloc, 21, 1);
+		ANKI_TEST_EXPECT_EQ(map.getSize(), 2);
+		map.destroy(alloc);
+	}
+
+	// Add more and iterate
+	{
+		FlatHashMap<int, int, Hasher, Compare> map;
+
+		for(U i = 0; i < valsSize; ++i)
+		{
+			map.pushBack(alloc, vals[i], vals[i] * 10);
+		}
+
+		U count = 0;
+		int sum = 0;
+		for(int x : map)
+		{
+			++count;
+			sum += x;
+		}
+		ANKI_TEST_EXPECT_EQ(count, valsSize);
+		ANKI_TEST_EXPECT_EQ(sum, 1090);
+
+		map.destroy(alloc);
+	}
+
+	// Erase and find
+	{
+		FlatHashMap<int, int, Hasher, Compare> map;
+
+		for(U i = 0; i < valsSize; ++i)
+		{
+			map.pushBack(alloc, vals[i], vals[i] * 10);
+		}
+
+		for(U i = valsSize - 1; i != 0; --i)
+		{
+			auto it = map.find(vals[i]);
+			ANKI_TEST_EXPECT_NEQ(it, map.getEnd());
+			ANKI_TEST_EXPECT_EQ(*it, vals[i] * 10);
+
+			map.erase(alloc, it);
+			ANKI_TEST_EXPECT_EQ(map.find(vals[i]), map.getEnd());
+			map.pushBack(alloc, vals[i], vals[i] * 10);
+		}
+
+		ANKI_TEST_EXPECT_EQ(map.getSize(), valsSize);
+		map.destroy(alloc);
+	}
+
+	// Reserve and rehash
+	{
+		FlatHashMap<int, int, Hasher, Compare> map;
+		map.reserve(alloc, 1000);
+		const U capacity = map.getCapacity();
+		ANKI_TEST_EXPECT_GEQ(capacity, 1000);
+
+		for(int i = 0; i < 1000; ++i)
+		{
+			map.pushBack(alloc, i, i);
+		}
+		ANKI_TEST_EXPECT_EQ(map.getCapacity(), capacity);
+
+		for(int i = 0; i < 990; ++i)
+		{
+			map.erase(alloc, map.find(i));
+		}
+
+		map.rehash(alloc);
+		ANKI_TEST_EXPECT_LT(map.getCapacity(), capacity);
+		ANKI_TEST_EXPECT_EQ(map.getSize(), 10);
+		for(int i = 990; i < 1000; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(*map.find(i), i);
+		}
+
+		map.destroy(alloc);
+	}
+
+	// Fuzzy test against the STL
+	{
+		FlatHashMap<int, int, Hasher, Compare> akMap;
+		std::unordered_map<int, int> stdMap;
+
+		for(U i = 0; i < 100000; ++i)
+		{
+			const int num = rand() % 2000;
+			auto it = akMap.find(num);
+			auto stdIt = stdMap.find(num);
+
+			if(stdIt == stdMap.end())
+			{
+				ANKI_TEST_EXPECT_EQ(it, akMap.getEnd());
+				akMap.pushBack(alloc, num, num * 2);
+				stdMap[num] = num * 2;
+			}
+			else
+			{
+				ANKI_TEST_EXPECT_NEQ(it, akMap.getEnd());
+				ANKI_TEST_EXPECT_EQ(*it, stdIt->second);
+				akMap.erase(alloc, it);
+				stdMap.erase(stdIt);
+			}
+		}
+
+		ANKI_TEST_EXPECT_EQ(akMap.getSize(), stdMap.size());
+		akMap.destroy(alloc);
+	}
+}
+
+ANKI_TEST(Util, FlatHashMapBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	HighRezTimer timer;
+	I64 count = 0;
+
+	printf("%8s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+		"count",
+		"ins STL",
+		"ins tree",
+		"ins flat",
+		"find STL",
+		"find tree",
+		"find flat",
+		"del STL",
+		"del tree",
+		"del flat");
+
+	for(U count2 = 1000; count2 <= 1000000; count2 *= 10)
+	{
+		const U COUNT = count2;
+
+		// Create unique random keys
+		std::unordered_map<int, int> tmpMap;
+		DynamicArrayAuto<int> vals(alloc);
+		vals.create(COUNT);
+		for(U i = 0; i < COUNT; ++i)
+		{
+			int v;
+			do
+			{
+				v = rand();
+			} while(tmpMap.find(v) != tmpMap.end());
+			tmpMap[v] = 1;
+
+			vals[i] = v;
+		}
+
+		std::unordered_map<int,
+			int,
+			std::hash<int>,
+			std::equal_to<int>,
+			HeapAllocator<std::pair<const int, int>>>
+			stdMap(10, std::hash<int>(), std::equal_to<int>(), alloc);
+		HashMap<int, int, Hasher, Compare> treeMap;
+		FlatHashMap<int, int, Hasher, Compare> flatMap;
+		Array<HighRezTimer::Scalar, 9> times;
+
+		// Insert
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			stdMap[vals[i]] = vals[i];
+		}
+		timer.stop();
+		times[0] = timer.getElapsedTime();
+
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			treeMap.pushBack(alloc, vals[i], vals[i]);
+		}
+		timer.stop();
+		times[1] = timer.getElapsedTime();
+
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			flatMap.pushBack(alloc, vals[i], vals[i]);
+		}
+		timer.stop();
+		times[2] = timer.getElapsedTime();
+
+		// Find
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			count += stdMap.find(vals[i])->second;
+		}
+		timer.stop();
+		times[3] = timer.getElapsedTime();
+
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			count += *treeMap.find(vals[i]);
+		}
+		timer.stop();
+		times[4] = timer.getElapsedTime();
+
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			count += *flatMap.find(vals[i]);
+		}
+		timer.stop();
+		times[5] = timer.getElapsedTime();
+
+		// Erase
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			stdMap.erase(vals[i]);
+		}
+		timer.stop();
+		times[6] = timer.getElapsedTime();
+
+		// The tree degenerates when erasing a lot so skip the big sets
+		times[7] = -1.0;
+		if(COUNT <= 10000)
+		{
+			timer.start();
+			for(U i = 0; i < COUNT; ++i)
+			{
+				treeMap.erase(alloc, treeMap.find(vals[i]));
+			}
+			timer.stop();
+			times[7] = timer.getElapsedTime();
+		}
+
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			flatMap.erase(alloc, flatMap.find(vals[i]));
+		}
+		timer.stop();
+		times[8] = timer.getElapsedTime();
+
+		printf("%8u", U32(COUNT));
+		for(HighRezTimer::Scalar t : times)
+		{
+			printf(" %10f", t);
+		}
+		printf("\n");
+
+		ANKI_TEST_EXPECT_EQ(flatMap.isEmpty(), true);
+		treeMap.destroy(alloc);
+		flatMap.destroy(alloc);
+	}
+
+	printf("Ignore %ld\n", long(count));
+}
@@ -168,6 +168,80 @@ ANKI_TEST(Util, StackMemoryPool)
 			}
 		}
 	}
+
+	// Parallel with thread local blocks
+	{
+		StackMemoryPool pool;
+		const U THREAD_COUNT = 32;
+		const U ALLOC_SIZE = 25;
+		const U ALLOCS_PER_THREAD = 0xF;
+		ThreadPool threadPool(THREAD_COUNT);
+
+		class AllocateTask : public ThreadPoolTask
+		{
+		public:
+			StackMemoryPool* m_pool = nullptr;
+			Array<void*, ALLOCS_PER_THREAD> m_allocations;
+
+			Error operator()(U32 taskId, PtrSize threadsCount)
+			{
+				for(U i = 0; i < m_allocations.getSize(); ++i)
+				{
+					void* ptr = m_pool->allocate(ALLOC_SIZE, 1);
+					memset(ptr, (taskId << 4) | i, ALLOC_SIZE);
+					m_allocations[i] = ptr;
+				}
+
+				return ErrorCode::NONE;
+			}
+		};
+
+		pool.create(allocAligned,
+			nullptr,
+			1024,
+			2.0,
+			0,
+			true,
+			ANKI_SAFE_ALIGNMENT,
+			256);
+		Array<AllocateTask, THREAD_COUNT> tasks;
+
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			tasks[i].m_pool = &pool;
+			threadPool.assignNewTask(i, &tasks[i]);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			const auto& task = tasks[i];
+
+			for(U j = 0; j < task.m_allocations.getSize(); ++j)
+			{
+				U8 magic = (i << 4) | j;
+				U8* ptr = static_cast<U8*>(task.m_allocations[j]);
+
+				for(U k = 0; k < ALLOC_SIZE; ++k)
+				{
+					ANKI_TEST_EXPECT_EQ(ptr[k], magic);
+				}
+			}
+		}
+
+		MemoryPoolStats stats = pool.getStats();
+		ANKI_TEST_EXPECT_EQ(
+			stats.m_allocationsCount, THREAD_COUNT * ALLOCS_PER_THREAD);
+		ANKI_TEST_EXPECT_GEQ(
+			stats.m_usedSize, THREAD_COUNT * ALLOCS_PER_THREAD * ALLOC_SIZE);
+		ANKI_TEST_EXPECT_GEQ(stats.m_reservedSize, stats.m_usedSize);
+
+		pool.reset();
+		stats = pool.getStats();
+		ANKI_TEST_EXPECT_EQ(stats.m_allocationsCount, 0);
+		ANKI_TEST_EXPECT_EQ(stats.m_usedSize, 0);
+	}
 }
 
 ANKI_TEST(Util, ChainMemoryPool)
@@ -217,4 +291,88 @@ ANKI_TEST(Util, ChainMemoryPool)
 
 		ANKI_TEST_EXPECT_EQ(pool.getChunksCount(), 0);
 	}
+
+	// Parallel. Every thread frees the memory of another
+	{
+		ChainMemoryPool pool;
+		const U THREAD_COUNT = 32;
+		const U ALLOC_SIZE = 25;
+		ThreadPool threadPool(THREAD_COUNT);
+
+		class AllocateTask : public ThreadPoolTask
+		{
+		public:
+			ChainMemoryPool* m_pool = nullptr;
+			Array<void*, 0xF> m_allocations;
+			Bool8 m_free = false;
+
+			Error operator()(U32 taskId, PtrSize threadsCount)
+			{
+				for(U i = 0; i < m_allocations.getSize(); ++i)
+				{
+					if(m_free)
+					{
+						m_pool->free(m_allocations[i]);
+					}
+					else
+					{
+						void* ptr = m_pool->allocate(ALLOC_SIZE, 1);
+						memset(ptr, (taskId << 4) | i, ALLOC_SIZE);
+						m_allocations[i] = ptr;
+					}
+				}
+
+				return ErrorCode::NONE;
+			}
+		};
+
+		pool.create(allocAligned, nullptr, 128, 2.0, 0, 16);
+		Array<AllocateTask, THREAD_COUNT> tasks;
+
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			tasks[i].m_pool = &pool;
+			threadPool.assignNewTask(i, &tasks[i]);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			const auto& task = tasks[i];
+
+			for(U j = 0; j < task.m_allocations.getSize(); ++j)
+			{
+				U8 magic = (i << 4) | j;
+				U8* ptr = static_cast<U8*>(task.m_allocations[j]);
+
+				for(U k = 0; k < ALLOC_SIZE; ++k)
+				{
+					ANKI_TEST_EXPECT_EQ(ptr[k], magic);
+				}
+			}
+		}
+
+		MemoryPoolStats stats = pool.getStats();
+		ANKI_TEST_EXPECT_EQ(stats.m_allocationsCount, THREAD_COUNT * 0xF);
+		ANKI_TEST_EXPECT_GEQ(stats.m_reservedSize, stats.m_usedSize);
+		ANKI_TEST_EXPECT_GT(stats.m_chunksCount, 0);
+
+		// Free the allocations of the other threads
+		Array<AllocateTask, THREAD_COUNT> freeTasks;
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			freeTasks[i] = tasks[(i + 1) % THREAD_COUNT];
+			freeTasks[i].m_free = true;
+			threadPool.assignNewTask(i, &freeTasks[i]);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+
+		stats = pool.getStats();
+		ANKI_TEST_EXPECT_EQ(stats.m_allocationsCount, 0);
+		ANKI_TEST_EXPECT_EQ(stats.m_chunksCount, 0);
+		ANKI_TEST_EXPECT_EQ(stats.m_reservedSize, 0);
+		ANKI_TEST_EXPECT_GT(stats.m_peakReservedSize, 0);
+	}
 }
@@ -0,0 +1,73 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/util/RadixSort.h"
+#include "anki/util/Functions.h"
+#include <vector>
+#include <algorithm>
+
+using namespace anki;
+
+ANKI_TEST(Util, RadixSort)
+{
+	for(U count : {0u, 1u, 17u, 32u, 33u, 1000u, 12345u})
+	{
+		for(U mode = 0; mode < 3; ++mode)
+		{
+			std::vector<U64> keys(count);
+			std::vector<U32> values(count);
+			for(U i = 0; i < count; ++i)
+			{
+				U64 key = 0;
+				for(U j = 0; j < 4; ++j)
+				{
+					key = (key << 16) | randRange(0u, 0xFFFFu);
+				}
+
+				if(mode == 1)
+				{
+					// Few bits and a lot of duplicates
+					key &= 0xF0F;
+				}
+				else if(mode == 2)
+				{
+					// All the same
+					key = 42;
+				}
+
+				keys[i] = key;
+				values[i] = i;
+			}
+
+			// Stable sort the pairs as a reference
+			std::vector<std::pair<U64, U32>> ref(count);
+			for(U i = 0; i < count; ++i)
+			{
+				ref[i] = std::make_pair(keys[i], values[i]);
+			}
+			std::stable_sort(ref.begin(),
+				ref.end(),
+				[](const std::pair<U64, U32>& a,
+					const std::pair<U64, U32>& b) {
+					return a.first < b.first;
+				});
+
+			std::vector<U64> tmpKeys(count);
+			std::vector<U32> tmpValues(count);
+			radixSort(keys.data(),
+				values.data(),
+				count,
+				tmpKeys.data(),
+				tmpValues.data());
+
+			for(U i = 0; i < count; ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(keys[i], ref[i].first);
+				ANKI_TEST_EXPECT_EQ(values[i], ref[i].second);
+			}
+		}
+	}
+}
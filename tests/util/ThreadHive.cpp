@@ -5,7 +5,9 @@
 
 #include <tests/framework/Framework.h>
 #include <anki/util/ThreadHive.h>
+#include <anki/util/HighRezTimer.h>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 namespace anki
@@ -63,12 +65,8 @@ static void taskToWait(void* arg, U32 threadId, ThreadHive& hive)
 }
 
 //==============================================================================
-ANKI_TEST(Util, ThreadHive)
+static void testHive(ThreadHive& hive)
 {
-	const U32 threadCount = 4;
-	HeapAllocator<U8> alloc(allocAligned, nullptr);
-	ThreadHive hive(threadCount, alloc);
-
 	// Simple test
 	if(1)
 	{
@@ -173,4 +171,224 @@ ANKI_TEST(Util, ThreadHive)
 	}
 }
 
+//==============================================================================
+ANKI_TEST(Util, ThreadHive)
+{
+	const U32 threadCount = 4;
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	{
+		ThreadHive hive(threadCount, alloc);
+		testHive(hive);
+	}
+
+	{
+		ThreadHive hive(threadCount, alloc, true);
+		testHive(hive);
+	}
+}
+
+//==============================================================================
+class ParallelForTestContext
+{
+public:
+	Array<U8, 10000> m_visited;
+	Atomic<U32> m_nestedDone = {0};
+};
+
+//==============================================================================
+static void nestedParallelFor(void* arg, U32, ThreadHive& hive)
+{
+	ParallelForTestContext& ctx = *static_cast<ParallelForTestContext*>(arg);
+
+	Error err = hive.parallelFor(0,
+		ctx.m_visited.getSize(),
+		7,
+		[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+			for(PtrSize i = start; i < end; ++i)
+			{
+				++ctx.m_visited[i];
+			}
+			return ErrorCode::NONE;
+		});
+	ANKI_TEST_EXPECT_EQ(err, ErrorCode::NONE);
+
+	ctx.m_nestedDone.fetchAdd(1);
+}
+
+//==============================================================================
+ANKI_TEST(Util, ThreadHiveParallelFor)
+{
+	const U32 threadCount = 4;
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	for(U mode = 0; mode < 2; ++mode)
+	{
+		ThreadHive hive(threadCount, alloc, mode == 1);
+
+		// From outside the hive
+		{
+			ParallelForTestContext ctx;
+			memset(&ctx.m_visited[0], 0, ctx.m_visited.getSize());
+
+			Error err = hive.parallelFor(10,
+				ctx.m_visited.getSize(),
+				33,
+				[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+					ANKI_TEST_EXPECT_LT(threadId, threadCount);
+					for(PtrSize i = start; i < end; ++i)
+					{
+						++ctx.m_visited[i];
+					}
+					return ErrorCode::NONE;
+				});
+			ANKI_TEST_EXPECT_EQ(err, ErrorCode::NONE);
+
+			for(U i = 0; i < ctx.m_visited.getSize(); ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(ctx.m_visited[i], (i < 10) ? 0 : 1);
+			}
+		}
+
+		// Nested
+		{
+			ParallelForTestContext ctx;
+			memset(&ctx.m_visited[0], 0, ctx.m_visited.getSize());
+
+			hive.submitTask(nestedParallelFor, &ctx);
+			hive.waitAllTasks();
+
+			ANKI_TEST_EXPECT_EQ(ctx.m_nestedDone.load(), 1);
+			for(U i = 0; i < ctx.m_visited.getSize(); ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(ctx.m_visited[i], 1);
+			}
+		}
+
+		// Errors
+		{
+			Error err = hive.parallelFor(0,
+				1000,
+				1,
+				[&](PtrSize start, PtrSize end, U32 threadId) -> Error {
+					return (start == 500) ? ErrorCode::USER_DATA
+										  : ErrorCode::NONE;
+				});
+			ANKI_TEST_EXPECT_EQ(err, ErrorCode::USER_DATA);
+		}
+	}
+}
+
+//==============================================================================
+ANKI_TEST(Util, SplitThreadedProblem)
+{
+	const Array<PtrSize, 4> problemSizes = {{0, 1, 7, 1000}};
+	for(PtrSize problemSize : problemSizes)
+	{
+		for(PtrSize threadCount = 1; threadCount <= 8; ++threadCount)
+		{
+			// The ranges should be contiguous and cover the whole problem
+			PtrSize prevEnd = 0;
+			for(PtrSize i = 0; i < threadCount; ++i)
+			{
+				PtrSize start, end;
+				splitThreadedProblem(i, threadCount, problemSize, start, end);
+				ANKI_TEST_EXPECT_EQ(start, prevEnd);
+				ANKI_TEST_EXPECT_LEQ(start, end);
+				ANKI_TEST_EXPECT_LEQ(
+					end - start, problemSize / threadCount + 1);
+				prevEnd = end;
+			}
+
+			ANKI_TEST_EXPECT_EQ(prevEnd, problemSize);
+		}
+	}
+}
+
+//==============================================================================
+class ThreadHiveBenchContext
+{
+public:
+	Atomic<U64> m_sum = {0};
+	U32 m_iterations = 0;
+};
+
+//==============================================================================
+static void benchLeaf(void* arg, U32, ThreadHive&)
+{
+	ThreadHiveBenchContext& ctx = *static_cast<ThreadHiveBenchContext*>(arg);
+
+	// Some small amount of work
+	U64 x = 0;
+	for(U i = 0; i < ctx.m_iterations; ++i)
+	{
+		x = x * 6364136223846793005 + i;
+	}
+
+	ctx.m_sum.fetchAdd(x & 1);
+}
+
+//==============================================================================
+static void benchParent(void* arg, U32 threadId, ThreadHive& hive)
+{
+	benchLeaf(arg, threadId, hive);
+
+	// Spawn some more like the visibility does
+	Array<ThreadHiveTask, 2> tasks;
+	for(ThreadHiveTask& task : tasks)
+	{
+		task.m_callback = benchLeaf;
+		task.m_argument = arg;
+	}
+
+	hive.submitTasks(&tasks[0], tasks.getSize());
+}
+
+//==============================================================================
+ANKI_TEST(Util, ThreadHiveBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U SESSIONS = 100;
+	const U PARENT_TASKS = 512; // Every parent spawns 2 more
+	const U TASKS_PER_SESSION = PARENT_TASKS * 3;
+
+	ThreadHiveBenchContext ctx;
+	ctx.m_iterations = 64;
+
+	printf("Task throughput (tasks/sec)\n");
+	for(U threadCount = 1; threadCount <= ThreadHive::MAX_THREADS;
+		threadCount *= 2)
+	{
+		Array<F64, 2> throughput;
+
+		for(U mode = 0; mode < 2; ++mode)
+		{
+			ThreadHive hive(threadCount, alloc, mode == 1);
+
+			HighRezTimer timer;
+			timer.start();
+			for(U s = 0; s < SESSIONS; ++s)
+			{
+				for(U i = 0; i < PARENT_TASKS; ++i)
+				{
+					hive.submitTask(benchParent, &ctx);
+				}
+
+				hive.waitAllTasks();
+			}
+			timer.stop();
+
+			throughput[mode] =
+				F64(SESSIONS * TASKS_PER_SESSION) / timer.getElapsedTime();
+		}
+
+		printf("%2u threads: mutex %12.0f work stealing %12.0f | %f%%\n",
+			U32(threadCount),
+			throughput[0],
+			throughput[1],
+			throughput[1] / throughput[0] * 100.0);
+	}
+}
+
 } // end namespace anki
@@ -0,0 +1,181 @@
+#!/usr/bin/python
+
+# Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+# All rights reserved.
+# Code licensed under the BSD License.
+# http://www.anki3d.org/LICENSE
+
+# Create an .ankizip archive. The files are compressed in chunks so the engine
+# can read them from any position and many threads can decompress files of the
+# same archive at the same time.
+
+import optparse
+import os
+import struct
+import zlib
+
+#
+# Config
+#
+class Config:
+	in_dir = ""
+	out_file = ""
+	chunk_size = 64 * 1024
+	store_exts = []
+
+#
+# Archive format. Keep it in sync with ResourceFilesystem.cpp
+#
+
+# Compression methods
+CM_STORED = 0
+CM_DEFLATE = 8
+CM_CHUNKED = 0x414B
+
+# Chunk codecs
+CC_NONE = 0
+CC_DEFLATE = 1
+
+CHUNKED_MAGIC = b"ANKICHK1"
+
+def printi(s):
+	print("[I] %s" % s)
+
+def parse_commandline():
+	""" Parse the command line arguments """
+
+	parser = optparse.OptionParser(usage = "usage: %prog [options]", \
+			description = "Create an AnKi archive out of a directory")
+
+	parser.add_option("-i", "--input", dest = "inp", type = "string", \
+			help = "specify the directory to archive")
+
+	parser.add_option("-o", "--output", dest = "out", type = "string", \
+			help = "specify the .ankizip file")
+
+	parser.add_option("-c", "--chunk-size", dest = "chunk_size", \
+			type = "int", action = "store", default = 64 * 1024, \
+			help = "the uncompressed size of the chunks. Default is 64K")
+
+	parser.add_option("-s", "--store", dest = "store", type = "string", \
+			action = "store", default = "", \
+			help = "comma separated extensions of the files that will be " \
+			"stored without compression. The engine maps them to memory")
+
+	(options, args) = parser.parse_args()
+
+	if not options.inp or not options.out:
+		parser.error("argument is missing")
+
+	if not options.out.endswith(".ankizip"):
+		parser.error("the output file should have the .ankizip extension")
+
+	if options.chunk_size <= 0:
+		parser.error("wrong chunk size")
+
+	config = Config()
+	config.in_dir = options.inp
+	config.out_file = options.out
+	config.chunk_size = options.chunk_size
+	config.store_exts = [e for e in options.store.split(",") if e]
+
+	return config
+
+def deflate_raw(data):
+	""" Compress without the zlib header """
+
+	comp = zlib.compressobj(9, zlib.DEFLATED, -zlib.MAX_WBITS)
+	return comp.compress(data) + comp.flush()
+
+def create_chunked(data, chunk_size):
+	""" Create the payload of a CM_CHUNKED file """
+
+	chunk_count = (len(data) + chunk_size - 1) // chunk_size
+	header_size = 24 + (chunk_count + 1) * 4
+
+	chunks = []
+	offsets = []
+	offset = header_size
+	for i in range(0, chunk_count):
+		chunk = data[i * chunk_size:(i + 1) * chunk_size]
+		compressed = deflate_raw(chunk)
+
+		# The engine knows that a chunk is not compressed from its size
+		if len(compressed) >= len(chunk):
+			compressed = chunk
+
+		offsets.append(offset)
+		chunks.append(compressed)
+		offset += len(compressed)
+
+	offsets.append(offset)
+
+	out = CHUNKED_MAGIC
+	out += struct.pack("<IIII", CC_DEFLATE, chunk_size, chunk_count, 0)
+	out += struct.pack("<%dI" % len(offsets), *offsets)
+	out += b"".join(chunks)
+
+	return out
+
+def create_archive(config):
+	""" Write the archive. It's a zip with an extra compression method """
+
+	out = open(config.out_file, "wb")
+	entries = []
+
+	for root, dirs, files in os.walk(config.in_dir):
+		dirs.sort()
+		for fname in sorted(files):
+			path = os.path.join(root, fname)
+			name = os.path.relpath(path, config.in_dir).replace(os.sep, "/")
+			data = open(path, "rb").read()
+
+			# Empty files are considered directories by the engine
+			if len(data) == 0:
+				continue
+
+			ext = os.path.splitext(fname)[1][1:]
+			if ext in config.store_exts:
+				method = CM_STORED
+				payload = data
+			else:
+				method = CM_CHUNKED
+				payload = create_chunked(data, config.chunk_size)
+
+			crc = zlib.crc32(data) & 0xFFFFFFFF
+			name_bytes = name.encode("utf-8")
+			offset = out.tell()
+
+			out.write(struct.pack("<IHHHHHIIIHH", 0x04034b50, 20, 0, method, \
+					0, 0, crc, len(payload), len(data), len(name_bytes), 0))
+			out.write(name_bytes)
+			out.write(payload)
+
+			entries.append((name_bytes, method, crc, len(payload), \
+					len(data), offset))
+
+			printi("Adding %s" % name)
+
+	# Central directory
+	dir_offset = out.tell()
+	for (name_bytes, method, crc, comp_size, size, offset) in entries:
+		out.write(struct.pack("<IHHHHHHIIIHHHHHII", 0x02014b50, 20, 20, 0, \
+				method, 0, 0, crc, comp_size, size, len(name_bytes), 0, 0, \
+				0, 0, 0, offset))
+		out.write(name_bytes)
+	dir_size = out.tell() - dir_offset
+
+	if len(entries) >= 0xFFFF or out.tell() >= 0xFFFFFFFF:
+		raise Exception("The archive is too big")
+
+	out.write(struct.pack("<IHHHHIIH", 0x06054b50, 0, 0, len(entries), \
+			len(entries), dir_size, dir_offset, 0))
+	out.close()
+
+def main():
+	config = parse_commandline()
+	create_archive(config)
+	printi("Done!")
+
+if __name__ == "__main__":
+	main()
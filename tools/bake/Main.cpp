@@ -0,0 +1,156 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/misc/Xml.h>
+#include <anki/util/File.h>
+#include <anki/util/Filesystem.h>
+#include <anki/util/StringList.h>
+#include <anki/util/Logger.h>
+#include <cstdio>
+
+using namespace anki;
+
+static const char* USAGE = R"(Usage: %s data_dir [options]
+Bake the XML resources of a directory. For every file it writes a file with the
+".baked" suffix next to it. The engine loads the baked files instead of the XML
+files unless the XML files changed after the baking. Run it again every time
+the XML files change.
+Options:
+-e <string> : Comma separated extensions of the files to bake. Default is
+              "ankimtl,ankimdl,ankipart,ankianim"
+)";
+
+class Baker
+{
+public:
+	HeapAllocator<U8> m_alloc;
+	String m_dataDir;
+	StringList m_extensions;
+	U32 m_bakedCount = 0;
+
+	Baker()
+		: m_alloc(allocAligned, nullptr)
+	{
+	}
+
+	~Baker()
+	{
+		m_dataDir.destroy(m_alloc);
+		m_extensions.destroy(m_alloc);
+	}
+
+	ANKI_USE_RESULT Error bakeFile(const CString& filename);
+};
+
+//==============================================================================
+Error Baker::bakeFile(const CString& filename)
+{
+	StringAuto ext(m_alloc);
+	getFileExtension(filename, m_alloc, ext);
+
+	Bool bake = false;
+	for(const String& e : m_extensions)
+	{
+		bake = bake || (!ext.isEmpty() && e == ext);
+	}
+
+	if(!bake)
+	{
+		return ErrorCode::NONE;
+	}
+
+	StringAuto inFname(m_alloc);
+	inFname.sprintf("%s/%s", &m_dataDir[0], &filename[0]);
+
+	XmlDocument doc;
+	ANKI_CHECK(doc.loadFile(inFname.toCString(), m_alloc));
+
+	DynamicArrayAuto<U8> blob(m_alloc);
+	ANKI_CHECK(doc.bake(blob));
+
+	// Write to a temp file and rename so the engine never sees half a file
+	StringAuto outFname(m_alloc);
+	outFname.sprintf("%s%s",
+		&inFname[0],
+		&XmlDocument::BAKED_FILENAME_SUFFIX[0]);
+
+	StringAuto tmpFname(m_alloc);
+	tmpFname.sprintf("%s.tmp", &outFname[0]);
+
+	{
+		File file;
+		ANKI_CHECK(file.open(tmpFname.toCString(),
+			File::OpenFlag::WRITE | File::OpenFlag::BINARY));
+		ANKI_CHECK(file.write(&blob[0], blob.getSize()));
+	}
+
+	ANKI_CHECK(renameFile(tmpFname.toCString(), outFname.toCString()));
+
+	ANKI_LOGI("Baked %s", &filename[0]);
+	++m_bakedCount;
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+static Error parseCommandLineArgs(int argc, char** argv, Baker& baker)
+{
+	if(argc < 2)
+	{
+		return ErrorCode::USER_DATA;
+	}
+
+	baker.m_dataDir.create(baker.m_alloc, argv[1]);
+
+	CString extensions = "ankimtl,ankimdl,ankipart,ankianim";
+	for(int i = 2; i < argc; i++)
+	{
+		if(CString(argv[i]) == "-e" && i + 1 < argc)
+		{
+			++i;
+			extensions = argv[i];
+		}
+		else
+		{
+			return ErrorCode::USER_DATA;
+		}
+	}
+
+	baker.m_extensions.splitString(baker.m_alloc, extensions, ',');
+
+	return ErrorCode::NONE;
+}
+
+//==============================================================================
+int main(int argc, char** argv)
+{
+	Baker baker;
+
+	if(parseCommandLineArgs(argc, argv, baker))
+	{
+		printf(USAGE, argv[0]);
+		return 1;
+	}
+
+	Error err = walkDirectoryTree(baker.m_dataDir.toCString(),
+		&baker,
+		[](const CString& fname, void* ud, Bool isDir) -> Error {
+			if(isDir)
+			{
+				return ErrorCode::NONE;
+			}
+
+			return static_cast<Baker*>(ud)->bakeFile(fname);
+		});
+
+	if(err)
+	{
+		ANKI_LOGE("Baking failed");
+		return 1;
+	}
+
+	ANKI_LOGI("Baked %u files", baker.m_bakedCount);
+	return 0;
+}